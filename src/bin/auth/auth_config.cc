@@ -137,6 +137,55 @@ private:
     size_t timeout_;
 };
 
+/// \brief Configuration for the number of worker threads
+class WorkerThreadsConfig : public AuthConfigParser {
+public:
+    WorkerThreadsConfig(AuthSrv& server) : server_(server), count_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        if (config->intValue() >= 0) {
+            count_ = config->intValue();
+        } else {
+            isc_throw(AuthConfigError, "worker_threads must be 0 or higher");
+        }
+    }
+
+    virtual void commit() {
+        if (count_ != server_.getWorkerThreads()) {
+            server_.setWorkerThreads(count_);
+        }
+    }
+private:
+    AuthSrv& server_;
+    size_t count_;
+};
+
+/// \brief Configuration for the size of the response cache
+class ResponseCacheSizeConfig : public AuthConfigParser {
+public:
+    ResponseCacheSizeConfig(AuthSrv& server) : server_(server), size_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        if (config->intValue() >= 0) {
+            size_ = config->intValue();
+        } else {
+            isc_throw(AuthConfigError,
+                      "response_cache_size must be 0 or higher");
+        }
+    }
+
+    virtual void commit() {
+        if (size_ != server_.getResponseCacheSize()) {
+            server_.setResponseCacheSize(size_);
+        }
+    }
+private:
+    AuthSrv& server_;
+    size_t size_;
+};
+
 } // end of unnamed namespace
 
 AuthConfigParser*
@@ -170,6 +219,10 @@ createAuthConfigParser(AuthSrv& server, const std::string& config_id) {
         return (new VersionConfig());
     } else if (config_id == "tcp_recv_timeout") {
         return (new TCPRecvTimeoutConfig(server));
+    } else if (config_id == "worker_threads") {
+        return (new WorkerThreadsConfig(server));
+    } else if (config_id == "response_cache_size") {
+        return (new ResponseCacheSizeConfig(server));
     } else {
         isc_throw(AuthConfigError, "Unknown configuration identifier: " <<
                   config_id);
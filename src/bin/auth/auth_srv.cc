@@ -15,6 +15,8 @@
 #include <config.h>
 
 #include <util/io/socketsession.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
 #include <asiolink/asiolink.h>
 #include <asiolink/io_endpoint.h>
@@ -47,6 +49,8 @@
 
 #include <xfr/xfrout_client.h>
 
+#include <server_common/keyring.h>
+
 #include <auth/common.h>
 #include <auth/auth_config.h>
 #include <auth/auth_srv.h>
@@ -54,19 +58,26 @@
 #include <auth/statistics.h>
 #include <auth/auth_log.h>
 #include <auth/datasrc_clients_mgr.h>
+#include <auth/response_cache.h>
 
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 #include <boost/scoped_ptr.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
+#include <utility>
 #include <vector>
 #include <memory>
 
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -86,6 +97,8 @@ using namespace isc::asiodns;
 using namespace isc::server_common::portconfig;
 using isc::auth::statistics::Counters;
 using isc::auth::statistics::MessageAttributes;
+using isc::util::thread::Mutex;
+using isc::util::thread::Thread;
 
 namespace {
 // A helper class for cleaning up message renderer.
@@ -131,6 +144,29 @@ private:
     Message& message_;
 };
 
+// The options of the UDP servers.  We always build the response in the
+// lookup callback, so the servers can act in the synchronous mode, and
+// receive and answer the queries in batches.
+const DNSService::ServerFlag UDP_SERVER_OPTIONS =
+    static_cast<DNSService::ServerFlag>(DNSService::SERVER_SYNC_OK |
+                                        DNSService::SERVER_BATCH_OK);
+
+// Whether all the data sources of a list are served from memory.  Only the
+// updates of the in-memory data are known to the data source clients
+// manager, so only the responses built from them can be cached.
+bool
+isServedFromMemory(const datasrc::ConfigurableClientList& list) {
+    const datasrc::ConfigurableClientList::DataSources& sources =
+        list.getDataSources();
+    for (datasrc::ConfigurableClientList::DataSources::const_iterator it =
+             sources.begin(); it != sources.end(); ++it) {
+        if (!it->cache_) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
 // A helper container of socket session forwarder.
 //
 // This class provides a simple wrapper interface to SocketSessionForwarder
@@ -233,6 +269,29 @@ private:
 };
 }
 
+// The objects used to process a query and account for it.  They are not
+// thread-safe, so each thread processing queries has its own set.
+struct ProcessingContext : boost::noncopyable {
+    explicit ProcessingContext(size_t response_cache_size = 0) :
+        response_cache_(response_cache_size)
+    {}
+
+    MessageRenderer renderer_;
+    auth::Query query_;
+
+    /// Query counters for statistics
+    Counters counters_;
+
+    /// Rendered responses to the normal queries
+    auth::ResponseCache response_cache_;
+};
+
+// The UDP sockets the server listens on, as pairs of the descriptor and the
+// address family.
+typedef std::vector<std::pair<int, int> > UDPSocketList;
+
+class QueryWorker;
+
 class AuthSrvImpl {
 private:
     // prohibit copy
@@ -243,24 +302,43 @@ public:
                 BaseSocketSessionForwarder& ddns_forwarder);
     ~AuthSrvImpl();
 
+    /// \brief Process a message with the given context.
+    ///
+    /// This is the implementation of AuthSrv::processMessage(), which may
+    /// be called by several threads at once, each with its own context.
+    void processMessage(const IOMessage& io_message, Message& message,
+                        OutputBuffer& buffer, DNSServer* server,
+                        ProcessingContext& context);
+
     bool processNormalQuery(const IOMessage& io_message,
                             ConstEDNSPtr remote_edns, Message& message,
                             OutputBuffer& buffer,
                             auto_ptr<TSIGContext> tsig_context,
-                            MessageAttributes& stats_attrs);
+                            MessageAttributes& stats_attrs,
+                            ProcessingContext& context);
     bool processXfrQuery(const IOMessage& io_message, Message& message,
                          OutputBuffer& buffer,
                          auto_ptr<TSIGContext> tsig_context,
-                         MessageAttributes& stats_attrs);
+                         MessageAttributes& stats_attrs,
+                         ProcessingContext& context);
     bool processNotify(const IOMessage& io_message, Message& message,
                        OutputBuffer& buffer,
                        auto_ptr<TSIGContext> tsig_context,
-                       MessageAttributes& stats_attrs);
+                       MessageAttributes& stats_attrs,
+                       ProcessingContext& context);
     bool processUpdate(const IOMessage& io_message);
 
+    /// \brief Start the configured number of worker threads.
+    void startWorkers();
+
+    /// \brief Stop the worker threads, if any.
+    void stopWorkers();
+
     IOService io_service_;
 
-    MessageRenderer renderer_;
+    /// The context of the queries processed by the main thread
+    ProcessingContext main_context_;
+
     /// Currently non-configurable, but will be.
     static const uint16_t DEFAULT_LOCAL_UDPSIZE = 4096;
 
@@ -268,12 +346,21 @@ public:
     ModuleCCSession* config_session_;
     AbstractSession* xfrin_session_;
 
-    /// Query counters for statistics
-    Counters counters_;
-
     /// Addresses we listen on
     AddressList listen_addresses_;
 
+    /// The UDP sockets of the listen addresses, served by the workers too
+    UDPSocketList udp_sockets_;
+
+    /// The number of worker threads to run
+    size_t worker_threads_;
+
+    /// The worker threads processing the queries
+    std::vector<boost::shared_ptr<QueryWorker> > workers_;
+
+    /// The maximum number of responses cached by each thread
+    size_t response_cache_size_;
+
     /// The TSIG keyring
     const boost::shared_ptr<TSIGKeyRing>* keyring_;
 
@@ -288,6 +375,11 @@ public:
     /// b10-ddns is not running
     boost::scoped_ptr<SocketSessionForwarderHolder> ddns_forwarder_;
 
+    /// Serialize the use of xfrin_session_ and ddns_forwarder_ respectively,
+    /// which are shared by the threads processing the queries.
+    Mutex xfrin_mutex_;
+    Mutex ddns_mutex_;
+
     /// \brief Resume the server
     ///
     /// This is a wrapper call for DNSServer::resume(done). Query/Response
@@ -301,25 +393,26 @@ public:
     ///                    with statistics
     /// \param done If true, it indicates there is a response.
     ///             this value will be passed to server->resume(bool)
+    /// \param context The context the message was processed with
     void resumeServer(isc::asiodns::DNSServer* server,
                       isc::dns::Message& message,
                       MessageAttributes& stats_attrs,
-                      const bool done);
+                      const bool done,
+                      ProcessingContext& context);
 
     /// Are we currently subscribed to the SegmentReader group?
     bool readers_group_subscribed_;
 private:
     bool xfrout_connected_;
     AbstractXfroutClient& xfrout_client_;
-
-    auth::Query query_;
 };
 
 AuthSrvImpl::AuthSrvImpl(AbstractXfroutClient& xfrout_client,
                          BaseSocketSessionForwarder& ddns_forwarder) :
     config_session_(NULL),
     xfrin_session_(NULL),
-    counters_(),
+    worker_threads_(0),
+    response_cache_size_(0),
     keyring_(NULL),
     datasrc_clients_mgr_(io_service_),
     ddns_base_forwarder_(ddns_forwarder),
@@ -330,6 +423,8 @@ AuthSrvImpl::AuthSrvImpl(AbstractXfroutClient& xfrout_client,
 {}
 
 AuthSrvImpl::~AuthSrvImpl() {
+    // The workers use the other members, so they are stopped first.
+    stopWorkers();
     if (xfrout_connected_) {
         xfrout_client_.disconnect();
         xfrout_connected_ = false;
@@ -338,10 +433,13 @@ AuthSrvImpl::~AuthSrvImpl() {
 
 // This is a derived class of \c DNSLookup, to serve as a
 // callback in the asiolink module.  It calls
-// AuthSrv::processMessage() on a single DNS message.
+// AuthSrvImpl::processMessage() on a single DNS message, with the context
+// of the thread running the lookup.
 class MessageLookup : public DNSLookup {
 public:
-    MessageLookup(AuthSrv* srv) : server_(srv) {}
+    MessageLookup(AuthSrvImpl* impl, ProcessingContext* context) :
+        impl_(impl), context_(context)
+    {}
     virtual void operator()(const IOMessage& io_message,
                             MessagePtr message,
                             MessagePtr, // Not used here
@@ -353,10 +451,24 @@ public:
         // This is not done in processMessage itself (which would be
         // equivalent), to allow tests to inspect the message handling.
         MessageHolder message_holder(*message);
-        server_->processMessage(io_message, *message, *buffer, server);
+        impl_->processMessage(io_message, *message, *buffer, server,
+                              *context_);
     }
 private:
-    AuthSrv* server_;
+    AuthSrvImpl* impl_;
+    ProcessingContext* context_;
+};
+
+// A \c MessageLookup with a context of its own, for the threads processing
+// queries outside of the server.
+class ContextLookup : public MessageLookup {
+public:
+    ContextLookup(AuthSrvImpl* impl) :
+        MessageLookup(impl, &context_),
+        context_(impl->response_cache_size_)
+    {}
+private:
+    ProcessingContext context_;
 };
 
 // This is a derived class of \c DNSAnswer, to serve as a callback in the
@@ -369,19 +481,106 @@ private:
 // implementation.
 class MessageAnswer : public DNSAnswer {
 public:
-    MessageAnswer(AuthSrv*) {}
+    MessageAnswer() {}
     virtual void operator()(const IOMessage&, MessagePtr,
                             MessagePtr, OutputBufferPtr) const
     {}
 };
 
+// A thread processing the queries received on the UDP sockets of the server.
+//
+// The worker serves its own duplicates of the sockets, with its own IO
+// service and DNS service, so as it can run and close them independently of
+// the main thread and the other workers.  Each datagram is still received
+// only once, by whichever thread reads the socket first.  The sockets are
+// created by b10-init and passed to us, so sharing them is how we spread
+// the load rather than binding a socket per thread with SO_REUSEPORT.
+class QueryWorker : boost::noncopyable {
+public:
+    QueryWorker(AuthSrvImpl* impl, const UDPSocketList& sockets) :
+        context_(impl->response_cache_size_),
+        lookup_(impl, &context_),
+        dns_service_(io_service_, &lookup_, &answer_)
+    {
+        for (UDPSocketList::const_iterator it = sockets.begin();
+             it != sockets.end(); ++it) {
+            const int fd = dup(it->first);
+            if (fd == -1) {
+                isc_throw(isc::Unexpected, "failed to duplicate socket "
+                          << it->first << ": " << strerror(errno));
+            }
+            try {
+                dns_service_.addServerUDPFromFD(fd, it->second,
+                                                UDP_SERVER_OPTIONS);
+            } catch (...) {
+                close(fd);
+                throw;
+            }
+        }
+        thread_.reset(new Thread(boost::bind(&QueryWorker::run, this)));
+    }
+
+    ~QueryWorker() {
+        // The servers are not thread-safe, so they are closed only once
+        // the thread is done with them.
+        io_service_.stop();
+        thread_->wait();
+        dns_service_.clearServers();
+    }
+
+    const Counters& getCounters() const {
+        return (context_.counters_);
+    }
+
+    const auth::ResponseCache& getResponseCache() const {
+        return (context_.response_cache_);
+    }
+
+private:
+    void run() {
+        try {
+            io_service_.run();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(auth_logger, AUTH_WORKER_THREAD_FAILED).arg(ex.what());
+        }
+    }
+
+    IOService io_service_;
+    ProcessingContext context_;
+    MessageLookup lookup_;
+    MessageAnswer answer_;
+    DNSService dns_service_;
+    boost::scoped_ptr<Thread> thread_;
+};
+
+void
+AuthSrvImpl::startWorkers() {
+    for (size_t i = 0; i < worker_threads_; ++i) {
+        workers_.push_back(boost::shared_ptr<QueryWorker>(
+                               new QueryWorker(this, udp_sockets_)));
+    }
+    if (!workers_.empty()) {
+        LOG_INFO(auth_logger, AUTH_WORKER_THREADS_STARTED).
+            arg(workers_.size()).arg(udp_sockets_.size());
+    }
+}
+
+void
+AuthSrvImpl::stopWorkers() {
+    if (!workers_.empty()) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_WORKER_THREADS_STOPPED).
+            arg(workers_.size());
+        workers_.clear();
+    }
+}
+
 AuthSrv::AuthSrv(isc::xfr::AbstractXfroutClient& xfrout_client,
                  isc::util::io::BaseSocketSessionForwarder& ddns_forwarder) :
     dnss_(NULL)
 {
     impl_ = new AuthSrvImpl(xfrout_client, ddns_forwarder);
-    dns_lookup_ = new MessageLookup(this);
-    dns_answer_ = new MessageAnswer(this);
+    dns_lookup_ = new MessageLookup(impl_, &impl_->main_context_);
+    dns_answer_ = new MessageAnswer();
 }
 
 void
@@ -455,6 +654,11 @@ AuthSrv::getIOService() {
     return (impl_->io_service_);
 }
 
+boost::shared_ptr<DNSLookup>
+AuthSrv::createDNSLookupProvider() {
+    return (boost::shared_ptr<DNSLookup>(new ContextLookup(impl_)));
+}
+
 isc::auth::DataSrcClientsMgr&
 AuthSrv::getDataSrcClientsMgr() {
     return (impl_->datasrc_clients_mgr_);
@@ -478,6 +682,15 @@ AuthSrv::getConfigSession() const {
 void
 AuthSrv::processMessage(const IOMessage& io_message, Message& message,
                         OutputBuffer& buffer, DNSServer* server)
+{
+    impl_->processMessage(io_message, message, buffer, server,
+                          impl_->main_context_);
+}
+
+void
+AuthSrvImpl::processMessage(const IOMessage& io_message, Message& message,
+                            OutputBuffer& buffer, DNSServer* server,
+                            ProcessingContext& context)
 {
     InputBuffer request_buffer(io_message.getData(), io_message.getDataSize());
     MessageAttributes stats_attrs;
@@ -495,13 +708,13 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
         // Ignore all responses.
         if (message.getHeaderFlag(Message::HEADERFLAG_QR)) {
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_RECEIVED);
-            impl_->resumeServer(server, message, stats_attrs, false);
+            resumeServer(server, message, stats_attrs, false, context);
             return;
         }
     } catch (const isc::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_HEADER_PARSE_FAIL)
                   .arg(ex.what());
-        impl_->resumeServer(server, message, stats_attrs, false);
+        resumeServer(server, message, stats_attrs, false, context);
         return;
     }
 
@@ -518,16 +731,16 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     } catch (const DNSProtocolError& error) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PROTOCOL_FAILURE)
                   .arg(error.getRcode().toText()).arg(error.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, error.getRcode(),
+        makeErrorMessage(context.renderer_, message, buffer, error.getRcode(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(server, message, stats_attrs, true, context);
         return;
     } catch (const isc::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PARSE_FAILED)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(server, message, stats_attrs, true, context);
         return;
     } // other exceptions will be handled at a higher layer.
 
@@ -543,20 +756,24 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
 
     // Do we do TSIG?
     // The keyring can be null if we're in test
-    if (impl_->keyring_ != NULL && tsig_record != NULL) {
+    if (keyring_ != NULL && tsig_record != NULL) {
+        // The key ring can be replaced by the main thread at any time, so
+        // we hold a copy of the pointer while we use it.
+        const boost::shared_ptr<TSIGKeyRing> keyring(
+            server_common::copyKeyring(*keyring_));
         tsig_context.reset(new TSIGContext(tsig_record->getName(),
                                            tsig_record->getRdata().
                                                 getAlgorithm(),
-                                           **impl_->keyring_));
+                                           *keyring));
         tsig_error = tsig_context->verify(tsig_record, io_message.getData(),
                                           io_message.getDataSize());
         stats_attrs.setRequestTSIG(true, tsig_error != TSIGError::NOERROR());
     }
 
     if (tsig_error != TSIGError::NOERROR()) {
-        makeErrorMessage(impl_->renderer_, message, buffer,
+        makeErrorMessage(context.renderer_, message, buffer,
                          tsig_error.toRcode(), stats_attrs, tsig_context);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(server, message, stats_attrs, true, context);
         return;
     }
 
@@ -571,53 +788,53 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
 
         // note: This can only be reliable after TSIG check succeeds.
         if (opcode == Opcode::NOTIFY()) {
-            send_answer = impl_->processNotify(io_message, message, buffer,
-                                               tsig_context, stats_attrs);
+            send_answer = processNotify(io_message, message, buffer,
+                                        tsig_context, stats_attrs, context);
         } else if (opcode == Opcode::UPDATE()) {
-            if (impl_->ddns_forwarder_) {
-                send_answer = impl_->processUpdate(io_message);
+            Mutex::Locker locker(ddns_mutex_);
+            if (ddns_forwarder_) {
+                send_answer = processUpdate(io_message);
             } else {
-                makeErrorMessage(impl_->renderer_, message, buffer,
+                makeErrorMessage(context.renderer_, message, buffer,
                                  Rcode::NOTIMP(), stats_attrs, tsig_context);
             }
         } else if (opcode != Opcode::QUERY()) {
             const IOEndpoint& remote_ep = io_message.getRemoteEndpoint();
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_UNSUPPORTED_OPCODE)
                 .arg(message.getOpcode().toText()).arg(remote_ep);
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer_, message, buffer,
                              Rcode::NOTIMP(), stats_attrs, tsig_context);
         } else if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer_, message, buffer,
                              Rcode::FORMERR(), stats_attrs, tsig_context);
         } else {
             ConstQuestionPtr question = *message.beginQuestion();
             const RRType& qtype = question->getType();
             if (qtype == RRType::AXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, tsig_context,
-                                                     stats_attrs);
+                send_answer = processXfrQuery(io_message, message, buffer,
+                                              tsig_context, stats_attrs,
+                                              context);
             } else if (qtype == RRType::IXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, tsig_context,
-                                                     stats_attrs);
+                send_answer = processXfrQuery(io_message, message, buffer,
+                                              tsig_context, stats_attrs,
+                                              context);
             } else {
-                send_answer = impl_->processNormalQuery(io_message, edns,
-                                                        message, buffer,
-                                                        tsig_context,
-                                                        stats_attrs);
+                send_answer = processNormalQuery(io_message, edns, message,
+                                                 buffer, tsig_context,
+                                                 stats_attrs, context);
             }
         }
     } catch (const std::exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     } catch (...) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE_UNKNOWN);
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     }
-    impl_->resumeServer(server, message, stats_attrs, send_answer);
+    resumeServer(server, message, stats_attrs, send_answer, context);
 }
 
 bool
@@ -625,11 +842,20 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
                                 ConstEDNSPtr remote_edns, Message& message,
                                 OutputBuffer& buffer,
                                 auto_ptr<TSIGContext> tsig_context,
-                                MessageAttributes& stats_attrs)
+                                MessageAttributes& stats_attrs,
+                                ProcessingContext& context)
 {
     const bool dnssec_ok = remote_edns && remote_edns->getDNSSECAwareness();
     const uint16_t remote_bufsize = remote_edns ? remote_edns->getUDPSize() :
         Message::DEFAULT_MAX_UDPSIZE;
+    const bool udp_buffer =
+        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
+    const uint16_t length_limit = udp_buffer ? remote_bufsize : 65535;
+
+    // The signed responses depend on the key, so they are never cached.
+    ResponseCache& cache = context.response_cache_;
+    const bool use_cache =
+        (cache.getMaxEntries() > 0 && tsig_context.get() == NULL);
 
     message.makeResponse();
     message.setHeaderFlag(Message::HEADERFLAG_AA);
@@ -644,38 +870,66 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
 
     // Get access to data source client list through the holder and keep
     // the holder until the processing and rendering is done to avoid
-    // race with any other thread(s) such as the background loader.
+    // race with any other thread(s) such as the background loader.  The
+    // other threads processing queries can hold it at the same time.
     auth::DataSrcClientsMgr::Holder datasrc_holder(datasrc_clients_mgr_);
+    const ConstQuestionPtr question = *message.beginQuestion();
+    boost::optional<ResponseCache::Key> cache_key;
 
     try {
-        const ConstQuestionPtr question = *message.beginQuestion();
-        const boost::shared_ptr<datasrc::ClientList>
+        const boost::shared_ptr<datasrc::ConfigurableClientList>
             list(datasrc_holder.findClientList(question->getClass()));
         if (list) {
+            if (use_cache && isServedFromMemory(*list)) {
+                cache_key = ResponseCache::Key(*question,
+                                               remote_edns.get() != NULL,
+                                               dnssec_ok, length_limit);
+            }
+            ResponseCache::ResponseAttributes cached;
+            if (cache_key &&
+                cache.lookup(*cache_key, datasrc_holder.getGeneration(),
+                             message, buffer, cached)) {
+                // The message isn't rendered, but it's still used for the
+                // statistics.
+                message.setHeaderFlag(Message::HEADERFLAG_AA,
+                                      cached.authoritative_);
+                message.setRcode(Rcode(cached.rcode_));
+                stats_attrs.setResponseAnswerCount(cached.answer_count_);
+                LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES,
+                          AUTH_SEND_CACHED_RESPONSE)
+                    .arg(buffer.getLength()).arg(question->toText());
+                return (true);
+            }
             const RRType& qtype = question->getType();
             const Name& qname = question->getName();
-            query_.process(*list, qname, qtype, message, dnssec_ok);
+            context.query_.process(*list, qname, qtype, message, dnssec_ok);
         } else {
-            makeErrorMessage(renderer_, message, buffer, Rcode::REFUSED(),
-                             stats_attrs);
+            makeErrorMessage(context.renderer_, message, buffer,
+                             Rcode::REFUSED(), stats_attrs);
             return (true);
         }
     } catch (const isc::Exception& ex) {
         LOG_ERROR(auth_logger, AUTH_PROCESS_FAIL).arg(ex.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
-                         stats_attrs);
+        makeErrorMessage(context.renderer_, message, buffer,
+                         Rcode::SERVFAIL(), stats_attrs);
         return (true);
     }
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    const bool udp_buffer =
-        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
-    renderer_.setLengthLimit(udp_buffer ? remote_bufsize : 65535);
-    message.toWire(renderer_, tsig_context.get());
+    MessageRenderer& renderer = context.renderer_;
+    RendererHolder holder(renderer, &buffer, stats_attrs);
+    renderer.setLengthLimit(length_limit);
+    message.toWire(renderer, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
 
+    // The statistics couldn't tell the truncated responses from the cache,
+    // so they are left out; they should be rare anyway.
+    if (cache_key && !renderer.isTruncated()) {
+        cache.insert(*cache_key, datasrc_holder.getGeneration(), message,
+                     buffer.getData(), buffer.getLength());
+    }
+
     LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_NORMAL_RESPONSE)
-              .arg(renderer_.getLength()).arg(message);
+              .arg(renderer.getLength()).arg(message);
     return (true);
     // The message can contain some data from the locked resource. But outside
     // this method, we touch only the RCode of it, so it should be safe.
@@ -688,15 +942,18 @@ bool
 AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
                              OutputBuffer& buffer,
                              auto_ptr<TSIGContext> tsig_context,
-                             MessageAttributes& stats_attrs)
+                             MessageAttributes& stats_attrs,
+                             ProcessingContext& context)
 {
     if (io_message.getSocket().getProtocol() == IPPROTO_UDP) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_UDP);
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
 
+    // The worker threads serve UDP only, so the xfrout client is used by
+    // the main thread only.
     try {
         if (!xfrout_connected_) {
             xfrout_client_.connect();
@@ -718,8 +975,8 @@ AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
 
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_PROBLEM)
                   .arg(err.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
-                         stats_attrs, tsig_context);
+        makeErrorMessage(context.renderer_, message, buffer,
+                         Rcode::SERVFAIL(), stats_attrs, tsig_context);
         return (true);
     }
 
@@ -730,7 +987,8 @@ bool
 AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
                            OutputBuffer& buffer,
                            std::auto_ptr<TSIGContext> tsig_context,
-                           MessageAttributes& stats_attrs)
+                           MessageAttributes& stats_attrs,
+                           ProcessingContext& context)
 {
     const IOEndpoint& remote_ep = io_message.getRemoteEndpoint(); // for logs
 
@@ -739,7 +997,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_QUESTIONS)
                   .arg(message.getRRCount(Message::SECTION_QUESTION));
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -747,7 +1005,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (question->getType() != RRType::SOA()) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_RRTYPE)
                   .arg(question->getType().toText());
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -769,7 +1027,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (!is_auth) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RECEIVED_NOTIFY_NOTAUTH)
             .arg(question->getName()).arg(question->getClass()).arg(remote_ep);
-        makeErrorMessage(renderer_, message, buffer, Rcode::NOTAUTH(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::NOTAUTH(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -791,6 +1049,9 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     static const string command_template_end = "\"}]}";
 
     try {
+        // The session is shared by the threads processing the queries, and
+        // the answer must be read by the thread which sent the command.
+        Mutex::Locker locker(xfrin_mutex_);
         ConstElementPtr notify_command = Element::fromJSON(
                 command_template_start + question->getName().toText() +
                 command_template_master + remote_ip_address +
@@ -829,8 +1090,8 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     message.setHeaderFlag(Message::HEADERFLAG_AA);
     message.setRcode(Rcode::NOERROR());
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    message.toWire(renderer_, tsig_context.get());
+    RendererHolder holder(context.renderer_, &buffer, stats_attrs);
+    message.toWire(context.renderer_, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
     return (true);
 }
@@ -848,8 +1109,8 @@ AuthSrvImpl::processUpdate(const IOMessage& io_message)
 void
 AuthSrvImpl::resumeServer(DNSServer* server, Message& message,
                           MessageAttributes& stats_attrs,
-                          const bool done) {
-    counters_.inc(stats_attrs, message, done);
+                          const bool done, ProcessingContext& context) {
+    context.counters_.inc(stats_attrs, message, done);
     server->resume(done);
 }
 
@@ -869,7 +1130,11 @@ AuthSrv::updateConfig(ConstElementPtr new_config) {
 }
 
 ConstElementPtr AuthSrv::getStatistics() const {
-    return (impl_->counters_.get());
+    std::vector<const Counters*> shards(1, &impl_->main_context_.counters_);
+    for (size_t i = 0; i < impl_->workers_.size(); ++i) {
+        shards.push_back(&impl_->workers_[i]->getCounters());
+    }
+    return (Counters::get(shards));
 }
 
 const AddressList&
@@ -877,12 +1142,54 @@ AuthSrv::getListenAddresses() const {
     return (impl_->listen_addresses_);
 }
 
+namespace {
+// A DNS service installing the servers on another one, which records the
+// UDP sockets on the way, so as the workers can serve them too.
+class UDPSocketRecorder : public DNSServiceBase {
+public:
+    UDPSocketRecorder(DNSServiceBase& service, UDPSocketList& sockets) :
+        service_(service), sockets_(sockets)
+    {}
+    virtual void addServerTCPFromFD(int fd, int af) {
+        service_.addServerTCPFromFD(fd, af);
+    }
+    virtual void addServerUDPFromFD(int fd, int af,
+                                    ServerFlag options = SERVER_DEFAULT)
+    {
+        service_.addServerUDPFromFD(fd, af, options);
+        sockets_.push_back(std::make_pair(fd, af));
+    }
+    virtual void clearServers() {
+        service_.clearServers();
+        sockets_.clear();
+    }
+    virtual void setTCPRecvTimeout(size_t timeout) {
+        service_.setTCPRecvTimeout(timeout);
+    }
+    virtual IOService& getIOService() {
+        return (service_.getIOService());
+    }
+private:
+    DNSServiceBase& service_;
+    UDPSocketList& sockets_;
+};
+}
+
 void
 AuthSrv::setListenAddresses(const AddressList& addresses) {
-    // For UDP servers we specify the "SYNC_OK" option because in our usage
-    // it can act in the synchronous mode.
-    installListenAddresses(addresses, impl_->listen_addresses_, *dnss_,
-                           DNSService::SERVER_SYNC_OK);
+    // The workers serve duplicates of the current sockets, so they are
+    // stopped before the sockets are replaced and restarted with the new
+    // ones (or the old ones, if the change is rolled back).
+    impl_->stopWorkers();
+    UDPSocketRecorder recorder(*dnss_, impl_->udp_sockets_);
+    try {
+        installListenAddresses(addresses, impl_->listen_addresses_, recorder,
+                               UDP_SERVER_OPTIONS);
+    } catch (...) {
+        impl_->startWorkers();
+        throw;
+    }
+    impl_->startWorkers();
 }
 
 void
@@ -892,12 +1199,17 @@ AuthSrv::setDNSService(isc::asiodns::DNSServiceBase& dnss) {
 
 void
 AuthSrv::setTSIGKeyRing(const boost::shared_ptr<TSIGKeyRing>* keyring) {
+    // The workers read the pointer without synchronization, so they are
+    // restarted to see the new one.
+    impl_->stopWorkers();
     impl_->keyring_ = keyring;
+    impl_->startWorkers();
 }
 
 void
 AuthSrv::createDDNSForwarder() {
     LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_START_DDNS_FORWARDER);
+    Mutex::Locker locker(impl_->ddns_mutex_);
     impl_->ddns_forwarder_.reset(
         new SocketSessionForwarderHolder("update",
                                          impl_->ddns_base_forwarder_));
@@ -905,6 +1217,7 @@ AuthSrv::createDDNSForwarder() {
 
 void
 AuthSrv::destroyDDNSForwarder() {
+    Mutex::Locker locker(impl_->ddns_mutex_);
     if (impl_->ddns_forwarder_) {
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_STOP_DDNS_FORWARDER);
         impl_->ddns_forwarder_.reset();
@@ -916,6 +1229,52 @@ AuthSrv::setTCPRecvTimeout(size_t timeout) {
     dnss_->setTCPRecvTimeout(timeout);
 }
 
+void
+AuthSrv::setWorkerThreads(size_t count) {
+    impl_->stopWorkers();
+    impl_->worker_threads_ = count;
+    impl_->startWorkers();
+}
+
+size_t
+AuthSrv::getWorkerThreads() const {
+    return (impl_->worker_threads_);
+}
+
+void
+AuthSrv::setResponseCacheSize(size_t entries) {
+    // The caches of the workers are sized when they start.
+    impl_->stopWorkers();
+    impl_->response_cache_size_ = entries;
+    impl_->main_context_.response_cache_.setMaxEntries(entries);
+    impl_->startWorkers();
+}
+
+size_t
+AuthSrv::getResponseCacheSize() const {
+    return (impl_->response_cache_size_);
+}
+
+// As the statistics counters, the numbers of the workers are read while
+// they may be updated, which is harmless for reporting.
+uint64_t
+AuthSrv::getResponseCacheHits() const {
+    uint64_t hits = impl_->main_context_.response_cache_.getHits();
+    for (size_t i = 0; i < impl_->workers_.size(); ++i) {
+        hits += impl_->workers_[i]->getResponseCache().getHits();
+    }
+    return (hits);
+}
+
+uint64_t
+AuthSrv::getResponseCacheMisses() const {
+    uint64_t misses = impl_->main_context_.response_cache_.getMisses();
+    for (size_t i = 0; i < impl_->workers_.size(); ++i) {
+        misses += impl_->workers_[i]->getResponseCache().getMisses();
+    }
+    return (misses);
+}
+
 namespace {
 
 bool
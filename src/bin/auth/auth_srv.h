@@ -192,6 +192,18 @@ public:
     /// \brief Return pointer to the DNS Answer callback function
     isc::asiodns::DNSAnswer* getDNSAnswerProvider() const { return (dns_answer_); }
 
+    /// \brief Create a DNS Lookup callback with a context of its own
+    ///
+    /// Unlike the one returned by \c getDNSLookupProvider(), the returned
+    /// callback has its own message renderer, query object and statistics
+    /// counters, so as it can be used by another thread, concurrently with
+    /// the IO service of the server, in the same way as the worker threads
+    /// (see \c setWorkerThreads()) do.  It is meant for the benchmarks;
+    /// the queries it processes are not counted in \c getStatistics().
+    ///
+    /// The callback must not be used after the server is destroyed.
+    boost::shared_ptr<isc::asiodns::DNSLookup> createDNSLookupProvider();
+
     /// \brief Return data source clients manager.
     ///
     /// \throw None
@@ -217,6 +229,9 @@ public:
 
     /// \brief Returns statistics data
     ///
+    /// The counters of the worker threads, if any, are summed with the
+    /// ones of the main thread.
+    ///
     /// This function can throw an exception from
     /// Counters::get().
     ///
@@ -272,6 +287,73 @@ public:
     /// open forever.
     void setTCPRecvTimeout(size_t timeout);
 
+    /// \brief Sets the number of worker threads processing the queries.
+    ///
+    /// By default, all the queries are processed by the thread running the
+    /// IO service of the server.  With worker threads, each of them serves
+    /// its own copies of the UDP sockets the server listens on, with its
+    /// own message renderer, query object and statistics counters, while
+    /// the zone data of the data sources are shared.  The queries over UDP
+    /// are then received by whichever of the threads is ready to process
+    /// them first, including the main thread; TCP, as well as the commands
+    /// and configuration, are still handled by the main thread only.
+    ///
+    /// The threads are restarted on each change of the listen addresses,
+    /// so as they serve the new sockets.
+    ///
+    /// \note The data sources must support concurrent lookups, as the
+    /// in-memory cache does.  The data sources accessing a database
+    /// directly, such as sqlite3 without the cache, don't.
+    ///
+    /// \param count The number of worker threads.  If set to zero, the
+    /// worker threads are stopped.
+    void setWorkerThreads(size_t count);
+
+    /// \brief Returns the number of worker threads processing the queries.
+    ///
+    /// \throw None
+    size_t getWorkerThreads() const;
+
+    /// \brief Sets the size of the response cache.
+    ///
+    /// With the cache enabled, the rendered responses to the normal queries
+    /// are kept, so as the same question is answered by patching the ID
+    /// and a few flags of the cached response instead of searching the zone
+    /// and rendering the response again.  Each thread processing queries
+    /// has its own cache of this size, which is emptied whenever a zone is
+    /// (re)loaded or the data sources are reconfigured.
+    ///
+    /// Only the responses from the data sources served entirely from
+    /// memory are cached, as the updates of the other ones aren't known to
+    /// the server; neither are the TSIG signed or the truncated responses.
+    ///
+    /// Setting the size empties the caches and restarts the worker
+    /// threads, if any.
+    ///
+    /// \param entries The maximum number of responses cached by each
+    /// thread.  If set to zero, the cache is disabled.
+    void setResponseCacheSize(size_t entries);
+
+    /// \brief Returns the maximum number of responses cached by each thread.
+    ///
+    /// \throw None
+    size_t getResponseCacheSize() const;
+
+    /// \brief Returns the number of queries answered from the response
+    /// caches of the server's threads.
+    ///
+    /// \note The caches of the lookup providers returned by
+    /// \c createDNSLookupProvider() are not accounted for.
+    ///
+    /// \throw None
+    uint64_t getResponseCacheHits() const;
+
+    /// \brief Returns the number of queries looked up in the response
+    /// caches of the server's threads without success.
+    ///
+    /// \throw None
+    uint64_t getResponseCacheMisses() const;
+
     /// \brief Notify the authoritative server that the client lists were
     ///     reconfigured.
     ///
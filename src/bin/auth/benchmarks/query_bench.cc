@@ -28,6 +28,7 @@
 #include <xfr/xfrout_client.h>
 
 #include <util/unittests/mock_socketsession.h>
+#include <util/threads/thread.h>
 
 #include <auth/auth_srv.h>
 #include <auth/auth_config.h>
@@ -38,9 +39,11 @@
 #include <asiodns/asiodns.h>
 #include <asiolink/asiolink.h>
 
+#include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <stdlib.h>
+#include <sys/time.h>
 
 #include <iostream>
 #include <vector>
@@ -57,6 +60,7 @@ using namespace isc::xfr;
 using namespace isc::bench;
 using namespace isc::asiodns;
 using namespace isc::asiolink;
+using isc::util::thread::Thread;
 
 namespace {
 // Commonly used constant:
@@ -107,6 +111,10 @@ public:
 
         return (queries_.size());
     }
+
+    AuthSrv& getServer() {
+        return (*server_);
+    }
 private:
     MockSocketSessionForwarder ddns_forwarder;
 protected:
@@ -169,6 +177,123 @@ printQPSResult(unsigned int iteration, double duration,
     cout.precision(2);
     cout << " (" << fixed << iteration_per_second << "qps)" << endl;
 }
+
+// Runs the benchmark, and again with the response cache of the server
+// enabled if cache_size isn't 0, reporting its hit rate and the gain.
+template <typename T>
+void
+runBenchMark(const int iteration, T target, const size_t cache_size) {
+    const BenchMark<T> uncached(iteration, target);
+    if (cache_size == 0) {
+        return;
+    }
+
+    cout << "With a response cache of " << cache_size << " entries" << endl;
+    AuthSrv& server = target.getServer();
+    server.setResponseCacheSize(cache_size);
+    const BenchMark<T> cached(iteration, target);
+    const uint64_t hits = server.getResponseCacheHits();
+    const uint64_t lookups = hits + server.getResponseCacheMisses();
+    cout.precision(2);
+    cout << "Response cache: " << hits << " hits in " << lookups
+         << " lookups (" << fixed
+         << (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "%)" << endl;
+    cout << "Speedup: " << fixed
+         << cached.getIterationPerSecond() / uncached.getIterationPerSecond()
+         << endl;
+}
+
+// Processes the queries in a thread of its own, with its own lookup
+// provider, message and buffer, as a worker thread of the server does.
+class QueryThread {
+public:
+    QueryThread(AuthSrv& server, const BenchQueries& queries,
+                const int iteration) :
+        lookup_(server.createDNSLookupProvider()),
+        queries_(queries), iteration_(iteration),
+        message_(new Message(Message::PARSE)),
+        buffer_(new OutputBuffer(4096)),
+        dummy_endpoint_(IOEndpoint::create(IPPROTO_UDP,
+                                           IOAddress("192.0.2.1"), 53210))
+    {
+        thread_.reset(new Thread(boost::bind(&QueryThread::run, this)));
+    }
+
+    void wait() {
+        thread_->wait();
+    }
+
+private:
+    void run() {
+        DummyServer server;
+        for (int i = 0; i < iteration_; ++i) {
+            for (BenchQueries::const_iterator query = queries_.begin();
+                 query != queries_.end(); ++query) {
+                IOMessage io_message(&(*query)[0], (*query).size(),
+                                     IOSocket::getDummyUDPSocket(),
+                                     *dummy_endpoint_);
+                message_->clear(Message::PARSE);
+                buffer_->clear();
+                (*lookup_)(io_message, message_, MessagePtr(), buffer_,
+                           &server);
+            }
+        }
+    }
+
+    boost::shared_ptr<DNSLookup> lookup_;
+    const BenchQueries& queries_;
+    const int iteration_;
+    MessagePtr message_;
+    OutputBufferPtr buffer_;
+    boost::shared_ptr<const IOEndpoint> dummy_endpoint_;
+    boost::shared_ptr<Thread> thread_;
+};
+
+double
+getTime() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec + now.tv_usec / 1000000.0);
+}
+
+// Runs the queries with 1, 2, 4... threads up to max_threads, all of them
+// sharing the data sources of the server, and reports how the throughput
+// scales with the number of threads.
+void
+runScaling(AuthSrv& server, const BenchQueries& queries, const int iteration,
+           const unsigned int max_threads)
+{
+    double base_qps = 0;
+    for (unsigned int threads = 1; ; threads *= 2) {
+        if (threads > max_threads) {
+            threads = max_threads;
+        }
+        const double start = getTime();
+        vector<boost::shared_ptr<QueryThread> > query_threads;
+        for (unsigned int i = 0; i < threads; ++i) {
+            query_threads.push_back(boost::shared_ptr<QueryThread>(
+                new QueryThread(server, queries, iteration)));
+        }
+        for (unsigned int i = 0; i < threads; ++i) {
+            query_threads[i]->wait();
+        }
+        const double duration = getTime() - start;
+        const unsigned int processed = threads * iteration * queries.size();
+        const double qps = processed / duration;
+        if (threads == 1) {
+            base_qps = qps;
+        }
+
+        cout << threads << " thread(s): ";
+        printQPSResult(processed, duration, qps);
+        cout.precision(2);
+        cout << "  Speedup: " << fixed << qps / base_qps << endl;
+
+        if (threads == max_threads) {
+            break;
+        }
+    }
+}
 }
 
 namespace isc {
@@ -198,13 +323,18 @@ void
 usage() {
     cerr <<
         "Usage: query_bench [-d] [-n iterations] [-t datasrc_type] [-o origin]"
-        " datasrc_file query_datafile\n"
+        " [-c cache_size] [-T threads] datasrc_file query_datafile\n"
         "  -d Enable debug logging to stdout\n"
         "  -n Number of iterations per test case (default: "
          << ITERATION_DEFAULT << ")\n"
         "  -t Type of data source: sqlite3|memory (default: sqlite3)\n"
         "  -o Origin name of datasrc_file necessary for \"memory\", "
         "ignored for others\n"
+        "  -c Also measure with a response cache of this number of entries\n"
+        "  -T Measure the scaling with up to this number of threads, "
+        "each processing\n"
+        "     the queries (the iterations are per thread); \"memory\" "
+        "only\n"
         "  datasrc_file: sqlite3 DB file for \"sqlite3\", "
         "textual master file for \"memory\" datasrc\n"
         "  query_datafile: queryperf style input data"
@@ -220,11 +350,25 @@ main(int argc, char* argv[]) {
     const char* opt_datasrc_type = "sqlite3";
     const char* origin = NULL;
     bool debug_log = false;
-    while ((ch = getopt(argc, argv, "dn:t:o:")) != -1) {
+    int max_threads = 0;
+    int cache_size = 0;
+    while ((ch = getopt(argc, argv, "dn:t:o:c:T:")) != -1) {
         switch (ch) {
         case 'n':
             iteration = atoi(optarg);
             break;
+        case 'c':
+            cache_size = atoi(optarg);
+            if (cache_size <= 0) {
+                usage();
+            }
+            break;
+        case 'T':
+            max_threads = atoi(optarg);
+            if (max_threads <= 0) {
+                usage();
+            }
+            break;
         case 't':
             opt_datasrc_type = optarg;
             break;
@@ -266,6 +410,12 @@ main(int argc, char* argv[]) {
         return (1);
     }
 
+    // The database data sources can't be searched by several threads.
+    if (max_threads > 0 && datasrc_type != MEMORY) {
+        cerr << "'-T threads' requires the memory data source" << endl;
+        return (1);
+    }
+
     try {
         BenchQueries queries;
         loadQueryData(query_data_file, queries, RRClass::IN());
@@ -280,20 +430,38 @@ main(int argc, char* argv[]) {
             cout << "  Origin: " << origin << endl;
         }
         cout << "  Query data: file=" << query_data_file << " ("
-             << queries.size() << " queries)" << endl << endl;
+             << queries.size() << " queries)" << endl;
+        if (cache_size > 0) {
+            cout << "  Response cache: " << cache_size << " entries" << endl;
+        }
+        if (max_threads > 0) {
+            cout << "  Threads: up to " << max_threads << endl;
+        }
+        cout << endl;
+
+        if (max_threads > 0) {
+            cout << "Scaling with In Memory Data Source" << endl;
+            MemoryQueryBenchMark bench(datasrc_file, origin, queries,
+                                       message, buffer);
+            bench.getServer().setResponseCacheSize(cache_size);
+            runScaling(bench.getServer(), queries, iteration, max_threads);
+            return (0);
+        }
 
         switch (datasrc_type) {
         case SQLITE3:
             cout << "Benchmark with SQLite3" << endl;
-            BenchMark<Sqlite3QueryBenchMark>(
-                iteration, Sqlite3QueryBenchMark(datasrc_file, queries,
-                                                 message, buffer));
+            runBenchMark(iteration,
+                         Sqlite3QueryBenchMark(datasrc_file, queries,
+                                               message, buffer),
+                         cache_size);
             break;
         case MEMORY:
             cout << "Benchmark with In Memory Data Source" << endl;
-            BenchMark<MemoryQueryBenchMark>(
-                iteration, MemoryQueryBenchMark(datasrc_file, origin, queries,
-                                                message, buffer));
+            runBenchMark(iteration,
+                         MemoryQueryBenchMark(datasrc_file, origin, queries,
+                                              message, buffer),
+                         cache_size);
             break;
         }
     } catch (const std::exception& ex) {
@@ -141,8 +141,13 @@ struct Command {
 /// involving actual threads or mutex.  Normal applications will only
 /// need one specific specialization that has a typedef of
 /// \c DataSrcClientsMgr.
+///
+/// The client lists are protected by a lock of \c MapMutexType, which must
+/// provide a \c ReaderLocker class in addition to \c Locker.  The lists
+/// are only read through the \c Holder, which takes the lock shared, so as
+/// several threads processing queries can search them concurrently.
 template <typename ThreadType, typename BuilderType, typename MutexType,
-          typename CondVarType>
+          typename CondVarType, typename MapMutexType = MutexType>
 class DataSrcClientsMgrBase : boost::noncopyable {
 private:
     typedef std::map<dns::RRClass,
@@ -181,6 +186,11 @@ public:
     /// It's normally expected to create the holder object on the stack
     /// of a small scope and automatically let it be destroyed at the end
     /// of the scope.
+    ///
+    /// Any number of holders can exist at the same time in different
+    /// threads, as the lists are not modified through it; only the updates
+    /// of the lists by the builder are exclusive.  A thread must not create
+    /// a holder while it already has one, though.
     class Holder {
     public:
         Holder(DataSrcClientsMgrBase& mgr) :
@@ -231,9 +241,20 @@ public:
             }
             return (result);
         }
+
+        /// \brief Return the generation of the data source client lists.
+        ///
+        /// The generation changes whenever the lists or the data they
+        /// serve are updated, i.e., when the data sources are reconfigured
+        /// or a zone is (re)loaded into memory.  It allows the users to
+        /// invalidate what they derived from the data, e.g., cached
+        /// responses.  It stays the same as long as the holder exists.
+        unsigned int getGeneration() const {
+            return (mgr_.generation_);
+        }
     private:
         DataSrcClientsMgrBase& mgr_;
-        typename MutexType::Locker locker_;
+        typename MapMutexType::ReaderLocker locker_;
     };
 
     /// \brief Constructor.
@@ -251,9 +272,9 @@ public:
     DataSrcClientsMgrBase(asiolink::IOService& service) :
         clients_map_(new ClientListsMap),
         fd_guard_(new FDGuard(this)),
-        read_fd_(-1), write_fd_(-1),
+        read_fd_(-1), write_fd_(-1), generation_(0),
         builder_(&command_queue_, &callback_queue_, &cond_, &queue_mutex_,
-                 &clients_map_, &map_mutex_, createFds()),
+                 &clients_map_, &map_mutex_, &generation_, createFds()),
         builder_thread_(boost::bind(&BuilderType::run, &builder_)),
         wakeup_socket_(service, read_fd_)
     {
@@ -336,8 +357,9 @@ public:
     /// cleaner way to use faked data source clients.  Non test code or
     /// newer tests must not use this.
     void setDataSrcClientLists(datasrc::ClientListMapPtr new_lists) {
-        typename MutexType::Locker locker(map_mutex_);
+        typename MapMutexType::Locker locker(map_mutex_);
         clients_map_ = new_lists;
+        ++generation_;
     }
 
     /// \brief Instruct internal thread to (re)load a zone
@@ -507,7 +529,9 @@ private:
                                 // map of actual data source client objects
     boost::scoped_ptr<FDGuard> fd_guard_; // A guard to close the fds.
     int read_fd_, write_fd_;    // Descriptors for wakeup
-    MutexType map_mutex_;       // mutex to protect the clients map
+    MapMutexType map_mutex_;    // mutex to protect the clients map
+    unsigned int generation_;   // incremented on any update of the map or
+                                // of the data, protected by map_mutex_
 
     BuilderType builder_;
     ThreadType builder_thread_; // for safety this should be placed last
@@ -533,7 +557,8 @@ namespace datasrc_clientmgr_internal {
 ///
 /// This class is templated so that we can test it without involving actual
 /// threads or locks.
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType,
+          typename MapMutexType = MutexType>
 class DataSrcClientsBuilderBase : boost::noncopyable {
 private:
     typedef std::map<dns::RRClass,
@@ -561,12 +586,14 @@ public:
                               std::list<FinishedCallback>* callback_queue,
                               CondVarType* cond, MutexType* queue_mutex,
                               datasrc::ClientListMapPtr* clients_map,
-                              MutexType* map_mutex,
+                              MapMutexType* map_mutex,
+                              unsigned int* generation,
                               int wake_fd
         ) :
         command_queue_(command_queue), callback_queue_(callback_queue),
         cond_(cond), queue_mutex_(queue_mutex),
-        clients_map_(clients_map), map_mutex_(map_mutex), wake_fd_(wake_fd)
+        clients_map_(clients_map), map_mutex_(map_mutex),
+        generation_(generation), wake_fd_(wake_fd)
     {}
 
     /// \brief The main loop.
@@ -600,8 +627,9 @@ private:
                 datasrc::ClientListMapPtr new_clients_map =
                     configureDataSource(config);
                 {
-                    typename MutexType::Locker locker(*map_mutex_);
+                    typename MapMutexType::Locker locker(*map_mutex_);
                     new_clients_map.swap(*clients_map_);
+                    ++*generation_;
                 } // lock is released by leaving scope
                 LOG_INFO(auth_logger,
                          AUTH_DATASRC_CLIENTS_BUILDER_RECONFIGURE_SUCCESS);
@@ -634,7 +662,7 @@ private:
                 name(arg->get("data-source-name")->stringValue());
             const isc::data::ConstElementPtr& segment_params =
                 arg->get("segment-params");
-            typename MutexType::Locker locker(*map_mutex_);
+            typename MapMutexType::Locker locker(*map_mutex_);
             const boost::shared_ptr<isc::datasrc::ConfigurableClientList>&
                 list = (**clients_map_)[rrclass];
             if (!list) {
@@ -651,6 +679,7 @@ private:
                     .arg(rrclass).arg(name);
                 std::terminate();
             }
+            ++*generation_;
         } catch (const isc::dns::InvalidRRClass& irce) {
             LOG_FATAL(auth_logger,
                       AUTH_DATASRC_CLIENTS_BUILDER_SEGMENT_BAD_CLASS)
@@ -675,17 +704,19 @@ private:
     CondVarType* cond_;
     MutexType* queue_mutex_;
     datasrc::ClientListMapPtr* clients_map_;
-    MutexType* map_mutex_;
+    MapMutexType* map_mutex_;
+    unsigned int* generation_;
     int wake_fd_;
 };
 
 // Shortcut typedef for normal use
-typedef DataSrcClientsBuilderBase<util::thread::Mutex, util::thread::CondVar>
+typedef DataSrcClientsBuilderBase<util::thread::Mutex, util::thread::CondVar,
+                                  util::thread::RWMutex>
 DataSrcClientsBuilder;
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 void
-DataSrcClientsBuilderBase<MutexType, CondVarType>::run() {
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::run() {
     LOG_INFO(auth_logger, AUTH_DATASRC_CLIENTS_BUILDER_STARTED);
 
     try {
@@ -751,9 +782,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::run() {
     }
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 bool
-DataSrcClientsBuilderBase<MutexType, CondVarType>::handleCommand(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::handleCommand(
     const Command& command)
 {
     const CommandID cid = command.id;
@@ -788,9 +819,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::handleCommand(
     return (true);
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 void
-DataSrcClientsBuilderBase<MutexType, CondVarType>::doLoadZone(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::doLoadZone(
     const isc::data::ConstElementPtr& arg)
 {
     // We assume some basic level validation as this method can only be
@@ -831,8 +862,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doLoadZone(
 
         zwriter->load(); // this can take time but doesn't cause a race
         {   // install() can cause a race and must be in a critical section
-            typename MutexType::Locker locker(*map_mutex_);
+            typename MapMutexType::Locker locker(*map_mutex_);
             zwriter->install();
+            ++*generation_;
         }
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS,
                   AUTH_DATASRC_CLIENTS_BUILDER_LOAD_ZONE)
@@ -855,9 +887,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doLoadZone(
 
 // A dedicated subroutine of doLoadZone().  Separated just for keeping the
 // main method concise.
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 boost::shared_ptr<datasrc::memory::ZoneWriter>
-DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::getZoneWriter(
     datasrc::ConfigurableClientList& client_list,
     const dns::RRClass& rrclass, const dns::Name& origin)
 {
@@ -866,7 +898,7 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
     // source for lookup.  So we need to protect the access here.
     datasrc::ConfigurableClientList::ZoneWriterPair writerpair;
     {
-        typename MutexType::Locker locker(*map_mutex_);
+        typename MapMutexType::Locker locker(*map_mutex_);
         writerpair = client_list.getCachedZoneWriter(origin, false);
     }
 
@@ -911,7 +943,8 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
 typedef DataSrcClientsMgrBase<
     util::thread::Thread,
     datasrc_clientmgr_internal::DataSrcClientsBuilder,
-    util::thread::Mutex, util::thread::CondVar> DataSrcClientsMgr;
+    util::thread::Mutex, util::thread::CondVar,
+    util::thread::RWMutex> DataSrcClientsMgr;
 } // namespace auth
 } // namespace isc
 
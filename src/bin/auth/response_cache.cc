@@ -0,0 +1,165 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/response_cache.h>
+
+#include <dns/name.h>
+#include <dns/rcode.h>
+#include <util/io_utilities.h>
+
+#include <cassert>
+
+using namespace isc::dns;
+using isc::util::OutputBuffer;
+
+namespace {
+// The offset of the flags and of the question name in the header.
+const size_t FLAGS_OFFSET = 2;
+const size_t QUESTION_OFFSET = 12;
+
+// The flags of the response which are copied from the query; see
+// Message::makeResponse().
+const uint16_t QUERY_FLAGS = Message::HEADERFLAG_RD | Message::HEADERFLAG_CD;
+}
+
+namespace isc {
+namespace auth {
+
+ResponseCache::Key::Key(const Question& question, const bool edns,
+                        const bool dnssec_ok, const uint16_t length_limit)
+{
+    const Name& name = question.getName();
+    const size_t name_length = name.getLength();
+    data_.reserve(name_length + 7);
+    // The label lengths are below the upper case letters, so the whole
+    // name in wire format can be normalized as if it were text.
+    for (size_t i = 0; i < name_length; ++i) {
+        const uint8_t c = name.at(i);
+        data_.push_back((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+    }
+    const uint16_t qtype = question.getType().getCode();
+    const uint16_t qclass = question.getClass().getCode();
+    data_.push_back(qtype >> 8);
+    data_.push_back(qtype & 0xff);
+    data_.push_back(qclass >> 8);
+    data_.push_back(qclass & 0xff);
+    data_.push_back((edns ? 1 : 0) | (dnssec_ok ? 2 : 0));
+    data_.push_back(length_limit >> 8);
+    data_.push_back(length_limit & 0xff);
+}
+
+ResponseCache::ResponseCache(const size_t max_entries) :
+    max_entries_(max_entries), generation_(0), hits_(0), misses_(0)
+{}
+
+void
+ResponseCache::setMaxEntries(const size_t max_entries) {
+    clear();
+    max_entries_ = max_entries;
+}
+
+void
+ResponseCache::clear() {
+    index_.clear();
+    entries_.clear();
+}
+
+void
+ResponseCache::checkGeneration(const unsigned int generation) {
+    if (generation != generation_) {
+        clear();
+        generation_ = generation;
+    }
+}
+
+bool
+ResponseCache::lookup(const Key& key, const unsigned int generation,
+                      const Message& query, OutputBuffer& buffer,
+                      ResponseAttributes& attributes)
+{
+    checkGeneration(generation);
+    const EntryMap::iterator found = index_.find(key.data_);
+    if (found == index_.end()) {
+        ++misses_;
+        return (false);
+    }
+    ++hits_;
+
+    // Move the entry to the front, keeping the least recently used one at
+    // the back for eviction.
+    const EntryList::iterator entry = found->second;
+    if (entry != entries_.begin()) {
+        entries_.splice(entries_.begin(), entries_, entry);
+    }
+
+    buffer.clear();
+    buffer.writeData(&entry->data_[0], entry->data_.size());
+    buffer.writeUint16At(query.getQid(), 0);
+    uint16_t flags = util::readUint16(&entry->data_[FLAGS_OFFSET], 2);
+    flags &= ~QUERY_FLAGS;
+    if (query.getHeaderFlag(Message::HEADERFLAG_RD)) {
+        flags |= Message::HEADERFLAG_RD;
+    }
+    if (query.getHeaderFlag(Message::HEADERFLAG_CD)) {
+        flags |= Message::HEADERFLAG_CD;
+    }
+    buffer.writeUint16At(flags, FLAGS_OFFSET);
+
+    // The question name is the first one of the response, so it's never
+    // compressed.  The names compressed against it get its case, as they
+    // would if the response was rendered for this query.
+    const Name& qname = (*query.beginQuestion())->getName();
+    for (size_t i = 0; i < qname.getLength(); ++i) {
+        buffer.writeUint8At(qname.at(i), QUESTION_OFFSET + i);
+    }
+
+    attributes = entry->attributes_;
+    return (true);
+}
+
+void
+ResponseCache::insert(const Key& key, const unsigned int generation,
+                      const Message& response, const void* data,
+                      const size_t length)
+{
+    if (max_entries_ == 0) {
+        return;
+    }
+    checkGeneration(generation);
+    assert(length >= QUESTION_OFFSET);
+
+    const EntryMap::iterator found = index_.find(key.data_);
+    if (found != index_.end()) {
+        entries_.erase(found->second);
+        index_.erase(found);
+    } else if (entries_.size() >= max_entries_) {
+        index_.erase(entries_.back().key_);
+        entries_.pop_back();
+    }
+
+    entries_.push_front(Entry());
+    Entry& entry = entries_.front();
+    entry.key_ = key.data_;
+    entry.attributes_.rcode_ = response.getRcode().getCode();
+    entry.attributes_.authoritative_ =
+        response.getHeaderFlag(Message::HEADERFLAG_AA);
+    entry.attributes_.answer_count_ =
+        response.getRRCount(Message::SECTION_ANSWER);
+    const uint8_t* const wire = static_cast<const uint8_t*>(data);
+    entry.data_.assign(wire, wire + length);
+    index_[entry.key_] = entries_.begin();
+}
+
+} // namespace auth
+} // namespace isc
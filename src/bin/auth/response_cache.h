@@ -0,0 +1,190 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_RESPONSE_CACHE_H
+#define AUTH_RESPONSE_CACHE_H 1
+
+#include <dns/message.h>
+#include <dns/question.h>
+#include <util/buffer.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace auth {
+
+/// \brief A cache of rendered responses to normal queries.
+///
+/// Answering the same question again and again, the server would search
+/// the zone and render the same response each time.  This class keeps the
+/// responses in wire format, so as a repeated question can be answered by
+/// copying the cached response and patching the few fields which depend on
+/// the query: the ID, the RD and CD flags and the case of the question name.
+///
+/// The responses are keyed by the question, with the name normalized to
+/// lower case, and by the attributes of the query which change the
+/// response: whether it has EDNS, the DO bit and the maximum size of the
+/// response.  The caller must not cache the responses which depend on
+/// anything else, e.g. the TSIG signed ones.
+///
+/// The cache is emptied whenever the data it was built from changes.  The
+/// data is identified by a generation number provided by the caller, which
+/// is expected to change when a new version of a zone is installed or the
+/// data sources are reconfigured.
+///
+/// When the cache is full, the least recently used response is evicted.
+///
+/// The class is not thread-safe; each thread processing queries is expected
+/// to have its own cache.
+class ResponseCache : boost::noncopyable {
+public:
+    /// \brief The key of a response in the cache.
+    ///
+    /// It is built once per query, so as it can be used both to look up
+    /// the response and to insert it if it isn't found.
+    class Key {
+    public:
+        /// \brief Constructor.
+        ///
+        /// \param question The question of the query.
+        /// \param edns Whether the query has EDNS.
+        /// \param dnssec_ok Whether the DO bit is set in the query.
+        /// \param length_limit The maximum size of the response.
+        Key(const dns::Question& question, bool edns, bool dnssec_ok,
+            uint16_t length_limit);
+
+    private:
+        friend class ResponseCache;
+        std::string data_;
+    };
+
+    /// \brief Attributes of a cached response.
+    ///
+    /// These are what the statistics need to account for the response,
+    /// which is not built in a \c Message when it is found in the cache.
+    struct ResponseAttributes {
+        uint16_t rcode_;            ///< The Rcode of the response
+        bool authoritative_;        ///< Whether the AA bit is set
+        unsigned int answer_count_; ///< The number of RRs in the answer
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \param max_entries The maximum number of responses to cache.  If
+    /// it's 0, the cache is disabled.
+    explicit ResponseCache(size_t max_entries = 0);
+
+    /// \brief Set the maximum number of responses to cache.
+    ///
+    /// The cache is emptied.
+    ///
+    /// \param max_entries The maximum number of responses.  If it's 0, the
+    /// cache is disabled.
+    void setMaxEntries(size_t max_entries);
+
+    /// \brief Return the maximum number of responses to cache.
+    size_t getMaxEntries() const {
+        return (max_entries_);
+    }
+
+    /// \brief Return the number of cached responses.
+    size_t getEntryCount() const {
+        return (entries_.size());
+    }
+
+    /// \brief Return the number of the successful lookups.
+    uint64_t getHits() const {
+        return (hits_);
+    }
+
+    /// \brief Return the number of the failed lookups.
+    uint64_t getMisses() const {
+        return (misses_);
+    }
+
+    /// \brief Look up the response to a query.
+    ///
+    /// If found, the response is written to the buffer, with the ID, the
+    /// RD and CD flags and the question name of the query.
+    ///
+    /// \param key The key of the query.
+    /// \param generation The generation of the data the query is answered
+    /// from.  If it differs from the one of the cached responses, the cache
+    /// is emptied first.
+    /// \param query The query.  It may have been turned into the response
+    /// already, as \c Message::makeResponse() keeps what is used here.
+    /// \param buffer The buffer the response is written to.  It's cleared
+    /// first.
+    /// \param attributes Set to the attributes of the response, if found.
+    /// \return true if the response was found, false otherwise.
+    bool lookup(const Key& key, unsigned int generation,
+                const dns::Message& query, util::OutputBuffer& buffer,
+                ResponseAttributes& attributes);
+
+    /// \brief Insert the response to a query.
+    ///
+    /// If the cache is full, the least recently used response is evicted.
+    /// Nothing is done if the cache is disabled.
+    ///
+    /// \param key The key of the query, as passed to \c lookup().
+    /// \param generation The generation of the data the response was built
+    /// from.
+    /// \param response The response message, for the attributes.
+    /// \param data The response in wire format.
+    /// \param length The length of the response.
+    void insert(const Key& key, unsigned int generation,
+                const dns::Message& response, const void* data,
+                size_t length);
+
+    /// \brief Empty the cache.
+    ///
+    /// The numbers of hits and misses are kept.
+    void clear();
+
+private:
+    struct Entry {
+        std::string key_;
+        ResponseAttributes attributes_;
+        std::vector<uint8_t> data_;
+    };
+    typedef std::list<Entry> EntryList;
+    typedef std::map<std::string, EntryList::iterator> EntryMap;
+
+    // Empty the cache if the data it was built from has changed.
+    void checkGeneration(unsigned int generation);
+
+    size_t max_entries_;
+    unsigned int generation_;
+    // The responses, the most recently used first.
+    EntryList entries_;
+    EntryMap index_;
+    uint64_t hits_;
+    uint64_t misses_;
+};
+
+} // namespace auth
+} // namespace isc
+
+#endif // AUTH_RESPONSE_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -26,6 +26,7 @@
 #include <boost/optional.hpp>
 
 #include <bitset>
+#include <vector>
 
 #include <stdint.h>
 
@@ -63,6 +64,9 @@ private:
     int req_address_family_;        // IP version
     int req_transport_protocol_;    // Transport layer protocol
     boost::optional<isc::dns::Opcode> req_opcode_;  // OpCode
+    // number of RRs in the answer section of the response, if it isn't
+    // held by the response message
+    boost::optional<unsigned int> res_answer_count_;
     enum BitAttributes {
         REQ_WITH_EDNS_0,            // request with EDNS ver.0
         REQ_WITH_DNSSEC_OK,         // DNSSEC OK (DO) bit is set in request
@@ -251,6 +255,28 @@ public:
     void setResponseTSIG(const bool signed_tsig) {
         bit_attributes_[RES_TSIG_SIGNED] = signed_tsig;
     }
+
+    /// \brief Return the number of RRs in the answer section of the
+    /// response, if it was set.
+    ///
+    /// \return the number of RRs wrapped with boost::optional; it's
+    ///         converted to false if it hasn't been set, in which case it is
+    ///         taken from the response message.
+    /// \throw None
+    const boost::optional<unsigned int>& getResponseAnswerCount() const {
+        return (res_answer_count_);
+    }
+
+    /// \brief Set the number of RRs in the answer section of the response.
+    ///
+    /// This is for the responses which are not built in the response
+    /// message, e.g., the ones taken from the response cache.
+    ///
+    /// \param answer_count the number of RRs in the answer section
+    /// \throw None
+    void setResponseAnswerCount(const unsigned int answer_count) {
+        res_answer_count_ = answer_count;
+    }
 };
 
 /// \brief Set of DNS message counters.
@@ -316,6 +342,22 @@ public:
     /// \return statistics data
     /// \throw std::bad_alloc Internal resource allocation fails
     ConstItemTreePtr get() const;
+
+    /// \brief Get the sum of several sets of statistics counters.
+    ///
+    /// When the queries are processed by several threads, each of them
+    /// increments its own set of counters, so as they don't need to be
+    /// synchronized.  This returns the statistics of the server as a whole,
+    /// in the same form as \c get() does.
+    ///
+    /// The counters may be incremented by the other threads while they are
+    /// summed, in which case some of the latest increments may be missing
+    /// in the result.
+    ///
+    /// \param shards the sets of counters to sum
+    /// \return statistics data
+    /// \throw std::bad_alloc Internal resource allocation fails
+    static ConstItemTreePtr get(const std::vector<const Counters*>& shards);
 };
 
 } // namespace statistics
@@ -30,6 +30,7 @@
 
 #include <server_common/portconfig.h>
 #include <server_common/keyring.h>
+#include <server_common/socket_request.h>
 
 #include <datasrc/client_list.h>
 #include <auth/auth_srv.h>
@@ -60,11 +61,15 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/foreach.hpp>
 
+#include <cstring>
 #include <vector>
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
 #include <netdb.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace isc::cc;
@@ -1549,6 +1554,191 @@ TEST_F(AuthSrvTest, listenAddresses) {
                                 "Released tokens");
 }
 
+// A socket requestor creating real sockets on an ephemeral port of the
+// loopback address, so as the server can actually receive queries.
+class LoopbackSocketRequestor : public isc::server_common::SocketRequestor {
+public:
+    LoopbackSocketRequestor() : udp_port_(0) {
+        isc::server_common::initTestSocketRequestor(this);
+    }
+    ~LoopbackSocketRequestor() {
+        isc::server_common::initTestSocketRequestor(NULL);
+    }
+    virtual SocketID requestSocket(Protocol protocol, const std::string&,
+                                   uint16_t, ShareMode, const std::string&)
+    {
+        const int fd = socket(AF_INET, protocol == UDP ? SOCK_DGRAM :
+                              SOCK_STREAM, 0);
+        EXPECT_NE(-1, fd);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        EXPECT_EQ(0, bind(fd, convertSockAddr(&addr), sizeof(addr)));
+        if (protocol == UDP) {
+            socklen_t len = sizeof(addr);
+            EXPECT_EQ(0, getsockname(fd, convertSockAddr(&addr), &len));
+            udp_port_ = ntohs(addr.sin_port);
+        } else {
+            EXPECT_EQ(0, listen(fd, 1));
+        }
+        return (SocketID(fd, "token"));
+    }
+    virtual void releaseSocket(const std::string&) {}
+
+    // The port of the last UDP socket created
+    uint16_t udp_port_;
+};
+
+// The queries received on the UDP sockets are answered by the worker
+// threads, even though the IO service of the main thread isn't running, and
+// the statistics include their counters.
+TEST_F(AuthSrvTest, workerThreads) {
+    DNSService dnss(server.getIOService(), server.getDNSLookupProvider(),
+                    server.getDNSAnswerProvider());
+    server.setDNSService(dnss);
+    LoopbackSocketRequestor requestor;
+    server.setWorkerThreads(2);
+    EXPECT_EQ(2, server.getWorkerThreads());
+    AddressList addresses;
+    addresses.push_back(AddressPair("127.0.0.1", 53210));
+    server.setListenAddresses(addresses);
+    ASSERT_NE(0, requestor.udp_port_);
+
+    UnitTestUtil::createRequestMessage(request_message, Opcode::QUERY(),
+                                       default_qid, Name("version.bind"),
+                                       RRClass::CH(), RRType::TXT());
+    MessageRenderer renderer;
+    request_message.toWire(renderer);
+
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, fd);
+    struct timeval timeout = { 10, 0 };
+    EXPECT_EQ(0, setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                            sizeof(timeout)));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(requestor.udp_port_);
+    EXPECT_EQ(renderer.getLength(),
+              sendto(fd, renderer.getData(), renderer.getLength(), 0,
+                     convertSockAddr(&addr), sizeof(addr)));
+    uint8_t response[512];
+    const ssize_t length = recv(fd, response, sizeof(response), 0);
+    close(fd);
+    ASSERT_LT(0, length);
+
+    Message response_message(Message::PARSE);
+    InputBuffer buffer(response, length);
+    response_message.fromWire(buffer);
+    headerCheck(response_message, default_qid, Rcode::REFUSED(),
+                opcode.getCode(), QR_FLAG, 1, 0, 0, 0);
+
+    // The counters are incremented before the response is sent.
+    std::map<std::string, int> expect;
+    expect["request.v4"] = 1;
+    expect["request.udp"] = 1;
+    expect["opcode.query"] = 1;
+    expect["responses"] = 1;
+    expect["qrynoauthans"] = 1;
+    expect["authqryrej"] = 1;
+    expect["rcode.refused"] = 1;
+    checkStatisticsCounters(server.getStatistics()->get("zones")->
+                            get("_SERVER_"), expect);
+
+    // The queries processed by the main thread are counted too.
+    createRequestPacket(request_message, IPPROTO_UDP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    expect["request.v4"] = 2;
+    expect["request.udp"] = 2;
+    expect["opcode.query"] = 2;
+    expect["responses"] = 2;
+    expect["qrynoauthans"] = 2;
+    expect["authqryrej"] = 2;
+    expect["rcode.refused"] = 2;
+    checkStatisticsCounters(server.getStatistics()->get("zones")->
+                            get("_SERVER_"), expect);
+
+    server.setListenAddresses(AddressList());
+    server.setWorkerThreads(0);
+    EXPECT_EQ(0, server.getWorkerThreads());
+    server.setDNSService(dnss_);
+}
+
+TEST_F(AuthSrvTest, responseCache) {
+    EXPECT_EQ(0, server.getResponseCacheSize());
+    server.setResponseCacheSize(10);
+    EXPECT_EQ(10, server.getResponseCacheSize());
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+
+    // The first query is answered from the zone and its response cached.
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    EXPECT_EQ(0, server.getResponseCacheHits());
+    EXPECT_EQ(1, server.getResponseCacheMisses());
+    const std::vector<uint8_t> rendered(
+        static_cast<const uint8_t*>(response_obuffer->getData()),
+        static_cast<const uint8_t*>(response_obuffer->getData()) +
+        response_obuffer->getLength());
+
+    // The same query is answered from the cache, with the same response.
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    EXPECT_EQ(1, server.getResponseCacheHits());
+    EXPECT_EQ(1, server.getResponseCacheMisses());
+    ASSERT_EQ(rendered.size(), response_obuffer->getLength());
+    EXPECT_EQ(0, memcmp(&rendered[0], response_obuffer->getData(),
+                        rendered.size()));
+
+    // Both responses are accounted in the same way.
+    const ConstElementPtr stats = server.getStatistics()->get("zones")->
+        get("_SERVER_");
+    EXPECT_EQ(2, stats->get("responses")->intValue());
+    EXPECT_EQ(2, stats->get("qryauthans")->intValue());
+    EXPECT_EQ(2, stats->get("qrysuccess")->intValue());
+    EXPECT_EQ(2, stats->get("rcode")->get("noerror")->intValue());
+
+    // Loading the zone again invalidates the cached response.
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_EQ(1, server.getResponseCacheHits());
+    EXPECT_EQ(2, server.getResponseCacheMisses());
+}
+
+// The responses from a database aren't cached, as its updates are not known
+// to the server.
+#ifdef USE_STATIC_LINK
+TEST_F(AuthSrvTest, DISABLED_responseCacheDatabase) {
+#else
+TEST_F(AuthSrvTest, responseCacheDatabase) {
+#endif
+    server.setResponseCacheSize(10);
+    updateDatabase(server, CONFIG_TESTDB);
+    UnitTestUtil::createRequestMessage(request_message, Opcode::QUERY(),
+                                       default_qid, Name("example.com"),
+                                       RRClass::IN(), RRType::NS());
+    createRequestPacket(request_message, IPPROTO_UDP);
+    for (int i = 0; i < 2; ++i) {
+        parse_message->clear(Message::PARSE);
+        response_obuffer->clear();
+        server.processMessage(*io_message, *parse_message, *response_obuffer,
+                              &dnsserv);
+        EXPECT_TRUE(dnsserv.hasAnswer());
+    }
+    EXPECT_EQ(0, server.getResponseCacheHits());
+    EXPECT_EQ(0, server.getResponseCacheMisses());
+}
+
 TEST_F(AuthSrvTest, processNormalQuery_reuseRenderer1) {
     UnitTestUtil::createRequestMessage(request_message, Opcode::QUERY(),
                                        default_qid, Name("example.com"),
@@ -135,11 +135,13 @@ TEST_F(AuthConfigTest, listenAddressConfig) {
 
     // listenAddressConfig should have attempted to create 4 DNS server
     // objects: two IP addresses, TCP and UDP for each.  For UDP, the "SYNC_OK"
-    // option should have been specified.
+    // and "BATCH_OK" options should have been specified.
     EXPECT_EQ(2, dnss_.getTCPFdParams().size());
     EXPECT_EQ(2, dnss_.getUDPFdParams().size());
-    EXPECT_EQ(DNSService::SERVER_SYNC_OK, dnss_.getUDPFdParams().at(0).options);
-    EXPECT_EQ(DNSService::SERVER_SYNC_OK, dnss_.getUDPFdParams().at(1).options);
+    const int options = DNSService::SERVER_SYNC_OK |
+        DNSService::SERVER_BATCH_OK;
+    EXPECT_EQ(options, dnss_.getUDPFdParams().at(0).options);
+    EXPECT_EQ(options, dnss_.getUDPFdParams().at(1).options);
 }
 
 // Try setting tcp receive timeout through config
@@ -155,4 +157,18 @@ TEST_F(AuthConfigTest, tcpRecvTimeoutConfig) {
                  AuthConfigError);
 }
 
+// Try setting the number of worker threads through config
+TEST_F(AuthConfigTest, workerThreadsConfig) {
+    EXPECT_EQ(0, server.getWorkerThreads());
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"worker_threads\": 2 }"));
+    EXPECT_EQ(2, server.getWorkerThreads());
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"worker_threads\": 0 }"));
+    EXPECT_EQ(0, server.getWorkerThreads());
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"worker_threads\": -1 }")),
+                 AuthConfigError);
+}
+
 }
@@ -59,9 +59,9 @@ protected:
     DataSrcClientsBuilderTest() :
         clients_map(new std::map<RRClass,
                     boost::shared_ptr<ConfigurableClientList> >),
-        write_end(-1), read_end(-1),
+        write_end(-1), read_end(-1), generation(0),
         builder(&command_queue, &callback_queue, &cond, &queue_mutex,
-                &clients_map, &map_mutex, generateSockets()),
+                &clients_map, &map_mutex, &generation, generateSockets()),
         cond(command_queue, delayed_command_queue), rrclass(RRClass::IN()),
         shutdown_cmd(SHUTDOWN, ConstElementPtr(), FinishedCallback()),
         noop_cmd(NOOP, ConstElementPtr(), FinishedCallback())
@@ -82,6 +82,7 @@ protected:
     std::list<Command> delayed_command_queue; // commands available after wait
     std::list<FinishedCallback> callback_queue; // Callbacks from commands
     int write_end, read_end;
+    unsigned int generation; // generation of the data, updated by builder
     TestDataSrcClientsBuilder builder;
     TestCondVar cond;
     TestMutex queue_mutex;
@@ -235,6 +236,7 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_TRUE(builder.handleCommand(reconfig_cmd));
     EXPECT_EQ(1, clients_map->size());
     EXPECT_EQ(1, map_mutex.lock_count);
+    EXPECT_EQ(1, generation);
 
     // Store the nonempty clients map we now have
     ClientListMapPtr working_config_clients(clients_map);
@@ -263,6 +265,8 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_TRUE(builder.handleCommand(reconfig_cmd));
     EXPECT_EQ(working_config_clients, clients_map);
     EXPECT_EQ(1, map_mutex.lock_count);
+    // The data haven't changed after all these failures
+    EXPECT_EQ(1, generation);
 
     // Reconfigure again with the same good clients, the result should
     // be a different map than the original, but not an empty one.
@@ -277,6 +281,7 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_TRUE(builder.handleCommand(reconfig_cmd));
     EXPECT_EQ(0, clients_map->size());
     EXPECT_EQ(3, map_mutex.lock_count);
+    EXPECT_EQ(3, generation);
 
     // Also check if it has been cleanly unlocked every time
     EXPECT_EQ(3, map_mutex.unlock_count);
@@ -376,6 +381,7 @@ TEST_F(DataSrcClientsBuilderTest, loadZone) {
                                    "{\"class\": \"IN\","
                                    " \"origin\": \"test1.example\"}"),
                                FinishedCallback());
+    const unsigned int old_generation = generation;
     EXPECT_TRUE(builder.handleCommand(loadzone_cmd));
 
     // loadZone involves two critical sections: one for getting the zone
@@ -384,6 +390,9 @@ TEST_F(DataSrcClientsBuilderTest, loadZone) {
     EXPECT_EQ(2, map_mutex.lock_count);
     EXPECT_EQ(2, map_mutex.unlock_count);
 
+    // Installing the new version of the zone changes the generation.
+    EXPECT_EQ(old_generation + 1, generation);
+
     newZoneChecks(clients_map, rrclass);
 }
 
@@ -0,0 +1,226 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/response_cache.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rdata.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <util/buffer.h>
+
+#include <gtest/gtest.h>
+
+using namespace isc::dns;
+using namespace isc::dns::rdata;
+using namespace isc::auth;
+using isc::util::InputBuffer;
+using isc::util::OutputBuffer;
+
+namespace {
+
+class ResponseCacheTest : public ::testing::Test {
+protected:
+    ResponseCacheTest() :
+        cache_(10), buffer_(0),
+        qname_("www.example.com"),
+        key_(Question(qname_, RRClass::IN(), RRType::A()), false, false, 512)
+    {}
+
+    // Make a query for the given name and type.
+    void makeQuery(Message& query, const Name& qname, const RRType& qtype,
+                   const qid_t qid, const bool rd, const bool cd)
+    {
+        query.setQid(qid);
+        query.setOpcode(Opcode::QUERY());
+        query.setHeaderFlag(Message::HEADERFLAG_RD, rd);
+        query.setHeaderFlag(Message::HEADERFLAG_CD, cd);
+        query.addQuestion(Question(qname, RRClass::IN(), qtype));
+    }
+
+    // Make and render the response to a query for the given name, with an
+    // A record in the answer section.
+    void makeResponse(Message& response, MessageRenderer& renderer,
+                      const Name& qname)
+    {
+        makeQuery(response, qname, RRType::A(), 0x1111, false, false);
+        response.setHeaderFlag(Message::HEADERFLAG_QR);
+        response.setHeaderFlag(Message::HEADERFLAG_AA);
+        response.setRcode(Rcode::NOERROR());
+        RRsetPtr rrset(new RRset(qname_, RRClass::IN(), RRType::A(),
+                                 RRTTL(3600)));
+        rrset->addRdata(createRdata(RRType::A(), RRClass::IN(), "192.0.2.1"));
+        response.addRRset(Message::SECTION_ANSWER, rrset);
+        response.toWire(renderer);
+    }
+
+    // Insert the response to the default question.
+    void insertResponse(const ResponseCache::Key& key,
+                        const unsigned int generation)
+    {
+        Message response(Message::RENDER);
+        MessageRenderer renderer;
+        makeResponse(response, renderer, qname_);
+        cache_.insert(key, generation, response, renderer.getData(),
+                      renderer.getLength());
+    }
+
+    bool lookup(const ResponseCache::Key& key, const unsigned int generation)
+    {
+        Message query(Message::RENDER);
+        makeQuery(query, qname_, RRType::A(), 0x2222, false, false);
+        return (cache_.lookup(key, generation, query, buffer_, attributes_));
+    }
+
+    ResponseCache cache_;
+    OutputBuffer buffer_;
+    ResponseCache::ResponseAttributes attributes_;
+    const Name qname_;
+    const ResponseCache::Key key_;
+};
+
+TEST_F(ResponseCacheTest, disabled) {
+    ResponseCache cache;
+    EXPECT_EQ(0, cache.getMaxEntries());
+
+    Message response(Message::RENDER);
+    MessageRenderer renderer;
+    makeResponse(response, renderer, qname_);
+    cache.insert(key_, 0, response, renderer.getData(), renderer.getLength());
+    EXPECT_EQ(0, cache.getEntryCount());
+
+    Message query(Message::RENDER);
+    makeQuery(query, qname_, RRType::A(), 0x2222, false, false);
+    EXPECT_FALSE(cache.lookup(key_, 0, query, buffer_, attributes_));
+    EXPECT_EQ(1, cache.getMisses());
+}
+
+TEST_F(ResponseCacheTest, lookup) {
+    EXPECT_FALSE(lookup(key_, 0));
+    insertResponse(key_, 0);
+    EXPECT_EQ(1, cache_.getEntryCount());
+
+    // The response is patched with the ID, the flags and the case of the
+    // question name of the query, which are not in the key.
+    const Name qname("WWW.example.COM");
+    Message query(Message::RENDER);
+    makeQuery(query, qname, RRType::A(), 0x2222, true, true);
+    const ResponseCache::Key key(**query.beginQuestion(), false, false, 512);
+    ASSERT_TRUE(cache_.lookup(key, 0, query, buffer_, attributes_));
+    EXPECT_EQ(1, cache_.getHits());
+    EXPECT_EQ(1, cache_.getMisses());
+
+    EXPECT_EQ(Rcode::NOERROR().getCode(), attributes_.rcode_);
+    EXPECT_TRUE(attributes_.authoritative_);
+    EXPECT_EQ(1, attributes_.answer_count_);
+
+    Message parsed(Message::PARSE);
+    InputBuffer wire(buffer_.getData(), buffer_.getLength());
+    parsed.fromWire(wire);
+    EXPECT_EQ(0x2222, parsed.getQid());
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_QR));
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_AA));
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_CD));
+    EXPECT_EQ("WWW.example.COM.",
+              (*parsed.beginQuestion())->getName().toText());
+    EXPECT_EQ(1, parsed.getRRCount(Message::SECTION_ANSWER));
+
+    // And the flags are cleared if the query doesn't have them.
+    Message query2(Message::RENDER);
+    makeQuery(query2, qname_, RRType::A(), 0x3333, false, false);
+    ASSERT_TRUE(cache_.lookup(key_, 0, query2, buffer_, attributes_));
+    Message parsed2(Message::PARSE);
+    InputBuffer wire2(buffer_.getData(), buffer_.getLength());
+    parsed2.fromWire(wire2);
+    EXPECT_EQ(0x3333, parsed2.getQid());
+    EXPECT_FALSE(parsed2.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_FALSE(parsed2.getHeaderFlag(Message::HEADERFLAG_CD));
+    EXPECT_EQ("www.example.com.",
+              (*parsed2.beginQuestion())->getName().toText());
+}
+
+TEST_F(ResponseCacheTest, key) {
+    insertResponse(key_, 0);
+    const Question question(qname_, RRClass::IN(), RRType::A());
+
+    // Any of the attributes of the query changing the response makes
+    // another key.
+    EXPECT_FALSE(lookup(ResponseCache::Key(question, true, false, 512), 0));
+    EXPECT_FALSE(lookup(ResponseCache::Key(question, true, true, 512), 0));
+    EXPECT_FALSE(lookup(ResponseCache::Key(question, false, false, 65535),
+                        0));
+    EXPECT_FALSE(lookup(ResponseCache::Key(
+                            Question(qname_, RRClass::IN(), RRType::AAAA()),
+                            false, false, 512), 0));
+    EXPECT_FALSE(lookup(ResponseCache::Key(
+                            Question(qname_, RRClass::CH(), RRType::A()),
+                            false, false, 512), 0));
+    EXPECT_FALSE(lookup(ResponseCache::Key(
+                            Question(Name("example.com"), RRClass::IN(),
+                                     RRType::A()),
+                            false, false, 512), 0));
+    EXPECT_TRUE(lookup(ResponseCache::Key(question, false, false, 512), 0));
+}
+
+TEST_F(ResponseCacheTest, generation) {
+    insertResponse(key_, 0);
+    EXPECT_TRUE(lookup(key_, 0));
+
+    // A new generation of the data empties the cache.
+    EXPECT_FALSE(lookup(key_, 1));
+    EXPECT_EQ(0, cache_.getEntryCount());
+
+    // The responses of the old generation aren't kept either.
+    insertResponse(key_, 0);
+    EXPECT_FALSE(lookup(key_, 1));
+}
+
+TEST_F(ResponseCacheTest, evict) {
+    cache_.setMaxEntries(2);
+    const ResponseCache::Key key1(
+        Question(qname_, RRClass::IN(), RRType::A()), true, false, 512);
+    const ResponseCache::Key key2(
+        Question(qname_, RRClass::IN(), RRType::A()), true, true, 512);
+    insertResponse(key_, 0);
+    insertResponse(key1, 0);
+    EXPECT_EQ(2, cache_.getEntryCount());
+
+    // Use the first one, so as the second one is the least recently used.
+    EXPECT_TRUE(lookup(key_, 0));
+    insertResponse(key2, 0);
+    EXPECT_EQ(2, cache_.getEntryCount());
+    EXPECT_TRUE(lookup(key_, 0));
+    EXPECT_FALSE(lookup(key1, 0));
+    EXPECT_TRUE(lookup(key2, 0));
+
+    // Inserting an existing key replaces the response.
+    insertResponse(key2, 0);
+    EXPECT_EQ(2, cache_.getEntryCount());
+
+    // Setting the size empties the cache, but the counts are kept.
+    cache_.setMaxEntries(2);
+    EXPECT_EQ(0, cache_.getEntryCount());
+    EXPECT_EQ(3, cache_.getHits());
+    EXPECT_EQ(1, cache_.getMisses());
+}
+
+}
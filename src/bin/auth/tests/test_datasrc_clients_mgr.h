@@ -71,6 +71,9 @@ public:
     private:
         TestMutex& mutex_;
     };
+    // The shared lock is counted in the same way, so as the tests don't
+    // need to care about which one the manager takes.
+    typedef Locker ReaderLocker;
     size_t lock_count; // number of lock acquisitions; tests can check this
     size_t unlock_count; // number of lock releases; tests can check this
     size_t noop_count;          // allow doNoop() to modify this
@@ -162,7 +165,7 @@ public:
         TestCondVar* cond,
         TestMutex* queue_mutex,
         isc::datasrc::ClientListMapPtr* clients_map,
-        TestMutex* map_mutex, int wakeup_fd)
+        TestMutex* map_mutex, unsigned int*, int wakeup_fd)
     {
         FakeDataSrcClientsBuilder::started = false;
         FakeDataSrcClientsBuilder::command_queue = command_queue;
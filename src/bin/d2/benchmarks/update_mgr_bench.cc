@@ -0,0 +1,381 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <asio.hpp>
+#include <asiolink/io_address.h>
+#include <cc/data.h>
+#include <config/ccsession.h>
+#include <d2/d2_asio.h>
+#include <d2/d2_cfg_mgr.h>
+#include <d2/d2_queue_mgr.h>
+#include <d2/d2_update_mgr.h>
+#include <dhcp_ddns/ncr_msg.h>
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/opcode.h>
+#include <dns/rcode.h>
+#include <log/logger_support.h>
+#include <util/buffer.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace isc;
+using namespace isc::d2;
+
+namespace {
+
+// Stand-in for a DNS server: it responds to each update with NOERROR,
+// after a fixed delay, which models the time the server takes to process
+// the update.  As the delay is the same for all the updates, the
+// responses are sent in the order the updates were received.  The updates
+// are received over UDP or, on a single connection, over TCP.
+class DelayedServer {
+public:
+    DelayedServer(asiolink::IOService& io_service,
+                  const asiolink::IOAddress& address, const uint16_t port,
+                  const unsigned int delay_ms, const bool tcp) :
+        udp_socket_(io_service.get_io_service()),
+        acceptor_(io_service.get_io_service()),
+        tcp_socket_(io_service.get_io_service()),
+        timer_(io_service.get_io_service()),
+        delay_(boost::posix_time::milliseconds(delay_ms)),
+        received_(0)
+    {
+        const asio::ip::address asio_address =
+            asio::ip::address::from_string(address.toText());
+        if (tcp) {
+            const asio::ip::tcp::endpoint endpoint(asio_address, port);
+            acceptor_.open(endpoint.protocol());
+            acceptor_.set_option(asio::socket_base::reuse_address(true));
+            acceptor_.bind(endpoint);
+            acceptor_.listen();
+            acceptor_.async_accept(tcp_socket_,
+                                   boost::bind(&DelayedServer::acceptHandler,
+                                               this, _1));
+        } else {
+            const asio::ip::udp::endpoint endpoint(asio_address, port);
+            udp_socket_.open(endpoint.protocol());
+            udp_socket_.set_option(asio::socket_base::reuse_address(true));
+            udp_socket_.bind(endpoint);
+            receive();
+        }
+    }
+
+    size_t getReceived() const { return (received_); }
+
+private:
+    struct Response {
+        boost::posix_time::ptime deadline_;
+        asio::ip::udp::endpoint remote_;
+        std::vector<uint8_t> data_;
+    };
+
+    void receive() {
+        udp_socket_.async_receive_from(asio::buffer(buffer_, sizeof(buffer_)),
+                                       remote_,
+                                       boost::bind(&DelayedServer::
+                                                   requestHandler,
+                                                   this, _1, _2));
+    }
+
+    void requestHandler(const asio::error_code& error, size_t length) {
+        if (!error && length > 0) {
+            handleRequest(length);
+        }
+        receive();
+    }
+
+    void acceptHandler(const asio::error_code& error) {
+        if (!error) {
+            readLength();
+        }
+    }
+
+    void readLength() {
+        asio::async_read(tcp_socket_, asio::buffer(buffer_, 2),
+                         boost::bind(&DelayedServer::lengthHandler,
+                                     this, _1));
+    }
+
+    void lengthHandler(const asio::error_code& error) {
+        if (error) {
+            return;
+        }
+        const size_t length = (buffer_[0] << 8) | buffer_[1];
+        asio::async_read(tcp_socket_, asio::buffer(buffer_, length),
+                         boost::bind(&DelayedServer::tcpRequestHandler,
+                                     this, _1, _2));
+    }
+
+    void tcpRequestHandler(const asio::error_code& error, size_t length) {
+        if (error) {
+            return;
+        }
+        handleRequest(length);
+        readLength();
+    }
+
+    void handleRequest(const size_t length) {
+        ++received_;
+        dns::Message request(dns::Message::PARSE);
+        util::InputBuffer request_buf(buffer_, length);
+        try {
+            request.fromWire(request_buf);
+            queueResponse(request);
+        } catch (const std::exception& ex) {
+            cerr << "Update request is corrupt: " << ex.what() << endl;
+        }
+    }
+
+    void queueResponse(const dns::Message& request) {
+        dns::Message response(dns::Message::RENDER);
+        response.setQid(request.getQid());
+        response.setOpcode(dns::Opcode(dns::Opcode::UPDATE_CODE));
+        response.setHeaderFlag(dns::Message::HEADERFLAG_QR, true);
+        response.setRcode(dns::Rcode::NOERROR());
+        dns::MessageRenderer renderer;
+        response.toWire(renderer);
+
+        Response pending;
+        pending.deadline_ =
+            boost::posix_time::microsec_clock::universal_time() + delay_;
+        pending.remote_ = remote_;
+        const uint8_t* data =
+            static_cast<const uint8_t*>(renderer.getData());
+        if (tcp_socket_.is_open()) {
+            pending.data_.push_back(renderer.getLength() >> 8);
+            pending.data_.push_back(renderer.getLength() & 0xff);
+        }
+        pending.data_.insert(pending.data_.end(), data,
+                             data + renderer.getLength());
+        responses_.push_back(pending);
+        if (responses_.size() == 1) {
+            scheduleSend();
+        }
+    }
+
+    void scheduleSend() {
+        timer_.expires_at(responses_.front().deadline_);
+        timer_.async_wait(boost::bind(&DelayedServer::sendHandler, this, _1));
+    }
+
+    void sendHandler(const asio::error_code& error) {
+        if (error) {
+            return;
+        }
+        const boost::posix_time::ptime now =
+            boost::posix_time::microsec_clock::universal_time();
+        while (!responses_.empty() && (responses_.front().deadline_ <= now)) {
+            const Response& response = responses_.front();
+            if (tcp_socket_.is_open()) {
+                asio::write(tcp_socket_, asio::buffer(response.data_));
+            } else {
+                udp_socket_.send_to(asio::buffer(response.data_),
+                                    response.remote_);
+            }
+            responses_.pop_front();
+        }
+        if (!responses_.empty()) {
+            scheduleSend();
+        }
+    }
+
+    asio::ip::udp::socket udp_socket_;
+    asio::ip::tcp::acceptor acceptor_;
+    asio::ip::tcp::socket tcp_socket_;
+    asio::deadline_timer timer_;
+    const boost::posix_time::time_duration delay_;
+    asio::ip::udp::endpoint remote_;
+    uint8_t buffer_[65536];
+    std::deque<Response> responses_;
+    size_t received_;
+};
+
+// Configures a single forward domain served by the stand-in server, over
+// UDP or TCP.  The reverse updates are not configured.
+void
+configure(D2CfgMgrPtr& cfg_mgr, const uint16_t port, const bool tcp) {
+    ostringstream config;
+    config << "{ \"interface\" : \"lo\" , "
+           << "\"ip_address\" : \"127.0.0.1\" , "
+           << "\"port\" : 53001 , "
+           << "\"tsig_keys\": [] , "
+           << "\"forward_ddns\" : { \"ddns_domains\": [ "
+           << "{ \"name\": \"example.com.\" , "
+           << "  \"dns_servers\" : [ "
+           << "  { \"ip_address\": \"127.0.0.1\", \"port\" : " << port
+           << "  , \"protocol\" : \"" << (tcp ? "TCP" : "UDP") << "\""
+           << "  } ] } ] }, "
+           << "\"reverse_ddns\" : { \"ddns_domains\": [ ] } }";
+    int rcode = 0;
+    config::parseAnswer(rcode, cfg_mgr->parseConfig(
+                            data::Element::fromJSON(config.str())));
+    if (rcode != 0) {
+        isc_throw(Unexpected, "unable to configure the update manager");
+    }
+}
+
+// Makes the request for the client index % clients.  When there are more
+// requests than clients, the later requests alternately remove and add
+// the names of the clients, so as the benchmark exercises the coalescing
+// of the queued requests and the ordering of the updates for the same name.
+dhcp_ddns::NameChangeRequestPtr
+makeRequest(const unsigned int index, const unsigned int clients) {
+    const unsigned int client = index % clients;
+    ostringstream fqdn;
+    fqdn << "client" << client << ".example.com.";
+    ostringstream dhcid;
+    dhcid << hex << setfill('0') << setw(8) << client;
+    dhcp_ddns::NameChangeRequestPtr ncr(new dhcp_ddns::NameChangeRequest(
+        (index / clients) % 2 == 0 ? dhcp_ddns::CHG_ADD :
+                                     dhcp_ddns::CHG_REMOVE,
+        true, false, fqdn.str(), "192.0.2.1",
+        dhcp_ddns::D2Dhcid(dhcid.str()), 0, 3600));
+    return (ncr);
+}
+
+double
+elapsed(const struct timeval& start, const struct timeval& end) {
+    return ((end.tv_sec - start.tv_sec) +
+            (end.tv_usec - start.tv_usec) / 1000000.0);
+}
+
+void
+usage() {
+    cerr << "Usage: update_mgr_bench [-n requests] [-c clients] "
+         << "[-m max_transactions] [-d delay_ms] [-p port] [-t]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    unsigned int requests = 10000;
+    unsigned int clients = 5000;
+    unsigned int max_transactions = D2UpdateMgr::MAX_TRANSACTIONS_DEFAULT;
+    unsigned int delay_ms = 5;
+    uint16_t port = 53053;
+    bool tcp = false;
+    while ((ch = getopt(argc, argv, "n:c:m:d:p:t")) != -1) {
+        switch (ch) {
+        case 'n':
+            requests = atoi(optarg);
+            break;
+        case 'c':
+            clients = atoi(optarg);
+            break;
+        case 'm':
+            max_transactions = atoi(optarg);
+            break;
+        case 'd':
+            delay_ms = atoi(optarg);
+            break;
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case 't':
+            tcp = true;
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if ((argc != 0) || (requests == 0) || (clients == 0) ||
+        (max_transactions == 0)) {
+        usage();
+    }
+
+    // Each update is logged at the informational level, which would
+    // dominate the results.
+    log::initLogger("update_mgr_bench", log::WARN);
+
+    cout << "Parameters:" << endl;
+    cout << "  Requests: " << requests << endl;
+    cout << "  Clients: " << clients << endl;
+    cout << "  Max transactions: " << max_transactions << endl;
+    cout << "  Server delay: " << delay_ms << "ms" << endl;
+    cout << "  Protocol: " << (tcp ? "TCP" : "UDP") << endl;
+
+    IOServicePtr io_service(new asiolink::IOService());
+    D2CfgMgrPtr cfg_mgr(new D2CfgMgr());
+    configure(cfg_mgr, port, tcp);
+    D2QueueMgrPtr queue_mgr(new D2QueueMgr(io_service, requests));
+    D2UpdateMgr update_mgr(queue_mgr, cfg_mgr, io_service, max_transactions);
+    DelayedServer server(*io_service, asiolink::IOAddress("127.0.0.1"),
+                         port, delay_ms, tcp);
+
+    std::vector<dhcp_ddns::NameChangeRequestPtr> ncrs;
+    for (unsigned int i = 0; i < requests; ++i) {
+        ncrs.push_back(makeRequest(i, clients));
+        queue_mgr->enqueue(ncrs.back());
+    }
+
+    // Run the update manager as D2Process does: sweep, then run the ready
+    // handlers or wait for one.  The last sweep removes the finished
+    // transactions.
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    asio::io_service& asio_io_service = io_service->get_io_service();
+    for (;;) {
+        update_mgr.sweep();
+        if ((update_mgr.getQueueCount() == 0) &&
+            (update_mgr.getTransactionCount() == 0)) {
+            break;
+        }
+        if (asio_io_service.poll() == 0) {
+            asio_io_service.run_one();
+        }
+    }
+    gettimeofday(&end, NULL);
+
+    const D2UpdateMgr::Stats& stats = update_mgr.getStats();
+    const double duration = elapsed(start, end);
+    cout << "Results:" << endl;
+    cout << "  Elapsed: " << fixed << setprecision(3) << duration << "s"
+         << endl;
+    cout << "  Throughput: " << setprecision(1) << requests / duration
+         << " requests/s" << endl;
+    cout << "  Updates received by the server: " << server.getReceived()
+         << endl;
+    cout << "  Coalesced: " << queue_mgr->getCoalescedCount() << endl;
+    cout << "  Completed: " << stats.completed_ << endl;
+    cout << "  Failed: " << stats.failed_ << endl;
+    cout << "  Timeouts: " << stats.timeouts_ << endl;
+    cout << "  Deferred (same client in progress): " << stats.deferred_
+         << endl;
+    cout << "  Sweeps at the concurrency limit: " << stats.limit_reached_
+         << endl;
+    cout << "  Max concurrent transactions: "
+         << stats.max_transaction_count_ << endl;
+    cout << "  Final concurrency limit: " << update_mgr.getConcurrencyLimit()
+         << endl;
+
+    return (0);
+}
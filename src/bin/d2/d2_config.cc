@@ -44,9 +44,9 @@ const char* DnsServerInfo::EMPTY_IP_STR = "0.0.0.0";
 
 DnsServerInfo::DnsServerInfo(const std::string& hostname,
                              isc::asiolink::IOAddress ip_address, uint32_t port,
-                             bool enabled)
+                             bool enabled, DNSClient::Protocol protocol)
     :hostname_(hostname), ip_address_(ip_address), port_(port),
-    enabled_(enabled) {
+    enabled_(enabled), protocol_(protocol) {
 }
 
 DnsServerInfo::~DnsServerInfo() {
@@ -56,6 +56,9 @@ std::string
 DnsServerInfo::toText() const {
     std::ostringstream stream;
     stream << (getIpAddress().toText()) << " port:" << getPort();
+    if (getProtocol() == DNSClient::TCP) {
+        stream << " protocol:TCP";
+    }
     return (stream.str());
 }
 
@@ -351,7 +354,8 @@ DnsServerInfoParser::createConfigParser(const std::string& config_id) {
     // Based on the configuration id of the element, create the appropriate
     // parser. Scalars are set to use the parser's local scalar storage.
     if ((config_id == "hostname")  ||
-        (config_id == "ip_address")) {
+        (config_id == "ip_address") ||
+        (config_id == "protocol")) {
         parser = new isc::dhcp::StringParser(config_id,
                                              local_scalars_.getStringStorage());
     } else if (config_id == "port") {
@@ -379,6 +383,9 @@ DnsServerInfoParser::commit() {
     local_scalars_.getParam("ip_address", ip_address,
                             DCfgContextBase::OPTIONAL);
     local_scalars_.getParam("port", port, DCfgContextBase::OPTIONAL);
+    std::string protocol_str = "UDP";
+    local_scalars_.getParam("protocol", protocol_str,
+                            DCfgContextBase::OPTIONAL);
 
     // The configuration must specify one or the other.
     if (hostname.empty() == ip_address.empty()) {
@@ -386,18 +393,28 @@ DnsServerInfoParser::commit() {
                   " of hostname and IP address");
     }
 
+    DNSClient::Protocol protocol = DNSClient::UDP;
+    if (protocol_str == "TCP") {
+        protocol = DNSClient::TCP;
+    } else if (protocol_str != "UDP") {
+        isc_throw(D2CfgError, "Dns Server protocol must be UDP or TCP: "
+                  << protocol_str);
+    }
+
     DnsServerInfoPtr serverInfo;
     if (!hostname.empty()) {
         // When  hostname is specified, create a valid, blank IOAddress and
         // then create the DnsServerInfo.
         isc::asiolink::IOAddress io_addr(DnsServerInfo::EMPTY_IP_STR);
-        serverInfo.reset(new DnsServerInfo(hostname, io_addr, port));
+        serverInfo.reset(new DnsServerInfo(hostname, io_addr, port,
+                                           true, protocol));
     } else {
         try {
             // Create an IOAddress from the IP address string given and then
             // create the DnsServerInfo.
             isc::asiolink::IOAddress io_addr(ip_address);
-            serverInfo.reset(new DnsServerInfo(hostname, io_addr, port));
+            serverInfo.reset(new DnsServerInfo(hostname, io_addr, port,
+                                               true, protocol));
         } catch (const isc::asiolink::IOError& ex) {
             isc_throw(D2CfgError, "Invalid IP address:" << ip_address);
         }
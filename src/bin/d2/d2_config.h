@@ -18,6 +18,7 @@
 #include <cc/data.h>
 #include <d2/d2_asio.h>
 #include <d2/d_cfg_mgr.h>
+#include <d2/dns_client.h>
 #include <dhcpsrv/dhcp_parsers.h>
 #include <exceptions/exceptions.h>
 
@@ -242,10 +243,13 @@ public:
     /// the default.)
     /// @param enabled is a flag that indicates whether this server is
     /// enabled for use. It defaults to true.
+    /// @param protocol is the transport protocol used to send the DNS
+    /// updates to the server. It defaults to UDP.
     DnsServerInfo(const std::string& hostname,
                   isc::asiolink::IOAddress ip_address,
                   uint32_t port = STANDARD_DNS_PORT,
-                  bool enabled=true);
+                  bool enabled=true,
+                  DNSClient::Protocol protocol = DNSClient::UDP);
 
     /// @brief Destructor
     virtual ~DnsServerInfo();
@@ -271,6 +275,13 @@ public:
         return (ip_address_);
     }
 
+    /// @brief Getter which returns the server's transport protocol.
+    ///
+    /// @return returns the protocol used to send the DNS updates.
+    DNSClient::Protocol getProtocol() const {
+        return (protocol_);
+    }
+
     /// @brief Convenience method which returns whether or not the
     /// server is enabled.
     ///
@@ -308,6 +319,9 @@ private:
     /// @param enabled is a flag that indicates whether this server is
     /// enabled for use. It defaults to true.
     bool enabled_;
+
+    /// @brief The transport protocol used to send the DNS updates.
+    DNSClient::Protocol protocol_;
 };
 
 std::ostream&
@@ -15,6 +15,9 @@
 #include <d2/d2_log.h>
 #include <d2/d2_queue_mgr.h>
 #include <dhcp_ddns/ncr_udp.h>
+#include <util/strutil.h>
+
+#include <iterator>
 
 namespace isc {
 namespace d2 {
@@ -24,7 +27,8 @@ const size_t D2QueueMgr::MAX_QUEUE_DEFAULT;
 
 D2QueueMgr::D2QueueMgr(IOServicePtr& io_service, const size_t max_queue_size)
     : io_service_(io_service), max_queue_size_(max_queue_size),
-      mgr_state_(NOT_INITTED), target_stop_state_(NOT_INITTED) {
+      coalesced_count_(0), mgr_state_(NOT_INITTED),
+      target_stop_state_(NOT_INITTED) {
     if (!io_service_) {
         isc_throw(D2QueueMgrError, "IOServicePtr cannot be null");
     }
@@ -208,7 +212,9 @@ D2QueueMgr::peekAt(const size_t index) const {
                   << " index: " << index << " queue size: " << getQueueSize());
     }
 
-    return (ncr_queue_.at(index));
+    RequestQueue::const_iterator pos = ncr_queue_.begin();
+    std::advance(pos, index);
+    return (*pos);
 }
 
 void
@@ -219,10 +225,17 @@ D2QueueMgr::dequeueAt(const size_t index) {
                   << " index: " << index << " queue size: " << getQueueSize());
     }
 
-    RequestQueue::iterator pos = ncr_queue_.begin() + index;
+    RequestQueue::iterator pos = ncr_queue_.begin();
+    std::advance(pos, index);
+    removeFromIndex(pos);
     ncr_queue_.erase(pos);
 }
 
+RequestQueue::iterator
+D2QueueMgr::dequeueAt(const RequestQueue::iterator& pos) {
+    removeFromIndex(pos);
+    return (ncr_queue_.erase(pos));
+}
 
 void
 D2QueueMgr::dequeue() {
@@ -231,17 +244,60 @@ D2QueueMgr::dequeue() {
                   "D2QueueMgr dequeue attempted on an empty queue");
     }
 
+    removeFromIndex(ncr_queue_.begin());
     ncr_queue_.pop_front();
 }
 
 void
 D2QueueMgr::enqueue(dhcp_ddns::NameChangeRequestPtr& ncr) {
+    const std::string key = getIndexKey(*ncr);
+    RequestIndex::iterator found = ncr_index_.find(key);
+    if (found != ncr_index_.end()) {
+        // The request supersedes the queued one if it updates the same
+        // directions, or more.
+        const dhcp_ddns::NameChangeRequestPtr& queued = *found->second;
+        if ((ncr->isForwardChange() || !queued->isForwardChange()) &&
+            (ncr->isReverseChange() || !queued->isReverseChange())) {
+            ncr_queue_.erase(found->second);
+            ++coalesced_count_;
+            LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA,
+                      DHCP_DDNS_QUEUE_MGR_REQUEST_COALESCED)
+                      .arg(ncr->getFqdn()).arg(ncr->getIpAddress())
+                      .arg(coalesced_count_);
+        }
+    }
+
     ncr_queue_.push_back(ncr);
+    RequestQueue::iterator pos = ncr_queue_.end();
+    --pos;
+    if (found != ncr_index_.end()) {
+        found->second = pos;
+    } else {
+        ncr_index_.insert(RequestIndex::value_type(key, pos));
+    }
 }
 
 void
 D2QueueMgr::clearQueue() {
     ncr_queue_.clear();
+    ncr_index_.clear();
+}
+
+std::string
+D2QueueMgr::getIndexKey(const dhcp_ddns::NameChangeRequest& ncr) {
+    // DNS names are case insensitive.
+    std::string key = ncr.getFqdn();
+    util::str::lowercase(key);
+    key += "/" + ncr.getDhcid().toStr() + "/" + ncr.getIpAddress();
+    return (key);
+}
+
+void
+D2QueueMgr::removeFromIndex(const RequestQueue::iterator& pos) {
+    RequestIndex::iterator found = ncr_index_.find(getIndexKey(**pos));
+    if ((found != ncr_index_.end()) && (found->second == pos)) {
+        ncr_index_.erase(found);
+    }
 }
 
 void
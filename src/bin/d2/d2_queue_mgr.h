@@ -23,14 +23,16 @@
 #include <dhcp_ddns/ncr_io.h>
 
 #include <boost/noncopyable.hpp>
-#include <deque>
+#include <list>
+#include <map>
+#include <string>
 
 namespace isc {
 namespace d2 {
 
 /// @brief Defines a queue of requests.
 /// @todo This may be replaced with an actual class in the future.
-typedef std::deque<dhcp_ddns::NameChangeRequestPtr> RequestQueue;
+typedef std::list<dhcp_ddns::NameChangeRequestPtr> RequestQueue;
 
 /// @brief Thrown if the queue manager encounters a general error.
 class D2QueueMgrError : public isc::Exception {
@@ -86,6 +88,18 @@ public:
 /// through this operator() that D2QueueMgr is passed inbound NCRs. D2QueueMgr
 /// will add each newly received request onto the back of the request queue
 ///
+/// Clients which renew their leases or flap generate chains of requests for
+/// the same FQDN, DHCID and IP address.  Only the last of them determines
+/// the outcome of the DNS updates, so D2QueueMgr coalesces them: when a
+/// request is queued, a queued request it supersedes is removed from the
+/// queue.  A request supersedes a queued one with the same FQDN (regardless
+/// of the case), DHCID and IP address, if it updates at least the same
+/// directions (forward and/or reverse).  The new request is added to the back
+/// of the queue, so as the order of the updates of the same FQDN or DHCID is
+/// preserved.  The queued requests are indexed by these attributes, so as
+/// coalescing doesn't require scanning the queue.  The number of requests
+/// removed this way is returned by getCoalescedCount().
+///
 /// D2QueueMgr defines a simple state model constructed around the status of
 /// its NameChangeListener, consisting of the following states:
 ///
@@ -285,9 +299,23 @@ public:
     /// @throw D2QueueMgrQueEmpty if there are no entries in the queue.
     const dhcp_ddns::NameChangeRequestPtr& peek() const;
 
+    /// @brief Returns the position of the front of the queue.
+    ///
+    /// The positions stay valid until the entries they refer to are
+    /// removed.
+    RequestQueue::iterator queueBegin() {
+        return (ncr_queue_.begin());
+    }
+
+    /// @brief Returns the position past the end of the queue.
+    RequestQueue::iterator queueEnd() {
+        return (ncr_queue_.end());
+    }
+
     /// @brief Returns the entry at a given position in the queue.
     ///
-    /// Note that the entry is not removed from the queue.
+    /// Note that the entry is not removed from the queue.  The time it
+    /// takes grows with the index.
     /// @param index the index of the entry in the queue to fetch.
     /// Valid values are 0 (front of the queue) to (queue size - 1).
     ///
@@ -299,6 +327,8 @@ public:
 
     /// @brief Removes the entry at a given position in the queue.
     ///
+    /// The time it takes grows with the index.
+    ///
     /// @param index the index of the entry in the queue to remove.
     /// Valid values are 0 (front of the queue) to (queue size - 1).
     ///
@@ -306,6 +336,18 @@ public:
     /// end of the queue.
     void dequeueAt(const size_t index);
 
+    /// @brief Removes the entry at a given position in the queue.
+    ///
+    /// Unlike the index based variant, this takes the same time whatever
+    /// the position, so as the queue can be walked from @c queueBegin
+    /// and the entries removed on the way.
+    ///
+    /// @param pos position of the entry to remove.  It must refer to an
+    /// entry of the queue.
+    ///
+    /// @return Position of the entry which followed the removed one.
+    RequestQueue::iterator dequeueAt(const RequestQueue::iterator& pos);
+
     /// @brief Removes the entry at the front of the queue.
     ///
     /// @throw D2QueueMgrQueEmpty if there are no entries in the queue.
@@ -313,13 +355,44 @@ public:
 
     /// @brief Adds a request to the end of the queue.
     ///
+    /// If a queued request is superseded by the given one, it is removed
+    /// from the queue.  It is found through the index of the queued
+    /// requests, so this takes the same time whatever the queue size.
+    ///
     /// @param ncr pointer to the NameChangeRequest to add to the queue.
     void enqueue(dhcp_ddns::NameChangeRequestPtr& ncr);
 
     /// @brief Removes all entries from the queue.
     void clearQueue();
 
+    /// @brief Returns the number of queued requests which were removed
+    /// because newer requests superseded them.
+    uint64_t getCoalescedCount() const {
+        return (coalesced_count_);
+    }
+
   private:
+    /// @brief Defines the index of the queued requests.
+    ///
+    /// The key is made of the FQDN in lower case, the DHCID and the IP
+    /// address of the request, the value is the position in the queue of
+    /// the last queued request with these attributes.  The positions stay
+    /// valid when other requests are added or removed.
+    typedef std::map<std::string, RequestQueue::iterator> RequestIndex;
+
+    /// @brief Returns the key of the request in the index.
+    ///
+    /// @param ncr the request.
+    static std::string getIndexKey(const dhcp_ddns::NameChangeRequest& ncr);
+
+    /// @brief Removes the request from the index.
+    ///
+    /// It has no effect if the index refers to another request with the
+    /// same key.
+    ///
+    /// @param pos position of the request which is removed from the queue.
+    void removeFromIndex(const RequestQueue::iterator& pos);
+
     /// @brief Sets the manager state to the target stop state.
     ///
     /// Convenience method which sets the manager state to the target stop
@@ -335,6 +408,12 @@ public:
     /// @brief Queue of received NameChangeRequests.
     RequestQueue ncr_queue_;
 
+    /// @brief Index of the queued requests.
+    RequestIndex ncr_index_;
+
+    /// @brief Number of the requests superseded by newer requests.
+    uint64_t coalesced_count_;
+
     /// @brief Listener instance from which requests are received.
     boost::shared_ptr<dhcp_ddns::NameChangeListener> listener_;
 
@@ -15,6 +15,7 @@
 #include <d2/d2_update_mgr.h>
 #include <d2/nc_add.h>
 #include <d2/nc_remove.h>
+#include <util/strutil.h>
 
 #include <sstream>
 #include <iostream>
@@ -24,11 +25,19 @@ namespace isc {
 namespace d2 {
 
 const size_t D2UpdateMgr::MAX_TRANSACTIONS_DEFAULT;
+const size_t D2UpdateMgr::INITIAL_CONCURRENCY_LIMIT;
+
+D2UpdateMgr::Stats::Stats()
+    : started_(0), completed_(0), failed_(0), timeouts_(0), deferred_(0),
+      limit_reached_(0), max_transaction_count_(0), max_queue_count_(0) {
+}
 
 D2UpdateMgr::D2UpdateMgr(D2QueueMgrPtr& queue_mgr, D2CfgMgrPtr& cfg_mgr,
                          IOServicePtr& io_service,
                          const size_t max_transactions)
-    :queue_mgr_(queue_mgr), cfg_mgr_(cfg_mgr), io_service_(io_service) {
+    :queue_mgr_(queue_mgr), cfg_mgr_(cfg_mgr), io_service_(io_service),
+     concurrency_limit_(INITIAL_CONCURRENCY_LIMIT),
+     completed_since_change_(0) {
     if (!queue_mgr_) {
         isc_throw(D2UpdateMgrError, "D2UpdateMgr queue manager cannot be null");
     }
@@ -47,30 +56,30 @@ D2UpdateMgr::D2UpdateMgr(D2QueueMgrPtr& queue_mgr, D2CfgMgrPtr& cfg_mgr,
 }
 
 D2UpdateMgr::~D2UpdateMgr() {
-    transaction_list_.clear();
+    clearTransactionList();
 }
 
 void D2UpdateMgr::sweep() {
     // cleanup finished transactions;
     checkFinishedTransactions();
 
-    // if the queue isn't empty, find the next suitable job and
-    // start a transaction for it.
-    // @todo - Do we want to queue max transactions? The logic here will only
-    // start one new transaction per invocation.  On the other hand a busy
-    // system will generate many IO events and this method will be called
-    // frequently.  It will likely achieve max transactions quickly on its own.
+    // if the queue isn't empty, start transactions for all the eligible
+    // jobs the concurrency limit allows for.
     if (getQueueCount() > 0)  {
-        if (getTransactionCount() >= max_transactions_) {
+        stats_.max_queue_count_ = std::max(stats_.max_queue_count_,
+                                           getQueueCount());
+        pickJobs(getQueueCount());
+
+        // The requests left in the queue are either waiting for the
+        // updates of the same clients or for a free transaction slot. The
+        // latter means the DNS servers don't keep up with the requests.
+        if ((getQueueCount() > 0) &&
+            (getTransactionCount() >= getConcurrencyLimit())) {
+            ++stats_.limit_reached_;
             LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA,
                       DHCP_DDNS_AT_MAX_TRANSACTIONS).arg(getQueueCount())
-                      .arg(getMaxTransactions());
-
-            return;
+                      .arg(getConcurrencyLimit());
         }
-
-        // We are not at maximum transactions, so pick and start the next job.
-        pickNextJob();
     }
 }
 
@@ -84,40 +93,92 @@ D2UpdateMgr::checkFinishedTransactions() {
     // to erase.  This replaces the old iterator which becomes invalid by the
     // erase with a the next valid iterator.  Prefix incrementing will not
     // work.
+    bool timed_out = false;
     TransactionList::iterator it = transaction_list_.begin();
     while (it != transaction_list_.end()) {
         NameChangeTransactionPtr trans = (*it).second;
         if (trans->isModelDone()) {
-            // @todo  Addtional actions based on NCR status could be
-            // performed here.
-            transaction_list_.erase(it++);
+            // A full window of successful transactions allows for one more
+            // concurrent transaction, while the transactions failing on
+            // timeouts indicate that the servers are overloaded.
+            if (trans->getNcrStatus() == dhcp_ddns::ST_COMPLETED) {
+                ++stats_.completed_;
+                if (++completed_since_change_ >= getConcurrencyLimit()) {
+                    completed_since_change_ = 0;
+                    if (getConcurrencyLimit() < max_transactions_) {
+                        concurrency_limit_ = getConcurrencyLimit() + 1;
+                    }
+                }
+            } else {
+                ++stats_.failed_;
+                if (trans->getDnsUpdateStatus() == DNSClient::TIMEOUT) {
+                    ++stats_.timeouts_;
+                    timed_out = true;
+                }
+            }
+            removeTransaction(it++);
         } else {
             ++it;
         }
     }
+
+    if (timed_out && (getConcurrencyLimit() > 1)) {
+        concurrency_limit_ = getConcurrencyLimit() / 2;
+        completed_since_change_ = 0;
+        LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA,
+                  DHCP_DDNS_CONCURRENCY_LIMIT_DECREASED)
+                  .arg(concurrency_limit_);
+    }
 }
 
 void D2UpdateMgr::pickNextJob() {
-    // Start at the front of the queue, looking for the first entry for
-    // which no transaction is in progress.  If we find an eligible entry
-    // remove it from the queue and  make a transaction for it.
-    // Requests and transactions are associated by DHCID.  If a request has
-    // the same DHCID as a transaction, they are presumed to be for the same
-    // "end user".
-    size_t queue_count = getQueueCount();
-    for (size_t index = 0; index < queue_count; ++index) {
-        dhcp_ddns::NameChangeRequestPtr found_ncr = queue_mgr_->peekAt(index);
-        if (!hasTransaction(found_ncr->getDhcid())) {
-            queue_mgr_->dequeueAt(index);
-            makeTransaction(found_ncr);
-            return;
+    pickJobs(1);
+}
+
+size_t
+D2UpdateMgr::pickJobs(const size_t max_jobs) {
+    // Start at the front of the queue, looking for the entries for which
+    // no transaction is in progress.  If we find an eligible entry remove
+    // it from the queue and  make a transaction for it.
+    // Requests and transactions are associated by DHCID and by FQDN.  If a
+    // request has the same DHCID or FQDN as a transaction, they are presumed
+    // to be for the same "end user".  The entries passed over block the
+    // later entries for the same DHCID or FQDN, so as the updates are done
+    // in the order in which they were requested.
+    std::set<TransactionKey> blocked_dhcids;
+    std::set<std::string> blocked_fqdns;
+    size_t picked = 0;
+    RequestQueue::iterator pos = queue_mgr_->queueBegin();
+    while ((picked < max_jobs) && (pos != queue_mgr_->queueEnd()) &&
+           (getTransactionCount() < getConcurrencyLimit())) {
+        dhcp_ddns::NameChangeRequestPtr found_ncr = *pos;
+        const TransactionKey& dhcid = found_ncr->getDhcid();
+        const std::string fqdn = getFqdnKey(*found_ncr);
+        if (hasTransaction(dhcid) || (fqdn_list_.count(fqdn) > 0) ||
+            (blocked_dhcids.count(dhcid) > 0) ||
+            (blocked_fqdns.count(fqdn) > 0)) {
+            blocked_dhcids.insert(dhcid);
+            blocked_fqdns.insert(fqdn);
+            ++stats_.deferred_;
+            ++pos;
+            continue;
         }
+
+        pos = queue_mgr_->dequeueAt(pos);
+        makeTransaction(found_ncr);
+        ++picked;
     }
 
-    // There were no eligible jobs. All of the current DHCIDs already have
-    // transactions pending.
-    LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA, DHCP_DDNS_NO_ELIGIBLE_JOBS)
-              .arg(getQueueCount()).arg(getTransactionCount());
+    if ((picked == 0) && (getQueueCount() > 0) &&
+        (getTransactionCount() < getConcurrencyLimit())) {
+        // There were no eligible jobs. All of the current DHCIDs and FQDNs
+        // already have transactions pending.
+        LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA,
+                  DHCP_DDNS_NO_ELIGIBLE_JOBS)
+                  .arg(getQueueCount()).arg(getTransactionCount());
+    }
+
+    return (picked);
 }
 
 void
@@ -131,6 +192,10 @@ D2UpdateMgr::makeTransaction(dhcp_ddns::NameChangeRequestPtr& next_ncr) {
         isc_throw(D2UpdateMgrError, "Transaction already in progress for: "
             << key.toStr());
     }
+    if (hasFqdnTransaction(next_ncr->getFqdn())) {
+        isc_throw(D2UpdateMgrError, "Transaction already in progress for: "
+            << next_ncr->getFqdn());
+    }
 
     int direction_count = 0;
     // If forward change is enabled, match to forward servers.
@@ -203,6 +268,10 @@ D2UpdateMgr::makeTransaction(dhcp_ddns::NameChangeRequestPtr& next_ncr) {
 
     // Add the new transaction to the list.
     transaction_list_[key] = trans;
+    fqdn_list_.insert(getFqdnKey(*next_ncr));
+    ++stats_.started_;
+    stats_.max_transaction_count_ = std::max(stats_.max_transaction_count_,
+                                             getTransactionCount());
 
     // Start it.
     trans->startTransaction();
@@ -218,14 +287,35 @@ D2UpdateMgr::hasTransaction(const TransactionKey& key) {
    return (findTransaction(key) != transactionListEnd());
 }
 
+bool
+D2UpdateMgr::hasFqdnTransaction(const std::string& fqdn) const {
+    std::string key(fqdn);
+    util::str::lowercase(key);
+    return (fqdn_list_.count(key) > 0);
+}
+
+std::string
+D2UpdateMgr::getFqdnKey(const dhcp_ddns::NameChangeRequest& ncr) {
+    // DNS names are case insensitive.
+    std::string key(ncr.getFqdn());
+    util::str::lowercase(key);
+    return (key);
+}
+
 void
 D2UpdateMgr::removeTransaction(const TransactionKey& key) {
     TransactionList::iterator pos = findTransaction(key);
     if (pos != transactionListEnd()) {
-        transaction_list_.erase(pos);
+        removeTransaction(pos);
     }
 }
 
+void
+D2UpdateMgr::removeTransaction(TransactionList::iterator pos) {
+    fqdn_list_.erase(getFqdnKey(*(pos->second->getNcr())));
+    transaction_list_.erase(pos);
+}
+
 TransactionList::iterator
 D2UpdateMgr::transactionListBegin() {
     return (transaction_list_.begin());
@@ -241,6 +331,7 @@ D2UpdateMgr::clearTransactionList() {
     // @todo for now this just wipes them out. We might need something
     // more elegant, that allows a cancel first.
     transaction_list_.clear();
+    fqdn_list_.clear();
 }
 
 void
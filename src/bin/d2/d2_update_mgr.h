@@ -26,7 +26,10 @@
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include <algorithm>
 #include <map>
+#include <set>
+#include <string>
 
 namespace isc {
 namespace d2 {
@@ -70,23 +73,57 @@ typedef std::map<TransactionKey, NameChangeTransactionPtr> TransactionList;
 /// The upper layer(s) are responsible for calling sweep in a timely and cyclic
 /// manner.
 ///
+/// Many transactions run concurrently, while the updates for a given client
+/// are carried out in the order in which the requests were received: a
+/// request is not started while an update for the same DHCID or the same FQDN
+/// is in progress, or while an earlier request for the same DHCID or FQDN is
+/// still queued.
+///
+/// The number of concurrent transactions is adapted to the responsiveness of
+/// the DNS servers.  It starts at INITIAL_CONCURRENCY_LIMIT.  It is raised by
+/// one each time as many transactions as the limit completed successfully,
+/// i.e. roughly once per round trip, up to the maximum number of
+/// transactions, and it is halved when transactions fail because a DNS
+/// server did not respond in time.  The counters describing the load
+/// of the update manager (see Stats) allow for monitoring the backpressure
+/// on the request queue.
 class D2UpdateMgr : public boost::noncopyable {
 public:
     /// @brief Maximum number of concurrent transactions
+    /// The actual number of concurrent transactions is limited by the
+    /// concurrency limit, which is adapted to the DNS servers.
+    static const size_t MAX_TRANSACTIONS_DEFAULT = 1024;
+
+    /// @brief Initial limit of concurrent transactions.
     /// NOTE that 32 is an arbitrary choice picked for the initial
     /// implementation.
-    static const size_t MAX_TRANSACTIONS_DEFAULT = 32;
+    static const size_t INITIAL_CONCURRENCY_LIMIT = 32;
 
-    // @todo This structure is not yet used. It is here in anticipation of
-    // enabled statistics capture.
+    /// @brief Counters describing the load of the update manager.
     struct Stats {
-        uint64_t start_time_;
-        uint64_t stop_time_;
-        uint64_t update_count_;
-        uint64_t min_update_time_;
-        uint64_t max_update_time_;
-        uint64_t server_rejects_;
-        uint64_t server_timeouts_;
+        /// @brief Constructor, zeroes all counters.
+        Stats();
+
+        /// @brief Number of transactions started.
+        uint64_t started_;
+        /// @brief Number of transactions which completed successfully.
+        uint64_t completed_;
+        /// @brief Number of transactions which failed.
+        uint64_t failed_;
+        /// @brief Number of failed transactions for which the last DNS
+        /// server did not respond in time.
+        uint64_t timeouts_;
+        /// @brief Number of times a queued request was passed over because
+        /// an update for the same DHCID or FQDN was in progress or queued
+        /// before it.
+        uint64_t deferred_;
+        /// @brief Number of sweeps which left requests in the queue because
+        /// the concurrency limit was reached.
+        uint64_t limit_reached_;
+        /// @brief Highest number of concurrent transactions.
+        size_t max_transaction_count_;
+        /// @brief Highest number of queued requests seen by sweep.
+        size_t max_queue_count_;
     };
 
     /// @brief Constructor
@@ -112,30 +149,32 @@ public:
     /// should be called as IO events complete.  During each invocation it does
     /// the following:
     ///
-    /// - Removes all completed transactions from the transaction list.
+    /// - Removes all completed transactions from the transaction list and
+    /// adapts the concurrency limit to their outcome.
     ///
-    /// - If the request queue is not empty and the number of transactions
-    /// in the transaction list has not reached maximum allowed, then select
-    /// a request from the queue.
-    ///
-    /// - If a request was selected, start a new transaction for it and
-    /// add the transaction to the list of transactions.
+    /// - While the request queue is not empty and the number of transactions
+    /// in the transaction list has not reached the concurrency limit, selects
+    /// the eligible requests from the queue, starts a new transaction for
+    /// each of them and adds it to the list of transactions.
     void sweep();
 
 protected:
     /// @brief Performs post-completion cleanup on completed transactions.
     ///
     /// Iterates through the list of transactions and removes any that have
-    /// reached completion.  This method may expand in complexity or even
-    /// disappear altogether as the implementation matures.
+    /// reached completion.  The concurrency limit is raised by one when as
+    /// many transactions as the limit have completed successfully since it
+    /// last changed, and it is halved, once for all the finished
+    /// transactions, if any of them failed after a DNS server did not
+    /// respond in time.
     void checkFinishedTransactions();
 
     /// @brief Starts a transaction for the next eligible request in the queue.
     ///
     /// This method will scan the request queue for the next request to
-    /// dequeue.  The current implementation starts at the front of the queue
-    /// and looks for the first request for whose DHCID there is no current
-    /// transaction in progress.
+    /// dequeue.  It starts at the front of the queue and looks for the first
+    /// request for whose DHCID and FQDN there is no current transaction in
+    /// progress and no earlier request in the queue.
     ///
     /// If a request is selected, it is removed from the queue and transaction
     /// is constructed for it.
@@ -145,6 +184,19 @@ protected:
     /// clients in quick succession.
     void pickNextJob();
 
+    /// @brief Starts transactions for the eligible requests in the queue.
+    ///
+    /// This method scans the request queue once, from the front, and starts
+    /// a transaction for each request for whose DHCID and FQDN there is no
+    /// current transaction in progress and no earlier request in the queue,
+    /// until the given number of requests have been dequeued.
+    ///
+    /// @param max_jobs maximum number of requests to dequeue.
+    ///
+    /// @return number of requests dequeued.  Note that a request which
+    /// doesn't match any DNS servers is dequeued and discarded.
+    size_t pickJobs(const size_t max_jobs);
+
     /// @brief Create a new transaction for the given request.
     ///
     /// This method will attempt to match the request to suitable DNS servers.
@@ -165,10 +217,17 @@ protected:
     ///
     /// @param ncr the NameChangeRequest for which to create a transaction.
     ///
-    /// @throw D2UpdateMgrError if a transaction for this DHCID already
-    /// exists. Note this would be programmatic error.
+    /// @throw D2UpdateMgrError if a transaction for this DHCID or this FQDN
+    /// already exists. Note this would be programmatic error.
     void makeTransaction(isc::dhcp_ddns::NameChangeRequestPtr& ncr);
 
+    /// @brief Returns the key used to order the updates of the FQDN.
+    ///
+    /// @param ncr the NameChangeRequest.
+    ///
+    /// @return the FQDN of the request in lower case.
+    static std::string getFqdnKey(const dhcp_ddns::NameChangeRequest& ncr);
+
 public:
     /// @brief Gets the D2UpdateMgr's IOService.
     ///
@@ -182,6 +241,19 @@ public:
         return (max_transactions_);
     }
 
+    /// @brief Returns the current limit of concurrent transactions.
+    ///
+    /// It is adapted to the outcome of the transactions and never exceeds
+    /// the maximum number of transactions.
+    size_t getConcurrencyLimit() const {
+        return (std::min(concurrency_limit_, max_transactions_));
+    }
+
+    /// @brief Returns the counters describing the load of the manager.
+    const Stats& getStats() const {
+        return (stats_);
+    }
+
     /// @brief Sets the maximum number of entries allowed in the queue.
     ///
     /// @param max_transactions is the new maximum number of transactions
@@ -213,6 +285,15 @@ public:
     /// otherwise.
     bool hasTransaction(const TransactionKey& key);
 
+    /// @brief Checks if a transaction is in progress for the given FQDN.
+    ///
+    /// @param fqdn the FQDN for which to search.  The comparison is case
+    /// insensitive.
+    ///
+    /// @return Returns true if a transaction updates the FQDN, false
+    /// otherwise.
+    bool hasFqdnTransaction(const std::string& fqdn) const;
+
     /// @brief Removes the entry pointed to by key from the transaction list.
     ///
     /// Removes the entry referred to by key if it exists.  It has no effect
@@ -221,6 +302,11 @@ public:
     /// @param key of the transaction to remove
     void removeTransaction(const TransactionKey& key);
 
+    /// @brief Removes the entry pointed to by the iterator.
+    ///
+    /// @param pos position of the transaction to remove.  It is invalidated.
+    void removeTransaction(TransactionList::iterator pos);
+
     /// @brief Immediately discards all entries in the transaction list.
     ///
     /// @todo For now this just wipes them out. We might need something
@@ -251,8 +337,21 @@ private:
     /// @brief Maximum number of concurrent transactions.
     size_t max_transactions_;
 
+    /// @brief Current limit of concurrent transactions.
+    size_t concurrency_limit_;
+
+    /// @brief Number of transactions completed successfully since the
+    /// concurrency limit last changed.
+    size_t completed_since_change_;
+
     /// @brief List of transactions.
     TransactionList transaction_list_;
+
+    /// @brief FQDNs updated by the transactions, in lower case.
+    std::set<std::string> fqdn_list_;
+
+    /// @brief Counters describing the load of the manager.
+    Stats stats_;
 };
 
 /// @brief Defines a pointer to a D2UpdateMgr instance.
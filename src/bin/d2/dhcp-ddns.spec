@@ -117,6 +117,12 @@
                             "item_type": "integer",
                             "item_optional": true,
                             "item_default": 53 
+                        },
+                        { 
+                            "item_name": "protocol",
+                            "item_type": "string",
+                            "item_optional": true,
+                            "item_default": "UDP"
                         }]
                     }
                 }]
@@ -185,6 +191,12 @@
                             "item_type": "integer",
                             "item_optional": true,
                             "item_default": 53 
+                        },
+                        { 
+                            "item_name": "protocol",
+                            "item_type": "string",
+                            "item_optional": true,
+                            "item_default": "UDP"
                         }]
                     }
                 }]
@@ -14,6 +14,7 @@
 
 #include <d2/dns_client.h>
 #include <d2/d2_log.h>
+#include <d2/dns_tcp_connection.h>
 #include <dns/messagerenderer.h>
 #include <limits>
 
@@ -36,10 +37,10 @@ using namespace isc::dns;
 
 // This class provides the implementation for the DNSClient. This allows for
 // the separation of the DNSClient interface from the implementation details.
-// Currently, implementation uses IOFetch object to handle asynchronous
-// communication with the DNS. This design may be revisited in the future. If
-// implementation is changed, the DNSClient API will remain unchanged thanks
-// to this separation.
+// The implementation uses IOFetch object to handle asynchronous communication
+// with the DNS over UDP, and a persistent connection shared with the other
+// DNSClient instances over TCP. If implementation is changed, the DNSClient
+// API will remain unchanged thanks to this separation.
 class DNSClientImpl : public asiodns::IOFetch::Callback {
 public:
     // A buffer holding response from a DNS.
@@ -60,6 +61,11 @@ public:
     DNSClient::Callback* callback_;
     // A Transport Layer protocol used to communicate with a DNS.
     DNSClient::Protocol proto_;
+    // The TCP connection over which the last update was sent, and the ID
+    // the connection assigned to it. The update is cancelled if this object
+    // is destroyed before it completes.
+    DNSTCPConnectionPtr connection_;
+    uint16_t connection_id_;
 
     // Constructor and Destructor
     DNSClientImpl(D2UpdateMessagePtr& response_placeholder,
@@ -88,7 +94,8 @@ DNSClientImpl::DNSClientImpl(D2UpdateMessagePtr& response_placeholder,
                              DNSClient::Callback* callback,
                              const DNSClient::Protocol proto)
     : in_buf_(new OutputBuffer(DEFAULT_BUFFER_SIZE)),
-      response_(response_placeholder), callback_(callback), proto_(proto) {
+      response_(response_placeholder), callback_(callback), proto_(proto),
+      connection_(), connection_id_(0) {
 
     // Response should be an empty pointer. It gets populated by the
     // operator() method.
@@ -96,17 +103,6 @@ DNSClientImpl::DNSClientImpl(D2UpdateMessagePtr& response_placeholder,
         isc_throw(isc::BadValue, "Response buffer pointer should be null");
     }
 
-    // @todo Currently we only support UDP. The support for TCP is planned for
-    // the future release.
-    if (proto_ == DNSClient::TCP) {
-        isc_throw(isc::NotImplemented, "TCP is currently not supported as a"
-                  << " Transport protocol for DNS Updates; please use UDP");
-    }
-
-    // Given that we already eliminated the possibility that TCP is used, it
-    // would be sufficient  to check that (proto != DNSClient::UDP). But, once
-    // support TCP is added the check above will disappear and the extra check
-    // will be needed here anyway.
     // Note that cascaded check is used here instead of:
     //   if (proto_ != DNSClient::TCP && proto_ != DNSClient::UDP)..
     // because some versions of GCC compiler complain that check above would
@@ -122,10 +118,16 @@ DNSClientImpl::DNSClientImpl(D2UpdateMessagePtr& response_placeholder,
 }
 
 DNSClientImpl::~DNSClientImpl() {
+    // The connection outlives this object, so it must forget the callback.
+    if (connection_) {
+        connection_->cancel(connection_id_);
+    }
 }
 
 void
 DNSClientImpl::operator()(asiodns::IOFetch::Result result) {
+    connection_.reset();
+
     // Get the status from IO. If no success, we just call user's callback
     // and pass the status code.
     DNSClient::Status status = getStatus(result);
@@ -169,6 +171,11 @@ DNSClientImpl::getStatus(const asiodns::IOFetch::Result result) {
     case IOFetch::STOPPED:
         return (DNSClient::IO_STOPPED);
 
+    case IOFetch::IO_ERROR:
+        // The server is unreachable rather than overloaded, which is told
+        // apart from a timeout by the callers.
+        return (DNSClient::OTHER);
+
     default:
         ;
     }
@@ -195,6 +202,19 @@ DNSClientImpl::doUpdate(asiolink::IOService& io_service,
     // invalid message object is given.
     update.toWire(renderer);
 
+    // Over TCP, the update is pipelined over the connection to the server
+    // shared by all the DNSClient instances using this IO service. The
+    // connection calls operator()(Status) on completion, as IOFetch does.
+    if (proto_ == DNSClient::TCP) {
+        DNSTCPConnectionPtr connection =
+            asio::use_service<DNSTCPConnectionPool>(io_service.
+                                                    get_io_service()).
+            getConnection(ns_addr, ns_port);
+        connection_id_ = connection->send(msg_buf, in_buf_, this, wait);
+        connection_ = connection;
+        return;
+    }
+
     // IOFetch has all the mechanisms that we need to perform asynchronous
     // communication with the DNS server. The last but one argument points to
     // this object as a completion callback for the message exchange. As a
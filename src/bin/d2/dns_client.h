@@ -47,13 +47,15 @@ class DNSClientImpl;
 /// encapsulate DNS response, through class constructor. An exception will be
 /// thrown if the pointer is not initialized by the caller.
 ///
-/// @todo Ultimately, this class will support both TCP and UDP Transport.
-/// Currently only UDP is supported and can be specified as a preferred
-/// protocol. @c DNSClient constructor will throw an exception if TCP is
-/// specified. Once both protocols are supported, the @c DNSClient logic will
-/// try to obey caller's preference. However, it may use the other protocol if
-/// on its own discretion, when there is a legitimate reason to do so. For
-/// example, if communication with the server using preferred protocol fails.
+/// Over UDP, each DNS Update is sent from its own socket. Over TCP, the DNS
+/// Updates are pipelined over a persistent connection to the server, shared
+/// by all the @c DNSClient instances using the same IO service (see
+/// @c DNSTCPConnection). This saves the connection setup per DNS Update and
+/// avoids the truncation of the large DNS Updates.
+///
+/// @todo The @c DNSClient logic may use the other protocol on its own
+/// discretion, when there is a legitimate reason to do so. For example, if
+/// communication with the server using preferred protocol fails.
 class DNSClient {
 public:
 
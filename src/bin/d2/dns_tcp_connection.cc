@@ -0,0 +1,299 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <d2/d2_log.h>
+#include <d2/dns_tcp_connection.h>
+#include <util/io_utilities.h>
+#include <util/random/qid_gen.h>
+
+#include <boost/bind.hpp>
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace isc {
+namespace d2 {
+
+using namespace isc::asiodns;
+using namespace isc::util;
+
+const size_t DNSTCPConnection::MAX_PENDING;
+
+DNSTCPConnection::DNSTCPConnection(asio::io_service& io_service,
+                                   const asiolink::IOAddress& address,
+                                   const uint16_t port)
+    : io_service_(io_service),
+      endpoint_(asio::ip::address::from_string(address.toText()), port),
+      socket_(io_service), state_(CLOSED), generation_(0), connect_count_(0),
+      next_id_(random::QidGenerator::getInstance().generateQid()),
+      exchanges_(), write_queue_(), writing_(false), read_buf_() {
+}
+
+DNSTCPConnection::~DNSTCPConnection() {
+    asio::error_code ignored;
+    socket_.close(ignored);
+}
+
+std::string
+DNSTCPConnection::toText() const {
+    std::ostringstream stream;
+    stream << endpoint_.address().to_string() << " port:" << endpoint_.port();
+    return (stream.str());
+}
+
+uint16_t
+DNSTCPConnection::send(const OutputBufferPtr& msg_buf,
+                       const OutputBufferPtr& in_buf,
+                       IOFetch::Callback* callback,
+                       const unsigned int wait) {
+    const size_t length = msg_buf->getLength();
+    if ((length < 2) || (length > std::numeric_limits<uint16_t>::max())) {
+        isc_throw(BadValue, "invalid DNS Update message length " << length
+                  << " for TCP");
+    }
+    if (exchanges_.size() >= MAX_PENDING) {
+        isc_throw(Unexpected, "too many DNS Updates awaiting a response from "
+                  << toText());
+    }
+
+    // Find an ID which is not used by an update awaiting a response, so as
+    // the responses can't be mistaken for each other.
+    while (exchanges_.count(next_id_) > 0) {
+        ++next_id_;
+    }
+    const uint16_t id = next_id_++;
+
+    // The message is prefixed with its length, as required for TCP by
+    // RFC 1035, section 4.2.2.
+    WireDataPtr data(new std::vector<uint8_t>(length + 2));
+    writeUint16(static_cast<uint16_t>(length), &(*data)[0], 2);
+    std::memcpy(&(*data)[2], msg_buf->getData(), length);
+    writeUint16(id, &(*data)[2], 2);
+
+    Exchange exchange;
+    exchange.callback_ = callback;
+    exchange.in_buf_ = in_buf;
+    exchange.timer_.reset(new asio::deadline_timer(io_service_));
+    exchange.timer_->expires_from_now(boost::posix_time::milliseconds(wait));
+    exchange.timer_->async_wait(boost::bind(&DNSTCPConnection::timeoutHandler,
+                                            shared_from_this(), id,
+                                            exchange.timer_, _1));
+    exchanges_[id] = exchange;
+
+    write_queue_.push_back(data);
+    if (state_ == CLOSED) {
+        connect();
+    } else if (state_ == CONNECTED) {
+        write();
+    }
+    return (id);
+}
+
+void
+DNSTCPConnection::cancel(const uint16_t id) {
+    ExchangeMap::iterator it = exchanges_.find(id);
+    if (it != exchanges_.end()) {
+        it->second.timer_->cancel();
+        exchanges_.erase(it);
+    }
+}
+
+void
+DNSTCPConnection::connect() {
+    state_ = CONNECTING;
+    socket_.async_connect(endpoint_,
+                          boost::bind(&DNSTCPConnection::connectHandler,
+                                      shared_from_this(), generation_, _1));
+}
+
+void
+DNSTCPConnection::connectHandler(const unsigned int generation,
+                                 const asio::error_code& error) {
+    if (generation != generation_) {
+        return;
+    }
+    if (error) {
+        close(error);
+        return;
+    }
+    state_ = CONNECTED;
+    ++connect_count_;
+    readLength();
+    write();
+}
+
+void
+DNSTCPConnection::write() {
+    if (writing_ || write_queue_.empty()) {
+        return;
+    }
+    // The handler holds the data being written, as the write queue is
+    // cleared when the connection is closed.
+    writing_ = true;
+    WireDataPtr data = write_queue_.front();
+    asio::async_write(socket_, asio::buffer(*data),
+                      boost::bind(&DNSTCPConnection::writeHandler,
+                                  shared_from_this(), generation_, data, _1));
+}
+
+void
+DNSTCPConnection::writeHandler(const unsigned int generation, WireDataPtr,
+                               const asio::error_code& error) {
+    if (generation != generation_) {
+        return;
+    }
+    writing_ = false;
+    if (error) {
+        close(error);
+        return;
+    }
+    write_queue_.pop_front();
+    write();
+}
+
+void
+DNSTCPConnection::readLength() {
+    asio::async_read(socket_, asio::buffer(length_buf_, sizeof(length_buf_)),
+                     boost::bind(&DNSTCPConnection::lengthHandler,
+                                 shared_from_this(), generation_, _1));
+}
+
+void
+DNSTCPConnection::lengthHandler(const unsigned int generation,
+                                const asio::error_code& error) {
+    if (generation != generation_) {
+        return;
+    }
+    if (error) {
+        close(error);
+        return;
+    }
+    read_buf_.resize(readUint16(length_buf_, sizeof(length_buf_)));
+    if (read_buf_.empty()) {
+        readLength();
+        return;
+    }
+    asio::async_read(socket_, asio::buffer(read_buf_),
+                     boost::bind(&DNSTCPConnection::responseHandler,
+                                 shared_from_this(), generation_, _1));
+}
+
+void
+DNSTCPConnection::responseHandler(const unsigned int generation,
+                                  const asio::error_code& error) {
+    if (generation != generation_) {
+        return;
+    }
+    if (error) {
+        close(error);
+        return;
+    }
+
+    // The responses to the updates which timed out or were cancelled, as
+    // well as the ones too short to hold an ID, are dropped.
+    ExchangeMap::iterator it = exchanges_.end();
+    if (read_buf_.size() >= 2) {
+        it = exchanges_.find(readUint16(&read_buf_[0], 2));
+    }
+    if (it != exchanges_.end()) {
+        // The exchange is removed before the callback is invoked, as the
+        // callback may send another update or cancel this one.
+        Exchange exchange = it->second;
+        exchanges_.erase(it);
+        exchange.timer_->cancel();
+        exchange.in_buf_->clear();
+        exchange.in_buf_->writeData(&read_buf_[0], read_buf_.size());
+        (*exchange.callback_)(IOFetch::SUCCESS);
+    }
+
+    readLength();
+}
+
+void
+DNSTCPConnection::timeoutHandler(const uint16_t id, TimerPtr timer,
+                                 const asio::error_code& error) {
+    if (error == asio::error::operation_aborted) {
+        return;
+    }
+    // The ID may have been reused by another update since this one
+    // completed, so the timer identifies the update.
+    ExchangeMap::iterator it = exchanges_.find(id);
+    if ((it == exchanges_.end()) || (it->second.timer_ != timer)) {
+        return;
+    }
+    IOFetch::Callback* callback = it->second.callback_;
+    exchanges_.erase(it);
+    (*callback)(IOFetch::TIME_OUT);
+}
+
+void
+DNSTCPConnection::close(const asio::error_code& error) {
+    LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL,
+              DHCP_DDNS_DNS_CONNECTION_CLOSED).arg(toText())
+              .arg(error.message());
+
+    asio::error_code ignored;
+    socket_.close(ignored);
+    state_ = CLOSED;
+    writing_ = false;
+    ++generation_;
+    write_queue_.clear();
+
+    // The callbacks may send other updates, over a new connection, or
+    // cancel the updates not reported yet, so each exchange is looked up
+    // again before it is reported. The new updates don't reuse the IDs of
+    // the exchanges still in the map.
+    std::vector<std::pair<uint16_t, TimerPtr> > failed;
+    for (ExchangeMap::iterator it = exchanges_.begin(); it != exchanges_.end();
+         ++it) {
+        it->second.timer_->cancel();
+        failed.push_back(std::make_pair(it->first, it->second.timer_));
+    }
+    for (size_t i = 0; i < failed.size(); ++i) {
+        ExchangeMap::iterator it = exchanges_.find(failed[i].first);
+        if ((it != exchanges_.end()) &&
+            (it->second.timer_ == failed[i].second)) {
+            IOFetch::Callback* callback = it->second.callback_;
+            exchanges_.erase(it);
+            (*callback)(IOFetch::IO_ERROR);
+        }
+    }
+}
+
+asio::io_service::id DNSTCPConnectionPool::id;
+
+DNSTCPConnectionPool::DNSTCPConnectionPool(asio::io_service& io_service)
+    : asio::io_service::service(io_service), connections_() {
+}
+
+DNSTCPConnectionPtr
+DNSTCPConnectionPool::getConnection(const asiolink::IOAddress& address,
+                                    const uint16_t port) {
+    DNSTCPConnectionPtr& connection =
+        connections_[std::make_pair(address.toText(), port)];
+    if (!connection) {
+        connection.reset(new DNSTCPConnection(get_io_service(), address,
+                                              port));
+    }
+    return (connection);
+}
+
+void
+DNSTCPConnectionPool::shutdown_service() {
+    connections_.clear();
+}
+
+} // namespace d2
+} // namespace isc
@@ -0,0 +1,267 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DNS_TCP_CONNECTION_H
+#define DNS_TCP_CONNECTION_H
+
+#include <asio.hpp>
+#include <asiodns/io_fetch.h>
+#include <asiolink/io_address.h>
+#include <util/buffer.h>
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace d2 {
+
+/// @brief Persistent TCP connection to a DNS server.
+///
+/// Sending each DNS Update over its own TCP connection costs a handshake
+/// and a socket setup per update, which is why DNSClient used to support
+/// UDP only. This class keeps a single connection to the server open and
+/// pipelines the updates over it, as permitted by RFC 5966: an update is
+/// written as soon as it is sent, without waiting for the responses to the
+/// earlier ones, and the responses, which the server may send in any order,
+/// are matched to the updates by their message ID.
+///
+/// The connection assigns to each update an ID which is unique among the
+/// updates awaiting a response on this connection, overwriting the ID of
+/// the rendered message, in the same way as IOFetch does for UDP. Each
+/// update has its own timeout. The connection is established when the
+/// first update is sent and is kept open until an I/O error occurs, e.g.
+/// the server closes it. In that case, all the updates awaiting a response
+/// fail and the connection is reestablished when the next update is sent.
+///
+/// The completion of an update is reported to the IOFetch::Callback given
+/// when the update is sent, with the response written to the given buffer,
+/// so as the callers may handle UDP and TCP exchanges in the same way.
+class DNSTCPConnection :
+        public boost::enable_shared_from_this<DNSTCPConnection> {
+public:
+    /// @brief Maximum number of the updates awaiting a response.
+    ///
+    /// Each of them holds one of the 65536 message IDs.
+    static const size_t MAX_PENDING = 65536;
+
+    /// @brief Constructor
+    ///
+    /// @param io_service IO service on which the exchanges are run.
+    /// @param address address of the DNS server.
+    /// @param port port on which the DNS server listens.
+    DNSTCPConnection(asio::io_service& io_service,
+                     const asiolink::IOAddress& address,
+                     const uint16_t port);
+
+    /// @brief Destructor
+    ///
+    /// Closes the connection. The updates awaiting a response are dropped
+    /// without calling their callbacks.
+    ~DNSTCPConnection();
+
+    /// @brief Sends an update over the connection.
+    ///
+    /// @param msg_buf rendered update. Its ID is replaced by the one
+    /// assigned by the connection.
+    /// @param in_buf buffer to which the response is written.
+    /// @param callback callback invoked when the response is received or
+    /// the update fails. It must remain valid until it is invoked or the
+    /// update is cancelled.
+    /// @param wait timeout of the update, in milliseconds.
+    ///
+    /// @return ID assigned to the update.
+    /// @throw isc::BadValue if the update is too large to be sent over TCP.
+    /// @throw isc::Unexpected if @c MAX_PENDING updates await a response.
+    uint16_t send(const util::OutputBufferPtr& msg_buf,
+                  const util::OutputBufferPtr& in_buf,
+                  asiodns::IOFetch::Callback* callback,
+                  const unsigned int wait);
+
+    /// @brief Cancels an update.
+    ///
+    /// The callback of the update is not invoked and its response, if
+    /// received later, is dropped. It is not an error to cancel an update
+    /// which has already completed.
+    ///
+    /// @param id ID assigned to the update by @c send.
+    void cancel(const uint16_t id);
+
+    /// @brief Returns the number of the updates awaiting a response.
+    size_t getPendingCount() const {
+        return (exchanges_.size());
+    }
+
+    /// @brief Returns the number of times the connection was established.
+    size_t getConnectCount() const {
+        return (connect_count_);
+    }
+
+    /// @brief Returns a text representation of the server address.
+    std::string toText() const;
+
+private:
+    /// @brief State of the connection.
+    enum State {
+        CLOSED,
+        CONNECTING,
+        CONNECTED
+    };
+
+    /// @brief Defines a pointer to the timer of an update.
+    typedef boost::shared_ptr<asio::deadline_timer> TimerPtr;
+
+    /// @brief Update awaiting a response.
+    struct Exchange {
+        asiodns::IOFetch::Callback* callback_;
+        util::OutputBufferPtr in_buf_;
+        TimerPtr timer_;
+    };
+
+    /// @brief Defines the map of the updates keyed by their ID.
+    typedef std::map<uint16_t, Exchange> ExchangeMap;
+
+    /// @brief Defines a pointer to a length-prefixed update.
+    typedef boost::shared_ptr<std::vector<uint8_t> > WireDataPtr;
+
+    /// @brief Starts establishing the connection.
+    void connect();
+
+    /// @brief Writes the first update of the write queue.
+    void write();
+
+    /// @brief Reads the length of the next response.
+    void readLength();
+
+    /// @brief Handlers of the asynchronous operations.
+    ///
+    /// The generation identifies the connection on which the operation was
+    /// started, so as the completions of the operations on a connection
+    /// which has been closed are ignored.
+    //@{
+    void connectHandler(const unsigned int generation,
+                        const asio::error_code& error);
+    void writeHandler(const unsigned int generation, WireDataPtr data,
+                      const asio::error_code& error);
+    void lengthHandler(const unsigned int generation,
+                       const asio::error_code& error);
+    void responseHandler(const unsigned int generation,
+                         const asio::error_code& error);
+    void timeoutHandler(const uint16_t id, TimerPtr timer,
+                        const asio::error_code& error);
+    //@}
+
+    /// @brief Closes the connection after an I/O error.
+    ///
+    /// All the updates awaiting a response fail with an I/O error, so as
+    /// the callers don't take an unreachable server for an overloaded one.
+    ///
+    /// @param error the I/O error.
+    void close(const asio::error_code& error);
+
+    /// @brief IO service on which the exchanges are run.
+    asio::io_service& io_service_;
+
+    /// @brief Endpoint of the DNS server.
+    asio::ip::tcp::endpoint endpoint_;
+
+    /// @brief Socket of the connection.
+    asio::ip::tcp::socket socket_;
+
+    /// @brief State of the connection.
+    State state_;
+
+    /// @brief Incremented each time the connection is closed.
+    unsigned int generation_;
+
+    /// @brief Number of times the connection was established.
+    size_t connect_count_;
+
+    /// @brief ID to be tried for the next update.
+    uint16_t next_id_;
+
+    /// @brief Updates awaiting a response.
+    ExchangeMap exchanges_;
+
+    /// @brief Updates not yet written to the connection.
+    std::deque<WireDataPtr> write_queue_;
+
+    /// @brief Whether or not a write is in progress.
+    bool writing_;
+
+    /// @brief Buffer receiving the length of the response.
+    uint8_t length_buf_[2];
+
+    /// @brief Buffer receiving the response.
+    std::vector<uint8_t> read_buf_;
+};
+
+/// @brief Defines a pointer to a DNSTCPConnection.
+typedef boost::shared_ptr<DNSTCPConnection> DNSTCPConnectionPtr;
+
+/// @brief Set of the persistent TCP connections to the DNS servers.
+///
+/// The connections are shared by all the DNSClient instances using the same
+/// IO service, which is what makes the pipelining possible as each
+/// transaction has its own DNSClient. The set is attached to the IO service
+/// as an asio service, so as it lives as long as the IO service does,
+/// without a global or a new argument to thread through the transactions.
+class DNSTCPConnectionPool : public asio::io_service::service {
+public:
+    /// @brief Identifies the service in the IO service.
+    static asio::io_service::id id;
+
+    /// @brief Constructor
+    ///
+    /// It should not be called directly: the pool is created by
+    /// asio::use_service when the first connection is requested.
+    ///
+    /// @param io_service IO service to which the pool is attached.
+    explicit DNSTCPConnectionPool(asio::io_service& io_service);
+
+    /// @brief Returns the connection to a DNS server, creating it if needed.
+    ///
+    /// @param address address of the DNS server.
+    /// @param port port on which the DNS server listens.
+    DNSTCPConnectionPtr getConnection(const asiolink::IOAddress& address,
+                                      const uint16_t port);
+
+    /// @brief Returns the number of the connections in the pool.
+    size_t getConnectionCount() const {
+        return (connections_.size());
+    }
+
+private:
+    /// @brief Releases the connections when the IO service is destroyed.
+    virtual void shutdown_service();
+
+    /// @brief Defines the map of the connections keyed by address and port.
+    typedef std::map<std::pair<std::string, uint16_t>, DNSTCPConnectionPtr>
+        ConnectionMap;
+
+    /// @brief Connections to the DNS servers.
+    ConnectionMap connections_;
+};
+
+} // namespace d2
+} // namespace isc
+
+#endif // DNS_TCP_CONNECTION_H
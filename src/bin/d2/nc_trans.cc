@@ -433,12 +433,10 @@ NameChangeTransaction::selectNextServer() {
         // Toss out any previous response.
         dns_update_response_.reset();
 
-        // @todo  Protocol is set on DNSClient constructor.  We need
-        // to propagate a configuration value downward, probably starting
-        // at global, then domain, then server
-        // Once that is supported we need to add it here.
+        // Protocol is set on DNSClient constructor, from the server's
+        // configuration.
         dns_client_.reset(new DNSClient(dns_update_response_ , this,
-                                        DNSClient::UDP));
+                                        current_server_->getProtocol()));
         ++next_server_pos_;
         return (true);
     }
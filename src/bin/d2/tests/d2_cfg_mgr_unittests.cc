@@ -448,6 +448,7 @@ TEST_F(TSIGKeyInfoTest, validTSIGKeyList) {
 /// 1. Specifying both a hostname and an ip address is not allowed.
 /// 2. Specifying both blank a hostname and blank ip address is not allowed.
 /// 3. Specifying a negative port number is not allowed.
+/// 4. Specifying a protocol other than UDP or TCP is not allowed.
 TEST_F(DnsServerInfoTest, invalidEntry) {
     // Create a config in which both host and ip address are supplied.
     // Verify that it builds without throwing but commit fails.
@@ -471,6 +472,14 @@ TEST_F(DnsServerInfoTest, invalidEntry) {
              "  \"port\": -100 }";
     ASSERT_TRUE(fromJSON(config));
     EXPECT_THROW (parser_->build(config_set_), isc::BadValue);
+
+    // Create a config with an unknown protocol.
+    // Verify that it builds without throwing but commit fails.
+    config = "{ \"ip_address\": \"192.168.5.6\" ,"
+             "  \"protocol\": \"SCTP\" }";
+    ASSERT_TRUE(fromJSON(config));
+    EXPECT_NO_THROW(parser_->build(config_set_));
+    EXPECT_THROW(parser_->commit(), D2CfgError);
 }
 
 
@@ -480,6 +489,7 @@ TEST_F(DnsServerInfoTest, invalidEntry) {
 /// 1. A DnsServerInfo entry is correctly made, when given only a hostname.
 /// 2. A DnsServerInfo entry is correctly made, when given ip address and port.
 /// 3. A DnsServerInfo entry is correctly made, when given only an ip address.
+/// 4. A DnsServerInfo entry is correctly made, when given a protocol.
 TEST_F(DnsServerInfoTest, validEntry) {
     // Valid entries for dynamic host
     std::string config = "{ \"hostname\": \"pegasus.tmark\" }";
@@ -538,6 +548,27 @@ TEST_F(DnsServerInfoTest, validEntry) {
     server = (*servers_)[0];
     EXPECT_TRUE(checkServer(server, "", "192.168.2.5",
                             DnsServerInfo::STANDARD_DNS_PORT));
+    // UDP is the default protocol.
+    EXPECT_EQ(DNSClient::UDP, server->getProtocol());
+
+    // Start over for a new test.
+    reset();
+
+    // Valid entries for static ip and TCP
+    config = " { \"ip_address\": \"192.168.2.5\" , "
+             "  \"protocol\": \"TCP\" }";
+    ASSERT_TRUE(fromJSON(config));
+
+    // Verify that it builds and commits without throwing.
+    ASSERT_NO_THROW(parser_->build(config_set_));
+    ASSERT_NO_THROW(parser_->commit());
+
+    // Verify the server exists and has the correct values.
+    ASSERT_EQ(1, servers_->size());
+    server = (*servers_)[0];
+    EXPECT_TRUE(checkServer(server, "", "192.168.2.5",
+                            DnsServerInfo::STANDARD_DNS_PORT));
+    EXPECT_EQ(DNSClient::TCP, server->getProtocol());
 }
 
 /// @brief Verifies that attempting to parse an invalid list of DnsServerInfo
@@ -291,10 +291,15 @@ TEST_F(D2ProcessTest, queueFullRecovery) {
     size_t max_queue_size = 5;
     queue_mgr->setMaxQueueSize(max_queue_size);
 
-    // Manually enqueue max requests.
+    // Manually enqueue max requests.  Each request is for another address,
+    // so as the requests don't supersede each other.
     dhcp_ddns::NameChangeRequestPtr ncr;
-    ASSERT_NO_THROW(ncr = dhcp_ddns::NameChangeRequest::fromJSON(test_msg));
     for (int i = 0; i < max_queue_size; i++) {
+        ASSERT_NO_THROW(ncr = dhcp_ddns::NameChangeRequest::fromJSON(test_msg));
+        std::ostringstream address;
+        address << "192.168.2." << (i + 1);
+        ncr->setIpAddress(address.str());
+
         // Verify that the request can be added to the queue and queue
         // size increments accordingly.
         ASSERT_NO_THROW(queue_mgr->enqueue(ncr));
@@ -45,13 +45,14 @@ const char *valid_msgs[] =
      " \"lease_expires_on\" : \"20130121132405\" , "
      " \"lease_length\" : 1300 "
      "}",
-    // Valid Remove.
+    // Valid Remove, for another address than the Add so as it doesn't
+    // supersede it.
      "{"
      " \"change_type\" : 1 , "
      " \"forward_change\" : true , "
      " \"reverse_change\" : false , "
      " \"fqdn\" : \"walah.walah.com\" , "
-     " \"ip_address\" : \"192.168.2.1\" , "
+     " \"ip_address\" : \"192.168.2.2\" , "
      " \"dhcid\" : \"010203040A7F8E3D\" , "
      " \"lease_expires_on\" : \"20130121132405\" , "
      " \"lease_length\" : 1300 "
@@ -195,6 +196,101 @@ TEST(D2QueueMgrBasicTest, basicQueue) {
     EXPECT_THROW(queue_mgr->peekAt(VALID_MSG_CNT + 1), D2QueueMgrInvalidIndex);
     EXPECT_THROW(queue_mgr->dequeueAt(VALID_MSG_CNT + 1),
                  D2QueueMgrInvalidIndex);
+
+    // Verify that the queue can be walked by position, removing entries on
+    // the way: the removal returns the position of the next entry.
+    RequestQueue::iterator pos = queue_mgr->queueBegin();
+    ASSERT_TRUE(pos != queue_mgr->queueEnd());
+    EXPECT_TRUE (*(ref_msgs[0]) == **pos);
+    EXPECT_NO_THROW(pos = queue_mgr->dequeueAt(pos));
+    ASSERT_TRUE(pos != queue_mgr->queueEnd());
+    EXPECT_TRUE (*(ref_msgs[2]) == **pos);
+    EXPECT_EQ(VALID_MSG_CNT - 2, queue_mgr->getQueueSize());
+    EXPECT_TRUE(++pos == queue_mgr->queueEnd());
+
+    // The removed entry is no longer superseded by a new request.
+    EXPECT_NO_THROW(queue_mgr->enqueue(ref_msgs[0]));
+    EXPECT_EQ(VALID_MSG_CNT - 1, queue_mgr->getQueueSize());
+    EXPECT_EQ(0, queue_mgr->getCoalescedCount());
+}
+
+/// @brief Tests coalescing of the requests superseding queued requests.
+/// This test verifies that:
+/// 1. A request removes a queued request for the same FQDN, DHCID and
+/// address, regardless of the change type and of the case of the FQDN, and
+/// it is added to the end of the queue.
+/// 2. A request doesn't supersede a queued request for another FQDN, DHCID
+/// or address.
+/// 3. A request doesn't supersede a queued request updating more
+/// directions.
+/// 4. A request doesn't supersede a request which has been dequeued.
+/// 5. The superseded requests are counted.
+TEST(D2QueueMgrBasicTest, coalescing) {
+    IOServicePtr io_service(new isc::asiolink::IOService());
+    D2QueueMgrPtr queue_mgr;
+    ASSERT_NO_THROW(queue_mgr.reset(new D2QueueMgr(io_service)));
+    EXPECT_EQ(0, queue_mgr->getCoalescedCount());
+
+    NameChangeRequestPtr add;
+    ASSERT_NO_THROW(add = NameChangeRequest::fromJSON(valid_msgs[0]));
+    NameChangeRequestPtr other_fqdn(new NameChangeRequest(*add));
+    other_fqdn->setFqdn("other.walah.com");
+    NameChangeRequestPtr other_dhcid(new NameChangeRequest(*add));
+    other_dhcid->setDhcid("0102030405060708");
+    NameChangeRequestPtr other_address(new NameChangeRequest(*add));
+    other_address->setIpAddress("192.168.2.3");
+
+    ASSERT_NO_THROW(queue_mgr->enqueue(add));
+    ASSERT_NO_THROW(queue_mgr->enqueue(other_fqdn));
+    ASSERT_NO_THROW(queue_mgr->enqueue(other_dhcid));
+    ASSERT_NO_THROW(queue_mgr->enqueue(other_address));
+    EXPECT_EQ(4, queue_mgr->getQueueSize());
+    EXPECT_EQ(0, queue_mgr->getCoalescedCount());
+
+    // The remove supersedes the add, and it goes to the end of the queue.
+    NameChangeRequestPtr remove(new NameChangeRequest(*add));
+    remove->setChangeType(CHG_REMOVE);
+    ASSERT_NO_THROW(queue_mgr->enqueue(remove));
+    EXPECT_EQ(4, queue_mgr->getQueueSize());
+    EXPECT_EQ(1, queue_mgr->getCoalescedCount());
+    EXPECT_TRUE(queue_mgr->peek() == other_fqdn);
+    EXPECT_TRUE(queue_mgr->peekAt(3) == remove);
+
+    // The add supersedes the remove, regardless of the case of the FQDN.
+    NameChangeRequestPtr add_again(new NameChangeRequest(*add));
+    add_again->setFqdn("WALAH.walah.COM");
+    ASSERT_NO_THROW(queue_mgr->enqueue(add_again));
+    EXPECT_EQ(4, queue_mgr->getQueueSize());
+    EXPECT_EQ(2, queue_mgr->getCoalescedCount());
+    EXPECT_TRUE(queue_mgr->peekAt(3) == add_again);
+
+    // A request updating the reverse mapping too supersedes the add, but
+    // a forward only request doesn't supersede it.
+    NameChangeRequestPtr both(new NameChangeRequest(*add));
+    both->setReverseChange(true);
+    ASSERT_NO_THROW(queue_mgr->enqueue(both));
+    EXPECT_EQ(4, queue_mgr->getQueueSize());
+    EXPECT_EQ(3, queue_mgr->getCoalescedCount());
+    ASSERT_NO_THROW(queue_mgr->enqueue(add));
+    EXPECT_EQ(5, queue_mgr->getQueueSize());
+    EXPECT_EQ(3, queue_mgr->getCoalescedCount());
+
+    // The dequeued requests are not superseded.
+    ASSERT_NO_THROW(queue_mgr->dequeue());
+    ASSERT_NO_THROW(queue_mgr->enqueue(other_fqdn));
+    EXPECT_EQ(5, queue_mgr->getQueueSize());
+    EXPECT_EQ(3, queue_mgr->getCoalescedCount());
+    ASSERT_NO_THROW(queue_mgr->dequeueAt(0));
+    NameChangeRequestPtr dhcid_again(new NameChangeRequest(*other_dhcid));
+    ASSERT_NO_THROW(queue_mgr->enqueue(dhcid_again));
+    EXPECT_EQ(5, queue_mgr->getQueueSize());
+    EXPECT_EQ(3, queue_mgr->getCoalescedCount());
+
+    // Nothing is superseded once the queue has been cleared.
+    ASSERT_NO_THROW(queue_mgr->clearQueue());
+    ASSERT_NO_THROW(queue_mgr->enqueue(add));
+    EXPECT_EQ(1, queue_mgr->getQueueSize());
+    EXPECT_EQ(3, queue_mgr->getCoalescedCount());
 }
 
 /// @brief Compares two NameChangeRequests for equality.
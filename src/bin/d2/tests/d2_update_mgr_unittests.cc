@@ -54,6 +54,7 @@ public:
     // Expose the protected methods to be tested.
     using D2UpdateMgr::checkFinishedTransactions;
     using D2UpdateMgr::pickNextJob;
+    using D2UpdateMgr::pickJobs;
     using D2UpdateMgr::makeTransaction;
 };
 
@@ -90,7 +91,8 @@ public:
     /// @brief Creates a list of valid NameChangeRequest.
     ///
     /// This method builds a list of NameChangeRequests from a single
-    /// JSON string request. Each request is assigned a unique DHCID.
+    /// JSON string request. Each request is assigned a unique DHCID and
+    /// a unique FQDN.
     void makeCannedNcrs() {
         const char* msg_str =
         "{"
@@ -105,11 +107,14 @@ public:
         "}";
 
         const char* dhcids[] = { "111111", "222222", "333333", "444444"};
+        const char* fqdns[] = { "one.example.com.", "two.example.com.",
+                                "three.example.com.", "four.example.com." };
         canned_count_ = 4;
         for (int i = 0; i < canned_count_; i++) {
             dhcp_ddns::NameChangeRequestPtr ncr = NameChangeRequest::
                                                   fromJSON(msg_str);
             ncr->setDhcid(dhcids[i]);
+            ncr->setFqdn(fqdns[i]);
             ncr->setChangeType(i % 2 == 0 ?
                                dhcp_ddns::CHG_ADD : dhcp_ddns::CHG_REMOVE);
             canned_ncrs_.push_back(ncr);
@@ -162,14 +167,25 @@ public:
         // add test on index
         if (index >= canned_count_) {
             ADD_FAILURE() << "request index is out of range: " << index;
+            return;
         }
 
-        const dhcp_ddns::D2Dhcid key = canned_ncrs_[index]->getDhcid();
+        completeTransaction(canned_ncrs_[index], status);
+    }
+
+    /// @brief Fakes the completion of the transaction formed from a request.
+    ///
+    /// @param ncr request from which the transaction was formed.
+    /// @param status completion status to assign to the request
+    void completeTransaction(const NameChangeRequestPtr& ncr,
+                             const dhcp_ddns::NameChangeStatus& status) {
+        const dhcp_ddns::D2Dhcid key = ncr->getDhcid();
 
         // locate the transaction based on the request DHCID
         TransactionList::iterator pos = update_mgr_->findTransaction(key);
         if (pos == update_mgr_->transactionListEnd()) {
             ADD_FAILURE() << "cannot find transaction for key: " << key.toStr();
+            return;
         }
 
         NameChangeTransactionPtr trans = (*pos).second;
@@ -339,9 +355,24 @@ TEST_F(D2UpdateMgrTest, transactionList) {
     EXPECT_THROW(update_mgr_->makeTransaction(ncr), D2UpdateMgrError);
     EXPECT_EQ(1, update_mgr_->getTransactionCount());
 
+    // Verify that the transaction is found by FQDN, regardless of the case.
+    EXPECT_TRUE(update_mgr_->hasFqdnTransaction("one.example.com."));
+    EXPECT_TRUE(update_mgr_->hasFqdnTransaction("One.EXAMPLE.com."));
+    EXPECT_FALSE(update_mgr_->hasFqdnTransaction("two.example.com."));
+
+    // Verify that adding a transaction for the same FQDN fails.
+    dhcp_ddns::NameChangeRequestPtr
+        same_fqdn_ncr(new dhcp_ddns::NameChangeRequest(*ncr));
+    same_fqdn_ncr->setDhcid("AABBCCDDEEFF");
+    same_fqdn_ncr->setFqdn("ONE.example.com.");
+    EXPECT_THROW(update_mgr_->makeTransaction(same_fqdn_ncr),
+                 D2UpdateMgrError);
+    EXPECT_EQ(1, update_mgr_->getTransactionCount());
+
     // Verify the we can remove a transaction by key.
     EXPECT_NO_THROW(update_mgr_->removeTransaction(ncr->getDhcid()));
     EXPECT_EQ(0, update_mgr_->getTransactionCount());
+    EXPECT_FALSE(update_mgr_->hasFqdnTransaction("one.example.com."));
 
     // Verify the we can try to remove a non-existent transaction without harm.
     EXPECT_NO_THROW(update_mgr_->removeTransaction(ncr->getDhcid()));
@@ -454,8 +485,7 @@ TEST_F(D2UpdateMgrTest, bothDisabled) {
 /// This test verifies that:
 /// 1. Completed transactions are removed from the transaction list.
 /// 2. Failed transactions are removed from the transaction list.
-/// @todo This test will need to expand if and when checkFinishedTransactions
-/// method expands to do more than remove them from the list.
+/// 3. The finished transactions are counted.
 TEST_F(D2UpdateMgrTest, checkFinishedTransaction) {
     // Ensure we have at least 4 canned requests with which to work.
     ASSERT_TRUE(canned_count_ >= 4);
@@ -497,6 +527,14 @@ TEST_F(D2UpdateMgrTest, checkFinishedTransaction) {
     // Verify that the list of transactions has decreased by two.
     EXPECT_EQ(canned_count_ - 2, update_mgr_->getTransactionCount());
 
+    // Verify that the transactions have been counted.
+    const D2UpdateMgr::Stats& stats = update_mgr_->getStats();
+    EXPECT_EQ(canned_count_, stats.started_);
+    EXPECT_EQ(1, stats.completed_);
+    EXPECT_EQ(1, stats.failed_);
+    EXPECT_EQ(0, stats.timeouts_);
+    EXPECT_EQ(canned_count_, stats.max_transaction_count_);
+
     // Vefity that the transaction list is correct.
     EXPECT_TRUE(update_mgr_->hasTransaction(canned_ncrs_[0]->getDhcid()));
     EXPECT_FALSE(update_mgr_->hasTransaction(canned_ncrs_[1]->getDhcid()));
@@ -603,13 +641,17 @@ TEST_F(D2UpdateMgrTest, sweep) {
         EXPECT_NO_THROW(queue_mgr_->enqueue(canned_ncrs_[i]));
     }
 
-    // Invoke sweep canned_count_ times which should create a
-    // transaction for each canned ncr.
+    // The concurrency limit can't exceed max transactions.
+    EXPECT_EQ(canned_count_, update_mgr_->getConcurrencyLimit());
+
+    // Invoke sweep once which should create a transaction for each
+    // canned ncr.
+    EXPECT_NO_THROW(update_mgr_->sweep());
+    EXPECT_EQ(canned_count_, update_mgr_->getTransactionCount());
     for (int i = 0; i < canned_count_; i++) {
-        EXPECT_NO_THROW(update_mgr_->sweep());
-        EXPECT_EQ(i + 1, update_mgr_->getTransactionCount());
         EXPECT_TRUE(update_mgr_->hasTransaction(canned_ncrs_[i]->getDhcid()));
     }
+    EXPECT_EQ(canned_count_, update_mgr_->getStats().max_queue_count_);
 
     // Verify that the queue has been drained.
     EXPECT_EQ(0, update_mgr_->getQueueCount());
@@ -642,14 +684,17 @@ TEST_F(D2UpdateMgrTest, sweep) {
     dhcp_ddns::NameChangeRequestPtr
         another_ncr(new dhcp_ddns::NameChangeRequest(*(canned_ncrs_[0])));
     another_ncr->setDhcid("AABBCCDDEEFF");
+    another_ncr->setFqdn("five.example.com.");
     EXPECT_NO_THROW(queue_mgr_->enqueue(another_ncr));
     EXPECT_EQ(1, update_mgr_->getQueueCount());
 
     // Verify that sweep does not dequeue the new request as we are at
-    // maximum transaction count.
+    // maximum transaction count, and that it is counted.
+    const uint64_t limit_reached = update_mgr_->getStats().limit_reached_;
     EXPECT_NO_THROW(update_mgr_->sweep());
     EXPECT_EQ(canned_count_, update_mgr_->getTransactionCount());
     EXPECT_EQ(1, update_mgr_->getQueueCount());
+    EXPECT_EQ(limit_reached + 1, update_mgr_->getStats().limit_reached_);
 
     // Set max transactions to same as current transaction count.
     EXPECT_NO_THROW(update_mgr_->setMaxTransactions(canned_count_ + 1));
@@ -663,6 +708,117 @@ TEST_F(D2UpdateMgrTest, sweep) {
     // Verify that clearing transaction list works.
     EXPECT_NO_THROW(update_mgr_->clearTransactionList());
     EXPECT_EQ(0, update_mgr_->getTransactionCount());
+    EXPECT_FALSE(update_mgr_->hasFqdnTransaction("one.example.com."));
+}
+
+/// @brief Tests the ordering of the requests for the same FQDN or DHCID.
+/// This test verifies that:
+/// 1. A request for an FQDN with a transaction in progress is not selected,
+/// even if its DHCID differs.
+/// 2. A request for a DHCID of a request passed over is not selected, even
+/// if its FQDN differs, so as the requests are processed in order.
+/// 3. The requests for the other clients are selected in the same pass.
+/// 4. The requests passed over are selected, in order, once the preceding
+/// transactions finish.
+TEST_F(D2UpdateMgrTest, fqdnOrdering) {
+    // Same FQDN as the first canned request, but another DHCID.
+    dhcp_ddns::NameChangeRequestPtr
+        same_fqdn_ncr(new dhcp_ddns::NameChangeRequest(*(canned_ncrs_[0])));
+    same_fqdn_ncr->setDhcid("AABBCCDDEEFF");
+    same_fqdn_ncr->setFqdn("ONE.EXAMPLE.COM.");
+
+    // Same DHCID as the request above, but another FQDN.
+    dhcp_ddns::NameChangeRequestPtr
+        same_dhcid_ncr(new dhcp_ddns::NameChangeRequest(*same_fqdn_ncr));
+    same_dhcid_ncr->setFqdn("six.example.com.");
+
+    ASSERT_NO_THROW(queue_mgr_->enqueue(canned_ncrs_[0]));
+    ASSERT_NO_THROW(queue_mgr_->enqueue(same_fqdn_ncr));
+    ASSERT_NO_THROW(queue_mgr_->enqueue(same_dhcid_ncr));
+    ASSERT_NO_THROW(queue_mgr_->enqueue(canned_ncrs_[1]));
+
+    // Verify that the first and the last requests are selected in one
+    // pass, and the other two are deferred.
+    EXPECT_EQ(2, update_mgr_->pickJobs(update_mgr_->getQueueCount()));
+    EXPECT_EQ(2, update_mgr_->getTransactionCount());
+    EXPECT_EQ(2, update_mgr_->getQueueCount());
+    EXPECT_TRUE(update_mgr_->hasTransaction(canned_ncrs_[0]->getDhcid()));
+    EXPECT_TRUE(update_mgr_->hasTransaction(canned_ncrs_[1]->getDhcid()));
+    EXPECT_EQ(2, update_mgr_->getStats().deferred_);
+
+    // Verify that nothing is selected while the first transaction is
+    // in progress.
+    EXPECT_NO_THROW(update_mgr_->sweep());
+    EXPECT_EQ(2, update_mgr_->getTransactionCount());
+    EXPECT_EQ(2, update_mgr_->getQueueCount());
+
+    // Verify that the request for the same FQDN is selected once the first
+    // transaction finishes, but the following one for its DHCID is not.
+    completeTransaction(0, dhcp_ddns::ST_COMPLETED);
+    EXPECT_NO_THROW(update_mgr_->sweep());
+    EXPECT_EQ(2, update_mgr_->getTransactionCount());
+    EXPECT_EQ(1, update_mgr_->getQueueCount());
+    EXPECT_TRUE(update_mgr_->hasTransaction(same_fqdn_ncr->getDhcid()));
+    EXPECT_TRUE(update_mgr_->hasFqdnTransaction("one.example.com."));
+    EXPECT_FALSE(update_mgr_->hasFqdnTransaction("six.example.com."));
+
+    // Verify that the last request is selected when its predecessor
+    // finishes.
+    completeTransaction(same_fqdn_ncr, dhcp_ddns::ST_COMPLETED);
+    EXPECT_NO_THROW(update_mgr_->sweep());
+    EXPECT_EQ(2, update_mgr_->getTransactionCount());
+    EXPECT_EQ(0, update_mgr_->getQueueCount());
+    EXPECT_TRUE(update_mgr_->hasFqdnTransaction("six.example.com."));
+    EXPECT_FALSE(update_mgr_->hasFqdnTransaction("one.example.com."));
+}
+
+/// @brief Tests the adaptation of the concurrency limit.
+/// This test verifies that:
+/// 1. The limit is raised by one once as many transactions as the limit
+/// completed successfully.
+/// 2. The failures other than timeouts don't change the limit.
+/// 3. The limit never exceeds max transactions.
+TEST_F(D2UpdateMgrTest, concurrencyLimit) {
+    const size_t limit = D2UpdateMgr::INITIAL_CONCURRENCY_LIMIT;
+    ASSERT_EQ(limit, update_mgr_->getConcurrencyLimit());
+
+    // Run the given number of transactions to completion, one after
+    // another.
+    NameChangeRequestPtr ncr = canned_ncrs_[0];
+    for (size_t i = 0; i < 2 * limit + 1; ++i) {
+        ASSERT_NO_THROW(update_mgr_->makeTransaction(ncr));
+        completeTransaction(0, (i == limit - 1 ? dhcp_ddns::ST_FAILED :
+                                dhcp_ddns::ST_COMPLETED));
+        ASSERT_NO_THROW(update_mgr_->checkFinishedTransactions());
+
+        // The failed transaction doesn't count.
+        if (i < limit) {
+            EXPECT_EQ(limit, update_mgr_->getConcurrencyLimit());
+        } else {
+            EXPECT_EQ(limit + 1, update_mgr_->getConcurrencyLimit());
+        }
+    }
+    EXPECT_EQ(0, update_mgr_->getTransactionCount());
+    EXPECT_EQ(2 * limit, update_mgr_->getStats().completed_);
+    EXPECT_EQ(1, update_mgr_->getStats().failed_);
+
+    // Another full window raises the limit again.
+    for (size_t i = 0; i < limit; ++i) {
+        ASSERT_NO_THROW(update_mgr_->makeTransaction(ncr));
+        completeTransaction(0, dhcp_ddns::ST_COMPLETED);
+        ASSERT_NO_THROW(update_mgr_->checkFinishedTransactions());
+    }
+    EXPECT_EQ(limit + 2, update_mgr_->getConcurrencyLimit());
+
+    // Verify that max transactions caps the limit.
+    ASSERT_NO_THROW(update_mgr_->setMaxTransactions(2));
+    EXPECT_EQ(2, update_mgr_->getConcurrencyLimit());
+    for (size_t i = 0; i < 4; ++i) {
+        ASSERT_NO_THROW(update_mgr_->makeTransaction(ncr));
+        completeTransaction(0, dhcp_ddns::ST_COMPLETED);
+        ASSERT_NO_THROW(update_mgr_->checkFinishedTransactions());
+    }
+    EXPECT_EQ(2, update_mgr_->getConcurrencyLimit());
 }
 
 /// @brief Tests integration of NameAddTransaction
@@ -847,13 +1003,19 @@ TEST_F(D2UpdateMgrTest, multiTransaction) {
     for (int i = 0; i < test_count; i++) {
         EXPECT_EQ(dhcp_ddns::ST_COMPLETED, canned_ncrs_[i]->getStatus());
     }
+
+    // Verify that all the transactions ran concurrently.
+    const D2UpdateMgr::Stats& stats = update_mgr_->getStats();
+    EXPECT_EQ(test_count, stats.started_);
+    EXPECT_EQ(test_count, stats.completed_);
+    EXPECT_EQ(0, stats.failed_);
+    EXPECT_EQ(test_count, stats.max_transaction_count_);
 }
 
-/// @brief Tests processing of multiple transactions.
-/// This test verifies that update manager can create and manage a multiple
-/// transactions, concurrently.  It uses a fake server that responds to all
-/// requests sent with NOERROR, simulating successful DNS updates. The
-/// transactions are a mix of both adds and removes.
+/// @brief Tests processing of multiple transactions which time out.
+/// This test verifies that update manager concludes multiple concurrent
+/// transactions for which no server responds, and that the timeouts
+/// decrease the concurrency limit.
 TEST_F(D2UpdateMgrTest, multiTransactionTimeout) {
     // Queue up all the requests.
     int test_count = canned_count_;
@@ -870,6 +1032,13 @@ TEST_F(D2UpdateMgrTest, multiTransactionTimeout) {
     for (int i = 0; i < test_count; i++) {
         EXPECT_EQ(dhcp_ddns::ST_FAILED, canned_ncrs_[i]->getStatus());
     }
+
+    const D2UpdateMgr::Stats& stats = update_mgr_->getStats();
+    EXPECT_EQ(test_count, stats.failed_);
+    EXPECT_EQ(test_count, stats.timeouts_);
+    EXPECT_LE(update_mgr_->getConcurrencyLimit(),
+              D2UpdateMgr::INITIAL_CONCURRENCY_LIMIT / 2);
+    EXPECT_GE(update_mgr_->getConcurrencyLimit(), 1);
 }
 
 }
@@ -14,12 +14,15 @@
 
 #include <config.h>
 #include <d2/dns_client.h>
+#include <d2/dns_tcp_connection.h>
 #include <asiodns/io_fetch.h>
 #include <asiodns/logger.h>
 #include <asiolink/interval_timer.h>
+#include <dns/messagerenderer.h>
 #include <dns/rcode.h>
 #include <dns/rrclass.h>
 #include <dns/tsig.h>
+#include <asio/ip/tcp.hpp>
 #include <asio/ip/udp.hpp>
 #include <asio/socket_base.hpp>
 #include <boost/bind.hpp>
@@ -27,6 +30,8 @@
 #include <gtest/gtest.h>
 #include <nc_test_utils.h>
 
+#include <set>
+
 using namespace std;
 using namespace isc;
 using namespace isc::asiolink;
@@ -46,6 +51,121 @@ const uint16_t TEST_PORT = 5301;
 const size_t MAX_SIZE = 1024;
 const long TEST_TIMEOUT = 5 * 1000;
 
+// @brief Completion callback of a DNSClient used in the TCP tests.
+//
+// Each DNSClient sending an update over TCP has its own callback, which
+// records the status and stops the IO service when the expected number
+// of updates have completed.
+class TCPCallback : public DNSClient::Callback {
+public:
+    TCPCallback(IOService& service, int& completed, const int expected)
+        : service_(service), completed_(completed), expected_(expected),
+          status_(DNSClient::OTHER), called_(false) {
+    }
+
+    virtual void operator()(DNSClient::Status status) {
+        status_ = status;
+        called_ = true;
+        if (++completed_ == expected_) {
+            service_.stop();
+        }
+    }
+
+    IOService& service_;
+    int& completed_;
+    const int expected_;
+    DNSClient::Status status_;
+    bool called_;
+};
+
+// @brief Stand-in for a DNS server accepting the updates over TCP.
+//
+// It reads the given number of updates from the connection it accepts,
+// then responds to them in the reverse order, so as the responses can only
+// be matched to the updates by their ID. The responses are the copies of
+// the updates with the QR bit set. It counts the connections it accepts.
+class TCPServer {
+public:
+    TCPServer(IOService& service, const size_t updates)
+        : acceptor_(service.get_io_service(),
+                    tcp::endpoint(address::from_string(TEST_ADDRESS),
+                                  TEST_PORT)),
+          socket_(service.get_io_service()),
+          other_socket_(service.get_io_service()),
+          updates_(updates), accepted_(0) {
+        acceptor_.async_accept(socket_, boost::bind(&TCPServer::acceptHandler,
+                                                    this, _1));
+    }
+
+    size_t getAccepted() const {
+        return (accepted_);
+    }
+
+private:
+    void acceptHandler(const asio::error_code& error) {
+        if (error) {
+            return;
+        }
+        ++accepted_;
+        // Count the other connections, if any.
+        acceptor_.async_accept(other_socket_,
+                               boost::bind(&TCPServer::otherAcceptHandler,
+                                           this, _1));
+        readLength();
+    }
+
+    void otherAcceptHandler(const asio::error_code& error) {
+        if (!error) {
+            ++accepted_;
+        }
+    }
+
+    void readLength() {
+        asio::async_read(socket_, asio::buffer(length_buf_, 2),
+                         boost::bind(&TCPServer::lengthHandler, this, _1));
+    }
+
+    void lengthHandler(const asio::error_code& error) {
+        if (error) {
+            return;
+        }
+        buffers_.push_back(std::vector<uint8_t>((length_buf_[0] << 8) |
+                                                length_buf_[1]));
+        asio::async_read(socket_, asio::buffer(buffers_.back()),
+                         boost::bind(&TCPServer::updateHandler, this, _1));
+    }
+
+    void updateHandler(const asio::error_code& error) {
+        if (error) {
+            return;
+        }
+        if (buffers_.size() < updates_) {
+            readLength();
+            return;
+        }
+        // All the updates were received: respond in the reverse order.
+        for (size_t i = buffers_.size(); i > 0; --i) {
+            std::vector<uint8_t>& response = buffers_[i - 1];
+            // See udpReceiveHandler for the value of the 3rd byte.
+            response[2] = 0xA8;
+            const uint8_t length[] = {
+                static_cast<uint8_t>(response.size() >> 8),
+                static_cast<uint8_t>(response.size() & 0xff)
+            };
+            asio::write(socket_, asio::buffer(length, sizeof(length)));
+            asio::write(socket_, asio::buffer(response));
+        }
+    }
+
+    tcp::acceptor acceptor_;
+    tcp::socket socket_;
+    tcp::socket other_socket_;
+    const size_t updates_;
+    size_t accepted_;
+    uint8_t length_buf_[2];
+    std::vector<std::vector<uint8_t> > buffers_;
+};
+
 // @brief Test Fixture class.
 //
 // This test fixture class implements DNSClient::Callback so as it can be
@@ -195,12 +315,7 @@ public:
     // callback object is NULL.
     void runConstructorTest() {
         EXPECT_NO_THROW(DNSClient(response_, NULL, DNSClient::UDP));
-
-        // The TCP Transport is not supported right now. So, we return exception
-        // if caller specified TCP as a preferred protocol. This test will be
-        // removed once TCP is supported.
-        EXPECT_THROW(DNSClient(response_, NULL, DNSClient::TCP),
-                     isc::NotImplemented);
+        EXPECT_NO_THROW(DNSClient(response_, NULL, DNSClient::TCP));
     }
 
     // This test verifies that it accepted timeout values belong to the range of
@@ -359,6 +474,120 @@ public:
         // run_one() to work.
         service_.get_io_service().reset();
     }
+
+    // This test verifies that the DNS Updates sent over TCP by different
+    // DNSClient instances are pipelined over a single connection, and that
+    // the responses are matched to the updates by their ID.
+    void runTCPPipelineTest() {
+        TCPServer server(service_, 2);
+
+        // Each update is for a different zone, so as each response tells
+        // which update it was matched to.
+        D2UpdateMessage message1(D2UpdateMessage::OUTBOUND);
+        ASSERT_NO_THROW(message1.setZone(Name("example.com"), RRClass::IN()));
+        D2UpdateMessage message2(D2UpdateMessage::OUTBOUND);
+        ASSERT_NO_THROW(message2.setZone(Name("example.org"), RRClass::IN()));
+
+        int completed = 0;
+        D2UpdateMessagePtr response1;
+        TCPCallback callback1(service_, completed, 2);
+        DNSClient client1(response1, &callback1, DNSClient::TCP);
+        D2UpdateMessagePtr response2;
+        TCPCallback callback2(service_, completed, 2);
+        DNSClient client2(response2, &callback2, DNSClient::TCP);
+
+        const int timeout = 500;
+        client1.doUpdate(service_, IOAddress(TEST_ADDRESS), TEST_PORT,
+                         message1, timeout);
+        client2.doUpdate(service_, IOAddress(TEST_ADDRESS), TEST_PORT,
+                         message2, timeout);
+
+        // The server responds only once it has received both updates.
+        service_.run();
+        service_.get_io_service().reset();
+
+        ASSERT_TRUE(callback1.called_);
+        ASSERT_EQ(DNSClient::SUCCESS, callback1.status_);
+        ASSERT_TRUE(response1);
+        EXPECT_EQ(D2UpdateMessage::RESPONSE, response1->getQRFlag());
+        EXPECT_EQ("example.com.", response1->getZone()->getName().toText());
+
+        ASSERT_TRUE(callback2.called_);
+        ASSERT_EQ(DNSClient::SUCCESS, callback2.status_);
+        ASSERT_TRUE(response2);
+        EXPECT_EQ(D2UpdateMessage::RESPONSE, response2->getQRFlag());
+        EXPECT_EQ("example.org.", response2->getZone()->getName().toText());
+
+        // The connection assigned different IDs to the updates.
+        EXPECT_NE(response1->getId(), response2->getId());
+
+        // Both updates were sent over the same connection.
+        EXPECT_EQ(1, server.getAccepted());
+        DNSTCPConnectionPool& pool =
+            asio::use_service<DNSTCPConnectionPool>(service_.
+                                                    get_io_service());
+        EXPECT_EQ(1, pool.getConnectionCount());
+        DNSTCPConnectionPtr connection =
+            pool.getConnection(IOAddress(TEST_ADDRESS), TEST_PORT);
+        EXPECT_EQ(1, connection->getConnectCount());
+        EXPECT_EQ(0, connection->getPendingCount());
+    }
+
+    // This test verifies that an update sent over TCP fails when the
+    // connection to the server can't be established.
+    void runTCPConnectionRefusedTest() {
+        D2UpdateMessage message(D2UpdateMessage::OUTBOUND);
+        ASSERT_NO_THROW(message.setZone(Name("example.com"), RRClass::IN()));
+
+        int completed = 0;
+        D2UpdateMessagePtr response;
+        TCPCallback callback(service_, completed, 1);
+        DNSClient client(response, &callback, DNSClient::TCP);
+
+        // No server listens on the test port, so the connection is refused
+        // well before the timeout. It is reported as an I/O error, not as a
+        // timeout, which would make D2UpdateMgr lower its concurrency limit.
+        client.doUpdate(service_, IOAddress(TEST_ADDRESS), TEST_PORT, message,
+                        TEST_TIMEOUT);
+        service_.run();
+        service_.get_io_service().reset();
+
+        ASSERT_TRUE(callback.called_);
+        EXPECT_EQ(DNSClient::OTHER, callback.status_);
+        EXPECT_FALSE(response);
+    }
+
+    // This test verifies that a connection refuses an update once all the
+    // message IDs are held by the updates awaiting a response.
+    void runTCPPendingLimitTest() {
+        D2UpdateMessage message(D2UpdateMessage::OUTBOUND);
+        ASSERT_NO_THROW(message.setZone(Name("example.com"), RRClass::IN()));
+        dns::MessageRenderer renderer;
+        OutputBufferPtr msg_buf(new OutputBuffer(512));
+        renderer.setBuffer(msg_buf.get());
+        message.toWire(renderer);
+
+        // The IO service is not run, so none of the updates completes and
+        // the callback is never invoked.
+        DNSTCPConnectionPtr connection(
+            new DNSTCPConnection(service_.get_io_service(),
+                                 IOAddress(TEST_ADDRESS), TEST_PORT));
+        OutputBufferPtr in_buf(new OutputBuffer(512));
+        std::set<uint16_t> ids;
+        for (size_t i = 0; i < DNSTCPConnection::MAX_PENDING; ++i) {
+            ids.insert(connection->send(msg_buf, in_buf, NULL, TEST_TIMEOUT));
+        }
+        EXPECT_EQ(DNSTCPConnection::MAX_PENDING, ids.size());
+        EXPECT_EQ(DNSTCPConnection::MAX_PENDING,
+                  connection->getPendingCount());
+        EXPECT_THROW(connection->send(msg_buf, in_buf, NULL, TEST_TIMEOUT),
+                     isc::Unexpected);
+
+        // Cancelling one update frees its ID for the next one.
+        connection->cancel(*ids.begin());
+        EXPECT_EQ(*ids.begin(),
+                  connection->send(msg_buf, in_buf, NULL, TEST_TIMEOUT));
+    }
 };
 
 // Verify that the DNSClient object can be created if provided parameters are
@@ -416,6 +645,24 @@ TEST_F(DNSClientTest, sendReceiveTwice) {
     EXPECT_EQ(2, received_);
 }
 
+// Verify that the updates sent over TCP are pipelined over one connection
+// and the responses, received in any order, are matched to the updates.
+TEST_F(DNSClientTest, tcpPipeline) {
+    runTCPPipelineTest();
+}
+
+// Verify that a timeout is reported when the TCP connection to the server
+// can't be established.
+TEST_F(DNSClientTest, tcpConnectionRefused) {
+    runTCPConnectionRefusedTest();
+}
+
+// Verify that an update is refused rather than given the ID of another one
+// when all the IDs are in use on a TCP connection.
+TEST_F(DNSClientTest, tcpPendingLimit) {
+    runTCPPendingLimitTest();
+}
+
 // Verify that it is possible to use the DNSClient instance to perform the
 // following  sequence of message exchanges:
 // 1. send
@@ -14,6 +14,7 @@
 
 #include <config/ccsession.h>
 #include <dhcp4/dhcp4_log.h>
+#include <dhcp4/dhcp4_srv.h>
 #include <dhcp/libdhcp++.h>
 #include <dhcp/option_definition.h>
 #include <dhcpsrv/cfgmgr.h>
@@ -183,6 +184,10 @@ public:
                 sub4ptr->setRelayInfo(*relay_info_);
             }
 
+            // The configured options are sent as they are, so they are
+            // converted to the on-wire format only once.
+            sub4ptr->precompileOptions();
+
             isc::dhcp::CfgMgr::instance().addSubnet4(sub4ptr);
         }
     }
@@ -355,6 +360,8 @@ public:
             subnet->commit();
         }
 
+        // Rebuild the index used for the subnet selection.
+        CfgMgr::instance().indexSubnets4();
     }
 
     /// @brief Returns Subnet4ListConfigParser object
@@ -387,7 +394,10 @@ DhcpConfigParser* createGlobalDhcp4ConfigParser(const std::string& config_id) {
     DhcpConfigParser* parser = NULL;
     if ((config_id.compare("valid-lifetime") == 0)  ||
         (config_id.compare("renew-timer") == 0)  ||
-        (config_id.compare("rebind-timer") == 0))  {
+        (config_id.compare("rebind-timer") == 0) ||
+        (config_id.compare("reclaim-timer-wait-time") == 0) ||
+        (config_id.compare("max-reclaim-leases") == 0) ||
+        (config_id.compare("max-reclaim-time") == 0))  {
         parser = new Uint32Parser(config_id,
                                  globalContext()->uint32_values_);
     } else if (config_id.compare("interfaces") == 0) {
@@ -403,14 +413,16 @@ DhcpConfigParser* createGlobalDhcp4ConfigParser(const std::string& config_id) {
         parser  = new OptionDefListParser(config_id,
                                           globalContext()->option_defs_);
     } else if ((config_id.compare("version") == 0) ||
-               (config_id.compare("next-server") == 0)) {
+               (config_id.compare("next-server") == 0) ||
+               (config_id.compare("allocator") == 0)) {
         parser  = new StringParser(config_id,
                                     globalContext()->string_values_);
     } else if (config_id.compare("lease-database") == 0) {
         parser = new DbAccessParser(config_id);
     } else if (config_id.compare("hooks-libraries") == 0) {
         parser = new HooksLibrariesParser(config_id);
-    } else if (config_id.compare("echo-client-id") == 0) {
+    } else if ((config_id.compare("echo-client-id") == 0) ||
+               (config_id.compare("track-pool-usage") == 0)) {
         parser = new BooleanParser(config_id, globalContext()->boolean_values_);
     } else if (config_id.compare("dhcp-ddns") == 0) {
         parser = new D2ClientConfigParser(config_id);
@@ -438,7 +450,7 @@ void commitGlobalOptions() {
 }
 
 isc::data::ConstElementPtr
-configureDhcp4Server(Dhcpv4Srv&, isc::data::ConstElementPtr config_set) {
+configureDhcp4Server(Dhcpv4Srv& server, isc::data::ConstElementPtr config_set) {
     if (!config_set) {
         ConstElementPtr answer = isc::config::createAnswer(1,
                                  string("Can't parse NULL config"));
@@ -490,6 +502,8 @@ configureDhcp4Server(Dhcpv4Srv&, isc::data::ConstElementPtr config_set) {
     // the parsers.  It is declared outside the loops so in case of an error,
     // the name of the failing parser can be retrieved in the "catch" clause.
     ConfigPair config_pair;
+    // The address allocation algorithm.
+    AllocEngine::AllocType alloc_type = AllocEngine::ALLOC_ITERATIVE;
     try {
         // Make parsers grouping.
         const std::map<std::string, ConstElementPtr>& values_map =
@@ -540,6 +554,11 @@ configureDhcp4Server(Dhcpv4Srv&, isc::data::ConstElementPtr config_set) {
             subnet_parser->build(subnet_config->second);
         }
 
+        // Check the allocation algorithm before anything is committed.
+        config_pair = ConfigPair("allocator", ConstElementPtr());
+        alloc_type = AllocEngine::allocTypeFromText(globalContext()->
+            string_values_->getOptionalParam("allocator", "iterative"));
+
     } catch (const isc::Exception& ex) {
         LOG_ERROR(dhcp4_logger, DHCP4_PARSER_FAIL)
                   .arg(config_pair.first).arg(ex.what());
@@ -573,6 +592,17 @@ configureDhcp4Server(Dhcpv4Srv&, isc::data::ConstElementPtr config_set) {
                 iface_parser->commit();
             }
 
+            // Switch to the configured allocation algorithm.
+            server.setAllocType(alloc_type);
+            server.setPoolTracking(globalContext()->boolean_values_->
+                getOptionalParam("track-pool-usage", false));
+            server.setLeaseReclamation(globalContext()->uint32_values_->
+                getOptionalParam("reclaim-timer-wait-time", 10),
+                globalContext()->uint32_values_->
+                getOptionalParam("max-reclaim-leases", 100),
+                globalContext()->uint32_values_->
+                getOptionalParam("max-reclaim-time", 250));
+
             // Apply global options
             commitGlobalOptions();
 
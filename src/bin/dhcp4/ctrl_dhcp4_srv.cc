@@ -23,14 +23,17 @@
 #include <dhcp4/ctrl_dhcp4_srv.h>
 #include <dhcp4/dhcp4_log.h>
 #include <dhcp4/spec_config.h>
+#include <dhcpsrv/callout_handle_store.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcp_config_parser.h>
 #include <exceptions/exceptions.h>
 #include <hooks/hooks_manager.h>
 #include <util/buffer.h>
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -48,6 +51,51 @@ using namespace std;
 namespace isc {
 namespace dhcp {
 
+namespace {
+
+/// @brief Appends the usage of the subnet pools to the list.
+///
+/// @param stats list the pool usage maps are appended to
+/// @param subnet subnet which pools are reported
+/// @param type type of the pools
+void
+addPoolStats(const ElementPtr& stats, const SubnetPtr& subnet,
+             const Lease::Type type) {
+    const PoolCollection& pools = subnet->getPools(type);
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        const uint64_t capacity =
+            std::min((*pool)->getCapacity(),
+                     static_cast<uint64_t>(std::numeric_limits<int64_t>::max()));
+        ElementPtr pool_stats = Element::createMap();
+        pool_stats->set("subnet", Element::create(subnet->toText()));
+        pool_stats->set("pool", Element::create((*pool)->toText()));
+        pool_stats->set("capacity",
+                        Element::create(static_cast<long long int>(capacity)));
+        pool_stats->set("tracked",
+                        Element::create((*pool)->isUsageTracked()));
+        pool_stats->set("used", Element::create(static_cast<long long int>(
+                        (*pool)->getUsedCount())));
+        stats->add(pool_stats);
+    }
+}
+
+/// @brief Returns the usage of all configured pools.
+///
+/// @return list of maps holding the usage of each pool
+ElementPtr
+getPoolStats() {
+    ElementPtr stats = Element::createList();
+    const Subnet4Collection* subnets = CfgMgr::instance().getSubnets4();
+    for (Subnet4Collection::const_iterator subnet = subnets->begin();
+         subnet != subnets->end(); ++subnet) {
+        addPoolStats(stats, *subnet, Lease::TYPE_V4);
+    }
+    return (stats);
+}
+
+}; // anonymous namespace
+
 ControlledDhcpv4Srv* ControlledDhcpv4Srv::server_ = NULL;
 
 ConstElementPtr
@@ -88,6 +136,10 @@ ControlledDhcpv4Srv::dhcp4ConfigHandler(ConstElementPtr new_config) {
     // In order to work around this problem we need to merge the new
     // configuration with the existing (full) configuration.
 
+    // The packets being processed by the worker threads use the current
+    // configuration, so wait until they are done with it.
+    server_->waitForPendingPackets();
+
     // Let's create a new object that will hold the merged configuration.
     boost::shared_ptr<MapElement> merged_config(new MapElement());
     // Let's get the existing configuration.
@@ -157,7 +209,14 @@ ControlledDhcpv4Srv::dhcp4CommandHandler(const string& command, ConstElementPtr
         return (answer);
 
     } else if (command == "libreload") {
-        // TODO delete any stored CalloutHandles referring to the old libraries
+        // The worker threads may be executing the callouts, so wait until
+        // they are done before unloading the libraries.
+        if (ControlledDhcpv4Srv::server_) {
+            ControlledDhcpv4Srv::server_->waitForPendingPackets();
+        }
+        // Delete the stored CalloutHandles referring to the old libraries,
+        // so as the libraries are actually unloaded.
+        CalloutHandleStore<Pkt4Ptr>::clearAll();
         // Get list of currently loaded libraries and reload them.
         vector<string> loaded = HooksManager::getLibraryNames();
         bool status = HooksManager::loadLibraries(loaded);
@@ -170,6 +229,9 @@ ControlledDhcpv4Srv::dhcp4CommandHandler(const string& command, ConstElementPtr
         ConstElementPtr answer = isc::config::createAnswer(0,
                                  "Hooks libraries successfully reloaded.");
         return (answer);
+
+    } else if (command == "pool-stats") {
+        return (isc::config::createAnswer(0, getPoolStats()));
     }
 
     ConstElementPtr answer = isc::config::createAnswer(1,
@@ -17,6 +17,7 @@
 #include <dhcp/duid.h>
 #include <dhcp/hwaddr.h>
 #include <dhcp/iface_mgr.h>
+#include <dhcp/libdhcp++.h>
 #include <dhcp/option4_addrlst.h>
 #include <dhcp/option_int.h>
 #include <dhcp/option_int_array.h>
@@ -41,7 +42,9 @@
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
 #include <iomanip>
+#include <limits>
 
 using namespace isc;
 using namespace isc::asiolink;
@@ -49,9 +52,10 @@ using namespace isc::dhcp;
 using namespace isc::dhcp_ddns;
 using namespace isc::hooks;
 using namespace isc::log;
+using namespace isc::util::thread;
 using namespace std;
 
-/// Structure that holds registered hook indexes
+/// Structure that holds registered hook and callout argument indexes
 struct Dhcp4Hooks {
     int hook_index_buffer4_receive_;///< index for "buffer4_receive" hook point
     int hook_index_pkt4_receive_;   ///< index for "pkt4_receive" hook point
@@ -59,8 +63,13 @@ struct Dhcp4Hooks {
     int hook_index_lease4_release_; ///< index for "lease4_release" hook point
     int hook_index_pkt4_send_;      ///< index for "pkt4_send" hook point
     int hook_index_buffer4_send_;   ///< index for "buffer4_send" hook point
+    int arg_index_query4_;            ///< index of the "query4" argument
+    int arg_index_response4_;         ///< index of the "response4" argument
+    int arg_index_lease4_;            ///< index of the "lease4" argument
+    int arg_index_subnet4_;           ///< index of the "subnet4" argument
+    int arg_index_subnet4collection_; ///< index of the "subnet4collection" argument
 
-    /// Constructor that registers hook points for DHCPv4 engine
+    /// Constructor that registers hook points and arguments for DHCPv4 engine
     Dhcp4Hooks() {
         hook_index_buffer4_receive_= HooksManager::registerHook("buffer4_receive");
         hook_index_pkt4_receive_   = HooksManager::registerHook("pkt4_receive");
@@ -68,6 +77,12 @@ struct Dhcp4Hooks {
         hook_index_pkt4_send_      = HooksManager::registerHook("pkt4_send");
         hook_index_lease4_release_ = HooksManager::registerHook("lease4_release");
         hook_index_buffer4_send_   = HooksManager::registerHook("buffer4_send");
+
+        arg_index_query4_            = HooksManager::registerArgument("query4");
+        arg_index_response4_         = HooksManager::registerArgument("response4");
+        arg_index_lease4_            = HooksManager::registerArgument("lease4");
+        arg_index_subnet4_           = HooksManager::registerArgument("subnet4");
+        arg_index_subnet4collection_ = HooksManager::registerArgument("subnet4collection");
     }
 };
 
@@ -77,16 +92,38 @@ struct Dhcp4Hooks {
 // module is called.
 Dhcp4Hooks Hooks;
 
+namespace {
+
+/// @brief Logs the failure of the asynchronous update of the lease with
+/// the hostname generated by the server.
+///
+/// @param write executed update
+void
+nameUpdateDone(const LeaseWrite& write) {
+    if (!write.result_) {
+        LOG_ERROR(dhcp4_logger, DHCP4_NAME_GEN_UPDATE_FAIL).arg(write.error_);
+    }
+}
+
+}
+
 namespace isc {
 namespace dhcp {
 
 const std::string Dhcpv4Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 
+const size_t Dhcpv4Srv::DEFAULT_QUEUE_SIZE;
+const size_t Dhcpv4Srv::LEASE_WRITE_BATCH_SIZE;
+
 Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
                      const bool direct_response_desired)
-: shutdown_(true), alloc_engine_(), port_(port),
+: shutdown_(true), alloc_engine_(),
+    alloc_type_(AllocEngine::ALLOC_ITERATIVE), port_(port),
     use_bcast_(use_bcast), hook_index_pkt4_receive_(-1),
-    hook_index_subnet4_select_(-1), hook_index_pkt4_send_(-1) {
+    hook_index_subnet4_select_(-1), hook_index_pkt4_send_(-1), workers_(0),
+    queue_size_(DEFAULT_QUEUE_SIZE), reclaim_interval_(0),
+    max_reclaim_leases_(0), max_reclaim_time_(0), next_reclaim_(0),
+    next_received_(0) {
 
     LOG_DEBUG(dhcp4_logger, DBG_DHCP4_START, DHCP4_OPEN_SOCKET).arg(port);
     try {
@@ -119,8 +156,7 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
             .arg(LeaseMgrFactory::instance().getName());
 
         // Instantiate allocation engine
-        alloc_engine_.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100,
-                                            false /* false = IPv4 */));
+        setAllocType(AllocEngine::ALLOC_ITERATIVE);
 
         // Register hook points
         hook_index_pkt4_receive_   = Hooks.hook_index_pkt4_receive_;
@@ -150,7 +186,20 @@ Dhcpv4Srv::shutdown() {
 
 Pkt4Ptr
 Dhcpv4Srv::receivePacket(int timeout) {
-    return (IfaceMgr::instance().receive4(timeout));
+    if (next_received_ >= received_.size()) {
+        received_.clear();
+        next_received_ = 0;
+        IfaceMgr::instance().receiveBatch4(received_, RECEIVE_BATCH_SIZE,
+                                           timeout);
+        if (received_.empty()) {
+            return (Pkt4Ptr());
+        }
+    }
+    // Don't hold the reference to the packet, so as it is released as soon
+    // as it has been processed.
+    Pkt4Ptr query;
+    query.swap(received_[next_received_++]);
+    return (query);
 }
 
 void
@@ -158,16 +207,33 @@ Dhcpv4Srv::sendPacket(const Pkt4Ptr& packet) {
     IfaceMgr::instance().send(packet);
 }
 
+void
+Dhcpv4Srv::sendPackets(const std::vector<Pkt4Ptr>& packets) {
+    // The packets which can't be sent are skipped by the IfaceMgr, so as
+    // they don't cause the loss of the whole batch. Log why each of them
+    // has not been sent.
+    std::vector<std::string> errors;
+    IfaceMgr::instance().sendBatch(packets, errors);
+    for (std::vector<std::string>::const_iterator error = errors.begin();
+         error != errors.end(); ++error) {
+        LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL).arg(*error);
+    }
+}
+
 bool
 Dhcpv4Srv::run() {
+    // Start the worker threads if the server has been configured to process
+    // packets concurrently.
+    if (workers_ > 0) {
+        startPipeline();
+    }
+
     while (!shutdown_) {
-        /// @todo: calculate actual timeout once we have lease database
-        //cppcheck-suppress variableScope This is temporary anyway
-        const int timeout = 1000;
+        // Wait for the packets until the next lease reclamation cycle.
+        const int timeout = std::min<uint32_t>(1000, reclaimExpiredLeases());
 
-        // client's message and server's response
+        // client's message
         Pkt4Ptr query;
-        Pkt4Ptr rsp;
 
         try {
             query = receivePacket(timeout);
@@ -181,252 +247,436 @@ Dhcpv4Srv::run() {
             continue;
         }
 
-        // In order to parse the DHCP options, the server needs to use some
-        // configuration information such as: existing option spaces, option
-        // definitions etc. This is the kind of information which is not
-        // available in the libdhcp, so we need to supply our own implementation
-        // of the option parsing function here, which would rely on the
-        // configuration data.
-        query->setCallback(boost::bind(&Dhcpv4Srv::unpackOptions, this,
-                                       _1, _2, _3));
+        // Hand the packet over to the workers. If they can't keep up with
+        // the incoming traffic, the packet is dropped.
+        if (pipeline_) {
+            if (!pipeline_->push(query)) {
+                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                          DHCP4_PACKET_QUEUE_FULL)
+                    .arg(query->getRemoteAddr().toText())
+                    .arg(query->getIface());
+            }
+            continue;
+        }
 
-        bool skip_unpack = false;
+        Pkt4Ptr rsp = processPacket(query);
+        if (rsp) {
+            sendResponse(rsp);
+        }
+    }
 
-        // The packet has just been received so contains the uninterpreted wire
-        // data; execute callouts registered for buffer4_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    // Process the packets still held in the queue, write their leases and
+    // send the responses before the workers and the sender are stopped.
+    if (pipeline_) {
+        pipeline_->wait();
+        async_lease_mgr_->stop();
+    }
+    pipeline_.reset();
+    async_lease_mgr_.reset();
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC, DHCP4_RESPONSE_POOL_STATS)
+        .arg(response_pool_.getAllocated()).arg(response_pool_.getReused());
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query4", query);
+    return (true);
+}
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_buffer4_receive_,
-                                       *callout_handle);
+void
+Dhcpv4Srv::setWorkerThreads(const size_t workers, const size_t queue_size) {
+    if (pipeline_) {
+        isc_throw(InvalidOperation, "unable to change the number of worker"
+                  " threads while the server is running");
+    } else if (queue_size == 0) {
+        isc_throw(BadValue, "size of the packet queue must be greater than 0");
+    }
+    workers_ = workers;
+    queue_size_ = queue_size;
+}
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to parse the packet, so skip at this
-            // stage means that callouts did the parsing already, so server
-            // should skip parsing.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_BUFFER_RCVD_SKIP);
-                skip_unpack = true;
-            }
+void
+Dhcpv4Srv::waitForPendingPackets() {
+    if (pipeline_) {
+        // The responses are handed over to the sender when the leases have
+        // been written, i.e. after the workers have processed the packets.
+        pipeline_->wait();
+        async_lease_mgr_->wait();
+        pipeline_->wait();
+    }
+}
 
-            callout_handle->getArgument("query4", query);
-        }
+void
+Dhcpv4Srv::setAllocType(const AllocEngine::AllocType alloc_type) {
+    if (alloc_engine_ && (alloc_type == alloc_type_)) {
+        return;
+    }
+    const bool track = alloc_engine_ && alloc_engine_->getPoolTracking();
+    alloc_engine_.reset(new AllocEngine(alloc_type, 100,
+                                        false /* false = IPv4 */));
+    alloc_engine_->setPoolTracking(track);
+    alloc_type_ = alloc_type;
+}
 
-        // Unpack the packet information unless the buffer4_receive callouts
-        // indicated they did it
-        if (!skip_unpack) {
-            try {
-                query->unpack();
-            } catch (const std::exception& e) {
-                // Failed to parse the packet.
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
-                          DHCP4_PACKET_PARSE_FAIL).arg(e.what());
-                continue;
+void
+Dhcpv4Srv::setLeaseReclamation(const uint32_t interval,
+                               const uint32_t max_leases,
+                               const uint32_t max_time) {
+    reclaim_interval_ = interval;
+    max_reclaim_leases_ = max_leases;
+    max_reclaim_time_ = max_time;
+    next_reclaim_ = time(NULL) + interval;
+}
+
+uint32_t
+Dhcpv4Srv::reclaimExpiredLeases() {
+    if (reclaim_interval_ == 0) {
+        return (std::numeric_limits<uint32_t>::max());
+    }
+
+    time_t now = time(NULL);
+    if (now >= next_reclaim_) {
+        // The reclamation may run concurrently with the packet processing:
+        // it locks the subnet of each reclaimed lease, as the allocations
+        // do.
+        try {
+            AllocEngine::Lease4ReclaimCallback callback;
+            if (CfgMgr::instance().ddnsEnabled()) {
+                callback = boost::bind(&Dhcpv4Srv::queueNameChangeRequest,
+                                       this, isc::dhcp_ddns::CHG_REMOVE, _1);
             }
+            alloc_engine_->reclaimExpiredLeases4(max_reclaim_leases_,
+                                                 max_reclaim_time_, callback);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcp4_logger, DHCP4_RECLAIM_LEASES_FAIL).arg(ex.what());
         }
+        now = time(NULL);
+        next_reclaim_ = now + reclaim_interval_;
+    }
+    return (next_reclaim_ - now);
+}
 
-        // Assign this packet to one or more classes if needed. We need to do
-        // this before calling accept(), because getSubnet4() may need client
-        // class information.
-        classifyPacket(query);
+void
+Dhcpv4Srv::startPipeline() {
+    // The standard option definitions are created on first use. Make sure
+    // it happens before the workers may use them concurrently.
+    LibDHCP::getOptionDefs(Option::V4);
+    LibDHCP::getVendorOption4Defs(VENDOR_ID_CABLE_LABS);
+
+    LOG_INFO(dhcp4_logger, DHCP4_PIPELINE_START).arg(workers_).arg(queue_size_);
+    async_lease_mgr_.reset(new AsyncLeaseMgr(queue_size_,
+                                             LEASE_WRITE_BATCH_SIZE));
+    pipeline_.reset(new PacketPipeline<Pkt4Ptr>(workers_, queue_size_,
+        boost::bind(&Dhcpv4Srv::processPacket, this, _1),
+        boost::bind(&Dhcpv4Srv::sendResponses, this, _1)));
+}
 
-        // Check whether the message should be further processed or discarded.
-        // There is no need to log anything here. This function logs by itself.
-        if (!accept(query)) {
-            continue;
-        }
+void
+Dhcpv4Srv::leasesCommitted(const Pkt4Ptr& rsp, const bool success) {
+    if (!success) {
+        LOG_ERROR(dhcp4_logger, DHCP4_LEASE_COMMIT_FAIL)
+            .arg(rsp->getYiaddr().toText())
+            .arg(rsp->getTransid());
+        return;
+    }
+    pipeline_->send(rsp);
+}
 
-        // We have sanity checked (in accept() that the Message Type option
-        // exists, so we can safely get it here.
-        int type = query->getType();
-        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_RECEIVED)
-            .arg(serverReceivedPacketName(type))
-            .arg(type)
-            .arg(query->getIface());
-        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_QUERY_DATA)
-            .arg(type)
-            .arg(query->toText());
+Pkt4Ptr
+Dhcpv4Srv::processPacket(Pkt4Ptr query) {
+    // client's message and server's response
+    Pkt4Ptr rsp;
 
-        // Let's execute all callouts registered for pkt4_receive
-        if (HooksManager::calloutsPresent(hook_index_pkt4_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    // Lease writes made while processing the packet by the worker.
+    LeaseCommitPtr commit;
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+    // Specifies if server should do the packing
+    bool skip_pack = false;
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query4", query);
+    // In order to parse the DHCP options, the server needs to use some
+    // configuration information such as: existing option spaces, option
+    // definitions etc. This is the kind of information which is not
+    // available in the libdhcp, so we need to supply our own implementation
+    // of the option parsing function here, which would rely on the
+    // configuration data.
+    query->setCallback(boost::bind(&Dhcpv4Srv::unpackOptions, this,
+                                   _1, _2, _3));
 
-            // Call callouts
-            HooksManager::callCallouts(hook_index_pkt4_receive_,
-                                       *callout_handle);
+    bool skip_unpack = false;
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to process the packet, so skip at this
-            // stage means drop.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_RCVD_SKIP);
-                continue;
-            }
+    // The packet has just been received so contains the uninterpreted wire
+    // data; execute callouts registered for buffer4_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
+
+        // Pass incoming packet as argument
+        callout_handle->setArgument(Hooks.arg_index_query4_, query);
+
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_buffer4_receive_,
+                                   *callout_handle);
 
-            callout_handle->getArgument("query4", query);
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to parse the packet, so skip at this
+        // stage means that callouts did the parsing already, so server
+        // should skip parsing.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_BUFFER_RCVD_SKIP);
+            skip_unpack = true;
         }
 
+        callout_handle->getArgument(Hooks.arg_index_query4_, query);
+    }
+
+    // Unpack the packet information unless the buffer4_receive callouts
+    // indicated they did it
+    if (!skip_unpack) {
         try {
-            switch (query->getType()) {
-            case DHCPDISCOVER:
-                rsp = processDiscover(query);
-                break;
-
-            case DHCPREQUEST:
-                // Note that REQUEST is used for many things in DHCPv4: for
-                // requesting new leases, renewing existing ones and even
-                // for rebinding.
-                rsp = processRequest(query);
-                break;
-
-            case DHCPRELEASE:
-                processRelease(query);
-                break;
-
-            case DHCPDECLINE:
-                processDecline(query);
-                break;
-
-            case DHCPINFORM:
-                processInform(query);
-                break;
-
-            default:
-                // Only action is to output a message if debug is enabled,
-                // and that is covered by the debug statement before the
-                // "switch" statement.
-                ;
+            query->unpack();
+        } catch (const std::exception& e) {
+            // Failed to parse the packet.
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                      DHCP4_PACKET_PARSE_FAIL).arg(e.what());
+            return (Pkt4Ptr());
+        }
+    }
+
+    // Assign this packet to one or more classes if needed. We need to do
+    // this before calling accept(), because getSubnet4() may need client
+    // class information.
+    classifyPacket(query);
+
+    // Check whether the message should be further processed or discarded.
+    // There is no need to log anything here. This function logs by itself.
+    if (!accept(query)) {
+        return (Pkt4Ptr());
+    }
+
+    // We have sanity checked (in accept() that the Message Type option
+    // exists, so we can safely get it here.
+    int type = query->getType();
+    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_RECEIVED)
+        .arg(serverReceivedPacketName(type))
+        .arg(type)
+        .arg(query->getIface());
+    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_QUERY_DATA)
+        .arg(type)
+        .arg(query->toText());
+
+    // Let's execute all callouts registered for pkt4_receive
+    if (HooksManager::calloutsPresent(hook_index_pkt4_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
+
+        // Pass incoming packet as argument
+        callout_handle->setArgument(Hooks.arg_index_query4_, query);
+
+        // Call callouts
+        HooksManager::callCallouts(hook_index_pkt4_receive_,
+                                   *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to process the packet, so skip at this
+        // stage means drop.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_RCVD_SKIP);
+            return (Pkt4Ptr());
+        }
+
+        callout_handle->getArgument(Hooks.arg_index_query4_, query);
+    }
+
+    try {
+        switch (query->getType()) {
+        case DHCPDISCOVER:
+            rsp = processDiscover(query);
+            break;
+
+        case DHCPREQUEST:
+            // Note that REQUEST is used for many things in DHCPv4: for
+            // requesting new leases, renewing existing ones and even
+            // for rebinding. The workers write the leases asynchronously.
+            if (async_lease_mgr_) {
+                commit.reset(new LeaseCommit(*async_lease_mgr_));
             }
-        } catch (const isc::Exception& e) {
-
-            // Catch-all exception (at least for ones based on the isc
-            // Exception class, which covers more or less all that
-            // are explicitly raised in the BIND 10 code).  Just log
-            // the problem and ignore the packet. (The problem is logged
-            // as a debug message because debug is disabled by default -
-            // it prevents a DDOS attack based on the sending of problem
-            // packets.)
-            if (dhcp4_logger.isDebugEnabled(DBG_DHCP4_BASIC)) {
-                std::string source = "unknown";
-                HWAddrPtr hwptr = query->getHWAddr();
-                if (hwptr) {
-                    source = hwptr->toText();
-                }
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC,
-                          DHCP4_PACKET_PROCESS_FAIL)
-                    .arg(source).arg(e.what());
+            rsp = processRequest(query, commit);
+            break;
+
+        case DHCPRELEASE:
+            processRelease(query);
+            break;
+
+        case DHCPDECLINE:
+            processDecline(query);
+            break;
+
+        case DHCPINFORM:
+            processInform(query);
+            break;
+
+        default:
+            // Only action is to output a message if debug is enabled,
+            // and that is covered by the debug statement before the
+            // "switch" statement.
+            ;
+        }
+    } catch (const isc::Exception& e) {
+
+        // Catch-all exception (at least for ones based on the isc
+        // Exception class, which covers more or less all that
+        // are explicitly raised in the BIND 10 code).  Just log
+        // the problem and ignore the packet. (The problem is logged
+        // as a debug message because debug is disabled by default -
+        // it prevents a DDOS attack based on the sending of problem
+        // packets.)
+        if (dhcp4_logger.isDebugEnabled(DBG_DHCP4_BASIC)) {
+            std::string source = "unknown";
+            HWAddrPtr hwptr = query->getHWAddr();
+            if (hwptr) {
+                source = hwptr->toText();
             }
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC,
+                      DHCP4_PACKET_PROCESS_FAIL)
+                .arg(source).arg(e.what());
         }
+    }
 
-        if (!rsp) {
-            continue;
-        }
+    if (!rsp) {
+        return (Pkt4Ptr());
+    }
 
-        // Let's do class specific processing. This is done before
-        // pkt4_send.
-        //
-        /// @todo: decide whether we want to add a new hook point for
-        /// doing class specific processing.
-        if (!classSpecificProcessing(query, rsp)) {
-            /// @todo add more verbosity here
-            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC, DHCP4_CLASS_PROCESSING_FAILED);
+    // Let's do class specific processing. This is done before
+    // pkt4_send.
+    //
+    /// @todo: decide whether we want to add a new hook point for
+    /// doing class specific processing.
+    if (!classSpecificProcessing(query, rsp)) {
+        /// @todo add more verbosity here
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC, DHCP4_CLASS_PROCESSING_FAILED);
 
-            continue;
+        return (Pkt4Ptr());
+    }
+
+    // Execute all callouts registered for pkt4_send
+    if (HooksManager::calloutsPresent(hook_index_pkt4_send_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete all previous arguments
+        callout_handle->deleteAllArguments();
+
+        // Clear skip flag if it was set in previous callouts
+        callout_handle->setSkip(false);
+
+        // Set our response
+        callout_handle->setArgument(Hooks.arg_index_response4_, rsp);
+
+        // Call all installed callouts
+        HooksManager::callCallouts(hook_index_pkt4_send_,
+                                   *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to send the packet, so skip at this
+        // stage means "drop response".
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_SEND_SKIP);
+            skip_pack = true;
         }
+    }
 
-        // Specifies if server should do the packing
-        bool skip_pack = false;
+    // The callouts of any hook library may hold and modify the configured
+    // options included in the response, e.g. through the subnet. Their
+    // precompiled data are only copied when no hook library is loaded.
+    if (HooksManager::getLibraryNames().empty()) {
+        rsp->setUsePrecompiled(true);
+    }
 
-        // Execute all callouts registered for pkt4_send
-        if (HooksManager::calloutsPresent(hook_index_pkt4_send_)) {
+    if (!skip_pack) {
+        try {
+            rsp->pack();
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+                .arg(e.what());
+        }
+    }
+
+    // Now all fields and options are constructed into output wire buffer.
+    // Option objects modification does not make sense anymore. Hooks
+    // can only manipulate wire buffer at this stage.
+    // Let's execute all callouts registered for buffer4_send
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_send_)) {
+        try {
             CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Delete all previous arguments
+            // Delete previously set arguments
             callout_handle->deleteAllArguments();
 
-            // Clear skip flag if it was set in previous callouts
-            callout_handle->setSkip(false);
-
-            // Set our response
-            callout_handle->setArgument("response4", rsp);
+            // Pass incoming packet as argument
+            callout_handle->setArgument(Hooks.arg_index_response4_, rsp);
 
-            // Call all installed callouts
-            HooksManager::callCallouts(hook_index_pkt4_send_,
+            // Call callouts
+            HooksManager::callCallouts(Hooks.hook_index_buffer4_send_,
                                        *callout_handle);
 
             // Callouts decided to skip the next processing step. The next
-            // processing step would to send the packet, so skip at this
-            // stage means "drop response".
+            // processing step would to parse the packet, so skip at this
+            // stage means drop.
             if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_SEND_SKIP);
-                skip_pack = true;
+                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS,
+                          DHCP4_HOOK_BUFFER_SEND_SKIP);
+                return (Pkt4Ptr());
             }
-        }
 
-        if (!skip_pack) {
-            try {
-                rsp->pack();
-            } catch (const std::exception& e) {
-                LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
-                    .arg(e.what());
-            }
+            callout_handle->getArgument(Hooks.arg_index_response4_, rsp);
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+                .arg(e.what());
+            return (Pkt4Ptr());
         }
+    }
 
-        try {
-            // Now all fields and options are constructed into output wire buffer.
-            // Option objects modification does not make sense anymore. Hooks
-            // can only manipulate wire buffer at this stage.
-            // Let's execute all callouts registered for buffer4_send
-            if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_send_)) {
-                CalloutHandlePtr callout_handle = getCalloutHandle(query);
-
-                // Delete previously set arguments
-                callout_handle->deleteAllArguments();
-
-                // Pass incoming packet as argument
-                callout_handle->setArgument("response4", rsp);
-
-                // Call callouts
-                HooksManager::callCallouts(Hooks.hook_index_buffer4_send_,
-                                           *callout_handle);
-
-                // Callouts decided to skip the next processing step. The next
-                // processing step would to parse the packet, so skip at this
-                // stage means drop.
-                if (callout_handle->getSkip()) {
-                    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS,
-                              DHCP4_HOOK_BUFFER_SEND_SKIP);
-                    continue;
-                }
+    // The response is sent when the leases have been written, so as the
+    // client doesn't use the lease which may not be stored.
+    if (commit && (commit->getPending() > 0)) {
+        commit->close(boost::bind(&Dhcpv4Srv::leasesCommitted, this, rsp,
+                                  _1));
+        return (Pkt4Ptr());
+    }
 
-                callout_handle->getArgument("response4", rsp);
-            }
+    return (rsp);
+}
 
+void
+Dhcpv4Srv::sendResponse(const Pkt4Ptr& rsp) {
+    try {
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA,
+                  DHCP4_RESPONSE_DATA)
+            .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+
+        sendPacket(rsp);
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+            .arg(e.what());
+    }
+}
+
+void
+Dhcpv4Srv::sendResponses(const std::vector<Pkt4Ptr>& rsps) {
+    try {
+        for (std::vector<Pkt4Ptr>::const_iterator rsp = rsps.begin();
+             rsp != rsps.end(); ++rsp) {
             LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA,
                       DHCP4_RESPONSE_DATA)
-                .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
-
-            sendPacket(rsp);
-        } catch (const std::exception& e) {
-            LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
-                .arg(e.what());
+                .arg(static_cast<int>((*rsp)->getType()))
+                .arg((*rsp)->toText());
         }
-    }
 
-    return (true);
+        sendPackets(rsps);
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+            .arg(e.what());
+    }
 }
 
 string
@@ -903,7 +1153,8 @@ queueNameChangeRequest(const isc::dhcp_ddns::NameChangeType chg_type,
 }
 
 void
-Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
+Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer,
+                       const LeaseCommitPtr& commit) {
 
     // We need to select a subnet the client is connected in.
     Subnet4Ptr subnet = selectSubnet(question);
@@ -998,7 +1249,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
                                                       hostname,
                                                     fake_allocation,
                                                     callout_handle,
-                                                    old_lease);
+                                                    old_lease, commit);
 
     if (lease) {
         // We have a lease! Let's set it in the packet and send it back to
@@ -1025,8 +1276,18 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
             try {
                 // The lease update should be safe, because the lease should
                 // be already in the database. In most cases the exception
-                // would be thrown if the lease was missing.
-                LeaseMgrFactory::instance().updateLease4(lease);
+                // would be thrown if the lease was missing. The update of
+                // the lease which is being written asynchronously is queued
+                // after the write and its failure is only logged.
+                if (commit) {
+                    if (!async_lease_mgr_->updateLease4(lease,
+                            boost::bind(&nameUpdateDone, _1))) {
+                        isc_throw(DbOperationError, "the queue of the lease"
+                                  " writes is full");
+                    }
+                } else {
+                    LeaseMgrFactory::instance().updateLease4(lease);
+                }
                 // The name update in the option should be also safe,
                 // because the generated name is well formed.
                 if (fqdn) {
@@ -1181,8 +1442,7 @@ Dhcpv4Srv::processDiscover(Pkt4Ptr& discover) {
 
     sanityCheck(discover, FORBIDDEN);
 
-    Pkt4Ptr offer = Pkt4Ptr
-        (new Pkt4(DHCPOFFER, discover->getTransid()));
+    Pkt4Ptr offer = response_pool_.create(DHCPOFFER, discover->getTransid());
 
     copyDefaultFields(discover, offer);
     appendDefaultOptions(offer, DHCPOFFER);
@@ -1215,13 +1475,12 @@ Dhcpv4Srv::processDiscover(Pkt4Ptr& discover) {
 }
 
 Pkt4Ptr
-Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
+Dhcpv4Srv::processRequest(Pkt4Ptr& request, const LeaseCommitPtr& commit) {
 
     /// @todo Uncomment this (see ticket #3116)
     /// sanityCheck(request, MANDATORY);
 
-    Pkt4Ptr ack = Pkt4Ptr
-        (new Pkt4(DHCPACK, request->getTransid()));
+    Pkt4Ptr ack = response_pool_.create(DHCPACK, request->getTransid());
 
     copyDefaultFields(request, ack);
     appendDefaultOptions(ack, DHCPACK);
@@ -1235,7 +1494,7 @@ Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
     // Note that we treat REQUEST message uniformly, regardless if this is a
     // first request (requesting for new address), renewing existing address
     // or even rebinding.
-    assignLease(request, ack);
+    assignLease(request, ack, commit);
 
     // Adding any other options makes sense only when we got the lease.
     if (ack->getYiaddr() != IOAddress("0.0.0.0")) {
@@ -1313,10 +1572,10 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
             callout_handle->deleteAllArguments();
 
             // Pass the original packet
-            callout_handle->setArgument("query4", release);
+            callout_handle->setArgument(Hooks.arg_index_query4_, release);
 
             // Pass the lease to be updated
-            callout_handle->setArgument("lease4", lease);
+            callout_handle->setArgument(Hooks.arg_index_lease4_, lease);
 
             // Call all installed callouts
             HooksManager::callCallouts(Hooks.hook_index_lease4_release_,
@@ -1337,6 +1596,9 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
             bool success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
 
             if (success) {
+                alloc_engine_->markPoolFree(Lease::TYPE_V4, lease->addr_,
+                                            lease->subnet_id_);
+
                 // Release successful
                 LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_RELEASE)
                     .arg(lease->addr_.toText())
@@ -1452,9 +1714,9 @@ Dhcpv4Srv::selectSubnet(const Pkt4Ptr& question) const {
         callout_handle->deleteAllArguments();
 
         // Set new arguments
-        callout_handle->setArgument("query4", question);
-        callout_handle->setArgument("subnet4", subnet);
-        callout_handle->setArgument("subnet4collection",
+        callout_handle->setArgument(Hooks.arg_index_query4_, question);
+        callout_handle->setArgument(Hooks.arg_index_subnet4_, subnet);
+        callout_handle->setArgument(Hooks.arg_index_subnet4collection_,
                                     CfgMgr::instance().getSubnets4());
 
         // Call user (and server-side) callouts
@@ -1471,7 +1733,7 @@ Dhcpv4Srv::selectSubnet(const Pkt4Ptr& question) const {
         }
 
         // Use whatever subnet was specified by the callout
-        callout_handle->getArgument("subnet4", subnet);
+        callout_handle->getArgument(Hooks.arg_index_subnet4_, subnet);
     }
 
     return (subnet);
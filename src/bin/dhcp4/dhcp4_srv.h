@@ -17,6 +17,7 @@
 
 #include <dhcp/dhcp4.h>
 #include <dhcp/pkt4.h>
+#include <dhcp/pkt_pool.h>
 #include <dhcp/option.h>
 #include <dhcp/option_string.h>
 #include <dhcp/option4_client_fqdn.h>
@@ -25,12 +26,16 @@
 #include <dhcpsrv/d2_client_mgr.h>
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/async_lease_mgr.h>
+#include <dhcpsrv/packet_pipeline.h>
 #include <hooks/callout_handle.h>
 
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <iostream>
 #include <queue>
+#include <vector>
 
 namespace isc {
 namespace dhcp {
@@ -108,6 +113,138 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Default capacity of the queues of the packet processing
+    /// pipeline.
+    static const size_t DEFAULT_QUEUE_SIZE = 1024;
+
+    /// @brief Maximum number of packets received with a single call to
+    /// the @c IfaceMgr.
+    static const size_t RECEIVE_BATCH_SIZE = 32;
+
+    /// @brief Maximum number of lease writes committed to the lease
+    /// database at once when the packets are processed concurrently.
+    static const size_t LEASE_WRITE_BATCH_SIZE = 64;
+
+    /// @brief Configures the server to process packets concurrently.
+    ///
+    /// By default the server receives, processes and responds to the
+    /// packets one by one in a single thread. If the number of workers is
+    /// greater than 0, the @c run method hands the received packets over to
+    /// the specified number of worker threads, through a queue of the
+    /// specified size, and the responses are sent by a dedicated thread.
+    /// The configuration is not modified while the workers run (see
+    /// @c waitForPendingPackets), so the packets are processed concurrently
+    /// and only the state which is really shared is locked: the allocations
+    /// in a subnet are serialized by the allocation mutex of the subnet,
+    /// the lease managers and the hooks callouts lock themselves and each
+    /// worker uses its own callout handle. See
+    /// @ref isc::dhcp::PacketPipeline.
+    ///
+    /// The workers don't wait for the lease database either: the leases
+    /// allocated for a DHCPREQUEST are written by the
+    /// @ref isc::dhcp::AsyncLeaseMgr and the DHCPACK is handed over to the
+    /// sender when they have been written, so as the worker may process
+    /// the next packet in the meantime. If the write fails, the DHCPACK is
+    /// dropped. The releases and declines are still written synchronously.
+    ///
+    /// This function must be called before @c run.
+    ///
+    /// @param workers Number of worker threads; 0 disables the concurrent
+    /// processing.
+    /// @param queue_size Maximum number of packets waiting for the workers.
+    ///
+    /// @throw isc::InvalidOperation if called while the server is running.
+    /// @throw isc::BadValue if the queue size is 0.
+    void setWorkerThreads(const size_t workers,
+                          const size_t queue_size = DEFAULT_QUEUE_SIZE);
+
+    /// @brief Returns the number of worker threads.
+    size_t getWorkerThreads() const {
+        return (workers_);
+    }
+
+    /// @brief Waits until all received packets have been processed.
+    ///
+    /// When the packets are processed concurrently, this function must
+    /// be called before the server configuration is modified. It returns
+    /// when the leases of the processed packets have been written and the
+    /// responses have been sent. It must be
+    /// called from the thread running @c run. It returns immediately if
+    /// the packets are processed in a single thread.
+    void waitForPendingPackets();
+
+    /// @brief Returns the pool of the response packets.
+    ///
+    /// The responses are recycled once they have been sent. The numbers
+    /// of the packets allocated and reused by the pool show how many
+    /// packets are allocated per transaction.
+    const PktPool<Pkt4>& getResponsePool() const {
+        return (response_pool_);
+    }
+
+    /// @brief Returns the manager writing the leases asynchronously.
+    ///
+    /// It only exists while the packets are processed concurrently.
+    ///
+    /// @return pointer to the manager or NULL.
+    AsyncLeaseMgr* getAsyncLeaseMgr() {
+        return (async_lease_mgr_.get());
+    }
+
+    /// @brief Selects the address allocation algorithm.
+    ///
+    /// The allocation engine is replaced if the algorithm differs from the
+    /// one in use. As any other configuration change, it must be done
+    /// when no packets are being processed (see @c waitForPendingPackets).
+    ///
+    /// @param alloc_type allocation algorithm
+    void setAllocType(const AllocEngine::AllocType alloc_type);
+
+    /// @brief Returns the address allocation algorithm in use.
+    AllocEngine::AllocType getAllocType() const {
+        return (alloc_type_);
+    }
+
+    /// @brief Enables or disables tracking of the free addresses in pools.
+    ///
+    /// See @c AllocEngine::setPoolTracking for details. The setting is
+    /// retained when the allocation algorithm is changed.
+    ///
+    /// @param track true if the usage of the pools should be tracked
+    void setPoolTracking(const bool track) {
+        alloc_engine_->setPoolTracking(track);
+    }
+
+    /// @brief Checks if tracking of the free addresses in pools is enabled.
+    bool getPoolTracking() const {
+        return (alloc_engine_->getPoolTracking());
+    }
+
+    /// @brief Configures the periodic reclamation of the expired leases.
+    ///
+    /// The server reclaims the expired leases between the packets it
+    /// receives: the leases are removed from the lease database, their
+    /// addresses are returned to the pools and the removal of their DNS
+    /// entries is requested from the DHCP-DDNS server, if the DNS updates
+    /// are enabled. The reclamation cycle is interrupted when it takes
+    /// longer than the configured time, so as it doesn't delay the
+    /// processing of the clients' packets too much.
+    ///
+    /// @param interval interval between the reclamation cycles in seconds,
+    ///        0 disables the reclamation
+    /// @param max_leases maximum number of leases reclaimed in one cycle,
+    ///        0 means no limit
+    /// @param max_time maximum duration of the cycle in milliseconds, 0
+    ///        means no limit
+    void setLeaseReclamation(const uint32_t interval,
+                             const uint32_t max_leases,
+                             const uint32_t max_time);
+
+    /// @brief Returns the interval between the lease reclamation cycles.
+    uint32_t getReclaimInterval() const {
+        return (reclaim_interval_);
+    }
+
     /// @brief Return textual type of packet received by server
     ///
     /// Returns the name of valid packet received by the server (e.g. DISCOVER).
@@ -317,9 +454,13 @@ protected:
     /// Returns ACK message, NAK message, or NULL
     ///
     /// @param request a message received from client
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted. If it is not specified, the leases are written
+    ///        before the function returns.
     ///
     /// @return ACK or NAK message
-    Pkt4Ptr processRequest(Pkt4Ptr& request);
+    Pkt4Ptr processRequest(Pkt4Ptr& request,
+                           const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Stub function that will handle incoming RELEASE messages.
     ///
@@ -377,7 +518,10 @@ protected:
     ///
     /// @param question DISCOVER or REQUEST message from client
     /// @param answer OFFER or ACK/NAK message (lease options will be added here)
-    void assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer);
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
+    void assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer,
+                     const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Append basic options if they are not present.
     ///
@@ -636,7 +780,41 @@ protected:
     /// initiate server shutdown procedure.
     volatile bool shutdown_;
 
-    /// @brief dummy wrapper around IfaceMgr::receive4
+    /// @brief Processes the received packet.
+    ///
+    /// Runs the hooks, parses the packet, generates the response and
+    /// assembles its wire format. This function may be called concurrently
+    /// by the worker threads.
+    ///
+    /// When the leases allocated by the worker are written asynchronously,
+    /// the response is handed over to the sender of the pipeline once they
+    /// have been written, rather than returned.
+    ///
+    /// @param query Packet received from the client.
+    ///
+    /// @return Response to be sent or null pointer if there is no response
+    /// or it is sent later.
+    Pkt4Ptr processPacket(Pkt4Ptr query);
+
+    /// @brief Sends the response, logging any errors.
+    ///
+    /// @param rsp Response returned by @c processPacket.
+    void sendResponse(const Pkt4Ptr& rsp);
+
+    /// @brief Sends the batch of responses, logging any errors.
+    ///
+    /// It is used by the sender thread of the packet processing pipeline,
+    /// so as the responses which piled up are sent together.
+    ///
+    /// @param rsps Responses returned by @c processPacket.
+    void sendResponses(const std::vector<Pkt4Ptr>& rsps);
+
+    /// @brief dummy wrapper around IfaceMgr::receiveBatch4
+    ///
+    /// The packets are received from the @c IfaceMgr in batches of up to
+    /// @c RECEIVE_BATCH_SIZE packets and returned one by one. The
+    /// @c IfaceMgr is only called when all packets of the previous batch
+    /// have been returned.
     ///
     /// This method is useful for testing purposes, where its replacement
     /// simulates reception of a packet. For that purpose it is protected.
@@ -648,6 +826,13 @@ protected:
     /// simulates transmission of a packet. For that purpose it is protected.
     virtual void sendPacket(const Pkt4Ptr& pkt);
 
+    /// @brief dummy wrapper around IfaceMgr::sendBatch()
+    ///
+    /// This method is useful for testing purposes, where its replacement
+    /// simulates transmission of the packets. For that purpose it is
+    /// protected. The packets which can't be sent are logged and skipped.
+    virtual void sendPackets(const std::vector<Pkt4Ptr>& pkts);
+
     /// @brief Implements a callback function to parse options in the message.
     ///
     /// @param buf a A buffer holding options in on-wire format.
@@ -696,12 +881,32 @@ private:
     /// @param errmsg An error message containing a cause of the failure.
     static void ifaceMgrSocket4ErrorHandler(const std::string& errmsg);
 
+    /// @brief Starts the worker threads processing the packets.
+    void startPipeline();
+
+    /// @brief Hands the response over to the sender when the leases
+    /// allocated for the query have been written.
+    ///
+    /// It is invoked by the thread of the @c AsyncLeaseMgr.
+    ///
+    /// @param rsp Response to be sent.
+    /// @param success Indicates if the leases have been written.
+    void leasesCommitted(const Pkt4Ptr& rsp, const bool success);
+
+    /// @brief Runs the lease reclamation cycle if it is due.
+    ///
+    /// @return time in seconds until the next reclamation cycle
+    uint32_t reclaimExpiredLeases();
+
     /// @brief Allocation Engine.
     /// Pointer to the allocation engine that we are currently using
     /// It must be a pointer, because we will support changing engines
     /// during normal operation (e.g. to use different allocators)
     boost::shared_ptr<AllocEngine> alloc_engine_;
 
+    /// @brief Allocation algorithm used by the allocation engine.
+    AllocEngine::AllocType alloc_type_;
+
     uint16_t port_;  ///< UDP port number on which server listens.
     bool use_bcast_; ///< Should broadcast be enabled on sockets (if true).
 
@@ -709,6 +914,44 @@ private:
     int hook_index_pkt4_receive_;
     int hook_index_subnet4_select_;
     int hook_index_pkt4_send_;
+
+    /// @brief Number of worker threads processing the packets.
+    size_t workers_;
+
+    /// @brief Maximum number of packets waiting for the workers.
+    size_t queue_size_;
+
+    /// @brief Multi-threaded packet processing pipeline.
+    ///
+    /// It is only created when the server is configured to use workers.
+    boost::scoped_ptr<PacketPipeline<Pkt4Ptr> > pipeline_;
+
+    /// @brief Manager writing the leases allocated by the workers.
+    ///
+    /// It exists when the pipeline exists.
+    boost::scoped_ptr<AsyncLeaseMgr> async_lease_mgr_;
+
+    /// @brief Pool of the response packets.
+    PktPool<Pkt4> response_pool_;
+
+    /// @brief Interval between the lease reclamation cycles in seconds.
+    uint32_t reclaim_interval_;
+
+    /// @brief Maximum number of leases reclaimed in one cycle.
+    uint32_t max_reclaim_leases_;
+
+    /// @brief Maximum duration of the reclamation cycle in milliseconds.
+    uint32_t max_reclaim_time_;
+
+    /// @brief Time of the next lease reclamation cycle.
+    time_t next_reclaim_;
+
+    /// @brief Packets received in the last batch.
+    std::vector<Pkt4Ptr> received_;
+
+    /// @brief Index of the next packet of the last batch to be returned by
+    /// @c receivePacket.
+    size_t next_received_;
 };
 
 }; // namespace isc::dhcp
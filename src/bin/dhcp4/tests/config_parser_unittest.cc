@@ -918,6 +918,119 @@ TEST_F(Dhcp4ParserTest, echoClientId) {
     CfgMgr::instance().echoClientId(true);
 }
 
+// Checks that the address allocation algorithm can be configured.
+TEST_F(Dhcp4ParserTest, allocator) {
+    ConstElementPtr status;
+
+    string config_prefix = "{ \"interfaces\": [ \"*\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, ";
+    string config_suffix = "\"subnet4\": [ { "
+        "    \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+        "    \"subnet\": \"192.0.2.0/24\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    // The iterative allocator is used by default.
+    EXPECT_EQ(AllocEngine::ALLOC_ITERATIVE, srv_->getAllocType());
+
+    ElementPtr json = Element::fromJSON(config_prefix +
+                                        "\"allocator\": \"hashed\", " +
+                                        config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_EQ(AllocEngine::ALLOC_HASHED, srv_->getAllocType());
+
+    json = Element::fromJSON(config_prefix +
+                             "\"allocator\": \"random\", " +
+                             config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_EQ(AllocEngine::ALLOC_RANDOM, srv_->getAllocType());
+
+    // The unknown algorithm is rejected and the current one remains.
+    json = Element::fromJSON(config_prefix +
+                             "\"allocator\": \"fancy\", " +
+                             config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 1);
+    EXPECT_EQ(AllocEngine::ALLOC_RANDOM, srv_->getAllocType());
+}
+
+// Checks that the tracking of the free addresses in pools can be enabled.
+TEST_F(Dhcp4ParserTest, trackPoolUsage) {
+    ConstElementPtr status;
+
+    string config_prefix = "{ \"interfaces\": [ \"*\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, ";
+    string config_suffix = "\"subnet4\": [ { "
+        "    \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+        "    \"subnet\": \"192.0.2.0/24\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    // The tracking is disabled by default.
+    EXPECT_FALSE(srv_->getPoolTracking());
+
+    ElementPtr json = Element::fromJSON(config_prefix +
+                                        "\"track-pool-usage\": true, " +
+                                        config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_TRUE(srv_->getPoolTracking());
+
+    // The setting is retained when the allocator is replaced.
+    json = Element::fromJSON(config_prefix +
+                             "\"track-pool-usage\": true, "
+                             "\"allocator\": \"random\", " +
+                             config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_TRUE(srv_->getPoolTracking());
+
+    json = Element::fromJSON(config_prefix +
+                             "\"track-pool-usage\": false, " +
+                             config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_FALSE(srv_->getPoolTracking());
+}
+
+// Checks that the periodic reclamation of the expired leases is configured.
+TEST_F(Dhcp4ParserTest, leaseReclamation) {
+    ConstElementPtr status;
+
+    string config_prefix = "{ \"interfaces\": [ \"*\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, ";
+    string config_suffix = "\"subnet4\": [ { "
+        "    \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+        "    \"subnet\": \"192.0.2.0/24\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    // The reclamation is enabled by default.
+    ElementPtr json = Element::fromJSON(config_prefix + config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_EQ(10, srv_->getReclaimInterval());
+
+    json = Element::fromJSON(config_prefix +
+                             "\"reclaim-timer-wait-time\": 30, "
+                             "\"max-reclaim-leases\": 500, "
+                             "\"max-reclaim-time\": 50, " +
+                             config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_EQ(30, srv_->getReclaimInterval());
+
+    // The interval of 0 disables the reclamation.
+    json = Element::fromJSON(config_prefix +
+                             "\"reclaim-timer-wait-time\": 0, " +
+                             config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_EQ(0, srv_->getReclaimInterval());
+}
+
 // This test checks if it is possible to override global values
 // on a per subnet basis.
 TEST_F(Dhcp4ParserTest, subnetLocal) {
@@ -17,6 +17,7 @@
 #include <config/ccsession.h>
 #include <dhcp/dhcp4.h>
 #include <dhcp4/ctrl_dhcp4_srv.h>
+#include <dhcpsrv/cfgmgr.h>
 #include <hooks/hooks_manager.h>
 
 #include "marker_file.h"
@@ -104,6 +105,41 @@ TEST_F(CtrlDhcpv4SrvTest, commands) {
     EXPECT_EQ(0, rcode); // expect success
 }
 
+// Checks that the "pool-stats" command returns the usage of the pools.
+TEST_F(CtrlDhcpv4SrvTest, poolStats) {
+    boost::scoped_ptr<ControlledDhcpv4Srv> srv;
+    ASSERT_NO_THROW(
+        srv.reset(new ControlledDhcpv4Srv(DHCP4_SERVER_PORT + 10000))
+    );
+
+    CfgMgr::instance().deleteSubnets4();
+    Subnet4Ptr subnet(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
+    Pool4Ptr pool(new Pool4(IOAddress("192.0.2.100"),
+                            IOAddress("192.0.2.109")));
+    subnet->addPool(pool);
+    CfgMgr::instance().addSubnet4(subnet);
+    ASSERT_NO_THROW(pool->initUsage());
+    pool->markUsed(IOAddress("192.0.2.100"));
+
+    ElementPtr params(new isc::data::MapElement());
+    int rcode = -1;
+    ConstElementPtr result =
+        ControlledDhcpv4Srv::execDhcpv4ServerCommand("pool-stats", params);
+    ConstElementPtr stats = parseAnswer(rcode, result);
+    EXPECT_EQ(0, rcode);
+
+    ASSERT_TRUE(stats);
+    ASSERT_EQ(Element::list, stats->getType());
+    ASSERT_EQ(1, stats->size());
+    ConstElementPtr pool_stats = stats->get(0);
+    EXPECT_EQ(pool->toText(), pool_stats->get("pool")->stringValue());
+    EXPECT_EQ(10, pool_stats->get("capacity")->intValue());
+    EXPECT_TRUE(pool_stats->get("tracked")->boolValue());
+    EXPECT_EQ(1, pool_stats->get("used")->intValue());
+
+    CfgMgr::instance().deleteSubnets4();
+}
+
 // Check that the "libreload" command will reload libraries
 
 TEST_F(CtrlDhcpv4SrvTest, libreload) {
@@ -34,6 +34,7 @@
 #include <dhcp4/dhcp4_log.h>
 #include <dhcp4/config_parser.h>
 #include <hooks/server_hooks.h>
+#include <dhcpsrv/async_lease_mgr.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <dhcpsrv/lease_mgr_factory.h>
@@ -42,10 +43,13 @@
 #include <hooks/server_hooks.h>
 #include <hooks/hooks_manager.h>
 #include <config/ccsession.h>
+#include <util/threads/sync.h>
 
+#include <boost/bind.hpp>
 #include <boost/scoped_ptr.hpp>
 
 #include <iostream>
+#include <set>
 
 #include <arpa/inet.h>
 
@@ -565,6 +569,38 @@ TEST_F(Dhcpv4SrvTest, DiscoverBasic) {
     checkClientId(offer, clientid);
 }
 
+// This test verifies that the response packet is recycled once it has been
+// released and that the recycled packet carries the new response only.
+TEST_F(Dhcpv4SrvTest, DiscoverResponseRecycled) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    boost::scoped_ptr<NakedDhcpv4Srv> srv;
+    ASSERT_NO_THROW(srv.reset(new NakedDhcpv4Srv(0)));
+
+    Pkt4Ptr dis = Pkt4Ptr(new Pkt4(DHCPDISCOVER, 1234));
+    dis->setRemoteAddr(IOAddress("192.0.2.1"));
+    OptionPtr clientid = generateClientId();
+    dis->addOption(clientid);
+    dis->setIface("eth1");
+
+    Pkt4Ptr offer = srv->processDiscover(dis);
+    checkResponse(offer, DHCPOFFER, 1234);
+    const Pkt4* const offer_addr = offer.get();
+    offer.reset();
+
+    dis->setTransid(5678);
+    offer = srv->processDiscover(dis);
+    EXPECT_EQ(offer_addr, offer.get());
+    EXPECT_EQ(1, srv->getResponsePool().getAllocated());
+    EXPECT_EQ(1, srv->getResponsePool().getReused());
+
+    checkResponse(offer, DHCPOFFER, 5678);
+    checkAddressParams(offer, subnet_);
+    checkServerId(offer, srv->getServerID());
+    checkClientId(offer, clientid);
+}
+
 
 // This test verifies that incoming DISCOVER can be handled properly, that an
 // OFFER is generated, that the response has an address and that address
@@ -1362,6 +1398,150 @@ TEST_F(Dhcpv4SrvTest, relayAgentInfoEcho) {
     EXPECT_TRUE(rai_response->equal(rai_query));
 }
 
+// Checks that the server processes the queries using the worker threads
+// and sends the responses to all of them.
+TEST_F(Dhcpv4SrvTest, workerThreads) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    NakedDhcpv4Srv srv(0);
+    EXPECT_EQ(0, srv.getWorkerThreads());
+    EXPECT_THROW(srv.setWorkerThreads(4, 0), isc::BadValue);
+    ASSERT_NO_THROW(srv.setWorkerThreads(4, 16));
+    EXPECT_EQ(4, srv.getWorkerThreads());
+
+    // Each client uses its own HW address, so each gets its own offer.
+    const uint32_t packets_num = 10;
+    for (uint32_t transid = 1; transid <= packets_num; ++transid) {
+        Pkt4Ptr dis(new Pkt4(DHCPDISCOVER, transid));
+        dis->setHWAddr(HTYPE_ETHER, 6,
+                       std::vector<uint8_t>(6, static_cast<uint8_t>(transid)));
+        dis->setGiaddr(IOAddress("192.0.2.10"));
+        dis->setHops(1);
+        dis->setRemoteAddr(IOAddress("192.0.2.10"));
+
+        // The server expects the wire data, so create the packet from it.
+        Pkt4Ptr received;
+        ASSERT_NO_FATAL_FAILURE(createPacketFromBuffer(dis, received));
+        received->setIface("eth0");
+        received->setRemoteAddr(IOAddress("192.0.2.10"));
+        srv.fakeReceive(received);
+    }
+
+    // The server exits when there are no more packets to receive, after
+    // the workers have processed the queued ones.
+    srv.run();
+
+    ASSERT_EQ(packets_num, srv.fake_sent_.size());
+    std::set<uint32_t> transids;
+    for (std::list<Pkt4Ptr>::const_iterator rsp = srv.fake_sent_.begin();
+         rsp != srv.fake_sent_.end(); ++rsp) {
+        EXPECT_EQ(DHCPOFFER, (*rsp)->getType());
+        transids.insert((*rsp)->getTransid());
+    }
+    EXPECT_EQ(packets_num, transids.size());
+}
+
+/// @brief Server holding the lease writes until it has sent an offer.
+///
+/// The lookup queued when the first packet is received blocks the thread
+/// writing the leases until a DHCPOFFER has been sent, or for 10 seconds
+/// at most, so as the test fails rather than hangs if the offer isn't sent
+/// while a lease write is pending.
+class CommitBlockingDhcpv4Srv : public NakedDhcpv4Srv {
+public:
+    /// @brief Constructor.
+    CommitBlockingDhcpv4Srv()
+        : NakedDhcpv4Srv(0), blocked_(false), offer_sent_(false) {
+    }
+
+    /// @brief Blocks the lease writes and receives the packet.
+    virtual Pkt4Ptr receivePacket(int timeout) {
+        if (!blocked_) {
+            blocked_ = true;
+            AsyncLeaseMgr* lease_mgr = getAsyncLeaseMgr();
+            if (lease_mgr) {
+                lease_mgr->getLease4(IOAddress("0.0.0.0"),
+                    boost::bind(&CommitBlockingDhcpv4Srv::waitForOffer,
+                                this, _1));
+            }
+        }
+        return (NakedDhcpv4Srv::receivePacket(timeout));
+    }
+
+    /// @brief Sends the packets and unblocks the lease writes if there
+    /// is an offer among them.
+    virtual void sendPackets(const std::vector<Pkt4Ptr>& pkts) {
+        NakedDhcpv4Srv::sendPackets(pkts);
+        for (std::vector<Pkt4Ptr>::const_iterator pkt = pkts.begin();
+             pkt != pkts.end(); ++pkt) {
+            if ((*pkt)->getType() == DHCPOFFER) {
+                util::thread::Mutex::Locker lock(mutex_);
+                offer_sent_ = true;
+                cond_.signal();
+            }
+        }
+    }
+
+private:
+    /// @brief Waits until the offer has been sent.
+    void waitForOffer(const Lease4Ptr&) {
+        util::thread::Mutex::Locker lock(mutex_);
+        while (!offer_sent_ && cond_.timedWait(mutex_, 10000000)) {
+        }
+    }
+
+    bool blocked_;
+    util::thread::Mutex mutex_;
+    util::thread::CondVar cond_;
+    bool offer_sent_;
+};
+
+// Checks that the worker processes the next packet while the lease
+// allocated for the previous one is being written, and that the response
+// is sent when the lease has been written.
+TEST_F(Dhcpv4SrvTest, workerThreadsPendingCommit) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    CommitBlockingDhcpv4Srv srv;
+    ASSERT_NO_THROW(srv.setWorkerThreads(1, 16));
+
+    // The REQUEST of the first client is followed by the DISCOVER of the
+    // second one.
+    const uint8_t types[] = { DHCPREQUEST, DHCPDISCOVER };
+    for (uint32_t transid = 1; transid <= 2; ++transid) {
+        Pkt4Ptr query(new Pkt4(types[transid - 1], transid));
+        query->setHWAddr(HTYPE_ETHER, 6,
+                         std::vector<uint8_t>(6, static_cast<uint8_t>(transid)));
+        query->setGiaddr(IOAddress("192.0.2.10"));
+        query->setHops(1);
+        query->setRemoteAddr(IOAddress("192.0.2.10"));
+
+        Pkt4Ptr received;
+        ASSERT_NO_FATAL_FAILURE(createPacketFromBuffer(query, received));
+        received->setIface("eth0");
+        received->setRemoteAddr(IOAddress("192.0.2.10"));
+        srv.fakeReceive(received);
+    }
+
+    srv.run();
+
+    // The offer has been sent while the lease of the first client was
+    // being written.
+    ASSERT_EQ(2, srv.fake_sent_.size());
+    Pkt4Ptr offer = srv.fake_sent_.front();
+    EXPECT_EQ(DHCPOFFER, offer->getType());
+    EXPECT_EQ(2, offer->getTransid());
+    Pkt4Ptr ack = srv.fake_sent_.back();
+    EXPECT_EQ(DHCPACK, ack->getType());
+    EXPECT_EQ(1, ack->getTransid());
+    EXPECT_NE(offer->getYiaddr(), ack->getYiaddr());
+
+    // The acknowledged lease is in the database.
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(ack->getYiaddr()));
+}
+
 /// @todo move vendor options tests to a separate file.
 /// @todo Add more extensive vendor options tests, including multiple
 ///       vendor options
@@ -158,6 +158,13 @@ public:
         fake_sent_.push_back(pkt);
     }
 
+    /// @brief fake sending of the packets
+    ///
+    /// Stores the packets in fake_send_ list, as @c sendPacket does.
+    virtual void sendPackets(const std::vector<Pkt4Ptr>& pkts) {
+        fake_sent_.insert(fake_sent_.end(), pkts.begin(), pkts.end());
+    }
+
     /// @brief adds a packet to fake receive queue
     ///
     /// See fake_received_ field for description
@@ -18,6 +18,7 @@
 #include <dhcp/libdhcp++.h>
 #include <dhcp6/config_parser.h>
 #include <dhcp6/dhcp6_log.h>
+#include <dhcp6/dhcp6_srv.h>
 #include <dhcp/iface_mgr.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dbaccess_parser.h>
@@ -387,6 +388,10 @@ public:
                 sub6ptr->setRelayInfo(*relay_info_);
             }
 
+            // The configured options are sent as they are, so they are
+            // converted to the on-wire format only once.
+            sub6ptr->precompileOptions();
+
             isc::dhcp::CfgMgr::instance().addSubnet6(sub6ptr);
         }
     }
@@ -586,6 +591,8 @@ public:
             subnet->commit();
         }
 
+        // Rebuild the index used for the subnet selection.
+        isc::dhcp::CfgMgr::instance().indexSubnets6();
     }
 
     /// @brief Returns Subnet6ListConfigParser object
@@ -618,7 +625,10 @@ DhcpConfigParser* createGlobal6DhcpConfigParser(const std::string& config_id) {
     if ((config_id.compare("preferred-lifetime") == 0)  ||
         (config_id.compare("valid-lifetime") == 0)  ||
         (config_id.compare("renew-timer") == 0)  ||
-        (config_id.compare("rebind-timer") == 0))  {
+        (config_id.compare("rebind-timer") == 0) ||
+        (config_id.compare("reclaim-timer-wait-time") == 0) ||
+        (config_id.compare("max-reclaim-leases") == 0) ||
+        (config_id.compare("max-reclaim-time") == 0))  {
         parser = new Uint32Parser(config_id,
                                  globalContext()->uint32_values_);
     } else if (config_id.compare("interfaces") == 0) {
@@ -633,13 +643,16 @@ DhcpConfigParser* createGlobal6DhcpConfigParser(const std::string& config_id) {
     } else if (config_id.compare("option-def") == 0) {
         parser  = new OptionDefListParser(config_id,
                                           globalContext()->option_defs_);
-    } else if (config_id.compare("version") == 0) {
+    } else if ((config_id.compare("version") == 0) ||
+               (config_id.compare("allocator") == 0)) {
         parser  = new StringParser(config_id,
                                    globalContext()->string_values_);
     } else if (config_id.compare("lease-database") == 0) {
         parser = new DbAccessParser(config_id);
     } else if (config_id.compare("hooks-libraries") == 0) {
         parser = new HooksLibrariesParser(config_id);
+    } else if (config_id.compare("track-pool-usage") == 0) {
+        parser = new BooleanParser(config_id, globalContext()->boolean_values_);
     } else if (config_id.compare("dhcp-ddns") == 0) {
         parser = new D2ClientConfigParser(config_id);
     } else {
@@ -652,7 +665,7 @@ DhcpConfigParser* createGlobal6DhcpConfigParser(const std::string& config_id) {
 }
 
 isc::data::ConstElementPtr
-configureDhcp6Server(Dhcpv6Srv&, isc::data::ConstElementPtr config_set) {
+configureDhcp6Server(Dhcpv6Srv& server, isc::data::ConstElementPtr config_set) {
     if (!config_set) {
         ConstElementPtr answer = isc::config::createAnswer(1,
                                  string("Can't parse NULL config"));
@@ -704,6 +717,8 @@ configureDhcp6Server(Dhcpv6Srv&, isc::data::ConstElementPtr config_set) {
     // the parsers.  It is declared outside the loop so in case of error, the
     // name of the failing parser can be retrieved within the "catch" clause.
     ConfigPair config_pair;
+    // The address allocation algorithm.
+    AllocEngine::AllocType alloc_type = AllocEngine::ALLOC_ITERATIVE;
     try {
 
         // Make parsers grouping.
@@ -756,6 +771,11 @@ configureDhcp6Server(Dhcpv6Srv&, isc::data::ConstElementPtr config_set) {
             subnet_parser->build(subnet_config->second);
         }
 
+        // Check the allocation algorithm before anything is committed.
+        config_pair = ConfigPair("allocator", ConstElementPtr());
+        alloc_type = AllocEngine::allocTypeFromText(globalContext()->
+            string_values_->getOptionalParam("allocator", "iterative"));
+
     } catch (const isc::Exception& ex) {
         LOG_ERROR(dhcp6_logger, DHCP6_PARSER_FAIL)
                   .arg(config_pair.first).arg(ex.what());
@@ -787,6 +807,17 @@ configureDhcp6Server(Dhcpv6Srv&, isc::data::ConstElementPtr config_set) {
                 iface_parser->commit();
             }
 
+            // Switch to the configured allocation algorithm.
+            server.setAllocType(alloc_type);
+            server.setPoolTracking(globalContext()->boolean_values_->
+                getOptionalParam("track-pool-usage", false));
+            server.setLeaseReclamation(globalContext()->uint32_values_->
+                getOptionalParam("reclaim-timer-wait-time", 10),
+                globalContext()->uint32_values_->
+                getOptionalParam("max-reclaim-leases", 100),
+                globalContext()->uint32_values_->
+                getOptionalParam("max-reclaim-time", 250));
+
             // This occurs last as if it succeeds, there is no easy way to
             // revert it.  As a result, the failure to commit a subsequent
             // change causes problems when trying to roll back.
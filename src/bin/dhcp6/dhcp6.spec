@@ -54,6 +54,36 @@
         "item_default": 4000
       },
 
+      { "item_name": "allocator",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": "iterative"
+      },
+
+      { "item_name": "track-pool-usage",
+        "item_type": "boolean",
+        "item_optional": true,
+        "item_default": false
+      },
+
+      { "item_name": "reclaim-timer-wait-time",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 10
+      },
+
+      { "item_name": "max-reclaim-leases",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 100
+      },
+
+      { "item_name": "max-reclaim-time",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 250
+      },
+
       { "item_name": "option-def",
         "item_type": "list",
         "item_optional": false,
@@ -185,6 +215,18 @@
                 "item_type": "string",
                 "item_optional": true,
                 "item_default": ""
+            },
+            {
+                "item_name": "sync-batch",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 64
+            },
+            {
+                "item_name": "compact-threshold",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 10000
             }
         ]
       },
@@ -392,7 +434,7 @@
                 "item_type": "string",
                 "item_optional": true,
                 "item_default": "JSON",
-                "item_description" : "Format of the update request packet"
+                "item_description" : "Format of the update request packet: JSON or BINARY"
             },
             {
 
@@ -458,6 +500,12 @@
             "command_name": "libreload",
             "command_description": "Reloads the current hooks libraries.",
             "command_args": []
+        },
+
+        {
+            "command_name": "pool-stats",
+            "command_description": "Returns the usage of the address pools.",
+            "command_args": []
         }
     ]
   }
@@ -48,12 +48,15 @@
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string/erase.hpp>
 
 #include <stdlib.h>
 #include <time.h>
+#include <algorithm>
 #include <iomanip>
+#include <limits>
 #include <fstream>
 #include <sstream>
 
@@ -63,11 +66,12 @@ using namespace isc::dhcp_ddns;
 using namespace isc::dhcp;
 using namespace isc::hooks;
 using namespace isc::util;
+using namespace isc::util::thread;
 using namespace std;
 
 namespace {
 
-/// Structure that holds registered hook indexes
+/// Structure that holds registered hook and callout argument indexes
 struct Dhcp6Hooks {
     int hook_index_buffer6_receive_;///< index for "buffer6_receive" hook point
     int hook_index_pkt6_receive_;   ///< index for "pkt6_receive" hook point
@@ -77,8 +81,15 @@ struct Dhcp6Hooks {
     int hook_index_lease6_release_; ///< index for "lease6_release" hook point
     int hook_index_pkt6_send_;      ///< index for "pkt6_send" hook point
     int hook_index_buffer6_send_;   ///< index for "buffer6_send" hook point
-
-    /// Constructor that registers hook points for DHCPv6 engine
+    int arg_index_query6_;            ///< index of the "query6" argument
+    int arg_index_response6_;         ///< index of the "response6" argument
+    int arg_index_lease6_;            ///< index of the "lease6" argument
+    int arg_index_subnet6_;           ///< index of the "subnet6" argument
+    int arg_index_subnet6collection_; ///< index of the "subnet6collection" argument
+    int arg_index_ia_na_;             ///< index of the "ia_na" argument
+    int arg_index_ia_pd_;             ///< index of the "ia_pd" argument
+
+    /// Constructor that registers hook points and arguments for DHCPv6 engine
     Dhcp6Hooks() {
         hook_index_buffer6_receive_= HooksManager::registerHook("buffer6_receive");
         hook_index_pkt6_receive_   = HooksManager::registerHook("pkt6_receive");
@@ -88,6 +99,14 @@ struct Dhcp6Hooks {
         hook_index_lease6_release_ = HooksManager::registerHook("lease6_release");
         hook_index_pkt6_send_      = HooksManager::registerHook("pkt6_send");
         hook_index_buffer6_send_   = HooksManager::registerHook("buffer6_send");
+
+        arg_index_query6_            = HooksManager::registerArgument("query6");
+        arg_index_response6_         = HooksManager::registerArgument("response6");
+        arg_index_lease6_            = HooksManager::registerArgument("lease6");
+        arg_index_subnet6_           = HooksManager::registerArgument("subnet6");
+        arg_index_subnet6collection_ = HooksManager::registerArgument("subnet6collection");
+        arg_index_ia_na_             = HooksManager::registerArgument("ia_na");
+        arg_index_ia_pd_             = HooksManager::registerArgument("ia_pd");
     }
 };
 
@@ -97,6 +116,36 @@ struct Dhcp6Hooks {
 // module is called.
 Dhcp6Hooks Hooks;
 
+/// @brief Logs the failure of the asynchronous update of the lease with
+/// the hostname generated by the server.
+///
+/// @param write executed update
+void
+nameUpdateDone(const LeaseWrite& write) {
+    if (!write.result_) {
+        LOG_ERROR(dhcp6_logger, DHCP6_NAME_GEN_UPDATE_FAIL)
+            .arg(write.addr_.toText())
+            .arg(write.error_);
+    }
+}
+
+/// @brief Updates the extended lease in the lease database.
+///
+/// @param lease extended lease
+/// @param commit optional commit through which the update is submitted;
+/// without it, the lease is updated before the function returns
+///
+/// @throw isc::dhcp::DbOperationError if the update couldn't be submitted
+void
+updateLease(const Lease6Ptr& lease, const LeaseCommitPtr& commit) {
+    if (!commit) {
+        LeaseMgrFactory::instance().updateLease6(lease);
+
+    } else if (!commit->submit(LeaseWrite(LeaseWrite::UPDATE, lease))) {
+        isc_throw(DbOperationError, "the queue of the lease writes is full");
+    }
+}
+
 }; // anonymous namespace
 
 namespace isc {
@@ -104,6 +153,9 @@ namespace dhcp {
 
 const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 
+const size_t Dhcpv6Srv::DEFAULT_QUEUE_SIZE;
+const size_t Dhcpv6Srv::LEASE_WRITE_BATCH_SIZE;
+
 /// @brief file name of a server-id file
 ///
 /// Server must store its duid in persistent storage that must not change
@@ -115,7 +167,11 @@ const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 static const char* SERVER_DUID_FILE = "b10-dhcp6-serverid";
 
 Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
-:alloc_engine_(), serverid_(), port_(port), shutdown_(true)
+:alloc_engine_(), alloc_type_(AllocEngine::ALLOC_ITERATIVE), serverid_(),
+    port_(port), workers_(0),
+    queue_size_(DEFAULT_QUEUE_SIZE), reclaim_interval_(0),
+    max_reclaim_leases_(0), max_reclaim_time_(0), next_reclaim_(0),
+    next_received_(0), shutdown_(true)
 {
 
     LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_OPEN_SOCKET).arg(port);
@@ -157,7 +213,7 @@ Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
         }
 
         // Instantiate allocation engine
-        alloc_engine_.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100));
+        setAllocType(AllocEngine::ALLOC_ITERATIVE);
 
         /// @todo call loadLibraries() when handling configuration changes
 
@@ -182,13 +238,39 @@ void Dhcpv6Srv::shutdown() {
 }
 
 Pkt6Ptr Dhcpv6Srv::receivePacket(int timeout) {
-    return (IfaceMgr::instance().receive6(timeout));
+    if (next_received_ >= received_.size()) {
+        received_.clear();
+        next_received_ = 0;
+        IfaceMgr::instance().receiveBatch6(received_, RECEIVE_BATCH_SIZE,
+                                           timeout);
+        if (received_.empty()) {
+            return (Pkt6Ptr());
+        }
+    }
+    // Don't hold the reference to the packet, so as it is released as soon
+    // as it has been processed.
+    Pkt6Ptr query;
+    query.swap(received_[next_received_++]);
+    return (query);
 }
 
 void Dhcpv6Srv::sendPacket(const Pkt6Ptr& packet) {
     IfaceMgr::instance().send(packet);
 }
 
+void
+Dhcpv6Srv::sendPackets(const std::vector<Pkt6Ptr>& packets) {
+    // The packets which can't be sent are skipped by the IfaceMgr, so as
+    // they don't cause the loss of the whole batch. Log why each of them
+    // has not been sent.
+    std::vector<std::string> errors;
+    IfaceMgr::instance().sendBatch(packets, errors);
+    for (std::vector<std::string>::const_iterator error = errors.begin();
+         error != errors.end(); ++error) {
+        LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL).arg(*error);
+    }
+}
+
 bool
 Dhcpv6Srv::testServerID(const Pkt6Ptr& pkt) {
     /// @todo Currently we always check server identifier regardless if
@@ -235,19 +317,21 @@ Dhcpv6Srv::testUnicast(const Pkt6Ptr& pkt) const {
 }
 
 bool Dhcpv6Srv::run() {
+    // Start the worker threads if the server has been configured to process
+    // packets concurrently.
+    if (workers_ > 0) {
+        startPipeline();
+    }
+
     while (!shutdown_) {
-        /// @todo Calculate actual timeout to the next event (e.g. lease
-        /// expiration) once we have lease database. The idea here is that
-        /// it is possible to do everything in a single process/thread.
-        /// For now, we are just calling select for 1000 seconds. There
-        /// were some issues reported on some systems when calling select()
-        /// with too large values. Unfortunately, I don't recall the details.
-        //cppcheck-suppress variableScope This is temporary anyway
-        const int timeout = 1000;
-
-        // client's message and server's response
+        /// Wait for the packets until the next lease reclamation cycle,
+        /// but no longer than 1000 seconds. There were some issues reported
+        /// on some systems when calling select() with too large values.
+        /// Unfortunately, I don't recall the details.
+        const int timeout = std::min<uint32_t>(1000, reclaimExpiredLeases());
+
+        // client's message
         Pkt6Ptr query;
-        Pkt6Ptr rsp;
 
         try {
             query = receivePacket(timeout);
@@ -261,271 +345,504 @@ bool Dhcpv6Srv::run() {
             continue;
         }
 
-        // In order to parse the DHCP options, the server needs to use some
-        // configuration information such as: existing option spaces, option
-        // definitions etc. This is the kind of information which is not
-        // available in the libdhcp, so we need to supply our own implementation
-        // of the option parsing function here, which would rely on the
-        // configuration data.
-        query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
-                                       _3, _4, _5));
+        // Hand the packet over to the workers. If they can't keep up with
+        // the incoming traffic, the packet is dropped.
+        if (pipeline_) {
+            if (!pipeline_->push(query)) {
+                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                          DHCP6_PACKET_QUEUE_FULL)
+                    .arg(query->getRemoteAddr().toText())
+                    .arg(query->getIface());
+            }
+            continue;
+        }
+
+        Pkt6Ptr rsp = processPacket(query);
+        if (rsp) {
+            sendResponse(rsp);
+        }
+    }
 
-        bool skip_unpack = false;
+    // Process the packets still held in the queues, write their leases and
+    // send the responses before the workers and the sender are stopped.
+    if (pipeline_) {
+        pipeline_->wait();
+        async_lease_mgr_->stop();
+    }
+    pipeline_.reset();
+    async_lease_mgr_.reset();
 
-        // The packet has just been received so contains the uninterpreted wire
-        // data; execute callouts registered for buffer6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_RESPONSE_POOL_STATS)
+        .arg(response_pool_.getAllocated()).arg(response_pool_.getReused());
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+    return (true);
+}
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+void
+Dhcpv6Srv::setWorkerThreads(const size_t workers, const size_t queue_size) {
+    if (pipeline_) {
+        isc_throw(InvalidOperation, "unable to change the number of worker"
+                  " threads while the server is running");
+    } else if (queue_size == 0) {
+        isc_throw(BadValue, "size of the packet queue must be greater than 0");
+    }
+    workers_ = workers;
+    queue_size_ = queue_size;
+}
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
+void
+Dhcpv6Srv::waitForPendingPackets() {
+    if (pipeline_) {
+        // The responses are handed over to the sender when the leases have
+        // been written, i.e. after the workers have processed the packets.
+        pipeline_->wait();
+        async_lease_mgr_->wait();
+        pipeline_->wait();
+    }
+}
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to parse the packet, so skip at this
-            // stage means that callouts did the parsing already, so server
-            // should skip parsing.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
-                skip_unpack = true;
-            }
+void
+Dhcpv6Srv::setAllocType(const AllocEngine::AllocType alloc_type) {
+    if (alloc_engine_ && (alloc_type == alloc_type_)) {
+        return;
+    }
+    const bool track = alloc_engine_ && alloc_engine_->getPoolTracking();
+    alloc_engine_.reset(new AllocEngine(alloc_type, 100));
+    alloc_engine_->setPoolTracking(track);
+    alloc_type_ = alloc_type;
+}
 
-            callout_handle->getArgument("query6", query);
+void
+Dhcpv6Srv::setLeaseReclamation(const uint32_t interval,
+                               const uint32_t max_leases,
+                               const uint32_t max_time) {
+    reclaim_interval_ = interval;
+    max_reclaim_leases_ = max_leases;
+    max_reclaim_time_ = max_time;
+    next_reclaim_ = time(NULL) + interval;
+}
+
+uint32_t
+Dhcpv6Srv::reclaimExpiredLeases() {
+    if (reclaim_interval_ == 0) {
+        return (std::numeric_limits<uint32_t>::max());
+    }
+
+    time_t now = time(NULL);
+    if (now >= next_reclaim_) {
+        // The reclamation may run concurrently with the packet processing:
+        // it locks the subnet of each reclaimed lease, as the allocations
+        // do.
+        try {
+            // The removal of the DNS entries is skipped if the DNS updates
+            // are disabled.
+            alloc_engine_->reclaimExpiredLeases6(max_reclaim_leases_,
+                max_reclaim_time_,
+                boost::bind(&Dhcpv6Srv::createRemovalNameChangeRequest,
+                            this, _1));
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcp6_logger, DHCP6_RECLAIM_LEASES_FAIL).arg(ex.what());
         }
+        now = time(NULL);
+        next_reclaim_ = now + reclaim_interval_;
+    }
+    return (next_reclaim_ - now);
+}
 
-        // Unpack the packet information unless the buffer6_receive callouts
-        // indicated they did it
-        if (!skip_unpack) {
-            if (!query->unpack()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
-                          DHCP6_PACKET_PARSE_FAIL);
-                continue;
+void
+Dhcpv6Srv::startPipeline() {
+    // The standard option definitions are created on first use. Make sure
+    // it happens before the workers may use them concurrently.
+    LibDHCP::getOptionDefs(Option::V6);
+    LibDHCP::getVendorOption6Defs(VENDOR_ID_CABLE_LABS);
+
+    LOG_INFO(dhcp6_logger, DHCP6_PIPELINE_START).arg(workers_).arg(queue_size_);
+    async_lease_mgr_.reset(new AsyncLeaseMgr(queue_size_,
+                                             LEASE_WRITE_BATCH_SIZE));
+    pipeline_.reset(new PacketPipeline<Pkt6Ptr>(workers_, queue_size_,
+        boost::bind(&Dhcpv6Srv::processPacket, this, _1),
+        boost::bind(&Dhcpv6Srv::sendResponses, this, _1),
+        &Dhcpv6Srv::getQueryKey));
+}
+
+void
+Dhcpv6Srv::leasesCommitted(const Pkt6Ptr& rsp, const bool success) {
+    if (!success) {
+        LOG_ERROR(dhcp6_logger, DHCP6_LEASE_COMMIT_FAIL)
+            .arg(rsp->getTransid());
+        return;
+    }
+    pipeline_->send(rsp);
+}
+
+size_t
+Dhcpv6Srv::getQueryKey(const Pkt6Ptr& query) {
+    const OptionBuffer& buf = query->data_;
+    size_t offset = 0;
+    size_t end = buf.size();
+    while (offset < end) {
+        // The relayed message carries the client's message in the Relay
+        // Message option, which may in turn hold another relayed message.
+        const bool relayed = (buf[offset] == DHCPV6_RELAY_FORW) ||
+            (buf[offset] == DHCPV6_RELAY_REPL);
+        const uint16_t wanted = relayed ? D6O_RELAY_MSG : D6O_CLIENTID;
+        offset += (relayed ? Pkt6::DHCPV6_RELAY_HDR_LEN :
+                   Pkt6::DHCPV6_PKT_HDR_LEN);
+
+        // Walk through the options until the wanted one is found.
+        bool found = false;
+        while (!found && (offset + 4 <= end)) {
+            const uint16_t code = readUint16(&buf[offset], 2);
+            const uint16_t len = readUint16(&buf[offset + 2], 2);
+            offset += 4;
+            if (offset + len > end) {
+                // Truncated option. The packet will be dropped anyway.
+                break;
+            }
+            if (code == wanted) {
+                found = true;
+                end = offset + len;
+            } else {
+                offset += len;
             }
-        }
-        // Check if received query carries server identifier matching
-        // server identifier being used by the server.
-        if (!testServerID(query)) {
-            continue;
         }
 
-        // Check if the received query has been sent to unicast or multicast.
-        // The Solicit, Confirm, Rebind and Information Request will be
-        // discarded if sent to unicast address.
-        if (!testUnicast(query)) {
-            continue;
+        if (!found) {
+            break;
+
+        } else if (!relayed) {
+            return (boost::hash_range(buf.begin() + offset,
+                                      buf.begin() + end));
         }
+    }
+    const std::vector<uint8_t> addr = query->getRemoteAddr().toBytes();
+    return (boost::hash_range(addr.begin(), addr.end()));
+}
 
-        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
-            .arg(query->getName());
-        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_QUERY_DATA)
-            .arg(static_cast<int>(query->getType()))
-            .arg(query->getBuffer().getLength())
-            .arg(query->toText());
-
-        // At this point the information in the packet has been unpacked into
-        // the various packet fields and option objects has been cretated.
-        // Execute callouts registered for packet6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+Pkt6Ptr
+Dhcpv6Srv::processPacket(Pkt6Ptr query) {
+    // server's response
+    Pkt6Ptr rsp;
+
+    // Lease writes made while processing the packet by the worker.
+    LeaseCommitPtr commit;
+
+    // Specifies if server should do the packing
+    bool skip_pack = false;
+
+    // In order to parse the DHCP options, the server needs to use some
+    // configuration information such as: existing option spaces, option
+    // definitions etc. This is the kind of information which is not
+    // available in the libdhcp, so we need to supply our own implementation
+    // of the option parsing function here, which would rely on the
+    // configuration data.
+    query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
+                                   _3, _4, _5));
+
+    bool skip_unpack = false;
+
+    // The packet has just been received so contains the uninterpreted wire
+    // data; execute callouts registered for buffer6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+        // Pass incoming packet as argument
+        callout_handle->setArgument(Hooks.arg_index_query6_, query);
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to process the packet, so skip at this
-            // stage means drop.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
-                continue;
-            }
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to parse the packet, so skip at this
+        // stage means that callouts did the parsing already, so server
+        // should skip parsing.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
+            skip_unpack = true;
+        }
 
-            callout_handle->getArgument("query6", query);
+        callout_handle->getArgument(Hooks.arg_index_query6_, query);
+    }
+
+    // Unpack the packet information unless the buffer6_receive callouts
+    // indicated they did it
+    if (!skip_unpack) {
+        if (!query->unpack()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                      DHCP6_PACKET_PARSE_FAIL);
+            return (Pkt6Ptr());
         }
+    }
+    // Check if received query carries server identifier matching
+    // server identifier being used by the server.
+    if (!testServerID(query)) {
+        return (Pkt6Ptr());
+    }
 
-        // Assign this packet to a class, if possible
-        classifyPacket(query);
+    // Check if the received query has been sent to unicast or multicast.
+    // The Solicit, Confirm, Rebind and Information Request will be
+    // discarded if sent to unicast address.
+    if (!testUnicast(query)) {
+        return (Pkt6Ptr());
+    }
 
-        try {
-                NameChangeRequestPtr ncr;
-            switch (query->getType()) {
-            case DHCPV6_SOLICIT:
-                rsp = processSolicit(query);
-                    break;
-
-            case DHCPV6_REQUEST:
-                rsp = processRequest(query);
-                break;
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
+        .arg(query->getName());
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_QUERY_DATA)
+        .arg(static_cast<int>(query->getType()))
+        .arg(query->getBuffer().getLength())
+        .arg(query->toText());
 
-            case DHCPV6_RENEW:
-                rsp = processRenew(query);
-                break;
+    // At this point the information in the packet has been unpacked into
+    // the various packet fields and option objects has been cretated.
+    // Execute callouts registered for packet6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            case DHCPV6_REBIND:
-                rsp = processRebind(query);
-                break;
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            case DHCPV6_CONFIRM:
-                rsp = processConfirm(query);
-                break;
+        // Pass incoming packet as argument
+        callout_handle->setArgument(Hooks.arg_index_query6_, query);
 
-            case DHCPV6_RELEASE:
-                rsp = processRelease(query);
-                break;
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
 
-            case DHCPV6_DECLINE:
-                rsp = processDecline(query);
-                break;
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to process the packet, so skip at this
+        // stage means drop.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
+            return (Pkt6Ptr());
+        }
+
+        callout_handle->getArgument(Hooks.arg_index_query6_, query);
+    }
+
+    // Assign this packet to a class, if possible
+    classifyPacket(query);
 
-            case DHCPV6_INFORMATION_REQUEST:
-                rsp = processInfRequest(query);
+    try {
+            NameChangeRequestPtr ncr;
+        switch (query->getType()) {
+        case DHCPV6_SOLICIT:
+            rsp = processSolicit(query);
                 break;
 
-            default:
-                // We received a packet type that we do not recognize.
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
-                    .arg(static_cast<int>(query->getType()))
-                    .arg(query->getIface());
-                // Only action is to output a message if debug is enabled,
-                // and that will be covered by the debug statement before
-                // the "switch" statement.
-                ;
+        case DHCPV6_REQUEST:
+            // The workers write the leases asynchronously.
+            if (async_lease_mgr_) {
+                commit.reset(new LeaseCommit(*async_lease_mgr_));
+            }
+            rsp = processRequest(query, commit);
+            break;
+
+        case DHCPV6_RENEW:
+            if (async_lease_mgr_) {
+                commit.reset(new LeaseCommit(*async_lease_mgr_));
             }
+            rsp = processRenew(query, commit);
+            break;
 
-        } catch (const RFCViolation& e) {
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+        case DHCPV6_REBIND:
+            if (async_lease_mgr_) {
+                commit.reset(new LeaseCommit(*async_lease_mgr_));
+            }
+            rsp = processRebind(query, commit);
+            break;
 
-        } catch (const isc::Exception& e) {
+        case DHCPV6_CONFIRM:
+            rsp = processConfirm(query);
+            break;
 
-            // Catch-all exception (at least for ones based on the isc
-            // Exception class, which covers more or less all that
-            // are explicitly raised in the BIND 10 code).  Just log
-            // the problem and ignore the packet. (The problem is logged
-            // as a debug message because debug is disabled by default -
-            // it prevents a DDOS attack based on the sending of problem
-            // packets.)
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+        case DHCPV6_RELEASE:
+            rsp = processRelease(query);
+            break;
+
+        case DHCPV6_DECLINE:
+            rsp = processDecline(query);
+            break;
+
+        case DHCPV6_INFORMATION_REQUEST:
+            rsp = processInfRequest(query);
+            break;
+
+        default:
+            // We received a packet type that we do not recognize.
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
+                .arg(static_cast<int>(query->getType()))
+                .arg(query->getIface());
+            // Only action is to output a message if debug is enabled,
+            // and that will be covered by the debug statement before
+            // the "switch" statement.
+            ;
         }
 
-        if (rsp) {
-            rsp->setRemoteAddr(query->getRemoteAddr());
-            rsp->setLocalAddr(query->getLocalAddr());
+    } catch (const RFCViolation& e) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+
+    } catch (const isc::Exception& e) {
+
+        // Catch-all exception (at least for ones based on the isc
+        // Exception class, which covers more or less all that
+        // are explicitly raised in the BIND 10 code).  Just log
+        // the problem and ignore the packet. (The problem is logged
+        // as a debug message because debug is disabled by default -
+        // it prevents a DDOS attack based on the sending of problem
+        // packets.)
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+    }
 
-            if (rsp->relay_info_.empty()) {
-                // Direct traffic, send back to the client directly
-                rsp->setRemotePort(DHCP6_CLIENT_PORT);
-            } else {
-                // Relayed traffic, send back to the relay agent
-                rsp->setRemotePort(DHCP6_SERVER_PORT);
-            }
+    if (!rsp) {
+        return (Pkt6Ptr());
+    }
 
-            rsp->setLocalPort(DHCP6_SERVER_PORT);
-            rsp->setIndex(query->getIndex());
-            rsp->setIface(query->getIface());
-
-            // Specifies if server should do the packing
-            bool skip_pack = false;
-
-            // Server's reply packet now has all options and fields set.
-            // Options are represented by individual objects, but the
-            // output wire data has not been prepared yet.
-            // Execute all callouts registered for packet6_send
-            if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
-                CalloutHandlePtr callout_handle = getCalloutHandle(query);
-
-                // Delete all previous arguments
-                callout_handle->deleteAllArguments();
-
-                // Set our response
-                callout_handle->setArgument("response6", rsp);
-
-                // Call all installed callouts
-                HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
-
-                // Callouts decided to skip the next processing step. The next
-                // processing step would to pack the packet (create wire data).
-                // That step will be skipped if any callout sets skip flag.
-                // It essentially means that the callout already did packing,
-                // so the server does not have to do it again.
-                if (callout_handle->getSkip()) {
-                    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
-                    skip_pack = true;
-                }
-            }
+    rsp->setRemoteAddr(query->getRemoteAddr());
+    rsp->setLocalAddr(query->getLocalAddr());
 
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
-                      DHCP6_RESPONSE_DATA)
-                .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+    if (rsp->relay_info_.empty()) {
+        // Direct traffic, send back to the client directly
+        rsp->setRemotePort(DHCP6_CLIENT_PORT);
+    } else {
+        // Relayed traffic, send back to the relay agent
+        rsp->setRemotePort(DHCP6_SERVER_PORT);
+    }
 
-            if (!skip_pack) {
-                try {
-                    rsp->pack();
-                } catch (const std::exception& e) {
-                    LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
-                        .arg(e.what());
-                    continue;
-                }
+    rsp->setLocalPort(DHCP6_SERVER_PORT);
+    rsp->setIndex(query->getIndex());
+    rsp->setIface(query->getIface());
 
-            }
+    // Server's reply packet now has all options and fields set.
+    // Options are represented by individual objects, but the
+    // output wire data has not been prepared yet.
+    // Execute all callouts registered for packet6_send
+    if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            try {
+        // Delete all previous arguments
+        callout_handle->deleteAllArguments();
 
-                // Now all fields and options are constructed into output wire buffer.
-                // Option objects modification does not make sense anymore. Hooks
-                // can only manipulate wire buffer at this stage.
-                // Let's execute all callouts registered for buffer6_send
-                if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
-                    CalloutHandlePtr callout_handle = getCalloutHandle(query);
+        // Set our response
+        callout_handle->setArgument(Hooks.arg_index_response6_, rsp);
 
-                    // Delete previously set arguments
-                    callout_handle->deleteAllArguments();
+        // Call all installed callouts
+        HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
 
-                    // Pass incoming packet as argument
-                    callout_handle->setArgument("response6", rsp);
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to pack the packet (create wire data).
+        // That step will be skipped if any callout sets skip flag.
+        // It essentially means that the callout already did packing,
+        // so the server does not have to do it again.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
+            skip_pack = true;
+        }
+    }
 
-                    // Call callouts
-                    HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
+    // The callouts of any hook library may hold and modify the configured
+    // options included in the response, e.g. through the subnet. Their
+    // precompiled data are only copied when no hook library is loaded.
+    if (HooksManager::getLibraryNames().empty()) {
+        rsp->setUsePrecompiled(true);
+    }
+
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
+              DHCP6_RESPONSE_DATA)
+        .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+
+    if (!skip_pack) {
+        try {
+            rsp->pack();
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
+                .arg(e.what());
+            return (Pkt6Ptr());
+        }
+    }
 
-                    // Callouts decided to skip the next processing step. The next
-                    // processing step would to parse the packet, so skip at this
-                    // stage means drop.
-                    if (callout_handle->getSkip()) {
-                        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
-                        continue;
-                    }
+    // Now all fields and options are constructed into output wire buffer.
+    // Option objects modification does not make sense anymore. Hooks
+    // can only manipulate wire buffer at this stage.
+    // Let's execute all callouts registered for buffer6_send
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
+        try {
+            CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-                    callout_handle->getArgument("response6", rsp);
-                }
+            // Delete previously set arguments
+            callout_handle->deleteAllArguments();
+
+            // Pass incoming packet as argument
+            callout_handle->setArgument(Hooks.arg_index_response6_, rsp);
 
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
-                          DHCP6_RESPONSE_DATA)
-                    .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+            // Call callouts
+            HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
 
-                sendPacket(rsp);
-            } catch (const std::exception& e) {
-                LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
-                    .arg(e.what());
+            // Callouts decided to skip the next processing step. The next
+            // processing step would to parse the packet, so skip at this
+            // stage means drop.
+            if (callout_handle->getSkip()) {
+                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
+                return (Pkt6Ptr());
             }
+
+            callout_handle->getArgument(Hooks.arg_index_response6_, rsp);
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
+                .arg(e.what());
+            return (Pkt6Ptr());
         }
     }
 
-    return (true);
+    // The response is sent when the leases have been written, so as the
+    // client doesn't use the leases which may not be stored.
+    if (commit && (commit->getPending() > 0)) {
+        commit->close(boost::bind(&Dhcpv6Srv::leasesCommitted, this, rsp,
+                                  _1));
+        return (Pkt6Ptr());
+    }
+
+    return (rsp);
+}
+
+void
+Dhcpv6Srv::sendResponse(const Pkt6Ptr& rsp) {
+    try {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
+                  DHCP6_RESPONSE_DATA)
+            .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+
+        sendPacket(rsp);
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
+            .arg(e.what());
+    }
+}
+
+void
+Dhcpv6Srv::sendResponses(const std::vector<Pkt6Ptr>& rsps) {
+    try {
+        for (std::vector<Pkt6Ptr>::const_iterator rsp = rsps.begin();
+             rsp != rsps.end(); ++rsp) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
+                      DHCP6_RESPONSE_DATA)
+                .arg(static_cast<int>((*rsp)->getType()))
+                .arg((*rsp)->toText());
+        }
+
+        sendPackets(rsps);
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
+            .arg(e.what());
+    }
 }
 
 bool Dhcpv6Srv::loadServerID(const std::string& file_name) {
@@ -902,13 +1219,13 @@ Dhcpv6Srv::selectSubnet(const Pkt6Ptr& question) {
         callout_handle->deleteAllArguments();
 
         // Set new arguments
-        callout_handle->setArgument("query6", question);
-        callout_handle->setArgument("subnet6", subnet);
+        callout_handle->setArgument(Hooks.arg_index_query6_, question);
+        callout_handle->setArgument(Hooks.arg_index_subnet6_, subnet);
 
         // We pass pointer to const collection for performance reasons.
         // Otherwise we would get a non-trivial performance penalty each
         // time subnet6_select is called.
-        callout_handle->setArgument("subnet6collection", CfgMgr::instance().getSubnets6());
+        callout_handle->setArgument(Hooks.arg_index_subnet6collection_, CfgMgr::instance().getSubnets6());
 
         // Call user (and server-side) callouts
         HooksManager::callCallouts(Hooks.hook_index_subnet6_select_, *callout_handle);
@@ -922,14 +1239,15 @@ Dhcpv6Srv::selectSubnet(const Pkt6Ptr& question) {
         }
 
         // Use whatever subnet was specified by the callout
-        callout_handle->getArgument("subnet6", subnet);
+        callout_handle->getArgument(Hooks.arg_index_subnet6_, subnet);
     }
 
     return (subnet);
 }
 
 void
-Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer) {
+Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer,
+                        const LeaseCommitPtr& commit) {
 
     // We need to allocate addresses for all IA_NA options in the client's
     // question (i.e. SOLICIT or REQUEST) message.
@@ -984,7 +1302,8 @@ Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer) {
         case D6O_IA_NA: {
             OptionPtr answer_opt = assignIA_NA(subnet, duid, question, answer,
                                                boost::dynamic_pointer_cast<
-                                               Option6IA>(opt->second));
+                                               Option6IA>(opt->second),
+                                               commit);
             if (answer_opt) {
                 answer->addOption(answer_opt);
             }
@@ -993,7 +1312,8 @@ Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer) {
         case D6O_IA_PD: {
             OptionPtr answer_opt = assignIA_PD(subnet, duid, question,
                                                boost::dynamic_pointer_cast<
-                                               Option6IA>(opt->second));
+                                               Option6IA>(opt->second),
+                                               commit);
             if (answer_opt) {
                 answer->addOption(answer_opt);
             }
@@ -1182,7 +1502,8 @@ Dhcpv6Srv::createRemovalNameChangeRequest(const Lease6Ptr& lease) {
 OptionPtr
 Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
                        const Pkt6Ptr& query, const Pkt6Ptr& answer,
-                       boost::shared_ptr<Option6IA> ia) {
+                       boost::shared_ptr<Option6IA> ia,
+                       const LeaseCommitPtr& commit) {
     // If there is no subnet selected for handling this IA_NA, the only thing to do left is
     // to say that we are sorry, but the user won't get an address. As a convenience, we
     // use a different status text to indicate that (compare to the same status code,
@@ -1264,7 +1585,8 @@ Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
                                                              hostname,
                                                              fake_allocation,
                                                              callout_handle,
-                                                             old_leases);
+                                                             old_leases,
+                                                             commit);
     /// @todo: Handle more than one lease
     Lease6Ptr lease;
     if (!leases.empty()) {
@@ -1338,7 +1660,8 @@ Dhcpv6Srv::assignIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
 
 OptionPtr
 Dhcpv6Srv::assignIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
-                       const Pkt6Ptr& query, boost::shared_ptr<Option6IA> ia) {
+                       const Pkt6Ptr& query, boost::shared_ptr<Option6IA> ia,
+                       const LeaseCommitPtr& commit) {
 
     // Create IA_PD that we will put in the response.
     // Do not use OptionDefinition to create option's instance so
@@ -1393,7 +1716,8 @@ Dhcpv6Srv::assignIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
                                                              string(),
                                                              fake_allocation,
                                                              callout_handle,
-                                                             old_leases);
+                                                             old_leases,
+                                                             commit);
 
     if (!leases.empty()) {
 
@@ -1442,7 +1766,8 @@ Dhcpv6Srv::assignIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
 OptionPtr
 Dhcpv6Srv::extendIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
                        const Pkt6Ptr& query, const Pkt6Ptr& answer,
-                       boost::shared_ptr<Option6IA> ia) {
+                       boost::shared_ptr<Option6IA> ia,
+                       const LeaseCommitPtr& commit) {
 
     // Create empty IA_NA option with IAID matching the request.
     Option6IAPtr ia_rsp(new Option6IA(D6O_IA_NA, ia->getIAID()));
@@ -1580,13 +1905,13 @@ Dhcpv6Srv::extendIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
         callout_handle->deleteAllArguments();
 
         // Pass the original packet
-        callout_handle->setArgument("query6", query);
+        callout_handle->setArgument(Hooks.arg_index_query6_, query);
 
         // Pass the lease to be updated
-        callout_handle->setArgument("lease6", lease);
+        callout_handle->setArgument(Hooks.arg_index_lease6_, lease);
 
         // Pass the IA option to be sent in response
-        callout_handle->setArgument("ia_na", ia_rsp);
+        callout_handle->setArgument(Hooks.arg_index_ia_na_, ia_rsp);
 
         // Call all installed callouts
         HooksManager::callCallouts(hook_point, *callout_handle);
@@ -1606,7 +1931,7 @@ Dhcpv6Srv::extendIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // If the client has sent an invalid address, it shouldn't affect the
         // lease in our lease database.
         if (!invalid_addr) {
-            LeaseMgrFactory::instance().updateLease6(lease);
+            updateLease(lease, commit);
         }
     } else {
         // Copy back the original date to the lease. For MySQL it doesn't make
@@ -1621,7 +1946,8 @@ Dhcpv6Srv::extendIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
 
 OptionPtr
 Dhcpv6Srv::extendIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
-                       const Pkt6Ptr& query, boost::shared_ptr<Option6IA> ia) {
+                       const Pkt6Ptr& query, boost::shared_ptr<Option6IA> ia,
+                       const LeaseCommitPtr& commit) {
 
     // Let's create a IA_PD response and fill it in later
     Option6IAPtr ia_rsp(new Option6IA(D6O_IA_PD, ia->getIAID()));
@@ -1753,13 +2079,13 @@ Dhcpv6Srv::extendIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
         callout_handle->deleteAllArguments();
 
         // Pass the original packet
-        callout_handle->setArgument("query6", query);
+        callout_handle->setArgument(Hooks.arg_index_query6_, query);
 
         // Pass the lease to be updated
-        callout_handle->setArgument("lease6", lease);
+        callout_handle->setArgument(Hooks.arg_index_lease6_, lease);
 
         // Pass the IA option to be sent in response
-        callout_handle->setArgument("ia_pd", ia_rsp);
+        callout_handle->setArgument(Hooks.arg_index_ia_pd_, ia_rsp);
 
         // Call all installed callouts
         HooksManager::callCallouts(hook_point,
@@ -1773,7 +2099,7 @@ Dhcpv6Srv::extendIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // If the prefix specified by the client is wrong, we don't want to
         // update client's lease.
         if (!invalid_prefix) {
-            LeaseMgrFactory::instance().updateLease6(lease);
+            updateLease(lease, commit);
         }
     } else {
         // Callouts decided to skip the next processing step. The next
@@ -1793,7 +2119,8 @@ Dhcpv6Srv::extendIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
 }
 
 void
-Dhcpv6Srv::extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply) {
+Dhcpv6Srv::extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply,
+                        const LeaseCommitPtr& commit) {
 
     // We will try to extend lease lifetime for all IA options in the client's
     // Renew or Rebind message.
@@ -1843,7 +2170,8 @@ Dhcpv6Srv::extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply) {
         case D6O_IA_NA: {
             OptionPtr answer_opt = extendIA_NA(subnet, duid, query, reply,
                                                boost::dynamic_pointer_cast<
-                                                   Option6IA>(opt->second));
+                                                   Option6IA>(opt->second),
+                                               commit);
             if (answer_opt) {
                 reply->addOption(answer_opt);
             }
@@ -1853,7 +2181,8 @@ Dhcpv6Srv::extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply) {
         case D6O_IA_PD: {
             OptionPtr answer_opt = extendIA_PD(subnet, duid, query,
                                                boost::dynamic_pointer_cast<
-                                                   Option6IA>(opt->second));
+                                                   Option6IA>(opt->second),
+                                               commit);
             if (answer_opt) {
                 reply->addOption(answer_opt);
             }
@@ -2030,10 +2359,10 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, const Pkt6Ptr& query,
         callout_handle->deleteAllArguments();
 
         // Pass the original packet
-        callout_handle->setArgument("query6", query);
+        callout_handle->setArgument(Hooks.arg_index_query6_, query);
 
         // Pass the lease to be updated
-        callout_handle->setArgument("lease6", lease);
+        callout_handle->setArgument(Hooks.arg_index_lease6_, lease);
 
         // Call all installed callouts
         HooksManager::callCallouts(Hooks.hook_index_lease6_release_, *callout_handle);
@@ -2052,6 +2381,10 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success) {
+            alloc_engine_->markPoolFree(lease->type_, lease->addr_,
+                                        lease->subnet_id_);
+        }
     }
 
     // Here the success should be true if we removed lease successfully
@@ -2180,10 +2513,10 @@ Dhcpv6Srv::releaseIA_PD(const DuidPtr& duid, const Pkt6Ptr& query,
         callout_handle->deleteAllArguments();
 
         // Pass the original packet
-        callout_handle->setArgument("query6", query);
+        callout_handle->setArgument(Hooks.arg_index_query6_, query);
 
         // Pass the lease to be updated
-        callout_handle->setArgument("lease6", lease);
+        callout_handle->setArgument(Hooks.arg_index_lease6_, lease);
 
         // Call all installed callouts
         HooksManager::callCallouts(Hooks.hook_index_lease6_release_, *callout_handle);
@@ -2196,6 +2529,10 @@ Dhcpv6Srv::releaseIA_PD(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success) {
+            alloc_engine_->markPoolFree(lease->type_, lease->addr_,
+                                        lease->subnet_id_);
+        }
     } else {
         // Callouts decided to skip the next processing step. The next
         // processing step would to send the packet, so skip at this
@@ -2233,7 +2570,8 @@ Dhcpv6Srv::processSolicit(const Pkt6Ptr& solicit) {
 
     sanityCheck(solicit, MANDATORY, FORBIDDEN);
 
-    Pkt6Ptr advertise(new Pkt6(DHCPV6_ADVERTISE, solicit->getTransid()));
+    Pkt6Ptr advertise = response_pool_.create(DHCPV6_ADVERTISE,
+                                              solicit->getTransid());
 
     copyDefaultOptions(solicit, advertise);
     appendDefaultOptions(solicit, advertise);
@@ -2252,11 +2590,12 @@ Dhcpv6Srv::processSolicit(const Pkt6Ptr& solicit) {
 }
 
 Pkt6Ptr
-Dhcpv6Srv::processRequest(const Pkt6Ptr& request) {
+Dhcpv6Srv::processRequest(const Pkt6Ptr& request,
+                          const LeaseCommitPtr& commit) {
 
     sanityCheck(request, MANDATORY, MANDATORY);
 
-    Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, request->getTransid()));
+    Pkt6Ptr reply = response_pool_.create(DHCPV6_REPLY, request->getTransid());
 
     copyDefaultOptions(request, reply);
     appendDefaultOptions(request, reply);
@@ -2264,44 +2603,45 @@ Dhcpv6Srv::processRequest(const Pkt6Ptr& request) {
     appendRequestedVendorOptions(request, reply);
 
     processClientFqdn(request, reply);
-    assignLeases(request, reply);
-    generateFqdn(reply);
+    assignLeases(request, reply, commit);
+    generateFqdn(reply, commit);
     createNameChangeRequests(reply);
 
     return (reply);
 }
 
 Pkt6Ptr
-Dhcpv6Srv::processRenew(const Pkt6Ptr& renew) {
+Dhcpv6Srv::processRenew(const Pkt6Ptr& renew, const LeaseCommitPtr& commit) {
 
     sanityCheck(renew, MANDATORY, MANDATORY);
 
-    Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, renew->getTransid()));
+    Pkt6Ptr reply = response_pool_.create(DHCPV6_REPLY, renew->getTransid());
 
     copyDefaultOptions(renew, reply);
     appendDefaultOptions(renew, reply);
     appendRequestedOptions(renew, reply);
 
     processClientFqdn(renew, reply);
-    extendLeases(renew, reply);
-    generateFqdn(reply);
+    extendLeases(renew, reply, commit);
+    generateFqdn(reply, commit);
     createNameChangeRequests(reply);
 
     return (reply);
 }
 
 Pkt6Ptr
-Dhcpv6Srv::processRebind(const Pkt6Ptr& rebind) {
+Dhcpv6Srv::processRebind(const Pkt6Ptr& rebind,
+                         const LeaseCommitPtr& commit) {
 
-    Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, rebind->getTransid()));
+    Pkt6Ptr reply = response_pool_.create(DHCPV6_REPLY, rebind->getTransid());
 
     copyDefaultOptions(rebind, reply);
     appendDefaultOptions(rebind, reply);
     appendRequestedOptions(rebind, reply);
 
     processClientFqdn(rebind, reply);
-    extendLeases(rebind, reply);
-    generateFqdn(reply);
+    extendLeases(rebind, reply, commit);
+    generateFqdn(reply, commit);
     createNameChangeRequests(rebind);
 
     return (reply);
@@ -2310,7 +2650,7 @@ Dhcpv6Srv::processRebind(const Pkt6Ptr& rebind) {
 Pkt6Ptr
 Dhcpv6Srv::processConfirm(const Pkt6Ptr& confirm) {
     /// @todo: Implement this
-    Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, confirm->getTransid()));
+    Pkt6Ptr reply = response_pool_.create(DHCPV6_REPLY, confirm->getTransid());
     return reply;
 }
 
@@ -2319,7 +2659,7 @@ Dhcpv6Srv::processRelease(const Pkt6Ptr& release) {
 
     sanityCheck(release, MANDATORY, MANDATORY);
 
-    Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, release->getTransid()));
+    Pkt6Ptr reply = response_pool_.create(DHCPV6_REPLY, release->getTransid());
 
     copyDefaultOptions(release, reply);
     appendDefaultOptions(release, reply);
@@ -2335,14 +2675,15 @@ Dhcpv6Srv::processRelease(const Pkt6Ptr& release) {
 Pkt6Ptr
 Dhcpv6Srv::processDecline(const Pkt6Ptr& decline) {
     /// @todo: Implement this
-    Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, decline->getTransid()));
+    Pkt6Ptr reply = response_pool_.create(DHCPV6_REPLY, decline->getTransid());
     return reply;
 }
 
 Pkt6Ptr
 Dhcpv6Srv::processInfRequest(const Pkt6Ptr& infRequest) {
     /// @todo: Implement this
-    Pkt6Ptr reply(new Pkt6(DHCPV6_REPLY, infRequest->getTransid()));
+    Pkt6Ptr reply = response_pool_.create(DHCPV6_REPLY,
+                                          infRequest->getTransid());
     return reply;
 }
 
@@ -2530,7 +2871,8 @@ void Dhcpv6Srv::classifyPacket(const Pkt6Ptr& pkt) {
 }
 
 void
-Dhcpv6Srv::generateFqdn(const Pkt6Ptr& answer) {
+Dhcpv6Srv::generateFqdn(const Pkt6Ptr& answer,
+                        const LeaseCommitPtr& commit) {
     if (!answer) {
         isc_throw(isc::Unexpected, "an instance of the object encapsulating"
                   " a message must not be NULL when generating FQDN");
@@ -2566,8 +2908,17 @@ Dhcpv6Srv::generateFqdn(const Pkt6Ptr& answer) {
         // been updated in the lease database. We now have new FQDN
         // generated, so the lease database has to be updated here.
         // However, never update lease database for Advertise, just send
-        // our notion of client's FQDN in the Client FQDN option.
-        if (answer->getType() != DHCPV6_ADVERTISE) {
+        // our notion of client's FQDN in the Client FQDN option. The lease
+        // which is being written asynchronously may not be in the database
+        // yet, so it is read and updated after the pending writes.
+        if (commit) {
+            if (!async_lease_mgr_->getLease6(Lease::TYPE_NA, addr,
+                    boost::bind(&Dhcpv6Srv::updateGeneratedName, this, _1,
+                                addr, generated_name))) {
+                isc_throw(DbOperationError, "the queue of the lease writes"
+                          " is full");
+            }
+        } else if (answer->getType() != DHCPV6_ADVERTISE) {
             Lease6Ptr lease =
                 LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addr);
             if (lease) {
@@ -2592,6 +2943,24 @@ Dhcpv6Srv::generateFqdn(const Pkt6Ptr& answer) {
     }
 }
 
+void
+Dhcpv6Srv::updateGeneratedName(const Lease6Ptr& lease, const IOAddress& addr,
+                               const std::string& hostname) {
+    if (!lease) {
+        LOG_ERROR(dhcp6_logger, DHCP6_NAME_GEN_UPDATE_FAIL)
+            .arg(addr.toText())
+            .arg("there is no lease in the database for this address");
+        return;
+    }
+    lease->hostname_ = hostname;
+    if (!async_lease_mgr_->updateLease6(lease,
+                                        boost::bind(&nameUpdateDone, _1))) {
+        LOG_ERROR(dhcp6_logger, DHCP6_NAME_GEN_UPDATE_FAIL)
+            .arg(addr.toText())
+            .arg("the queue of the lease writes is full");
+    }
+}
+
 void
 Dhcpv6Srv::startD2() {
     D2ClientMgr& d2_mgr = CfgMgr::instance().getD2ClientMgr();
@@ -23,15 +23,20 @@
 #include <dhcp/option6_ia.h>
 #include <dhcp/option_definition.h>
 #include <dhcp/pkt6.h>
+#include <dhcp/pkt_pool.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/async_lease_mgr.h>
 #include <dhcpsrv/d2_client_mgr.h>
+#include <dhcpsrv/packet_pipeline.h>
 #include <dhcpsrv/subnet.h>
 #include <hooks/callout_handle.h>
 
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <iostream>
 #include <queue>
+#include <vector>
 
 namespace isc {
 namespace dhcp {
@@ -100,6 +105,141 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Default capacity of the queues of the packet processing
+    /// pipeline.
+    static const size_t DEFAULT_QUEUE_SIZE = 1024;
+
+    /// @brief Maximum number of packets received with a single call to
+    /// the @c IfaceMgr.
+    static const size_t RECEIVE_BATCH_SIZE = 32;
+
+    /// @brief Maximum number of lease writes committed to the lease
+    /// database at once when the packets are processed concurrently.
+    static const size_t LEASE_WRITE_BATCH_SIZE = 64;
+
+    /// @brief Configures the server to process packets concurrently.
+    ///
+    /// By default the server receives, processes and responds to the
+    /// packets one by one in a single thread. If the number of workers is
+    /// greater than 0, the @c run method hands the received packets over to
+    /// the specified number of worker threads and the responses are sent by
+    /// a dedicated thread. Each worker has its own queue of the specified
+    /// size. The packets are assigned to the workers by the hash of the
+    /// client identifier (see @c getQueryKey), so the packets sent by the
+    /// same client are processed in the order in which they were received.
+    /// The configuration is not modified while the workers run (see
+    /// @c waitForPendingPackets), so the packets are processed concurrently
+    /// and only the state which is really shared is locked: the allocations
+    /// in a subnet are serialized by the allocation mutex of the subnet,
+    /// the lease managers and the hooks callouts lock themselves and each
+    /// worker uses its own callout handle. See
+    /// @ref isc::dhcp::PacketPipeline.
+    ///
+    /// The workers don't wait for the lease database either: the leases
+    /// allocated or extended for a Request, Renew or Rebind are written by
+    /// the @ref isc::dhcp::AsyncLeaseMgr and the Reply is handed over to
+    /// the sender when they have been written, so as the worker may process
+    /// the next packet in the meantime. If the write fails, the Reply is
+    /// dropped. The releases and declines are still written synchronously,
+    /// because their Reply depends on the result.
+    ///
+    /// This function must be called before @c run.
+    ///
+    /// @param workers Number of worker threads; 0 disables the concurrent
+    /// processing.
+    /// @param queue_size Maximum number of packets waiting for each worker.
+    ///
+    /// @throw isc::InvalidOperation if called while the server is running.
+    /// @throw isc::BadValue if the queue size is 0.
+    void setWorkerThreads(const size_t workers,
+                          const size_t queue_size = DEFAULT_QUEUE_SIZE);
+
+    /// @brief Returns the number of worker threads.
+    size_t getWorkerThreads() const {
+        return (workers_);
+    }
+
+    /// @brief Waits until all received packets have been processed.
+    ///
+    /// When the packets are processed concurrently, this function must
+    /// be called before the server configuration is modified. It returns
+    /// when the leases of the processed packets have been written and the
+    /// responses have been sent. It must be
+    /// called from the thread running @c run. It returns immediately if
+    /// the packets are processed in a single thread.
+    void waitForPendingPackets();
+
+    /// @brief Returns the pool of the response packets.
+    ///
+    /// The responses are recycled once they have been sent. The numbers
+    /// of the packets allocated and reused by the pool show how many
+    /// packets are allocated per transaction.
+    const PktPool<Pkt6>& getResponsePool() const {
+        return (response_pool_);
+    }
+
+    /// @brief Returns the manager writing the leases asynchronously.
+    ///
+    /// It only exists while the packets are processed concurrently.
+    ///
+    /// @return pointer to the manager or NULL.
+    AsyncLeaseMgr* getAsyncLeaseMgr() {
+        return (async_lease_mgr_.get());
+    }
+
+    /// @brief Selects the address allocation algorithm.
+    ///
+    /// The allocation engine is replaced if the algorithm differs from the
+    /// one in use. As any other configuration change, it must be done
+    /// when no packets are being processed (see @c waitForPendingPackets).
+    ///
+    /// @param alloc_type allocation algorithm
+    void setAllocType(const AllocEngine::AllocType alloc_type);
+
+    /// @brief Returns the address allocation algorithm in use.
+    AllocEngine::AllocType getAllocType() const {
+        return (alloc_type_);
+    }
+
+    /// @brief Enables or disables tracking of the free addresses in pools.
+    ///
+    /// See @c AllocEngine::setPoolTracking for details. The setting is
+    /// retained when the allocation algorithm is changed.
+    ///
+    /// @param track true if the usage of the pools should be tracked
+    void setPoolTracking(const bool track) {
+        alloc_engine_->setPoolTracking(track);
+    }
+
+    /// @brief Checks if tracking of the free addresses in pools is enabled.
+    bool getPoolTracking() const {
+        return (alloc_engine_->getPoolTracking());
+    }
+
+    /// @brief Configures the periodic reclamation of the expired leases.
+    ///
+    /// The server reclaims the expired leases between the packets it
+    /// receives: the leases are removed from the lease database, their
+    /// addresses and prefixes are returned to the pools and the removal of
+    /// their DNS entries is requested from the DHCP-DDNS server, if the DNS
+    /// updates are enabled. The reclamation cycle is interrupted when it
+    /// takes longer than the configured time.
+    ///
+    /// @param interval interval between the reclamation cycles in seconds,
+    ///        0 disables the reclamation
+    /// @param max_leases maximum number of leases reclaimed in one cycle,
+    ///        0 means no limit
+    /// @param max_time maximum duration of the cycle in milliseconds, 0
+    ///        means no limit
+    void setLeaseReclamation(const uint32_t interval,
+                             const uint32_t max_leases,
+                             const uint32_t max_time);
+
+    /// @brief Returns the interval between the lease reclamation cycles.
+    uint32_t getReclaimInterval() const {
+        return (reclaim_interval_);
+    }
+
     /// @brief Get UDP port on which server should listen.
     ///
     /// Typically, server listens on UDP port 547. Other ports are only
@@ -212,19 +352,29 @@ protected:
     /// leases.
     ///
     /// @param request a message received from client
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted. If it is not specified, the leases are written
+    ///        before the function returns.
     ///
     /// @return REPLY message or NULL
-    Pkt6Ptr processRequest(const Pkt6Ptr& request);
+    Pkt6Ptr processRequest(const Pkt6Ptr& request,
+                           const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Stub function that will handle incoming RENEW messages.
     ///
     /// @param renew message received from client
-    Pkt6Ptr processRenew(const Pkt6Ptr& renew);
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
+    Pkt6Ptr processRenew(const Pkt6Ptr& renew,
+                         const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Stub function that will handle incoming REBIND messages.
     ///
     /// @param rebind message received from client
-    Pkt6Ptr processRebind(const Pkt6Ptr& rebind);
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
+    Pkt6Ptr processRebind(const Pkt6Ptr& rebind,
+                          const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Stub function that will handle incoming CONFIRM messages.
     ///
@@ -274,13 +424,16 @@ protected:
     /// message should contain Client FQDN option being sent by the server
     /// to the client (if the client sent this option to the server).
     /// @param ia pointer to client's IA_NA option (client's request)
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
     ///
     /// @return IA_NA option (server's response)
     OptionPtr assignIA_NA(const isc::dhcp::Subnet6Ptr& subnet,
                           const isc::dhcp::DuidPtr& duid,
                           const isc::dhcp::Pkt6Ptr& query,
                           const isc::dhcp::Pkt6Ptr& answer,
-                          Option6IAPtr ia);
+                          Option6IAPtr ia,
+                          const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Processes IA_PD option (and assigns prefixes if necessary).
     ///
@@ -294,10 +447,13 @@ protected:
     /// @param duid client's duid
     /// @param query client's message (typically SOLICIT or REQUEST)
     /// @param ia pointer to client's IA_PD option (client's request)
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
     /// @return IA_PD option (server's response)
     OptionPtr assignIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
                           const Pkt6Ptr& query,
-                          boost::shared_ptr<Option6IA> ia);
+                          boost::shared_ptr<Option6IA> ia,
+                          const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Extends lifetime of the specific IA_NA option.
     ///
@@ -326,10 +482,13 @@ protected:
     /// to the client (if the client sent this option to the server).
     /// @param ia IA_NA option which carries adress for which lease lifetime
     /// will be extended.
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
     /// @return IA_NA option (server's response)
     OptionPtr extendIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
                           const Pkt6Ptr& query, const Pkt6Ptr& answer,
-                          Option6IAPtr ia);
+                          Option6IAPtr ia,
+                          const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Extends lifetime of the prefix.
     ///
@@ -346,12 +505,15 @@ protected:
     /// @param duid client's duid
     /// @param query client's message
     /// @param ia IA_PD option that is being renewed
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
     /// @return IA_PD option (server's response)
     /// @throw DHCPv6DiscardMessageError when the message being processed should
     /// be discarded by the server, i.e. there is no binding for the client doing
     /// Rebind.
     OptionPtr extendIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
-                          const Pkt6Ptr& query, Option6IAPtr ia);
+                          const Pkt6Ptr& query, Option6IAPtr ia,
+                          const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Releases specific IA_NA option
     ///
@@ -437,7 +599,10 @@ protected:
     /// @param answer server's message (IA_NA options will be added here).
     /// This message should contain Client FQDN option being sent by the server
     /// to the client (if the client sent this option to the server).
-    void assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer);
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
+    void assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer,
+                      const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Processes Client FQDN Option.
     ///
@@ -507,7 +672,10 @@ protected:
     ///
     /// @param query client's Renew or Rebind message
     /// @param reply server's response
-    void extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply);
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c processRequest).
+    void extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply,
+                      const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Attempts to release received addresses
     ///
@@ -557,7 +725,12 @@ protected:
     static std::string duidToString(const OptionPtr& opt);
 
 
-    /// @brief dummy wrapper around IfaceMgr::receive6
+    /// @brief dummy wrapper around IfaceMgr::receiveBatch6
+    ///
+    /// The packets are received from the @c IfaceMgr in batches of up to
+    /// @c RECEIVE_BATCH_SIZE packets and returned one by one. The
+    /// @c IfaceMgr is only called when all packets of the previous batch
+    /// have been returned.
     ///
     /// This method is useful for testing purposes, where its replacement
     /// simulates reception of a packet. For that purpose it is protected.
@@ -569,6 +742,55 @@ protected:
     /// simulates transmission of a packet. For that purpose it is protected.
     virtual void sendPacket(const Pkt6Ptr& pkt);
 
+    /// @brief dummy wrapper around IfaceMgr::sendBatch()
+    ///
+    /// This method is useful for testing purposes, where its replacement
+    /// simulates transmission of the packets. For that purpose it is
+    /// protected. The packets which can't be sent are logged and skipped.
+    virtual void sendPackets(const std::vector<Pkt6Ptr>& pkts);
+
+    /// @brief Processes the received packet.
+    ///
+    /// Runs the hooks, parses the packet, generates the response and
+    /// assembles its wire format. This function may be called concurrently
+    /// by the worker threads.
+    ///
+    /// When the leases written by the worker are written asynchronously,
+    /// the response is handed over to the sender of the pipeline once they
+    /// have been written, rather than returned.
+    ///
+    /// @param query Packet received from the client.
+    ///
+    /// @return Response to be sent or null pointer if there is no response
+    /// or it is sent later.
+    Pkt6Ptr processPacket(Pkt6Ptr query);
+
+    /// @brief Sends the response, logging any errors.
+    ///
+    /// @param rsp Response returned by @c processPacket.
+    void sendResponse(const Pkt6Ptr& rsp);
+
+    /// @brief Sends the batch of responses, logging any errors.
+    ///
+    /// It is used by the sender thread of the packet processing pipeline,
+    /// so as the responses which piled up are sent together.
+    ///
+    /// @param rsps Responses returned by @c processPacket.
+    void sendResponses(const std::vector<Pkt6Ptr>& rsps);
+
+    /// @brief Returns the key assigning the received packet to a worker.
+    ///
+    /// The key is the hash of the DUID carried in the client identifier
+    /// option. The packet hasn't been parsed yet, so the function looks
+    /// for the option in the wire data, descending into the Relay Message
+    /// options of the relayed packets. If there is no client identifier,
+    /// the hash of the source address of the packet is returned.
+    ///
+    /// @param query Packet received from the client.
+    ///
+    /// @return Key of the packet.
+    static size_t getQueryKey(const Pkt6Ptr& query);
+
     /// @brief Implements a callback function to parse options in the message.
     ///
     /// @param buf a A buffer holding options in on-wire format.
@@ -654,10 +876,43 @@ private:
     ///
     /// @param answer Message being sent to a client, which may hold IA_NA
     /// and Client FQDN options to be used to generate name for a client.
+    /// @param commit Optional commit through which the leases have been
+    /// written. If it is specified, the lease is updated by the thread
+    /// writing the leases, after its pending writes.
     ///
     /// @throw isc::Unexpected if specified message is NULL. This is treated
     /// as a programmatic error.
-    void generateFqdn(const Pkt6Ptr& answer);
+    void generateFqdn(const Pkt6Ptr& answer,
+                      const LeaseCommitPtr& commit = LeaseCommitPtr());
+
+    /// @brief Updates the lease with the hostname generated by the server.
+    ///
+    /// It is invoked by the thread of the @c AsyncLeaseMgr with the lease
+    /// read from the database and queues its update.
+    ///
+    /// @param lease Lease read from the database or null pointer.
+    /// @param addr Address of the lease.
+    /// @param hostname Generated hostname.
+    void updateGeneratedName(const Lease6Ptr& lease,
+                             const isc::asiolink::IOAddress& addr,
+                             const std::string& hostname);
+
+    /// @brief Starts the worker threads processing the packets.
+    void startPipeline();
+
+    /// @brief Hands the response over to the sender when the leases
+    /// written while processing the query have been written.
+    ///
+    /// It is invoked by the thread of the @c AsyncLeaseMgr.
+    ///
+    /// @param rsp Response to be sent.
+    /// @param success Indicates if the leases have been written.
+    void leasesCommitted(const Pkt6Ptr& rsp, const bool success);
+
+    /// @brief Runs the lease reclamation cycle if it is due.
+    ///
+    /// @return time in seconds until the next reclamation cycle
+    uint32_t reclaimExpiredLeases();
 
     /// @brief Allocation Engine.
     /// Pointer to the allocation engine that we are currently using
@@ -665,12 +920,53 @@ private:
     /// during normal operation (e.g. to use different allocators)
     boost::shared_ptr<AllocEngine> alloc_engine_;
 
+    /// @brief Allocation algorithm used by the allocation engine.
+    AllocEngine::AllocType alloc_type_;
+
     /// Server DUID (to be sent in server-identifier option)
     OptionPtr serverid_;
 
     /// UDP port number on which server listens.
     uint16_t port_;
 
+    /// @brief Number of worker threads processing the packets.
+    size_t workers_;
+
+    /// @brief Maximum number of packets waiting for each worker.
+    size_t queue_size_;
+
+    /// @brief Multi-threaded packet processing pipeline.
+    ///
+    /// It is only created when the server is configured to use workers.
+    boost::scoped_ptr<PacketPipeline<Pkt6Ptr> > pipeline_;
+
+    /// @brief Manager writing the leases allocated by the workers.
+    ///
+    /// It exists when the pipeline exists.
+    boost::scoped_ptr<AsyncLeaseMgr> async_lease_mgr_;
+
+    /// @brief Pool of the response packets.
+    PktPool<Pkt6> response_pool_;
+
+    /// @brief Interval between the lease reclamation cycles in seconds.
+    uint32_t reclaim_interval_;
+
+    /// @brief Maximum number of leases reclaimed in one cycle.
+    uint32_t max_reclaim_leases_;
+
+    /// @brief Maximum duration of the reclamation cycle in milliseconds.
+    uint32_t max_reclaim_time_;
+
+    /// @brief Time of the next lease reclamation cycle.
+    time_t next_reclaim_;
+
+    /// @brief Packets received in the last batch.
+    std::vector<Pkt6Ptr> received_;
+
+    /// @brief Index of the next packet of the last batch to be returned by
+    /// @c receivePacket.
+    size_t next_received_;
+
 protected:
 
     /// Indicates if shutdown is in progress. Setting it to true will
@@ -38,13 +38,20 @@ using namespace std;
 namespace {
 const char* const DHCP6_NAME = "b10-dhcp6";
 
+/// @brief Maximum number of worker threads which can be specified.
+const int MAX_WORKER_THREADS = 256;
+
 void
 usage() {
-    cerr << "Usage: " << DHCP6_NAME << " [-v] [-s] [-p number]" << endl;
+    cerr << "Usage: " << DHCP6_NAME << " [-v] [-s] [-p number] [-w number]"
+         << endl;
     cerr << "  -v: verbose output" << endl;
     cerr << "  -s: stand-alone mode (don't connect to BIND10)" << endl;
     cerr << "  -p number: specify non-standard port number 1-65535 "
          << "(useful for testing only)" << endl;
+    cerr << "  -w number: process packets using the specified number of "
+         << "worker threads 0-" << MAX_WORKER_THREADS << " (default 0, "
+         << "process packets in the main thread)" << endl;
     exit(EXIT_FAILURE);
 }
 } // end of anonymous namespace
@@ -56,8 +63,9 @@ main(int argc, char* argv[]) {
                                          // useful for testing only.
     bool stand_alone = false;  // Should be connect to BIND10 msgq?
     bool verbose_mode = false; // Should server be verbose?
+    int workers = 0; // Number of worker threads processing packets.
 
-    while ((ch = getopt(argc, argv, "vsp:")) != -1) {
+    while ((ch = getopt(argc, argv, "vsp:w:")) != -1) {
         switch (ch) {
         case 'v':
             verbose_mode = true;
@@ -82,6 +90,20 @@ main(int argc, char* argv[]) {
             }
             break;
 
+        case 'w':
+            try {
+                workers = boost::lexical_cast<int>(optarg);
+            } catch (const boost::bad_lexical_cast &) {
+                workers = -1;
+            }
+            if (workers < 0 || workers > MAX_WORKER_THREADS) {
+                cerr << "Failed to parse number of worker threads: ["
+                     << optarg << "], 0-" << MAX_WORKER_THREADS
+                     << " allowed." << endl;
+                usage();
+            }
+            break;
+
         default:
             usage();
         }
@@ -105,6 +127,7 @@ main(int argc, char* argv[]) {
     int ret = EXIT_SUCCESS;
     try {
         ControlledDhcpv6Srv server(port_number);
+        server.setWorkerThreads(workers);
         if (!stand_alone) {
             try {
                 server.establishSession();
@@ -17,6 +17,7 @@
 #include <config/ccsession.h>
 #include <dhcp/dhcp6.h>
 #include <dhcp6/ctrl_dhcp6_srv.h>
+#include <dhcpsrv/cfgmgr.h>
 #include <hooks/hooks_manager.h>
 
 #include "marker_file.h"
@@ -104,6 +105,41 @@ TEST_F(CtrlDhcpv6SrvTest, commands) {
     EXPECT_EQ(0, rcode); // Expect success
 }
 
+// Checks that the "pool-stats" command returns the usage of the pools.
+TEST_F(CtrlDhcpv6SrvTest, poolStats) {
+    boost::scoped_ptr<ControlledDhcpv6Srv> srv;
+    ASSERT_NO_THROW(
+        srv.reset(new ControlledDhcpv6Srv(DHCP6_SERVER_PORT + 10000))
+    );
+
+    CfgMgr::instance().deleteSubnets6();
+    Subnet6Ptr subnet(new Subnet6(IOAddress("2001:db8:1::"), 48, 1, 2, 3, 4));
+    Pool6Ptr pool(new Pool6(Lease::TYPE_NA, IOAddress("2001:db8:1::10"),
+                            IOAddress("2001:db8:1::19")));
+    subnet->addPool(pool);
+    CfgMgr::instance().addSubnet6(subnet);
+    ASSERT_NO_THROW(pool->initUsage());
+    pool->markUsed(IOAddress("2001:db8:1::10"));
+
+    ElementPtr params(new isc::data::MapElement());
+    int rcode = -1;
+    ConstElementPtr result =
+        ControlledDhcpv6Srv::execDhcpv6ServerCommand("pool-stats", params);
+    ConstElementPtr stats = parseAnswer(rcode, result);
+    EXPECT_EQ(0, rcode);
+
+    ASSERT_TRUE(stats);
+    ASSERT_EQ(Element::list, stats->getType());
+    ASSERT_EQ(1, stats->size());
+    ConstElementPtr pool_stats = stats->get(0);
+    EXPECT_EQ(pool->toText(), pool_stats->get("pool")->stringValue());
+    EXPECT_EQ(10, pool_stats->get("capacity")->intValue());
+    EXPECT_TRUE(pool_stats->get("tracked")->boolValue());
+    EXPECT_EQ(1, pool_stats->get("used")->intValue());
+
+    CfgMgr::instance().deleteSubnets6();
+}
+
 // Check that the "libreload" command will reload libraries
 
 TEST_F(CtrlDhcpv6SrvTest, libreload) {
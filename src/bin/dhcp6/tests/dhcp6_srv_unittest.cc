@@ -30,21 +30,25 @@
 #include <dhcp/dhcp6.h>
 #include <dhcp/docsis3_option_defs.h>
 #include <dhcp/tests/iface_mgr_test_config.h>
+#include <dhcpsrv/async_lease_mgr.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <dhcpsrv/lease_mgr_factory.h>
 #include <dhcpsrv/utils.h>
 #include <util/buffer.h>
 #include <util/range_utilities.h>
+#include <util/threads/sync.h>
 #include <hooks/server_hooks.h>
 
 #include <dhcp6/tests/dhcp6_test_utils.h>
+#include <boost/bind.hpp>
 #include <boost/pointer_cast.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 #include <unistd.h>
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 
 using namespace isc;
@@ -1471,6 +1475,204 @@ TEST_F(Dhcpv6SrvTest, portsRelayedTraffic) {
     EXPECT_EQ(DHCP6_SERVER_PORT, adv->getRemotePort());
 }
 
+// Checks that the key assigning the received packets to the worker threads
+// is derived from the client identifier, also for the relayed packets.
+TEST_F(Dhcpv6SrvTest, queryKey) {
+    // The DUID carried in the client identifier of captureSimpleSolicit.
+    const uint8_t duid[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    OptionPtr clientid(new Option(Option::V6, D6O_CLIENTID,
+                                  OptionBuffer(duid, duid + sizeof(duid))));
+
+    Pkt6Ptr sol = captureSimpleSolicit();
+    const size_t key = NakedDhcpv6Srv::getQueryKey(sol);
+
+    // Another message from the same client, received through the relay,
+    // must be assigned the same key.
+    Pkt6Ptr req(new Pkt6(DHCPV6_REQUEST, 1234));
+    req->addOption(clientid);
+    req->addOption(generateIA(D6O_IA_NA, 234, 1500, 3000));
+    Pkt6::RelayInfo relay;
+    relay.msg_type_ = DHCPV6_RELAY_FORW;
+    relay.hop_count_ = 1;
+    relay.linkaddr_ = IOAddress("2001:db8:1::1");
+    relay.peeraddr_ = IOAddress("fe80::1");
+    relay.options_.insert(make_pair(D6O_INTERFACE_ID,
+                                    generateInterfaceId("eth0")));
+    req->relay_info_.push_back(relay);
+    ASSERT_NO_THROW(req->pack());
+    Pkt6Ptr relayed(new Pkt6(static_cast<const uint8_t*>
+                             (req->getBuffer().getData()),
+                             req->getBuffer().getLength()));
+    EXPECT_EQ(key, NakedDhcpv6Srv::getQueryKey(relayed));
+
+    // Another client gets a different key.
+    Pkt6Ptr other(new Pkt6(DHCPV6_SOLICIT, 1234));
+    other->addOption(generateClientId());
+    ASSERT_NO_THROW(other->pack());
+    Pkt6Ptr received(new Pkt6(static_cast<const uint8_t*>
+                              (other->getBuffer().getData()),
+                              other->getBuffer().getLength()));
+    EXPECT_NE(key, NakedDhcpv6Srv::getQueryKey(received));
+
+    // The malformed packets must not cause reading beyond the buffer.
+    const uint8_t truncated[] = { 1, 0xca, 0xfe, 0x01, 0, 1, 0, 10, 1, 2 };
+    EXPECT_NO_THROW(NakedDhcpv6Srv::getQueryKey(
+        Pkt6Ptr(new Pkt6(truncated, sizeof(truncated)))));
+    const uint8_t relay_hdr[] = { DHCPV6_RELAY_FORW, 0 };
+    EXPECT_NO_THROW(NakedDhcpv6Srv::getQueryKey(
+        Pkt6Ptr(new Pkt6(relay_hdr, sizeof(relay_hdr)))));
+}
+
+// Checks that the server processes the queries using the worker threads
+// and sends the responses to all of them.
+TEST_F(Dhcpv6SrvTest, workerThreads) {
+    NakedDhcpv6Srv srv(0);
+    EXPECT_EQ(0, srv.getWorkerThreads());
+    EXPECT_THROW(srv.setWorkerThreads(4, 0), isc::BadValue);
+    ASSERT_NO_THROW(srv.setWorkerThreads(4, 16));
+    EXPECT_EQ(4, srv.getWorkerThreads());
+
+    // Each client uses its own DUID, so the packets are spread across
+    // the workers.
+    const uint32_t packets_num = 10;
+    for (uint32_t transid = 1; transid <= packets_num; ++transid) {
+        Pkt6Ptr sol(new Pkt6(DHCPV6_SOLICIT, transid));
+        OptionBuffer duid(16, static_cast<uint8_t>(transid));
+        sol->addOption(OptionPtr(new Option(Option::V6, D6O_CLIENTID, duid)));
+        sol->addOption(generateIA(D6O_IA_NA, 234, 1500, 3000));
+        ASSERT_NO_THROW(sol->pack());
+
+        // The server expects the wire data, so create the packet from it.
+        Pkt6Ptr received(new Pkt6(static_cast<const uint8_t*>
+                                  (sol->getBuffer().getData()),
+                                  sol->getBuffer().getLength()));
+        captureSetDefaultFields(received);
+        srv.fakeReceive(received);
+    }
+
+    // The server exits when there are no more packets to receive, after
+    // the workers have processed the queued ones.
+    srv.run();
+
+    ASSERT_EQ(packets_num, srv.fake_sent_.size());
+    std::set<uint32_t> transids;
+    for (list<Pkt6Ptr>::const_iterator rsp = srv.fake_sent_.begin();
+         rsp != srv.fake_sent_.end(); ++rsp) {
+        EXPECT_EQ(DHCPV6_ADVERTISE, (*rsp)->getType());
+        transids.insert((*rsp)->getTransid());
+    }
+    EXPECT_EQ(packets_num, transids.size());
+}
+
+/// @brief Server holding the lease writes until it has sent an advertise.
+///
+/// The lookup queued when the first packet is received blocks the thread
+/// writing the leases until an Advertise has been sent, or for 10 seconds
+/// at most, so as the test fails rather than hangs if the Advertise isn't
+/// sent while a lease write is pending.
+class CommitBlockingDhcpv6Srv : public NakedDhcpv6Srv {
+public:
+    /// @brief Constructor.
+    CommitBlockingDhcpv6Srv()
+        : NakedDhcpv6Srv(0), blocked_(false), advertise_sent_(false) {
+    }
+
+    /// @brief Blocks the lease writes and receives the packet.
+    virtual Pkt6Ptr receivePacket(int timeout) {
+        if (!blocked_) {
+            blocked_ = true;
+            AsyncLeaseMgr* lease_mgr = getAsyncLeaseMgr();
+            if (lease_mgr) {
+                lease_mgr->getLease6(Lease::TYPE_NA, IOAddress("::"),
+                    boost::bind(&CommitBlockingDhcpv6Srv::waitForAdvertise,
+                                this, _1));
+            }
+        }
+        return (NakedDhcpv6Srv::receivePacket(timeout));
+    }
+
+    /// @brief Sends the packets and unblocks the lease writes if there
+    /// is an advertise among them.
+    virtual void sendPackets(const std::vector<Pkt6Ptr>& pkts) {
+        NakedDhcpv6Srv::sendPackets(pkts);
+        for (std::vector<Pkt6Ptr>::const_iterator pkt = pkts.begin();
+             pkt != pkts.end(); ++pkt) {
+            if ((*pkt)->getType() == DHCPV6_ADVERTISE) {
+                util::thread::Mutex::Locker lock(mutex_);
+                advertise_sent_ = true;
+                cond_.signal();
+            }
+        }
+    }
+
+private:
+    /// @brief Waits until the advertise has been sent.
+    void waitForAdvertise(const Lease6Ptr&) {
+        util::thread::Mutex::Locker lock(mutex_);
+        while (!advertise_sent_ && cond_.timedWait(mutex_, 10000000)) {
+        }
+    }
+
+    bool blocked_;
+    util::thread::Mutex mutex_;
+    util::thread::CondVar cond_;
+    bool advertise_sent_;
+};
+
+// Checks that the worker processes the next packet while the lease
+// allocated for the previous one is being written, and that the response
+// is sent when the lease has been written.
+TEST_F(Dhcpv6SrvTest, workerThreadsPendingCommit) {
+    CommitBlockingDhcpv6Srv srv;
+    // A single worker processes the packets of both clients.
+    ASSERT_NO_THROW(srv.setWorkerThreads(1, 16));
+
+    // The Request of the first client is followed by the Solicit of the
+    // second one.
+    const uint8_t types[] = { DHCPV6_REQUEST, DHCPV6_SOLICIT };
+    for (uint32_t transid = 1; transid <= 2; ++transid) {
+        Pkt6Ptr query(new Pkt6(types[transid - 1], transid));
+        OptionBuffer duid(16, static_cast<uint8_t>(transid));
+        query->addOption(OptionPtr(new Option(Option::V6, D6O_CLIENTID,
+                                              duid)));
+        query->addOption(generateIA(D6O_IA_NA, 234, 1500, 3000));
+        if (query->getType() == DHCPV6_REQUEST) {
+            query->addOption(srv.getServerID());
+        }
+        ASSERT_NO_THROW(query->pack());
+
+        Pkt6Ptr received(new Pkt6(static_cast<const uint8_t*>
+                                  (query->getBuffer().getData()),
+                                  query->getBuffer().getLength()));
+        captureSetDefaultFields(received);
+        srv.fakeReceive(received);
+    }
+
+    srv.run();
+
+    // The advertise has been sent while the lease of the first client was
+    // being written.
+    ASSERT_EQ(2, srv.fake_sent_.size());
+    Pkt6Ptr adv = srv.fake_sent_.front();
+    EXPECT_EQ(DHCPV6_ADVERTISE, adv->getType());
+    EXPECT_EQ(2, adv->getTransid());
+    Pkt6Ptr reply = srv.fake_sent_.back();
+    EXPECT_EQ(DHCPV6_REPLY, reply->getType());
+    EXPECT_EQ(1, reply->getTransid());
+
+    // The leases offered to the clients differ and the one of the first
+    // client is in the database.
+    boost::shared_ptr<Option6IAAddr> adv_addr =
+        checkIA_NA(adv, 234, subnet_->getT1(), subnet_->getT2());
+    ASSERT_TRUE(adv_addr);
+    boost::shared_ptr<Option6IAAddr> reply_addr =
+        checkIA_NA(reply, 234, subnet_->getT1(), subnet_->getT2());
+    ASSERT_TRUE(reply_addr);
+    EXPECT_NE(adv_addr->getAddress(), reply_addr->getAddress());
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                                                      reply_addr->getAddress()));
+}
+
 // Checks if server is able to handle a relayed traffic from DOCSIS3.0 modems
 // @todo Uncomment this test as part of #3180 work.
 // Kea code currently fails to handle docsis traffic.
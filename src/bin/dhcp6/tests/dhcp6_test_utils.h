@@ -82,6 +82,13 @@ public:
         fake_sent_.push_back(pkt);
     }
 
+    /// @brief fake sending of the packets
+    ///
+    /// Stores the packets in fake_send_ list, as @c sendPacket does.
+    virtual void sendPackets(const std::vector<isc::dhcp::Pkt6Ptr>& pkts) {
+        fake_sent_.insert(fake_sent_.end(), pkts.begin(), pkts.end());
+    }
+
     /// @brief adds a packet to fake receive queue
     ///
     /// See fake_received_ field for description
@@ -110,6 +117,7 @@ public:
     using Dhcpv6Srv::loadServerID;
     using Dhcpv6Srv::writeServerID;
     using Dhcpv6Srv::unpackOptions;
+    using Dhcpv6Srv::getQueryKey;
     using Dhcpv6Srv::shutdown_;
     using Dhcpv6Srv::name_change_reqs_;
     using Dhcpv6Srv::VENDOR_CLASS_PREFIX;
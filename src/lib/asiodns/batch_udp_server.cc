@@ -0,0 +1,353 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asio.hpp>
+#include <asio/error.hpp>
+
+#include "batch_udp_server.h"
+#include "logger.h"
+
+#include <asiolink/dummy_io_cb.h>
+#include <asiolink/udp_endpoint.h>
+#include <asiolink/udp_socket.h>
+
+#include <boost/bind.hpp>
+
+#include <cassert>
+#include <cstring>
+
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+
+using namespace std;
+using namespace isc::asiolink;
+
+namespace {
+// Whether a failed receive or send only means that the operation can't be
+// done right now, which is not worth logging.
+bool
+isTransientError(const int error) {
+    return (error == EAGAIN || error == EWOULDBLOCK || error == EINTR);
+}
+}
+
+namespace isc {
+namespace asiodns {
+
+const size_t BatchUDPServer::DEFAULT_BATCH_SIZE;
+
+#if defined (HAVE_RECVMMSG) && defined (HAVE_SENDMMSG)
+struct BatchUDPServer::MessageHeaders {
+    explicit MessageHeaders(const size_t batch_size) :
+        recv_iovs_(batch_size), recv_msgs_(batch_size),
+        send_iovs_(batch_size), send_msgs_(batch_size)
+    {}
+    std::vector<struct iovec> recv_iovs_;
+    std::vector<struct mmsghdr> recv_msgs_;
+    std::vector<struct iovec> send_iovs_;
+    std::vector<struct mmsghdr> send_msgs_;
+};
+#else
+// Without recvmmsg() and sendmmsg(), the packets are received and sent
+// one by one.
+struct BatchUDPServer::MessageHeaders {
+    explicit MessageHeaders(const size_t) {}
+};
+#endif
+
+BatchUDPServerPtr
+BatchUDPServer::create(asio::io_service& io_service, const int fd,
+                       const int af, DNSLookup* lookup,
+                       const size_t batch_size)
+{
+    return (BatchUDPServerPtr(new BatchUDPServer(io_service, fd, af, lookup,
+                                                 batch_size)));
+}
+
+BatchUDPServer::BatchUDPServer(asio::io_service& io_service, const int fd,
+                               const int af, DNSLookup* lookup,
+                               const size_t batch_size) :
+    batch_size_(batch_size),
+    query_(new isc::dns::Message(isc::dns::Message::PARSE)),
+    lookup_callback_(lookup), resume_called_(false), done_(false),
+    stopped_(false)
+{
+    if (af != AF_INET && af != AF_INET6) {
+        isc_throw(InvalidParameter, "Address family must be either AF_INET "
+                  "or AF_INET6, not " << af);
+    }
+    if (!lookup) {
+        isc_throw(InvalidParameter, "null lookup callback given to "
+                  "BatchUDPServer");
+    }
+    if (batch_size == 0) {
+        isc_throw(InvalidParameter, "batch size of BatchUDPServer must be "
+                  "positive");
+    }
+    data_.resize(batch_size * MAX_LENGTH);
+    // Each packet gets a buffer of its own, so they are not copied from a
+    // single default one.
+    packets_.reserve(batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+        packets_.push_back(Packet());
+    }
+    headers_.reset(new MessageHeaders(batch_size));
+
+    LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_FD_ADD_UDP).arg(fd);
+    try {
+        socket_.reset(new asio::ip::udp::socket(io_service));
+        socket_->assign(af == AF_INET6 ? asio::ip::udp::v6() :
+                        asio::ip::udp::v4(), fd);
+    } catch (const std::exception& exception) {
+        // Whatever the thing throws, it is something from ASIO and we
+        // convert it
+        isc_throw(IOError, exception.what());
+    }
+    udp_socket_.reset(new UDPSocket<DummyIOCallback>(*socket_));
+
+#if defined (HAVE_RECVMMSG) && defined (HAVE_SENDMMSG)
+    // The received data and the senders always go to the same place, so
+    // the receive headers are set once; only the lengths are reset before
+    // each call.
+    for (size_t i = 0; i < batch_size; ++i) {
+        struct iovec& iov = headers_->recv_iovs_[i];
+        iov.iov_base = &data_[i * MAX_LENGTH];
+        iov.iov_len = MAX_LENGTH;
+        struct msghdr& m = headers_->recv_msgs_[i].msg_hdr;
+        memset(&m, 0, sizeof(m));
+        m.msg_name = packets_[i].sender_.data();
+        m.msg_iov = &iov;
+        m.msg_iovlen = 1;
+    }
+#endif
+}
+
+BatchUDPServer::~BatchUDPServer() {
+}
+
+void
+BatchUDPServer::scheduleRead() {
+    // We only wait for the socket to become readable; the data is then
+    // read directly, as much as is available.
+    socket_->async_receive(
+        asio::null_buffers(),
+        boost::bind(&BatchUDPServer::handleRead, shared_from_this(), _1));
+}
+
+size_t
+BatchUDPServer::receiveBatch() {
+    const int fd = socket_->native();
+#if defined (HAVE_RECVMMSG) && defined (HAVE_SENDMMSG)
+    for (size_t i = 0; i < batch_size_; ++i) {
+        headers_->recv_msgs_[i].msg_hdr.msg_namelen =
+            packets_[i].sender_.capacity();
+    }
+    // Don't wait: the socket may be shared with other servers, which may
+    // have taken the packets since it was reported readable.
+    const int result = recvmmsg(fd, &headers_->recv_msgs_[0], batch_size_,
+                                MSG_DONTWAIT, NULL);
+    if (result < 0) {
+        if (!isTransientError(errno)) {
+            LOG_ERROR(logger, ASIODNS_UDP_BATCH_RECEIVE_FAIL).
+                arg(strerror(errno));
+        }
+        return (0);
+    }
+    for (int i = 0; i < result; ++i) {
+        const struct mmsghdr& m = headers_->recv_msgs_[i];
+        packets_[i].length_ = m.msg_len;
+        packets_[i].sender_.resize(m.msg_hdr.msg_namelen);
+    }
+    return (result);
+#else
+    size_t count = 0;
+    while (count < batch_size_) {
+        Packet& packet = packets_[count];
+        socklen_t namelen = packet.sender_.capacity();
+        const ssize_t result = recvfrom(fd, &data_[count * MAX_LENGTH],
+                                        MAX_LENGTH, MSG_DONTWAIT,
+                                        packet.sender_.data(), &namelen);
+        if (result < 0) {
+            if (!isTransientError(errno)) {
+                LOG_ERROR(logger, ASIODNS_UDP_BATCH_RECEIVE_FAIL).
+                    arg(strerror(errno));
+            }
+            break;
+        }
+        packet.length_ = result;
+        packet.sender_.resize(namelen);
+        ++count;
+    }
+    return (count);
+#endif
+}
+
+void
+BatchUDPServer::sendBatch(const size_t count) {
+    const int fd = socket_->native();
+#if defined (HAVE_RECVMMSG) && defined (HAVE_SENDMMSG)
+    // Gather the answers, skipping the packets which are not answered.
+    size_t answers = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Packet& packet = packets_[i];
+        if (!packet.done_) {
+            continue;
+        }
+        struct iovec& iov = headers_->send_iovs_[answers];
+        iov.iov_base = const_cast<void*>(packet.output_buffer_->getData());
+        iov.iov_len = packet.output_buffer_->getLength();
+        struct msghdr& m = headers_->send_msgs_[answers].msg_hdr;
+        memset(&m, 0, sizeof(m));
+        m.msg_name = packet.sender_.data();
+        m.msg_namelen = packet.sender_.size();
+        m.msg_iov = &iov;
+        m.msg_iovlen = 1;
+        ++answers;
+    }
+
+    // The sendmmsg() stops at the first answer which can't be sent, e.g.
+    // because of an unreachable destination.  That one is dropped, as
+    // SyncUDPServer would, and the remaining ones are sent in the next call.
+    size_t sent = 0;
+    while (sent < answers) {
+        const int result = sendmmsg(fd, &headers_->send_msgs_[sent],
+                                    answers - sent, 0);
+        if (result > 0) {
+            sent += result;
+            continue;
+        }
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        const struct msghdr& m = headers_->send_msgs_[sent].msg_hdr;
+        asio::ip::udp::endpoint destination;
+        memcpy(destination.data(), m.msg_name, m.msg_namelen);
+        destination.resize(m.msg_namelen);
+        LOG_ERROR(logger, ASIODNS_UDP_BATCH_SEND_FAIL).
+            arg(destination.address().to_string()).
+            arg(result < 0 ? strerror(errno) : "no message sent");
+        ++sent;
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        Packet& packet = packets_[i];
+        if (!packet.done_) {
+            continue;
+        }
+        if (sendto(fd, packet.output_buffer_->getData(),
+                   packet.output_buffer_->getLength(), 0,
+                   packet.sender_.data(), packet.sender_.size()) < 0) {
+            LOG_ERROR(logger, ASIODNS_UDP_BATCH_SEND_FAIL).
+                arg(packet.sender_.address().to_string()).
+                arg(strerror(errno));
+        }
+    }
+#endif
+}
+
+void
+BatchUDPServer::handleRead(const asio::error_code& ec) {
+    if (stopped_) {
+        // See SyncUDPServer::handleRead().
+        assert(socket_ && !socket_->is_open());
+        return;
+    }
+    if (ec) {
+        using namespace asio::error;
+        const asio::error_code::value_type err_val = ec.value();
+
+        // See TCPServer::operator() for details on error handling.
+        if (err_val == operation_aborted || err_val == bad_descriptor) {
+            return;
+        }
+        if (err_val != would_block && err_val != try_again &&
+            err_val != interrupted) {
+            LOG_ERROR(logger, ASIODNS_UDP_BATCH_RECEIVE_FAIL).
+                arg(ec.message());
+        }
+        scheduleRead();
+        return;
+    }
+
+    const size_t count = receiveBatch();
+    for (size_t i = 0; i < count; ++i) {
+        Packet& packet = packets_[i];
+        packet.done_ = false;
+        if (packet.length_ == 0) {
+            continue;
+        }
+
+        // See SyncUDPServer::handleRead() as to query_.
+        packet.output_buffer_->clear();
+        done_ = false;
+        resume_called_ = false;
+
+        const UDPEndpoint endpoint(packet.sender_);
+        const IOMessage message(&data_[i * MAX_LENGTH], packet.length_,
+                                *udp_socket_, endpoint);
+        (*lookup_callback_)(message, query_, answer_, packet.output_buffer_,
+                            this);
+
+        if (!resume_called_) {
+            isc_throw(isc::Unexpected,
+                      "No resume called from the lookup callback");
+        }
+        if (stopped_) {
+            // The callback stopped the server; the socket is closed, so
+            // the answers can't be sent anymore.
+            return;
+        }
+        packet.done_ = done_;
+    }
+    sendBatch(count);
+
+    // And schedule handling the next packets.
+    scheduleRead();
+}
+
+void
+BatchUDPServer::operator()(asio::error_code, size_t) {
+    // To start the server, we just wait for data to arrive.
+    scheduleRead();
+}
+
+void
+BatchUDPServer::stop() {
+    // See SyncUDPServer::stop() as to why the socket is closed.
+    socket_->close(ec_);
+    stopped_ = true;
+    if (ec_) {
+        LOG_ERROR(logger, ASIODNS_BATCH_UDP_CLOSE_FAIL).arg(ec_.message());
+    }
+}
+
+void
+BatchUDPServer::resume(const bool done) {
+    resume_called_ = true;
+    done_ = done;
+}
+
+bool
+BatchUDPServer::hasAnswer() {
+    return (done_);
+}
+
+} // namespace asiodns
+} // namespace isc
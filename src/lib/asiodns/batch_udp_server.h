@@ -0,0 +1,221 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef BATCH_UDP_SERVER_H
+#define BATCH_UDP_SERVER_H 1
+
+#ifndef ASIO_HPP
+#error "asio.hpp must be included before including this, see asiolink.h as to why"
+#endif
+
+#include "dns_answer.h"
+#include "dns_lookup.h"
+#include "dns_server.h"
+
+#include <dns/message.h>
+#include <asiolink/dummy_io_cb.h>
+#include <asiolink/udp_socket.h>
+#include <util/buffer.h>
+#include <exceptions/exceptions.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace asiodns {
+
+class BatchUDPServer;
+typedef boost::shared_ptr<BatchUDPServer> BatchUDPServerPtr;
+
+/// \brief A synchronous UDP server handling the queries in batches.
+///
+/// Like \c SyncUDPServer, this server expects the lookup callback to
+/// provide the answer right away.  But instead of receiving and answering
+/// one packet at a time, whenever the socket becomes readable it receives
+/// all the packets queued on it, up to the batch size, passes them to the
+/// lookup callback back to back and sends all the answers at once.  Under
+/// load, this saves most of the system calls and of the event loop
+/// dispatching per query.
+///
+/// Where the system supports them, the packets are received with a single
+/// \c recvmmsg() call and the answers sent with a single \c sendmmsg()
+/// call.  Otherwise the server falls back to a loop of non-blocking
+/// \c recvfrom() calls and to one \c sendto() per answer, which still
+/// saves the event loop dispatching.
+///
+/// As the callback is given a separate output buffer for each packet of a
+/// batch, it must not keep a reference to the buffer once it returns, which
+/// is what the "synchronous" mode of \c DNSService guarantees anyway.
+///
+/// As for \c SyncUDPServer, objects of this class are created by a static
+/// factory method, as shared pointers, so as they can be passed to the ASIO
+/// callbacks.
+class BatchUDPServer : public DNSServer,
+                       public boost::enable_shared_from_this<BatchUDPServer>,
+                       boost::noncopyable
+{
+public:
+    /// \brief The default maximum number of packets handled in a batch.
+    static const size_t DEFAULT_BATCH_SIZE = 32;
+
+private:
+    /// \brief Constructor.
+    ///
+    /// This is hidden as private (see the class description).
+    BatchUDPServer(asio::io_service& io_service, const int fd, const int af,
+                   DNSLookup* lookup, const size_t batch_size);
+
+public:
+    /// \brief Factory of BatchUDPServer object in the form of shared_ptr.
+    ///
+    /// \param io_service the asio::io_service to work with
+    /// \param fd the file descriptor of opened UDP socket
+    /// \param af address family, either AF_INET or AF_INET6
+    /// \param lookup the callbackprovider for DNS lookup events (must not be
+    ///        NULL)
+    /// \param batch_size the maximum number of packets received and answered
+    ///        at once (must not be 0)
+    ///
+    /// \throw isc::InvalidParameter if af is neither AF_INET nor AF_INET6
+    /// \throw isc::InvalidParameter lookup is NULL or batch_size is 0
+    /// \throw isc::asiolink::IOError when a low-level error happens, like the
+    ///     fd is not a valid descriptor.
+    static BatchUDPServerPtr create(asio::io_service& io_service,
+                                    const int fd, const int af,
+                                    DNSLookup* lookup,
+                                    const size_t batch_size =
+                                    DEFAULT_BATCH_SIZE);
+
+    /// \brief Destructor.
+    virtual ~BatchUDPServer();
+
+    /// \brief Start the BatchUDPServer.
+    ///
+    /// This is the function operator to keep interface with other server
+    /// classes. They need that because they're coroutines.
+    virtual void operator()(asio::error_code ec = asio::error_code(),
+                            size_t length = 0);
+
+    /// \brief Calls the lookup callback
+    virtual void asyncLookup() {
+        isc_throw(Unexpected,
+                  "BatchUDPServer doesn't support asyncLookup by design, use "
+                  "UDPServer if you need it.");
+    }
+
+    /// \brief Stop the running server
+    ///
+    /// The answers to the packets of the current batch which were not sent
+    /// yet are dropped.
+    ///
+    /// \note once the server stopped, it can't restart
+    virtual void stop();
+
+    /// \brief Resume operation
+    ///
+    /// As for \c SyncUDPServer, this must be called directly from the
+    /// lookup callback, for each packet.  Otherwise the server throws an
+    /// Unexpected exception.
+    ///
+    /// \param done Set this to true if the lookup action is done and
+    ///        we have an answer
+    virtual void resume(const bool done);
+
+    /// \brief Check if we have an answer to the current packet
+    ///
+    /// \return true if we have an answer
+    virtual bool hasAnswer();
+
+    /// \brief Clones the object
+    ///
+    /// See \c SyncUDPServer::clone(); this throws Unexpected.
+    virtual DNSServer* clone() {
+        isc_throw(Unexpected, "BatchUDPServer can't be cloned.");
+    }
+
+    /// \brief Return the maximum number of packets handled in a batch.
+    size_t getBatchSize() const {
+        return (batch_size_);
+    }
+
+private:
+    // Maximum size of incoming UDP packet
+    static const size_t MAX_LENGTH = 4096;
+
+    // A packet of the batch: where it is received from, and the answer
+    // to it, if any.
+    struct Packet {
+        Packet() :
+            length_(0), output_buffer_(new isc::util::OutputBuffer(0)),
+            done_(false)
+        {}
+        size_t length_;
+        asio::ip::udp::endpoint sender_;
+        isc::util::OutputBufferPtr output_buffer_;
+        bool done_;
+    };
+
+    // The message headers passed to the system, defined in the .cc file
+    // as they depend on what the system supports.
+    struct MessageHeaders;
+
+    // The maximum number of packets in a batch
+    const size_t batch_size_;
+    // Buffer for incoming data, MAX_LENGTH bytes per packet
+    std::vector<uint8_t> data_;
+    std::vector<Packet> packets_;
+    boost::scoped_ptr<MessageHeaders> headers_;
+    // Objects to hold the query message and the answer (see SyncUDPServer).
+    isc::dns::MessagePtr query_, answer_;
+    // The socket used for the communication
+    boost::scoped_ptr<asio::ip::udp::socket> socket_;
+    // Wrapper of socket_ in the form of asiolink::IOSocket.
+    boost::scoped_ptr<asiolink::UDPSocket<asiolink::DummyIOCallback> >
+    udp_socket_;
+    // Callback
+    const DNSLookup* lookup_callback_;
+    // Answers from the lookup callback for the current packet
+    bool resume_called_, done_;
+    // This turns true when the server stops. Allows for not sending the
+    // answers after we closed the socket.
+    bool stopped_;
+    // Placeholder for error code object.
+    asio::error_code ec_;
+
+    // Auxiliary functions
+
+    // Wait for the socket to become readable.
+    void scheduleRead();
+    // Callback from the socket when it is readable (or on error).
+    void handleRead(const asio::error_code& ec);
+    // Receive the packets queued on the socket, up to the batch size.
+    // Returns the number of packets received, which may be 0 if another
+    // server sharing the socket got them first.
+    size_t receiveBatch();
+    // Send the answers to the first count packets.
+    void sendBatch(const size_t count);
+};
+
+} // namespace asiodns
+} // namespace isc
+#endif // BATCH_UDP_SERVER_H
+
+// Local Variables:
+// mode: c++
+// End:
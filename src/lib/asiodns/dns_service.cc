@@ -24,6 +24,7 @@
 #include <tcp_server.h>
 #include <udp_server.h>
 #include <sync_udp_server.h>
+#include <batch_udp_server.h>
 
 #include <boost/foreach.hpp>
 
@@ -47,6 +48,7 @@ public:
 
     typedef boost::shared_ptr<UDPServer> UDPServerPtr;
     typedef boost::shared_ptr<SyncUDPServer> SyncUDPServerPtr;
+    typedef boost::shared_ptr<BatchUDPServer> BatchUDPServerPtr;
     typedef boost::shared_ptr<TCPServer> TCPServerPtr;
     typedef boost::shared_ptr<DNSServer> DNSServerPtr;
     std::vector<DNSServerPtr> servers_;
@@ -69,6 +71,13 @@ public:
         startServer(server);
     }
 
+    void addBatchUDPServerFromFD(int fd, int af) {
+        BatchUDPServerPtr server(BatchUDPServer::create(
+                                     io_service_.get_io_service(), fd, af,
+                                     lookup_));
+        startServer(server);
+    }
+
     void setTCPRecvTimeout(size_t timeout) {
         // Store it for future tcp connections
         tcp_recv_timeout_ = timeout;
@@ -107,7 +116,13 @@ void DNSService::addServerUDPFromFD(int fd, int af, ServerFlag options) {
         isc_throw(isc::InvalidParameter, "Invalid DNS/UDP server option: "
                   << options);
     }
-    if ((options & SERVER_SYNC_OK) != 0) {
+    if ((options & SERVER_BATCH_OK) != 0) {
+        if ((options & SERVER_SYNC_OK) == 0) {
+            isc_throw(isc::InvalidParameter, "DNS/UDP server option "
+                      "SERVER_BATCH_OK requires SERVER_SYNC_OK: " << options);
+        }
+        impl_->addBatchUDPServerFromFD(fd, af);
+    } else if ((options & SERVER_SYNC_OK) != 0) {
         impl_->addSyncUDPServerFromFD(fd, af);
     } else {
         impl_->addServerFromFD<DNSServiceImpl::UDPServerPtr, UDPServer>(
@@ -51,28 +51,36 @@ public:
     ///
     /// The values of this enumerable type are intended to be used to specify
     /// a particular property of the server created via the \c addServer
-    /// variants.  As we see need for more such properties, a compound
-    /// form of flags (i.e., a single value generated by bitwise OR'ed
-    /// multiple flag values) will be allowed.
+    /// variants.  A compound form of flags (i.e., a single value generated
+    /// by bitwise OR'ed multiple flag values) is allowed, as long as the
+    /// combined properties are compatible.
     ///
     /// Note: the description is given here because it's used in the method
     /// signature.  It essentially belongs to the derived \c DNSService
     /// class.
     enum ServerFlag {
         SERVER_DEFAULT = 0, ///< The default flag (no particular property)
-        SERVER_SYNC_OK = 1 ///< The server can act in the "synchronous" mode.
-                           ///< In this mode, the client ensures that the
-                           ///< lookup provider always completes the query
-                           ///< process and it immediately releases the
-                           ///< ownership of the given buffer.  This allows
-                           ///< the server implementation to introduce some
-                           ///< optimization such as omitting unnecessary
-                           ///< operation or reusing internal resources.
-                           ///< Note that in functionality the non
-                           ///< "synchronous" mode is compatible with the
-                           ///< synchronous mode; it's up to the server
-                           ///< implementation whether it exploits the
-                           ///< information given by the client.
+        SERVER_SYNC_OK = 1, ///< The server can act in the "synchronous" mode.
+                            ///< In this mode, the client ensures that the
+                            ///< lookup provider always completes the query
+                            ///< process and it immediately releases the
+                            ///< ownership of the given buffer.  This allows
+                            ///< the server implementation to introduce some
+                            ///< optimization such as omitting unnecessary
+                            ///< operation or reusing internal resources.
+                            ///< Note that in functionality the non
+                            ///< "synchronous" mode is compatible with the
+                            ///< synchronous mode; it's up to the server
+                            ///< implementation whether it exploits the
+                            ///< information given by the client.
+        SERVER_BATCH_OK = 2 ///< The server can receive several queries and
+                            ///< send their answers at once.  This is only
+                            ///< valid with \c SERVER_SYNC_OK, as it relies
+                            ///< on the lookup provider completing each
+                            ///< query before the next one is given.  It
+                            ///< reduces the system calls per query under
+                            ///< load, at the cost of the memory of a batch
+                            ///< of packets per server.
     };
 
 public:
@@ -124,7 +132,7 @@ private:
     // Bit or'ed all defined \c ServerFlag values.  Used internally for
     // compatibility check.  Note that this doesn't have to be used by
     // applications, and doesn't have to be defined in the "base" class.
-    static const unsigned int SERVER_DEFINED_FLAGS = 1;
+    static const unsigned int SERVER_DEFINED_FLAGS = 3;
 
 public:
     /// \brief The constructor without any servers.
@@ -176,9 +184,11 @@ public:
     /// \param af the address family of the file descriptor. Must be either
     ///     AF_INET or AF_INET6.
     /// \param options Optional properties of the server (see ServerFlag).
+    ///     Several properties can be given by bitwise OR'ing them.
     ///
     /// \throw isc::InvalidParameter if af is neither AF_INET nor AF_INET6,
-    ///     or the given \c options include an unsupported or invalid value.
+    ///     or the given \c options include an unsupported or invalid value,
+    ///     including \c SERVER_BATCH_OK without \c SERVER_SYNC_OK.
     /// \throw isc::asiolink::IOError when a low-level error happens, like the
     ///     fd is not a valid descriptor or it can't be listened on.
     virtual void addServerUDPFromFD(int fd, int af,
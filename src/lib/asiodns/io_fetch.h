@@ -72,7 +72,8 @@ public:
         SUCCESS = 0,        ///< Success, fetch completed
         TIME_OUT = 1,       ///< Failure, fetch timed out
         STOPPED = 2,        ///< Control code, fetch has been stopped
-        NOTSET = 3          ///< For testing, indicates value not set
+        NOTSET = 3,         ///< For testing, indicates value not set
+        IO_ERROR = 4        ///< Failure, I/O error other than a timeout
     };
 
     // The next enum is a "trick" to allow constants to be defined in a class
@@ -20,6 +20,7 @@
 #include <asiolink/io_error.h>
 #include <asiodns/udp_server.h>
 #include <asiodns/sync_udp_server.h>
+#include <asiodns/batch_udp_server.h>
 #include <asiodns/tcp_server.h>
 #include <asiodns/dns_answer.h>
 #include <asiodns/dns_lookup.h>
@@ -140,7 +141,7 @@ class SimpleAnswer : public DNSAnswer, public ServerStopper {
 };
 
 /// \brief Mixture of DummyLookup and SimpleAnswer: build the answer in the
-/// lookup callback.  Used with SyncUDPServer.
+/// lookup callback.  Used with SyncUDPServer and BatchUDPServer.
 class SyncDummyLookup : public DummyLookup {
 public:
     virtual void operator()(const IOMessage& io_message,
@@ -538,20 +539,39 @@ FdInit<SyncUDPServer>::createServer(int fd, int af) {
     return (SyncUDPServer::create(this->service, fd, af, this->lookup_));
 }
 
+// Likewise for BatchUDPServer.
+template<>
+boost::shared_ptr<BatchUDPServer>
+FdInit<BatchUDPServer>::createServer(int fd, int af) {
+    delete this->lookup_;
+    this->lookup_ = new SyncDummyLookup;
+    return (BatchUDPServer::create(this->service, fd, af, this->lookup_));
+}
+
 // This makes it the template as gtest wants it.
 template<class Parent>
 class DNSServerTest : public Parent { };
 
-typedef ::testing::Types<FdInit<UDPServer>, FdInit<SyncUDPServer> >
-    ServerTypes;
+typedef ::testing::Types<FdInit<UDPServer>, FdInit<SyncUDPServer>,
+                         FdInit<BatchUDPServer> > ServerTypes;
 TYPED_TEST_CASE(DNSServerTest, ServerTypes);
 
-// Some tests work only for SyncUDPServer, some others work only for
-// (non Sync)UDPServer.  We specialize these tests.
+// Some tests work only for the synchronous servers, some others work only
+// for (non Sync)UDPServer.  We specialize these tests.
 typedef FdInit<UDPServer> AsyncServerTest;
+
+template<class Parent>
+class SyncDNSServerTest : public Parent { };
+
+typedef ::testing::Types<FdInit<SyncUDPServer>, FdInit<BatchUDPServer> >
+    SyncServerTypes;
+TYPED_TEST_CASE(SyncDNSServerTest, SyncServerTypes);
+
 typedef FdInit<SyncUDPServer> SyncServerTest;
+typedef FdInit<BatchUDPServer> BatchServerTest;
 
-typedef ::testing::Types<UDPServer, SyncUDPServer> UDPServerTypes;
+typedef ::testing::Types<UDPServer, SyncUDPServer, BatchUDPServer>
+    UDPServerTypes;
 TYPED_TEST_CASE(DNSServerTestBase, UDPServerTypes);
 
 template<class UDPServerClass>
@@ -738,15 +758,17 @@ TYPED_TEST(DNSServerTest, DISABLED_invalidUDPFD) {
 }
 
 // Check it rejects some of the unsupported operations
-TEST_F(SyncServerTest, unsupportedOps) {
-    EXPECT_THROW(udp_server_->clone(), isc::Unexpected);
-    EXPECT_THROW(udp_server_->asyncLookup(), isc::Unexpected);
+TYPED_TEST(SyncDNSServerTest, unsupportedOps) {
+    EXPECT_THROW(this->udp_server_->clone(), isc::Unexpected);
+    EXPECT_THROW(this->udp_server_->asyncLookup(), isc::Unexpected);
 }
 
 // Check it rejects forgotten resume (eg. insists that it is synchronous)
-TEST_F(SyncServerTest, mustResume) {
-    lookup_->allow_resume_ = false;
-    ASSERT_THROW(testStopServerByStopper(*udp_server_, udp_client_, lookup_),
+TYPED_TEST(SyncDNSServerTest, mustResume) {
+    this->lookup_->allow_resume_ = false;
+    ASSERT_THROW(this->testStopServerByStopper(*this->udp_server_,
+                                               this->udp_client_,
+                                               this->lookup_),
                  isc::Unexpected);
 }
 
@@ -756,7 +778,17 @@ TEST_F(SyncServerTest, nullLookupCallback) {
                  isc::InvalidParameter);
 }
 
-TEST_F(SyncServerTest, resetUDPServerBeforeEvent) {
+// Neither does BatchUDPServer, nor an empty batch.
+TEST_F(BatchServerTest, invalidParameters) {
+    EXPECT_THROW(BatchUDPServer::create(service, 0, AF_INET, NULL),
+                 isc::InvalidParameter);
+    EXPECT_THROW(BatchUDPServer::create(service, 0, AF_INET, lookup_, 0),
+                 isc::InvalidParameter);
+    EXPECT_EQ(BatchUDPServer::DEFAULT_BATCH_SIZE,
+              udp_server_->getBatchSize());
+}
+
+TYPED_TEST(SyncDNSServerTest, resetUDPServerBeforeEvent) {
     // Reset the UDP server object after starting and before it would get
     // an event from io_service (in this case abort event).  The following
     // sequence confirms it's shut down immediately, and without any
@@ -766,16 +798,81 @@ TEST_F(SyncServerTest, resetUDPServerBeforeEvent) {
     // it's very unlikely to cause hangup.  But we'll make very sure it
     // doesn't happen.
     const unsigned int IO_SERVICE_TIME_OUT = 5;
-    (*udp_server_)();
-    udp_server_->stop();
-    udp_server_.reset();
-    void (*prev_handler)(int) = std::signal(SIGALRM, stopIOService);
-    current_service = &service;
+    (*this->udp_server_)();
+    this->udp_server_->stop();
+    this->udp_server_.reset();
+    void (*prev_handler)(int) = std::signal(SIGALRM,
+                                            TestFixture::stopIOService);
+    TestFixture::current_service = &this->service;
     alarm(IO_SERVICE_TIME_OUT);
-    service.run();
+    this->service.run();
     alarm(0);
     std::signal(SIGALRM, prev_handler);
-    EXPECT_FALSE(io_service_is_time_out);
+    EXPECT_FALSE(TestFixture::io_service_is_time_out);
+}
+
+// A lookup callback answering with the query, counting the queries and
+// checking each one gets a buffer of its own.
+class CountingLookup : public DNSLookup {
+public:
+    CountingLookup() : count_(0) {}
+    virtual void operator()(const IOMessage& io_message,
+                            isc::dns::MessagePtr,
+                            isc::dns::MessagePtr,
+                            isc::util::OutputBufferPtr buffer,
+                            DNSServer* server) const
+    {
+        EXPECT_EQ(0, buffer->getLength());
+        buffer->writeData(io_message.getData(), io_message.getDataSize());
+        ++count_;
+        server->resume(true);
+    }
+    mutable size_t count_;
+};
+
+// Check the queries received at once are all answered, even when there are
+// more than a batch.
+TEST_F(BatchServerTest, answerBatches) {
+    CountingLookup lookup;
+
+    // A server with small batches on a socket of its own.
+    const int fd_udp(socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP));
+    ASSERT_NE(-1, fd_udp) << strerror(errno);
+    const ip::udp::endpoint server_ep(server_address_, server_port + 1);
+    ASSERT_EQ(0, bind(fd_udp, server_ep.data(), server_ep.size()))
+        << strerror(errno);
+    udp_server_ = BatchUDPServer::create(service, fd_udp, AF_INET6, &lookup,
+                                         4);
+    (*udp_server_)();
+
+    // Queue the queries before running the server, so as they're received
+    // in batches.
+    const size_t queries = 10;
+    ip::udp::socket client(service, ip::udp::v6());
+    for (size_t i = 0; i < queries; ++i) {
+        const std::string data = std::string(query_message) +
+            static_cast<char>('0' + i);
+        client.send_to(buffer(data.c_str(), data.size()), server_ep);
+    }
+    std::vector<std::string> answers;
+    char received[SimpleClient::MAX_DATA_LEN];
+    for (size_t i = 0; i < 100 && answers.size() < queries; ++i) {
+        if (service.poll() == 0) {
+            usleep(10000);
+        }
+        while (client.available() > 0) {
+            const size_t length = client.receive(buffer(received,
+                                                        sizeof(received)));
+            answers.push_back(std::string(received, length));
+        }
+    }
+    udp_server_->stop();
+    EXPECT_EQ(queries, lookup.count_);
+    ASSERT_EQ(queries, answers.size());
+    for (size_t i = 0; i < queries; ++i) {
+        EXPECT_EQ(std::string(query_message) + static_cast<char>('0' + i),
+                  answers[i]);
+    }
 }
 
 }
@@ -221,12 +221,36 @@ TEST_F(UDPDNSServiceTest, syncUDPServerFromFD) {
     EXPECT_EQ(first_buffer_, second_buffer_);
 }
 
+TEST_F(UDPDNSServiceTest, batchUDPServerFromFD) {
+    // If "BATCH_OK" option is specified too, a batched server should be
+    // created.  The two packets are received at once and each one is given
+    // a buffer of its own.
+    dns_service.addServerUDPFromFD(getSocketFD(AF_INET6, TEST_IPV6_ADDR,
+                                               TEST_SERVER_PORT),
+                                   AF_INET6,
+                                   static_cast<DNSService::ServerFlag>(
+                                       DNSService::SERVER_SYNC_OK |
+                                       DNSService::SERVER_BATCH_OK));
+    runService();
+    EXPECT_TRUE(serverStopSucceed());
+    EXPECT_NE(static_cast<isc::util::OutputBuffer*>(NULL), second_buffer_);
+    EXPECT_NE(first_buffer_, second_buffer_);
+}
+
 TEST_F(UDPDNSServiceTest, addUDPServerFromFDWithUnknownOption) {
     // Use of undefined/incompatible options should result in an exception.
+    // The socket isn't taken by the service then, so we close it.
+    int fd = getSocketFD(AF_INET6, TEST_IPV6_ADDR, TEST_SERVER_PORT);
+    EXPECT_THROW(dns_service.addServerUDPFromFD(
+                     fd, AF_INET6, static_cast<DNSService::ServerFlag>(4)),
+                 isc::InvalidParameter);
+    close(fd);
+    // The batched mode is only possible in the synchronous mode.
+    fd = getSocketFD(AF_INET6, TEST_IPV6_ADDR, TEST_SERVER_PORT);
     EXPECT_THROW(dns_service.addServerUDPFromFD(
-                     getSocketFD(AF_INET6, TEST_IPV6_ADDR, TEST_SERVER_PORT),
-                     AF_INET6, static_cast<DNSService::ServerFlag>(2)),
+                     fd, AF_INET6, DNSService::SERVER_BATCH_OK),
                  isc::InvalidParameter);
+    close(fd);
 }
 
 } // unnamed namespace
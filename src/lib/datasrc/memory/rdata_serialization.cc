@@ -744,25 +744,30 @@ RdataReader::emptyDataAction(const void*, size_t) {
     // Do nothing here.
 }
 
+void
+RdataReader::locateSigs() {
+    if (sigs_ == NULL) {
+        // We didn't find where the signatures start yet. We do it
+        // by iterating the whole data and then returning the state
+        // back.
+        const size_t data_pos = data_pos_;
+        const size_t spec_pos = spec_pos_;
+        const size_t length_pos = length_pos_;
+        // When the next() gets to the last item, it sets the sigs_
+        while (nextInternal(emptyNameAction, emptyDataAction) !=
+               RRSET_BOUNDARY) {}
+        assert(sigs_ != NULL);
+        // Return the state
+        data_pos_ = data_pos;
+        spec_pos_ = spec_pos;
+        length_pos_ = length_pos;
+    }
+}
+
 RdataReader::Boundary
 RdataReader::nextSig() {
     if (sig_pos_ < sig_count_) {
-        if (sigs_ == NULL) {
-            // We didn't find where the signatures start yet. We do it
-            // by iterating the whole data and then returning the state
-            // back.
-            const size_t data_pos = data_pos_;
-            const size_t spec_pos = spec_pos_;
-            const size_t length_pos = length_pos_;
-            // When the next() gets to the last item, it sets the sigs_
-            while (nextInternal(emptyNameAction, emptyDataAction) !=
-                   RRSET_BOUNDARY) {}
-            assert(sigs_ != NULL);
-            // Return the state
-            data_pos_ = data_pos;
-            spec_pos_ = spec_pos;
-            length_pos_ = length_pos;
-        }
+        locateSigs();
         // Extract the result
         const size_t length = lengths_[var_count_total_ + sig_pos_];
         const uint8_t* const pos = sigs_ + sig_data_pos_;
@@ -777,6 +782,58 @@ RdataReader::nextSig() {
     }
 }
 
+bool
+RdataReader::renderRdata(AbstractMessageRenderer& renderer) {
+    if (spec_pos_ >= spec_count_) {
+        sigs_ = data_ + data_pos_;
+        return (false);
+    }
+    assert(spec_pos_ % spec_.field_count == 0);
+
+    // The data fields are stored just as they are in the wire format, so
+    // the consecutive ones are copied at once; e.g., A, AAAA or DS RDATA
+    // are a single copy, and MX or SOA RDATA a copy besides the names.
+    const uint8_t* chunk = data_ + data_pos_;
+    size_t chunk_len = 0;
+    for (size_t i = 0; i < spec_.field_count; ++i) {
+        const RdataFieldSpec& spec = spec_.fields[i];
+        if (spec.type == RdataFieldSpec::DOMAIN_NAME) {
+            if (chunk_len > 0) {
+                renderer.writeData(chunk, chunk_len);
+                chunk_len = 0;
+            }
+            const LabelSequence sequence(data_ + data_pos_);
+            data_pos_ += sequence.getSerializedLength();
+            renderer.writeName(sequence, (spec.name_attributes &
+                                          NAMEATTR_COMPRESSIBLE) != 0);
+            chunk = data_ + data_pos_;
+        } else {
+            const size_t length(spec.type == RdataFieldSpec::FIXEDLEN_DATA ?
+                                spec.fixeddata_len : lengths_[length_pos_++]);
+            data_pos_ += length;
+            chunk_len += length;
+        }
+    }
+    if (chunk_len > 0) {
+        renderer.writeData(chunk, chunk_len);
+    }
+    spec_pos_ += spec_.field_count;
+    return (true);
+}
+
+bool
+RdataReader::renderSingleSig(AbstractMessageRenderer& renderer) {
+    if (sig_pos_ >= sig_count_) {
+        return (false);
+    }
+    locateSigs();
+    const size_t length = lengths_[var_count_total_ + sig_pos_];
+    renderer.writeData(sigs_ + sig_data_pos_, length);
+    sig_data_pos_ += length;
+    ++sig_pos_;
+    return (true);
+}
+
 size_t
 RdataReader::getSize() const {
     size_t storage_size = 0;    // this will be the end result
@@ -533,6 +533,33 @@ public:
         }
     }
 
+    /// \brief Render the current RDATA directly into a message renderer.
+    ///
+    /// This is equivalent to \c iterateRdata() with callbacks which write
+    /// the names and the data to the renderer (compressing the names with
+    /// the \c NAMEATTR_COMPRESSIBLE attribute), but it doesn't call any
+    /// callback: the encoded data are copied straight into the renderer,
+    /// consecutive data fields in a single chunk, and only the names go
+    /// through the compression logic.  This is the path to use when
+    /// rendering a DNS message, as it avoids the overhead of the callbacks.
+    ///
+    /// It must be called at the boundary of an RDATA, i.e., it must not be
+    /// mixed with \c next() in the middle of an RDATA.  It can be mixed with
+    /// \c iterateRdata() otherwise.
+    ///
+    /// \param renderer The renderer the RDATA is written to.
+    /// \return If there was Rdata to render.
+    bool renderRdata(dns::AbstractMessageRenderer& renderer);
+
+    /// \brief Render the current RRSig RDATA directly into a message
+    /// renderer.
+    ///
+    /// This is the counterpart of \c renderRdata() for \c iterateSingleSig().
+    ///
+    /// \param renderer The renderer the RDATA is written to.
+    /// \return If there was RRSig Rdata to render.
+    bool renderSingleSig(dns::AbstractMessageRenderer& renderer);
+
     /// \brief Rewind the iterator to the beginning of data.
     ///
     /// The following next() and nextSig() will start iterating from the
@@ -571,6 +598,8 @@ private:
     size_t sig_pos_, sig_data_pos_;
     Boundary nextInternal(const NameAction& name_action,
                           const DataAction& data_action);
+    // Find where the signatures start, if not known yet.
+    void locateSigs();
 };
 
 } // namespace memory
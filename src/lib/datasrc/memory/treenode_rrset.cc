@@ -30,6 +30,7 @@
 #include <boost/bind.hpp>
 
 #include <cassert>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -113,20 +114,6 @@ sizeupData(const void*, size_t data_len, size_t* length)
     *length += data_len;
 }
 
-void
-renderName(const LabelSequence& name_labels, RdataNameAttributes attr,
-           AbstractMessageRenderer* renderer)
-{
-    renderer->writeName(name_labels, (attr & NAMEATTR_COMPRESSIBLE) != 0);
-}
-
-void
-renderData(const void* data, size_t data_len,
-           AbstractMessageRenderer* renderer)
-{
-    renderer->writeData(data, data_len);
-}
-
 // Helper for calculating wire data length of a single (etiher main or
 // RRSIG) RRset.
 uint16_t
@@ -156,26 +143,70 @@ getLengthHelper(size_t* rlength, size_t rr_count, uint16_t name_labels_size,
     return (length);
 }
 
+// The length of the fields of an RR between the owner name and the RDATA:
+// type, class, TTL.
+const size_t RR_FIXED_LEN = sizeof(uint16_t) * 2 + sizeof(uint32_t);
+
+// Build the header (owner name, type, class and TTL) of the RRs following
+// the first one, rendered at pos0, in an RRset.  The owner name of these
+// RRs is compressed into a pointer to the owner name of the first RR (or
+// to the same place if it was a pointer itself), which is what the
+// renderer would do anyway.  Returns the length of the header, or 0 if
+// it can't be built (the owner name is the root name, which is never
+// compressed, or it's too far in the message for a pointer).
+size_t
+makeRRHeader(const AbstractMessageRenderer& renderer, size_t pos0,
+             uint8_t* header)
+{
+    const size_t name_len = renderer.getLength() - pos0 - RR_FIXED_LEN;
+    const uint8_t* const rendered =
+        static_cast<const uint8_t*>(renderer.getData()) + pos0;
+    if (name_len == sizeof(uint16_t) && (rendered[0] & 0xc0) == 0xc0) {
+        std::memcpy(header, rendered, sizeof(uint16_t) + RR_FIXED_LEN);
+    } else if (name_len > sizeof(uint16_t) && pos0 < 0x4000) {
+        header[0] = 0xc0 | (pos0 >> 8);
+        header[1] = pos0 & 0xff;
+        std::memcpy(header + sizeof(uint16_t), rendered + name_len,
+                    RR_FIXED_LEN);
+    } else {
+        return (0);
+    }
+    return (sizeof(uint16_t) + RR_FIXED_LEN);
+}
+
 // Common code logic for rendering a single (either main or RRSIG) RRset.
+// The RDATA are rendered directly from the encoded data by rdata_render_fn,
+// without going through the callbacks of the reader, and only the first RR
+// goes through the name compression for the owner name.
 size_t
 writeRRs(AbstractMessageRenderer& renderer, size_t rr_count,
          const LabelSequence& name_labels, const RRType& rrtype,
          const RRClass& rrclass, const void* ttl_data,
-         RdataReader& reader, bool (RdataReader::* rdata_iterate_fn)())
+         RdataReader& reader,
+         bool (RdataReader::* rdata_render_fn)(AbstractMessageRenderer&))
 {
+    uint8_t header[sizeof(uint16_t) + RR_FIXED_LEN];
+    size_t header_len = 0;
     for (size_t i = 0; i < rr_count; ++i) {
         const size_t pos0 = renderer.getLength();
 
         // Name, type, class, TTL
-        renderer.writeName(name_labels, true);
-        rrtype.toWire(renderer);
-        rrclass.toWire(renderer);
-        renderer.writeData(ttl_data, sizeof(uint32_t));
+        if (header_len > 0) {
+            renderer.writeData(header, header_len);
+        } else {
+            renderer.writeName(name_labels, true);
+            rrtype.toWire(renderer);
+            rrclass.toWire(renderer);
+            renderer.writeData(ttl_data, sizeof(uint32_t));
+            if (i == 0 && rr_count > 1) {
+                header_len = makeRRHeader(renderer, pos0, header);
+            }
+        }
 
         // RDLEN and RDATA
         const size_t pos = renderer.getLength();
         renderer.skip(sizeof(uint16_t)); // leave the space for RDLENGTH
-        const bool rendered = (reader.*rdata_iterate_fn)();
+        const bool rendered = (reader.*rdata_render_fn)(renderer);
         assert(rendered == true);
         renderer.writeUint16At(renderer.getLength() - pos - sizeof(uint16_t),
                                pos);
@@ -228,8 +259,8 @@ unsigned int
 TreeNodeRRset::toWire(AbstractMessageRenderer& renderer) const {
     RdataReader reader(rrclass_, rdataset_->type, rdataset_->getDataBuf(),
                        rdataset_->getRdataCount(), rrsig_count_,
-                       boost::bind(renderName, _1, _2, &renderer),
-                       boost::bind(renderData, _1, _2, &renderer));
+                       &RdataReader::emptyNameAction,
+                       &RdataReader::emptyDataAction);
 
     // Get the owner name of the RRset in the form of LabelSequence.
     uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
@@ -239,18 +270,18 @@ TreeNodeRRset::toWire(AbstractMessageRenderer& renderer) const {
     const size_t rendered_rdata_count =
         writeRRs(renderer, rdataset_->getRdataCount(), name_labels,
                  rdataset_->type, rrclass_, ttl_data_, reader,
-                 &RdataReader::iterateRdata);
+                 &RdataReader::renderRdata);
     if (renderer.isTruncated()) {
         return (rendered_rdata_count);
     }
-    const bool rendered = reader.iterateRdata();
+    const bool rendered = reader.renderRdata(renderer);
     assert(rendered == false); // we should've reached the end
 
     // Render any RRSIGs, if we supposed to do so
     const size_t rendered_rrsig_count = dnssec_ok_ ?
         writeRRs(renderer, rrsig_count_, name_labels, RRType::RRSIG(),
                  rrclass_, ttl_data_, reader,
-                 &RdataReader::iterateSingleSig) : 0;
+                 &RdataReader::renderSingleSig) : 0;
 
     return (rendered_rdata_count + rendered_rrsig_count);
 }
@@ -463,6 +463,34 @@ public:
     }
 };
 
+// Decode by rendering the data directly into the renderer, one rdata each
+// time, without the callbacks.
+class RenderDecoder {
+public:
+    static void decode(const isc::dns::RRClass& rrclass,
+                       const isc::dns::RRType& rrtype,
+                       size_t rdata_count, size_t sig_count, size_t,
+                       const vector<uint8_t>& encoded_data, size_t,
+                       MessageRenderer& renderer)
+    {
+        RdataReader reader(rrclass, rrtype, &encoded_data[0],
+                           rdata_count, sig_count,
+                           &RdataReader::emptyNameAction,
+                           &RdataReader::emptyDataAction);
+        size_t actual_count = 0;
+        while (reader.renderRdata(renderer)) {
+            ++actual_count;
+        }
+        EXPECT_EQ(rdata_count, actual_count);
+        actual_count = 0;
+        renderer.writeName(dummyName2());
+        while (reader.renderSingleSig(renderer)) {
+            ++actual_count;
+        }
+        EXPECT_EQ(sig_count, actual_count);
+    }
+};
+
 // This one does not adhere to the usual way the reader is used, trying
 // to confuse it. It iterates part of the data manually and then reads
 // the rest through iterate. It also reads the signatures in the middle
@@ -520,6 +548,7 @@ public:
 
 typedef ::testing::Types<ManualDecoderStyle,
                          CallbackDecoder, IterateDecoder, SingleIterateDecoder,
+                         RenderDecoder,
                          HybridDecoder<true, true>, HybridDecoder<true, false>,
                          HybridDecoder<false, true>,
                          HybridDecoder<false, false> >
@@ -474,6 +474,62 @@ TEST_F(TreeNodeRRsetTest, toWire) {
     }
 }
 
+TEST_F(TreeNodeRRsetTest, toWireOwnerCompression) {
+    // The owner names of the RRs after the first one are rendered as a
+    // pointer to the first one.  Check it's the same as what the renderer
+    // would do in the cases where the first owner name isn't a pointer.
+    MessageRenderer expected_renderer, actual_renderer;
+    const TreeNodeRRset rrset(rrclass_, www_node_, a_rdataset_, true);
+
+    {
+        SCOPED_TRACE("uncompressed owner name");
+        checkToWireResult(expected_renderer, actual_renderer, rrset,
+                          Name("example.org"), a_rrset_, a_rrsig_rrset_,
+                          true);
+    }
+
+    {
+        SCOPED_TRACE("partially compressed owner name");
+        checkToWireResult(expected_renderer, actual_renderer, rrset,
+                          origin_name_, a_rrset_, a_rrsig_rrset_, true);
+    }
+
+    {
+        // The root name is never compressed.
+        SCOPED_TRACE("root owner name");
+        ConstRRsetPtr expected_rrset =
+            textToRRset(". 3600 IN A 192.0.2.1\n"
+                        ". 3600 IN A 192.0.2.2");
+        checkToWireResult(expected_renderer, actual_renderer,
+                          *createRRset(Name::ROOT_NAME(), rrclass_,
+                                       wildcard_node_, wildcard_rdataset_,
+                                       false),
+                          Name("example.org"), expected_rrset,
+                          ConstRRsetPtr(), false);
+    }
+
+    {
+        // A name beyond the reach of compression pointers isn't used for
+        // compression.
+        SCOPED_TRACE("owner name in a large message");
+        expected_renderer.clear();
+        actual_renderer.clear();
+        expected_renderer.setLengthLimit(65535);
+        actual_renderer.setLengthLimit(65535);
+        expected_renderer.skip(0x4000);
+        actual_renderer.skip(0x4000);
+        a_rrset_->toWire(expected_renderer);
+        a_rrsig_rrset_->toWire(expected_renderer);
+        EXPECT_EQ(3, rrset.toWire(actual_renderer));
+        matchWireData(static_cast<const uint8_t*>(
+                          expected_renderer.getData()) + 0x4000,
+                      expected_renderer.getLength() - 0x4000,
+                      static_cast<const uint8_t*>(
+                          actual_renderer.getData()) + 0x4000,
+                      actual_renderer.getLength() - 0x4000);
+    }
+}
+
 TEST_F(TreeNodeRRsetTest, toWireTruncated) {
     MessageRenderer expected_renderer, actual_renderer;
     // dummy parameter to checkToWireResult (unused for the this test case)
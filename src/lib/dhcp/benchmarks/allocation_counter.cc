@@ -0,0 +1,48 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/benchmarks/allocation_counter.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Number of the blocks allocated by the global operator new. The
+// benchmarks are single-threaded.
+size_t allocations = 0;
+
+}
+
+// The global allocator is replaced in this separate translation unit, so
+// as it is not inlined into the code using it.
+void*
+operator new(size_t size) throw(std::bad_alloc) {
+    ++allocations;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return (ptr);
+}
+
+void
+operator delete(void* ptr) throw() {
+    free(ptr);
+}
+
+size_t
+getAllocationCount() {
+    return (allocations);
+}
@@ -0,0 +1,185 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/benchmarks/allocation_counter.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/libdhcp++.h>
+#include <dhcp/option4_addrlst.h>
+#include <dhcp/option_arena.h>
+#include <dhcp/option_int.h>
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt_pool.h>
+#include <util/encode/hex.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::asiolink;
+using namespace isc::bench;
+using namespace isc::dhcp;
+
+namespace {
+
+// This benchmark performs the allocations of a DHCPDISCOVER/DHCPOFFER
+// transaction: it parses the received packet, creates the response with
+// the options typically sent by the server and packs it. The packets are
+// either allocated for each transaction or taken from a PktPool. The
+// options are always allocated from the OptionArena.
+class TransactionBenchMark {
+public:
+    TransactionBenchMark(const vector<uint8_t>& data, PktPool<Pkt4>* pool,
+                         const OptionCollection& subnet_options) :
+        data_(data), pool_(pool), subnet_options_(subnet_options)
+    {}
+    unsigned int run() {
+        Pkt4Ptr query = pool_ ? pool_->create(&data_[0], data_.size()) :
+            Pkt4Ptr(new Pkt4(&data_[0], data_.size()));
+        query->unpack();
+        assert(query->getType() == DHCPDISCOVER);
+        assert(query->getOption(DHO_DHCP_CLIENT_IDENTIFIER));
+
+        Pkt4Ptr response = pool_ ?
+            pool_->create(DHCPOFFER, query->getTransid()) :
+            Pkt4Ptr(new Pkt4(DHCPOFFER, query->getTransid()));
+        response->addOption(OptionPtr(
+            new Option4AddrLst(DHO_DHCP_SERVER_IDENTIFIER, server_id_)));
+        response->addOption(OptionPtr(
+            new OptionInt<uint32_t>(Option::V4, DHO_DHCP_LEASE_TIME, 4000)));
+        response->addOption(OptionPtr(
+            new OptionInt<uint32_t>(Option::V4, DHO_DHCP_RENEWAL_TIME,
+                                    2000)));
+        response->addOption(OptionPtr(
+            new OptionInt<uint32_t>(Option::V4, DHO_DHCP_REBINDING_TIME,
+                                    3000)));
+        for (OptionCollection::const_iterator opt = subnet_options_.begin();
+             opt != subnet_options_.end(); ++opt) {
+            response->addOption(opt->second);
+        }
+        response->addOption(query->getOption(DHO_DHCP_AGENT_OPTIONS));
+        response->pack();
+        return (1);
+    }
+private:
+    const vector<uint8_t>& data_;
+    PktPool<Pkt4>* pool_;
+    const OptionCollection& subnet_options_;
+    static const IOAddress server_id_;
+};
+
+const IOAddress TransactionBenchMark::server_id_("192.0.2.1");
+
+// The relayed DHCPDISCOVER sent by the cable modem, packet 1 from the
+// capture dhcp-val/pcap/docsis-*-CG3000DCR-Registration-Filtered.cap. It
+// carries 8 options including the vendor-specific ones.
+const char* const relayed_discover =
+    "010106015d05478d000000000000000000000000000000000afee20120e52ab8151400"
+    "0000000000000000000000000000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000000000000000000000000000638253633501013707"
+    "0102030407067d3c0a646f63736973332e303a7d7f0000118b7a010102057501010102"
+    "010303010104010105010106010107010f0801100901030a01010b01180c01010d0200"
+    "400e0200100f010110040000000211010014010015013f160101170101180104190104"
+    "1a01041b01201c01021d01081e01201f01102001102101022201012301002401002501"
+    "01260200ff2701012b59020345434d030b45434d3a45524f55544552040d3242523232"
+    "39553430303434430504312e3034060856312e33332e30330707322e332e3052320806"
+    "30303039354209094347333030304443520a074e657467656172fe01083d0fff2ab815"
+    "140003000120e52ab81514390205dc5219010420000002020620e52ab8151409090000"
+    "118b0401020300ff";
+
+// Runs the benchmark and prints the allocations per transaction.
+void
+runBenchMark(const int iteration, const vector<uint8_t>& data,
+             PktPool<Pkt4>* pool, const OptionCollection& subnet_options) {
+    TransactionBenchMark target(data, pool, subnet_options);
+    // The first transaction fills the pool and the arena.
+    target.run();
+
+    const size_t allocated = getAllocationCount();
+    const size_t reused = OptionArena::getReused();
+    BenchMark<TransactionBenchMark>(iteration, target);
+    cout << "Allocations per transaction: "
+         << static_cast<double>(getAllocationCount() - allocated) /
+        iteration << endl;
+    cout << "Option blocks reused per transaction: "
+         << static_cast<double>(OptionArena::getReused() - reused) /
+        iteration << endl;
+}
+
+void
+usage() {
+    cerr << "Usage: pkt_pool_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 100000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+
+    // The standard option definitions are created on first use, which
+    // shouldn't be measured.
+    LibDHCP::getOptionDefs(Option::V4);
+
+    vector<uint8_t> discover;
+    isc::util::encode::decodeHex(relayed_discover, discover);
+
+    // The options configured for the subnet are shared by all responses.
+    OptionCollection subnet_options;
+    subnet_options.insert(make_pair(DHO_ROUTERS, OptionPtr(
+        new Option4AddrLst(DHO_ROUTERS, IOAddress("192.0.2.1")))));
+    subnet_options.insert(make_pair(DHO_SUBNET_MASK, OptionPtr(
+        new Option4AddrLst(DHO_SUBNET_MASK, IOAddress("255.255.255.0")))));
+    subnet_options.insert(make_pair(DHO_DOMAIN_NAME_SERVERS, OptionPtr(
+        new Option4AddrLst(DHO_DOMAIN_NAME_SERVERS,
+                           IOAddress("192.0.2.2")))));
+
+    cout << "Benchmark for the transaction with allocated packets" << endl;
+    runBenchMark(iteration, discover, NULL, subnet_options);
+
+    PktPool<Pkt4> pool;
+    cout << "Benchmark for the transaction with recycled packets" << endl;
+    runBenchMark(iteration, discover, &pool, subnet_options);
+
+    return (0);
+}
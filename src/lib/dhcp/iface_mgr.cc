@@ -28,15 +28,21 @@
 #include <exceptions/exceptions.h>
 #include <util/io/pktinfo_utilities.h>
 
+#include <algorithm>
 #include <cstring>
 #include <errno.h>
 #include <fstream>
+#include <limits>
 #include <sstream>
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/select.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 using namespace std;
 using namespace isc::asiolink;
@@ -45,6 +51,33 @@ using namespace isc::util::io::internal;
 namespace isc {
 namespace dhcp {
 
+namespace {
+
+/// @brief Counts the changes of the sets of sockets.
+///
+/// The counter is incremented whenever a socket is added to or removed from
+/// an interface, an interface is added or removed or an external socket is
+/// registered or unregistered. The @c IfaceMgr compares it with the value
+/// recorded when it created its epoll set to tell whether the set needs to
+/// be created anew.
+uint64_t sockets_generation = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+/// @brief Maximum number of events returned by a single epoll_wait() call.
+const int EPOLL_MAX_EVENTS = 16;
+#endif
+
+/// @brief Checks if the socket is used for the specified family.
+///
+/// @param sock socket.
+/// @param family AF_INET or AF_INET6.
+bool
+isFamilySocket(const SocketInfo& sock, const uint16_t family) {
+    return (family == AF_INET ? sock.addr_.isV4() : sock.addr_.isV6());
+}
+
+} // end of anonymous namespace
+
 IfaceMgr&
 IfaceMgr::instance() {
     static IfaceMgr iface_mgr;
@@ -96,6 +129,7 @@ Iface::closeSockets(const uint16_t family) {
                 close(sock->fallbackfd_);
             }
             sockets_.erase(sock++);
+            ++sockets_generation;
 
         } else {
             // Different type of socket. Let's move
@@ -160,6 +194,7 @@ bool Iface::delSocket(const uint16_t sockfd) {
                 close(sock->fallbackfd_);
             }
             sockets_.erase(sock);
+            ++sockets_generation;
             return (true); //socket found
         }
         ++sock;
@@ -167,11 +202,20 @@ bool Iface::delSocket(const uint16_t sockfd) {
     return (false); // socket not found
 }
 
+void
+Iface::addSocket(const SocketInfo& sock) {
+    sockets_.push_back(sock);
+    ++sockets_generation;
+}
+
 IfaceMgr::IfaceMgr()
     :control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
      control_buf_(new char[control_buf_len_]),
      packet_filter_(new PktFilterInet()),
-     packet_filter6_(new PktFilterInet6())
+     packet_filter6_(new PktFilterInet6()),
+     epoll_fd_(-1),
+     epoll_family_(0),
+     epoll_generation_(0)
 {
 
     try {
@@ -237,6 +281,10 @@ IfaceMgr::~IfaceMgr() {
     control_buf_len_ = 0;
 
     closeSockets();
+
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
 }
 
 bool
@@ -246,6 +294,7 @@ IfaceMgr::isDirectResponseSupported() const {
 
 void
 IfaceMgr::addExternalSocket(int socketfd, SocketCallback callback) {
+    ++sockets_generation;
     for (SocketCallbackInfoContainer::iterator s = callbacks_.begin();
          s != callbacks_.end(); ++s) {
 
@@ -270,6 +319,7 @@ IfaceMgr::deleteExternalSocket(int socketfd) {
          s != callbacks_.end(); ++s) {
         if (s->socket_ == socketfd) {
             callbacks_.erase(s);
+            ++sockets_generation;
             return;
         }
     }
@@ -612,6 +662,13 @@ IfaceMgr::getIface(const std::string& ifname) {
 void
 IfaceMgr::clearIfaces() {
     ifaces_.clear();
+    ++sockets_generation;
+}
+
+void
+IfaceMgr::addInterface(const Iface& iface) {
+    ifaces_.push_back(iface);
+    ++sockets_generation;
 }
 
 int IfaceMgr::openSocket(const std::string& ifname, const IOAddress& addr,
@@ -828,59 +885,255 @@ IfaceMgr::send(const Pkt4Ptr& pkt) {
 
 boost::shared_ptr<Pkt4>
 IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
-    // Sanity check for microsecond timeout.
-    if (timeout_usec >= 1000000) {
-        isc_throw(BadValue, "fractional timeout must be shorter than"
-                  " one million microseconds");
+    IfaceCollection::const_iterator iface;
+    const SocketInfo* candidate = waitForSocket(AF_INET, timeout_sec,
+                                                timeout_usec, iface);
+    if (!candidate) {
+        return (Pkt4Ptr()); // NULL
     }
-    const SocketInfo* candidate = 0;
+
+    // Now we have a socket, let's get some data from it!
+    // Assuming that packet filter is not NULL, because its modifier checks it.
+    return (packet_filter_->receive(*iface, *candidate));
+}
+
+Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */ ) {
     IfaceCollection::const_iterator iface;
-    fd_set sockets;
-    int maxfd = 0;
+    const SocketInfo* candidate = waitForSocket(AF_INET6, timeout_sec,
+                                                timeout_usec, iface);
+    if (!candidate) {
+        return (Pkt6Ptr()); // NULL
+    }
 
-    FD_ZERO(&sockets);
+    // Assuming that packet filter is not NULL, because its modifier checks it.
+    return (packet_filter6_->receive(*candidate));
+}
 
-    /// @todo: marginal performance optimization. We could create the set once
-    /// and then use its copy for select(). Please note that select() modifies
-    /// provided set to indicated which sockets have something to read.
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+size_t
+IfaceMgr::receiveBatch4(std::vector<Pkt4Ptr>& pkts, const size_t max_pkts,
+                        uint32_t timeout_sec, uint32_t timeout_usec) {
+    IfaceCollection::const_iterator iface;
+    const SocketInfo* candidate = waitForSocket(AF_INET, timeout_sec,
+                                                timeout_usec, iface);
+    if (!candidate) {
+        return (0);
+    }
 
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
-        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
-             s != socket_collection.end(); ++s) {
+    // Assuming that packet filter is not NULL, because its modifier checks it.
+    return (packet_filter_->receiveBatch(*iface, *candidate, pkts, max_pkts));
+}
 
-            // Only deal with IPv4 addresses.
-            if (s->addr_.isV4()) {
+size_t
+IfaceMgr::receiveBatch6(std::vector<Pkt6Ptr>& pkts, const size_t max_pkts,
+                        uint32_t timeout_sec, uint32_t timeout_usec) {
+    IfaceCollection::const_iterator iface;
+    const SocketInfo* candidate = waitForSocket(AF_INET6, timeout_sec,
+                                                timeout_usec, iface);
+    if (!candidate) {
+        return (0);
+    }
 
-                // Add this socket to listening set
-                FD_SET(s->sockfd_, &sockets);
-                if (maxfd < s->sockfd_) {
-                    maxfd = s->sockfd_;
-                }
-            }
+    // Assuming that packet filter is not NULL, because its modifier checks it.
+    return (packet_filter6_->receiveBatch(*candidate, pkts, max_pkts));
+}
+
+size_t
+IfaceMgr::sendBatch(const std::vector<Pkt4Ptr>& pkts,
+                    std::vector<std::string>& errors) {
+    size_t sent = 0;
+    std::vector<Pkt4Ptr> group;
+    std::vector<Pkt4Ptr>::const_iterator pkt = pkts.begin();
+    while (pkt != pkts.end()) {
+        // The packet which can't be sent is skipped, so as it doesn't cause
+        // the loss of the other packets in the batch.
+        Iface* iface = getIface((*pkt)->getIface());
+        if (!iface) {
+            std::ostringstream error;
+            error << "Unable to send DHCPv4 message to "
+                  << (*pkt)->getRemoteAddr() << ". Invalid interface ("
+                  << (*pkt)->getIface() << ") specified.";
+            errors.push_back(error.str());
+            ++pkt;
+            continue;
+        }
+        uint16_t sockfd = 0;
+        try {
+            sockfd = getSocket(**pkt).sockfd_;
+        } catch (const std::exception& ex) {
+            errors.push_back(ex.what());
+            ++pkt;
+            continue;
+        }
+
+        // Collect the consecutive packets to be sent over the same socket.
+        group.clear();
+        do {
+            group.push_back(*pkt);
+            ++pkt;
+        } while ((pkt != pkts.end()) &&
+                 ((*pkt)->getIface() == iface->getName()));
+
+        // Assuming that packet filter is not NULL, because its modifier
+        // checks it.
+        try {
+            sent += packet_filter_->sendBatch(*iface, sockfd, group, errors);
+        } catch (const std::exception& ex) {
+            errors.push_back(ex.what());
         }
     }
+    return (sent);
+}
 
-    // if there are any callbacks for external sockets registered...
-    if (!callbacks_.empty()) {
+size_t
+IfaceMgr::sendBatch(const std::vector<Pkt6Ptr>& pkts,
+                    std::vector<std::string>& errors) {
+    size_t sent = 0;
+    std::vector<Pkt6Ptr> group;
+    std::vector<Pkt6Ptr>::const_iterator pkt = pkts.begin();
+    while (pkt != pkts.end()) {
+        // The packet which can't be sent is skipped, so as it doesn't cause
+        // the loss of the other packets in the batch.
+        Iface* iface = getIface((*pkt)->getIface());
+        if (!iface) {
+            std::ostringstream error;
+            error << "Unable to send DHCPv6 message to "
+                  << (*pkt)->getRemoteAddr() << ". Invalid interface ("
+                  << (*pkt)->getIface() << ") specified.";
+            errors.push_back(error.str());
+            ++pkt;
+            continue;
+        }
+        uint16_t sockfd = 0;
+        try {
+            sockfd = getSocket(**pkt);
+        } catch (const std::exception& ex) {
+            errors.push_back(ex.what());
+            ++pkt;
+            continue;
+        }
+
+        // Collect the consecutive packets to be sent over the same socket.
+        // The socket depends on the local address of the packet, so it
+        // must be checked for each packet. The packet for which there is
+        // no socket ends the group and is reported in the next iteration.
+        group.clear();
+        do {
+            group.push_back(*pkt);
+            ++pkt;
+        } while ((pkt != pkts.end()) &&
+                 ((*pkt)->getIface() == iface->getName()) &&
+                 sameSocket(**pkt, sockfd));
+
+        // Assuming that packet filter is not NULL, because its modifier
+        // checks it.
+        try {
+            sent += packet_filter6_->sendBatch(*iface, sockfd, group, errors);
+        } catch (const std::exception& ex) {
+            errors.push_back(ex.what());
+        }
+    }
+    return (sent);
+}
+
+bool
+IfaceMgr::sameSocket(const Pkt6& pkt, const uint16_t sockfd) {
+    try {
+        return (getSocket(pkt) == sockfd);
+    } catch (const std::exception&) {
+        return (false);
+    }
+}
+
+const SocketInfo*
+IfaceMgr::waitForSocket(const uint16_t family, uint32_t timeout_sec,
+                        uint32_t timeout_usec,
+                        IfaceCollection::const_iterator& iface) {
+    // Sanity check for microsecond timeout.
+    if (timeout_usec >= 1000000) {
+        isc_throw(BadValue, "fractional timeout must be shorter than"
+                  " one million microseconds");
+    }
+
+    int sockfd = -1;
+
+#ifdef HAVE_SYS_EPOLL_H
+    // Register the sockets in a new epoll set if the sockets have changed
+    // since the current set was created.
+    if ((epoll_fd_ < 0) || (epoll_family_ != family) ||
+        (epoll_generation_ != sockets_generation)) {
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+        }
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            isc_throw(SocketReadError, "failed to create epoll set: "
+                      << strerror(errno));
+        }
+        epoll_family_ = family;
+        epoll_generation_ = sockets_generation;
+
+        std::vector<int> fds;
+        for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+            const Iface::SocketCollection& socket_collection =
+                iface->getSockets();
+            for (Iface::SocketCollection::const_iterator s =
+                     socket_collection.begin();
+                 s != socket_collection.end(); ++s) {
+                if (isFamilySocket(*s, family)) {
+                    fds.push_back(s->sockfd_);
+                }
+            }
+        }
         for (SocketCallbackInfoContainer::const_iterator s = callbacks_.begin();
              s != callbacks_.end(); ++s) {
-            FD_SET(s->socket_, &sockets);
-            if (maxfd < s->socket_) {
-                maxfd = s->socket_;
+            fds.push_back(s->socket_);
+        }
+
+        for (std::vector<int>::const_iterator fd = fds.begin();
+             fd != fds.end(); ++fd) {
+            struct epoll_event event;
+            memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN;
+            event.data.fd = *fd;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, *fd, &event) < 0) {
+                const int error = errno;
+                close(epoll_fd_);
+                epoll_fd_ = -1;
+                isc_throw(SocketReadError, "failed to add socket " << *fd
+                          << " to epoll set: " << strerror(error));
             }
         }
     }
 
-    struct timeval select_timeout;
-    select_timeout.tv_sec = timeout_sec;
-    select_timeout.tv_usec = timeout_usec;
-
-    int result = select(maxfd + 1, &sockets, NULL, NULL, &select_timeout);
+    // The epoll_wait() takes the timeout in milliseconds. Round it up, so
+    // as the call doesn't return before the timeout is reached.
+    const uint64_t timeout = static_cast<uint64_t>(timeout_sec) * 1000 +
+        (timeout_usec + 999) / 1000;
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int result = epoll_wait(epoll_fd_, events, EPOLL_MAX_EVENTS,
+                            std::min(timeout, static_cast<uint64_t>
+                                     (std::numeric_limits<int>::max())));
 
     if (result == 0) {
+        // Unlike select(), the epoll doesn't report an error for the socket
+        // which has been closed without removing it from the IfaceMgr. The
+        // socket is just silently removed from the epoll set, so check the
+        // sockets when nothing has been received.
+        for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+            const Iface::SocketCollection& socket_collection =
+                iface->getSockets();
+            for (Iface::SocketCollection::const_iterator s =
+                     socket_collection.begin();
+                 s != socket_collection.end(); ++s) {
+                if (isFamilySocket(*s, family) &&
+                    (fcntl(s->sockfd_, F_GETFD) < 0)) {
+                    isc_throw(SocketReadError, "socket " << s->sockfd_
+                              << " is not open: " << strerror(errno));
+                }
+            }
+        }
         // nothing received and timeout has been reached
-        return (Pkt4Ptr()); // NULL
+        return (NULL);
     } else if (result < 0) {
         isc_throw(SocketReadError, strerror(errno));
     }
@@ -888,70 +1141,42 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
     // Let's find out which socket has the data
     for (SocketCallbackInfoContainer::iterator s = callbacks_.begin();
          s != callbacks_.end(); ++s) {
-        if (!FD_ISSET(s->socket_, &sockets)) {
-            continue;
-        }
-
-        // something received over external socket
-
-        // Calling the external socket's callback provides its service
-        // layer access without integrating any specific features
-        // in IfaceMgr
-        if (s->callback_) {
-            s->callback_();
-        }
+        for (int i = 0; i < result; ++i) {
+            if (events[i].data.fd != s->socket_) {
+                continue;
+            }
 
-        return (Pkt4Ptr());
-    }
+            // something received over external socket
 
-    // Let's find out which interface/socket has the data
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
-        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
-             s != socket_collection.end(); ++s) {
-            if (FD_ISSET(s->sockfd_, &sockets)) {
-                candidate = &(*s);
-                break;
+            // Calling the external socket's callback provides its service
+            // layer access without integrating any specific features
+            // in IfaceMgr
+            if (s->callback_) {
+                s->callback_();
             }
-        }
-        if (candidate) {
-            break;
-        }
-    }
 
-    if (!candidate) {
-        isc_throw(SocketReadError, "received data over unknown socket");
+            return (NULL);
+        }
     }
 
-    // Now we have a socket, let's get some data from it!
-    // Assuming that packet filter is not NULL, because its modifier checks it.
-    return (packet_filter_->receive(*iface, *candidate));
-}
+    // None of the ready sockets is external, so all of them are the
+    // sockets open by the IfaceMgr.
+    sockfd = events[0].data.fd;
 
-Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */ ) {
-    // Sanity check for microsecond timeout.
-    if (timeout_usec >= 1000000) {
-        isc_throw(BadValue, "fractional timeout must be shorter than"
-                  " one million microseconds");
-    }
-
-    const SocketInfo* candidate = 0;
+#else
     fd_set sockets;
     int maxfd = 0;
 
     FD_ZERO(&sockets);
 
-    /// @todo: marginal performance optimization. We could create the set once
-    /// and then use its copy for select(). Please note that select() modifies
-    /// provided set to indicated which sockets have something to read.
-    IfaceCollection::const_iterator iface;
     for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+
         const Iface::SocketCollection& socket_collection = iface->getSockets();
         for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
              s != socket_collection.end(); ++s) {
 
-            // Only deal with IPv6 addresses.
-            if (s->addr_.isV6()) {
+            // Only deal with the sockets of the requested family.
+            if (isFamilySocket(*s, family)) {
 
                 // Add this socket to listening set
                 FD_SET(s->sockfd_, &sockets);
@@ -966,8 +1191,6 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
     if (!callbacks_.empty()) {
         for (SocketCallbackInfoContainer::const_iterator s = callbacks_.begin();
              s != callbacks_.end(); ++s) {
-
-            // Add it to the set as well
             FD_SET(s->socket_, &sockets);
             if (maxfd < s->socket_) {
                 maxfd = s->socket_;
@@ -983,7 +1206,7 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
 
     if (result == 0) {
         // nothing received and timeout has been reached
-        return (Pkt6Ptr()); // NULL
+        return (NULL);
     } else if (result < 0) {
         isc_throw(SocketReadError, strerror(errno));
     }
@@ -1004,7 +1227,7 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
             s->callback_();
         }
 
-        return (Pkt6Ptr());
+        return (NULL);
     }
 
     // Let's find out which interface/socket has the data
@@ -1012,21 +1235,37 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
         const Iface::SocketCollection& socket_collection = iface->getSockets();
         for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
              s != socket_collection.end(); ++s) {
-            if (FD_ISSET(s->sockfd_, &sockets)) {
-                candidate = &(*s);
+            if (isFamilySocket(*s, family) && FD_ISSET(s->sockfd_, &sockets)) {
+                sockfd = s->sockfd_;
                 break;
             }
         }
-        if (candidate) {
+        if (sockfd >= 0) {
             break;
         }
     }
+#endif
 
+    const SocketInfo* candidate = findSocket(family, sockfd, iface);
     if (!candidate) {
         isc_throw(SocketReadError, "received data over unknown socket");
     }
-    // Assuming that packet filter is not NULL, because its modifier checks it.
-    return (packet_filter6_->receive(*candidate));
+    return (candidate);
+}
+
+const SocketInfo*
+IfaceMgr::findSocket(const uint16_t family, const int sockfd,
+                     IfaceCollection::const_iterator& iface) const {
+    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+        const Iface::SocketCollection& socket_collection = iface->getSockets();
+        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
+             s != socket_collection.end(); ++s) {
+            if ((s->sockfd_ == sockfd) && isFamilySocket(*s, family)) {
+                return (&(*s));
+            }
+        }
+    }
+    return (NULL);
 }
 
 uint16_t IfaceMgr::getSocket(const isc::dhcp::Pkt6& pkt) {
@@ -29,6 +29,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include <list>
+#include <vector>
 
 namespace isc {
 
@@ -281,9 +282,7 @@ public:
     /// @brief Adds socket descriptor to an interface.
     ///
     /// @param sock SocketInfo structure that describes socket.
-    void addSocket(const SocketInfo& sock) {
-        sockets_.push_back(sock);
-    }
+    void addSocket(const SocketInfo& sock);
 
     /// @brief Closes socket.
     ///
@@ -585,6 +584,86 @@ public:
     /// @return Pkt4 object representing received packet (or NULL)
     Pkt4Ptr receive4(uint32_t timeout_sec, uint32_t timeout_usec = 0);
 
+    /// @brief Tries to receive multiple IPv6 packets over open IPv6 sockets.
+    ///
+    /// Waits for the data on any of the open IPv6 sockets, like
+    /// @c receive6, and then receives the packets queued on the socket which
+    /// became ready, up to the specified number of packets. Where the system
+    /// supports it, all these packets are received with a single system call.
+    ///
+    /// @param [out] pkts vector to which the received packets are appended
+    /// @param max_pkts maximum number of packets to receive
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if error occured when receiving
+    /// packets.
+    /// @return number of packets appended to the vector; 0 if the timeout
+    /// has been reached or the data arrived over an external socket.
+    size_t receiveBatch6(std::vector<Pkt6Ptr>& pkts, const size_t max_pkts,
+                         uint32_t timeout_sec, uint32_t timeout_usec = 0);
+
+    /// @brief Tries to receive multiple IPv4 packets over open IPv4 sockets.
+    ///
+    /// Waits for the data on any of the open IPv4 sockets, like
+    /// @c receive4, and then receives the packets queued on the socket which
+    /// became ready, up to the specified number of packets. Where the system
+    /// supports it, all these packets are received with a single system call.
+    ///
+    /// @param [out] pkts vector to which the received packets are appended
+    /// @param max_pkts maximum number of packets to receive
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if error occured when receiving
+    /// packets.
+    /// @return number of packets appended to the vector; 0 if the timeout
+    /// has been reached or the data arrived over an external socket.
+    size_t receiveBatch4(std::vector<Pkt4Ptr>& pkts, const size_t max_pkts,
+                         uint32_t timeout_sec, uint32_t timeout_usec = 0);
+
+    /// @brief Sends multiple IPv6 packets.
+    ///
+    /// The consecutive packets to be sent over the same socket are sent
+    /// together, with a single system call where the system supports it.
+    ///
+    /// A packet which can't be sent, e.g. because of the invalid interface
+    /// specified in it or an error reported by the socket, doesn't cause
+    /// the loss of the other packets: it is skipped, the reason of the
+    /// failure is appended to the errors and the remaining packets are
+    /// sent.
+    ///
+    /// @param pkts packets to be sent
+    /// @param [out] errors vector to which the description of each failure
+    /// is appended
+    ///
+    /// @return number of packets sent
+    size_t sendBatch(const std::vector<Pkt6Ptr>& pkts,
+                     std::vector<std::string>& errors);
+
+    /// @brief Sends multiple IPv4 packets.
+    ///
+    /// The consecutive packets to be sent over the same socket are sent
+    /// together, with a single system call where the system supports it.
+    ///
+    /// A packet which can't be sent, e.g. because of the invalid interface
+    /// specified in it or an error reported by the socket, doesn't cause
+    /// the loss of the other packets: it is skipped, the reason of the
+    /// failure is appended to the errors and the remaining packets are
+    /// sent.
+    ///
+    /// @param pkts packets to be sent
+    /// @param [out] errors vector to which the description of each failure
+    /// is appended
+    ///
+    /// @return number of packets sent
+    size_t sendBatch(const std::vector<Pkt4Ptr>& pkts,
+                     std::vector<std::string>& errors);
+
     /// Opens UDP/IP socket and binds it to address, interface and port.
     ///
     /// Specific type of socket (UDP/IPv4 or UDP/IPv6) depends on passed addr
@@ -883,9 +962,7 @@ public:
     /// @param iface reference to Iface object.
     /// @note This function must be public because it has to be callable
     /// from unit tests.
-    void addInterface(const Iface& iface) {
-        ifaces_.push_back(iface);
-    }
+    void addInterface(const Iface& iface);
 
     /// @brief Checks if there is at least one socket of the specified family
     /// open.
@@ -999,6 +1076,55 @@ protected:
     bool os_receive4(struct msghdr& m, Pkt4Ptr& pkt);
 
 private:
+    /// @brief Waits for the data on the open sockets.
+    ///
+    /// This is the common part of the @c receive4, @c receive6 and their
+    /// batch variants. It waits until the data is available on any of the
+    /// sockets used for the specified family or on any of the external
+    /// sockets. The callbacks of the external sockets take precedence over
+    /// the reception of the DHCP packets.
+    ///
+    /// Where the system supports epoll, the sockets are registered in the
+    /// epoll set only when the sockets have been added or removed since the
+    /// last call, rather than collected on every call.
+    ///
+    /// @param family AF_INET or AF_INET6.
+    /// @param timeout_sec specifies integral part of the timeout (in seconds)
+    /// @param timeout_usec specifies fractional part of the timeout
+    /// (in microseconds)
+    /// @param [out] iface interface of the returned socket.
+    ///
+    /// @throw isc::BadValue if timeout_usec is greater than one million
+    /// @throw isc::dhcp::SocketReadError if error occured when waiting for
+    /// the data or the data arrived over unknown socket.
+    /// @return socket on which the data is available or NULL if the timeout
+    /// has been reached or the data arrived over an external socket.
+    const SocketInfo* waitForSocket(const uint16_t family,
+                                    uint32_t timeout_sec,
+                                    uint32_t timeout_usec,
+                                    IfaceCollection::const_iterator& iface);
+
+    /// @brief Returns the socket with the specified descriptor.
+    ///
+    /// @param family AF_INET or AF_INET6.
+    /// @param sockfd socket descriptor.
+    /// @param [out] iface interface of the returned socket.
+    ///
+    /// @return socket with the specified descriptor or NULL if there is no
+    /// such socket of the specified family.
+    const SocketInfo* findSocket(const uint16_t family, const int sockfd,
+                                 IfaceCollection::const_iterator& iface) const;
+
+    /// @brief Checks if the message is to be sent over the specified socket.
+    ///
+    /// @param pkt DHCPv6 message to be sent.
+    /// @param sockfd socket descriptor.
+    ///
+    /// @return true if the socket returned by @c getSocket for the message
+    /// is the specified one, false otherwise or if there is no socket to
+    /// send the message over.
+    bool sameSocket(const Pkt6& pkt, const uint16_t sockfd);
+
     /// @brief Identifies local network address to be used to
     /// connect to remote address.
     ///
@@ -1059,6 +1185,17 @@ private:
 
     /// @brief Contains list of callbacks for external sockets
     SocketCallbackInfoContainer callbacks_;
+
+    /// @brief Descriptor of the epoll set or -1 if the set has not been
+    /// created (or epoll is not supported by the system).
+    int epoll_fd_;
+
+    /// @brief Family of the sockets registered in the epoll set.
+    uint16_t epoll_family_;
+
+    /// @brief Value of the socket change counter at the time when the
+    /// epoll set has been created.
+    uint64_t epoll_generation_;
 };
 
 }; // namespace isc::dhcp
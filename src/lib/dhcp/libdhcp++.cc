@@ -52,6 +52,10 @@ VendorOptionDefContainers LibDHCP::vendor4_defs_;
 
 VendorOptionDefContainers LibDHCP::vendor6_defs_;
 
+// Empty container of option definitions, used for the option spaces other
+// than the standard ones.
+static const OptionDefContainer empty_option_defs;
+
 // Those two vendor classes are used for cable modems:
 
 /// DOCSIS3.0 compatible cable modem
@@ -215,11 +219,10 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
     size_t offset = 0;
     size_t length = buf.size();
 
-    // Get the list of standard option definitions.
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp6") {
-        option_defs = LibDHCP::getOptionDefs(Option::V6);
-    }
+    // Get the list of standard option definitions. The container is
+    // referenced rather than copied for each received packet.
+    const OptionDefContainer& option_defs = (option_space == "dhcp6") ?
+        LibDHCP::getOptionDefs(Option::V6) : empty_option_defs;
     // @todo Once we implement other option spaces we should add else clause
     // here and gather option definitions for them. For now leaving option_defs
     // empty will imply creation of generic Option.
@@ -315,11 +318,10 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                                isc::dhcp::OptionCollection& options) {
     size_t offset = 0;
 
-    // Get the list of stdandard option definitions.
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp4") {
-        option_defs = LibDHCP::getOptionDefs(Option::V4);
-    }
+    // Get the list of standard option definitions. The container is
+    // referenced rather than copied for each received packet.
+    const OptionDefContainer& option_defs = (option_space == "dhcp4") ?
+        LibDHCP::getOptionDefs(Option::V4) : empty_option_defs;
     // @todo Once we implement other option spaces we should add else clause
     // here and gather option definitions for them. For now leaving option_defs
     // empty will imply creation of generic Option.
@@ -580,10 +582,15 @@ size_t LibDHCP::unpackVendorOptions4(const uint32_t vendor_id, const OptionBuffe
 
 void
 LibDHCP::packOptions(isc::util::OutputBuffer& buf,
-                     const OptionCollection& options) {
+                     const OptionCollection& options,
+                     const bool precompiled) {
     for (OptionCollection::const_iterator it = options.begin();
          it != options.end(); ++it) {
-        it->second->pack(buf);
+        if (precompiled) {
+            it->second->packPrecompiled(buf);
+        } else {
+            it->second->pack(buf);
+        }
     }
 }
 
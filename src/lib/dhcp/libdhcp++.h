@@ -110,8 +110,12 @@ public:
     ///
     /// @param buf output buffer (assembled options will be stored here)
     /// @param options collection of options to store to
+    /// @param precompiled if true, the on-wire data of the precompiled
+    ///        options are copied rather than packing these options again
+    ///        (see @c Option::precompile).
     static void packOptions(isc::util::OutputBuffer& buf,
-                            const isc::dhcp::OptionCollection& options);
+                            const isc::dhcp::OptionCollection& options,
+                            const bool precompiled = false);
 
     /// @brief Parses provided buffer as DHCPv4 options and creates Option objects.
     ///
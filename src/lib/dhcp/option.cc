@@ -114,6 +114,43 @@ Option::packHeader(isc::util::OutputBuffer& buf) {
     }
 }
 
+void
+Option::precompile() {
+    // The sub-options are precompiled too, so as isPrecompiled can tell
+    // whether any of them has been modified since.
+    for (OptionCollection::const_iterator opt = options_.begin();
+         opt != options_.end(); ++opt) {
+        opt->second->precompile();
+    }
+    isc::util::OutputBuffer buf(0);
+    pack(buf);
+    const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+    precompiled_.assign(data, data + buf.getLength());
+}
+
+bool
+Option::isPrecompiled() const {
+    if (precompiled_.empty()) {
+        return (false);
+    }
+    for (OptionCollection::const_iterator opt = options_.begin();
+         opt != options_.end(); ++opt) {
+        if (!opt->second->isPrecompiled()) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+void
+Option::packPrecompiled(isc::util::OutputBuffer& buf) {
+    if (isPrecompiled()) {
+        buf.writeData(&precompiled_[0], precompiled_.size());
+    } else {
+        pack(buf);
+    }
+}
+
 void
 Option::packOptions(isc::util::OutputBuffer& buf) {
     LibDHCP::packOptions(buf, options_);
@@ -126,6 +163,7 @@ void Option::unpack(OptionBufferConstIter begin,
 
 void
 Option::unpackOptions(const OptionBuffer& buf) {
+    invalidatePrecompiled();
     // If custom option parsing function has been set, use this function
     // to parse options. Otherwise, use standard function from libdhcp++.
     if (!callback_.empty()) {
@@ -188,6 +226,7 @@ bool Option::delOption(uint16_t opt_type) {
     isc::dhcp::OptionCollection::iterator x = options_.find(opt_type);
     if ( x != options_.end() ) {
         options_.erase(x);
+        invalidatePrecompiled();
         return true; // delete successful
     }
     return (false); // option not found, can't delete
@@ -239,6 +278,7 @@ void Option::addOption(OptionPtr opt) {
         }
     }
     options_.insert(make_pair(opt->getType(), opt));
+    invalidatePrecompiled();
 }
 
 uint8_t Option::getUint8() {
@@ -262,16 +302,19 @@ uint32_t Option::getUint32() {
 void Option::setUint8(uint8_t value) {
     data_.resize(sizeof(value));
     data_[0] = value;
+    invalidatePrecompiled();
 }
 
 void Option::setUint16(uint16_t value) {
     data_.resize(sizeof(value));
     writeUint16(value, &data_[0], data_.size());
+    invalidatePrecompiled();
 }
 
 void Option::setUint32(uint32_t value) {
     data_.resize(sizeof(value));
     writeUint32(value, &data_[0], data_.size());
+    invalidatePrecompiled();
 }
 
 bool Option::equal(const OptionPtr& other) const {
@@ -15,6 +15,7 @@
 #ifndef OPTION_H
 #define OPTION_H
 
+#include <dhcp/option_arena.h>
 #include <util/buffer.h>
 
 #include <boost/function.hpp>
@@ -46,7 +47,12 @@ class Option;
 typedef boost::shared_ptr<Option> OptionPtr;
 
 /// A collection of DHCP (v4 or v6) options
-typedef std::multimap<unsigned int, OptionPtr> OptionCollection;
+///
+/// Its nodes are allocated from the @c OptionArena.
+typedef std::multimap<unsigned int, OptionPtr, std::less<unsigned int>,
+                      OptionArenaAllocator<std::pair<const unsigned int,
+                                                     OptionPtr> > >
+OptionCollection;
 
 /// @brief This type describes a callback function to parse options from buffer.
 ///
@@ -324,6 +330,7 @@ public:
     template<typename InputIterator>
     void setData(InputIterator first, InputIterator last) {
         data_.assign(first, last);
+        invalidatePrecompiled();
     }
 
     /// @brief Sets the name of the option space encapsulated by this option.
@@ -332,6 +339,7 @@ public:
     /// this option.
     void setEncapsulatedSpace(const std::string& encapsulated_space) {
         encapsulated_space_ = encapsulated_space;
+        invalidatePrecompiled();
     }
 
     /// @brief Returns the name of the option space encapsulated by this option.
@@ -349,9 +357,58 @@ public:
         callback_ = callback;
     }
 
+    /// @brief Stores the option in the on-wire format for later use.
+    ///
+    /// The option is packed once and the resulting data are copied into
+    /// the buffer by @c packPrecompiled, rather than packing the option
+    /// again for each packet. This is meant for the options which are not
+    /// modified once created, e.g. the options configured for a subnet.
+    ///
+    /// The sub-options are precompiled as well. The stored data are
+    /// discarded when the option is modified (see @c invalidatePrecompiled)
+    /// and they are not used if any of its sub-options has been modified
+    /// since.
+    ///
+    /// @throw an exception thrown by the @c pack method.
+    virtual void precompile();
+
+    /// @brief Checks if the option has been precompiled.
+    ///
+    /// @return true if the on-wire data stored by @c precompile are present
+    /// and neither the option nor any of its sub-options has been modified
+    /// since.
+    virtual bool isPrecompiled() const;
+
+    /// @brief Stores the option in a buffer, using the on-wire data stored
+    /// by @c precompile if they are still valid.
+    ///
+    /// @param [out] buf output buffer.
+    virtual void packPrecompiled(isc::util::OutputBuffer& buf);
+
     /// just to force that every option has virtual dtor
     virtual ~Option();
 
+    /// @brief Allocates the memory for the option from the @c OptionArena.
+    ///
+    /// It is inherited by the derived classes, so as all options are
+    /// allocated from the arena.
+    ///
+    /// @param size size of the option object
+    static void* operator new(size_t size) {
+        return (OptionArena::allocate(size));
+    }
+
+    /// @brief Returns the memory of the option to the @c OptionArena.
+    ///
+    /// The destructor is virtual, so the size is the size of the most
+    /// derived class.
+    ///
+    /// @param ptr pointer to the option object
+    /// @param size size of the option object
+    static void operator delete(void* ptr, size_t size) {
+        OptionArena::deallocate(ptr, size);
+    }
+
     /// @brief Checks if two options are equal
     ///
     /// Equality verifies option type and option content. Care should
@@ -367,6 +424,14 @@ public:
 
 protected:
 
+    /// @brief Discards the on-wire data stored by @c precompile.
+    ///
+    /// It must be called by every method which modifies the option,
+    /// including the methods of the derived classes.
+    virtual void invalidatePrecompiled() {
+        precompiled_.clear();
+    }
+
     /// @brief Store option's header in a buffer.
     ///
     /// This method writes option's header into a buffer in the
@@ -437,6 +502,9 @@ protected:
     /// A callback to be called to unpack options from the packet.
     UnpackOptionsCallback callback_;
 
+    /// On-wire data stored by @c precompile.
+    OptionBuffer precompiled_;
+
     /// @todo probably 2 different containers have to be used for v4 (unique
     /// options) and v6 (options with the same type can repeat)
 };
@@ -86,6 +86,7 @@ Option4AddrLst::pack(isc::util::OutputBuffer& buf) {
 }
 
 void Option4AddrLst::setAddress(const isc::asiolink::IOAddress& addr) {
+    invalidatePrecompiled();
     if (!addr.isV4()) {
         isc_throw(BadValue, "Can't store non-IPv4 address in "
                   << "Option4AddrLst option");
@@ -95,6 +96,7 @@ void Option4AddrLst::setAddress(const isc::asiolink::IOAddress& addr) {
 }
 
 void Option4AddrLst::setAddresses(const AddressContainer& addrs) {
+    invalidatePrecompiled();
 
     // Do not copy it as a whole. addAddress() does sanity checks.
     // i.e. throw if someone tries to set IPv6 address.
@@ -107,6 +109,7 @@ void Option4AddrLst::setAddresses(const AddressContainer& addrs) {
 
 
 void Option4AddrLst::addAddress(const isc::asiolink::IOAddress& addr) {
+    invalidatePrecompiled();
     if (!addr.isV4()) {
         isc_throw(BadValue, "Can't store non-IPv4 address in "
                   << "Option4AddrLst option");
@@ -359,6 +359,7 @@ Option4ClientFqdn&
 // constructor of Option4ClientFqdnImpl to copy all required values.
 // cppcheck-suppress operatorEqToSelf
 Option4ClientFqdn::operator=(const Option4ClientFqdn& source) {
+    invalidatePrecompiled();
     Option4ClientFqdnImpl* old_impl = impl_;
     impl_ = new Option4ClientFqdnImpl(*source.impl_);
     delete(old_impl);
@@ -379,6 +380,7 @@ Option4ClientFqdn::getFlag(const uint8_t flag) const {
 
 void
 Option4ClientFqdn::setFlag(const uint8_t flag, const bool set_flag) {
+    invalidatePrecompiled();
     // Check that flag is in range between 0x1 and 0x7. Although it is
     // discouraged this check doesn't preclude the caller from setting
     // multiple flags concurrently.
@@ -406,12 +408,14 @@ Option4ClientFqdn::setFlag(const uint8_t flag, const bool set_flag) {
 
 void
 Option4ClientFqdn::setRcode(const Rcode& rcode) {
+    invalidatePrecompiled();
     impl_->rcode1_ = rcode;
     impl_->rcode2_ = rcode;
 }
 
 void
 Option4ClientFqdn::resetFlags() {
+    invalidatePrecompiled();
     impl_->flags_ = 0;
 }
 
@@ -455,6 +459,7 @@ Option4ClientFqdn::packDomainName(isc::util::OutputBuffer& buf) const {
 void
 Option4ClientFqdn::setDomainName(const std::string& domain_name,
                                  const DomainNameType domain_name_type) {
+    invalidatePrecompiled();
     impl_->setDomainName(domain_name, domain_name_type);
 }
 
@@ -484,6 +489,7 @@ Option4ClientFqdn::pack(isc::util::OutputBuffer& buf) {
 void
 Option4ClientFqdn::unpack(OptionBufferConstIter first,
                           OptionBufferConstIter last) {
+    invalidatePrecompiled();
     setData(first, last);
     impl_->parseWireData(first, last);
     // Check that the flags in the received option are valid. Ignore MBZ bits,
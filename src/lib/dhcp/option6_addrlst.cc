@@ -49,6 +49,7 @@ Option6AddrLst::Option6AddrLst(uint16_t type, OptionBufferConstIter begin,
 
 void
 Option6AddrLst::setAddress(const isc::asiolink::IOAddress& addr) {
+    invalidatePrecompiled();
     if (!addr.isV6()) {
         isc_throw(BadValue, "Can't store non-IPv6 address in Option6AddrLst option");
     }
@@ -59,6 +60,7 @@ Option6AddrLst::setAddress(const isc::asiolink::IOAddress& addr) {
 
 void
 Option6AddrLst::setAddresses(const AddressContainer& addrs) {
+    invalidatePrecompiled();
     addrs_ = addrs;
 }
 
@@ -84,6 +86,7 @@ void Option6AddrLst::pack(isc::util::OutputBuffer& buf) {
 
 void Option6AddrLst::unpack(OptionBufferConstIter begin,
                         OptionBufferConstIter end) {
+    invalidatePrecompiled();
     if ((distance(begin, end) % V6ADDRESS_LEN) != 0) {
         isc_throw(OutOfRange, "Option " << type_
                   << " malformed: len=" << distance(begin, end)
@@ -306,6 +306,7 @@ Option6ClientFqdn&
 // constructor of Option6ClientFqdnImpl to copy all required values.
 // cppcheck-suppress operatorEqToSelf
 Option6ClientFqdn::operator=(const Option6ClientFqdn& source) {
+    invalidatePrecompiled();
     Option6ClientFqdnImpl* old_impl = impl_;
     impl_ = new Option6ClientFqdnImpl(*source.impl_);
     delete(old_impl);
@@ -326,6 +327,7 @@ Option6ClientFqdn::getFlag(const uint8_t flag) const {
 
 void
 Option6ClientFqdn::setFlag(const uint8_t flag, const bool set_flag) {
+    invalidatePrecompiled();
     // Check that flag is in range between 0x1 and 0x7. Note that this
     // allows to set or clear multiple flags concurrently. Setting
     // concurrent bits is discouraged (see header file) but it is not
@@ -353,6 +355,7 @@ Option6ClientFqdn::setFlag(const uint8_t flag, const bool set_flag) {
 
 void
 Option6ClientFqdn::resetFlags() {
+    invalidatePrecompiled();
     impl_->flags_ = 0;
 }
 
@@ -389,6 +392,7 @@ Option6ClientFqdn::packDomainName(isc::util::OutputBuffer& buf) const {
 void
 Option6ClientFqdn::setDomainName(const std::string& domain_name,
                                  const DomainNameType domain_name_type) {
+    invalidatePrecompiled();
     impl_->setDomainName(domain_name, domain_name_type);
 }
 
@@ -415,6 +419,7 @@ Option6ClientFqdn::pack(isc::util::OutputBuffer& buf) {
 void
 Option6ClientFqdn::unpack(OptionBufferConstIter first,
                           OptionBufferConstIter last) {
+    invalidatePrecompiled();
     setData(first, last);
     impl_->parseWireData(first, last);
     // Check that the flags in the received option are valid. Ignore MBZ bits
@@ -67,6 +67,7 @@ void Option6IA::pack(isc::util::OutputBuffer& buf) {
 
 void Option6IA::unpack(OptionBufferConstIter begin,
                        OptionBufferConstIter end) {
+    invalidatePrecompiled();
     // IA_NA and IA_PD have 12 bytes content (iaid, t1, t2 fields)
     // followed by 0 or more sub-options.
     if (distance(begin, end) < OPTION6_IA_LEN) {
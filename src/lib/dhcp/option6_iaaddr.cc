@@ -70,6 +70,7 @@ void Option6IAAddr::pack(isc::util::OutputBuffer& buf) {
 
 void Option6IAAddr::unpack(OptionBuffer::const_iterator begin,
                       OptionBuffer::const_iterator end) {
+    invalidatePrecompiled();
     if ( distance(begin, end) < OPTION6_IAADDR_LEN) {
         isc_throw(OutOfRange, "Option " << type_ << " truncated");
     }
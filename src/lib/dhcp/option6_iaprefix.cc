@@ -72,6 +72,7 @@ void Option6IAPrefix::pack(isc::util::OutputBuffer& buf) {
 
 void Option6IAPrefix::unpack(OptionBuffer::const_iterator begin,
                       OptionBuffer::const_iterator end) {
+    invalidatePrecompiled();
     if ( distance(begin, end) < OPTION6_IAPREFIX_LEN) {
         isc_throw(OutOfRange, "Option " << type_ << " truncated");
     }
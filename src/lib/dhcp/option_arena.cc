@@ -0,0 +1,178 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/option_arena.h>
+
+#include <pthread.h>
+
+namespace {
+
+using isc::dhcp::OptionArena;
+
+/// @brief Number of the size classes of the pooled blocks.
+const size_t SIZE_CLASSES =
+    OptionArena::MAX_BLOCK_SIZE / OptionArena::BLOCK_ALIGNMENT;
+
+/// @brief Free block, linked with the other free blocks of its size class.
+struct FreeBlock {
+    FreeBlock* next_;
+};
+
+/// @brief Free lists of a thread.
+struct ThreadArena {
+    /// @brief Constructor.
+    ThreadArena() : allocated_(0), reused_(0) {
+        for (size_t i = 0; i < SIZE_CLASSES; ++i) {
+            free_[i] = NULL;
+            free_count_[i] = 0;
+        }
+    }
+
+    /// @brief Destructor.
+    ///
+    /// Releases the free blocks.
+    ~ThreadArena() {
+        for (size_t i = 0; i < SIZE_CLASSES; ++i) {
+            while (free_[i] != NULL) {
+                FreeBlock* block = free_[i];
+                free_[i] = block->next_;
+                ::operator delete(block);
+            }
+        }
+    }
+
+    /// @brief Free blocks of each size class.
+    FreeBlock* free_[SIZE_CLASSES];
+
+    /// @brief Number of the free blocks of each size class.
+    size_t free_count_[SIZE_CLASSES];
+
+    /// @brief Number of the blocks allocated from the global allocator.
+    size_t allocated_;
+
+    /// @brief Number of the reused blocks.
+    size_t reused_;
+};
+
+/// @brief Guards the creation of the key.
+pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+
+/// @brief Key of the thread-specific free lists.
+pthread_key_t arena_key;
+
+/// @brief Deletes the free lists of the terminated thread.
+///
+/// @param arena free lists of the thread.
+void
+destroyArena(void* arena) {
+    delete static_cast<ThreadArena*>(arena);
+}
+
+/// @brief Creates the key of the thread-specific free lists.
+void
+createArenaKey() {
+    (void) pthread_key_create(&arena_key, &destroyArena);
+}
+
+/// @brief Returns the free lists of the calling thread.
+///
+/// @return free lists or NULL if they can't be created, in which case the
+/// blocks are neither pooled nor counted.
+ThreadArena*
+getArena() {
+    (void) pthread_once(&arena_once, &createArenaKey);
+    void* arena = pthread_getspecific(arena_key);
+    if (arena == NULL) {
+        arena = new(std::nothrow) ThreadArena();
+        if ((arena != NULL) && (pthread_setspecific(arena_key, arena) != 0)) {
+            delete static_cast<ThreadArena*>(arena);
+            arena = NULL;
+        }
+    }
+    return (static_cast<ThreadArena*>(arena));
+}
+
+/// @brief Returns the size class of the block.
+///
+/// @param size size of the block, not greater than MAX_BLOCK_SIZE
+size_t
+sizeClass(const size_t size) {
+    return (size == 0 ? 0 : (size - 1) / OptionArena::BLOCK_ALIGNMENT);
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+const size_t OptionArena::MAX_BLOCK_SIZE;
+const size_t OptionArena::BLOCK_ALIGNMENT;
+const size_t OptionArena::MAX_FREE_BLOCKS;
+
+void*
+OptionArena::allocate(const size_t size) {
+    if (size > MAX_BLOCK_SIZE) {
+        return (::operator new(size));
+    }
+    const size_t size_class = sizeClass(size);
+    ThreadArena* arena = getArena();
+    if (arena != NULL) {
+        FreeBlock* block = arena->free_[size_class];
+        if (block != NULL) {
+            arena->free_[size_class] = block->next_;
+            --arena->free_count_[size_class];
+            ++arena->reused_;
+            return (block);
+        }
+        ++arena->allocated_;
+    }
+    // The block is allocated with the full size of its class, so as it
+    // may be reused for any block of this class.
+    return (::operator new((size_class + 1) * BLOCK_ALIGNMENT));
+}
+
+void
+OptionArena::deallocate(void* ptr, const size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (size <= MAX_BLOCK_SIZE) {
+        const size_t size_class = sizeClass(size);
+        ThreadArena* arena = getArena();
+        if ((arena != NULL) &&
+            (arena->free_count_[size_class] < MAX_FREE_BLOCKS)) {
+            FreeBlock* block = static_cast<FreeBlock*>(ptr);
+            block->next_ = arena->free_[size_class];
+            arena->free_[size_class] = block;
+            ++arena->free_count_[size_class];
+            return;
+        }
+    }
+    ::operator delete(ptr);
+}
+
+size_t
+OptionArena::getAllocated() {
+    ThreadArena* arena = getArena();
+    return (arena != NULL ? arena->allocated_ : 0);
+}
+
+size_t
+OptionArena::getReused() {
+    ThreadArena* arena = getArena();
+    return (arena != NULL ? arena->reused_ : 0);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
@@ -0,0 +1,167 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef OPTION_ARENA_H
+#define OPTION_ARENA_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Per-thread pool of the memory blocks holding the options.
+///
+/// Each received packet and each response creates a number of options,
+/// which are destroyed once the packet has been processed. The option
+/// objects and the nodes of the option collections are small and of a
+/// handful of sizes, so the freed blocks are kept on the free lists of
+/// the calling thread and handed out again to the next option of the same
+/// size class, rather than being returned to the global allocator.
+///
+/// The blocks are allocated with the global operator new, so a block
+/// allocated by one thread may be freed by another one: it then goes to
+/// the free list of the thread freeing it. Each free list is bounded, and
+/// the free lists of a thread are released when the thread terminates.
+///
+/// The blocks larger than @c MAX_BLOCK_SIZE are not pooled.
+class OptionArena {
+public:
+    /// @brief Size of the largest pooled block.
+    static const size_t MAX_BLOCK_SIZE = 256;
+
+    /// @brief Granularity of the sizes of the pooled blocks.
+    static const size_t BLOCK_ALIGNMENT = 16;
+
+    /// @brief Maximum number of the free blocks of each size kept by a
+    /// thread.
+    static const size_t MAX_FREE_BLOCKS = 1024;
+
+    /// @brief Allocates the memory block.
+    ///
+    /// @param size size of the block
+    ///
+    /// @return pointer to the block
+    /// @throw std::bad_alloc if the memory can't be allocated.
+    static void* allocate(const size_t size);
+
+    /// @brief Returns the memory block to the pool.
+    ///
+    /// @param ptr pointer to the block (may be NULL)
+    /// @param size size of the block, as passed to @c allocate
+    static void deallocate(void* ptr, const size_t size);
+
+    /// @brief Returns the number of the blocks allocated from the global
+    /// allocator by the calling thread.
+    ///
+    /// Together with @c getReused it shows how many allocations the pool
+    /// saves.
+    static size_t getAllocated();
+
+    /// @brief Returns the number of the blocks reused by the calling
+    /// thread.
+    static size_t getReused();
+};
+
+/// @brief Allocator taking the memory from the @c OptionArena.
+///
+/// It is used for the nodes of the option collections.
+///
+/// @tparam T type of the allocated objects
+template<typename T>
+class OptionArenaAllocator {
+public:
+    /// @name Standard allocator types.
+    //@{
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind {
+        typedef OptionArenaAllocator<U> other;
+    };
+    //@}
+
+    /// @brief Constructor.
+    OptionArenaAllocator() {
+    }
+
+    /// @brief Copy constructor from the allocator of another type.
+    template<typename U>
+    OptionArenaAllocator(const OptionArenaAllocator<U>&) {
+    }
+
+    /// @brief Returns the address of the object.
+    pointer address(reference x) const {
+        return (&x);
+    }
+
+    /// @brief Returns the address of the object.
+    const_pointer address(const_reference x) const {
+        return (&x);
+    }
+
+    /// @brief Allocates the memory for n objects.
+    pointer allocate(size_type n, const void* = 0) {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        return (static_cast<pointer>(OptionArena::allocate(n * sizeof(T))));
+    }
+
+    /// @brief Frees the memory allocated for n objects.
+    void deallocate(pointer p, size_type n) {
+        OptionArena::deallocate(p, n * sizeof(T));
+    }
+
+    /// @brief Returns the maximum number of objects which may be allocated.
+    size_type max_size() const {
+        return (std::numeric_limits<size_type>::max() / sizeof(T));
+    }
+
+    /// @brief Constructs the object at the specified address.
+    void construct(pointer p, const T& value) {
+        new(static_cast<void*>(p)) T(value);
+    }
+
+    /// @brief Destroys the object at the specified address.
+    void destroy(pointer p) {
+        p->~T();
+    }
+};
+
+/// @brief All arena allocators are equal.
+template<typename T, typename U>
+bool operator==(const OptionArenaAllocator<T>&,
+                const OptionArenaAllocator<U>&) {
+    return (true);
+}
+
+/// @brief All arena allocators are equal.
+template<typename T, typename U>
+bool operator!=(const OptionArenaAllocator<T>&,
+                const OptionArenaAllocator<U>&) {
+    return (false);
+}
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // OPTION_ARENA_H
@@ -49,6 +49,7 @@ OptionCustom::OptionCustom(const OptionDefinition& def,
 
 void
 OptionCustom::addArrayDataField(const asiolink::IOAddress& address) {
+    invalidatePrecompiled();
     checkArrayType();
 
     if ((address.isV4() && definition_.getType() != OPT_IPV4_ADDRESS_TYPE) ||
@@ -66,6 +67,7 @@ OptionCustom::addArrayDataField(const asiolink::IOAddress& address) {
 
 void
 OptionCustom::addArrayDataField(const bool value) {
+    invalidatePrecompiled();
     checkArrayType();
 
     OptionBuffer buf;
@@ -436,6 +438,7 @@ OptionCustom::readAddress(const uint32_t index) const {
 void
 OptionCustom::writeAddress(const asiolink::IOAddress& address,
                            const uint32_t index) {
+    invalidatePrecompiled();
     using namespace isc::asiolink;
 
     checkIndex(index);
@@ -462,6 +465,7 @@ OptionCustom::readBinary(const uint32_t index) const {
 void
 OptionCustom::writeBinary(const OptionBuffer& buf,
                           const uint32_t index) {
+    invalidatePrecompiled();
     checkIndex(index);
     buffers_[index] = buf;
 }
@@ -474,6 +478,7 @@ OptionCustom::readBoolean(const uint32_t index) const {
 
 void
 OptionCustom::writeBoolean(const bool value, const uint32_t index) {
+    invalidatePrecompiled();
     checkIndex(index);
 
     buffers_[index].clear();
@@ -488,6 +493,7 @@ OptionCustom::readFqdn(const uint32_t index) const {
 
 void
 OptionCustom::writeFqdn(const std::string& fqdn, const uint32_t index) {
+    invalidatePrecompiled();
     checkIndex(index);
 
     // Create a temporay buffer where the FQDN will be written.
@@ -511,6 +517,7 @@ OptionCustom::readString(const uint32_t index) const {
 
 void
 OptionCustom::writeString(const std::string& text, const uint32_t index) {
+    invalidatePrecompiled();
     checkIndex(index);
 
     // Let's clear a buffer as we want to replace the value of the
@@ -527,6 +534,7 @@ OptionCustom::writeString(const std::string& text, const uint32_t index) {
 void
 OptionCustom::unpack(OptionBufferConstIter begin,
                      OptionBufferConstIter end) {
+    invalidatePrecompiled();
     initialize(begin, end);
 }
 
@@ -104,6 +104,7 @@ public:
     /// @tparam T integer type of the value being stored.
     template<typename T>
     void addArrayDataField(const T value) {
+        invalidatePrecompiled();
         checkArrayType();
         OptionDataType data_type = definition_.getType();
         if (OptionDataTypeTraits<T>::type != data_type) {
@@ -220,6 +221,7 @@ public:
     /// @throw isc::dhcp::InvalidDataType if T is invalid.
     template<typename T>
     void writeInteger(const T value, const uint32_t index = 0) {
+        invalidatePrecompiled();
         // Check that the index is not out of range.
         checkIndex(index);
         // Check that T points to a valid integer type and this type
@@ -126,6 +126,7 @@ public:
     /// equal to 1, 2 or 4 bytes. The data type is not checked in this function
     /// because it is checked in a constructor.
     virtual void unpack(OptionBufferConstIter begin, OptionBufferConstIter end) {
+        invalidatePrecompiled();
         if (distance(begin, end) < sizeof(T)) {
             isc_throw(OutOfRange, "Option " << getType() << " truncated");
         }
@@ -163,7 +164,7 @@ public:
     /// @brief Set option value.
     ///
     /// @param value new option value.
-    void setValue(T value) { value_ = value; }
+    void setValue(T value) { invalidatePrecompiled(); value_ = value; }
 
     /// @brief Return option value.
     ///
@@ -128,6 +128,7 @@ public:
     ///
     /// @param value a value being added.
     void addValue(const T value) {
+        invalidatePrecompiled();
         values_.push_back(value);
     }
 
@@ -180,6 +181,7 @@ public:
     /// equal to 1, 2 or 4 bytes. The data type is not checked in this function
     /// because it is checked in a constructor.
     virtual void unpack(OptionBufferConstIter begin, OptionBufferConstIter end) {
+        invalidatePrecompiled();
         if (distance(begin, end) == 0) {
             isc_throw(OutOfRange, "option " << getType() << " empty");
         }
@@ -230,7 +232,10 @@ public:
     /// @brief Set option values.
     ///
     /// @param values collection of values to be set for option.
-    void setValues(const std::vector<T>& values) { values_ = values; }
+    void setValues(const std::vector<T>& values) {
+        invalidatePrecompiled();
+        values_ = values;
+    }
 
     /// @brief returns complete length of option
     ///
@@ -42,6 +42,7 @@ OptionString::getValue() const {
 
 void
 OptionString::setValue(const std::string& value) {
+    invalidatePrecompiled();
     // Sanity check that the string value is at least one byte long.
     // This is a requirement for all currently defined options which
     // carry a string value.
@@ -74,6 +75,7 @@ OptionString::pack(isc::util::OutputBuffer& buf) {
 void
 OptionString::unpack(OptionBufferConstIter begin,
                      OptionBufferConstIter end) {
+    invalidatePrecompiled();
     if (std::distance(begin, end) == 0) {
         isc_throw(isc::OutOfRange, "failed to parse an option '"
                   << getType() << "' holding string value"
@@ -49,6 +49,7 @@ void OptionVendor::pack(isc::util::OutputBuffer& buf) {
 
 void OptionVendor::unpack(OptionBufferConstIter begin,
                           OptionBufferConstIter end) {
+    invalidatePrecompiled();
     if (distance(begin, end) < sizeof(uint32_t)) {
         isc_throw(OutOfRange, "Truncated vendor-specific information option"
                   << ", length=" << distance(begin, end));
@@ -78,7 +78,10 @@ public:
     /// @brief Sets enterprise identifier
     ///
     /// @param vendor_id vendor identifier
-    void setVendorId(const uint32_t vendor_id) { vendor_id_ = vendor_id; }
+    void setVendorId(const uint32_t vendor_id) {
+        invalidatePrecompiled();
+        vendor_id_ = vendor_id;
+    }
 
     /// @brief Returns enterprise identifier
     ///
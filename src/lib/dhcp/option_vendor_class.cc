@@ -57,6 +57,7 @@ OptionVendorClass::pack(isc::util::OutputBuffer& buf) {
 void
 OptionVendorClass::unpack(OptionBufferConstIter begin,
                           OptionBufferConstIter end) {
+    invalidatePrecompiled();
     if (std::distance(begin, end) < getMinimalLength() - getHeaderLen()) {
         isc_throw(OutOfRange, "parsed Vendor Class option data truncated to"
                   " size " << std::distance(begin, end));
@@ -95,6 +96,7 @@ OptionVendorClass::unpack(OptionBufferConstIter begin,
 
 void
 OptionVendorClass::addTuple(const OpaqueDataTuple& tuple) {
+    invalidatePrecompiled();
     if (tuple.getLengthFieldType() != getLengthFieldType()) {
         isc_throw(isc::BadValue, "attempted to add opaque data tuple having"
                   " invalid size of the length field "
@@ -107,6 +109,7 @@ OptionVendorClass::addTuple(const OpaqueDataTuple& tuple) {
 
 void
 OptionVendorClass::setTuple(const size_t at, const OpaqueDataTuple& tuple) {
+    invalidatePrecompiled();
     if (at >= getTuplesNum()) {
         isc_throw(isc::OutOfRange, "attempted to set an opaque data for the"
                   " vendor option at position " << at << " which is out of"
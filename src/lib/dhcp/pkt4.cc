@@ -49,7 +49,8 @@ Pkt4::Pkt4(uint8_t msg_type, uint32_t transid)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      use_precompiled_(false)
 {
     memset(sname_, 0, MAX_SNAME_LEN);
     memset(file_, 0, MAX_FILE_LEN);
@@ -74,7 +75,8 @@ Pkt4::Pkt4(const uint8_t* data, size_t len)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      use_precompiled_(false)
 {
     if (len < DHCPV4_PKT_HDR_LEN) {
         isc_throw(OutOfRange, "Truncated DHCPv4 packet (len=" << len
@@ -89,6 +91,69 @@ Pkt4::Pkt4(const uint8_t* data, size_t len)
     memcpy(&data_[0], data, len);
 }
 
+void
+Pkt4::reset(const uint8_t* data, size_t len) {
+    if (len < DHCPV4_PKT_HDR_LEN) {
+        isc_throw(OutOfRange, "Truncated DHCPv4 packet (len=" << len
+                  << ") received, at least " << DHCPV4_PKT_HDR_LEN
+                  << " is expected.");
+
+    } else if (data == NULL) {
+        isc_throw(InvalidParameter, "data buffer passed to Pkt4 is NULL");
+    }
+
+    clear();
+    data_.assign(data, data + len);
+}
+
+void
+Pkt4::reset(uint8_t msg_type, uint32_t transid) {
+    clear();
+    op_ = DHCPTypeToBootpType(msg_type);
+    transid_ = transid;
+    setType(msg_type);
+}
+
+void
+Pkt4::clear() {
+    // The buffers are cleared without releasing their memory.
+    buffer_out_.clear();
+    data_.clear();
+    options_.clear();
+    classes_.clear();
+
+    local_hwaddr_.reset();
+    remote_hwaddr_.reset();
+    local_addr_ = DEFAULT_ADDRESS;
+    remote_addr_ = DEFAULT_ADDRESS;
+    iface_.clear();
+    ifindex_ = 0;
+    local_port_ = DHCP4_SERVER_PORT;
+    remote_port_ = DHCP4_CLIENT_PORT;
+    op_ = BOOTREQUEST;
+    // The hardware address is reused unless it is shared, e.g. with
+    // a lease.
+    if (hwaddr_ && hwaddr_.unique()) {
+        hwaddr_->hwaddr_.clear();
+        hwaddr_->htype_ = HTYPE_ETHER;
+    } else {
+        hwaddr_.reset(new HWAddr());
+    }
+    hops_ = 0;
+    transid_ = 0;
+    secs_ = 0;
+    flags_ = 0;
+    ciaddr_ = DEFAULT_ADDRESS;
+    yiaddr_ = DEFAULT_ADDRESS;
+    siaddr_ = DEFAULT_ADDRESS;
+    giaddr_ = DEFAULT_ADDRESS;
+    memset(sname_, 0, MAX_SNAME_LEN);
+    memset(file_, 0, MAX_FILE_LEN);
+    use_precompiled_ = false;
+    timestamp_ = boost::posix_time::ptime();
+    callback_.clear();
+}
+
 size_t
 Pkt4::len() {
     size_t length = DHCPV4_PKT_HDR_LEN; // DHCPv4 header
@@ -152,7 +217,7 @@ Pkt4::pack() {
         // write DHCP magic cookie
         buffer_out_.writeUint32(DHCP_OPTIONS_COOKIE);
 
-        LibDHCP::packOptions(buffer_out_, options_);
+        LibDHCP::packOptions(buffer_out_, options_, use_precompiled_);
 
         // add END option that indicates end of options
         // (End option is very simple, just a 255 octet)
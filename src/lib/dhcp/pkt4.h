@@ -69,6 +69,35 @@ public:
     /// @param len size of buffer to be allocated for this packet.
     Pkt4(const uint8_t* data, size_t len);
 
+    /// @brief Reinitializes the packet to hold the received data.
+    ///
+    /// The packet becomes equivalent to the one created with the
+    /// constructor taking the same arguments, but the memory allocated for
+    /// its buffers is reused. It is used to recycle the packets (see
+    /// @c PktPool).
+    ///
+    /// @param data pointer to received data
+    /// @param len size of the received data
+    void reset(const uint8_t* data, size_t len);
+
+    /// @brief Reinitializes the packet to be sent.
+    ///
+    /// The packet becomes equivalent to the one created with the
+    /// constructor taking the same arguments, but the memory allocated for
+    /// its buffers is reused.
+    ///
+    /// @param msg_type type of message (e.g. DHCPDISOVER=1)
+    /// @param transid transaction-id
+    void reset(uint8_t msg_type, uint32_t transid);
+
+    /// @brief Releases the contents of the packet.
+    ///
+    /// The options, the classes and the hardware addresses are released and
+    /// the fields are set to their default values. The memory allocated for
+    /// the buffers is kept for reuse, and so is the client's hardware
+    /// address object unless it is shared, e.g. with a lease.
+    void clear();
+
     /// @brief Prepares on-wire format of DHCPv4 packet.
     ///
     /// Prepares on-wire format of message and all its options.
@@ -504,6 +533,24 @@ public:
     /// found.
     bool isRelayed() const;
 
+    /// @brief Enables or disables the use of the precompiled options.
+    ///
+    /// When enabled, @c pack copies the on-wire data stored by
+    /// @c Option::precompile for the precompiled options, rather than
+    /// packing them again. It must only be enabled if the options added
+    /// to the packet can't be modified after they have been precompiled,
+    /// e.g. by the hooks libraries.
+    ///
+    /// @param precompiled true if the precompiled options should be used
+    void setUsePrecompiled(const bool precompiled) {
+        use_precompiled_ = precompiled;
+    }
+
+    /// @brief Checks if the precompiled options are used.
+    bool getUsePrecompiled() const {
+        return (use_precompiled_);
+    }
+
     /// @brief Set callback function to be used to parse options.
     ///
     /// @param callback An instance of the callback function or NULL to
@@ -695,6 +742,9 @@ protected:
     /// data format change etc.
     isc::dhcp::OptionCollection options_;
 
+    /// @brief Indicates if the precompiled options are used by @c pack.
+    bool use_precompiled_;
+
     /// packet timestamp
     boost::posix_time::ptime timestamp_;
 
@@ -27,6 +27,8 @@ using namespace isc::asiolink;
 namespace isc {
 namespace dhcp {
 
+const IOAddress DEFAULT_ADDRESS6("::");
+
 Pkt6::RelayInfo::RelayInfo()
     :msg_type_(0), hop_count_(0), linkaddr_("::"), peeraddr_("::"), relay_msg_len_(0) {
     // interface_id_, subscriber_id_, remote_id_ initialized to NULL
@@ -43,7 +45,8 @@ Pkt6::Pkt6(const uint8_t* buf, uint32_t buf_len, DHCPv6Proto proto /* = UDP */)
     remote_addr_("::"),
     local_port_(0),
     remote_port_(0),
-    buffer_out_(0) {
+    buffer_out_(0),
+    use_precompiled_(false) {
     data_.resize(buf_len);
     memcpy(&data_[0], buf, buf_len);
 }
@@ -58,7 +61,47 @@ Pkt6::Pkt6(uint8_t msg_type, uint32_t transid, DHCPv6Proto proto /*= UDP*/) :
     remote_addr_("::"),
     local_port_(0),
     remote_port_(0),
-    buffer_out_(0) {
+    buffer_out_(0),
+    use_precompiled_(false) {
+}
+
+void
+Pkt6::reset(const uint8_t* buf, uint32_t buf_len, DHCPv6Proto proto) {
+    clear();
+    proto_ = proto;
+    transid_ = rand()%0xffffff;
+    data_.assign(buf, buf + buf_len);
+}
+
+void
+Pkt6::reset(uint8_t msg_type, uint32_t transid, DHCPv6Proto proto) {
+    clear();
+    proto_ = proto;
+    msg_type_ = msg_type;
+    transid_ = transid;
+}
+
+void
+Pkt6::clear() {
+    // The buffers are cleared without releasing their memory.
+    buffer_out_.clear();
+    data_.clear();
+    options_.clear();
+    relay_info_.clear();
+    classes_.clear();
+
+    proto_ = UDP;
+    msg_type_ = 0;
+    transid_ = 0;
+    iface_.clear();
+    ifindex_ = -1;
+    local_addr_ = DEFAULT_ADDRESS6;
+    remote_addr_ = DEFAULT_ADDRESS6;
+    local_port_ = 0;
+    remote_port_ = 0;
+    use_precompiled_ = false;
+    timestamp_ = boost::posix_time::ptime();
+    callback_.clear();
 }
 
 uint16_t Pkt6::len() {
@@ -253,7 +296,7 @@ Pkt6::packUDP() {
         buffer_out_.writeUint8( (transid_) & 0xff );
 
         // the rest are options
-        LibDHCP::packOptions(buffer_out_, options_);
+        LibDHCP::packOptions(buffer_out_, options_, use_precompiled_);
     }
     catch (const Exception& e) {
        // An exception is thrown and message will be written to Logger
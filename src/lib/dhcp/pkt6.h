@@ -111,6 +111,36 @@ public:
     /// @param proto protocol (usually UDP, but TCP will be supported eventually)
     Pkt6(const uint8_t* buf, uint32_t len, DHCPv6Proto proto = UDP);
 
+    /// @brief Reinitializes the packet to hold the received data.
+    ///
+    /// The packet becomes equivalent to the one created with the
+    /// constructor taking the same arguments, but the memory allocated for
+    /// its buffers is reused. It is used to recycle the packets (see
+    /// @c PktPool).
+    ///
+    /// @param buf pointer to a buffer of received packet content
+    /// @param len size of buffer of received packet content
+    /// @param proto protocol (usually UDP, but TCP will be supported eventually)
+    void reset(const uint8_t* buf, uint32_t len, DHCPv6Proto proto = UDP);
+
+    /// @brief Reinitializes the packet to be sent.
+    ///
+    /// The packet becomes equivalent to the one created with the
+    /// constructor taking the same arguments, but the memory allocated for
+    /// its buffers is reused.
+    ///
+    /// @param msg_type type of message (SOLICIT=1, ADVERTISE=2, ...)
+    /// @param transid transaction-id
+    /// @param proto protocol (TCP or UDP)
+    void reset(uint8_t msg_type, uint32_t transid, DHCPv6Proto proto = UDP);
+
+    /// @brief Releases the contents of the packet.
+    ///
+    /// The options, the relay information and the classes are released and
+    /// the fields are set to their default values. The memory allocated for
+    /// the buffers is kept for reuse.
+    void clear();
+
     /// @brief Prepares on-wire format.
     ///
     /// Prepares on-wire format of message and all its options.
@@ -391,6 +421,21 @@ public:
     ///         be freed by the caller.
     const char* getName() const;
 
+    /// @brief Enables or disables the use of the precompiled options.
+    ///
+    /// See @c Pkt4::setUsePrecompiled for details. The options carried
+    /// in the relay information are always packed.
+    ///
+    /// @param precompiled true if the precompiled options should be used
+    void setUsePrecompiled(const bool precompiled) {
+        use_precompiled_ = precompiled;
+    }
+
+    /// @brief Checks if the precompiled options are used.
+    bool getUsePrecompiled() const {
+        return (use_precompiled_);
+    }
+
     /// @brief Set callback function to be used to parse options.
     ///
     /// @param callback An instance of the callback function or NULL to
@@ -578,6 +623,9 @@ protected:
     /// A callback to be called to unpack options from the packet.
     UnpackOptionsCallback callback_;
 
+    /// @brief Indicates if the precompiled options are used by @c pack.
+    bool use_precompiled_;
+
 }; // Pkt6 class
 
 } // isc::dhcp namespace
@@ -22,6 +22,37 @@
 namespace isc {
 namespace dhcp {
 
+size_t
+PktFilter::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                        std::vector<Pkt4Ptr>& pkts, const size_t max_pkts) {
+    if (max_pkts == 0) {
+        return (0);
+    }
+    Pkt4Ptr pkt = receive(iface, socket_info);
+    if (!pkt) {
+        return (0);
+    }
+    pkts.push_back(pkt);
+    return (1);
+}
+
+size_t
+PktFilter::sendBatch(const Iface& iface, uint16_t sockfd,
+                     const std::vector<Pkt4Ptr>& pkts,
+                     std::vector<std::string>& errors) {
+    size_t sent = 0;
+    for (std::vector<Pkt4Ptr>::const_iterator pkt = pkts.begin();
+         pkt != pkts.end(); ++pkt) {
+        try {
+            send(iface, sockfd, *pkt);
+            ++sent;
+        } catch (const std::exception& ex) {
+            errors.push_back(ex.what());
+        }
+    }
+    return (sent);
+}
+
 int
 PktFilter::openFallbackSocket(const isc::asiolink::IOAddress& addr,
                               const uint16_t port) {
@@ -19,6 +19,9 @@
 #include <asiolink/io_address.h>
 #include <boost/shared_ptr.hpp>
 
+#include <string>
+#include <vector>
+
 namespace isc {
 namespace dhcp {
 
@@ -111,6 +114,50 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt4Ptr& pkt) = 0;
 
+    /// @brief Receive multiple packets over specified socket.
+    ///
+    /// This function is called when the data is available on the socket.
+    /// It receives the packet waiting on the socket and the packets queued
+    /// behind it, up to the specified number of packets, without blocking
+    /// for more packets to arrive. The received packets are appended to the
+    /// vector.
+    ///
+    /// The default implementation receives a single packet with @c receive.
+    /// The derived classes may override it to receive multiple packets with
+    /// a single system call.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param [out] pkts vector to which the received packets are appended
+    /// @param max_pkts maximum number of packets to receive
+    ///
+    /// @return number of packets appended to the vector
+    virtual size_t receiveBatch(const Iface& iface,
+                                const SocketInfo& socket_info,
+                                std::vector<Pkt4Ptr>& pkts,
+                                const size_t max_pkts);
+
+    /// @brief Send multiple packets over specified socket.
+    ///
+    /// The default implementation sends the packets one by one with
+    /// @c send. The derived classes may override it to send multiple
+    /// packets with a single system call.
+    ///
+    /// A packet which can't be sent doesn't prevent the other packets from
+    /// being sent: the reason of the failure is appended to the errors and
+    /// the packet is skipped.
+    ///
+    /// @param iface interface to be used to send packets
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    /// @param [out] errors vector to which the description of each failure
+    /// is appended
+    ///
+    /// @return number of packets sent
+    virtual size_t sendBatch(const Iface& iface, uint16_t sockfd,
+                             const std::vector<Pkt4Ptr>& pkts,
+                             std::vector<std::string>& errors);
+
 protected:
 
     /// @brief Default implementation to open a fallback socket.
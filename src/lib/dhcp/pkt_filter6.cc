@@ -39,6 +39,37 @@ PktFilter6::joinMulticast(int sock, const std::string& ifname,
     return (true);
 }
 
+size_t
+PktFilter6::receiveBatch(const SocketInfo& socket_info,
+                         std::vector<Pkt6Ptr>& pkts, const size_t max_pkts) {
+    if (max_pkts == 0) {
+        return (0);
+    }
+    Pkt6Ptr pkt = receive(socket_info);
+    if (!pkt) {
+        return (0);
+    }
+    pkts.push_back(pkt);
+    return (1);
+}
+
+size_t
+PktFilter6::sendBatch(const Iface& iface, uint16_t sockfd,
+                      const std::vector<Pkt6Ptr>& pkts,
+                      std::vector<std::string>& errors) {
+    size_t sent = 0;
+    for (std::vector<Pkt6Ptr>::const_iterator pkt = pkts.begin();
+         pkt != pkts.end(); ++pkt) {
+        try {
+            send(iface, sockfd, *pkt);
+            ++sent;
+        } catch (const std::exception& ex) {
+            errors.push_back(ex.what());
+        }
+    }
+    return (sent);
+}
+
 
 } // end of isc::dhcp namespace
 } // end of isc namespace
@@ -18,6 +18,9 @@
 #include <asiolink/io_address.h>
 #include <dhcp/pkt6.h>
 
+#include <string>
+#include <vector>
+
 namespace isc {
 namespace dhcp {
 
@@ -123,6 +126,50 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt6Ptr& pkt) = 0;
 
+    /// @brief Receives multiple DHCPv6 messages on the socket.
+    ///
+    /// This function is called when the data is available on the socket.
+    /// It receives the message waiting on the socket and the messages queued
+    /// behind it, up to the specified number of messages, without blocking
+    /// for more messages to arrive. The received messages are appended to the
+    /// vector.
+    ///
+    /// The default implementation receives a single message with
+    /// @c receive. The derived classes may override it to receive multiple
+    /// messages with a single system call.
+    ///
+    /// @param socket_info A structure holding socket information.
+    /// @param [out] pkts A vector to which the received messages are
+    /// appended.
+    /// @param max_pkts Maximum number of messages to receive.
+    ///
+    /// @return Number of messages appended to the vector.
+    virtual size_t receiveBatch(const SocketInfo& socket_info,
+                                std::vector<Pkt6Ptr>& pkts,
+                                const size_t max_pkts);
+
+    /// @brief Sends multiple DHCPv6 messages through a specified interface
+    /// and socket.
+    ///
+    /// The default implementation sends the messages one by one with
+    /// @c send. The derived classes may override it to send multiple
+    /// messages with a single system call.
+    ///
+    /// A message which can't be sent doesn't prevent the other messages
+    /// from being sent: the reason of the failure is appended to the errors
+    /// and the message is skipped.
+    ///
+    /// @param iface Interface to be used to send messages.
+    /// @param sockfd A socket descriptor
+    /// @param pkts Messages to be sent.
+    /// @param [out] errors Vector to which the description of each failure
+    /// is appended.
+    ///
+    /// @return Number of messages sent.
+    virtual size_t sendBatch(const Iface& iface, uint16_t sockfd,
+                             const std::vector<Pkt6Ptr>& pkts,
+                             std::vector<std::string>& errors);
+
     /// @brief Joins IPv6 multicast group on a socket.
     ///
     /// Socket must be created and bound to an address. Note that this
@@ -18,18 +18,228 @@
 #include <dhcp/pkt_filter_inet.h>
 #include <errno.h>
 #include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace isc::asiolink;
 
 namespace isc {
 namespace dhcp {
 
+namespace {
+
+/// @brief Initializes the message header for the reception of a packet.
+///
+/// @param [out] m message header
+/// @param [out] from_addr structure to hold the address of the sender
+/// @param [out] v structure describing the data buffer
+/// @param buf buffer of @c IfaceMgr::RCVBUFSIZE bytes for the packet data
+/// @param control_buf buffer for the control messages
+/// @param control_buf_len length of the control buffer
+void
+initReceiveHeader(struct msghdr& m, struct sockaddr_in& from_addr,
+                  struct iovec& v, uint8_t* buf, char* control_buf,
+                  const size_t control_buf_len) {
+    memset(control_buf, 0, control_buf_len);
+    memset(&from_addr, 0, sizeof(from_addr));
+    memset(&m, 0, sizeof(m));
+
+    // Point so we can get the from address.
+    m.msg_name = &from_addr;
+    m.msg_namelen = sizeof(from_addr);
+
+    v.iov_base = static_cast<void*>(buf);
+    v.iov_len = IfaceMgr::RCVBUFSIZE;
+    m.msg_iov = &v;
+    m.msg_iovlen = 1;
+
+    // Getting the interface is a bit more involved.
+    //
+    // We set up some space for a "control message". We have
+    // previously asked the kernel to give us packet
+    // information (when we initialized the interface), so we
+    // should get the destination address from that.
+    m.msg_control = control_buf;
+    m.msg_controllen = control_buf_len;
+}
+
+/// @brief Initializes the message header for the transmission of a packet.
+///
+/// @param [out] m message header
+/// @param [out] to structure to hold the destination address
+/// @param [out] v structure describing the packet data
+/// @param control_buf buffer for the control messages
+/// @param control_buf_len length of the control buffer
+/// @param pkt packet to be sent
+void
+initSendHeader(struct msghdr& m, struct sockaddr_in& to, struct iovec& v,
+               char* control_buf, const size_t control_buf_len,
+               const Pkt4Ptr& pkt) {
+    memset(control_buf, 0, control_buf_len);
+
+    // Set the target address we're sending to.
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(pkt->getRemotePort());
+    to.sin_addr.s_addr = htonl(pkt->getRemoteAddr());
+
+    // Initialize our message header structure.
+    memset(&m, 0, sizeof(m));
+    m.msg_name = &to;
+    m.msg_namelen = sizeof(to);
+
+    // Set the data buffer we're sending. (Using this wacky
+    // "scatter-gather" stuff... we only have a single chunk
+    // of data to send, so we declare a single vector entry.)
+    memset(&v, 0, sizeof(v));
+    // iov_base field is of void * type. We use it for packet
+    // transmission, so this buffer will not be modified.
+    v.iov_base = const_cast<void *>(pkt->getBuffer().getData());
+    v.iov_len = pkt->getBuffer().getLength();
+    m.msg_iov = &v;
+    m.msg_iovlen = 1;
+
+// In the future the OS-specific code may be abstracted to a different
+// file but for now we keep it here because there is no code yet, which
+// is specific to non-Linux systems.
+#if defined (IP_PKTINFO) && defined (OS_LINUX)
+    // Setting the interface is a bit more involved.
+    //
+    // We have to create a "control message", and set that to
+    // define the IPv4 packet information. We could set the
+    // source address if we wanted, but we can safely let the
+    // kernel decide what that should be.
+    m.msg_control = control_buf;
+    m.msg_controllen = control_buf_len;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+    struct in_pktinfo* pktinfo =(struct in_pktinfo *)CMSG_DATA(cmsg);
+    memset(pktinfo, 0, sizeof(struct in_pktinfo));
+    pktinfo->ipi_ifindex = pkt->getIndex();
+    m.msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
+#endif
+}
+
+/// @brief Creates the packet from the received message.
+///
+/// @param pool pool of the packets
+/// @param iface interface over which the message has been received
+/// @param socket_info structure holding socket information
+/// @param m message header, as filled by recvmsg() or recvmmsg()
+/// @param length length of the received data
+///
+/// @return received packet
+Pkt4Ptr
+createPacket(PktPool<Pkt4>& pool, const Iface& iface,
+             const SocketInfo& socket_info, struct msghdr& m,
+             const size_t length) {
+    Pkt4Ptr pkt = pool.create(static_cast<const uint8_t*>
+                              (m.msg_iov[0].iov_base), length);
+
+    pkt->updateTimestamp();
+
+    unsigned int ifindex = iface.getIndex();
+
+    const struct sockaddr_in* from_addr =
+        static_cast<const struct sockaddr_in*>(m.msg_name);
+    IOAddress from(htonl(from_addr->sin_addr.s_addr));
+    uint16_t from_port = htons(from_addr->sin_port);
+
+    // Set receiving interface based on information, which socket was used to
+    // receive data. OS-specific info (see os_receive4()) may be more reliable,
+    // so this value may be overwritten.
+    pkt->setIndex(ifindex);
+    pkt->setIface(iface.getName());
+    pkt->setRemoteAddr(from);
+    pkt->setRemotePort(from_port);
+    pkt->setLocalPort(socket_info.port_);
+
+// In the future the OS-specific code may be abstracted to a different
+// file but for now we keep it here because there is no code yet, which
+// is specific to non-Linux systems.
+#if defined (IP_PKTINFO) && defined (OS_LINUX)
+    struct cmsghdr* cmsg;
+    struct in_pktinfo* pktinfo;
+    struct in_addr to_addr;
+
+    memset(&to_addr, 0, sizeof(to_addr));
+
+    cmsg = CMSG_FIRSTHDR(&m);
+    while (cmsg != NULL) {
+        if ((cmsg->cmsg_level == IPPROTO_IP) &&
+            (cmsg->cmsg_type == IP_PKTINFO)) {
+            pktinfo = (struct in_pktinfo*)CMSG_DATA(cmsg);
+
+            pkt->setIndex(pktinfo->ipi_ifindex);
+            pkt->setLocalAddr(IOAddress(htonl(pktinfo->ipi_addr.s_addr)));
+            break;
+
+            // This field is useful, when we are bound to unicast
+            // address e.g. 192.0.2.1 and the packet was sent to
+            // broadcast. This will return broadcast address, not
+            // the address we are bound to.
+
+            // XXX: Perhaps we should uncomment this:
+            // to_addr = pktinfo->ipi_spec_dst;
+        }
+        cmsg = CMSG_NXTHDR(&m, cmsg);
+    }
+#endif
+
+    return (pkt);
+}
+
+} // end of anonymous namespace
+
+/// @brief Buffers used to receive a batch of packets.
+///
+/// They are sized for the largest batch received so far and reused by the
+/// subsequent calls, so as the reception doesn't allocate memory. The
+/// packets are received by one thread at a time.
+struct PktFilterInet::ReceiveBuffers {
+    /// @brief Makes sure that the buffers can hold the batch.
+    ///
+    /// @param max_pkts maximum number of packets in the batch
+    /// @param control_buf_len length of the control buffer of one packet
+    void reserve(const size_t max_pkts, const size_t control_buf_len) {
+        if (vs_.size() < max_pkts) {
+            bufs_.resize(max_pkts * IfaceMgr::RCVBUFSIZE);
+            control_bufs_.resize(max_pkts * control_buf_len);
+            from_addrs_.resize(max_pkts);
+            vs_.resize(max_pkts);
+#if defined (HAVE_RECVMMSG)
+            msgs_.resize(max_pkts);
+#endif
+        }
+    }
+
+    /// Data buffers.
+    std::vector<uint8_t> bufs_;
+    /// Control buffers.
+    std::vector<char> control_bufs_;
+    /// Addresses of the senders.
+    std::vector<struct sockaddr_in> from_addrs_;
+    /// Structures describing the data buffers.
+    std::vector<struct iovec> vs_;
+#if defined (HAVE_RECVMMSG)
+    /// Message headers.
+    std::vector<struct mmsghdr> msgs_;
+#endif
+};
+
 PktFilterInet::PktFilterInet()
     : control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
-      control_buf_(new char[control_buf_len_])
+      control_buf_(new char[control_buf_len_]),
+      receive_buffers_(new ReceiveBuffers())
 {
 }
 
+PktFilterInet::~PktFilterInet() {
+}
+
 SocketInfo
 PktFilterInet::openSocket(const Iface& iface,
                           const isc::asiolink::IOAddress& addr,
@@ -104,31 +314,11 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
     struct sockaddr_in from_addr;
     uint8_t buf[IfaceMgr::RCVBUFSIZE];
 
-    memset(&control_buf_[0], 0, control_buf_len_);
-    memset(&from_addr, 0, sizeof(from_addr));
-
     // Initialize our message header structure.
     struct msghdr m;
-    memset(&m, 0, sizeof(m));
-
-    // Point so we can get the from address.
-    m.msg_name = &from_addr;
-    m.msg_namelen = sizeof(from_addr);
-
     struct iovec v;
-    v.iov_base = static_cast<void*>(buf);
-    v.iov_len = IfaceMgr::RCVBUFSIZE;
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
-
-    // Getting the interface is a bit more involved.
-    //
-    // We set up some space for a "control message". We have
-    // previously asked the kernel to give us packet
-    // information (when we initialized the interface), so we
-    // should get the destination address from that.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
+    initReceiveHeader(m, from_addr, v, buf, &control_buf_[0],
+                      control_buf_len_);
 
     int result = recvmsg(socket_info.sockfd_, &m, 0);
     if (result < 0) {
@@ -136,110 +326,22 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
     }
 
     // We have all data let's create Pkt4 object.
-    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(buf, result));
-
-    pkt->updateTimestamp();
-
-    unsigned int ifindex = iface.getIndex();
-
-    IOAddress from(htonl(from_addr.sin_addr.s_addr));
-    uint16_t from_port = htons(from_addr.sin_port);
-
-    // Set receiving interface based on information, which socket was used to
-    // receive data. OS-specific info (see os_receive4()) may be more reliable,
-    // so this value may be overwritten.
-    pkt->setIndex(ifindex);
-    pkt->setIface(iface.getName());
-    pkt->setRemoteAddr(from);
-    pkt->setRemotePort(from_port);
-    pkt->setLocalPort(socket_info.port_);
-
-// In the future the OS-specific code may be abstracted to a different
-// file but for now we keep it here because there is no code yet, which
-// is specific to non-Linux systems.
-#if defined (IP_PKTINFO) && defined (OS_LINUX)
-    struct cmsghdr* cmsg;
-    struct in_pktinfo* pktinfo;
-    struct in_addr to_addr;
-
-    memset(&to_addr, 0, sizeof(to_addr));
-
-    cmsg = CMSG_FIRSTHDR(&m);
-    while (cmsg != NULL) {
-        if ((cmsg->cmsg_level == IPPROTO_IP) &&
-            (cmsg->cmsg_type == IP_PKTINFO)) {
-            pktinfo = (struct in_pktinfo*)CMSG_DATA(cmsg);
-
-            pkt->setIndex(pktinfo->ipi_ifindex);
-            pkt->setLocalAddr(IOAddress(htonl(pktinfo->ipi_addr.s_addr)));
-            break;
-
-            // This field is useful, when we are bound to unicast
-            // address e.g. 192.0.2.1 and the packet was sent to
-            // broadcast. This will return broadcast address, not
-            // the address we are bound to.
-
-            // XXX: Perhaps we should uncomment this:
-            // to_addr = pktinfo->ipi_spec_dst;
-        }
-        cmsg = CMSG_NXTHDR(&m, cmsg);
-    }
-#endif
-
-    return (pkt);
+    return (createPacket(packet_pool_, iface, socket_info, m, result));
 }
 
 int
 PktFilterInet::send(const Iface&, uint16_t sockfd,
                     const Pkt4Ptr& pkt) {
-    memset(&control_buf_[0], 0, control_buf_len_);
-
-    // Set the target address we're sending to.
-    sockaddr_in to;
-    memset(&to, 0, sizeof(to));
-    to.sin_family = AF_INET;
-    to.sin_port = htons(pkt->getRemotePort());
-    to.sin_addr.s_addr = htonl(pkt->getRemoteAddr());
-
+    struct sockaddr_in to;
     struct msghdr m;
-    // Initialize our message header structure.
-    memset(&m, 0, sizeof(m));
-    m.msg_name = &to;
-    m.msg_namelen = sizeof(to);
-
-    // Set the data buffer we're sending. (Using this wacky
-    // "scatter-gather" stuff... we only have a single chunk
-    // of data to send, so we declare a single vector entry.)
     struct iovec v;
-    memset(&v, 0, sizeof(v));
-    // iov_base field is of void * type. We use it for packet
-    // transmission, so this buffer will not be modified.
-    v.iov_base = const_cast<void *>(pkt->getBuffer().getData());
-    v.iov_len = pkt->getBuffer().getLength();
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
-
-// In the future the OS-specific code may be abstracted to a different
-// file but for now we keep it here because there is no code yet, which
-// is specific to non-Linux systems.
-#if defined (IP_PKTINFO) && defined (OS_LINUX)
-    // Setting the interface is a bit more involved.
-    //
-    // We have to create a "control message", and set that to
-    // define the IPv4 packet information. We could set the
-    // source address if we wanted, but we can safely let the
-    // kernel decide what that should be.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
-    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
-    cmsg->cmsg_level = IPPROTO_IP;
-    cmsg->cmsg_type = IP_PKTINFO;
-    cmsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
-    struct in_pktinfo* pktinfo =(struct in_pktinfo *)CMSG_DATA(cmsg);
-    memset(pktinfo, 0, sizeof(struct in_pktinfo));
-    pktinfo->ipi_ifindex = pkt->getIndex();
-    m.msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
-#endif
+    // The control buffer is held on the stack, so as several threads may
+    // send at the same time.
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    } control;
+    initSendHeader(m, to, v, control.buf, sizeof(control.buf), pkt);
 
     pkt->updateTimestamp();
 
@@ -252,6 +354,105 @@ PktFilterInet::send(const Iface&, uint16_t sockfd,
     return (result);
 }
 
+size_t
+PktFilterInet::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                            std::vector<Pkt4Ptr>& pkts,
+                            const size_t max_pkts) {
+#if defined (HAVE_RECVMMSG)
+    if (max_pkts == 0) {
+        return (0);
+    }
+
+    ReceiveBuffers& b = *receive_buffers_;
+    b.reserve(max_pkts, control_buf_len_);
+    std::vector<struct mmsghdr>& msgs = b.msgs_;
+    for (size_t i = 0; i < max_pkts; ++i) {
+        initReceiveHeader(msgs[i].msg_hdr, b.from_addrs_[i], b.vs_[i],
+                          &b.bufs_[i * IfaceMgr::RCVBUFSIZE],
+                          &b.control_bufs_[i * control_buf_len_],
+                          control_buf_len_);
+    }
+
+    // The IfaceMgr has checked that there is some data on the socket, so
+    // the call returns immediately with the packets already queued.
+    int result = recvmmsg(socket_info.sockfd_, &msgs[0], max_pkts,
+                          MSG_WAITFORONE, NULL);
+    if (result < 0) {
+        isc_throw(SocketReadError, "failed to receive UDP4 data");
+    }
+
+    // A malformed packet must not cause the loss of the other packets
+    // received in the same batch, so it is dropped.
+    size_t received = 0;
+    std::string error;
+    for (int i = 0; i < result; ++i) {
+        try {
+            pkts.push_back(createPacket(packet_pool_, iface, socket_info,
+                                        msgs[i].msg_hdr, msgs[i].msg_len));
+            ++received;
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    if ((received == 0) && !error.empty()) {
+        isc_throw(SocketReadError, "failed to create new packet: " << error);
+    }
+    return (received);
+#else
+    return (PktFilter::receiveBatch(iface, socket_info, pkts, max_pkts));
+#endif
+}
+
+size_t
+PktFilterInet::sendBatch(const Iface& iface, uint16_t sockfd,
+                         const std::vector<Pkt4Ptr>& pkts,
+                         std::vector<std::string>& errors) {
+#if defined (HAVE_SENDMMSG)
+    const size_t pkts_num = pkts.size();
+    if (pkts_num == 0) {
+        return (0);
+    }
+
+    std::vector<char> control_bufs(pkts_num * control_buf_len_);
+    std::vector<struct sockaddr_in> to_addrs(pkts_num);
+    std::vector<struct iovec> vs(pkts_num);
+    std::vector<struct mmsghdr> msgs(pkts_num);
+    for (size_t i = 0; i < pkts_num; ++i) {
+        initSendHeader(msgs[i].msg_hdr, to_addrs[i], vs[i],
+                       &control_bufs[i * control_buf_len_], control_buf_len_,
+                       pkts[i]);
+        pkts[i]->updateTimestamp();
+    }
+
+    // The sendmmsg() may send fewer messages than requested, e.g. when
+    // interrupted by a signal, so send the remaining ones in a loop. It
+    // stops at the first packet which can't be sent, e.g. because of an
+    // unreachable destination. That one is skipped, so as it doesn't cause
+    // the loss of the packets following it.
+    size_t next = 0;
+    size_t sent = 0;
+    while (next < pkts_num) {
+        int result = sendmmsg(sockfd, &msgs[next], pkts_num - next, 0);
+        if (result > 0) {
+            next += result;
+            sent += result;
+            continue;
+        }
+        if ((result < 0) && (errno == EINTR)) {
+            continue;
+        }
+        std::ostringstream error;
+        error << "pkt4 send failed: sendmmsg() returned with an error"
+            " sending the packet to " << pkts[next]->getRemoteAddr() << ": "
+              << (result < 0 ? strerror(errno) : "no message sent");
+        errors.push_back(error.str());
+        ++next;
+    }
+    return (sent);
+#else
+    return (PktFilter::sendBatch(iface, sockfd, pkts, errors));
+#endif
+}
 
 
 } // end of isc::dhcp namespace
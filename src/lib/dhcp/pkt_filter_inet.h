@@ -16,7 +16,9 @@
 #define PKT_FILTER_INET_H
 
 #include <dhcp/pkt_filter.h>
+#include <dhcp/pkt_pool.h>
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace isc {
 namespace dhcp {
@@ -30,9 +32,12 @@ public:
 
     /// @brief Constructor
     ///
-    /// Allocates control buffer.
+    /// Allocates control buffers.
     PktFilterInet();
 
+    /// @brief Destructor.
+    virtual ~PktFilterInet();
+
     /// @brief Check if packet can be sent to the host without address directly.
     ///
     /// This Packet Filter sends packets through AF_INET datagram sockets, so
@@ -85,11 +90,59 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt4Ptr& pkt);
 
+    /// @brief Receive multiple packets over specified socket.
+    ///
+    /// Where the system supports it, the packets are received with a
+    /// single recvmmsg() call. The packets which can't be parsed into
+    /// the @c Pkt4 objects (e.g. truncated ones) are dropped, unless none
+    /// of the received packets could be parsed.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param [out] pkts vector to which the received packets are appended
+    /// @param max_pkts maximum number of packets to receive
+    ///
+    /// @return number of packets appended to the vector
+    /// @throw isc::dhcp::SocketReadError if an error occurs during reception
+    /// of the packets or none of the received packets could be parsed.
+    virtual size_t receiveBatch(const Iface& iface,
+                                const SocketInfo& socket_info,
+                                std::vector<Pkt4Ptr>& pkts,
+                                const size_t max_pkts);
+
+    /// @brief Send multiple packets over specified socket.
+    ///
+    /// Where the system supports it, the packets are sent with the
+    /// sendmmsg() call. A packet which can't be sent is skipped and the
+    /// remaining ones are sent.
+    ///
+    /// @param iface interface to be used to send packets
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    /// @param [out] errors vector to which the description of each failure
+    /// is appended
+    ///
+    /// @return number of packets sent
+    virtual size_t sendBatch(const Iface& iface, uint16_t sockfd,
+                             const std::vector<Pkt4Ptr>& pkts,
+                             std::vector<std::string>& errors);
+
+    /// @brief Returns the pool of the packets handed out by this object.
+    const PktPool<Pkt4>& getPacketPool() const {
+        return (packet_pool_);
+    }
+
 private:
-    /// Length of the control_buf_ array.
+    /// Length of the reception control buffer.
     size_t control_buf_len_;
-    /// Control buffer, used in transmission and reception.
+    /// Control buffer, used in reception.
     boost::scoped_array<char> control_buf_;
+    /// Buffers used in the reception of a batch, defined in the .cc file.
+    struct ReceiveBuffers;
+    /// Buffers used in the reception of a batch.
+    boost::scoped_ptr<ReceiveBuffers> receive_buffers_;
+    /// Pool of the received packets, recycled once they are released.
+    PktPool<Pkt4> packet_pool_;
 };
 
 } // namespace isc::dhcp
@@ -19,14 +19,251 @@
 
 #include <netinet/in.h>
 
+#include <sstream>
+#include <string>
+#include <vector>
+
 using namespace isc::asiolink;
 
 namespace isc {
 namespace dhcp {
 
+namespace {
+
+/// @brief Initializes the message header for the reception of a message.
+///
+/// @param [out] m Message header.
+/// @param [out] from Structure to hold the address of the sender.
+/// @param [out] v Structure describing the data buffer.
+/// @param buf Buffer of @c IfaceMgr::RCVBUFSIZE bytes for the message data.
+/// @param control_buf Buffer for the control messages.
+/// @param control_buf_len Length of the control buffer.
+void
+initReceiveHeader(struct msghdr& m, struct sockaddr_in6& from,
+                  struct iovec& v, uint8_t* buf, char* control_buf,
+                  const size_t control_buf_len) {
+    memset(control_buf, 0, control_buf_len);
+    memset(&from, 0, sizeof(from));
+    memset(&m, 0, sizeof(m));
+
+    // Point so we can get the from address.
+    m.msg_name = &from;
+    m.msg_namelen = sizeof(from);
+
+    // Set the data buffer we're receiving. (Using this wacky
+    // "scatter-gather" stuff... but we that doesn't really make
+    // sense for us, so we use a single vector entry.)
+    memset(&v, 0, sizeof(v));
+    v.iov_base = static_cast<void*>(buf);
+    v.iov_len = IfaceMgr::RCVBUFSIZE;
+    m.msg_iov = &v;
+    m.msg_iovlen = 1;
+
+    // Getting the interface is a bit more involved.
+    //
+    // We set up some space for a "control message". We have
+    // previously asked the kernel to give us packet
+    // information (when we initialized the interface), so we
+    // should get the destination address from that.
+    m.msg_control = control_buf;
+    m.msg_controllen = control_buf_len;
+}
+
+/// @brief Initializes the message header for the transmission of a message.
+///
+/// @param [out] m Message header.
+/// @param [out] to Structure to hold the destination address.
+/// @param [out] v Structure describing the message data.
+/// @param control_buf Buffer for the control messages.
+/// @param control_buf_len Length of the control buffer.
+/// @param pkt A message to be sent.
+void
+initSendHeader(struct msghdr& m, struct sockaddr_in6& to, struct iovec& v,
+               char* control_buf, const size_t control_buf_len,
+               const Pkt6Ptr& pkt) {
+    memset(control_buf, 0, control_buf_len);
+
+    // Set the target address we're sending to.
+    memset(&to, 0, sizeof(to));
+    to.sin6_family = AF_INET6;
+    to.sin6_port = htons(pkt->getRemotePort());
+    memcpy(&to.sin6_addr,
+           &pkt->getRemoteAddr().toBytes()[0],
+           16);
+    to.sin6_scope_id = pkt->getIndex();
+
+    // Initialize our message header structure.
+    memset(&m, 0, sizeof(m));
+    m.msg_name = &to;
+    m.msg_namelen = sizeof(to);
+
+    // Set the data buffer we're sending. (Using this wacky
+    // "scatter-gather" stuff... we only have a single chunk
+    // of data to send, so we declare a single vector entry.)
+
+    // As v structure is a C-style is used for both sending and
+    // receiving data, it is shared between sending and receiving
+    // (sendmsg and recvmsg). It is also defined in system headers,
+    // so we have no control over its definition. To set iov_base
+    // (defined as void*) we must use const cast from void *.
+    // Otherwise C++ compiler would complain that we are trying
+    // to assign const void* to void*.
+    memset(&v, 0, sizeof(v));
+    v.iov_base = const_cast<void *>(pkt->getBuffer().getData());
+    v.iov_len = pkt->getBuffer().getLength();
+    m.msg_iov = &v;
+    m.msg_iovlen = 1;
+
+    // Setting the interface is a bit more involved.
+    //
+    // We have to create a "control message", and set that to
+    // define the IPv6 packet information. We could set the
+    // source address if we wanted, but we can safely let the
+    // kernel decide what that should be.
+    m.msg_control = control_buf;
+    m.msg_controllen = control_buf_len;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&m);
+
+    // FIXME: Code below assumes that cmsg is not NULL, but
+    // CMSG_FIRSTHDR() is coded to return NULL as a possibility.  The
+    // following assertion should never fail, but if it did and you came
+    // here, fix the code. :)
+    assert(cmsg != NULL);
+
+    cmsg->cmsg_level = IPPROTO_IPV6;
+    cmsg->cmsg_type = IPV6_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+    struct in6_pktinfo *pktinfo =
+        util::io::internal::convertPktInfo6(CMSG_DATA(cmsg));
+    memset(pktinfo, 0, sizeof(struct in6_pktinfo));
+    pktinfo->ipi6_ifindex = pkt->getIndex();
+    // According to RFC3542, section 20.2, the msg_controllen field
+    // may be set using CMSG_SPACE (which includes padding) or
+    // using CMSG_LEN. Both forms appear to work fine on Linux, FreeBSD,
+    // NetBSD, but OpenBSD appears to have a bug, discussed here:
+    // http://www.archivum.info/mailing.openbsd.bugs/2009-02/00017/
+    // kernel-6080-msg_controllen-of-IPV6_PKTINFO.html
+    // which causes sendmsg to return EINVAL if the CMSG_LEN is
+    // used to set the msg_controllen value.
+    m.msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
+}
+
+/// @brief Creates the DHCPv6 message from the received data.
+///
+/// @param pool Pool of the messages.
+/// @param m Message header, as filled by recvmsg() or recvmmsg().
+/// @param length Length of the received data.
+///
+/// @return A pointer to received message.
+/// @throw isc::dhcp::SocketReadError if the destination address of the
+/// message is unknown, the message can't be created or it has been
+/// received over unknown interface.
+Pkt6Ptr
+createPacket(PktPool<Pkt6>& pool, struct msghdr& m, const size_t length) {
+    struct in6_addr to_addr;
+    memset(&to_addr, 0, sizeof(to_addr));
+
+    int ifindex = -1;
+    struct in6_pktinfo* pktinfo = NULL;
+
+    // We need to loop through the control messages we received and
+    // find the one with our destination address.
+    //
+    // We also keep a flag to see if we found it. If we
+    // didn't, then we consider this to be an error.
+    bool found_pktinfo = false;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
+    while (cmsg != NULL) {
+        if ((cmsg->cmsg_level == IPPROTO_IPV6) &&
+            (cmsg->cmsg_type == IPV6_PKTINFO)) {
+            pktinfo = util::io::internal::convertPktInfo6(CMSG_DATA(cmsg));
+            to_addr = pktinfo->ipi6_addr;
+            ifindex = pktinfo->ipi6_ifindex;
+            found_pktinfo = true;
+            break;
+        }
+        cmsg = CMSG_NXTHDR(&m, cmsg);
+    }
+    if (!found_pktinfo) {
+        isc_throw(SocketReadError, "unable to find pktinfo");
+    }
+
+    // Let's create a packet.
+    Pkt6Ptr pkt;
+    try {
+        pkt = pool.create(static_cast<const uint8_t*>
+                          (m.msg_iov[0].iov_base), length);
+    } catch (const std::exception& ex) {
+        isc_throw(SocketReadError, "failed to create new packet");
+    }
+
+    pkt->updateTimestamp();
+
+    const struct sockaddr_in6* from =
+        static_cast<const struct sockaddr_in6*>(m.msg_name);
+    pkt->setLocalAddr(IOAddress::fromBytes(AF_INET6,
+                      reinterpret_cast<const uint8_t*>(&to_addr)));
+    pkt->setRemoteAddr(IOAddress::fromBytes(AF_INET6,
+                       reinterpret_cast<const uint8_t*>(&from->sin6_addr)));
+    pkt->setRemotePort(ntohs(from->sin6_port));
+    pkt->setIndex(ifindex);
+
+    Iface* received = IfaceMgr::instance().getIface(pkt->getIndex());
+    if (received) {
+        pkt->setIface(received->getName());
+    } else {
+        isc_throw(SocketReadError, "received packet over unknown interface"
+                  << "(ifindex=" << pkt->getIndex() << ")");
+    }
+
+    return (pkt);
+}
+
+} // end of anonymous namespace
+
+/// @brief Buffers used to receive a batch of messages.
+///
+/// They are sized for the largest batch received so far and reused by the
+/// subsequent calls, so as the reception doesn't allocate memory. The
+/// messages are received by one thread at a time.
+struct PktFilterInet6::ReceiveBuffers {
+    /// @brief Makes sure that the buffers can hold the batch.
+    ///
+    /// @param max_pkts maximum number of messages in the batch
+    /// @param control_buf_len length of the control buffer of one message
+    void reserve(const size_t max_pkts, const size_t control_buf_len) {
+        if (vs_.size() < max_pkts) {
+            bufs_.resize(max_pkts * IfaceMgr::RCVBUFSIZE);
+            control_bufs_.resize(max_pkts * control_buf_len);
+            from_addrs_.resize(max_pkts);
+            vs_.resize(max_pkts);
+#if defined (HAVE_RECVMMSG)
+            msgs_.resize(max_pkts);
+#endif
+        }
+    }
+
+    /// Data buffers.
+    std::vector<uint8_t> bufs_;
+    /// Control buffers.
+    std::vector<char> control_bufs_;
+    /// Addresses of the senders.
+    std::vector<struct sockaddr_in6> from_addrs_;
+    /// Structures describing the data buffers.
+    std::vector<struct iovec> vs_;
+#if defined (HAVE_RECVMMSG)
+    /// Message headers.
+    std::vector<struct mmsghdr> msgs_;
+#endif
+};
+
 PktFilterInet6::PktFilterInet6()
 : control_buf_len_(CMSG_SPACE(sizeof(struct in6_pktinfo))),
-    control_buf_(new char[control_buf_len_]) {
+    control_buf_(new char[control_buf_len_]),
+    receive_buffers_(new ReceiveBuffers()) {
+}
+
+PktFilterInet6::~PktFilterInet6() {
 }
 
 SocketInfo
@@ -102,173 +339,33 @@ Pkt6Ptr
 PktFilterInet6::receive(const SocketInfo& socket_info) {
     // Now we have a socket, let's get some data from it!
     uint8_t buf[IfaceMgr::RCVBUFSIZE];
-    memset(&control_buf_[0], 0, control_buf_len_);
     struct sockaddr_in6 from;
-    memset(&from, 0, sizeof(from));
 
     // Initialize our message header structure.
     struct msghdr m;
-    memset(&m, 0, sizeof(m));
-
-    // Point so we can get the from address.
-    m.msg_name = &from;
-    m.msg_namelen = sizeof(from);
-
-    // Set the data buffer we're receiving. (Using this wacky
-    // "scatter-gather" stuff... but we that doesn't really make
-    // sense for us, so we use a single vector entry.)
     struct iovec v;
-    memset(&v, 0, sizeof(v));
-    v.iov_base = static_cast<void*>(buf);
-    v.iov_len = IfaceMgr::RCVBUFSIZE;
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
-
-    // Getting the interface is a bit more involved.
-    //
-    // We set up some space for a "control message". We have
-    // previously asked the kernel to give us packet
-    // information (when we initialized the interface), so we
-    // should get the destination address from that.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
+    initReceiveHeader(m, from, v, buf, &control_buf_[0], control_buf_len_);
 
     int result = recvmsg(socket_info.sockfd_, &m, 0);
-
-    struct in6_addr to_addr;
-    memset(&to_addr, 0, sizeof(to_addr));
-
-    int ifindex = -1;
-    if (result >= 0) {
-        struct in6_pktinfo* pktinfo = NULL;
-
-
-        // If we did read successfully, then we need to loop
-        // through the control messages we received and
-        // find the one with our destination address.
-        //
-        // We also keep a flag to see if we found it. If we
-        // didn't, then we consider this to be an error.
-        bool found_pktinfo = false;
-        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
-        while (cmsg != NULL) {
-            if ((cmsg->cmsg_level == IPPROTO_IPV6) &&
-                (cmsg->cmsg_type == IPV6_PKTINFO)) {
-                pktinfo = util::io::internal::convertPktInfo6(CMSG_DATA(cmsg));
-                to_addr = pktinfo->ipi6_addr;
-                ifindex = pktinfo->ipi6_ifindex;
-                found_pktinfo = true;
-                break;
-            }
-            cmsg = CMSG_NXTHDR(&m, cmsg);
-        }
-        if (!found_pktinfo) {
-            isc_throw(SocketReadError, "unable to find pktinfo");
-        }
-    } else {
+    if (result < 0) {
         isc_throw(SocketReadError, "failed to receive data");
     }
 
-    // Let's create a packet.
-    Pkt6Ptr pkt;
-    try {
-        pkt = Pkt6Ptr(new Pkt6(buf, result));
-    } catch (const std::exception& ex) {
-        isc_throw(SocketReadError, "failed to create new packet");
-    }
-
-    pkt->updateTimestamp();
-
-    pkt->setLocalAddr(IOAddress::fromBytes(AF_INET6,
-                      reinterpret_cast<const uint8_t*>(&to_addr)));
-    pkt->setRemoteAddr(IOAddress::fromBytes(AF_INET6,
-                       reinterpret_cast<const uint8_t*>(&from.sin6_addr)));
-    pkt->setRemotePort(ntohs(from.sin6_port));
-    pkt->setIndex(ifindex);
-
-    Iface* received = IfaceMgr::instance().getIface(pkt->getIndex());
-    if (received) {
-        pkt->setIface(received->getName());
-    } else {
-        isc_throw(SocketReadError, "received packet over unknown interface"
-                  << "(ifindex=" << pkt->getIndex() << ")");
-    }
-
-    return (pkt);
-
+    return (createPacket(packet_pool_, m, result));
 }
 
 int
 PktFilterInet6::send(const Iface&, uint16_t sockfd, const Pkt6Ptr& pkt) {
-
-    memset(&control_buf_[0], 0, control_buf_len_);
-
-    // Set the target address we're sending to.
     sockaddr_in6 to;
-    memset(&to, 0, sizeof(to));
-    to.sin6_family = AF_INET6;
-    to.sin6_port = htons(pkt->getRemotePort());
-    memcpy(&to.sin6_addr,
-           &pkt->getRemoteAddr().toBytes()[0],
-           16);
-    to.sin6_scope_id = pkt->getIndex();
-
-    // Initialize our message header structure.
     struct msghdr m;
-    memset(&m, 0, sizeof(m));
-    m.msg_name = &to;
-    m.msg_namelen = sizeof(to);
-
-    // Set the data buffer we're sending. (Using this wacky
-    // "scatter-gather" stuff... we only have a single chunk
-    // of data to send, so we declare a single vector entry.)
-
-    // As v structure is a C-style is used for both sending and
-    // receiving data, it is shared between sending and receiving
-    // (sendmsg and recvmsg). It is also defined in system headers,
-    // so we have no control over its definition. To set iov_base
-    // (defined as void*) we must use const cast from void *.
-    // Otherwise C++ compiler would complain that we are trying
-    // to assign const void* to void*.
     struct iovec v;
-    memset(&v, 0, sizeof(v));
-    v.iov_base = const_cast<void *>(pkt->getBuffer().getData());
-    v.iov_len = pkt->getBuffer().getLength();
-    m.msg_iov = &v;
-    m.msg_iovlen = 1;
-
-    // Setting the interface is a bit more involved.
-    //
-    // We have to create a "control message", and set that to
-    // define the IPv6 packet information. We could set the
-    // source address if we wanted, but we can safely let the
-    // kernel decide what that should be.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
-    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&m);
-
-    // FIXME: Code below assumes that cmsg is not NULL, but
-    // CMSG_FIRSTHDR() is coded to return NULL as a possibility.  The
-    // following assertion should never fail, but if it did and you came
-    // here, fix the code. :)
-    assert(cmsg != NULL);
-
-    cmsg->cmsg_level = IPPROTO_IPV6;
-    cmsg->cmsg_type = IPV6_PKTINFO;
-    cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
-    struct in6_pktinfo *pktinfo =
-        util::io::internal::convertPktInfo6(CMSG_DATA(cmsg));
-    memset(pktinfo, 0, sizeof(struct in6_pktinfo));
-    pktinfo->ipi6_ifindex = pkt->getIndex();
-    // According to RFC3542, section 20.2, the msg_controllen field
-    // may be set using CMSG_SPACE (which includes padding) or
-    // using CMSG_LEN. Both forms appear to work fine on Linux, FreeBSD,
-    // NetBSD, but OpenBSD appears to have a bug, discussed here:
-    // http://www.archivum.info/mailing.openbsd.bugs/2009-02/00017/
-    // kernel-6080-msg_controllen-of-IPV6_PKTINFO.html
-    // which causes sendmsg to return EINVAL if the CMSG_LEN is
-    // used to set the msg_controllen value.
-    m.msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
+    // The control buffer is held on the stack, so as several threads may
+    // send at the same time.
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    } control;
+    initSendHeader(m, to, v, control.buf, sizeof(control.buf), pkt);
 
     pkt->updateTimestamp();
 
@@ -281,6 +378,105 @@ PktFilterInet6::send(const Iface&, uint16_t sockfd, const Pkt6Ptr& pkt) {
     return (result);
 }
 
+size_t
+PktFilterInet6::receiveBatch(const SocketInfo& socket_info,
+                             std::vector<Pkt6Ptr>& pkts,
+                             const size_t max_pkts) {
+#if defined (HAVE_RECVMMSG)
+    if (max_pkts == 0) {
+        return (0);
+    }
+
+    ReceiveBuffers& b = *receive_buffers_;
+    b.reserve(max_pkts, control_buf_len_);
+    std::vector<struct mmsghdr>& msgs = b.msgs_;
+    for (size_t i = 0; i < max_pkts; ++i) {
+        initReceiveHeader(msgs[i].msg_hdr, b.from_addrs_[i], b.vs_[i],
+                          &b.bufs_[i * IfaceMgr::RCVBUFSIZE],
+                          &b.control_bufs_[i * control_buf_len_],
+                          control_buf_len_);
+    }
+
+    // The IfaceMgr has checked that there is some data on the socket, so
+    // the call returns immediately with the messages already queued.
+    int result = recvmmsg(socket_info.sockfd_, &msgs[0], max_pkts,
+                          MSG_WAITFORONE, NULL);
+    if (result < 0) {
+        isc_throw(SocketReadError, "failed to receive data");
+    }
+
+    // A message which can't be used must not cause the loss of the other
+    // messages received in the same batch, so it is dropped.
+    size_t received = 0;
+    std::string error;
+    for (int i = 0; i < result; ++i) {
+        try {
+            pkts.push_back(createPacket(packet_pool_, msgs[i].msg_hdr,
+                                        msgs[i].msg_len));
+            ++received;
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    if ((received == 0) && !error.empty()) {
+        isc_throw(SocketReadError, error);
+    }
+    return (received);
+#else
+    return (PktFilter6::receiveBatch(socket_info, pkts, max_pkts));
+#endif
+}
+
+size_t
+PktFilterInet6::sendBatch(const Iface& iface, uint16_t sockfd,
+                          const std::vector<Pkt6Ptr>& pkts,
+                          std::vector<std::string>& errors) {
+#if defined (HAVE_SENDMMSG)
+    const size_t pkts_num = pkts.size();
+    if (pkts_num == 0) {
+        return (0);
+    }
+
+    std::vector<char> control_bufs(pkts_num * control_buf_len_);
+    std::vector<struct sockaddr_in6> to_addrs(pkts_num);
+    std::vector<struct iovec> vs(pkts_num);
+    std::vector<struct mmsghdr> msgs(pkts_num);
+    for (size_t i = 0; i < pkts_num; ++i) {
+        initSendHeader(msgs[i].msg_hdr, to_addrs[i], vs[i],
+                       &control_bufs[i * control_buf_len_], control_buf_len_,
+                       pkts[i]);
+        pkts[i]->updateTimestamp();
+    }
+
+    // The sendmmsg() may send fewer messages than requested, e.g. when
+    // interrupted by a signal, so send the remaining ones in a loop. It
+    // stops at the first message which can't be sent, e.g. because of an
+    // unreachable destination. That one is skipped, so as it doesn't cause
+    // the loss of the messages following it.
+    size_t next = 0;
+    size_t sent = 0;
+    while (next < pkts_num) {
+        int result = sendmmsg(sockfd, &msgs[next], pkts_num - next, 0);
+        if (result > 0) {
+            next += result;
+            sent += result;
+            continue;
+        }
+        if ((result < 0) && (errno == EINTR)) {
+            continue;
+        }
+        std::ostringstream error;
+        error << "pkt6 send failed: sendmmsg() returned with an error"
+            " sending the message to " << pkts[next]->getRemoteAddr() << ": "
+              << (result < 0 ? strerror(errno) : "no message sent");
+        errors.push_back(error.str());
+        ++next;
+    }
+    return (sent);
+#else
+    return (PktFilter6::sendBatch(iface, sockfd, pkts, errors));
+#endif
+}
 
 }
 }
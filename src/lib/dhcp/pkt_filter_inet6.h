@@ -16,7 +16,9 @@
 #define PKT_FILTER_INET6_H
 
 #include <dhcp/pkt_filter6.h>
+#include <dhcp/pkt_pool.h>
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace isc {
 namespace dhcp {
@@ -31,9 +33,13 @@ public:
 
     /// @brief Constructor.
     ///
-    /// Initializes a control buffer used in the message transmission.
+    /// Initializes the control buffers used in the message transmission
+    /// and reception.
     PktFilterInet6();
 
+    /// @brief Destructor.
+    virtual ~PktFilterInet6();
+
     /// @brief Opens a socket.
     ///
     /// This function open an IPv6 socket on an interface and binds it to a
@@ -85,11 +91,59 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt6Ptr& pkt);
 
+    /// @brief Receives multiple DHCPv6 messages on the socket.
+    ///
+    /// Where the system supports it, the messages are received with a
+    /// single recvmmsg() call. The messages which can't be turned into
+    /// the @c Pkt6 objects (e.g. received over unknown interface) are
+    /// dropped, unless none of the received messages could be used.
+    ///
+    /// @param socket_info A structure holding socket information.
+    /// @param [out] pkts A vector to which the received messages are
+    /// appended.
+    /// @param max_pkts Maximum number of messages to receive.
+    ///
+    /// @return Number of messages appended to the vector.
+    /// @throw isc::dhcp::SocketReadError if error occurred during packet
+    /// reception or none of the received messages could be used.
+    virtual size_t receiveBatch(const SocketInfo& socket_info,
+                                std::vector<Pkt6Ptr>& pkts,
+                                const size_t max_pkts);
+
+    /// @brief Sends multiple DHCPv6 messages through a specified interface
+    /// and socket.
+    ///
+    /// Where the system supports it, the messages are sent with the
+    /// sendmmsg() call. A message which can't be sent is skipped and the
+    /// remaining ones are sent.
+    ///
+    /// @param iface Interface to be used to send messages.
+    /// @param sockfd A socket descriptor
+    /// @param pkts Messages to be sent.
+    /// @param [out] errors Vector to which the description of each failure
+    /// is appended.
+    ///
+    /// @return Number of messages sent.
+    virtual size_t sendBatch(const Iface& iface, uint16_t sockfd,
+                             const std::vector<Pkt6Ptr>& pkts,
+                             std::vector<std::string>& errors);
+
+    /// @brief Returns the pool of the messages handed out by this object.
+    const PktPool<Pkt6>& getPacketPool() const {
+        return (packet_pool_);
+    }
+
 private:
-    /// Length of the control_buf_ array.
+    /// Length of the reception control buffer.
     size_t control_buf_len_;
-    /// Control buffer, used in transmission and reception.
+    /// Control buffer, used in reception.
     boost::scoped_array<char> control_buf_;
+    /// Buffers used in the reception of a batch, defined in the .cc file.
+    struct ReceiveBuffers;
+    /// Buffers used in the reception of a batch.
+    boost::scoped_ptr<ReceiveBuffers> receive_buffers_;
+    /// Pool of the received messages, recycled once they are released.
+    PktPool<Pkt6> packet_pool_;
 };
 
 } // namespace isc::dhcp
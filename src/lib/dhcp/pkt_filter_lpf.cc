@@ -24,6 +24,11 @@
 #include <linux/if_packet.h>
 #include <net/ethernet.h>
 
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
 namespace {
 
 using namespace isc::dhcp;
@@ -209,7 +214,7 @@ PktFilterLPF::receive(const Iface& iface, const SocketInfo& socket_info) {
     // the reminder of the input buffer and set the IP addresses and
     // ports from the dummy packet. We should consider doing it
     // in some more elegant way.
-    Pkt4Ptr dummy_pkt = Pkt4Ptr(new Pkt4(DHCPDISCOVER, 0));
+    Pkt4Ptr dummy_pkt = packet_pool_.create(DHCPDISCOVER, 0);
 
     // Decode ethernet, ip and udp headers.
     decodeEthernetHeader(buf, dummy_pkt);
@@ -220,7 +225,7 @@ PktFilterLPF::receive(const Iface& iface, const SocketInfo& socket_info) {
     buf.readVector(dhcp_buf, buf.getLength() - buf.getPosition());
 
     // Decode DHCP data into the Pkt4 object.
-    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(&dhcp_buf[0], dhcp_buf.size()));
+    Pkt4Ptr pkt = packet_pool_.create(&dhcp_buf[0], dhcp_buf.size());
 
     // Set the appropriate packet members using data collected from
     // the decoded headers.
@@ -236,11 +241,15 @@ PktFilterLPF::receive(const Iface& iface, const SocketInfo& socket_info) {
     return (pkt);
 }
 
-int
-PktFilterLPF::send(const Iface& iface, uint16_t sockfd, const Pkt4Ptr& pkt) {
-
-    OutputBuffer buf(14);
+namespace {
 
+/// @brief Writes the Ethernet frame carrying the packet.
+///
+/// @param iface interface over which the packet is sent
+/// @param pkt packet to be sent
+/// @param [out] buf buffer to which the frame is written
+void
+writeFrame(const Iface& iface, const Pkt4Ptr& pkt, OutputBuffer& buf) {
     // Some interfaces may have no HW address - e.g. loopback interface.
     // For these interfaces the HW address length is 0. If this is the case,
     // then we will rely on the functions which construct the IP/UDP headers
@@ -263,6 +272,15 @@ PktFilterLPF::send(const Iface& iface, uint16_t sockfd, const Pkt4Ptr& pkt) {
 
     // DHCPv4 message
     buf.writeData(pkt->getBuffer().getData(), pkt->getBuffer().getLength());
+}
+
+} // end of anonymous namespace
+
+int
+PktFilterLPF::send(const Iface& iface, uint16_t sockfd, const Pkt4Ptr& pkt) {
+
+    OutputBuffer buf(14);
+    writeFrame(iface, pkt, buf);
 
     sockaddr_ll sa;
     sa.sll_family = AF_PACKET;
@@ -282,6 +300,66 @@ PktFilterLPF::send(const Iface& iface, uint16_t sockfd, const Pkt4Ptr& pkt) {
 
 }
 
+size_t
+PktFilterLPF::sendBatch(const Iface& iface, uint16_t sockfd,
+                        const std::vector<Pkt4Ptr>& pkts,
+                        std::vector<std::string>& errors) {
+#if defined (HAVE_SENDMMSG)
+    const size_t pkts_num = pkts.size();
+    if (pkts_num == 0) {
+        return (0);
+    }
+
+    sockaddr_ll sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sll_family = AF_PACKET;
+    sa.sll_ifindex = iface.getIndex();
+    sa.sll_protocol = htons(ETH_P_IP);
+    sa.sll_halen = 6;
+
+    // Each packet is sent in its own frame, which holds the Ethernet, IP
+    // and UDP headers followed by the DHCPv4 message.
+    std::vector<OutputBuffer> frames(pkts_num, OutputBuffer(14));
+    std::vector<struct iovec> vs(pkts_num);
+    std::vector<struct mmsghdr> msgs(pkts_num);
+    for (size_t i = 0; i < pkts_num; ++i) {
+        writeFrame(iface, pkts[i], frames[i]);
+        vs[i].iov_base = const_cast<void*>(frames[i].getData());
+        vs[i].iov_len = frames[i].getLength();
+        msgs[i].msg_hdr.msg_name = &sa;
+        msgs[i].msg_hdr.msg_namelen = sizeof(sa);
+        msgs[i].msg_hdr.msg_iov = &vs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // The sendmmsg() may send fewer messages than requested, e.g. when
+    // interrupted by a signal, so send the remaining ones in a loop. It
+    // stops at the first frame which can't be sent. That one is skipped, so
+    // as it doesn't cause the loss of the frames following it.
+    size_t next = 0;
+    size_t sent = 0;
+    while (next < pkts_num) {
+        int result = sendmmsg(sockfd, &msgs[next], pkts_num - next, 0);
+        if (result > 0) {
+            next += result;
+            sent += result;
+            continue;
+        }
+        if ((result < 0) && (errno == EINTR)) {
+            continue;
+        }
+        std::ostringstream error;
+        error << "failed to send DHCPv4 packet to "
+              << pkts[next]->getRemoteAddr() << ", errno="
+              << (result < 0 ? errno : 0) << " (check errno.h)";
+        errors.push_back(error.str());
+        ++next;
+    }
+    return (sent);
+#else
+    return (PktFilter::sendBatch(iface, sockfd, pkts, errors));
+#endif
+}
 
 } // end of isc::dhcp namespace
 } // end of isc namespace
@@ -16,6 +16,7 @@
 #define PKT_FILTER_LPF_H
 
 #include <dhcp/pkt_filter.h>
+#include <dhcp/pkt_pool.h>
 
 #include <util/buffer.h>
 
@@ -28,6 +29,11 @@ namespace dhcp {
 /// sockets and Linux Packet Filtering. It is used by @c isc::dhcp::IfaceMgr
 /// to send DHCPv4 messages to the hosts which don't have an IPv4 address
 /// assigned yet.
+///
+/// Where the system supports it, the batches of packets are sent with the
+/// sendmmsg() call. The packets are received one by one, by the default
+/// @c PktFilter::receiveBatch: the reception reads the raw socket and
+/// drains the fallback socket, so it gains little from the batching.
 class PktFilterLPF : public PktFilter {
 public:
 
@@ -75,6 +81,26 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt4Ptr& pkt);
 
+    /// @brief Send multiple packets over specified socket.
+    ///
+    /// Where the system supports it, the frames carrying the packets are
+    /// sent with the sendmmsg() call. A packet which can't be sent is
+    /// skipped and the remaining ones are sent.
+    ///
+    /// @param iface interface to be used to send packets
+    /// @param sockfd socket descriptor
+    /// @param pkts packets to be sent
+    /// @param [out] errors vector to which the description of each failure
+    /// is appended
+    ///
+    /// @return number of packets sent
+    virtual size_t sendBatch(const Iface& iface, uint16_t sockfd,
+                             const std::vector<Pkt4Ptr>& pkts,
+                             std::vector<std::string>& errors);
+
+private:
+    /// Pool of the received packets, recycled once they are released.
+    PktPool<Pkt4> packet_pool_;
 };
 
 } // namespace isc::dhcp
@@ -0,0 +1,230 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef PKT_POOL_H
+#define PKT_POOL_H
+
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Pool of the recycled packets.
+///
+/// Each received packet and each response used to be allocated anew and
+/// freed once processed, together with the buffers holding its data. The
+/// pool keeps the packets which are no longer used and hands them out
+/// again, so as the memory allocated for the packet and its buffers is
+/// reused.
+///
+/// The packets handed out by the pool are regular shared pointers. When
+/// the last reference to the packet is dropped (typically once it has
+/// been sent), the packet is cleared (see @c Pkt4::clear) and returned to
+/// the pool rather than destroyed. The options of the packet are released
+/// at this point, and their memory goes back to the @c OptionArena of the
+/// releasing thread. The packets which don't fit in the pool, or which are
+/// returned after the pool has been destroyed, are destroyed.
+///
+/// The pool may be used concurrently by multiple threads, e.g. the packets
+/// may be returned by the thread sending the responses while another
+/// thread receives the packets.
+///
+/// @tparam PktType type of the packet, @c Pkt4 or @c Pkt6. It must provide
+/// the constructors and the @c reset methods with the same arguments as
+/// the @c create methods of the pool, and the @c clear method.
+template<typename PktType>
+class PktPool : public boost::noncopyable {
+public:
+
+    /// @brief Pointer to the packet.
+    typedef boost::shared_ptr<PktType> PktTypePtr;
+
+    /// @brief Constructor.
+    ///
+    /// @param max_size maximum number of the unused packets kept by the
+    ///        pool.
+    PktPool(const size_t max_size = 256)
+        : storage_(new Storage(max_size)) {
+    }
+
+    /// @brief Destructor.
+    ///
+    /// Destroys the unused packets. The packets still in use are destroyed
+    /// when they are released.
+    ~PktPool() {
+        util::thread::Mutex::Locker locker(storage_->mutex_);
+        storage_->closed_ = true;
+        for (typename std::vector<PktType*>::iterator pkt =
+                 storage_->free_.begin(); pkt != storage_->free_.end(); ++pkt) {
+            delete *pkt;
+        }
+        storage_->free_.clear();
+    }
+
+    /// @brief Returns the packet holding the received data.
+    ///
+    /// @param data pointer to the received data
+    /// @param len length of the received data
+    ///
+    /// @return packet, as if constructed with @c PktType(data, len)
+    /// @throw an exception thrown by the packet's constructor or @c reset
+    /// method if the data are invalid.
+    PktTypePtr create(const uint8_t* data, const size_t len) {
+        PktType* pkt = pop();
+        if (pkt == NULL) {
+            return (wrap(new PktType(data, len)));
+        }
+        PktTypePtr pkt_ptr = wrap(pkt);
+        pkt->reset(data, len);
+        return (pkt_ptr);
+    }
+
+    /// @brief Returns the packet to be sent.
+    ///
+    /// @param msg_type type of the message
+    /// @param transid transaction-id
+    ///
+    /// @return packet, as if constructed with @c PktType(msg_type, transid)
+    PktTypePtr create(const uint8_t msg_type, const uint32_t transid) {
+        PktType* pkt = pop();
+        if (pkt == NULL) {
+            return (wrap(new PktType(msg_type, transid)));
+        }
+        PktTypePtr pkt_ptr = wrap(pkt);
+        pkt->reset(msg_type, transid);
+        return (pkt_ptr);
+    }
+
+    /// @brief Returns the number of the packets allocated by the pool.
+    size_t getAllocated() const {
+        util::thread::Mutex::Locker locker(storage_->mutex_);
+        return (storage_->allocated_);
+    }
+
+    /// @brief Returns the number of times a packet has been reused.
+    size_t getReused() const {
+        util::thread::Mutex::Locker locker(storage_->mutex_);
+        return (storage_->reused_);
+    }
+
+    /// @brief Returns the number of the unused packets in the pool.
+    size_t getFree() const {
+        util::thread::Mutex::Locker locker(storage_->mutex_);
+        return (storage_->free_.size());
+    }
+
+private:
+
+    /// @brief State of the pool shared with the packets in use.
+    ///
+    /// The packets hold a weak pointer to it, so as they are destroyed
+    /// rather than returned if the pool no longer exists.
+    struct Storage {
+        /// @brief Constructor.
+        ///
+        /// @param max_size maximum number of the unused packets.
+        Storage(const size_t max_size)
+            : max_size_(max_size), allocated_(0), reused_(0), closed_(false) {
+        }
+
+        /// @brief Protects the members of the structure.
+        util::thread::Mutex mutex_;
+
+        /// @brief Unused packets.
+        std::vector<PktType*> free_;
+
+        /// @brief Maximum number of the unused packets.
+        const size_t max_size_;
+
+        /// @brief Number of the packets allocated by the pool.
+        size_t allocated_;
+
+        /// @brief Number of times a packet has been reused.
+        size_t reused_;
+
+        /// @brief Indicates that the pool is being destroyed.
+        bool closed_;
+    };
+
+    /// @brief Deleter returning the packet to the pool.
+    class Recycler {
+    public:
+        /// @brief Constructor.
+        ///
+        /// @param storage state of the pool.
+        Recycler(const boost::shared_ptr<Storage>& storage)
+            : storage_(storage) {
+        }
+
+        /// @brief Clears the packet and returns it to the pool.
+        ///
+        /// @param pkt packet no longer in use
+        void operator()(PktType* pkt) const {
+            boost::shared_ptr<Storage> storage = storage_.lock();
+            if (storage) {
+                // The packet is cleared outside of the critical section.
+                // This releases its options.
+                pkt->clear();
+                util::thread::Mutex::Locker locker(storage->mutex_);
+                if (!storage->closed_ &&
+                    (storage->free_.size() < storage->max_size_)) {
+                    storage->free_.push_back(pkt);
+                    return;
+                }
+            }
+            delete pkt;
+        }
+
+    private:
+        /// @brief State of the pool.
+        boost::weak_ptr<Storage> storage_;
+    };
+
+    /// @brief Takes the unused packet from the pool.
+    ///
+    /// @return unused packet or NULL if there is none. In the latter case
+    /// the caller is expected to allocate the packet.
+    PktType* pop() {
+        util::thread::Mutex::Locker locker(storage_->mutex_);
+        if (storage_->free_.empty()) {
+            ++storage_->allocated_;
+            return (NULL);
+        }
+        PktType* pkt = storage_->free_.back();
+        storage_->free_.pop_back();
+        ++storage_->reused_;
+        return (pkt);
+    }
+
+    /// @brief Wraps the packet in the pointer returning it to the pool.
+    ///
+    /// @param pkt packet
+    PktTypePtr wrap(PktType* pkt) const {
+        return (PktTypePtr(pkt, Recycler(storage_)));
+    }
+
+    /// @brief State of the pool.
+    boost::shared_ptr<Storage> storage_;
+};
+
+} // namespace isc::dhcp
+} // namespace isc
+
+#endif // PKT_POOL_H
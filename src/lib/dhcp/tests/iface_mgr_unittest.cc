@@ -29,6 +29,7 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -1160,6 +1161,168 @@ TEST_F(IfaceMgrTest, sendReceive4) {
     EXPECT_THROW(ifacemgr->send(sendPkt), SocketWriteError);
 }
 
+// Verifies that multiple IPv6 packets are sent and received at once.
+TEST_F(IfaceMgrTest, sendReceiveBatch6) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    IOAddress loAddr("::1");
+    int socket1 = 0;
+    EXPECT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr, 10547);
+    );
+    EXPECT_GE(socket1, 0);
+
+    // Prepare three packets with different payloads.
+    std::vector<Pkt6Ptr> pkts;
+    for (int i = 0; i < 3; ++i) {
+        uint8_t data[128];
+        memset(data, i, sizeof(data));
+        Pkt6Ptr pkt(new Pkt6(data, sizeof(data)));
+        pkt->repack();
+        pkt->setRemotePort(10547);
+        pkt->setRemoteAddr(IOAddress("::1"));
+        pkt->setIndex(1);
+        pkt->setIface(LOOPBACK);
+        pkts.push_back(pkt);
+    }
+
+    size_t sent = 0;
+    std::vector<std::string> errors;
+    ASSERT_NO_THROW(sent = ifacemgr->sendBatch(pkts, errors));
+    EXPECT_EQ(3, sent);
+    EXPECT_TRUE(errors.empty());
+
+    std::vector<Pkt6Ptr> rcvd_pkts;
+    while (rcvd_pkts.size() < 3) {
+        size_t received = 0;
+        ASSERT_NO_THROW(received = ifacemgr->receiveBatch6(rcvd_pkts, 8, 10));
+        ASSERT_GT(received, 0);
+    }
+    ASSERT_EQ(3, rcvd_pkts.size());
+
+    // The packets must have been received in the order they were sent.
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(pkts[i]->data_.size(), rcvd_pkts[i]->data_.size());
+        EXPECT_EQ(0, memcmp(&pkts[i]->data_[0], &rcvd_pkts[i]->data_[0],
+                            rcvd_pkts[i]->data_.size()));
+    }
+}
+
+// Verifies that multiple IPv4 packets are sent and received at once and
+// that the packets are received over the socket which replaced the socket
+// used previously.
+TEST_F(IfaceMgrTest, sendReceiveBatch4) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    IOAddress loAddr("127.0.0.1");
+    int socket1 = 0;
+    EXPECT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr,
+                                       DHCP4_SERVER_PORT + 10000);
+    );
+    EXPECT_GE(socket1, 0);
+
+    // Prepare three packets with different transaction ids.
+    std::vector<Pkt4Ptr> pkts;
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        Pkt4Ptr pkt(new Pkt4(DHCPDISCOVER, transid));
+        pkt->setLocalAddr(IOAddress("127.0.0.1"));
+        pkt->setLocalPort(DHCP4_SERVER_PORT + 10000 + 1);
+        pkt->setRemotePort(DHCP4_SERVER_PORT + 10000);
+        pkt->setRemoteAddr(IOAddress("127.0.0.1"));
+        pkt->setIndex(1);
+        pkt->setIface(string(LOOPBACK));
+        ASSERT_NO_THROW(pkt->pack());
+        pkts.push_back(pkt);
+    }
+
+    size_t sent = 0;
+    std::vector<std::string> errors;
+    ASSERT_NO_THROW(sent = ifacemgr->sendBatch(pkts, errors));
+    EXPECT_EQ(3, sent);
+    EXPECT_TRUE(errors.empty());
+
+    std::vector<Pkt4Ptr> rcvd_pkts;
+    while (rcvd_pkts.size() < 3) {
+        size_t received = 0;
+        ASSERT_NO_THROW(received = ifacemgr->receiveBatch4(rcvd_pkts, 8, 10));
+        ASSERT_GT(received, 0);
+    }
+    ASSERT_EQ(3, rcvd_pkts.size());
+
+    // The packets must have been received in the order they were sent.
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_NO_THROW(rcvd_pkts[i]->unpack());
+        EXPECT_EQ(pkts[i]->getTransid(), rcvd_pkts[i]->getTransid());
+    }
+
+    // Replace the socket with the one bound to another port. The IfaceMgr
+    // must now wait for the data on the new socket.
+    ifacemgr->closeSockets();
+    EXPECT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr,
+                                       DHCP4_SERVER_PORT + 10002);
+    );
+    EXPECT_GE(socket1, 0);
+
+    pkts[0]->setRemotePort(DHCP4_SERVER_PORT + 10002);
+    EXPECT_NO_THROW(ifacemgr->send(pkts[0]));
+
+    Pkt4Ptr rcvd_pkt;
+    ASSERT_NO_THROW(rcvd_pkt = ifacemgr->receive4(10));
+    ASSERT_TRUE(rcvd_pkt);
+    ASSERT_NO_THROW(rcvd_pkt->unpack());
+    EXPECT_EQ(pkts[0]->getTransid(), rcvd_pkt->getTransid());
+}
+
+// Verifies that the packet which can't be sent doesn't cause the loss of
+// the other packets in the batch.
+TEST_F(IfaceMgrTest, sendBatch4InvalidIface) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    IOAddress loAddr("127.0.0.1");
+    int socket1 = 0;
+    EXPECT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr,
+                                       DHCP4_SERVER_PORT + 10000);
+    );
+    EXPECT_GE(socket1, 0);
+
+    // The second packet is to be sent over the non-existing interface.
+    std::vector<Pkt4Ptr> pkts;
+    for (uint32_t transid = 1; transid <= 3; ++transid) {
+        Pkt4Ptr pkt(new Pkt4(DHCPDISCOVER, transid));
+        pkt->setLocalAddr(IOAddress("127.0.0.1"));
+        pkt->setLocalPort(DHCP4_SERVER_PORT + 10000 + 1);
+        pkt->setRemotePort(DHCP4_SERVER_PORT + 10000);
+        pkt->setRemoteAddr(IOAddress("127.0.0.1"));
+        pkt->setIndex(1);
+        pkt->setIface(transid == 2 ? string("nonexistent0") :
+                      string(LOOPBACK));
+        ASSERT_NO_THROW(pkt->pack());
+        pkts.push_back(pkt);
+    }
+
+    size_t sent = 0;
+    std::vector<std::string> errors;
+    ASSERT_NO_THROW(sent = ifacemgr->sendBatch(pkts, errors));
+    EXPECT_EQ(2, sent);
+    ASSERT_EQ(1, errors.size());
+    EXPECT_NE(std::string::npos, errors[0].find("nonexistent0"));
+
+    std::vector<Pkt4Ptr> rcvd_pkts;
+    while (rcvd_pkts.size() < 2) {
+        size_t received = 0;
+        ASSERT_NO_THROW(received = ifacemgr->receiveBatch4(rcvd_pkts, 8, 10));
+        ASSERT_GT(received, 0);
+    }
+    ASSERT_EQ(2, rcvd_pkts.size());
+    ASSERT_NO_THROW(rcvd_pkts[0]->unpack());
+    EXPECT_EQ(1, rcvd_pkts[0]->getTransid());
+    ASSERT_NO_THROW(rcvd_pkts[1]->unpack());
+    EXPECT_EQ(3, rcvd_pkts[1]->getTransid());
+}
+
 // Verifies that it is possible to set custom packet filter object
 // to handle sockets opening and send/receive operation.
 TEST_F(IfaceMgrTest, setPacketFilter) {
@@ -252,4 +252,20 @@ TEST_F(Option4AddrLstTest, setAddresses) {
     EXPECT_NO_THROW(opt.reset());
 }
 
+// This test verifies that setting the addresses discards the precompiled
+// data of the option.
+TEST_F(Option4AddrLstTest, setAddressesPrecompiled) {
+    Option4AddrLst opt(123, IOAddress("192.0.2.3"));
+    ASSERT_NO_THROW(opt.precompile());
+    EXPECT_TRUE(opt.isPrecompiled());
+
+    opt.setAddresses(sampleAddrs_);
+    EXPECT_FALSE(opt.isPrecompiled());
+
+    OutputBuffer buf(100);
+    opt.packPrecompiled(buf);
+    EXPECT_EQ(Option::OPTION4_HDR_LEN + 4 * sampleAddrs_.size(),
+              buf.getLength());
+}
+
 } // namespace
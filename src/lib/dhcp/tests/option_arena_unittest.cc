@@ -0,0 +1,119 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/option.h>
+#include <dhcp/option4_addrlst.h>
+#include <dhcp/option_arena.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace {
+
+// Checks that the freed block is reused for the block of the same size
+// class and that the allocations are counted.
+TEST(OptionArenaTest, reuse) {
+    void* block = OptionArena::allocate(OptionArena::MAX_BLOCK_SIZE - 1);
+    ASSERT_TRUE(block != NULL);
+    const size_t allocated = OptionArena::getAllocated();
+    const size_t reused = OptionArena::getReused();
+    OptionArena::deallocate(block, OptionArena::MAX_BLOCK_SIZE - 1);
+
+    // A block of the same size class is taken from the free list rather
+    // than from the global allocator.
+    void* other = OptionArena::allocate(OptionArena::MAX_BLOCK_SIZE);
+    EXPECT_EQ(block, other);
+    EXPECT_EQ(allocated, OptionArena::getAllocated());
+    EXPECT_EQ(reused + 1, OptionArena::getReused());
+    OptionArena::deallocate(other, OptionArena::MAX_BLOCK_SIZE);
+
+    // Freeing NULL does nothing.
+    OptionArena::deallocate(NULL, 1);
+}
+
+// Checks that the large blocks are not pooled.
+TEST(OptionArenaTest, largeBlock) {
+    const size_t allocated = OptionArena::getAllocated();
+    const size_t reused = OptionArena::getReused();
+
+    void* block = OptionArena::allocate(OptionArena::MAX_BLOCK_SIZE + 1);
+    ASSERT_TRUE(block != NULL);
+    OptionArena::deallocate(block, OptionArena::MAX_BLOCK_SIZE + 1);
+    block = OptionArena::allocate(OptionArena::MAX_BLOCK_SIZE + 1);
+    OptionArena::deallocate(block, OptionArena::MAX_BLOCK_SIZE + 1);
+
+    EXPECT_EQ(allocated, OptionArena::getAllocated());
+    EXPECT_EQ(reused, OptionArena::getReused());
+}
+
+// Checks that the options and the nodes of the option collections are
+// allocated from the arena.
+TEST(OptionArenaTest, options) {
+    const IOAddress address("192.0.2.1");
+    {
+        // Creates the free blocks for the option and the collection node.
+        OptionCollection options;
+        options.insert(std::make_pair(DHO_ROUTERS, OptionPtr(
+            new Option4AddrLst(DHO_ROUTERS, address))));
+    }
+    const size_t allocated = OptionArena::getAllocated();
+    const size_t reused = OptionArena::getReused();
+
+    OptionCollection options;
+    OptionPtr opt(new Option4AddrLst(DHO_ROUTERS, address));
+    options.insert(std::make_pair(DHO_ROUTERS, opt));
+
+    EXPECT_EQ(allocated, OptionArena::getAllocated());
+    EXPECT_EQ(reused + 2, OptionArena::getReused());
+}
+
+/// @brief Records the counters of the arena of the calling thread.
+///
+/// @param [out] allocated number of the blocks allocated by the thread
+/// @param [out] reused number of the blocks reused by the thread
+void
+allocateInThread(size_t* allocated, size_t* reused) {
+    void* block = OptionArena::allocate(1);
+    OptionArena::deallocate(block, 1);
+    *allocated = OptionArena::getAllocated();
+    *reused = OptionArena::getReused();
+}
+
+// Checks that each thread has its own free lists.
+TEST(OptionArenaTest, perThread) {
+    // Make sure that the main thread has a free block of the smallest size.
+    void* block = OptionArena::allocate(1);
+    OptionArena::deallocate(block, 1);
+
+    size_t allocated = 0;
+    size_t reused = 0;
+    Thread thread(boost::bind(&allocateInThread, &allocated, &reused));
+    thread.wait();
+
+    // The new thread doesn't see the free block of the main thread.
+    EXPECT_EQ(1, allocated);
+    EXPECT_EQ(0, reused);
+}
+
+}
@@ -378,6 +378,23 @@ TEST_F(OptionIntTest, setValueInt32) {
     EXPECT_EQ(-125000, opt->getValue());
 }
 
+// This test verifies that setting a new value discards the precompiled
+// data of the option.
+TEST_F(OptionIntTest, setValuePrecompiled) {
+    OptionInt<uint16_t> opt(Option::V4, 123, 1000);
+    ASSERT_NO_THROW(opt.precompile());
+    EXPECT_TRUE(opt.isPrecompiled());
+
+    opt.setValue(2000);
+    EXPECT_FALSE(opt.isPrecompiled());
+
+    opt.packPrecompiled(out_buf_);
+    ASSERT_EQ(4, out_buf_.getLength());
+    InputBuffer in_buf(out_buf_.getData(), out_buf_.getLength());
+    in_buf.readUint16();
+    EXPECT_EQ(2000, in_buf.readUint16());
+}
+
 TEST_F(OptionIntTest, packSuboptions4) {
     boost::shared_ptr<OptionInt<uint16_t> > opt(new OptionInt<uint16_t>(Option::V4,
                                                                         TEST_OPT_CODE,
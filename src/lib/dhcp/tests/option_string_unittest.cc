@@ -157,4 +157,21 @@ TEST_F(OptionStringTest, pack) {
     EXPECT_TRUE(option_value == test_string);
 }
 
+// This test verifies that setting a new value discards the precompiled
+// data of the option.
+TEST_F(OptionStringTest, setValuePrecompiled) {
+    OptionString optv4(Option::V4, 123, "foo");
+    ASSERT_NO_THROW(optv4.precompile());
+    EXPECT_TRUE(optv4.isPrecompiled());
+
+    optv4.setValue("foobar");
+    EXPECT_FALSE(optv4.isPrecompiled());
+
+    OutputBuffer buf(Option::OPTION4_HDR_LEN);
+    optv4.packPrecompiled(buf);
+    ASSERT_EQ(Option::OPTION4_HDR_LEN + 6, buf.getLength());
+    EXPECT_EQ("foobar", std::string(static_cast<const char*>(buf.getData())
+                                    + Option::OPTION4_HDR_LEN, 6));
+}
+
 } // anonymous namespace
@@ -547,6 +547,79 @@ TEST_F(OptionTest, setData) {
                             buf_.size()));
 }
 
+/// @brief Option modifying its data without discarding the precompiled
+/// data, like the derived classes do.
+class OptionModifiable : public Option {
+public:
+    OptionModifiable(Universe u, uint16_t type, const OptionBuffer& data)
+        : Option(u, type, data) {
+    }
+
+    /// @brief Overwrites the first byte of the option data.
+    void modify(const uint8_t value) {
+        data_[0] = value;
+    }
+};
+
+// This test verifies that the precompiled option is copied into the buffer
+// and that the precompiled data are discarded when the option is modified.
+TEST_F(OptionTest, precompile) {
+    OptionModifiable opt(Option::V4, 125, OptionBuffer(3, 1));
+    EXPECT_FALSE(opt.isPrecompiled());
+    ASSERT_NO_THROW(opt.precompile());
+    EXPECT_TRUE(opt.isPrecompiled());
+
+    const uint8_t expected[] = { 125, 3, 1, 1, 1 };
+    opt.packPrecompiled(outBuf_);
+    ASSERT_EQ(sizeof(expected), outBuf_.getLength());
+    EXPECT_EQ(0, memcmp(expected, outBuf_.getData(), sizeof(expected)));
+
+    // The precompiled data are copied, even though the option has been
+    // modified since.
+    opt.modify(2);
+    outBuf_.clear();
+    opt.packPrecompiled(outBuf_);
+    ASSERT_EQ(sizeof(expected), outBuf_.getLength());
+    EXPECT_EQ(0, memcmp(expected, outBuf_.getData(), sizeof(expected)));
+
+    // Modifying the option using the methods of the base class discards
+    // the precompiled data.
+    opt.setUint8(4);
+    EXPECT_FALSE(opt.isPrecompiled());
+    const uint8_t expected_modified[] = { 125, 1, 4 };
+    outBuf_.clear();
+    opt.packPrecompiled(outBuf_);
+    ASSERT_EQ(sizeof(expected_modified), outBuf_.getLength());
+    EXPECT_EQ(0, memcmp(expected_modified, outBuf_.getData(),
+                        sizeof(expected_modified)));
+
+    // Adding a sub-option discards the precompiled data too.
+    ASSERT_NO_THROW(opt.precompile());
+    opt.addOption(OptionPtr(new Option(Option::V4, 1)));
+    EXPECT_FALSE(opt.isPrecompiled());
+}
+
+// This test verifies that modifying a sub-option of the precompiled option
+// discards the precompiled data of the parent option.
+TEST_F(OptionTest, precompileSubOption) {
+    Option opt(Option::V4, 125, OptionBuffer(1, 1));
+    OptionPtr sub(new Option(Option::V4, 1, OptionBuffer(1, 2)));
+    opt.addOption(sub);
+    ASSERT_NO_THROW(opt.precompile());
+    EXPECT_TRUE(opt.isPrecompiled());
+    EXPECT_TRUE(sub->isPrecompiled());
+
+    sub->setUint8(3);
+    EXPECT_FALSE(sub->isPrecompiled());
+    EXPECT_FALSE(opt.isPrecompiled());
+
+    // The parent option is packed again, including the modified sub-option.
+    const uint8_t expected[] = { 125, 4, 1, 1, 1, 3 };
+    opt.packPrecompiled(outBuf_);
+    ASSERT_EQ(sizeof(expected), outBuf_.getLength());
+    EXPECT_EQ(0, memcmp(expected, outBuf_.getData(), sizeof(expected)));
+}
+
 // This test verifies that options can be compared using equal() method.
 TEST_F(OptionTest, equal) {
 
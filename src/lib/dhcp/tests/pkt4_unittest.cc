@@ -18,6 +18,7 @@
 #include <dhcp/dhcp4.h>
 #include <dhcp/libdhcp++.h>
 #include <dhcp/docsis3_option_defs.h>
+#include <dhcp/option4_addrlst.h>
 #include <dhcp/option_string.h>
 #include <dhcp/pkt4.h>
 #include <exceptions/exceptions.h>
@@ -693,6 +694,40 @@ TEST_F(Pkt4Test, unpackOptionsWithCallback) {
 
 }
 
+// This test verifies that the on-wire data of the precompiled options are
+// copied into the packet only when it has been enabled.
+TEST_F(Pkt4Test, packPrecompiled) {
+    Option4AddrLstPtr opt(new Option4AddrLst(DHO_ROUTERS,
+                                             IOAddress("192.0.2.1")));
+    ASSERT_NO_THROW(opt->precompile());
+    // The option is modified without discarding the precompiled data,
+    // so as it is possible to tell which of them is packed.
+    opt->setAddress(IOAddress("192.0.2.2"));
+
+    Pkt4 pkt(DHCPOFFER, 1234);
+    pkt.addOption(opt);
+    EXPECT_FALSE(pkt.getUsePrecompiled());
+    ASSERT_NO_THROW(pkt.pack());
+    const uint8_t packed[] = { DHO_ROUTERS, 4, 192, 0, 2, 2 };
+    std::string wire(static_cast<const char*>(pkt.getBuffer().getData()),
+                     pkt.getBuffer().getLength());
+    EXPECT_NE(std::string::npos,
+              wire.find(reinterpret_cast<const char*>(packed), 0,
+                        sizeof(packed)));
+
+    pkt.setUsePrecompiled(true);
+    ASSERT_NO_THROW(pkt.pack());
+    const uint8_t precompiled[] = { DHO_ROUTERS, 4, 192, 0, 2, 1 };
+    wire.assign(static_cast<const char*>(pkt.getBuffer().getData()),
+                pkt.getBuffer().getLength());
+    EXPECT_NE(std::string::npos,
+              wire.find(reinterpret_cast<const char*>(precompiled), 0,
+                        sizeof(precompiled)));
+
+    pkt.clear();
+    EXPECT_FALSE(pkt.getUsePrecompiled());
+}
+
 // This test verifies methods that are used for manipulating meta fields
 // i.e. fields that are not part of DHCPv4 (e.g. interface name).
 TEST_F(Pkt4Test, metaFields) {
@@ -23,6 +23,8 @@
 
 #include <sys/socket.h>
 
+#include <vector>
+
 using namespace isc::asiolink;
 using namespace isc::dhcp;
 
@@ -150,4 +152,89 @@ TEST_F(PktFilterInetTest, receive) {
     testRcvdMessage(rcvd_pkt);
 }
 
+// This test verifies that multiple DHCPv4 packets are correctly received
+// at once via INET datagram socket.
+TEST_F(PktFilterInetTest, receiveBatch) {
+    // Packets will be received over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("127.0.0.1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, false, false);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Send three DHCPv4 messages to the local loopback address and server's
+    // port.
+    for (int i = 0; i < 3; ++i) {
+        sendMessage();
+    }
+
+    // Receive the packets, at most two at once. Depending on the system,
+    // the packets are received one by one or in batches.
+    std::vector<Pkt4Ptr> rcvd_pkts;
+    while (rcvd_pkts.size() < 3) {
+        size_t received = 0;
+        ASSERT_NO_THROW(received = pkt_filter.receiveBatch(iface, sock_info_,
+                                                           rcvd_pkts, 2));
+        ASSERT_GE(received, 1);
+        ASSERT_LE(received, 2);
+    }
+    ASSERT_EQ(3, rcvd_pkts.size());
+
+    // Check that the packets have been correctly received.
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(rcvd_pkts[i]);
+        ASSERT_NO_THROW(rcvd_pkts[i]->unpack());
+        testRcvdMessage(rcvd_pkts[i]);
+    }
+}
+
+// This test verifies that multiple DHCPv4 packets are correctly sent at once
+// over the INET datagram socket.
+TEST_F(PktFilterInetTest, sendBatch) {
+    // Packets will be sent over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("127.0.0.1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterInet pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, false, false);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Send three copies of the packet over the socket.
+    std::vector<Pkt4Ptr> pkts(3, test_message_);
+    size_t sent = 0;
+    std::vector<std::string> errors;
+    ASSERT_NO_THROW(sent = pkt_filter.sendBatch(iface, sock_info_.sockfd_,
+                                                pkts, errors));
+    EXPECT_EQ(3, sent);
+    EXPECT_TRUE(errors.empty());
+
+    // Read the data from socket.
+    for (int i = 0; i < 3; ++i) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sock_info_.sockfd_, &readfds);
+
+        struct timeval timeout;
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        int result = select(sock_info_.sockfd_ + 1, &readfds, NULL, NULL,
+                            &timeout);
+        // We should receive some data from loopback interface.
+        ASSERT_GT(result, 0);
+
+        // Get the actual data.
+        uint8_t rcv_buf[RECV_BUF_SIZE];
+        result = recv(sock_info_.sockfd_, rcv_buf, RECV_BUF_SIZE, 0);
+        ASSERT_GT(result, 0);
+
+        // Create the DHCPv4 packet from the received data and check it.
+        Pkt4Ptr rcvd_pkt(new Pkt4(rcv_buf, result));
+        ASSERT_NO_THROW(rcvd_pkt->unpack());
+        testRcvdMessage(rcvd_pkt);
+    }
+}
+
 } // anonymous namespace
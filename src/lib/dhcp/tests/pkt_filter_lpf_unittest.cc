@@ -158,6 +158,36 @@ TEST_F(PktFilterLPFTest, DISABLED_send) {
     testRcvdMessage(rcvd_pkt);
 }
 
+// This test verifies that multiple DHCP packets are sent through the raw
+// socket at once, each in its own hand-crafted frame.
+TEST_F(PktFilterLPFTest, DISABLED_sendBatch) {
+    // Packets will be sent over loopback interface.
+    Iface iface(ifname_, ifindex_);
+    IOAddress addr("127.0.0.1");
+
+    // Create an instance of the class which we are testing.
+    PktFilterLPF pkt_filter;
+    sock_info_ = pkt_filter.openSocket(iface, addr, PORT, false, false);
+    ASSERT_GE(sock_info_.sockfd_, 0);
+
+    // Send the same message twice.
+    std::vector<Pkt4Ptr> pkts(2, test_message_);
+    size_t sent = 0;
+    std::vector<std::string> errors;
+    ASSERT_NO_THROW(sent = pkt_filter.sendBatch(iface, sock_info_.sockfd_,
+                                                pkts, errors));
+    EXPECT_EQ(2, sent);
+    EXPECT_TRUE(errors.empty());
+
+    // Both packets should be received from the loopback interface.
+    for (size_t i = 0; i < pkts.size(); ++i) {
+        Pkt4Ptr rcvd_pkt = pkt_filter.receive(iface, sock_info_);
+        ASSERT_TRUE(rcvd_pkt);
+        ASSERT_NO_THROW(rcvd_pkt->unpack());
+        testRcvdMessage(rcvd_pkt);
+    }
+}
+
 // This test verifies correctness of reception of the DHCP packet over
 // raw socket, whereby all IP stack headers are hand-crafted.
 TEST_F(PktFilterLPFTest, DISABLED_receive) {
@@ -0,0 +1,181 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/dhcp6.h>
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+#include <dhcp/pkt_pool.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+
+namespace {
+
+// Checks that the released packet is reused and that it is reinitialized
+// as the packet to be sent.
+TEST(PktPoolTest, reuse4) {
+    PktPool<Pkt4> pool;
+
+    Pkt4Ptr pkt = pool.create(DHCPOFFER, 1234);
+    ASSERT_TRUE(pkt);
+    EXPECT_EQ(DHCPOFFER, pkt->getType());
+    EXPECT_EQ(1234, pkt->getTransid());
+    EXPECT_EQ(1, pool.getAllocated());
+    EXPECT_EQ(0, pool.getReused());
+
+    pkt->setYiaddr(IOAddress("192.0.2.1"));
+    pkt->setIface("eth0");
+    pkt->addClass("foo");
+    OptionPtr opt(new Option(Option::V4, 12, OptionBuffer(3, 1)));
+    pkt->addOption(opt);
+    ASSERT_NO_THROW(pkt->pack());
+    const Pkt4* const pkt_addr = pkt.get();
+
+    // The released packet is cleared and kept in the pool. The options are
+    // released at this point.
+    pkt.reset();
+    EXPECT_EQ(1, pool.getFree());
+    EXPECT_TRUE(opt.unique());
+
+    // The same packet is handed out again and it looks like a new one.
+    pkt = pool.create(DHCPACK, 5678);
+    EXPECT_EQ(pkt_addr, pkt.get());
+    EXPECT_EQ(1, pool.getAllocated());
+    EXPECT_EQ(1, pool.getReused());
+    EXPECT_EQ(0, pool.getFree());
+
+    EXPECT_EQ(DHCPACK, pkt->getType());
+    EXPECT_EQ(BOOTREPLY, pkt->getOp());
+    EXPECT_EQ(5678, pkt->getTransid());
+    EXPECT_EQ("0.0.0.0", pkt->getYiaddr().toText());
+    EXPECT_TRUE(pkt->getIface().empty());
+    EXPECT_TRUE(pkt->classes_.empty());
+    EXPECT_FALSE(pkt->getOption(12));
+    EXPECT_EQ(0, pkt->getBuffer().getLength());
+}
+
+// Checks that the hardware address of the released packet is cleared,
+// unless it is still used elsewhere.
+TEST(PktPoolTest, hwaddr4) {
+    PktPool<Pkt4> pool;
+    const std::vector<uint8_t> mac(6, 0xa);
+
+    Pkt4Ptr pkt = pool.create(DHCPOFFER, 1234);
+    pkt->setHWAddr(HTYPE_FDDI, mac.size(), mac);
+    pkt.reset();
+    pkt = pool.create(DHCPOFFER, 1234);
+    ASSERT_TRUE(pkt->getHWAddr());
+    EXPECT_TRUE(pkt->getHWAddr()->hwaddr_.empty());
+    EXPECT_EQ(HTYPE_ETHER, pkt->getHtype());
+
+    // The shared hardware address is left intact.
+    pkt->setHWAddr(HTYPE_FDDI, mac.size(), mac);
+    HWAddrPtr hwaddr = pkt->getHWAddr();
+    pkt.reset();
+    EXPECT_TRUE(hwaddr->hwaddr_ == mac);
+    EXPECT_EQ(HTYPE_FDDI, hwaddr->htype_);
+    pkt = pool.create(DHCPOFFER, 1234);
+    EXPECT_NE(hwaddr, pkt->getHWAddr());
+    EXPECT_TRUE(pkt->getHWAddr()->hwaddr_.empty());
+}
+
+// Checks that the released packet is reinitialized to hold the received
+// data.
+TEST(PktPoolTest, reuseReceived4) {
+    PktPool<Pkt4> pool;
+
+    // Assemble the message, which is then received.
+    Pkt4 sent(DHCPDISCOVER, 1234);
+    sent.setGiaddr(IOAddress("192.0.2.1"));
+    ASSERT_NO_THROW(sent.pack());
+    const uint8_t* data =
+        static_cast<const uint8_t*>(sent.getBuffer().getData());
+    const size_t len = sent.getBuffer().getLength();
+
+    pool.create(DHCPOFFER, 1);
+    Pkt4Ptr pkt = pool.create(data, len);
+    EXPECT_EQ(1, pool.getReused());
+    ASSERT_NO_THROW(pkt->unpack());
+    EXPECT_EQ(DHCPDISCOVER, pkt->getType());
+    EXPECT_EQ(1234, pkt->getTransid());
+    EXPECT_EQ("192.0.2.1", pkt->getGiaddr().toText());
+
+    // The invalid data are reported and the packet is returned to the pool.
+    pkt.reset();
+    EXPECT_THROW(pool.create(data, Pkt4::DHCPV4_PKT_HDR_LEN - 1), OutOfRange);
+    EXPECT_EQ(1, pool.getFree());
+}
+
+// Checks that the DHCPv6 messages are reused.
+TEST(PktPoolTest, reuse6) {
+    PktPool<Pkt6> pool;
+
+    // Assemble the message, which is then received.
+    Pkt6 sent(DHCPV6_SOLICIT, 1234);
+    sent.addOption(OptionPtr(new Option(Option::V6, D6O_CLIENTID,
+                                        OptionBuffer(8, 1))));
+    ASSERT_NO_THROW(sent.pack());
+    const uint8_t* data =
+        static_cast<const uint8_t*>(sent.getBuffer().getData());
+    const size_t len = sent.getBuffer().getLength();
+
+    Pkt6Ptr pkt = pool.create(DHCPV6_REPLY, 1234);
+    pkt->addOption(OptionPtr(new Option(Option::V6, D6O_SERVERID,
+                                        OptionBuffer(8, 1))));
+    pkt->addRelayInfo(Pkt6::RelayInfo());
+    pkt->setRemotePort(547);
+    pkt.reset();
+
+    pkt = pool.create(data, len);
+    EXPECT_EQ(1, pool.getReused());
+    EXPECT_TRUE(pkt->relay_info_.empty());
+    EXPECT_TRUE(pkt->options_.empty());
+    EXPECT_EQ(0, pkt->getRemotePort());
+    ASSERT_TRUE(pkt->unpack());
+    EXPECT_EQ(DHCPV6_SOLICIT, pkt->getType());
+    EXPECT_EQ(1234, pkt->getTransid());
+    EXPECT_TRUE(pkt->getOption(D6O_CLIENTID));
+    EXPECT_FALSE(pkt->getOption(D6O_SERVERID));
+}
+
+// Checks that the number of the unused packets is limited and that the
+// packets outliving the pool are destroyed.
+TEST(PktPoolTest, maxSize) {
+    boost::scoped_ptr<PktPool<Pkt4> > pool(new PktPool<Pkt4>(2));
+
+    std::vector<Pkt4Ptr> pkts;
+    for (int i = 0; i < 3; ++i) {
+        pkts.push_back(pool->create(DHCPOFFER, i));
+    }
+    EXPECT_EQ(3, pool->getAllocated());
+    Pkt4Ptr last = pkts.back();
+    pkts.clear();
+    EXPECT_EQ(2, pool->getFree());
+
+    // The pool is destroyed before the packet is released.
+    pool.reset();
+    EXPECT_NO_THROW(last.reset());
+}
+
+} // end of anonymous namespace
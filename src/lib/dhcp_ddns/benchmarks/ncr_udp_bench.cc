@@ -0,0 +1,211 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <asio.hpp>
+#include <asiolink/io_address.h>
+#include <asiolink/io_service.h>
+#include <dhcp_ddns/ncr_udp.h>
+#include <log/logger_support.h>
+#include <util/buffer.h>
+
+#include <boost/bind.hpp>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace isc;
+using namespace isc::dhcp_ddns;
+
+namespace {
+
+// Counts the requests sent and received, as a DHCP server and D2 would
+// handle them.
+class Counter : public NameChangeListener::RequestReceiveHandler,
+                public NameChangeSender::RequestSendHandler {
+public:
+    Counter() : sent_(0), send_failed_(0), received_(0), recv_failed_(0) {
+    }
+
+    virtual void operator()(const NameChangeListener::Result result,
+                            NameChangeRequestPtr&) {
+        if (result == NameChangeListener::SUCCESS) {
+            ++received_;
+        } else {
+            ++recv_failed_;
+        }
+    }
+
+    virtual void operator()(const NameChangeSender::Result result,
+                            NameChangeRequestPtr&) {
+        if (result == NameChangeSender::SUCCESS) {
+            ++sent_;
+        } else {
+            ++send_failed_;
+        }
+    }
+
+    size_t sent_;
+    size_t send_failed_;
+    size_t received_;
+    size_t recv_failed_;
+};
+
+// Makes the request of a client, with a distinct name and address.
+NameChangeRequestPtr
+makeRequest(const unsigned int client) {
+    ostringstream fqdn;
+    fqdn << "client" << client << ".example.com.";
+    ostringstream address;
+    address << "10." << ((client >> 16) & 0xff) << "."
+            << ((client >> 8) & 0xff) << "." << (client & 0xff);
+    ostringstream dhcid;
+    dhcid << "0102030405060708090a0b0c0d0e0f10" << hex << setfill('0')
+          << setw(8) << client;
+    NameChangeRequestPtr ncr(new NameChangeRequest(
+        CHG_ADD, true, true, fqdn.str(), address.str(),
+        D2Dhcid(dhcid.str()), 0, 3600));
+    return (ncr);
+}
+
+double
+elapsed(const struct timeval& start, const struct timeval& end) {
+    return ((end.tv_sec - start.tv_sec) +
+            (end.tv_usec - start.tv_usec) / 1000000.0);
+}
+
+void
+stopOnTimeout(asiolink::IOService& io_service, const asio::error_code& error) {
+    if (!error) {
+        io_service.stop();
+    }
+}
+
+// Sends the requests from a sender to a listener over the loopback and
+// reports the throughput.  As a DHCP server under load does, the requests
+// are queued faster than they are sent: they are all queued at once.
+void
+run(const NameChangeFormat format, const vector<NameChangeRequestPtr>& ncrs,
+    const uint16_t port) {
+    asiolink::IOService io_service;
+    Counter counter;
+    asiolink::IOAddress address("127.0.0.1");
+    NameChangeUDPListener listener(address, port, format, counter, true);
+    NameChangeUDPSender sender(address, port + 1, address, port, format,
+                               counter, ncrs.size(), true);
+
+    util::OutputBuffer rendered(0);
+    ncrs[0]->toFormat(format, rendered);
+
+    // The datagrams lost on the loopback would stall the run.
+    asio::deadline_timer timer(io_service.get_io_service());
+    timer.expires_from_now(boost::posix_time::seconds(60));
+    timer.async_wait(boost::bind(&stopOnTimeout, boost::ref(io_service), _1));
+
+    listener.startListening(io_service);
+    sender.startSending(io_service);
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    for (size_t i = 0; i < ncrs.size(); ++i) {
+        NameChangeRequestPtr ncr = ncrs[i];
+        sender.sendRequest(ncr);
+    }
+    while ((counter.received_ + counter.recv_failed_ < ncrs.size()) &&
+           (io_service.get_io_service().run_one() > 0)) {
+    }
+    gettimeofday(&end, NULL);
+    const double duration = elapsed(start, end);
+
+    timer.cancel();
+    listener.stopListening();
+    sender.stopSending();
+
+    cout << ncrFormatToString(format) << ":" << endl;
+    cout << "  Request size: " << rendered.getLength() << " bytes" << endl;
+    cout << "  Elapsed: " << fixed << setprecision(3) << duration << "s"
+         << endl;
+    cout << "  Throughput: " << setprecision(1) << ncrs.size() / duration
+         << " requests/s" << endl;
+    cout << "  Sent: " << counter.sent_ << ", failed: "
+         << counter.send_failed_ << endl;
+    cout << "  Received: " << counter.received_ << ", failed: "
+         << counter.recv_failed_ << endl;
+}
+
+void
+usage() {
+    cerr << "Usage: ncr_udp_bench [-n requests] [-f JSON|BINARY] [-p port]"
+         << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    unsigned int requests = 100000;
+    vector<NameChangeFormat> formats;
+    uint16_t port = 53101;
+    while ((ch = getopt(argc, argv, "n:f:p:")) != -1) {
+        switch (ch) {
+        case 'n':
+            requests = atoi(optarg);
+            break;
+        case 'f':
+            try {
+                formats.push_back(stringToNcrFormat(optarg));
+            } catch (const isc::BadValue&) {
+                usage();
+            }
+            break;
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if ((argc != 0) || (requests == 0)) {
+        usage();
+    }
+    if (formats.empty()) {
+        formats.push_back(FMT_JSON);
+        formats.push_back(FMT_BINARY);
+    }
+
+    log::initLogger("ncr_udp_bench", log::WARN);
+
+    cout << "Requests: " << requests << endl;
+
+    vector<NameChangeRequestPtr> ncrs;
+    for (unsigned int i = 0; i < requests; ++i) {
+        ncrs.push_back(makeRequest(i));
+    }
+
+    for (size_t i = 0; i < formats.size(); ++i) {
+        run(formats[i], ncrs, port);
+    }
+
+    return (0);
+}
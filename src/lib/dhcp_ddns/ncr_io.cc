@@ -110,16 +110,34 @@ NameChangeListener::stopListening() {
 void
 NameChangeListener::invokeRecvHandler(const Result result,
                                       NameChangeRequestPtr& ncr) {
-    // Call the registered application layer handler.
+    RequestList ncrs(1, ncr);
+    invokeRecvHandler(result, ncrs);
+}
+
+void
+NameChangeListener::invokeRecvHandler(const Result result,
+                                      RequestList& ncrs) {
+    // Call the registered application layer handler once per request.
     // Surround the invocation with a try-catch. The invoked handler is
     // not supposed to throw, but in the event it does we will at least
     // report it.
-    try {
-        io_pending_ = false;
-        recv_handler_(result, ncr);
-    } catch (const std::exception& ex) {
-        LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_UNCAUGHT_NCR_RECV_HANDLER_ERROR)
-                  .arg(ex.what());
+    io_pending_ = false;
+    for (size_t i = 0; i < ncrs.size(); ++i) {
+        // If the handler stopped listening, the requests left are dropped
+        // as the ones arriving afterward would be.
+        if ((i > 0) && !amListening()) {
+            LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_RECV_BATCH_DROPPED)
+                      .arg(ncrs.size() - i);
+            break;
+        }
+
+        try {
+            recv_handler_(result, ncrs[i]);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcp_ddns_logger,
+                      DHCP_DDNS_UNCAUGHT_NCR_RECV_HANDLER_ERROR)
+                      .arg(ex.what());
+        }
     }
 
     // Start the next IO layer asynchronous receive.
@@ -160,7 +178,7 @@ NameChangeListener::invokeRecvHandler(const Result result,
 NameChangeSender::NameChangeSender(RequestSendHandler& send_handler,
                                    size_t send_queue_max)
     : sending_(false), send_handler_(send_handler),
-      send_queue_max_(send_queue_max), io_service_(NULL) {
+      send_queue_max_(send_queue_max), send_count_(1), io_service_(NULL) {
 
     // Queue size must be big enough to hold at least 1 entry.
     setQueueMaxSize(send_queue_max);
@@ -175,6 +193,7 @@ NameChangeSender::startSending(isc::asiolink::IOService& io_service) {
 
     // Clear send marker.
     ncr_to_send_.reset();
+    send_count_ = 1;
 
     // Call implementation dependent open.
     try {
@@ -266,6 +285,7 @@ NameChangeSender::sendNext() {
        // handler need to cycle thru open/close ?
 
        // Call implementation dependent send.
+       send_count_ = 1;
        doSend(ncr_to_send_);
     }
 }
@@ -273,25 +293,36 @@ NameChangeSender::sendNext() {
 void
 NameChangeSender::invokeSendHandler(const NameChangeSender::Result result) {
     // @todo reset defense timer
+    SendQueue sent;
     if (result == SUCCESS) {
-        // It shipped so pull it off the queue.
-        send_queue_.pop_front();
+        // They shipped so pull them off the queue, before any handler may
+        // alter it.
+        for (size_t i = 0; (i < send_count_) && !send_queue_.empty(); ++i) {
+            sent.push_back(send_queue_.front());
+            send_queue_.pop_front();
+        }
+    } else {
+        sent.push_back(ncr_to_send_);
     }
 
     // Invoke the completion handler passing in the result and a pointer
-    // the request involved.
+    // the request involved, for each request.
     // Surround the invocation with a try-catch. The invoked handler is
     // not supposed to throw, but in the event it does we will at least
     // report it.
-    try {
-        send_handler_(result, ncr_to_send_);
-    } catch (const std::exception& ex) {
-        LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_UNCAUGHT_NCR_SEND_HANDLER_ERROR)
-                  .arg(ex.what());
+    for (SendQueue::iterator it = sent.begin(); it != sent.end(); ++it) {
+        try {
+            send_handler_(result, *it);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcp_ddns_logger,
+                      DHCP_DDNS_UNCAUGHT_NCR_SEND_HANDLER_ERROR)
+                      .arg(ex.what());
+        }
     }
 
     // Clear the pending ncr pointer.
     ncr_to_send_.reset();
+    send_count_ = 1;
 
     // Set up the next send
     try {
@@ -321,6 +352,16 @@ NameChangeSender::invokeSendHandler(const NameChangeSender::Result result) {
     }
 }
 
+void
+NameChangeSender::setSendCount(const size_t count) {
+    if ((count == 0) || (count > send_queue_.size())) {
+        isc_throw(NcrSenderError, "NameChangeSender: invalid send count: "
+                  << count << ", queue size: " << send_queue_.size());
+    }
+
+    send_count_ = count;
+}
+
 void
 NameChangeSender::skipNext() {
     if (!send_queue_.empty()) {
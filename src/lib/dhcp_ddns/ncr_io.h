@@ -62,6 +62,7 @@
 #include <exceptions/exceptions.h>
 
 #include <deque>
+#include <vector>
 
 namespace isc {
 namespace dhcp_ddns {
@@ -181,6 +182,9 @@ public:
       ERROR
     };
 
+    /// @brief Defines a list of the requests received together.
+    typedef std::vector<NameChangeRequestPtr> RequestList;
+
     /// @brief Abstract class for defining application layer receive callbacks.
     ///
     /// Applications which will receive NameChangeRequests must provide a
@@ -273,6 +277,19 @@ protected:
     /// wise.
     void invokeRecvHandler(const Result result, NameChangeRequestPtr& ncr);
 
+    /// @brief Calls the NCR receive handler for requests received together.
+    ///
+    /// This is the variant of the above method used by the derivations
+    /// which may receive several requests in a single IO layer read. The
+    /// handler is invoked once per request and the next read is started
+    /// only once all of them have been handed over. If the handler stops
+    /// listening, the remaining requests are dropped.
+    ///
+    /// @param result contains that receive outcome status.
+    /// @param ncrs is the list of the requests received, in the order in
+    /// which they were read. It must not be empty.
+    void invokeRecvHandler(const Result result, RequestList& ncrs);
+
     /// @brief Abstract method which opens the IO source for reception.
     ///
     /// The derivation uses this method to perform the steps needed to
@@ -462,6 +479,12 @@ public:
 /// will call the sendNext() method to initiate the next send.  This ensures
 /// that requests continue to dequeue and ship.
 ///
+/// A derivation may ship the requests following the one passed into doSend()
+/// along with it, e.g. in the same datagram, by calling setSendCount() from
+/// doSend().  When such a send succeeds, invokeSendHandler removes all of
+/// these requests from the queue and invokes the application layer handler
+/// once for each of them.
+///
 class NameChangeSender {
 public:
 
@@ -596,9 +619,12 @@ protected:
     /// This is the hook by which the sender's caller's NCR send completion
     /// handler is called.  This method MUST be invoked by the derivation's
     /// implementation of doSend.   Note that if the send was a success,
-    /// the entry at the front of the queue is removed from the queue.
-    /// If not we leave it there so we can retry it.  After we invoke the
-    /// handler we clear the pending ncr value and queue up the next send.
+    /// the entry at the front of the queue is removed from the queue, along
+    /// with the entries sent with it (see @c setSendCount), and the handler
+    /// is invoked for each of them.  If not we leave them there so we can
+    /// retry them, and the handler is invoked for the front entry only.
+    /// After we invoke the handler we clear the pending ncr value and queue
+    /// up the next send.
     ///
     /// NOTE:
     /// The handler invoked by this method MUST NOT THROW. The handler is
@@ -650,6 +676,19 @@ protected:
     /// throw it as an isc::Exception or derivative.
     virtual void doSend(NameChangeRequestPtr& ncr) = 0;
 
+    /// @brief Sets the number of the requests being sent.
+    ///
+    /// The derivation calls this method from doSend when it sends the
+    /// requests following the given NCR in the send queue along with it.
+    /// By default, only the given NCR is sent.
+    ///
+    /// @param count number of the requests sent, starting at the front of
+    /// the send queue.
+    ///
+    /// @throw NcrSenderError if the count is zero or exceeds the size of
+    /// the send queue.
+    void setSendCount(const size_t count);
+
 public:
     /// @brief Removes the request at the front of the send queue
     ///
@@ -774,6 +813,10 @@ private:
     /// @brief Pointer to the request which is in the process of being sent.
     NameChangeRequestPtr ncr_to_send_;
 
+    /// @brief Number of the requests, starting at the front of the queue,
+    /// which are in the process of being sent.
+    size_t send_count_;
+
     /// @brief Pointer to the IOService currently being used by the sender.
     /// @note We need to remember the io_service but we receive it by
     /// reference.  Use a raw pointer to store it.  This value should never be
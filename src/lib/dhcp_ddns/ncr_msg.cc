@@ -34,6 +34,10 @@ NameChangeFormat stringToNcrFormat(const std::string& fmt_str) {
         return FMT_JSON;
     }
 
+    if (boost::iequals(fmt_str, "BINARY")) {
+        return FMT_BINARY;
+    }
+
     isc_throw(BadValue, "Invalid NameChangeRequest format:" << fmt_str);
 }
 
@@ -43,6 +47,10 @@ std::string ncrFormatToString(NameChangeFormat format) {
         return ("JSON");
     }
 
+    if (format == FMT_BINARY) {
+        return ("BINARY");
+    }
+
     std::ostringstream stream;
     stream  << "UNKNOWN(" << format << ")";
     return (stream.str());
@@ -241,22 +249,34 @@ NameChangeRequest::fromFormat(const NameChangeFormat format,
     // InputBuffer and pass it into the appropriate format-specific factory.
     NameChangeRequestPtr ncr;
     switch (format) {
-    case FMT_JSON: {
+    case FMT_JSON:
+    case FMT_BINARY: {
         try {
-            // Get the length of the JSON text.
+            // Get the length of the request.
             size_t len = buffer.readUint16();
+            if (len == 0) {
+                isc_throw(NcrMessageError, "fromFormat: empty request");
+            }
 
-            // Read the text from the buffer into a vector.
+            // Read the request from the buffer into a vector.
             std::vector<uint8_t> vec;
             buffer.readVector(vec, len);
 
-            // Turn the vector into a string.
-            std::string string_data(vec.begin(), vec.end());
-
-            // Pass the string of JSON text into JSON factory to create the
-            // NameChangeRequest instance.  Note the factory may throw
-            // NcrMessageError.
-            ncr = NameChangeRequest::fromJSON(string_data);
+            // Both formats are accepted, whatever the format given, so as
+            // the peers may use either: the binary requests start with the
+            // version of the format, which can't start a JSON text.
+            if (vec[0] == NCR_BINARY_VERSION) {
+                isc::util::InputBuffer binary_data(&vec[0], vec.size());
+                ncr = NameChangeRequest::fromBinary(binary_data);
+            } else {
+                // Turn the vector into a string.
+                std::string string_data(vec.begin(), vec.end());
+
+                // Pass the string of JSON text into JSON factory to create
+                // the NameChangeRequest instance.  Note the factory may throw
+                // NcrMessageError.
+                ncr = NameChangeRequest::fromJSON(string_data);
+            }
         } catch (isc::util::InvalidBufferPosition& ex) {
             // Read error accessing data in InputBuffer.
             isc_throw(NcrMessageError, "fromFormat: buffer read error: "
@@ -291,6 +311,15 @@ NameChangeRequest::toFormat(const NameChangeFormat format,
         buffer.writeData(json.c_str(), length);
         break;
         }
+    case FMT_BINARY: {
+        // Write the request after a placeholder for its length, which is
+        // known once the request is written.
+        const size_t length_pos = buffer.getLength();
+        buffer.writeUint16(0);
+        toBinary(buffer);
+        buffer.writeUint16At(buffer.getLength() - length_pos - 2, length_pos);
+        break;
+        }
     default:
         // Programmatic error, shouldn't happen.
         isc_throw(NcrMessageError, "toFormat - invalid format");
@@ -381,6 +410,102 @@ NameChangeRequest::toJSON() const  {
 }
 
 
+NameChangeRequestPtr
+NameChangeRequest::fromBinary(isc::util::InputBuffer& buffer) {
+    // Use default constructor to create a "blank" NameChangeRequest, then
+    // set each member in the order they were written by toBinary.
+    NameChangeRequestPtr ncr(new NameChangeRequest());
+    try {
+        const uint8_t version = buffer.readUint8();
+        if (version != NCR_BINARY_VERSION) {
+            isc_throw(NcrMessageError, "Unsupported binary NameChangeRequest"
+                      " version: " << static_cast<int>(version));
+        }
+
+        const uint8_t change_type = buffer.readUint8();
+        if ((change_type != CHG_ADD) && (change_type != CHG_REMOVE)) {
+            isc_throw(NcrMessageError, "Invalid data value for change_type: "
+                      << static_cast<int>(change_type));
+        }
+        ncr->setChangeType(static_cast<NameChangeType>(change_type));
+
+        const uint8_t flags = buffer.readUint8();
+        ncr->setForwardChange(flags & 0x01);
+        ncr->setReverseChange(flags & 0x02);
+
+        const uint8_t address_len = buffer.readUint8();
+        uint8_t address[16];
+        if ((address_len != 4) && (address_len != 16)) {
+            isc_throw(NcrMessageError, "Invalid IP address length: "
+                      << static_cast<int>(address_len));
+        }
+        buffer.readData(address, address_len);
+        ncr->ip_io_address_ = asiolink::IOAddress::
+            fromBytes(address_len == 4 ? AF_INET : AF_INET6, address);
+
+        uint64_t lease_expires_on =
+            static_cast<uint64_t>(buffer.readUint32()) << 32;
+        lease_expires_on |= buffer.readUint32();
+        ncr->lease_expires_on_ = lease_expires_on;
+        ncr->setLeaseLength(buffer.readUint32());
+
+        // The empty DHCID and FQDN are rejected by validateContent.
+        std::vector<uint8_t> dhcid;
+        const size_t dhcid_len = buffer.readUint16();
+        if (dhcid_len > 0) {
+            buffer.readVector(dhcid, dhcid_len);
+        }
+        ncr->dhcid_.fromBytes(dhcid);
+
+        std::vector<uint8_t> fqdn;
+        const size_t fqdn_len = buffer.readUint16();
+        if (fqdn_len > 0) {
+            buffer.readVector(fqdn, fqdn_len);
+            ncr->setFqdn(std::string(fqdn.begin(), fqdn.end()));
+        }
+    } catch (const isc::util::InvalidBufferPosition& ex) {
+        isc_throw(NcrMessageError,
+                  "Malformed binary NameChangeRequest: " << ex.what());
+    }
+
+    if (buffer.getPosition() != buffer.getLength()) {
+        isc_throw(NcrMessageError, "Malformed binary NameChangeRequest: "
+                  << buffer.getLength() - buffer.getPosition()
+                  << " trailing bytes");
+    }
+
+    // Validate the overall content semantically.  This will throw an
+    // NcrMessageError if anything is amiss.
+    ncr->validateContent();
+
+    return (ncr);
+}
+
+void
+NameChangeRequest::toBinary(isc::util::OutputBuffer& buffer) const {
+    buffer.writeUint8(NCR_BINARY_VERSION);
+    buffer.writeUint8(getChangeType());
+    buffer.writeUint8((isForwardChange() ? 0x01 : 0) |
+                      (isReverseChange() ? 0x02 : 0));
+
+    const std::vector<uint8_t> address = ip_io_address_.toBytes();
+    buffer.writeUint8(address.size());
+    buffer.writeData(&address[0], address.size());
+
+    buffer.writeUint32(lease_expires_on_ >> 32);
+    buffer.writeUint32(lease_expires_on_ & 0xffffffff);
+    buffer.writeUint32(lease_length_);
+
+    const std::vector<uint8_t>& dhcid = dhcid_.getBytes();
+    buffer.writeUint16(dhcid.size());
+    if (!dhcid.empty()) {
+        buffer.writeData(&dhcid[0], dhcid.size());
+    }
+
+    buffer.writeUint16(fqdn_.size());
+    buffer.writeData(fqdn_.c_str(), fqdn_.size());
+}
+
 void
 NameChangeRequest::validateContent() {
     //@todo This is an initial implementation which provides a minimal amount
@@ -65,15 +65,21 @@ enum NameChangeStatus  {
   ST_FAILED
 };
 
+/// @brief Version of the binary format of the requests.
+///
+/// It is the first byte of a binary request, which can't start a JSON text.
+const uint8_t NCR_BINARY_VERSION = 1;
+
 /// @brief Defines the list of data wire formats supported.
 enum NameChangeFormat {
-  FMT_JSON
+  FMT_JSON,
+  FMT_BINARY
 };
 
 /// @brief Function which converts labels to  NameChangeFormat enum values.
 ///
 /// @param fmt_str text to convert to an enum.
-/// Valid string values: "JSON"
+/// Valid string values: "JSON", "BINARY"
 ///
 /// @return NameChangeFormat value which maps to the given string.
 ///
@@ -147,6 +153,13 @@ public:
     /// or there is an odd number of digits.
     void fromStr(const std::string& data);
 
+    /// @brief Sets the DHCID value to the given bytes.
+    ///
+    /// @param data is the DHCID value.
+    void fromBytes(const std::vector<uint8_t>& data) {
+        bytes_ = data;
+    }
+
     /// @brief Sets the DHCID value based on the Client Identifier.
     ///
     /// @param clientid_data Holds the raw bytes representing client identifier.
@@ -229,9 +242,10 @@ typedef std::map<std::string, isc::data::ConstElementPtr> ElementMap;
 /// This class is used by DHCP-DDNS clients (e.g. DHCP4, DHCP6) to
 /// request DNS updates.  Each message contains a single DNS change (either an
 /// add/update or a remove) for a single FQDN.  It provides marshalling services
-/// for moving instances to and from the wire.  Currently, the only format
-/// supported is JSON, however the class provides an interface such that other
-/// formats can be readily supported.
+/// for moving instances to and from the wire, in JSON or in a compact binary
+/// format.  In both formats a marshalled request is prefixed with its length,
+/// so as a buffer, a datagram or a stream may carry any number of requests
+/// one after the other.
 class NameChangeRequest {
 public:
     /// @brief Default Constructor.
@@ -280,7 +294,18 @@ public:
     /// is than treated as JSON which is then parsed into the data needed
     /// to create a request instance.
     ///
-    /// (NOTE currently only JSON is supported.)
+    /// BINARY: The buffer is expected to contain a two byte unsigned integer
+    /// which specifies the length of the binary request, followed by the
+    /// binary request itself (see @c fromBinary).
+    ///
+    /// As the binary requests start with a byte which can't start a JSON
+    /// text, the format of the request read is recognized by its first byte,
+    /// whatever the format given. This way the listeners accept the requests
+    /// of the peers using either format.
+    ///
+    /// Only the request at the current position of the buffer is read, so
+    /// the requests held one after the other by a buffer are read by calling
+    /// this method until the end of the buffer is reached.
     ///
     /// @param format indicates the data format to use
     /// @param buffer is the input buffer containing the marshalled request
@@ -303,7 +328,11 @@ public:
     /// the request data needed to reassemble the request on the receiving
     /// end. The JSON text in the buffer is NOT null-terminated.
     ///
-    /// (NOTE currently only JSON is supported.)
+    /// BINARY: Upon completion, the buffer will contain a two byte unsigned
+    /// integer which specifies the length of the binary request, followed by
+    /// the binary request itself (see @c toBinary).
+    ///
+    /// The request is appended to the contents of the buffer.
     ///
     /// @param format indicates the data format to use
     /// @param buffer is the output buffer to which the request should be
@@ -327,6 +356,38 @@ public:
     /// @return a string containing the JSON rendition of the request
     std::string toJSON() const;
 
+    /// @brief Static method for creating a NameChangeRequest from a
+    /// buffer containing a binary rendition of a request.
+    ///
+    /// The binary rendition of a request is made of, in network byte order:
+    ///
+    ///  - the format version (1 byte), @c NCR_BINARY_VERSION
+    ///  - the change type (1 byte)
+    ///  - the direction flags (1 byte): 1 for forward, 2 for reverse
+    ///  - the length of the IP address (1 byte), 4 or 16, and the address
+    ///  - the lease expiration (8 bytes), in seconds since the epoch
+    ///  - the lease length (4 bytes)
+    ///  - the length of the DHCID (2 bytes) and the DHCID
+    ///  - the length of the FQDN (2 bytes) and the FQDN text
+    ///
+    /// Unlike JSON, this format is read without any parsing or memory
+    /// allocation besides the members of the request.
+    ///
+    /// @param buffer is a buffer holding the binary request and nothing
+    /// else.
+    ///
+    /// @return a pointer to the new NameChangeRequest
+    ///
+    /// @throw NcrMessageError if an error occurs creating new request.
+    static NameChangeRequestPtr fromBinary(isc::util::InputBuffer& buffer);
+
+    /// @brief Instance method for marshalling the contents of the request
+    /// in binary.
+    ///
+    /// @param buffer is the output buffer to which the binary rendition of
+    /// the request (see @c fromBinary) is appended.
+    void toBinary(isc::util::OutputBuffer& buffer) const;
+
     /// @brief Validates the content of a populated request.  This method is
     /// used by both the full constructor and from-wire marshalling to ensure
     /// that the request is content valid.  Currently it enforces the
@@ -158,7 +158,7 @@ NameChangeUDPListener::close() {
 void
 NameChangeUDPListener::receiveCompletionHandler(const bool successful,
                                                 const UDPCallback *callback) {
-    NameChangeRequestPtr ncr;
+    RequestList ncrs;
     Result result = SUCCESS;
 
     if (successful) {
@@ -166,12 +166,18 @@ NameChangeUDPListener::receiveCompletionHandler(const bool successful,
         isc::util::InputBuffer input_buffer(callback->getData(),
                                             callback->getBytesTransferred());
 
+        // A datagram may carry several requests, one after the other.
         try {
-            ncr = NameChangeRequest::fromFormat(format_, input_buffer);
+            do {
+                ncrs.push_back(NameChangeRequest::fromFormat(format_,
+                                                             input_buffer));
+            } while (input_buffer.getPosition() < input_buffer.getLength());
         } catch (const NcrMessageError& ex) {
-            // log it and go back to listening
+            // log it and pass on the requests read before the invalid one.
             LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_INVALID_NCR).arg(ex.what());
+        }
 
+        if (ncrs.empty()) {
             // Queue up the next recieve.
             // NOTE: We must call the base class, NEVER doReceive
             receiveNext();
@@ -190,8 +196,12 @@ NameChangeUDPListener::receiveCompletionHandler(const bool successful,
         }
     }
 
+    if (ncrs.empty()) {
+        ncrs.push_back(NameChangeRequestPtr());
+    }
+
     // Call the application's registered request receive handler.
-    invokeRecvHandler(result, ncr);
+    invokeRecvHandler(result, ncrs);
 }
 
 
@@ -289,10 +299,26 @@ NameChangeUDPSender::close() {
 
 void
 NameChangeUDPSender::doSend(NameChangeRequestPtr& ncr) {
-    // Now use the NCR to write JSON to an output buffer.
+    // Now use the NCR to write its wire form to an output buffer.
     isc::util::OutputBuffer ncr_buffer(SEND_BUF_MAX);
     ncr->toFormat(format_, ncr_buffer);
 
+    // In the binary format, the requests queued behind this one are sent
+    // in the same datagram, as many as fit. JSON datagrams carry a single
+    // request, as listeners predating the batching read only the first one.
+    if (format_ == FMT_BINARY) {
+        size_t count = 1;
+        for (; count < getQueueSize(); ++count) {
+            const size_t length = ncr_buffer.getLength();
+            peekAt(count)->toFormat(format_, ncr_buffer);
+            if (ncr_buffer.getLength() > SEND_BUF_MAX) {
+                ncr_buffer.trim(ncr_buffer.getLength() - length);
+                break;
+            }
+        }
+        setSendCount(count);
+    }
+
     // Copy the wire-ized request to callback.  This way we know after
     // send completes what we sent (or attempted to send).
     send_callback_->putData(static_cast<const uint8_t*>(ncr_buffer.getData()),
@@ -333,8 +333,8 @@ public:
     ///
     /// @param ip_address is the network address on which to listen
     /// @param port is the UDP port on which to listen
-    /// @param format is the wire format of the inbound requests. Currently
-    /// only JSON is supported
+    /// @param format is the wire format of the inbound requests. Both
+    /// the JSON and binary requests are accepted whichever it is.
     /// @param ncr_recv_handler the receive handler object to notify when
     /// a receive completes.
     /// @param reuse_address enables IP address sharing when true
@@ -385,13 +385,14 @@ public:
     /// passing in the boolean success indicator and pointer to itself.
     ///
     /// If the indicator denotes success, then the method will attempt to
-    /// to construct a NameChangeRequest from the received data.  If the
-    /// construction was successful, it will send the new NCR to the
-    /// application layer by calling invokeRecvHandler() with a success
-    /// status and a pointer to the new NCR.
+    /// to construct the NameChangeRequests from the received data, which
+    /// may hold several of them one after the other.  It will then send the
+    /// new NCRs to the application layer by calling invokeRecvHandler() with
+    /// a success status and the list of the new NCRs.
     ///
     /// If the buffer contains invalid data such that construction fails,
-    /// the method will log the failure and then call doReceive() to start a
+    /// the method will log the failure and pass on the NCRs constructed
+    /// before the failure, if any, or else call doReceive() to start a
     /// initiate the next receive.
     ///
     /// If the indicator denotes failure the method will log the failure and
@@ -500,10 +501,12 @@ public:
     /// @brief Sends a given request asynchronously over the socket
     ///
     /// The given NameChangeRequest is converted to wire format and copied
-    /// into the send callback's transfer buffer.  Then the socket's
-    /// asyncSend() method is called, passing in send_callback_ member's
-    /// transfer buffer as the send buffer and the send_callback_ itself
-    /// as the callback object.
+    /// into the send callback's transfer buffer.  In the binary format, the
+    /// requests queued behind it are converted into the same buffer, as
+    /// many as fit in a datagram, so as they are sent together.  Then the
+    /// socket's asyncSend() method is called, passing in send_callback_
+    /// member's transfer buffer as the send buffer and the send_callback_
+    /// itself as the callback object.
     /// @param ncr NameChangeRequest to send.
     virtual void doSend(NameChangeRequestPtr& ncr);
 
@@ -620,6 +620,7 @@ public:
 
     std::vector<NameChangeRequestPtr> sent_ncrs_;
     std::vector<NameChangeRequestPtr> received_ncrs_;
+    std::vector<size_t> sent_queue_sizes_;
 
     NameChangeUDPTest()
         : io_service_(), recv_result_(NameChangeListener::SUCCESS),
@@ -641,9 +642,18 @@ public:
                           TEST_TIMEOUT);
     }
 
+    /// @brief Replaces the sender with one using the given format.
+    void createSender(const NameChangeFormat format) {
+        isc::asiolink::IOAddress addr(TEST_ADDRESS);
+        sender_.reset(
+            new NameChangeUDPSender(addr, SENDER_PORT, addr, LISTENER_PORT,
+                                    format, *this, 100, true));
+    }
+
     void reset_results() {
         sent_ncrs_.clear();
         received_ncrs_.clear();
+        sent_queue_sizes_.clear();
     }
 
     /// @brief Implements the receive completion handler.
@@ -657,9 +667,10 @@ public:
     /// @brief Implements the send completion handler.
     virtual void operator ()(const NameChangeSender::Result result,
                              NameChangeRequestPtr& ncr) {
-        // save the result and the NCR sent.
+        // save the result and the NCR sent, and the number of NCRs left.
         send_result_ = result;
         sent_ncrs_.push_back(ncr);
+        sent_queue_sizes_.push_back(sender_->getQueueSize());
     }
 
     // @brief Handler invoked when test timeout is hit.
@@ -724,6 +735,53 @@ TEST_F (NameChangeUDPTest, roundTripTest) {
     EXPECT_FALSE(sender_->amSending());
 }
 
+/// @brief Uses a binary sender and a listener to test batched NCR delivery
+/// Verifies that the binary sender sends the requests queued while a send
+/// is in progress in a single datagram, that the send handler is invoked
+/// for each of them, and that the listener, although configured for JSON,
+/// hands them all over in order.
+TEST_F (NameChangeUDPTest, binaryBatchTest) {
+    createSender(FMT_BINARY);
+
+    ASSERT_NO_THROW(listener_->startListening(io_service_));
+    ASSERT_NO_THROW(sender_->startSending(io_service_));
+
+    // The first request is sent right away, the others are queued behind
+    // it as no IO is run.
+    const int num_msgs = 30;
+    const int num_valid = sizeof(valid_msgs)/sizeof(char*);
+    for (int i = 0; i < num_msgs; i++) {
+        NameChangeRequestPtr ncr;
+        ASSERT_NO_THROW(ncr = NameChangeRequest::
+                        fromJSON(valid_msgs[i % num_valid]));
+        sender_->sendRequest(ncr);
+    }
+    EXPECT_EQ(num_msgs, sender_->getQueueSize());
+
+    // Execute callbacks until we have sent and received all of messages.
+    while (sender_->getQueueSize() > 0 || (received_ncrs_.size() < num_msgs)) {
+        EXPECT_NO_THROW(io_service_.run_one());
+    }
+
+    ASSERT_EQ(num_msgs, sent_ncrs_.size());
+    ASSERT_EQ(num_msgs, received_ncrs_.size());
+    for (int i = 0; i < num_msgs; i++) {
+        EXPECT_EQ(NameChangeSender::SUCCESS, send_result_);
+        EXPECT_TRUE (checkSendVsReceived(sent_ncrs_[i], received_ncrs_[i]));
+    }
+
+    // The first request was sent alone, and the rest together: all of them
+    // had left the queue when the handler was invoked for the second one.
+    EXPECT_EQ(num_msgs - 1, sent_queue_sizes_[0]);
+    for (int i = 1; i < num_msgs; i++) {
+        EXPECT_EQ(0, sent_queue_sizes_[i]) << "request idx: " << i;
+    }
+
+    EXPECT_NO_THROW(listener_->stopListening());
+    EXPECT_NO_THROW(io_service_.run_one());
+    EXPECT_NO_THROW(sender_->stopSending());
+}
+
 // Tests error handling of a failure to mark the watch socket ready, when
 // sendRequestt() is called.
 TEST(NameChangeUDPSenderBasicTest, watchClosedBeforeSendRequest) {
@@ -586,6 +586,104 @@ TEST(NameChangeRequestTest, toFromBufferTest) {
     ASSERT_EQ(final_str, msg_str);
 }
 
+/// @brief Tests converting to and from the binary format.
+/// This test verifies that:
+/// 1. Each valid request survives the round trip through the binary format
+/// 2. The binary requests are read whatever the format the reader expects,
+/// and so are the JSON ones
+/// 3. Several requests written one after the other to the same buffer, in
+/// either format, are read back in order
+TEST(NameChangeRequestTest, toFromBinaryTest) {
+    int num_msgs = sizeof(valid_msgs)/sizeof(char*);
+    std::vector<NameChangeRequestPtr> ncrs;
+    isc::util::OutputBuffer output_buffer(1024);
+    for (int i = 0; i < num_msgs; i++) {
+        NameChangeRequestPtr ncr;
+        ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[i]));
+        ncrs.push_back(ncr);
+
+        // Round trip through a buffer of its own, read as either format.
+        isc::util::OutputBuffer ncr_buffer(1024);
+        ASSERT_NO_THROW(ncr->toFormat(FMT_BINARY, ncr_buffer));
+        isc::util::InputBuffer binary_buffer(ncr_buffer.getData(),
+                                             ncr_buffer.getLength());
+        NameChangeRequestPtr ncr2;
+        ASSERT_NO_THROW(ncr2 = NameChangeRequest::fromFormat(FMT_BINARY,
+                                                             binary_buffer));
+        EXPECT_TRUE(*ncr == *ncr2) << "message idx: " << i;
+        EXPECT_EQ(ncr->toJSON(), ncr2->toJSON());
+
+        isc::util::InputBuffer json_buffer(ncr_buffer.getData(),
+                                           ncr_buffer.getLength());
+        ASSERT_NO_THROW(ncr2 = NameChangeRequest::fromFormat(FMT_JSON,
+                                                             json_buffer));
+        EXPECT_TRUE(*ncr == *ncr2) << "message idx: " << i;
+
+        // Alternate the formats in the shared buffer.
+        ASSERT_NO_THROW(ncr->toFormat(i % 2 ? FMT_JSON : FMT_BINARY,
+                                      output_buffer));
+    }
+
+    isc::util::InputBuffer input_buffer(output_buffer.getData(),
+                                        output_buffer.getLength());
+    for (int i = 0; i < num_msgs; i++) {
+        NameChangeRequestPtr ncr;
+        ASSERT_NO_THROW(ncr = NameChangeRequest::fromFormat(FMT_BINARY,
+                                                            input_buffer));
+        EXPECT_TRUE(*ncr == *ncrs[i]) << "message idx: " << i;
+    }
+    EXPECT_EQ(input_buffer.getLength(), input_buffer.getPosition());
+}
+
+/// @brief Tests that malformed binary requests are rejected.
+TEST(NameChangeRequestTest, invalidBinaryTest) {
+    NameChangeRequestPtr ncr;
+    ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[0]));
+    isc::util::OutputBuffer valid(1024);
+    ncr->toBinary(valid);
+    std::vector<uint8_t> wire(static_cast<const uint8_t*>(valid.getData()),
+                              static_cast<const uint8_t*>(valid.getData()) +
+                              valid.getLength());
+
+    // The valid rendition is accepted.
+    {
+        isc::util::InputBuffer buffer(&wire[0], wire.size());
+        EXPECT_NO_THROW(NameChangeRequest::fromBinary(buffer));
+    }
+
+    // Every truncation is rejected.
+    for (size_t len = 0; len < wire.size(); ++len) {
+        isc::util::InputBuffer buffer(&wire[0], len);
+        EXPECT_THROW(NameChangeRequest::fromBinary(buffer), NcrMessageError)
+            << "length: " << len;
+    }
+
+    // Trailing bytes are rejected.
+    {
+        std::vector<uint8_t> bad(wire);
+        bad.push_back(0);
+        isc::util::InputBuffer buffer(&bad[0], bad.size());
+        EXPECT_THROW(NameChangeRequest::fromBinary(buffer), NcrMessageError);
+    }
+
+    // Unsupported version, invalid change type and invalid address length
+    // are rejected.
+    const size_t offsets[] = { 0, 1, 3 };
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i) {
+        std::vector<uint8_t> bad(wire);
+        bad[offsets[i]] = 7;
+        isc::util::InputBuffer buffer(&bad[0], bad.size());
+        EXPECT_THROW(NameChangeRequest::fromBinary(buffer), NcrMessageError)
+            << "offset: " << offsets[i];
+    }
+
+    // An empty request is rejected by fromFormat.
+    const uint8_t empty[] = { 0, 0 };
+    isc::util::InputBuffer buffer(empty, sizeof(empty));
+    EXPECT_THROW(NameChangeRequest::fromFormat(FMT_BINARY, buffer),
+                 NcrMessageError);
+}
+
 /// @brief Tests ip address modification and validation
 TEST(NameChangeRequestTest, ipAddresses) {
     NameChangeRequest ncr;
@@ -612,9 +710,12 @@ TEST(NameChangeRequestTest, ipAddresses) {
 TEST(NameChangeFormatTest, formatEnumConversion){
     ASSERT_EQ(stringToNcrFormat("JSON"), dhcp_ddns::FMT_JSON);
     ASSERT_EQ(stringToNcrFormat("jSoN"), dhcp_ddns::FMT_JSON);
+    ASSERT_EQ(stringToNcrFormat("BINARY"), dhcp_ddns::FMT_BINARY);
+    ASSERT_EQ(stringToNcrFormat("Binary"), dhcp_ddns::FMT_BINARY);
     ASSERT_THROW(stringToNcrFormat("bogus"), isc::BadValue);
 
     ASSERT_EQ(ncrFormatToString(dhcp_ddns::FMT_JSON), "JSON");
+    ASSERT_EQ(ncrFormatToString(dhcp_ddns::FMT_BINARY), "BINARY");
 }
 
 /// @brief Tests conversion of NameChangeProtocol between enum and strings.
@@ -13,32 +13,53 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/lease_mgr_factory.h>
 
 #include <hooks/server_hooks.h>
 #include <hooks/hooks_manager.h>
 
+#include <boost/bind.hpp>
+
 #include <cstring>
+#include <limits>
 #include <vector>
 #include <string.h>
 
 using namespace isc::asiolink;
 using namespace isc::hooks;
+using namespace boost::posix_time;
+using isc::util::thread::Mutex;
 
 namespace {
 
-/// Structure that holds registered hook indexes
+/// Structure that holds registered hook and callout argument indexes
 struct AllocEngineHooks {
     int hook_index_lease4_select_; ///< index for "lease4_receive" hook point
     int hook_index_lease4_renew_;  ///< index for "lease4_renew" hook point
     int hook_index_lease6_select_; ///< index for "lease6_receive" hook point
-
-    /// Constructor that registers hook points for AllocationEngine
+    int arg_index_subnet4_;         ///< index of the "subnet4" argument
+    int arg_index_subnet6_;         ///< index of the "subnet6" argument
+    int arg_index_clientid_;        ///< index of the "clientid" argument
+    int arg_index_hwaddr_;          ///< index of the "hwaddr" argument
+    int arg_index_fake_allocation_; ///< index of the "fake_allocation" argument
+    int arg_index_lease4_;          ///< index of the "lease4" argument
+    int arg_index_lease6_;          ///< index of the "lease6" argument
+
+    /// Constructor that registers hooks and arguments for AllocationEngine
     AllocEngineHooks() {
         hook_index_lease4_select_ = HooksManager::registerHook("lease4_select");
         hook_index_lease4_renew_  = HooksManager::registerHook("lease4_renew");
         hook_index_lease6_select_ = HooksManager::registerHook("lease6_select");
+
+        arg_index_subnet4_         = HooksManager::registerArgument("subnet4");
+        arg_index_subnet6_         = HooksManager::registerArgument("subnet6");
+        arg_index_clientid_        = HooksManager::registerArgument("clientid");
+        arg_index_hwaddr_          = HooksManager::registerArgument("hwaddr");
+        arg_index_fake_allocation_ = HooksManager::registerArgument("fake_allocation");
+        arg_index_lease4_          = HooksManager::registerArgument("lease4");
+        arg_index_lease6_          = HooksManager::registerArgument("lease6");
     }
 };
 
@@ -217,36 +238,188 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
     return (next);
 }
 
-AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
+namespace {
+
+/// @brief Returns the type of the IPv4 lease.
+Lease::Type
+getLeaseType(const Lease4Ptr&) {
+    return (Lease::TYPE_V4);
+}
+
+/// @brief Returns the type of the IPv6 lease.
+Lease::Type
+getLeaseType(const Lease6Ptr& lease) {
+    return (lease->type_);
+}
+
+/// @brief Checks whether the IPv4 lease is still expired in the database.
+bool
+isStillExpired(const Lease4Ptr& lease) {
+    Lease4Ptr current = LeaseMgrFactory::instance().getLease4(lease->addr_);
+    return (current && current->expired());
+}
+
+/// @brief Checks whether the IPv6 lease is still expired in the database.
+bool
+isStillExpired(const Lease6Ptr& lease) {
+    Lease6Ptr current = LeaseMgrFactory::instance().getLease6(lease->type_,
+                                                              lease->addr_);
+    return (current && current->expired());
+}
+
+/// @brief Collection of the held locks.
+typedef std::vector<boost::shared_ptr<Mutex::Locker> > LockerCollection;
+
+/// @brief Computes the 64-bit FNV-1a hash of the data.
+///
+/// @param data data to be hashed
+/// @return hash value
+uint64_t
+fnv1aHash(const std::vector<uint8_t>& data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::vector<uint8_t>::const_iterator it = data.begin();
+         it != data.end(); ++it) {
+        hash ^= *it;
+        hash *= 1099511628211ULL;
+    }
+    return (hash);
+}
+
+/// @brief Marks the addresses of the leases which haven't expired as used.
+///
+/// The addresses of the expired leases are left free, so as the allocation
+/// engine may reuse them.
+///
+/// @param pool pool with the tracked usage
+/// @param leases leases for the addresses of the pool
+template<typename LeaseCollection>
+void
+markUnexpiredUsed(const PoolPtr& pool, const LeaseCollection& leases) {
+    for (typename LeaseCollection::const_iterator lease = leases.begin();
+         lease != leases.end(); ++lease) {
+        if (!(*lease)->expired()) {
+            pool->markUsed((*lease)->addr_);
+        }
+    }
+}
+
+}; // anonymous namespace
+
+AllocEngine::PositionalAllocator::PositionalAllocator(Lease::Type lease_type)
     :Allocator(lease_type) {
-    isc_throw(NotImplemented, "Hashed allocator is not implemented");
 }
 
+isc::asiolink::IOAddress
+AllocEngine::PositionalAllocator::getAddress(const PoolCollection& pools,
+                                             uint64_t position) {
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        const uint64_t pool_capacity = (*pool)->getCapacity();
+        if (position < pool_capacity) {
+            return ((*pool)->getAddress(position));
+        }
+        position -= pool_capacity;
+    }
+    isc_throw(BadValue, "position is out of range of the pools");
+}
+
+uint64_t
+AllocEngine::PositionalAllocator::getMaxProbes() const {
+    return (std::numeric_limits<uint64_t>::max());
+}
 
 isc::asiolink::IOAddress
-AllocEngine::HashedAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
-                                          const IOAddress&) {
-    isc_throw(NotImplemented, "Hashed allocator is not implemented");
+AllocEngine::PositionalAllocator::pickAddress(const SubnetPtr& subnet,
+                                              const DuidPtr& duid,
+                                              const IOAddress& hint) {
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+    if (pools.empty()) {
+        isc_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+    const uint64_t capacity = subnet->getPoolCapacity(pool_type_);
+
+    std::vector<uint8_t> client;
+    if (duid) {
+        client = duid->getDuid();
+    }
+
+    Mutex::Locker locker(mutex_);
+    std::map<SubnetID, Walk>::iterator walk = walks_.find(subnet->getID());
+    if (walk == walks_.end()) {
+        walk = walks_.insert(std::make_pair(subnet->getID(),
+                                            Walk(IOAddress(pool_type_ ==
+                                                           Lease::TYPE_V4 ?
+                                                           "0.0.0.0" : "::"))))
+            .first;
+    }
+
+    // Continue the walk if the engine has rejected the previously returned
+    // address for the same client. Otherwise, start from a new position.
+    if ((hint == walk->second.last_address_) &&
+        (client == walk->second.last_client_) &&
+        (walk->second.last_position_ < capacity) &&
+        (walk->second.probes_ < getMaxProbes())) {
+        walk->second.last_position_ =
+            (walk->second.last_position_ + 1) % capacity;
+        ++walk->second.probes_;
+    } else {
+        walk->second.last_client_.swap(client);
+        walk->second.last_position_ = getStartPosition(duid, capacity);
+        walk->second.probes_ = 1;
+    }
+    walk->second.last_address_ = getAddress(pools,
+                                            walk->second.last_position_);
+    return (walk->second.last_address_);
 }
 
+AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
+    :PositionalAllocator(lease_type) {
+}
+
+uint64_t
+AllocEngine::HashedAllocator::getStartPosition(const DuidPtr& duid,
+                                               uint64_t capacity) {
+    if (!duid) {
+        return (0);
+    }
+    return (fnv1aHash(duid->getDuid()) % capacity);
+}
+
+const uint64_t AllocEngine::RandomAllocator::MAX_PROBES;
+
 AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type)
-    :Allocator(lease_type) {
-    isc_throw(NotImplemented, "Random allocator is not implemented");
+    :PositionalAllocator(lease_type) {
+    rng_.seed(static_cast<uint32_t>(time(NULL)));
 }
 
+uint64_t
+AllocEngine::RandomAllocator::getStartPosition(const DuidPtr&,
+                                               uint64_t capacity) {
+    const uint64_t random = (static_cast<uint64_t>(rng_()) << 32) | rng_();
+    return (random % capacity);
+}
 
-isc::asiolink::IOAddress
-AllocEngine::RandomAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
-                                          const IOAddress&) {
-    isc_throw(NotImplemented, "Random allocator is not implemented");
+uint64_t
+AllocEngine::RandomAllocator::getMaxProbes() const {
+    return (MAX_PROBES);
 }
 
+AllocEngine::AllocType
+AllocEngine::allocTypeFromText(const std::string& alloc_type) {
+    if (alloc_type == "iterative") {
+        return (ALLOC_ITERATIVE);
+    } else if (alloc_type == "hashed") {
+        return (ALLOC_HASHED);
+    } else if (alloc_type == "random") {
+        return (ALLOC_RANDOM);
+    }
+    isc_throw(BadValue, "unsupported allocation type '" << alloc_type
+              << "', expected one of: iterative, hashed, random");
+}
 
 AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
                          bool ipv6)
-    :attempts_(attempts) {
+    :attempts_(attempts), track_pool_usage_(false) {
 
     // Choose the basic (normal address) lease type
     Lease::Type basic_type = ipv6 ? Lease::TYPE_NA : Lease::TYPE_V4;
@@ -299,7 +472,8 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                              const bool rev_dns_update,
                              const std::string& hostname, bool fake_allocation,
                              const isc::hooks::CalloutHandlePtr& callout_handle,
-                             Lease6Collection& old_leases) {
+                             Lease6Collection& old_leases,
+                             const LeaseCommitPtr& commit) {
 
     try {
         AllocatorPtr allocator = getAllocator(type);
@@ -317,19 +491,34 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
             isc_throw(InvalidOperation, "DUID is mandatory for allocation");
         }
 
+        // The allocations in the same subnet are serialized, as they share
+        // the state of the allocator and the usage of the pools.
+        Mutex::Locker locker(subnet->getAllocationMutex());
+
         // Check if there's existing lease for that subnet/duid/iaid
         // combination.
         /// @todo: Make this generic (cover temp. addrs and prefixes)
         Lease6Collection existing = LeaseMgrFactory::instance().getLeases6(type,
                                     *duid, iaid, subnet->getID());
 
+        // The lease which is being committed may have been reused for
+        // another client, so it isn't returned to the client.
+        for (Lease6Collection::iterator lease = existing.begin();
+             lease != existing.end(); ) {
+            if (isUncommitted((*lease)->addr_)) {
+                lease = existing.erase(lease);
+            } else {
+                ++lease;
+            }
+        }
+
         // There is at least one lease for this client. We will return these
         // leases for the client, but we may need to update FQDN information.
         if (!existing.empty()) {
             // Return old leases so the server can see what has changed.
             old_leases = existing;
             return (updateFqdnData(existing, fwd_dns_update, rev_dns_update,
-                                   hostname, fake_allocation));
+                                   hostname, fake_allocation, commit));
         }
 
         // check if the hint is in pool and is available
@@ -337,7 +526,7 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
         Pool6Ptr pool = boost::dynamic_pointer_cast<
             Pool6>(subnet->getPool(type, hint, false));
 
-        if (pool) {
+        if (pool && !isUncommitted(hint)) {
             /// @todo: We support only one hint for now
             Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(type, hint);
             if (!lease) {
@@ -349,7 +538,8 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 lease = createLease6(subnet, duid, iaid, hint,
                                      pool->getLength(), type,
                                      fwd_dns_update, rev_dns_update,
-                                     hostname, callout_handle, fake_allocation);
+                                     hostname, callout_handle, fake_allocation,
+                                     commit);
 
                 // It can happen that the lease allocation failed (we could
                 // have lost the race condition. That means that the hint is
@@ -377,7 +567,7 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                                               pool->getLength(),
                                               fwd_dns_update, rev_dns_update,
                                               hostname, callout_handle,
-                                              fake_allocation);
+                                              fake_allocation, commit);
 
                     /// @todo: We support only one lease per ia for now
                     Lease6Collection collection;
@@ -405,8 +595,24 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // moment, but we currently do not control expiration time at all
 
         unsigned int i = attempts_;
+        IOAddress candidate = hint;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, duid, hint);
+            // The previously rejected candidate is passed to the allocator,
+            // so as it can continue its walk over the pools.
+            candidate = allocator->pickAddress(subnet, duid, candidate);
+
+            // Skip the addresses which are known to be in use.
+            PoolPtr tracked_pool = getTrackedPool(subnet, type, candidate);
+            if (tracked_pool) {
+                tracked_pool->findFreeAddress(candidate, candidate);
+            }
+
+            // The address of the lease which is being committed for another
+            // client is skipped.
+            if (isUncommitted(candidate)) {
+                --i;
+                continue;
+            }
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
@@ -430,7 +636,8 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 Lease6Ptr lease = createLease6(subnet, duid, iaid, candidate,
                                                prefix_len, type, fwd_dns_update,
                                                rev_dns_update, hostname,
-                                               callout_handle, fake_allocation);
+                                               callout_handle, fake_allocation,
+                                               commit);
                 if (lease) {
                     // We are allocating a new lease (not renewing). So, the
                     // old lease should be NULL.
@@ -454,11 +661,18 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     existing = reuseExpiredLease(existing, subnet, duid, iaid,
                                                  prefix_len, fwd_dns_update,
                                                  rev_dns_update, hostname,
-                                                 callout_handle, fake_allocation);
+                                                 callout_handle, fake_allocation,
+                                                 commit);
                     Lease6Collection collection;
                     collection.push_back(existing);
                     return (collection);
                 }
+
+                // The lease has been added by someone else since the usage
+                // of the pool was collected.
+                if (tracked_pool) {
+                    tracked_pool->markUsed(candidate);
+                }
             }
 
             // Continue trying allocation until we run out of attempts
@@ -484,7 +698,8 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                             const bool fwd_dns_update, const bool rev_dns_update,
                             const std::string& hostname, bool fake_allocation,
                             const isc::hooks::CalloutHandlePtr& callout_handle,
-                            Lease4Ptr& old_lease) {
+                            Lease4Ptr& old_lease,
+                            const LeaseCommitPtr& commit) {
 
     // The NULL pointer indicates that the old lease didn't exist. It may
     // be later set to non NULL value if existing lease is found in the
@@ -509,16 +724,23 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
             isc_throw(InvalidOperation, "HWAddr must be defined");
         }
 
+        // The allocations in the same subnet are serialized, as they share
+        // the state of the allocator and the usage of the pools.
+        Mutex::Locker locker(subnet->getAllocationMutex());
+
         // Check if there's existing lease for that subnet/clientid/hwaddr combination.
+        // The lease which is being committed may have been reused for another
+        // client, so it isn't renewed.
         Lease4Ptr existing = LeaseMgrFactory::instance().getLease4(*hwaddr, subnet->getID());
-        if (existing) {
+        if (existing && !isUncommitted(existing->addr_)) {
             // Save the old lease, before renewal.
             old_lease.reset(new Lease4(*existing));
             // We have a lease already. This is a returning client, probably after
             // its reboot.
             existing = renewLease4(subnet, clientid, hwaddr,
                                    fwd_dns_update, rev_dns_update, hostname,
-                                   existing, callout_handle, fake_allocation);
+                                   existing, callout_handle, fake_allocation,
+                                   commit);
             if (existing) {
                 return (existing);
             }
@@ -529,7 +751,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
 
         if (clientid) {
             existing = LeaseMgrFactory::instance().getLease4(*clientid, subnet->getID());
-            if (existing) {
+            if (existing && !isUncommitted(existing->addr_)) {
                 // Save the old lease before renewal.
                 old_lease.reset(new Lease4(*existing));
                 // we have a lease already. This is a returning client, probably after
@@ -537,7 +759,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 existing = renewLease4(subnet, clientid, hwaddr,
                                        fwd_dns_update, rev_dns_update,
                                        hostname, existing, callout_handle,
-                                       fake_allocation);
+                                       fake_allocation, commit);
                 // @todo: produce a warning. We haven't found him using MAC address, but
                 // we found him using client-id
                 if (existing) {
@@ -547,7 +769,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
         }
 
         // check if the hint is in pool and is available
-        if (subnet->inPool(Lease::TYPE_V4, hint)) {
+        if (subnet->inPool(Lease::TYPE_V4, hint) && !isUncommitted(hint)) {
             existing = LeaseMgrFactory::instance().getLease4(hint);
             if (!existing) {
                 /// @todo: Check if the hint is reserved once we have host support
@@ -557,7 +779,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 Lease4Ptr lease = createLease4(subnet, clientid, hwaddr, hint,
                                                fwd_dns_update, rev_dns_update,
                                                hostname, callout_handle,
-                                               fake_allocation);
+                                               fake_allocation, commit);
 
                 // It can happen that the lease allocation failed (we could have lost
                 // the race condition. That means that the hint is lo longer usable and
@@ -572,7 +794,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                     return (reuseExpiredLease(existing, subnet, clientid, hwaddr,
                                               fwd_dns_update, rev_dns_update,
                                               hostname, callout_handle,
-                                              fake_allocation));
+                                              fake_allocation, commit));
                 }
 
             }
@@ -594,9 +816,34 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
         // left), but this has one major problem. We exactly control allocation
         // moment, but we currently do not control expiration time at all
 
+        // The allocators key the client by its identifier. The clients
+        // which don't send the client identifier option are keyed by their
+        // hardware address instead.
+        DuidPtr client_key = clientid;
+        if (!client_key && hwaddr && !hwaddr->hwaddr_.empty()) {
+            client_key.reset(new DUID(hwaddr->hwaddr_));
+        }
+
         unsigned int i = attempts_;
+        IOAddress candidate = hint;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, clientid, hint);
+            // The previously rejected candidate is passed to the allocator,
+            // so as it can continue its walk over the pools.
+            candidate = allocator->pickAddress(subnet, client_key, candidate);
+
+            // Skip the addresses which are known to be in use.
+            PoolPtr tracked_pool = getTrackedPool(subnet, Lease::TYPE_V4,
+                                                  candidate);
+            if (tracked_pool) {
+                tracked_pool->findFreeAddress(candidate, candidate);
+            }
+
+            // The address of the lease which is being committed for another
+            // client is skipped.
+            if (isUncommitted(candidate)) {
+                --i;
+                continue;
+            }
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
@@ -608,7 +855,8 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 Lease4Ptr lease = createLease4(subnet, clientid, hwaddr,
                                                candidate, fwd_dns_update,
                                                rev_dns_update, hostname,
-                                               callout_handle, fake_allocation);
+                                               callout_handle, fake_allocation,
+                                               commit);
                 if (lease) {
                     return (lease);
                 }
@@ -623,7 +871,13 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                     return (reuseExpiredLease(existing, subnet, clientid, hwaddr,
                                               fwd_dns_update, rev_dns_update,
                                               hostname, callout_handle,
-                                              fake_allocation));
+                                              fake_allocation, commit));
+                }
+
+                // The lease has been added by someone else since the usage
+                // of the pool was collected.
+                if (tracked_pool) {
+                    tracked_pool->markUsed(candidate);
                 }
             }
 
@@ -651,7 +905,8 @@ Lease4Ptr AllocEngine::renewLease4(const SubnetPtr& subnet,
                                    const std::string& hostname,
                                    const Lease4Ptr& lease,
                                    const isc::hooks::CalloutHandlePtr& callout_handle,
-                                   bool fake_allocation /* = false */) {
+                                   bool fake_allocation /* = false */,
+                                   const LeaseCommitPtr& commit) {
 
     if (!lease) {
         isc_throw(InvalidOperation, "Lease4 must be specified");
@@ -688,12 +943,12 @@ Lease4Ptr AllocEngine::renewLease4(const SubnetPtr& subnet,
         Subnet4Ptr subnet4 = boost::dynamic_pointer_cast<Subnet4>(subnet);
 
         // Pass the parameters
-        callout_handle->setArgument("subnet4", subnet4);
-        callout_handle->setArgument("clientid", clientid);
-        callout_handle->setArgument("hwaddr", hwaddr);
+        callout_handle->setArgument(Hooks.arg_index_subnet4_, subnet4);
+        callout_handle->setArgument(Hooks.arg_index_clientid_, clientid);
+        callout_handle->setArgument(Hooks.arg_index_hwaddr_, hwaddr);
 
         // Pass the lease to be updated
-        callout_handle->setArgument("lease4", lease);
+        callout_handle->setArgument(Hooks.arg_index_lease4_, lease);
 
         // Call all installed callouts
         HooksManager::callCallouts(Hooks.hook_index_lease4_renew_, *callout_handle);
@@ -709,7 +964,7 @@ Lease4Ptr AllocEngine::renewLease4(const SubnetPtr& subnet,
 
     if (!fake_allocation && !skip) {
         // for REQUEST we do update the lease
-        LeaseMgrFactory::instance().updateLease4(lease);
+        writeLease(LeaseWrite(LeaseWrite::UPDATE, lease), commit);
     }
     if (skip) {
         // Rollback changes (really useful only for memfile)
@@ -729,12 +984,17 @@ Lease6Ptr AllocEngine::reuseExpiredLease(Lease6Ptr& expired,
                                          const bool rev_dns_update,
                                          const std::string& hostname,
                                          const isc::hooks::CalloutHandlePtr& callout_handle,
-                                         bool fake_allocation /*= false */ ) {
+                                         bool fake_allocation /*= false */,
+                                         const LeaseCommitPtr& commit) {
 
     if (!expired->expired()) {
         isc_throw(BadValue, "Attempt to recycle lease that is still valid");
     }
 
+    // The expired lease doesn't hold the address any more. It is marked
+    // used again below if the lease is reused.
+    markPoolFreeInternal(subnet, expired->type_, expired->addr_);
+
     if (expired->type_ != Lease::TYPE_PD) {
         prefix_len = 128; // non-PD lease types must be always /128
     }
@@ -766,13 +1026,13 @@ Lease6Ptr AllocEngine::reuseExpiredLease(Lease6Ptr& expired,
 
         // Pass necessary arguments
         // Subnet from which we do the allocation
-        callout_handle->setArgument("subnet6", subnet);
+        callout_handle->setArgument(Hooks.arg_index_subnet6_, subnet);
 
         // Is this solicit (fake = true) or request (fake = false)
-        callout_handle->setArgument("fake_allocation", fake_allocation);
+        callout_handle->setArgument(Hooks.arg_index_fake_allocation_, fake_allocation);
 
         // The lease that will be assigned to a client
-        callout_handle->setArgument("lease6", expired);
+        callout_handle->setArgument(Hooks.arg_index_lease6_, expired);
 
         // Call the callouts
         HooksManager::callCallouts(hook_index_lease6_select_, *callout_handle);
@@ -787,12 +1047,13 @@ Lease6Ptr AllocEngine::reuseExpiredLease(Lease6Ptr& expired,
 
         // Let's use whatever callout returned. Hopefully it is the same lease
         // we handled to it.
-        callout_handle->getArgument("lease6", expired);
+        callout_handle->getArgument(Hooks.arg_index_lease6_, expired);
     }
 
     if (!fake_allocation) {
         // for REQUEST we do update the lease
-        LeaseMgrFactory::instance().updateLease6(expired);
+        writeLease(LeaseWrite(LeaseWrite::UPDATE, expired), commit);
+        markPoolUsed(subnet, expired->type_, expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -811,12 +1072,17 @@ Lease4Ptr AllocEngine::reuseExpiredLease(Lease4Ptr& expired,
                                          const bool rev_dns_update,
                                          const std::string& hostname,
                                          const isc::hooks::CalloutHandlePtr& callout_handle,
-                                         bool fake_allocation /*= false */ ) {
+                                         bool fake_allocation /*= false */,
+                                         const LeaseCommitPtr& commit) {
 
     if (!expired->expired()) {
         isc_throw(BadValue, "Attempt to recycle lease that is still valid");
     }
 
+    // The expired lease doesn't hold the address any more. It is marked
+    // used again below if the lease is reused.
+    markPoolFreeInternal(subnet, Lease::TYPE_V4, expired->addr_);
+
     // address, lease type and prefixlen (0) stay the same
     expired->client_id_ = clientid;
     expired->hwaddr_ = hwaddr->hwaddr_;
@@ -847,13 +1113,13 @@ Lease4Ptr AllocEngine::reuseExpiredLease(Lease4Ptr& expired,
         // boost smart pointers here, we need to do the cast using the boost
         // version of dynamic_pointer_cast.
         Subnet4Ptr subnet4 = boost::dynamic_pointer_cast<Subnet4>(subnet);
-        callout_handle->setArgument("subnet4", subnet4);
+        callout_handle->setArgument(Hooks.arg_index_subnet4_, subnet4);
 
         // Is this solicit (fake = true) or request (fake = false)
-        callout_handle->setArgument("fake_allocation", fake_allocation);
+        callout_handle->setArgument(Hooks.arg_index_fake_allocation_, fake_allocation);
 
         // The lease that will be assigned to a client
-        callout_handle->setArgument("lease4", expired);
+        callout_handle->setArgument(Hooks.arg_index_lease4_, expired);
 
         // Call the callouts
         HooksManager::callCallouts(hook_index_lease6_select_, *callout_handle);
@@ -868,12 +1134,13 @@ Lease4Ptr AllocEngine::reuseExpiredLease(Lease4Ptr& expired,
 
         // Let's use whatever callout returned. Hopefully it is the same lease
         // we handled to it.
-        callout_handle->getArgument("lease4", expired);
+        callout_handle->getArgument(Hooks.arg_index_lease4_, expired);
     }
 
     if (!fake_allocation) {
         // for REQUEST we do update the lease
-        LeaseMgrFactory::instance().updateLease4(expired);
+        writeLease(LeaseWrite(LeaseWrite::UPDATE, expired), commit);
+        markPoolUsed(subnet, Lease::TYPE_V4, expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -894,7 +1161,8 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
                                     const bool rev_dns_update,
                                     const std::string& hostname,
                                     const isc::hooks::CalloutHandlePtr& callout_handle,
-                                    bool fake_allocation /*= false */ ) {
+                                    bool fake_allocation /*= false */,
+                                    const LeaseCommitPtr& commit) {
 
     if (type != Lease::TYPE_PD) {
         prefix_len = 128; // non-PD lease types must be always /128
@@ -919,11 +1187,11 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
         // Pass necessary arguments
 
         // Subnet from which we do the allocation
-        callout_handle->setArgument("subnet6", subnet);
+        callout_handle->setArgument(Hooks.arg_index_subnet6_, subnet);
 
         // Is this solicit (fake = true) or request (fake = false)
-        callout_handle->setArgument("fake_allocation", fake_allocation);
-        callout_handle->setArgument("lease6", lease);
+        callout_handle->setArgument(Hooks.arg_index_fake_allocation_, fake_allocation);
+        callout_handle->setArgument(Hooks.arg_index_lease6_, lease);
 
         // This is the first callout, so no need to clear any arguments
         HooksManager::callCallouts(hook_index_lease6_select_, *callout_handle);
@@ -938,15 +1206,15 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
 
         // Let's use whatever callout returned. Hopefully it is the same lease
         // we handled to it.
-        callout_handle->getArgument("lease6", lease);
+        callout_handle->getArgument(Hooks.arg_index_lease6_, lease);
     }
 
     if (!fake_allocation) {
         // That is a real (REQUEST) allocation
-        bool status = LeaseMgrFactory::instance().addLease(lease);
+        bool status = writeLease(LeaseWrite(LeaseWrite::ADD, lease), commit);
 
         if (status) {
-
+            markPoolUsed(subnet, type, addr);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -978,7 +1246,8 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
                                     const bool rev_dns_update,
                                     const std::string& hostname,
                                     const isc::hooks::CalloutHandlePtr& callout_handle,
-                                    bool fake_allocation /*= false */ ) {
+                                    bool fake_allocation /*= false */,
+                                    const LeaseCommitPtr& commit) {
     if (!hwaddr) {
         isc_throw(BadValue, "Can't create a lease with NULL HW address");
     }
@@ -1014,13 +1283,13 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
         // be confused with dynamic_pointer_casts. They should get a concrete
         // pointer (Subnet4Ptr) pointing to a Subnet4 object.
         Subnet4Ptr subnet4 = boost::dynamic_pointer_cast<Subnet4>(subnet);
-        callout_handle->setArgument("subnet4", subnet4);
+        callout_handle->setArgument(Hooks.arg_index_subnet4_, subnet4);
 
         // Is this solicit (fake = true) or request (fake = false)
-        callout_handle->setArgument("fake_allocation", fake_allocation);
+        callout_handle->setArgument(Hooks.arg_index_fake_allocation_, fake_allocation);
 
         // Pass the intended lease as well
-        callout_handle->setArgument("lease4", lease);
+        callout_handle->setArgument(Hooks.arg_index_lease4_, lease);
 
         // This is the first callout, so no need to clear any arguments
         HooksManager::callCallouts(hook_index_lease4_select_, *callout_handle);
@@ -1035,13 +1304,14 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
 
         // Let's use whatever callout returned. Hopefully it is the same lease
         // we handled to it.
-        callout_handle->getArgument("lease4", lease);
+        callout_handle->getArgument(Hooks.arg_index_lease4_, lease);
     }
 
     if (!fake_allocation) {
         // That is a real (REQUEST) allocation
-        bool status = LeaseMgrFactory::instance().addLease(lease);
+        bool status = writeLease(LeaseWrite(LeaseWrite::ADD, lease), commit);
         if (status) {
+            markPoolUsed(subnet, Lease::TYPE_V4, addr);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -1069,7 +1339,8 @@ AllocEngine::updateFqdnData(const Lease6Collection& leases,
                             const bool fwd_dns_update,
                             const bool rev_dns_update,
                             const std::string& hostname,
-                            const bool fake_allocation) {
+                            const bool fake_allocation,
+                            const LeaseCommitPtr& commit) {
     Lease6Collection updated_leases;
     for (Lease6Collection::const_iterator lease_it = leases.begin();
          lease_it != leases.end(); ++lease_it) {
@@ -1081,13 +1352,64 @@ AllocEngine::updateFqdnData(const Lease6Collection& leases,
             ((lease->fqdn_fwd_ != (*lease_it)->fqdn_fwd_) ||
              (lease->fqdn_rev_ != (*lease_it)->fqdn_rev_) ||
              (lease->hostname_ != (*lease_it)->hostname_))) {
-            LeaseMgrFactory::instance().updateLease6(lease);
+            writeLease(LeaseWrite(LeaseWrite::UPDATE, lease), commit);
         }
         updated_leases.push_back(lease);
     }
     return (updated_leases);
 }
 
+bool
+AllocEngine::writeLease(const LeaseWrite& write,
+                        const LeaseCommitPtr& commit) {
+    if (!commit) {
+        if (write.type_ == LeaseWrite::ADD) {
+            return (write.lease4_ ?
+                    LeaseMgrFactory::instance().addLease(write.lease4_) :
+                    LeaseMgrFactory::instance().addLease(write.lease6_));
+        }
+        if (write.lease4_) {
+            LeaseMgrFactory::instance().updateLease4(write.lease4_);
+        } else {
+            LeaseMgrFactory::instance().updateLease6(write.lease6_);
+        }
+        return (true);
+    }
+
+    {
+        Mutex::Locker locker(uncommitted_mutex_);
+        uncommitted_.insert(write.addr_);
+    }
+    if (commit->submit(write, boost::bind(&AllocEngine::writeCommitted, this,
+                                          _1))) {
+        return (true);
+    }
+
+    // The write has been rejected, e.g. because the lease database can't
+    // keep up with the allocations.
+    writeCommitted(write);
+    if (write.type_ == LeaseWrite::ADD) {
+        return (false);
+    }
+    isc_throw(DbOperationError, "unable to submit the update of the lease for"
+              " address " << write.addr_);
+}
+
+void
+AllocEngine::writeCommitted(const LeaseWrite& write) {
+    Mutex::Locker locker(uncommitted_mutex_);
+    std::multiset<IOAddress>::iterator addr = uncommitted_.find(write.addr_);
+    if (addr != uncommitted_.end()) {
+        uncommitted_.erase(addr);
+    }
+}
+
+bool
+AllocEngine::isUncommitted(const IOAddress& addr) const {
+    Mutex::Locker locker(uncommitted_mutex_);
+    return (!uncommitted_.empty() && (uncommitted_.count(addr) > 0));
+}
+
 AllocEngine::AllocatorPtr AllocEngine::getAllocator(Lease::Type type) {
     std::map<Lease::Type, AllocatorPtr>::const_iterator alloc = allocators_.find(type);
 
@@ -1098,6 +1420,269 @@ AllocEngine::AllocatorPtr AllocEngine::getAllocator(Lease::Type type) {
     return (alloc->second);
 }
 
+void
+AllocEngine::setPoolTracking(bool track) {
+    // The bitmaps are not maintained while the tracking is disabled.
+    const bool rebuild = !track_pool_usage_;
+    track_pool_usage_ = track;
+    if (!track) {
+        return;
+    }
+
+    for (std::map<Lease::Type, AllocatorPtr>::const_iterator alloc =
+             allocators_.begin(); alloc != allocators_.end(); ++alloc) {
+        if (alloc->first == Lease::TYPE_V4) {
+            const Subnet4Collection* subnets =
+                CfgMgr::instance().getSubnets4();
+            for (Subnet4Collection::const_iterator subnet = subnets->begin();
+                 subnet != subnets->end(); ++subnet) {
+                initPoolUsage(*subnet, alloc->first, rebuild);
+            }
+        } else {
+            const Subnet6Collection* subnets =
+                CfgMgr::instance().getSubnets6();
+            for (Subnet6Collection::const_iterator subnet = subnets->begin();
+                 subnet != subnets->end(); ++subnet) {
+                initPoolUsage(*subnet, alloc->first, rebuild);
+            }
+        }
+    }
+}
+
+void
+AllocEngine::initPoolUsage(const SubnetPtr& subnet, Lease::Type type,
+                           const bool rebuild) {
+    Mutex::Locker locker(subnet->getAllocationMutex());
+
+    const PoolCollection& pools = subnet->getPools(type);
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        if ((!rebuild && (*pool)->isUsageTracked()) ||
+            ((*pool)->getCapacity() > Pool::MAX_TRACKED_CAPACITY)) {
+            continue;
+        }
+
+        (*pool)->initUsage();
+        if (type == Lease::TYPE_V4) {
+            markUnexpiredUsed(*pool, LeaseMgrFactory::instance().
+                              getLeases4((*pool)->getFirstAddress(),
+                                         (*pool)->getLastAddress()));
+        } else {
+            markUnexpiredUsed(*pool, LeaseMgrFactory::instance().
+                              getLeases6(type, (*pool)->getFirstAddress(),
+                                         (*pool)->getLastAddress()));
+        }
+
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_POOL_USAGE_INIT)
+            .arg((*pool)->toText()).arg((*pool)->getUsedCount())
+            .arg((*pool)->getCapacity());
+    }
+}
+
+PoolPtr
+AllocEngine::getTrackedPool(const SubnetPtr& subnet, Lease::Type type,
+                            const isc::asiolink::IOAddress& addr) {
+    if (!track_pool_usage_) {
+        return (PoolPtr());
+    }
+
+    PoolPtr pool = subnet->getPool(type, addr, false);
+    if (!pool || !pool->isUsageTracked()) {
+        return (PoolPtr());
+    }
+    return (pool);
+}
+
+void
+AllocEngine::markPoolUsed(const SubnetPtr& subnet, Lease::Type type,
+                          const isc::asiolink::IOAddress& addr) {
+    if (!track_pool_usage_) {
+        return;
+    }
+    PoolPtr pool = subnet->getPool(type, addr, false);
+    if (pool) {
+        pool->markUsed(addr);
+    }
+}
+
+AllocEngine::ReclamationStats
+AllocEngine::reclaimExpiredLeases4(const size_t max_leases,
+                                   const uint32_t timeout,
+                                   const Lease4ReclaimCallback& callback) {
+    const ptime start = microsec_clock::universal_time();
+    Lease4Collection leases;
+    LeaseMgrFactory::instance().getExpiredLeases4(leases, max_leases);
+    ReclamationStats stats = reclaimLeases(leases, timeout, callback, start);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_RECLAIM_LEASES4_COMPLETE)
+        .arg(stats.reclaimed_).arg(stats.duration_);
+    return (stats);
+}
+
+AllocEngine::ReclamationStats
+AllocEngine::reclaimExpiredLeases6(const size_t max_leases,
+                                   const uint32_t timeout,
+                                   const Lease6ReclaimCallback& callback) {
+    const ptime start = microsec_clock::universal_time();
+    Lease6Collection leases;
+    LeaseMgrFactory::instance().getExpiredLeases6(leases, max_leases);
+    ReclamationStats stats = reclaimLeases(leases, timeout, callback, start);
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+              DHCPSRV_RECLAIM_LEASES6_COMPLETE)
+        .arg(stats.reclaimed_).arg(stats.duration_);
+    return (stats);
+}
+
+template<typename LeaseCollectionType, typename CallbackType>
+AllocEngine::ReclamationStats
+AllocEngine::reclaimLeases(const LeaseCollectionType& leases,
+                           const uint32_t timeout,
+                           const CallbackType& callback,
+                           const ptime& start) {
+    ReclamationStats stats;
+    LeaseMgr& lease_mgr = LeaseMgrFactory::instance();
+
+    typename LeaseCollectionType::const_iterator lease = leases.begin();
+    while (lease != leases.end()) {
+        // The time is checked between the batches, so the cycle takes at
+        // most the maximum time and the time to reclaim one batch.
+        if ((timeout > 0) &&
+            ((microsec_clock::universal_time() - start).total_milliseconds()
+             >= timeout)) {
+            stats.timed_out_ = true;
+            break;
+        }
+
+        LeaseCollectionType batch;
+        while ((lease != leases.end()) && (batch.size() < RECLAIM_BATCH_SIZE)) {
+            batch.push_back(*lease);
+            ++lease;
+        }
+
+        LeaseCollectionType reclaimed;
+        {
+            // The subnets of the batch are locked, so as the allocation
+            // engine doesn't renew or reuse the leases while they are being
+            // deleted. A lease which has been renewed since it was fetched
+            // is no longer expired and is left alone. Only this thread ever
+            // holds more than one allocation mutex, so the order in which
+            // they are taken doesn't matter.
+            std::map<SubnetID, SubnetPtr> subnets;
+            LockerCollection locks;
+            LeaseCollectionType deleted;
+            LeaseWriteCollection writes;
+            for (typename LeaseCollectionType::const_iterator l = batch.begin();
+                 l != batch.end(); ++l) {
+                if (subnets.count((*l)->subnet_id_) == 0) {
+                    SubnetPtr subnet = getSubnet(getLeaseType(*l),
+                                                 (*l)->subnet_id_);
+                    if (subnet) {
+                        locks.push_back(boost::shared_ptr<Mutex::Locker>(
+                            new Mutex::Locker(subnet->getAllocationMutex())));
+                    }
+                    subnets[(*l)->subnet_id_] = subnet;
+                }
+                if (isStillExpired(*l)) {
+                    deleted.push_back(*l);
+                    writes.push_back(LeaseWrite(LeaseWrite::DELETE, *l));
+                }
+            }
+
+            try {
+                lease_mgr.writeLeases(writes);
+            } catch (const std::exception& ex) {
+                // None of the leases has been deleted, so they will be
+                // reclaimed in the next cycle.
+                for (LeaseWriteCollection::iterator write = writes.begin();
+                     write != writes.end(); ++write) {
+                    write->result_ = false;
+                    if (write->error_.empty()) {
+                        write->error_ = ex.what();
+                    }
+                }
+            }
+
+            typename LeaseCollectionType::const_iterator l = deleted.begin();
+            for (LeaseWriteCollection::const_iterator write = writes.begin();
+                 write != writes.end(); ++write, ++l) {
+                if (!write->result_) {
+                    // The lease which has been already deleted, e.g. by
+                    // another server sharing the database, doesn't have to
+                    // be reclaimed.
+                    if (!write->error_.empty()) {
+                        LOG_WARN(dhcpsrv_logger, DHCPSRV_RECLAIM_LEASE_FAIL)
+                            .arg(write->addr_.toText()).arg(write->error_);
+                    }
+                    continue;
+                }
+                markPoolFreeInternal(subnets[(*l)->subnet_id_],
+                                     getLeaseType(*l), (*l)->addr_);
+                reclaimed.push_back(*l);
+            }
+        }
+
+        // The callbacks are invoked without holding the locks.
+        for (typename LeaseCollectionType::const_iterator l = reclaimed.begin();
+             l != reclaimed.end(); ++l) {
+            ++stats.reclaimed_;
+            if (callback) {
+                try {
+                    callback(*l);
+                } catch (const std::exception& ex) {
+                    LOG_WARN(dhcpsrv_logger, DHCPSRV_RECLAIM_CALLBACK_FAIL)
+                        .arg((*l)->addr_.toText()).arg(ex.what());
+                }
+            }
+        }
+    }
+
+    stats.duration_ = (microsec_clock::universal_time() - start)
+        .total_milliseconds();
+    if (stats.timed_out_) {
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_RECLAIM_LEASES_TIMEOUT)
+            .arg(stats.duration_).arg(stats.reclaimed_);
+    }
+    return (stats);
+}
+
+SubnetPtr
+AllocEngine::getSubnet(Lease::Type type, const SubnetID subnet_id) const {
+    if (type == Lease::TYPE_V4) {
+        return (CfgMgr::instance().getSubnet4(subnet_id));
+    }
+    return (CfgMgr::instance().getSubnet6(subnet_id));
+}
+
+void
+AllocEngine::markPoolFree(Lease::Type type, const IOAddress& addr,
+                          const SubnetID subnet_id) {
+    if (!track_pool_usage_) {
+        return;
+    }
+
+    SubnetPtr subnet = getSubnet(type, subnet_id);
+    if (subnet) {
+        Mutex::Locker locker(subnet->getAllocationMutex());
+        markPoolFreeInternal(subnet, type, addr);
+    }
+}
+
+void
+AllocEngine::markPoolFreeInternal(const SubnetPtr& subnet, Lease::Type type,
+                                  const IOAddress& addr) {
+    if (!track_pool_usage_ || !subnet) {
+        return;
+    }
+
+    PoolPtr pool = subnet->getPool(type, addr, false);
+    if (pool) {
+        pool->markFree(addr);
+    }
+}
+
 AllocEngine::~AllocEngine() {
     // no need to delete allocator. smart_ptr will do the trick for us
 }
@@ -18,14 +18,21 @@
 #include <asiolink/io_address.h>
 #include <dhcp/duid.h>
 #include <dhcp/hwaddr.h>
+#include <dhcpsrv/async_lease_mgr.h>
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <hooks/callout_handle.h>
 
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/function.hpp>
+#include <boost/random/mersenne_twister.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
 
 #include <map>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace isc {
 namespace dhcp {
@@ -159,50 +166,161 @@ protected:
                        const uint8_t prefix_len);
     };
 
+    /// @brief Base class for the allocators which address the leases by
+    /// their position within the pools of a subnet.
+    ///
+    /// All addresses (or prefixes) in the pools of the subnet are numbered
+    /// consecutively, in the order of the pools. The derived allocators pick
+    /// the starting position and this class walks over the positions which
+    /// follow it when the allocation engine asks for another candidate for
+    /// the same client. The walk is linear, so the addresses freed in the
+    /// nearly exhausted pool are found with few lease database lookups.
+    ///
+    /// The allocation engine calls @c pickAddress repeatedly for the client
+    /// until it finds an available address, passing the rejected candidate
+    /// as a hint. The allocator continues the walk if the hint, the client
+    /// identifier and the subnet are those of the previous call. Otherwise,
+    /// it starts from the new position. The walk is tracked separately for
+    /// each subnet: the allocation engine serializes the allocations within
+    /// a subnet, but the allocations in different subnets may interleave.
+    class PositionalAllocator : public Allocator {
+    public:
+
+        /// @brief Constructor
+        ///
+        /// @param type specifies allocation type
+        PositionalAllocator(Lease::Type type);
+
+        /// @brief returns the next address for the client
+        ///
+        /// @param subnet an address will be picked from pool of that subnet
+        /// @param duid Client's DUID or client identifier (may be NULL)
+        /// @param hint client's hint or the previously rejected candidate
+        /// @return selected address
+        virtual isc::asiolink::IOAddress
+        pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
+                    const isc::asiolink::IOAddress& hint);
+
+        /// @brief Returns the address at the specified position.
+        ///
+        /// @param pools pools of a single type
+        /// @param position position of the address (or prefix), lower than
+        /// the value returned by @c Subnet::getPoolCapacity for the same
+        /// pools.
+        /// @return address or prefix at the position
+        /// @throw BadValue if the position is out of range
+        static isc::asiolink::IOAddress
+        getAddress(const PoolCollection& pools, uint64_t position);
+
+    protected:
+
+        /// @brief Returns the position at which the search starts.
+        ///
+        /// @param duid Client's DUID or client identifier (may be NULL)
+        /// @param capacity number of addresses in the pools (non-zero)
+        /// @return starting position, lower than capacity
+        virtual uint64_t getStartPosition(const DuidPtr& duid,
+                                          uint64_t capacity) = 0;
+
+        /// @brief Returns the maximum number of consecutive positions
+        /// checked from a single starting position.
+        ///
+        /// Once exceeded, the next candidate is taken from a new starting
+        /// position. The default implementation never gives up.
+        virtual uint64_t getMaxProbes() const;
+
+    private:
+
+        /// @brief State of the walk over the pools of a subnet.
+        struct Walk {
+            /// @brief Constructor.
+            ///
+            /// @param address initial value of the last returned address
+            Walk(const isc::asiolink::IOAddress& address)
+                : last_address_(address), last_position_(0), probes_(0) {
+            }
+
+            /// @brief Identifier of the client handled by the last call.
+            std::vector<uint8_t> last_client_;
+
+            /// @brief Last returned address.
+            isc::asiolink::IOAddress last_address_;
+
+            /// @brief Position of the last returned address.
+            uint64_t last_position_;
+
+            /// @brief Number of positions checked since the last start.
+            uint64_t probes_;
+        };
+
+        /// @brief Walks over the pools, by subnet ID.
+        std::map<SubnetID, Walk> walks_;
+
+        /// @brief Protects the walks and the state of the derived classes.
+        isc::util::thread::Mutex mutex_;
+    };
+
     /// @brief Address/prefix allocator that gets an address based on a hash
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
-    class HashedAllocator : public Allocator {
+    /// The search starts at the position derived from the hash of the
+    /// client's DUID or client identifier, so the client is likely to get
+    /// the same address whenever it asks for one, even if its lease is gone.
+    /// The DHCPv4 clients which don't send a client identifier are identified
+    /// by their hardware address. The clients which don't have an identifier
+    /// start at the beginning of the pools, i.e. they are handled like by the
+    /// iterative allocator.
+    class HashedAllocator : public PositionalAllocator {
     public:
 
         /// @brief default constructor (does nothing)
         /// @param type - specifies allocation type
         HashedAllocator(Lease::Type type);
 
-        /// @brief returns an address based on hash calculated from client's DUID.
-        ///
-        /// @todo: Implement this method
+    protected:
+
+        /// @brief Returns the position derived from the client's identifier.
         ///
-        /// @param subnet an address will be picked from pool of that subnet
-        /// @param duid Client's DUID
-        /// @param hint a hint (last address that was picked)
-        /// @return selected address
-        virtual isc::asiolink::IOAddress pickAddress(const SubnetPtr& subnet,
-                                                     const DuidPtr& duid,
-                                                     const isc::asiolink::IOAddress& hint);
+        /// @param duid Client's DUID or client identifier (may be NULL)
+        /// @param capacity number of addresses in the pools (non-zero)
+        /// @return starting position, lower than capacity
+        virtual uint64_t getStartPosition(const DuidPtr& duid,
+                                          uint64_t capacity);
     };
 
     /// @brief Random allocator that picks address randomly
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
-    class RandomAllocator : public Allocator {
+    /// The search starts at a random position. Up to @c MAX_PROBES
+    /// consecutive positions are then tried before the allocator moves to
+    /// another random position.
+    class RandomAllocator : public PositionalAllocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief Maximum number of positions tried from a random start.
+        static const uint64_t MAX_PROBES = 16;
+
+        /// @brief default constructor
+        ///
+        /// Seeds the random number generator with the current time.
         /// @param type - specifies allocation type
         RandomAllocator(Lease::Type type);
 
-        /// @brief returns an random address from pool of specified subnet
-        ///
-        /// @todo: Implement this method
+    protected:
+
+        /// @brief Returns a random position.
         ///
-        /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID (ignored)
-        /// @param hint the last address that was picked (ignored)
-        /// @return a random address from the pool
-        virtual isc::asiolink::IOAddress
-        pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
-                    const isc::asiolink::IOAddress& hint);
+        /// @param capacity number of addresses in the pools (non-zero)
+        /// @return starting position, lower than capacity
+        virtual uint64_t getStartPosition(const DuidPtr& duid,
+                                          uint64_t capacity);
+
+        /// @brief Returns @c MAX_PROBES
+        virtual uint64_t getMaxProbes() const;
+
+    private:
+
+        /// @brief Random number generator.
+        boost::mt19937 rng_;
     };
 
     public:
@@ -214,6 +332,13 @@ protected:
         ALLOC_RANDOM     // random - an address is randomly selected
     } AllocType;
 
+    /// @brief Returns the allocation type for its name.
+    ///
+    /// @param alloc_type name of the allocation type: "iterative",
+    /// "hashed" or "random"
+    /// @return allocation type
+    /// @throw BadValue if the name is not recognized
+    static AllocType allocTypeFromText(const std::string& alloc_type);
 
     /// @brief Default constructor.
     ///
@@ -272,6 +397,11 @@ protected:
     /// @param [out] old_lease Holds the pointer to a previous instance of a
     ///        lease. The NULL pointer indicates that lease didn't exist prior
     ///        to calling this function (e.g. new lease has been allocated).
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted. If it is specified, the writes are executed
+    ///        asynchronously and the lease is returned before it has been
+    ///        written to the database. Otherwise the lease is written before
+    ///        this function returns.
     ///
     /// @return Allocated IPv4 lease (or NULL if allocation failed)
     Lease4Ptr
@@ -281,7 +411,8 @@ protected:
                    const bool fwd_dns_update, const bool rev_dns_update,
                    const std::string& hostname, bool fake_allocation,
                    const isc::hooks::CalloutHandlePtr& callout_handle,
-                   Lease4Ptr& old_lease);
+                   Lease4Ptr& old_lease,
+                   const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Renews a IPv4 lease
     ///
@@ -305,6 +436,8 @@ protected:
     ///        will be executed if this parameter is passed.
     /// @param fake_allocation Is this real i.e. REQUEST (false) or just picking
     ///        an address for DISCOVER that is not really allocated (true)
+    /// @param commit Optional commit through which the lease update is
+    ///        submitted (see @c allocateLease4).
     Lease4Ptr
     renewLease4(const SubnetPtr& subnet,
                 const ClientIdPtr& clientid,
@@ -314,7 +447,8 @@ protected:
                 const std::string& hostname,
                 const Lease4Ptr& lease,
                 const isc::hooks::CalloutHandlePtr& callout_handle,
-                bool fake_allocation /* = false */);
+                bool fake_allocation /* = false */,
+                const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Allocates an IPv6 lease
     ///
@@ -343,6 +477,8 @@ protected:
     ///        collection of new leases, being returned. For newly allocated
     ///        leases (not renewed) the NULL pointers are stored in this
     ///        collection as old leases.
+    /// @param commit Optional commit through which the lease writes are
+    ///        submitted (see @c allocateLease4).
     ///
     /// @return Allocated IPv6 leases (may be empty if allocation failed)
     Lease6Collection
@@ -352,7 +488,8 @@ protected:
                     const bool fwd_dns_update, const bool rev_dns_update,
                     const std::string& hostname, bool fake_allocation,
                     const isc::hooks::CalloutHandlePtr& callout_handle,
-                    Lease6Collection& old_leases);
+                    Lease6Collection& old_leases,
+                    const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief returns allocator for a given pool type
     /// @param type type of pool (V4, IA, TA or PD)
@@ -360,10 +497,196 @@ protected:
     /// @return pointer to allocator handing a given resource types
     AllocatorPtr getAllocator(Lease::Type type);
 
+    /// @brief Enables or disables tracking of the free addresses in pools.
+    ///
+    /// When enabled, the engine keeps a bitmap of used addresses for each
+    /// pool having at most @c Pool::MAX_TRACKED_CAPACITY addresses. The
+    /// addresses of the expired leases are not marked used, because they
+    /// may be reused. The candidate addresses returned by the allocator
+    /// are moved to the nearest free address in the pool, so as the
+    /// lease database is queried once per allocation rather than once per
+    /// used address. The database is still queried to confirm that the
+    /// address is free, because other servers may share the database.
+    ///
+    /// The bitmaps are built from the lease database, with one query per
+    /// pool, for the pools of the configured subnets which aren't tracked
+    /// yet. The bitmaps are not updated while the tracking is disabled, so
+    /// all of them are rebuilt when it is enabled again. The servers enable
+    /// the tracking when the configuration is committed, so as the pools
+    /// of the new subnets are tracked before they are used for allocation.
+    ///
+    /// @param track true if the usage of the pools should be tracked
+    void setPoolTracking(bool track);
+
+    /// @brief Checks if tracking of the free addresses in pools is enabled.
+    ///
+    /// @return true if the usage of the pools is tracked
+    bool getPoolTracking() const {
+        return (track_pool_usage_);
+    }
+
+    /// @brief Marks the address of the released or reclaimed lease as free.
+    ///
+    /// The subnet is found by its identifier and the usage of its pool is
+    /// modified under the allocation mutex of the subnet. This is a no-op
+    /// unless the usage of the pools is tracked.
+    ///
+    /// @param type type of the lease
+    /// @param addr address of the lease
+    /// @param subnet_id identifier of the subnet the lease belongs to
+    void markPoolFree(Lease::Type type, const isc::asiolink::IOAddress& addr,
+                      const SubnetID subnet_id);
+
+    /// @brief Statistics of the lease reclamation cycle.
+    struct ReclamationStats {
+        /// @brief Constructor.
+        ReclamationStats()
+            : reclaimed_(0), duration_(0), timed_out_(false) {
+        }
+
+        /// @brief Number of the leases reclaimed.
+        size_t reclaimed_;
+
+        /// @brief Duration of the cycle in milliseconds.
+        uint64_t duration_;
+
+        /// @brief Indicates if the cycle has been interrupted because it
+        /// exceeded the maximum time.
+        bool timed_out_;
+    };
+
+    /// @brief Function invoked for each reclaimed IPv4 lease.
+    ///
+    /// The server uses it to remove the DNS entries for the lease.
+    typedef boost::function<void (const Lease4Ptr&)> Lease4ReclaimCallback;
+
+    /// @brief Function invoked for each reclaimed IPv6 lease.
+    ///
+    /// The server uses it to remove the DNS entries for the lease.
+    typedef boost::function<void (const Lease6Ptr&)> Lease6ReclaimCallback;
+
+    /// @brief Reclaims the expired IPv4 leases.
+    ///
+    /// The expired leases are fetched from the lease database in the order
+    /// of their expiration time and deleted from the database in batches
+    /// of @c RECLAIM_BATCH_SIZE leases (see @c LeaseMgr::writeLeases).
+    /// The addresses of the reclaimed leases are marked as free in the
+    /// pools, if the usage of the pools is tracked, and the callback is
+    /// invoked for each reclaimed lease.
+    ///
+    /// Each batch is deleted while holding the allocation mutexes of the
+    /// subnets of its leases, and a lease is only deleted if it is still
+    /// expired in the database. The reclamation may thus run concurrently
+    /// with the allocations, which may have renewed some of the leases.
+    ///
+    /// The cycle is interrupted when it has taken more than the maximum
+    /// time, so as the reclamation doesn't delay the processing of the
+    /// packets for too long. The remaining leases are reclaimed in the next
+    /// cycle.
+    ///
+    /// @param max_leases maximum number of leases reclaimed in the cycle,
+    ///        0 means no limit
+    /// @param timeout maximum duration of the cycle in milliseconds, 0
+    ///        means no limit
+    /// @param callback optional function invoked for each reclaimed lease
+    ///
+    /// @return statistics of the cycle
+    ReclamationStats
+    reclaimExpiredLeases4(const size_t max_leases, const uint32_t timeout,
+                          const Lease4ReclaimCallback& callback =
+                          Lease4ReclaimCallback());
+
+    /// @brief Reclaims the expired IPv6 leases.
+    ///
+    /// See @c reclaimExpiredLeases4 for details.
+    ///
+    /// @param max_leases maximum number of leases reclaimed in the cycle,
+    ///        0 means no limit
+    /// @param timeout maximum duration of the cycle in milliseconds, 0
+    ///        means no limit
+    /// @param callback optional function invoked for each reclaimed lease
+    ///
+    /// @return statistics of the cycle
+    ReclamationStats
+    reclaimExpiredLeases6(const size_t max_leases, const uint32_t timeout,
+                          const Lease6ReclaimCallback& callback =
+                          Lease6ReclaimCallback());
+
+    /// @brief Number of expired leases deleted from the database at once.
+    static const size_t RECLAIM_BATCH_SIZE = 32;
+
     /// @brief Destructor. Used during DHCPv6 service shutdown.
     virtual ~AllocEngine();
 private:
 
+    /// @brief Reclaims the expired leases (common code for IPv4 and IPv6).
+    ///
+    /// @param leases expired leases fetched from the database
+    /// @param timeout maximum duration of the cycle in milliseconds
+    /// @param callback function invoked for each reclaimed lease
+    /// @param start time when the cycle has started
+    ///
+    /// @return statistics of the cycle
+    template<typename LeaseCollectionType, typename CallbackType>
+    ReclamationStats
+    reclaimLeases(const LeaseCollectionType& leases, const uint32_t timeout,
+                  const CallbackType& callback,
+                  const boost::posix_time::ptime& start);
+
+    /// @brief Marks the address as free in its pool.
+    ///
+    /// The caller must hold the allocation mutex of the subnet.
+    ///
+    /// @param subnet subnet the address belongs to, may be NULL
+    /// @param type type of the lease
+    /// @param addr address of the lease
+    void markPoolFreeInternal(const SubnetPtr& subnet, Lease::Type type,
+                              const isc::asiolink::IOAddress& addr);
+
+    /// @brief Returns the configured subnet with the identifier.
+    ///
+    /// The subnet is found with the index of the subnets held by
+    /// @c CfgMgr.
+    ///
+    /// @param type type of the lease, selecting the IPv4 or IPv6 subnets
+    /// @param subnet_id identifier of the subnet
+    /// @return subnet or NULL if there is no such subnet
+    SubnetPtr getSubnet(Lease::Type type, const SubnetID subnet_id) const;
+
+    /// @brief Collects the usage of the pools of the subnet.
+    ///
+    /// The leases of each pool are obtained from the lease database with
+    /// a single query and the addresses of the leases which haven't expired
+    /// are marked used.
+    ///
+    /// @param subnet subnet whose pools are tracked
+    /// @param type type of the pools
+    /// @param rebuild true if the pools which are already tracked should
+    /// be collected again
+    void initPoolUsage(const SubnetPtr& subnet, Lease::Type type,
+                       const bool rebuild);
+
+    /// @brief Returns the pool with the tracked usage for the address.
+    ///
+    /// @param subnet subnet the address belongs to
+    /// @param type type of the pool
+    /// @param addr address within the pool
+    /// @return pool with the tracked usage, or NULL if the tracking is
+    /// disabled, the address is not in a pool or the pool isn't tracked,
+    /// e.g. because it is too large
+    PoolPtr getTrackedPool(const SubnetPtr& subnet, Lease::Type type,
+                           const isc::asiolink::IOAddress& addr);
+
+    /// @brief Marks the address as used if the pool usage is tracked.
+    ///
+    /// The caller must hold the allocation mutex of the subnet.
+    ///
+    /// @param subnet subnet the address belongs to
+    /// @param type type of the pool
+    /// @param addr allocated address
+    void markPoolUsed(const SubnetPtr& subnet, Lease::Type type,
+                      const isc::asiolink::IOAddress& addr);
+
     /// @brief Creates a lease and inserts it in LeaseMgr if necessary
     ///
     /// Creates a lease based on specified parameters and tries to insert it
@@ -384,6 +707,8 @@ private:
     ///        registered)
     /// @param fake_allocation Is this real i.e. REQUEST (false) or just picking
     ///        an address for DISCOVER that is not really allocated (true)
+    /// @param commit optional commit through which the lease write is
+    ///        submitted
     /// @return allocated lease (or NULL in the unlikely case of the lease just
     ///        becomed unavailable)
     Lease4Ptr createLease4(const SubnetPtr& subnet, const DuidPtr& clientid,
@@ -393,7 +718,8 @@ private:
                            const bool rev_dns_update,
                            const std::string& hostname,
                            const isc::hooks::CalloutHandlePtr& callout_handle,
-                           bool fake_allocation = false);
+                           bool fake_allocation = false,
+                           const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief creates a lease and inserts it in LeaseMgr if necessary
     ///
@@ -421,6 +747,8 @@ private:
     ///        registered)
     /// @param fake_allocation is this real i.e. REQUEST (false) or just picking
     ///        an address for SOLICIT that is not really allocated (true)
+    /// @param commit optional commit through which the lease write is
+    ///        submitted
     /// @return allocated lease (or NULL in the unlikely case of the lease just
     ///         became unavailable)
     Lease6Ptr createLease6(const Subnet6Ptr& subnet, const DuidPtr& duid,
@@ -429,7 +757,8 @@ private:
                            const bool fwd_dns_update, const bool rev_dns_update,
                            const std::string& hostname,
                            const isc::hooks::CalloutHandlePtr& callout_handle,
-                           bool fake_allocation = false);
+                           bool fake_allocation = false,
+                           const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Reuses expired IPv4 lease
     ///
@@ -450,6 +779,8 @@ private:
     ///        will be executed if this parameter is passed.
     /// @param fake_allocation Is this real i.e. REQUEST (false) or just picking
     ///        an address for DISCOVER that is not really allocated (true)
+    /// @param commit optional commit through which the lease write is
+    ///        submitted
     /// @return refreshed lease
     /// @throw BadValue if trying to recycle lease that is still valid
     Lease4Ptr reuseExpiredLease(Lease4Ptr& expired,
@@ -460,7 +791,8 @@ private:
                                 const bool rev_dns_update,
                                 const std::string& hostname,
                                 const isc::hooks::CalloutHandlePtr& callout_handle,
-                                bool fake_allocation = false);
+                                bool fake_allocation = false,
+                                const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Reuses expired IPv6 lease
     ///
@@ -485,6 +817,8 @@ private:
     ///        will be executed if this parameter is passed.
     /// @param fake_allocation is this real i.e. REQUEST (false) or just picking
     ///        an address for SOLICIT that is not really allocated (true)
+    /// @param commit optional commit through which the lease write is
+    ///        submitted
     /// @return refreshed lease
     /// @throw BadValue if trying to recycle lease that is still valid
     Lease6Ptr reuseExpiredLease(Lease6Ptr& expired, const Subnet6Ptr& subnet,
@@ -494,7 +828,8 @@ private:
                                 const bool rev_dns_update,
                                 const std::string& hostname,
                                 const isc::hooks::CalloutHandlePtr& callout_handle,
-                                bool fake_allocation = false);
+                                bool fake_allocation = false,
+                                const LeaseCommitPtr& commit = LeaseCommitPtr());
 
     /// @brief Updates FQDN data for a collection of leases.
     ///
@@ -509,6 +844,8 @@ private:
     /// lease allocation, e.g. Request message is processed (false), or address
     /// is just being picked as a result of processing Solicit (true). In the
     /// latter case, the FQDN data should not be updated in the lease database.
+    /// @param commit optional commit through which the lease updates are
+    /// submitted.
     ///
     /// @return Collection of leases with updated FQDN data. Note that returned
     /// collection holds updated FQDN data even for fake allocation.
@@ -516,7 +853,42 @@ private:
                                     const bool fwd_dns_update,
                                     const bool rev_dns_update,
                                     const std::string& hostname,
-                                    const bool fake_allocation);
+                                    const bool fake_allocation,
+                                    const LeaseCommitPtr& commit);
+
+    /// @brief Writes the lease to the database.
+    ///
+    /// Without the commit, the write is executed before this function
+    /// returns. With the commit, the write is submitted for the
+    /// asynchronous execution and the address of the lease is held as
+    /// uncommitted until the write has been executed.
+    ///
+    /// @param write lease addition or update
+    /// @param commit optional commit through which the write is submitted
+    ///
+    /// @return false if the lease to be added exists already or, with the
+    /// commit, if the write couldn't be submitted
+    /// @throw isc::dhcp::DbOperationError if the lease update couldn't be
+    /// submitted; the backend errors are propagated for the updates
+    /// executed without the commit
+    bool writeLease(const LeaseWrite& write, const LeaseCommitPtr& commit);
+
+    /// @brief Releases the address of the executed write.
+    ///
+    /// @param write executed lease write
+    void writeCommitted(const LeaseWrite& write);
+
+    /// @brief Checks if the lease write for the address is pending.
+    ///
+    /// The address of the lease which is being added or updated for a
+    /// client isn't offered to other clients and the lease isn't renewed,
+    /// until the write has been executed. The lease database doesn't
+    /// reflect the write until then, while the allocation mutex of the
+    /// subnet has been released.
+    ///
+    /// @param addr address of the lease
+    /// @return true if there is a pending write for the address
+    bool isUncommitted(const isc::asiolink::IOAddress& addr) const;
 
     /// @brief a pointer to currently used allocator
     ///
@@ -527,6 +899,17 @@ private:
     /// @brief number of attempts before we give up lease allocation (0=unlimited)
     unsigned int attempts_;
 
+    /// @brief Indicates if the free addresses in pools are tracked
+    bool track_pool_usage_;
+
+    /// @brief Addresses of the leases with pending writes.
+    ///
+    /// An address is held once for each of its pending writes.
+    std::multiset<isc::asiolink::IOAddress> uncommitted_;
+
+    /// @brief Mutex protecting the addresses with pending writes.
+    mutable util::thread::Mutex uncommitted_mutex_;
+
     // hook name indexes (used in hooks callouts)
     int hook_index_lease4_select_; ///< index for lease4_select hook
     int hook_index_lease6_select_; ///< index for lease6_select hook
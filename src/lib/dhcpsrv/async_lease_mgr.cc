@@ -0,0 +1,325 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/async_lease_mgr.h>
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/lease_mgr_factory.h>
+
+#include <boost/bind.hpp>
+
+using namespace isc::asiolink;
+using namespace isc::util::thread;
+
+namespace isc {
+namespace dhcp {
+
+AsyncLeaseMgr::AsyncLeaseMgr(LeaseMgr& lease_mgr, const size_t queue_size,
+                             const size_t max_batch_size)
+    : lease_mgr_(&lease_mgr), max_batch_size_(max_batch_size),
+      queue_(queue_size) {
+    start();
+}
+
+AsyncLeaseMgr::AsyncLeaseMgr(const size_t queue_size,
+                             const size_t max_batch_size)
+    : lease_mgr_(NULL), max_batch_size_(max_batch_size),
+      queue_(queue_size) {
+    start();
+}
+
+AsyncLeaseMgr::~AsyncLeaseMgr() {
+    stop();
+}
+
+bool
+AsyncLeaseMgr::addLease(const Lease4Ptr& lease,
+                        const WriteCallback& callback) {
+    return (write(LeaseWrite(LeaseWrite::ADD, lease), callback));
+}
+
+bool
+AsyncLeaseMgr::addLease(const Lease6Ptr& lease,
+                        const WriteCallback& callback) {
+    return (write(LeaseWrite(LeaseWrite::ADD, lease), callback));
+}
+
+bool
+AsyncLeaseMgr::updateLease4(const Lease4Ptr& lease,
+                            const WriteCallback& callback) {
+    return (write(LeaseWrite(LeaseWrite::UPDATE, lease), callback));
+}
+
+bool
+AsyncLeaseMgr::updateLease6(const Lease6Ptr& lease,
+                            const WriteCallback& callback) {
+    return (write(LeaseWrite(LeaseWrite::UPDATE, lease), callback));
+}
+
+bool
+AsyncLeaseMgr::deleteLease(const IOAddress& addr,
+                           const WriteCallback& callback) {
+    return (write(LeaseWrite(addr), callback));
+}
+
+bool
+AsyncLeaseMgr::getLease4(const IOAddress& addr,
+                         const Lease4Callback& callback) {
+    return (pushRead(boost::bind(&AsyncLeaseMgr::readLease4, _1, addr,
+                                 callback)));
+}
+
+bool
+AsyncLeaseMgr::getLease6(Lease::Type type, const IOAddress& addr,
+                         const Lease6Callback& callback) {
+    return (pushRead(boost::bind(&AsyncLeaseMgr::readLease6, _1, type, addr,
+                                 callback)));
+}
+
+void
+AsyncLeaseMgr::wait() {
+    queue_.waitIdle();
+}
+
+void
+AsyncLeaseMgr::stop() {
+    queue_.close();
+    if (thread_) {
+        thread_->wait();
+        thread_.reset();
+    }
+}
+
+bool
+AsyncLeaseMgr::write(const LeaseWrite& write, const WriteCallback& callback) {
+    OperationPtr operation(new Operation());
+    operation->write_.reset(new LeaseWrite(write));
+    operation->write_callback_ = callback;
+    return (queue_.push(operation));
+}
+
+bool
+AsyncLeaseMgr::pushRead(const ReadFunction& read) {
+    OperationPtr operation(new Operation());
+    operation->read_ = read;
+    return (queue_.push(operation));
+}
+
+void
+AsyncLeaseMgr::start() {
+    if (max_batch_size_ == 0) {
+        isc_throw(BadValue, "maximum size of the batch of lease writes"
+                  " must be greater than 0");
+    }
+    thread_.reset(new util::thread::Thread(boost::bind(&AsyncLeaseMgr::run,
+                                                       this)));
+}
+
+LeaseMgr&
+AsyncLeaseMgr::getLeaseMgr() const {
+    return (lease_mgr_ ? *lease_mgr_ : LeaseMgrFactory::instance());
+}
+
+void
+AsyncLeaseMgr::run() {
+    OperationCollection operations;
+    while (queue_.popBatch(operations, max_batch_size_) > 0) {
+        OperationCollection::const_iterator operation = operations.begin();
+        while (operation != operations.end()) {
+            if ((*operation)->read_) {
+                try {
+                    (*operation)->read_(getLeaseMgr());
+                } catch (const std::exception& ex) {
+                    LOG_ERROR(dhcpsrv_logger,
+                              DHCPSRV_ASYNC_LEASE_MGR_CALLBACK_FAIL)
+                        .arg(ex.what());
+                }
+                ++operation;
+                continue;
+            }
+
+            // Consecutive writes are executed in one batch. A read
+            // terminates the batch, so as it sees the preceding writes.
+            OperationCollection::const_iterator end = operation;
+            while ((end != operations.end()) && !(*end)->read_) {
+                ++end;
+            }
+            executeWrites(operation, end);
+            operation = end;
+        }
+
+        const size_t count = operations.size();
+        operations.clear();
+        queue_.done(count);
+    }
+}
+
+void
+AsyncLeaseMgr::executeWrites(OperationCollection::const_iterator begin,
+                             OperationCollection::const_iterator end) {
+    LeaseWriteCollection writes;
+    for (OperationCollection::const_iterator operation = begin;
+         operation != end; ++operation) {
+        writes.push_back(*(*operation)->write_);
+    }
+
+    try {
+        getLeaseMgr().writeLeases(writes);
+    } catch (const std::exception& ex) {
+        // The backend couldn't commit the writes, so none of them is
+        // considered successful.
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_ASYNC_LEASE_MGR_WRITE_FAIL)
+            .arg(writes.size()).arg(ex.what());
+        for (LeaseWriteCollection::iterator write = writes.begin();
+             write != writes.end(); ++write) {
+            write->result_ = false;
+            if (write->error_.empty()) {
+                write->error_ = ex.what();
+            }
+        }
+    }
+
+    LeaseWriteCollection::const_iterator write = writes.begin();
+    for (OperationCollection::const_iterator operation = begin;
+         operation != end; ++operation, ++write) {
+        if ((*operation)->write_callback_) {
+            try {
+                (*operation)->write_callback_(*write);
+            } catch (const std::exception& ex) {
+                LOG_ERROR(dhcpsrv_logger,
+                          DHCPSRV_ASYNC_LEASE_MGR_CALLBACK_FAIL)
+                    .arg(ex.what());
+            }
+        }
+    }
+}
+
+void
+AsyncLeaseMgr::readLease4(LeaseMgr& lease_mgr, const IOAddress& addr,
+                          const Lease4Callback& callback) {
+    Lease4Ptr lease;
+    try {
+        lease = lease_mgr.getLease4(addr);
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_ASYNC_LEASE_MGR_READ_FAIL)
+            .arg(addr.toText()).arg(ex.what());
+    }
+    callback(lease);
+}
+
+void
+AsyncLeaseMgr::readLease6(LeaseMgr& lease_mgr, Lease::Type type,
+                          const IOAddress& addr,
+                          const Lease6Callback& callback) {
+    Lease6Ptr lease;
+    try {
+        lease = lease_mgr.getLease6(type, addr);
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_ASYNC_LEASE_MGR_READ_FAIL)
+            .arg(addr.toText()).arg(ex.what());
+    }
+    callback(lease);
+}
+
+LeaseCommit::LeaseCommit(AsyncLeaseMgr& lease_mgr)
+    : lease_mgr_(lease_mgr), pending_(0), success_(true), closed_(false) {
+}
+
+bool
+LeaseCommit::submit(const LeaseWrite& write,
+                    const AsyncLeaseMgr::WriteCallback& callback) {
+    {
+        Mutex::Locker locker(mutex_);
+        if (closed_) {
+            isc_throw(InvalidOperation, "unable to submit the lease write"
+                      " for " << write.addr_ << ": the commit is closed");
+        }
+        ++pending_;
+    }
+    // The lease is copied, so as the caller may keep modifying it while
+    // the write is pending.
+    LeaseWrite copy(write);
+    if (copy.lease4_) {
+        copy.lease4_.reset(new Lease4(*copy.lease4_));
+    } else if (copy.lease6_) {
+        copy.lease6_.reset(new Lease6(*copy.lease6_));
+    }
+    // The callback holds the pointer to the commit, so as it exists until
+    // all writes have been executed.
+    if (lease_mgr_.write(copy, boost::bind(&LeaseCommit::writeDone,
+                                           shared_from_this(), _1,
+                                           callback))) {
+        return (true);
+    }
+    Mutex::Locker locker(mutex_);
+    --pending_;
+    return (false);
+}
+
+void
+LeaseCommit::close(const CompletionCallback& callback) {
+    bool success = false;
+    {
+        Mutex::Locker locker(mutex_);
+        if (closed_) {
+            isc_throw(InvalidOperation, "the lease commit is already closed");
+        }
+        closed_ = true;
+        if (pending_ > 0) {
+            callback_ = callback;
+            return;
+        }
+        success = success_;
+    }
+    callback(success);
+}
+
+size_t
+LeaseCommit::getPending() const {
+    Mutex::Locker locker(mutex_);
+    return (pending_);
+}
+
+void
+LeaseCommit::writeDone(const LeaseWrite& write,
+                       const AsyncLeaseMgr::WriteCallback& callback) {
+    if (callback) {
+        try {
+            callback(write);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_ASYNC_LEASE_MGR_CALLBACK_FAIL)
+                .arg(ex.what());
+        }
+    }
+
+    CompletionCallback completion;
+    bool success = false;
+    {
+        Mutex::Locker locker(mutex_);
+        if (!write.result_) {
+            success_ = false;
+        }
+        if ((--pending_ > 0) || !closed_) {
+            return;
+        }
+        completion.swap(callback_);
+        success = success_;
+    }
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_LEASE_COMMIT_COMPLETE).arg(success ? "succeeded" :
+                                                 "failed");
+    completion(success);
+}
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
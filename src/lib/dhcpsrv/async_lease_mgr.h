@@ -0,0 +1,396 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ASYNC_LEASE_MGR_H
+#define ASYNC_LEASE_MGR_H
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <util/threads/bounded_queue.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Asynchronous access to the lease database.
+///
+/// The calls to the lease database backend block the caller for the
+/// duration of the database round trip. This class lets the caller queue
+/// the lease operations and continue its work, while a dedicated thread
+/// executes them and reports their results with completion callbacks.
+///
+/// The operations are executed in the order in which they were queued.
+/// The writes which piled up in the queue while the thread was busy are
+/// handed over to the backend in one batch (see @c LeaseMgr::writeLeases),
+/// so as the backend can commit them at once, e.g. in one database
+/// transaction. A read is never reordered with the writes: it is executed
+/// once the writes queued before it have been committed, so it sees
+/// their results.
+///
+/// The callbacks are invoked by the thread executing the operations, so
+/// they must serialize access to the state they share with other threads.
+/// They should also be short, as they delay the execution of the following
+/// operations.
+///
+/// The backends lock themselves, so they may be used directly by other
+/// threads while the operations are pending. Such direct reads don't see
+/// the writes which are still queued. The @c wait method returns when all
+/// queued operations have been executed, so the backend may be replaced
+/// (or destroyed) afterwards.
+class AsyncLeaseMgr : public boost::noncopyable {
+public:
+
+    /// @brief Callback invoked when the lease write has been executed.
+    typedef boost::function<void (const LeaseWrite&)> WriteCallback;
+
+    /// @brief Callback receiving the IPv4 lease read from the database.
+    ///
+    /// The lease is null if it hasn't been found.
+    typedef boost::function<void (const Lease4Ptr&)> Lease4Callback;
+
+    /// @brief Callback receiving the IPv6 lease read from the database.
+    ///
+    /// The lease is null if it hasn't been found.
+    typedef boost::function<void (const Lease6Ptr&)> Lease6Callback;
+
+    /// @brief Constructor.
+    ///
+    /// Starts the thread executing the operations.
+    ///
+    /// @param lease_mgr Backend executing the operations. It must outlive
+    ///        this object.
+    /// @param queue_size Maximum number of operations waiting for the
+    ///        execution.
+    /// @param max_batch_size Maximum number of writes committed at once.
+    ///
+    /// @throw isc::InvalidParameter if the queue size is 0.
+    /// @throw isc::BadValue if the maximum batch size is 0.
+    AsyncLeaseMgr(LeaseMgr& lease_mgr, const size_t queue_size = 1024,
+                  const size_t max_batch_size = 64);
+
+    /// @brief Constructor.
+    ///
+    /// Starts the thread executing the operations on the backend returned
+    /// by @c LeaseMgrFactory::instance at the time of the execution, so
+    /// as the backend may be replaced when no operations are pending.
+    ///
+    /// @param queue_size Maximum number of operations waiting for the
+    ///        execution.
+    /// @param max_batch_size Maximum number of writes committed at once.
+    ///
+    /// @throw isc::InvalidParameter if the queue size is 0.
+    /// @throw isc::BadValue if the maximum batch size is 0.
+    AsyncLeaseMgr(const size_t queue_size, const size_t max_batch_size);
+
+    /// @brief Destructor.
+    ///
+    /// Executes the queued operations and stops the thread.
+    ~AsyncLeaseMgr();
+
+    /// @brief Queues the addition of the IPv4 lease.
+    ///
+    /// @param lease Lease to be added.
+    /// @param callback Optional callback invoked when the lease has been
+    ///        added. The result is false if the lease already exists.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool addLease(const Lease4Ptr& lease,
+                  const WriteCallback& callback = WriteCallback());
+
+    /// @brief Queues the addition of the IPv6 lease.
+    ///
+    /// @param lease Lease to be added.
+    /// @param callback Optional callback invoked when the lease has been
+    ///        added. The result is false if the lease already exists.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool addLease(const Lease6Ptr& lease,
+                  const WriteCallback& callback = WriteCallback());
+
+    /// @brief Queues the update of the IPv4 lease.
+    ///
+    /// @param lease Lease to be updated.
+    /// @param callback Optional callback invoked when the lease has been
+    ///        updated.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool updateLease4(const Lease4Ptr& lease,
+                      const WriteCallback& callback = WriteCallback());
+
+    /// @brief Queues the update of the IPv6 lease.
+    ///
+    /// @param lease Lease to be updated.
+    /// @param callback Optional callback invoked when the lease has been
+    ///        updated.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool updateLease6(const Lease6Ptr& lease,
+                      const WriteCallback& callback = WriteCallback());
+
+    /// @brief Queues the lease write.
+    ///
+    /// @param write Write to be executed.
+    /// @param callback Optional callback invoked when the write has been
+    ///        executed.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool write(const LeaseWrite& write,
+               const WriteCallback& callback = WriteCallback());
+
+    /// @brief Queues the deletion of the lease.
+    ///
+    /// @param addr Address of the lease to be deleted (IPv4 or IPv6).
+    /// @param callback Optional callback invoked when the lease has been
+    ///        deleted. The result is false if there was no such lease.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool deleteLease(const isc::asiolink::IOAddress& addr,
+                     const WriteCallback& callback = WriteCallback());
+
+    /// @brief Queues the lookup of the IPv4 lease by address.
+    ///
+    /// @param addr Address of the lease.
+    /// @param callback Callback receiving the lease.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool getLease4(const isc::asiolink::IOAddress& addr,
+                   const Lease4Callback& callback);
+
+    /// @brief Queues the lookup of the IPv6 lease by address.
+    ///
+    /// @param type Type of the lease.
+    /// @param addr Address of the lease.
+    /// @param callback Callback receiving the lease.
+    ///
+    /// @return true if the operation has been queued, false if the queue is
+    ///         full or the manager has been stopped.
+    bool getLease6(Lease::Type type, const isc::asiolink::IOAddress& addr,
+                   const Lease6Callback& callback);
+
+    /// @brief Waits until all queued operations have been executed.
+    ///
+    /// When this method returns, the callbacks of all operations queued
+    /// before the call have been invoked.
+    void wait();
+
+    /// @brief Stops the thread executing the operations.
+    ///
+    /// The operations already queued are executed before the thread
+    /// terminates. No more operations can be queued afterwards.
+    void stop();
+
+    /// @brief Returns the maximum number of writes committed at once.
+    size_t getMaxBatchSize() const {
+        return (max_batch_size_);
+    }
+
+private:
+
+    /// @brief Function executing the read on the backend.
+    typedef boost::function<void (LeaseMgr&)> ReadFunction;
+
+    /// @brief Operation waiting in the queue.
+    ///
+    /// It is either a write (with the optional callback) or a read.
+    struct Operation {
+        /// @brief Lease write.
+        boost::scoped_ptr<LeaseWrite> write_;
+
+        /// @brief Callback invoked when the write has been executed.
+        WriteCallback write_callback_;
+
+        /// @brief Function executing the read.
+        ReadFunction read_;
+    };
+
+    /// @brief Pointer to the operation.
+    typedef boost::shared_ptr<Operation> OperationPtr;
+
+    /// @brief Collection of the operations.
+    typedef std::vector<OperationPtr> OperationCollection;
+
+    /// @brief Queues the read.
+    ///
+    /// @param read Function executing the read.
+    ///
+    /// @return true if the operation has been queued.
+    bool pushRead(const ReadFunction& read);
+
+    /// @brief Starts the thread executing the operations.
+    void start();
+
+    /// @brief Returns the backend executing the operations.
+    LeaseMgr& getLeaseMgr() const;
+
+    /// @brief Main function of the thread executing the operations.
+    void run();
+
+    /// @brief Executes the writes in one batch and invokes their callbacks.
+    ///
+    /// @param begin First write of the batch.
+    /// @param end Operation following the last write of the batch.
+    void executeWrites(OperationCollection::const_iterator begin,
+                       OperationCollection::const_iterator end);
+
+    /// @brief Reads the IPv4 lease and hands it over to the callback.
+    ///
+    /// @param lease_mgr Backend.
+    /// @param addr Address of the lease.
+    /// @param callback Callback receiving the lease.
+    static void readLease4(LeaseMgr& lease_mgr,
+                           const isc::asiolink::IOAddress& addr,
+                           const Lease4Callback& callback);
+
+    /// @brief Reads the IPv6 lease and hands it over to the callback.
+    ///
+    /// @param lease_mgr Backend.
+    /// @param type Type of the lease.
+    /// @param addr Address of the lease.
+    /// @param callback Callback receiving the lease.
+    static void readLease6(LeaseMgr& lease_mgr, Lease::Type type,
+                           const isc::asiolink::IOAddress& addr,
+                           const Lease6Callback& callback);
+
+    /// @brief Backend executing the operations.
+    ///
+    /// If it is null, the backend created by the @c LeaseMgrFactory is used.
+    LeaseMgr* lease_mgr_;
+
+    /// @brief Maximum number of writes committed at once.
+    const size_t max_batch_size_;
+
+    /// @brief Operations waiting for the execution.
+    util::thread::BoundedQueue<OperationPtr> queue_;
+
+    /// @brief Thread executing the operations.
+    boost::scoped_ptr<util::thread::Thread> thread_;
+};
+
+/// @brief Lease writes made while processing one packet.
+///
+/// The server processing the packet submits the lease writes through the
+/// commit to the @c AsyncLeaseMgr, rather than waiting for the backend to
+/// execute each of them, so as it can process the next packet in the
+/// meantime. Once the processing is finished, the server closes the commit
+/// with the callback which sends the response. The callback is invoked
+/// when all writes have been executed, so the client doesn't get the
+/// response before its lease is in the database.
+///
+/// The commit fails if any of its writes fails, e.g. the lease to be
+/// added exists already because it has been allocated to another client
+/// concurrently. The server is expected to drop the response in this case.
+class LeaseCommit : public boost::noncopyable,
+                    public boost::enable_shared_from_this<LeaseCommit> {
+public:
+
+    /// @brief Callback invoked when all writes of the closed commit have
+    /// been executed.
+    ///
+    /// The argument is true if all writes have succeeded.
+    typedef boost::function<void (bool)> CompletionCallback;
+
+    /// @brief Constructor.
+    ///
+    /// @param lease_mgr Manager executing the writes. It must outlive the
+    ///        commit.
+    LeaseCommit(AsyncLeaseMgr& lease_mgr);
+
+    /// @brief Submits the lease write.
+    ///
+    /// The lease is copied, so as the caller may modify it after the
+    /// submission.
+    ///
+    /// @param write Write to be executed.
+    /// @param callback Optional callback invoked when the write has been
+    ///        executed, before the completion callback of the commit.
+    ///
+    /// @return true if the write has been queued, false if it has been
+    ///         rejected by the @c AsyncLeaseMgr. The rejected write doesn't
+    ///         make the commit fail and its callback isn't invoked.
+    ///
+    /// @throw isc::InvalidOperation if the commit has been closed.
+    bool submit(const LeaseWrite& write,
+                const AsyncLeaseMgr::WriteCallback& callback =
+                AsyncLeaseMgr::WriteCallback());
+
+    /// @brief Closes the commit.
+    ///
+    /// No more writes can be submitted afterwards. If there are no pending
+    /// writes, the callback is invoked immediately by the calling thread.
+    /// Otherwise it is invoked by the thread executing the last write.
+    ///
+    /// @param callback Callback invoked when all writes have been executed.
+    ///
+    /// @throw isc::InvalidOperation if the commit has been closed already.
+    void close(const CompletionCallback& callback);
+
+    /// @brief Returns the number of the writes which haven't been executed.
+    size_t getPending() const;
+
+private:
+
+    /// @brief Records the result of the write.
+    ///
+    /// Invokes the completion callback if it is the last pending write of
+    /// the closed commit.
+    ///
+    /// @param write Executed write.
+    /// @param callback Callback of the write.
+    void writeDone(const LeaseWrite& write,
+                   const AsyncLeaseMgr::WriteCallback& callback);
+
+    /// @brief Manager executing the writes.
+    AsyncLeaseMgr& lease_mgr_;
+
+    /// @brief Mutex protecting the state of the commit.
+    mutable util::thread::Mutex mutex_;
+
+    /// @brief Number of the writes which haven't been executed.
+    size_t pending_;
+
+    /// @brief Indicates if all executed writes have succeeded.
+    bool success_;
+
+    /// @brief Callback invoked when all writes have been executed.
+    ///
+    /// It is set when the commit is closed.
+    CompletionCallback callback_;
+
+    /// @brief Indicates if the commit has been closed.
+    bool closed_;
+};
+
+/// @brief Pointer to the lease commit.
+typedef boost::shared_ptr<LeaseCommit> LeaseCommitPtr;
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // ASYNC_LEASE_MGR_H
@@ -18,32 +18,136 @@
 #include <hooks/hooks_manager.h>
 #include <hooks/callout_handle.h>
 
+#include <util/threads/sync.h>
+
+#include <set>
+
+#include <pthread.h>
+
 namespace isc {
 namespace dhcp {
 
+/// @brief Per-thread storage of the packet and its CalloutHandle.
+///
+/// The DHCP servers may process several packets at the same time, each in
+/// its own thread. The packet being processed and its CalloutHandle are
+/// therefore stored separately for each thread, so as a thread never gets
+/// (nor replaces) the CalloutHandle of the packet processed by another
+/// thread. The storage is allocated when the thread first asks for it and
+/// deleted when the thread terminates.
+///
+/// The stored handles keep the hooks libraries loaded (and the last packets
+/// in memory) until they are replaced. They must be released with
+/// @c clearAll before the libraries are reloaded: the storage of the main
+/// thread, for instance, is never deleted.
+///
+/// @tparam T Type of the pointer to the packet, i.e. Pkt4Ptr or Pkt6Ptr.
+template <typename T>
+class CalloutHandleStore {
+public:
+    /// @brief Returns the storage of the calling thread.
+    static CalloutHandleStore& get() {
+        (void) pthread_once(&once_, &createKey);
+        void* store = pthread_getspecific(key_);
+        if (store == NULL) {
+            store = new CalloutHandleStore();
+            (void) pthread_setspecific(key_, store);
+        }
+        return (*static_cast<CalloutHandleStore*>(store));
+    }
+
+    /// @brief Clears the storage of all threads.
+    ///
+    /// The stored packets and CalloutHandles are released. The caller must
+    /// make sure that no thread is processing a packet at the same time.
+    static void clearAll() {
+        isc::util::thread::Mutex::Locker locker(getMutex());
+        for (typename std::set<CalloutHandleStore*>::iterator store =
+                 getStores().begin(); store != getStores().end(); ++store) {
+            (*store)->stored_pointer_.reset();
+            (*store)->stored_handle_.reset();
+        }
+    }
+
+    /// @brief Pointer to the last packet seen by the thread.
+    T stored_pointer_;
+
+    /// @brief CalloutHandle associated with the last packet.
+    isc::hooks::CalloutHandlePtr stored_handle_;
+
+private:
+    /// @brief Constructor
+    ///
+    /// Registers the storage, so as it is cleared by @c clearAll.
+    CalloutHandleStore() {
+        isc::util::thread::Mutex::Locker locker(getMutex());
+        getStores().insert(this);
+    }
+
+    /// @brief Destructor
+    ~CalloutHandleStore() {
+        isc::util::thread::Mutex::Locker locker(getMutex());
+        getStores().erase(this);
+    }
+
+    /// @brief Returns the storages of all threads.
+    static std::set<CalloutHandleStore*>& getStores() {
+        static std::set<CalloutHandleStore*> stores;
+        return (stores);
+    }
+
+    /// @brief Returns the mutex protecting the set of storages.
+    static isc::util::thread::Mutex& getMutex() {
+        static isc::util::thread::Mutex mutex;
+        return (mutex);
+    }
+
+    /// @brief Creates the key of the thread-specific storage.
+    static void createKey() {
+        (void) pthread_key_create(&key_, &destroy);
+    }
+
+    /// @brief Deletes the storage of the terminated thread.
+    ///
+    /// @param store Storage of the thread.
+    static void destroy(void* store) {
+        delete static_cast<CalloutHandleStore*>(store);
+    }
+
+    /// @brief Guards the creation of the key.
+    static pthread_once_t once_;
+
+    /// @brief Key of the thread-specific storage.
+    static pthread_key_t key_;
+};
+
+template <typename T>
+pthread_once_t CalloutHandleStore<T>::once_ = PTHREAD_ONCE_INIT;
+
+template <typename T>
+pthread_key_t CalloutHandleStore<T>::key_;
+
 /// @brief CalloutHandle Store
 ///
 /// When using the Hooks Framework, there is a need to associate an
 /// isc::hooks::CalloutHandle object with each request passing through the
 /// server.  For the DHCP servers, the association is provided by this function.
 ///
-/// The DHCP servers process a single request at a time. At points where the
-/// CalloutHandle is required, the pointer to the current request (packet) is
-/// passed to this function.  If the request is a new one, a pointer to
-/// the request is stored, a new CalloutHandle is allocated (and stored) and
-/// a pointer to the latter object returned to the caller.  If the request
-/// matches the one stored, the pointer to the stored CalloutHandle is
-/// returned.
+/// Each thread of the DHCP server processes a single request at a time. At
+/// points where the CalloutHandle is required, the pointer to the current
+/// request (packet) is passed to this function.  If the request is a new one,
+/// a pointer to the request is stored, a new CalloutHandle is allocated (and
+/// stored) and a pointer to the latter object returned to the caller.  If the
+/// request matches the one stored, the pointer to the stored CalloutHandle is
+/// returned.  The pointers are stored separately for each thread (see
+/// @ref CalloutHandleStore), so the threads processing different packets
+/// concurrently use different CalloutHandles.
 ///
 /// A special case is a null pointer being passed.  This has the effect of
 /// clearing the stored pointers to the packet being processed and
-/// CalloutHandle.  As the stored pointers are shared pointers, clearing them
-/// removes one reference that keeps the pointed-to objects in existence.
-///
-/// @note If the behaviour of the server changes so that multiple packets can
-///       be active at the same time, this simplistic approach will no longer
-///       be adequate and a more complicated structure (such as a map) will
-///       be needed.
+/// CalloutHandle of the calling thread.  As the stored pointers are shared
+/// pointers, clearing them removes one reference that keeps the pointed-to
+/// objects in existence.
 ///
 /// @param pktptr Pointer to the packet being processed.  This is typically a
 ///        Pkt4Ptr or Pkt6Ptr object.  An empty pointer is passed to clear
@@ -57,32 +161,31 @@ namespace dhcp {
 template <typename T>
 isc::hooks::CalloutHandlePtr getCalloutHandle(const T& pktptr) {
 
-    // Stored data is declared static, so is initialized when first accessed
-    static T stored_pointer;                // Pointer to last packet seen
-    static isc::hooks::CalloutHandlePtr stored_handle;
-                                            // Pointer to stored handle
+    // Stored data is held separately for each thread.
+    CalloutHandleStore<T>& store = CalloutHandleStore<T>::get();
 
     if (pktptr) {
 
         // Pointer given, have we seen it before? (If we have, we don't need to
         // do anything as we will automatically return the stored handle.)
-        if (pktptr != stored_pointer) {
+        if (pktptr != store.stored_pointer_) {
 
             // Not seen before, so store the pointer passed to us and get a new
             // CalloutHandle.  (The latter operation frees and probably deletes
             // (depending on other pointers) the stored one.)
-            stored_pointer = pktptr;
-            stored_handle = isc::hooks::HooksManager::createCalloutHandle();
+            store.stored_pointer_ = pktptr;
+            store.stored_handle_ =
+                isc::hooks::HooksManager::createCalloutHandle();
         }
-        
+
     } else {
 
         // Empty pointer passed, clear stored data
-        stored_pointer.reset();
-        stored_handle.reset();
+        store.stored_pointer_.reset();
+        store.stored_handle_.reset();
     }
 
-    return (stored_handle);
+    return (store.stored_handle_);
 }
 
 } // namespace shcp
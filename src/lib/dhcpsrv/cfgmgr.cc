@@ -22,6 +22,53 @@
 using namespace isc::asiolink;
 using namespace isc::util;
 
+namespace {
+
+/// @brief Returns the positions of all subnets in the collection.
+///
+/// It is used to walk over all subnets when the index hasn't been built.
+///
+/// @param subnets collection of subnets
+/// @param [out] positions positions 0 to subnets.size() - 1
+template<typename SubnetCollection>
+void
+getAllPositions(const SubnetCollection& subnets,
+                isc::dhcp::SubnetIndex::Positions& positions) {
+    positions.resize(subnets.size());
+    for (size_t position = 0; position < subnets.size(); ++position) {
+        positions[position] = position;
+    }
+}
+
+/// @brief Returns the subnet with the identifier.
+///
+/// @param subnets collection of subnets
+/// @param index index of the subnets, used if it has been built
+/// @param subnet_id identifier of the subnet
+/// @return subnet or NULL if there is no such subnet
+template<typename SubnetCollection>
+typename SubnetCollection::value_type
+getSubnetById(const SubnetCollection& subnets,
+              const isc::dhcp::SubnetIndex& index,
+              const isc::dhcp::SubnetID subnet_id) {
+    isc::dhcp::SubnetIndex::Positions candidates;
+    if (index.isBuilt()) {
+        index.findById(subnet_id, candidates);
+    } else {
+        getAllPositions(subnets, candidates);
+    }
+
+    for (isc::dhcp::SubnetIndex::Positions::const_iterator pos =
+             candidates.begin(); pos != candidates.end(); ++pos) {
+        if (subnets[*pos]->getID() == subnet_id) {
+            return (subnets[*pos]);
+        }
+    }
+    return (typename SubnetCollection::value_type());
+}
+
+}; // anonymous namespace
+
 namespace isc {
 namespace dhcp {
 
@@ -133,20 +180,28 @@ CfgMgr::getSubnet6(const std::string& iface,
         return (Subnet6Ptr());
     }
 
+    SubnetIndex::Positions candidates;
+    if (subnets6_index_.isBuilt()) {
+        subnets6_index_.findByIface(iface, candidates);
+    } else {
+        getAllPositions(subnets6_, candidates);
+    }
+
     // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    for (SubnetIndex::Positions::const_iterator pos = candidates.begin();
+         pos != candidates.end(); ++pos) {
+        const Subnet6Ptr& subnet = subnets6_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
-        if (iface == (*subnet)->getIface()) {
+        if (iface == subnet->getIface()) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET6_IFACE)
-                .arg((*subnet)->toText()).arg(iface);
-            return (*subnet);
+                .arg(subnet->toText()).arg(iface);
+            return (subnet);
         }
     }
     return (Subnet6Ptr());
@@ -157,28 +212,40 @@ CfgMgr::getSubnet6(const isc::asiolink::IOAddress& hint,
                    const isc::dhcp::ClientClasses& classes,
                    const bool relay) {
 
+    SubnetIndex::Positions candidates;
+    if (subnets6_index_.isBuilt()) {
+        subnets6_index_.findByAddress(hint, candidates);
+        if (relay) {
+            subnets6_index_.findByRelay(hint, candidates);
+        }
+        SubnetIndex::sortPositions(candidates);
+    } else {
+        getAllPositions(subnets6_, candidates);
+    }
+
     // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    for (SubnetIndex::Positions::const_iterator pos = candidates.begin();
+         pos != candidates.end(); ++pos) {
+        const Subnet6Ptr& subnet = subnets6_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
         // If the hint is a relay address, and there is relay info specified
         // for this subnet and those two match, then use this subnet.
-        if (relay && ((*subnet)->getRelayInfo().addr_ == hint) ) {
+        if (relay && (subnet->getRelayInfo().addr_ == hint) ) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET6_RELAY)
-                .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
 
-        if ((*subnet)->inRange(hint)) {
+        if (subnet->inRange(hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_SUBNET6)
-                      .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                      .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
     }
 
@@ -194,27 +261,40 @@ Subnet6Ptr CfgMgr::getSubnet6(OptionPtr iface_id_option,
         return (Subnet6Ptr());
     }
 
+    SubnetIndex::Positions candidates;
+    if (subnets6_index_.isBuilt()) {
+        subnets6_index_.findByInterfaceId(iface_id_option, candidates);
+    } else {
+        getAllPositions(subnets6_, candidates);
+    }
+
     // Let's iterate over all subnets and for those that have interface-id
     // defined, check if the interface-id is equal to what we are looking for
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
+    for (SubnetIndex::Positions::const_iterator pos = candidates.begin();
+         pos != candidates.end(); ++pos) {
+        const Subnet6Ptr& subnet = subnets6_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
-        if ( (*subnet)->getInterfaceId() &&
-             ((*subnet)->getInterfaceId()->equal(iface_id_option))) {
+        if ( subnet->getInterfaceId() &&
+             (subnet->getInterfaceId()->equal(iface_id_option))) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET6_IFACE_ID)
-                .arg((*subnet)->toText());
-            return (*subnet);
+                .arg(subnet->toText());
+            return (subnet);
         }
     }
     return (Subnet6Ptr());
 }
 
+Subnet6Ptr
+CfgMgr::getSubnet6(const SubnetID subnet_id) const {
+    return (getSubnetById(subnets6_, subnets6_index_, subnet_id));
+}
+
 void CfgMgr::addSubnet6(const Subnet6Ptr& subnet) {
     /// @todo: Check that this new subnet does not cross boundaries of any
     /// other already defined subnet.
@@ -222,37 +302,50 @@ void CfgMgr::addSubnet6(const Subnet6Ptr& subnet) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET6)
               .arg(subnet->toText());
     subnets6_.push_back(subnet);
+    subnets6_index_.clear();
 }
 
 Subnet4Ptr
 CfgMgr::getSubnet4(const isc::asiolink::IOAddress& hint,
                    const isc::dhcp::ClientClasses& classes,
                    bool relay) const {
+    SubnetIndex::Positions candidates;
+    if (subnets4_index_.isBuilt()) {
+        subnets4_index_.findByAddress(hint, candidates);
+        if (relay) {
+            subnets4_index_.findByRelay(hint, candidates);
+        }
+        SubnetIndex::sortPositions(candidates);
+    } else {
+        getAllPositions(subnets4_, candidates);
+    }
+
     // Iterate over existing subnets to find a suitable one for the
     // given address.
-    for (Subnet4Collection::const_iterator subnet = subnets4_.begin();
-         subnet != subnets4_.end(); ++subnet) {
+    for (SubnetIndex::Positions::const_iterator pos = candidates.begin();
+         pos != candidates.end(); ++pos) {
+        const Subnet4Ptr& subnet = subnets4_[*pos];
 
         // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
+        if (!subnet->clientSupported(classes)) {
             continue;
         }
 
         // If the hint is a relay address, and there is relay info specified
         // for this subnet and those two match, then use this subnet.
-        if (relay && ((*subnet)->getRelayInfo().addr_ == hint) ) {
+        if (relay && (subnet->getRelayInfo().addr_ == hint) ) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET4_RELAY)
-                .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
 
         // Let's check if the client belongs to the given subnet
-        if ((*subnet)->inRange(hint)) {
+        if (subnet->inRange(hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET4)
-                      .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                      .arg(subnet->toText()).arg(hint.toText());
+            return (subnet);
         }
     }
 
@@ -279,12 +372,18 @@ CfgMgr::getSubnet4(const std::string& iface_name,
     return (iface->getAddress4(addr) ? getSubnet4(addr, classes) : Subnet4Ptr());
 }
 
+Subnet4Ptr
+CfgMgr::getSubnet4(const SubnetID subnet_id) const {
+    return (getSubnetById(subnets4_, subnets4_index_, subnet_id));
+}
+
 void CfgMgr::addSubnet4(const Subnet4Ptr& subnet) {
     /// @todo: Check that this new subnet does not cross boundaries of any
     /// other already defined subnet.
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET4)
               .arg(subnet->toText());
     subnets4_.push_back(subnet);
+    subnets4_index_.clear();
 }
 
 void CfgMgr::deleteOptionDefs() {
@@ -294,11 +393,25 @@ void CfgMgr::deleteOptionDefs() {
 void CfgMgr::deleteSubnets4() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET4);
     subnets4_.clear();
+    subnets4_index_.clear();
 }
 
 void CfgMgr::deleteSubnets6() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET6);
     subnets6_.clear();
+    subnets6_index_.clear();
+}
+
+void CfgMgr::indexSubnets4() {
+    subnets4_index_.build(subnets4_);
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_INDEX_SUBNETS4)
+              .arg(subnets4_.size());
+}
+
+void CfgMgr::indexSubnets6() {
+    subnets6_index_.build(subnets6_);
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_INDEX_SUBNETS6)
+              .arg(subnets6_.size());
 }
 
 
@@ -24,6 +24,7 @@
 #include <dhcpsrv/option_space_container.h>
 #include <dhcpsrv/pool.h>
 #include <dhcpsrv/subnet.h>
+#include <dhcpsrv/subnet_index.h>
 #include <util/buffer.h>
 
 #include <boost/shared_ptr.hpp>
@@ -217,6 +218,14 @@ public:
     Subnet6Ptr getSubnet6(OptionPtr interface_id,
                           const isc::dhcp::ClientClasses& classes);
 
+    /// @brief Returns the IPv6 subnet with the identifier.
+    ///
+    /// The subnet is found with the index, if it has been built.
+    ///
+    /// @param subnet_id identifier of the subnet
+    /// @return subnet or NULL pointer if there is no such subnet
+    Subnet6Ptr getSubnet6(const SubnetID subnet_id) const;
+
     /// @brief adds an IPv6 subnet
     ///
     /// @param subnet new subnet to be added.
@@ -242,6 +251,16 @@ public:
     /// completely new?
     void deleteSubnets6();
 
+    /// @brief Builds the index used to select IPv6 subnets.
+    ///
+    /// The index speeds up the subnet selection when many subnets are
+    /// configured. It is built when the configuration of the subnets is
+    /// committed. Adding or removing subnets invalidates the index; until
+    /// it is built again, the subnets are selected by walking over all of
+    /// them. The index must be rebuilt if the relay information, interface
+    /// name or interface-id of a configured subnet is modified.
+    void indexSubnets6();
+
     /// @brief returns const reference to all subnets6
     ///
     /// This is used in a hook (subnet4_select), where the hook is able
@@ -303,6 +322,14 @@ public:
     Subnet4Ptr getSubnet4(const std::string& iface,
                           const isc::dhcp::ClientClasses& classes) const;
 
+    /// @brief Returns the IPv4 subnet with the identifier.
+    ///
+    /// See @c getSubnet6(const SubnetID) for details.
+    ///
+    /// @param subnet_id identifier of the subnet
+    /// @return subnet or NULL pointer if there is no such subnet
+    Subnet4Ptr getSubnet4(const SubnetID subnet_id) const;
+
     /// @brief adds a subnet4
     void addSubnet4(const Subnet4Ptr& subnet);
 
@@ -318,6 +345,11 @@ public:
     /// completely new?
     void deleteSubnets4();
 
+    /// @brief Builds the index used to select IPv4 subnets.
+    ///
+    /// See @c indexSubnets6 for details.
+    void indexSubnets4();
+
 
     /// @brief returns path do the data directory
     ///
@@ -428,20 +460,24 @@ protected:
 
     /// @brief a container for IPv6 subnets.
     ///
-    /// That is a simple vector of pointers. It does not make much sense to
-    /// optimize access time (e.g. using a map), because typical search
-    /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
+    /// That is a simple vector of pointers. The order of the subnets is
+    /// the order of the configuration, in which the subnets are selected.
     Subnet6Collection subnets6_;
 
+    /// @brief Index of IPv6 subnets, referring to their positions in
+    /// @c subnets6_.
+    SubnetIndex subnets6_index_;
+
     /// @brief a container for IPv4 subnets.
     ///
-    /// That is a simple vector of pointers. It does not make much sense to
-    /// optimize access time (e.g. using a map), because typical search
-    /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
+    /// That is a simple vector of pointers. The order of the subnets is
+    /// the order of the configuration, in which the subnets are selected.
     Subnet4Collection subnets4_;
 
+    /// @brief Index of IPv4 subnets, referring to their positions in
+    /// @c subnets4_.
+    SubnetIndex subnets4_index_;
+
 private:
 
     /// @brief Checks if the specified interface is listed as active.
@@ -79,7 +79,7 @@ public:
     /// @param ncr_protocol Socket protocol to use with b10-dhcp-ddns
     /// Currently only UDP is supported.
     /// @param ncr_format Format of the b10-dhcp-ddns requests.
-    /// Currently only JSON format is supported.
+    /// JSON and BINARY formats are supported.
     /// @param always_include_fqdn Enables always including the FQDN option in
     /// DHCP responses.
     /// @param override_no_update Enables updates, even if clients request no
@@ -207,7 +207,7 @@ private:
     dhcp_ddns::NameChangeProtocol ncr_protocol_;
 
     /// @brief Format of the b10-dhcp-ddns requests.
-    /// Currently only JSON format is supported.
+    /// JSON and BINARY formats are supported.
     dhcp_ddns::NameChangeFormat ncr_format_;
 
     /// @brief Should Kea always include the FQDN option in its response.
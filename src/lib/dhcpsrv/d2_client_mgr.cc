@@ -277,6 +277,7 @@ D2ClientMgr::sendRequest(dhcp_ddns::NameChangeRequestPtr& ncr) {
         isc_throw(D2ClientError, "D2ClientMgr::sendRequest not in send mode");
     }
 
+    util::thread::Mutex::Locker locker(sender_mutex_);
     try {
         name_change_sender_->sendRequest(ncr);
     } catch (const std::exception& ex) {
@@ -371,6 +372,7 @@ D2ClientMgr::runReadyIO() {
                   " name_change_sender is null");
     }
 
+    util::thread::Mutex::Locker locker(sender_mutex_);
     name_change_sender_->runReadyIO();
 }
 
@@ -23,6 +23,7 @@
 #include <dhcp_ddns/ncr_io.h>
 #include <dhcpsrv/d2_client_cfg.h>
 #include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
@@ -260,6 +261,10 @@ public:
     ///
     /// @param ncr NameChangeRequest to send
     ///
+    /// This method may be called by the packet processing threads of the
+    /// server while the main thread runs the sender's IO in
+    /// @c runReadyIO, so the two are serialized.
+    ///
     /// @throw D2ClientError if sender instance is null or not in send
     /// mode.  Either of these represents a programmatic error.
     void sendRequest(dhcp_ddns::NameChangeRequestPtr& ncr);
@@ -373,6 +378,9 @@ private:
 
     /// @brief Remembers the select-fd registered with IfaceMgr.
     int registered_select_fd_;
+
+    /// @brief Serializes @c sendRequest and @c runReadyIO.
+    util::thread::Mutex sender_mutex_;
 };
 
 template <class T>
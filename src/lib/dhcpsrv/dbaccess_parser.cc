@@ -17,6 +17,7 @@
 #include <dhcpsrv/lease_mgr_factory.h>
 
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <map>
 #include <string>
@@ -51,8 +52,15 @@ DbAccessParser::build(isc::data::ConstElementPtr config_value) {
     std::map<string, string> values_copy = values_;
 
     // 2. Update the copy with the passed keywords.
+    // The numeric parameters (e.g. "sync-batch" of the memfile backend)
+    // are passed to the lease manager as strings, like the other ones.
     BOOST_FOREACH(ConfigPair param, config_value->mapValue()) {
-        values_copy[param.first] = param.second->stringValue();
+        if (param.second->getType() == Element::integer) {
+            values_copy[param.first] =
+                boost::lexical_cast<string>(param.second->intValue());
+        } else {
+            values_copy[param.first] = param.second->stringValue();
+        }
     }
 
     // 3. Perform validation checks on the updated set of keyword/values.
@@ -14,6 +14,9 @@
 
 #include <dhcp/iface_mgr.h>
 #include <dhcp/libdhcp++.h>
+#include <dhcp/pkt4.h>
+#include <dhcp/pkt6.h>
+#include <dhcpsrv/callout_handle_store.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcp_parsers.h>
 #include <hooks/hooks_manager.h>
@@ -298,8 +301,10 @@ HooksLibrariesParser::commit() {
     /// Commits the list of libraries to the configuration manager storage if
     /// the list of libraries has changed.
     if (changed_) {
-        // TODO Delete any stored CalloutHandles before reloading the
-        // libraries
+        // Delete the stored CalloutHandles before reloading the libraries,
+        // so as the old libraries are actually unloaded.
+        CalloutHandleStore<Pkt4Ptr>::clearAll();
+        CalloutHandleStore<Pkt6Ptr>::clearAll();
         HooksManager::loadLibraries(libraries_);
     }
 }
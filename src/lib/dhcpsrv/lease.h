@@ -141,6 +141,12 @@ struct Lease {
     /// @return true if the lease is expired
     bool expired() const;
 
+    /// @brief Returns the time when the lease expires.
+    ///
+    /// @return Expiration time in seconds since the epoch (cltt + valid
+    /// lifetime).
+    int64_t getExpirationTime() const;
+
     /// @brief Returns true if the other lease has equal FQDN data.
     ///
     /// @param other Lease which FQDN data is to be compared with our lease.
@@ -0,0 +1,531 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/lease_journal.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <exceptions/exceptions.h>
+#include <util/encode/hex.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace isc::asiolink;
+using namespace isc::util::encode;
+using namespace std;
+
+namespace {
+
+/// @brief Number of comma separated fields in the "lease4" record.
+const size_t LEASE4_FIELDS = 12;
+
+/// @brief Number of comma separated fields in the "lease6" record.
+const size_t LEASE6_FIELDS = 15;
+
+/// @brief Number of hexadecimal digits of the record checksum.
+const size_t CHECKSUM_DIGITS = 8;
+
+/// @brief Computes the checksum of the record contents.
+///
+/// This is the 32-bit FNV-1a hash, which is cheap to compute and detects
+/// a record cut short at any point.
+///
+/// @param text Record contents, without the checksum.
+///
+/// @return Checksum as hexadecimal digits.
+string
+computeChecksum(const string& text) {
+    uint32_t hash = 2166136261U;
+    for (string::const_iterator c = text.begin(); c != text.end(); ++c) {
+        hash ^= static_cast<uint8_t>(*c);
+        hash *= 16777619U;
+    }
+    ostringstream s;
+    s << hex << setfill('0') << setw(CHECKSUM_DIGITS) << hash;
+    return (s.str());
+}
+
+/// @brief Returns the contents of the record which checksum is valid.
+///
+/// The checksum is the last field of the record, so as a record which
+/// was only partially written (e.g. cut inside the hostname) is rejected.
+///
+/// @param line Record, with its checksum.
+///
+/// @return Record contents without the checksum.
+///
+/// @throw BadValue if the checksum is missing or doesn't match.
+string
+checkRecord(const string& line) {
+    if ((line.size() <= CHECKSUM_DIGITS) ||
+        (line[line.size() - CHECKSUM_DIGITS - 1] != ',')) {
+        isc_throw(isc::BadValue, "record has no checksum, it may have been"
+                  " partially written");
+    }
+    const string text = line.substr(0, line.size() - CHECKSUM_DIGITS - 1);
+    if (line.compare(line.size() - CHECKSUM_DIGITS, CHECKSUM_DIGITS,
+                     computeChecksum(text)) != 0) {
+        isc_throw(isc::BadValue, "checksum mismatch, the record may have"
+                  " been partially written");
+    }
+    return (text);
+}
+
+/// @brief Escapes characters which would break the record structure.
+///
+/// The hostname is the last field of the lease records so it may contain
+/// commas, but it must not contain new line characters.
+string
+escapeText(const string& text) {
+    string escaped;
+    escaped.reserve(text.size());
+    for (string::const_iterator c = text.begin(); c != text.end(); ++c) {
+        switch (*c) {
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        case '\r':
+            escaped += "\\r";
+            break;
+        default:
+            escaped += *c;
+        }
+    }
+    return (escaped);
+}
+
+/// @brief Reverses @c escapeText.
+string
+unescapeText(const string& text) {
+    string unescaped;
+    unescaped.reserve(text.size());
+    for (string::const_iterator c = text.begin(); c != text.end(); ++c) {
+        if ((*c != '\\') || (c + 1 == text.end())) {
+            unescaped += *c;
+            continue;
+        }
+        ++c;
+        switch (*c) {
+        case 'n':
+            unescaped += '\n';
+            break;
+        case 'r':
+            unescaped += '\r';
+            break;
+        default:
+            unescaped += *c;
+        }
+    }
+    return (unescaped);
+}
+
+/// @brief Splits the record into fields.
+///
+/// The last field takes the remainder of the record, including commas.
+///
+/// @param line Record to be split.
+/// @param count Expected number of fields.
+/// @param [out] fields Fields of the record.
+void
+splitRecord(const string& line, const size_t count, vector<string>& fields) {
+    size_t start = 0;
+    while (fields.size() + 1 < count) {
+        size_t pos = line.find(',', start);
+        if (pos == string::npos) {
+            isc_throw(isc::BadValue, "expected " << count << " fields but"
+                      " found " << fields.size() + 1);
+        }
+        fields.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+    fields.push_back(line.substr(start));
+}
+
+/// @brief Converts the text field to the numeric value.
+template<typename T>
+T
+toNumber(const string& field, const char* name) {
+    try {
+        // Parse as a wider integer so as uint8_t is not treated as
+        // a character.
+        int64_t value = boost::lexical_cast<int64_t>(field);
+        if ((value < 0) ||
+            (static_cast<uint64_t>(value) > std::numeric_limits<T>::max())) {
+            isc_throw(isc::BadValue, "value of the " << name << " field '"
+                      << field << "' is out of range");
+        }
+        return (static_cast<T>(value));
+
+    } catch (const boost::bad_lexical_cast&) {
+        isc_throw(isc::BadValue, "invalid value of the " << name << " field '"
+                  << field << "'");
+    }
+}
+
+/// @brief Converts the "0" or "1" field to the boolean value.
+bool
+toBool(const string& field, const char* name) {
+    if (field == "1") {
+        return (true);
+    } else if (field == "0") {
+        return (false);
+    }
+    isc_throw(isc::BadValue, "invalid value of the " << name << " field '"
+              << field << "'");
+}
+
+}
+
+namespace isc {
+namespace dhcp {
+
+LeaseJournal::LeaseJournal(const std::string& filename,
+                           uint32_t sync_batch)
+    : filename_(filename), sync_batch_(sync_batch), file_(NULL), line_(0),
+      records_(0), unsynced_(0), invalid_(0) {
+}
+
+LeaseJournal::~LeaseJournal() {
+    // The destructor must not throw, so the failure to synchronize the
+    // file is ignored. Whatever has been written to the file is in the
+    // kernel's hands anyway.
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void
+LeaseJournal::open(const bool truncate) {
+    close();
+
+    file_ = fopen(filename_.c_str(), truncate ? "w+" : "a+");
+    if (file_ == NULL) {
+        isc_throw(DbOpenError, "unable to open the lease journal '"
+                  << filename_ << "': " << strerror(errno));
+    }
+
+    if (truncate) {
+        records_ = 0;
+        return;
+    }
+
+    // If the last record has no terminating new line, it has been only
+    // partially written (and rejected by the replay). It is cut off, so
+    // as the records appended next are not glued to it.
+    struct stat st;
+    bool failed = (fstat(fileno(file_), &st) != 0);
+    off_t end = failed ? 0 : st.st_size;
+    while (!failed && (end > 0)) {
+        int c = EOF;
+        failed = ((fseeko(file_, end - 1, SEEK_SET) != 0) ||
+                  ((c = fgetc(file_)) == EOF));
+        if (c == '\n') {
+            break;
+        }
+        --end;
+    }
+    if (!failed && (end != st.st_size)) {
+        failed = (ftruncate(fileno(file_), end) != 0);
+    }
+    if (failed) {
+        int error = errno;
+        close();
+        isc_throw(DbOpenError, "unable to remove the partially written"
+                  " record from the lease journal '" << filename_ << "': "
+                  << strerror(error));
+    }
+    // A read must be followed by a seek before the next write.
+    fseeko(file_, 0, SEEK_END);
+}
+
+void
+LeaseJournal::close() {
+    if (file_ != NULL) {
+        sync();
+        fclose(file_);
+        file_ = NULL;
+    }
+}
+
+void
+LeaseJournal::append(const Lease4& lease) {
+    std::ostringstream s;
+    s << "lease4," << lease.addr_.toText() << ","
+      << encodeHex(lease.hwaddr_) << ","
+      << encodeHex(lease.getClientIdVector()) << ","
+      << lease.valid_lft_ << "," << lease.t1_ << "," << lease.t2_ << ","
+      << static_cast<int64_t>(lease.cltt_) << "," << lease.subnet_id_ << ","
+      << (lease.fqdn_fwd_ ? "1" : "0") << "," << (lease.fqdn_rev_ ? "1" : "0")
+      << "," << escapeText(lease.hostname_);
+    write(s.str());
+}
+
+void
+LeaseJournal::append(const Lease6& lease) {
+    std::ostringstream s;
+    s << "lease6," << lease.addr_.toText() << ","
+      << static_cast<int>(lease.type_) << ","
+      << encodeHex(lease.getDuidVector()) << "," << lease.iaid_ << ","
+      << lease.preferred_lft_ << "," << lease.valid_lft_ << ","
+      << lease.t1_ << "," << lease.t2_ << ","
+      << static_cast<int64_t>(lease.cltt_) << "," << lease.subnet_id_ << ","
+      << static_cast<int>(lease.prefixlen_) << ","
+      << (lease.fqdn_fwd_ ? "1" : "0") << "," << (lease.fqdn_rev_ ? "1" : "0")
+      << "," << escapeText(lease.hostname_);
+    write(s.str());
+}
+
+void
+LeaseJournal::appendDelete(const isc::asiolink::IOAddress& addr) {
+    write((addr.isV4() ? "delete4," : "delete6,") + addr.toText());
+}
+
+void
+LeaseJournal::write(const std::string& record) {
+    writeLine(record + "," + computeChecksum(record));
+}
+
+void
+LeaseJournal::writeLine(const std::string& line) {
+    if (file_ == NULL) {
+        isc_throw(DbOperationError, "lease journal '" << filename_
+                  << "' is not open");
+    }
+
+    // Handing the record to the kernel right away guarantees that it is
+    // not lost if the server process dies. Surviving the power loss
+    // requires fsync, which is deferred until the batch is complete.
+    if ((fputs(line.c_str(), file_) == EOF) ||
+        (fputc('\n', file_) == EOF) || (fflush(file_) != 0)) {
+        isc_throw(DbOperationError, "failed to write to the lease journal '"
+                  << filename_ << "': " << strerror(errno));
+    }
+    ++records_;
+
+    if (++unsynced_ >= sync_batch_) {
+        sync();
+    }
+}
+
+void
+LeaseJournal::appendTail(const std::string& filename, const uint64_t offset) {
+    std::ifstream input(filename.c_str());
+    if (!input.is_open() ||
+        !input.seekg(static_cast<std::streamoff>(offset))) {
+        isc_throw(DbOperationError, "unable to read the lease journal '"
+                  << filename << "' from offset " << offset);
+    }
+    // The records are copied with their checksums. The last one may be
+    // still being written, in which case it is not copied.
+    std::string line;
+    while (std::getline(input, line)) {
+        try {
+            checkRecord(line);
+        } catch (const isc::BadValue&) {
+            continue;
+        }
+        writeLine(line);
+    }
+}
+
+uint64_t
+LeaseJournal::getSize() const {
+    struct stat st;
+    if ((file_ == NULL) || (fstat(fileno(file_), &st) != 0)) {
+        return (0);
+    }
+    return (static_cast<uint64_t>(st.st_size));
+}
+
+void
+LeaseJournal::replace(LeaseJournal& other) {
+    other.close();
+    close();
+    if (rename(other.filename_.c_str(), filename_.c_str()) != 0) {
+        int error = errno;
+        open();
+        isc_throw(DbOperationError, "failed to replace the lease journal '"
+                  << filename_ << "' with '" << other.filename_ << "': "
+                  << strerror(error));
+    }
+    records_ = other.records_;
+    open();
+
+    // The rename is only durable once the directory holding the journal
+    // has been synchronized. Until then the old journal may reappear after
+    // the power loss, together with the records appended to the new one
+    // being lost.
+    const size_t slash = filename_.find_last_of('/');
+    const std::string dirname = (slash == std::string::npos ? "." :
+                                 (slash == 0 ? "/" :
+                                  filename_.substr(0, slash)));
+    int dir = ::open(dirname.c_str(), O_RDONLY);
+    if ((dir < 0) || (fsync(dir) != 0)) {
+        int error = errno;
+        if (dir >= 0) {
+            ::close(dir);
+        }
+        isc_throw(DbOperationError, "failed to synchronize the directory '"
+                  << dirname << "' of the lease journal '" << filename_
+                  << "': " << strerror(error));
+    }
+    ::close(dir);
+}
+
+void
+LeaseJournal::sync() {
+    if ((file_ == NULL) || (unsynced_ == 0)) {
+        return;
+    }
+    if ((fflush(file_) != 0) || (fsync(fileno(file_)) != 0)) {
+        isc_throw(DbOperationError, "failed to synchronize the lease journal '"
+                  << filename_ << "': " << strerror(errno));
+    }
+    unsynced_ = 0;
+}
+
+void
+LeaseJournal::startReplay() {
+    input_.reset(new std::ifstream(filename_.c_str()));
+    line_ = 0;
+    records_ = 0;
+    invalid_ = 0;
+}
+
+bool
+LeaseJournal::readRecord(Record& record) {
+    if (!input_ || !input_->is_open()) {
+        return (false);
+    }
+
+    std::string line;
+    while (std::getline(*input_, line)) {
+        ++line_;
+        try {
+            parseRecord(line, record);
+            ++records_;
+            return (true);
+
+        } catch (const std::exception& ex) {
+            ++invalid_;
+            LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_JOURNAL_INVALID_RECORD)
+                .arg(line_).arg(filename_).arg(ex.what());
+        }
+    }
+
+    input_.reset();
+    return (false);
+}
+
+void
+LeaseJournal::parseRecord(const std::string& line, Record& record) {
+    const std::string text = checkRecord(line);
+    std::string type = text.substr(0, text.find(','));
+    std::vector<std::string> fields;
+
+    if (type == "lease4") {
+        splitRecord(text, LEASE4_FIELDS, fields);
+        Lease4Ptr lease(new Lease4());
+        lease->addr_ = IOAddress(fields[1]);
+        if (!lease->addr_.isV4()) {
+            isc_throw(BadValue, "address " << fields[1] << " is not IPv4");
+        }
+        decodeHex(fields[2], lease->hwaddr_);
+        std::vector<uint8_t> client_id;
+        decodeHex(fields[3], client_id);
+        if (!client_id.empty()) {
+            lease->client_id_.reset(new ClientId(client_id));
+        }
+        lease->valid_lft_ = toNumber<uint32_t>(fields[4], "valid lifetime");
+        lease->t1_ = toNumber<uint32_t>(fields[5], "t1");
+        lease->t2_ = toNumber<uint32_t>(fields[6], "t2");
+        lease->cltt_ = toNumber<time_t>(fields[7], "cltt");
+        lease->subnet_id_ = toNumber<SubnetID>(fields[8], "subnet id");
+        lease->fqdn_fwd_ = toBool(fields[9], "fqdn forward");
+        lease->fqdn_rev_ = toBool(fields[10], "fqdn reverse");
+        lease->hostname_ = unescapeText(fields[11]);
+
+        record.type_ = RECORD_LEASE4;
+        record.addr_ = lease->addr_;
+        record.lease4_ = lease;
+        record.lease6_.reset();
+
+    } else if (type == "lease6") {
+        splitRecord(text, LEASE6_FIELDS, fields);
+        Lease6Ptr lease(new Lease6());
+        lease->addr_ = IOAddress(fields[1]);
+        if (!lease->addr_.isV6()) {
+            isc_throw(BadValue, "address " << fields[1] << " is not IPv6");
+        }
+        uint8_t lease_type = toNumber<uint8_t>(fields[2], "lease type");
+        if (lease_type > Lease::TYPE_PD) {
+            isc_throw(BadValue, "invalid lease type " << fields[2]);
+        }
+        lease->type_ = static_cast<Lease::Type>(lease_type);
+        std::vector<uint8_t> duid;
+        decodeHex(fields[3], duid);
+        if (!duid.empty()) {
+            lease->duid_.reset(new DUID(duid));
+        }
+        lease->iaid_ = toNumber<uint32_t>(fields[4], "iaid");
+        lease->preferred_lft_ = toNumber<uint32_t>(fields[5],
+                                                   "preferred lifetime");
+        lease->valid_lft_ = toNumber<uint32_t>(fields[6], "valid lifetime");
+        lease->t1_ = toNumber<uint32_t>(fields[7], "t1");
+        lease->t2_ = toNumber<uint32_t>(fields[8], "t2");
+        lease->cltt_ = toNumber<time_t>(fields[9], "cltt");
+        lease->subnet_id_ = toNumber<SubnetID>(fields[10], "subnet id");
+        lease->prefixlen_ = toNumber<uint8_t>(fields[11], "prefix length");
+        lease->fqdn_fwd_ = toBool(fields[12], "fqdn forward");
+        lease->fqdn_rev_ = toBool(fields[13], "fqdn reverse");
+        lease->hostname_ = unescapeText(fields[14]);
+
+        record.type_ = RECORD_LEASE6;
+        record.addr_ = lease->addr_;
+        record.lease4_.reset();
+        record.lease6_ = lease;
+
+    } else if ((type == "delete4") || (type == "delete6")) {
+        splitRecord(text, 2, fields);
+        IOAddress addr(fields[1]);
+        if ((type == "delete4") != addr.isV4()) {
+            isc_throw(BadValue, "address " << fields[1] << " does not match"
+                      " the record type " << type);
+        }
+        record.type_ = addr.isV4() ? RECORD_DELETE4 : RECORD_DELETE6;
+        record.addr_ = addr;
+        record.lease4_.reset();
+        record.lease6_.reset();
+
+    } else {
+        isc_throw(BadValue, "unknown record type '" << type << "'");
+    }
+}
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
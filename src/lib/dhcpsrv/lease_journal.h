@@ -0,0 +1,281 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LEASE_JOURNAL_H
+#define LEASE_JOURNAL_H
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/lease.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Append-only on-disk journal of lease changes.
+///
+/// The journal is used by the @c Memfile_LeaseMgr to make its in-memory
+/// lease database survive restarts. Every change to the lease database
+/// is appended to the journal file as a single text record (one line):
+///
+/// - "lease4,..." and "lease6,..." records hold the complete state of the
+///   lease after it has been added or updated,
+/// - "delete4,<address>" and "delete6,<address>" records indicate that
+///   the lease for the address has been removed.
+///
+/// The last field of each record is the checksum of the preceding ones,
+/// so as a record only partially written when the server crashed is
+/// rejected wherever it was cut, including inside the hostname.
+///
+/// Replaying the journal from the beginning reproduces the state of the
+/// lease database. Since most records are superseded by later records
+/// for the same address, the journal is periodically rewritten (compacted)
+/// to hold one record per live lease.
+///
+/// The file is written using C stdio functions rather than C++ streams,
+/// because the latter offer no way to force the data onto the disk, like
+/// fflush() and fsync() do. Each record is handed to the kernel
+/// immediately (so it survives a crash of the server process), but fsync()
+/// is only called every "sync batch" records and on explicit call to
+/// @c sync(). This groups the costly disk synchronization of many lease
+/// changes together.
+class LeaseJournal : public boost::noncopyable {
+public:
+
+    /// @brief Type of the journal record.
+    enum RecordType {
+        RECORD_LEASE4,   ///< IPv4 lease added or updated
+        RECORD_DELETE4,  ///< IPv4 lease deleted
+        RECORD_LEASE6,   ///< IPv6 lease added or updated
+        RECORD_DELETE6   ///< IPv6 lease deleted
+    };
+
+    /// @brief A single record read back from the journal.
+    struct Record {
+        /// @brief Constructor
+        Record()
+            : type_(RECORD_DELETE4), addr_("0.0.0.0") {
+        }
+
+        /// @brief Type of the record.
+        RecordType type_;
+
+        /// @brief Address of the lease the record pertains to.
+        isc::asiolink::IOAddress addr_;
+
+        /// @brief Lease held by the RECORD_LEASE4 record.
+        Lease4Ptr lease4_;
+
+        /// @brief Lease held by the RECORD_LEASE6 record.
+        Lease6Ptr lease6_;
+    };
+
+    /// @brief Constructor
+    ///
+    /// The constructor does not open the file. @c open must be called
+    /// before the records can be appended.
+    ///
+    /// @param filename Name of the journal file.
+    /// @param sync_batch Number of appended records after which the file is
+    /// synchronized with the disk. The value of 0 or 1 causes the file to be
+    /// synchronized after each record.
+    LeaseJournal(const std::string& filename, uint32_t sync_batch = 1);
+
+    /// @brief Destructor
+    ///
+    /// Synchronizes and closes the journal file if it is open.
+    ~LeaseJournal();
+
+    /// @brief Returns the name of the journal file.
+    std::string getFilename() const {
+        return (filename_);
+    }
+
+    /// @brief Opens the journal file for appending.
+    ///
+    /// The file is created if it doesn't exist. If the last record in the
+    /// existing file has no terminating new line (e.g. the server crashed
+    /// while writing it) the partial record is removed from the file, so
+    /// that it doesn't corrupt the records appended after it.
+    ///
+    /// @param truncate Discard the existing contents of the file.
+    ///
+    /// @throw DbOpenError if the file can't be opened.
+    void open(const bool truncate = false);
+
+    /// @brief Synchronizes and closes the journal file.
+    void close();
+
+    /// @brief Checks if the journal file is open for appending.
+    bool isOpen() const {
+        return (file_ != NULL);
+    }
+
+    /// @brief Appends the record holding an IPv4 lease.
+    ///
+    /// @param lease Lease added to or updated in the database.
+    ///
+    /// @throw DbOperationError if the record could not be written.
+    void append(const Lease4& lease);
+
+    /// @brief Appends the record holding an IPv6 lease.
+    ///
+    /// @param lease Lease added to or updated in the database.
+    ///
+    /// @throw DbOperationError if the record could not be written.
+    void append(const Lease6& lease);
+
+    /// @brief Appends the record indicating that the lease was deleted.
+    ///
+    /// @param addr Address of the deleted lease (IPv4 or IPv6).
+    ///
+    /// @throw DbOperationError if the record could not be written.
+    void appendDelete(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Appends the records held in another journal file.
+    ///
+    /// This is used to copy the records appended to the journal while its
+    /// compacted copy was being written. The records which checksum is
+    /// not valid are not copied.
+    ///
+    /// @param filename Name of the journal file which records are copied.
+    /// @param offset Offset in the file of the first record to be copied.
+    ///
+    /// @throw DbOperationError if the file could not be read or the
+    /// records could not be written.
+    void appendTail(const std::string& filename, const uint64_t offset);
+
+    /// @brief Returns the size of the journal file open for appending.
+    ///
+    /// As each record is handed to the kernel as soon as it is written,
+    /// this is the offset at which the next record will be appended.
+    ///
+    /// @return Size of the file in bytes or 0 if the file is not open.
+    uint64_t getSize() const;
+
+    /// @brief Replaces the journal file with the file of another journal.
+    ///
+    /// Both journals are closed and the file of the other journal is
+    /// atomically renamed to the name of this journal, which is then
+    /// reopened for appending. The directory holding the journal is
+    /// synchronized, so as the rename survives the power loss. This is
+    /// used to install the compacted copy of the journal.
+    ///
+    /// @param other Journal which file replaces the file of this journal.
+    ///
+    /// @throw DbOperationError if the file could not be replaced. The
+    /// original journal file is reopened in such case. The exception is
+    /// also thrown if the directory could not be synchronized; the journal
+    /// has been replaced and reopened then.
+    void replace(LeaseJournal& other);
+
+    /// @brief Forces the records appended so far onto the disk.
+    ///
+    /// @throw DbOperationError if the file could not be synchronized.
+    void sync();
+
+    /// @brief Returns the number of records held in the journal file.
+    ///
+    /// This includes the records read by @c readRecord and the records
+    /// appended since the file was opened.
+    size_t getRecordCount() const {
+        return (records_);
+    }
+
+    /// @brief Returns the number of records not yet synchronized.
+    size_t getUnsyncedCount() const {
+        return (unsynced_);
+    }
+
+    /// @brief Positions the journal at its first record for reading.
+    ///
+    /// The records count is reset to 0 and then increased for each valid
+    /// record read by @c readRecord. If the file doesn't exist, the
+    /// journal is considered empty.
+    void startReplay();
+
+    /// @brief Reads the next record from the journal.
+    ///
+    /// Invalid records (e.g. a record truncated by a crash) are skipped
+    /// and logged.
+    ///
+    /// @param [out] record Record read from the journal.
+    ///
+    /// @return true if the record has been read, false if there are no
+    /// more records in the journal.
+    bool readRecord(Record& record);
+
+    /// @brief Returns the number of invalid records skipped by the replay.
+    size_t getInvalidCount() const {
+        return (invalid_);
+    }
+
+    /// @brief Converts a text record into the @c Record.
+    ///
+    /// @param line Text record without the trailing new line character.
+    /// @param [out] record Parsed record.
+    ///
+    /// @throw BadValue if the record is malformed or its checksum is
+    /// missing or doesn't match.
+    static void parseRecord(const std::string& line, Record& record);
+
+private:
+
+    /// @brief Writes a single text record with its checksum.
+    ///
+    /// @param record Text record without the checksum and the trailing
+    /// new line character.
+    void write(const std::string& record);
+
+    /// @brief Writes a single line and synchronizes the file if the sync
+    /// batch has been reached.
+    ///
+    /// @param line Text record with its checksum, without the trailing
+    /// new line character.
+    void writeLine(const std::string& line);
+
+    /// @brief Name of the journal file.
+    std::string filename_;
+
+    /// @brief Number of records after which the file is synchronized.
+    uint32_t sync_batch_;
+
+    /// @brief File handle of the file open for appending.
+    FILE* file_;
+
+    /// @brief Stream used to read the records during the replay.
+    boost::scoped_ptr<std::ifstream> input_;
+
+    /// @brief Number of the last line read during the replay.
+    size_t line_;
+
+    /// @brief Number of records held in the file.
+    size_t records_;
+
+    /// @brief Number of records appended since the last synchronization.
+    size_t unsynced_;
+
+    /// @brief Number of invalid records skipped during the replay.
+    size_t invalid_;
+};
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // LEASE_JOURNAL_H
@@ -57,5 +57,42 @@ LeaseMgr::getLease6(Lease::Type type, const DUID& duid,
     return (*col.begin());
 }
 
+void
+LeaseMgr::writeLeases(LeaseWriteCollection& writes) {
+    for (LeaseWriteCollection::iterator write = writes.begin();
+         write != writes.end(); ++write) {
+        writeLease(*write);
+    }
+    commit();
+}
+
+void
+LeaseMgr::writeLease(LeaseWrite& write) {
+    try {
+        switch (write.type_) {
+        case LeaseWrite::ADD:
+            write.result_ = (write.lease4_ ? addLease(write.lease4_) :
+                             addLease(write.lease6_));
+            break;
+
+        case LeaseWrite::UPDATE:
+            if (write.lease4_) {
+                updateLease4(write.lease4_);
+            } else {
+                updateLease6(write.lease6_);
+            }
+            write.result_ = true;
+            break;
+
+        case LeaseWrite::DELETE:
+            write.result_ = deleteLease(write.addr_);
+            break;
+        }
+    } catch (const std::exception& ex) {
+        write.result_ = false;
+        write.error_ = ex.what();
+    }
+}
+
 } // namespace isc::dhcp
 } // namespace isc
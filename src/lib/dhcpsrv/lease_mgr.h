@@ -110,6 +110,69 @@ public:
 };
 
 
+/// @brief Lease write executed as a part of the batch.
+///
+/// The batch of writes is passed to @c LeaseMgr::writeLeases, which
+/// executes the writes in order and stores the outcome of each of them
+/// in the @c result_ and @c error_ members.
+struct LeaseWrite {
+    /// @brief Type of the write.
+    enum Type {
+        ADD,     ///< Add the lease (@c LeaseMgr::addLease).
+        UPDATE,  ///< Update the lease (@c LeaseMgr::updateLease4/6).
+        DELETE   ///< Delete the lease (@c LeaseMgr::deleteLease).
+    };
+
+    /// @brief Constructor for the write of the IPv4 lease.
+    ///
+    /// @param type Type of the write.
+    /// @param lease Lease to be written. Only its address is used to
+    ///        delete the lease.
+    LeaseWrite(const Type type, const Lease4Ptr& lease)
+        : type_(type), lease4_(lease), addr_(lease->addr_), result_(false) {
+    }
+
+    /// @brief Constructor for the write of the IPv6 lease.
+    ///
+    /// @param type Type of the write.
+    /// @param lease Lease to be written. Only its address is used to
+    ///        delete the lease.
+    LeaseWrite(const Type type, const Lease6Ptr& lease)
+        : type_(type), lease6_(lease), addr_(lease->addr_), result_(false) {
+    }
+
+    /// @brief Constructor for the deletion of the lease.
+    ///
+    /// @param addr Address of the lease to be deleted.
+    LeaseWrite(const isc::asiolink::IOAddress& addr)
+        : type_(DELETE), addr_(addr), result_(false) {
+    }
+
+    /// @brief Type of the write.
+    Type type_;
+
+    /// @brief IPv4 lease to be added or updated.
+    Lease4Ptr lease4_;
+
+    /// @brief IPv6 lease to be added or updated.
+    Lease6Ptr lease6_;
+
+    /// @brief Address of the lease.
+    isc::asiolink::IOAddress addr_;
+
+    /// @brief Result of the write.
+    ///
+    /// It is the value returned by @c addLease or @c deleteLease. For the
+    /// update it is true if the lease has been updated.
+    bool result_;
+
+    /// @brief Error message if the write has failed with an exception.
+    std::string error_;
+};
+
+/// @brief A collection of the lease writes.
+typedef std::vector<LeaseWrite> LeaseWriteCollection;
+
 /// @brief Abstract Lease Manager
 ///
 /// This is an abstract API for lease database backends. It provides unified
@@ -298,6 +361,58 @@ public:
     Lease6Ptr getLease6(Lease::Type type, const DUID& duid,
                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// The leases are returned in the order of their expiration times,
+    /// starting from the one which expired first. The backends maintain
+    /// an index of the expiration times, so the cost of this call depends
+    /// on the number of returned leases rather than on the number of all
+    /// leases.
+    ///
+    /// @param [out] expired_leases The expired leases are appended to this
+    ///        collection.
+    /// @param max_leases Maximum number of leases returned; 0 means that
+    ///        all expired leases are returned.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const = 0;
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// See @c getExpiredLeases4 for details.
+    ///
+    /// @param [out] expired_leases The expired leases are appended to this
+    ///        collection.
+    /// @param max_leases Maximum number of leases returned; 0 means that
+    ///        all expired leases are returned.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const = 0;
+
+    /// @brief Returns the IPv4 leases for the addresses in the range.
+    ///
+    /// It is used to collect the usage of a pool with a single query
+    /// rather than with a query for each address of the pool.
+    ///
+    /// @param lower first address of the range
+    /// @param upper last address of the range
+    ///
+    /// @return collection of the leases (may be empty if no lease is found)
+    virtual Lease4Collection
+    getLeases4(const isc::asiolink::IOAddress& lower,
+               const isc::asiolink::IOAddress& upper) const = 0;
+
+    /// @brief Returns the IPv6 leases for the addresses in the range.
+    ///
+    /// See @c getLeases4 for details.
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param lower first address (or prefix) of the range
+    /// @param upper last address (or prefix) of the range
+    ///
+    /// @return collection of the leases (may be empty if no lease is found)
+    virtual Lease6Collection
+    getLeases6(Lease::Type type, const isc::asiolink::IOAddress& lower,
+               const isc::asiolink::IOAddress& upper) const = 0;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
@@ -318,6 +433,22 @@ public:
     /// @return true if deletion was successful, false if no such lease exists
     virtual bool deleteLease(const isc::asiolink::IOAddress& addr) = 0;
 
+    /// @brief Executes a batch of lease writes.
+    ///
+    /// The writes are executed in order and their results are stored in
+    /// the collection. Failure of one write doesn't prevent the execution
+    /// of the others. The changes are committed at the end of the batch.
+    ///
+    /// The default implementation executes each write with the respective
+    /// single lease method. The backends may override it to execute the
+    /// batch more efficiently, e.g. in one database transaction.
+    ///
+    /// @param writes Writes to be executed.
+    ///
+    /// @throw isc::dhcp::DbOperationError if the writes could not be
+    ///        committed.
+    virtual void writeLeases(LeaseWriteCollection& writes);
+
     /// @brief Return backend type
     ///
     /// Returns the type of the backend (e.g. "mysql", "memfile" etc.)
@@ -375,6 +506,15 @@ public:
     /// @brief returns value of the parameter
     virtual std::string getParameter(const std::string& name) const;
 
+protected:
+    /// @brief Executes a single lease write of the batch.
+    ///
+    /// Any exception thrown by the backend is caught and its message is
+    /// stored in the @c LeaseWrite::error_.
+    ///
+    /// @param write Write to be executed.
+    void writeLease(LeaseWrite& write);
+
 private:
     /// @brief list of parameters passed in dbconfig
     ///
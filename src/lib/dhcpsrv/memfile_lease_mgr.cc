@@ -16,16 +16,135 @@
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <exceptions/exceptions.h>
 
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
 #include <iostream>
 
+#include <time.h>
+#include <unistd.h>
+
 using namespace isc::dhcp;
+using isc::util::thread::Mutex;
+using isc::util::thread::Thread;
+
+namespace {
+
+/// @brief Appends copies of the expired leases to the collection.
+///
+/// @param index Index sorting the leases by the expiration time.
+/// @param [out] expired_leases Collection to which the leases are appended.
+/// @param max_leases Maximum number of leases appended; 0 means no limit.
+template<typename IndexType, typename LeaseType>
+void
+getExpiredLeasesCommon(const IndexType& index,
+                       std::vector<boost::shared_ptr<LeaseType> >&
+                       expired_leases, const size_t max_leases) {
+    const int64_t now = time(NULL);
+    size_t count = 0;
+    for (typename IndexType::const_iterator lease = index.begin();
+         (lease != index.end()) && ((*lease)->getExpirationTime() < now) &&
+             ((max_leases == 0) || (count < max_leases));
+         ++lease, ++count) {
+        expired_leases.push_back(boost::shared_ptr<LeaseType>
+                                 (new LeaseType(**lease)));
+    }
+}
+
+/// @brief Functor assigning the new value to the lease held in storage.
+///
+/// It is used with the @c modify function of the multi index container,
+/// which re-indexes the lease after the assignment.
+template<typename LeaseType>
+class LeaseAssigner {
+public:
+    /// @brief Constructor.
+    ///
+    /// @param lease New value of the lease.
+    LeaseAssigner(const LeaseType& lease)
+        : lease_(lease) {
+    }
+
+    /// @brief Assigns the new value to the stored lease.
+    ///
+    /// @param stored_lease Pointer to the lease held in the storage.
+    void operator()(boost::shared_ptr<LeaseType>& stored_lease) const {
+        *stored_lease = lease_;
+    }
+
+private:
+    /// @brief New value of the lease.
+    const LeaseType& lease_;
+};
+
+/// @brief Replaces the lease held in the storage and records the new
+/// value in the journal.
+///
+/// The hashed indexes locate the leases by the hash of the client's
+/// identifiers, so the lease must not be overwritten in place: the
+/// identifiers of the reused lease are typically different. The lease is
+/// re-indexed by the @c modify function instead.
+///
+/// @param storage Container holding the leases.
+/// @param lease_it Iterator pointing to the lease to be updated.
+/// @param lease New value of the lease.
+/// @param journal Lease journal or NULL if the leases are not persisted.
+///
+/// @throw DbOperationError if the new value of the lease conflicts with
+/// another lease. The lease held in the storage is left unchanged then.
+template<typename StorageType, typename LeaseType>
+void
+updateStoredLease(StorageType& storage, typename StorageType::iterator lease_it,
+                  const LeaseType& lease, LeaseJournal* journal) {
+    const LeaseType old_lease(**lease_it);
+    if (!storage.modify(lease_it, LeaseAssigner<LeaseType>(lease))) {
+        // The modify function removes the lease which can't be re-indexed.
+        storage.insert(boost::shared_ptr<LeaseType>(new LeaseType(old_lease)));
+        isc_throw(DbOperationError, "failed to update the lease with address "
+                  << lease.addr_ << " - the lease conflicts with another"
+                  " lease in the database");
+    }
+    if (journal) {
+        try {
+            journal->append(lease);
+        } catch (...) {
+            // Leave the in-memory database intact if the journal can't
+            // be written.
+            storage.modify(lease_it, LeaseAssigner<LeaseType>(old_lease));
+            throw;
+        }
+    }
+}
+
+} // end of anonymous namespace
 
 Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
-    : LeaseMgr(parameters) {
-    LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_WARNING);
+    : LeaseMgr(parameters), compact_threshold_(0), compact_retry_records_(0),
+      compacting_(false) {
+    std::string filename;
+    try {
+        filename = getParameter("name");
+    } catch (const isc::BadValue&) {
+        // The journal name is optional.
+    }
+
+    if (filename.empty()) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_WARNING);
+        return;
+    }
+
+    compact_threshold_ = getNumericParameter("compact-threshold",
+                                             DEFAULT_COMPACT_THRESHOLD);
+    journal_.reset(new LeaseJournal(filename,
+                                    getNumericParameter("sync-batch",
+                                                        DEFAULT_SYNC_BATCH)));
+    loadJournal();
+    journal_->open();
+    compactIfNeeded();
 }
 
 Memfile_LeaseMgr::~Memfile_LeaseMgr() {
+    waitForCompaction();
 }
 
 bool
@@ -33,11 +152,21 @@ Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR4).arg(lease->addr_.toText());
 
-    if (getLease4(lease->addr_)) {
+    Mutex::Locker locker(mutex_);
+
+    if (storage4_.find(lease->addr_) != storage4_.end()) {
         // there is a lease with specified address already
         return (false);
     }
-    storage4_.insert(lease);
+    // The journal is written first so as the in-memory database is left
+    // intact if the journal can't be written.
+    if (journal_) {
+        journal_->append(*lease);
+    }
+    // The copy is stored so as the lease held in the indexes can't be
+    // modified by the caller behind the lease manager's back.
+    storage4_.insert(Lease4Ptr(new Lease4(*lease)));
+    compactIfNeeded();
     return (true);
 }
 
@@ -46,11 +175,17 @@ Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR6).arg(lease->addr_.toText());
 
-    if (getLease6(lease->type_, lease->addr_)) {
+    Mutex::Locker locker(mutex_);
+
+    if (storage6_.find(lease->addr_) != storage6_.end()) {
         // there is a lease with specified address already
         return (false);
     }
-    storage6_.insert(lease);
+    if (journal_) {
+        journal_->append(*lease);
+    }
+    storage6_.insert(Lease6Ptr(new Lease6(*lease)));
+    compactIfNeeded();
     return (true);
 }
 
@@ -58,6 +193,7 @@ Lease4Ptr
 Memfile_LeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR4).arg(addr.toText());
+    Mutex::Locker locker(mutex_);
 
     typedef Lease4Storage::nth_index<0>::type SearchIndex;
     const SearchIndex& idx = storage4_.get<0>();
@@ -73,6 +209,8 @@ Lease4Collection
 Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_HWADDR).arg(hwaddr.toText());
+    Mutex::Locker locker(mutex_);
+
     typedef Lease4Storage::nth_index<0>::type SearchIndex;
     Lease4Collection collection;
     const SearchIndex& idx = storage4_.get<0>();
@@ -81,7 +219,7 @@ Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
         // Every Lease4 has a hardware address, so we can compare it
         if ((*lease)->hwaddr_ == hwaddr.hwaddr_) {
-            collection.push_back((*lease));
+            collection.push_back(Lease4Ptr(new Lease4(**lease)));
         }
     }
 
@@ -93,6 +231,7 @@ Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_SUBID_HWADDR).arg(subnet_id)
         .arg(hwaddr.toText());
+    Mutex::Locker locker(mutex_);
 
     // We are going to use index #1 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -116,6 +255,8 @@ Lease4Collection
 Memfile_LeaseMgr::getLease4(const ClientId& client_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_CLIENTID).arg(client_id.toText());
+    Mutex::Locker locker(mutex_);
+
     typedef Memfile_LeaseMgr::Lease4Storage::nth_index<0>::type SearchIndex;
     Lease4Collection collection;
     const SearchIndex& idx = storage4_.get<0>();
@@ -125,7 +266,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id) const {
         // client-id is not mandatory in DHCPv4. There can be a lease that does
         // not have a client-id. Dereferencing null pointer would be a bad thing
         if((*lease)->client_id_ && *(*lease)->client_id_ == client_id) {
-            collection.push_back((*lease));
+            collection.push_back(Lease4Ptr(new Lease4(**lease)));
         }
     }
 
@@ -140,6 +281,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
               DHCPSRV_MEMFILE_GET_CLIENTID_HWADDR_SUBID).arg(client_id.toText())
                                                         .arg(hwaddr.toText())
                                                         .arg(subnet_id);
+    Mutex::Locker locker(mutex_);
 
     // We are going to use index #3 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -158,7 +300,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     }
 
     // Lease was found. Return it to the caller.
-    return (*lease);
+    return (Lease4Ptr(new Lease4(**lease)));
 }
 
 Lease4Ptr
@@ -167,6 +309,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_SUBID_CLIENTID).arg(subnet_id)
               .arg(client_id.toText());
+    Mutex::Locker locker(mutex_);
 
     // We are going to use index #2 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -190,6 +333,7 @@ Memfile_LeaseMgr::getLease6(Lease::Type /* not used yet */,
                             const isc::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR6).arg(addr.toText());
+    Mutex::Locker locker(mutex_);
 
     Lease6Storage::iterator l = storage6_.find(addr);
     if (l == storage6_.end()) {
@@ -217,6 +361,7 @@ Memfile_LeaseMgr::getLeases6(Lease::Type /* not used yet */,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText());
+    Mutex::Locker locker(mutex_);
 
     // We are going to use index #1 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -239,36 +384,101 @@ Memfile_LeaseMgr::getLeases6(Lease::Type /* not used yet */,
     return (collection);
 }
 
+void
+Memfile_LeaseMgr::getExpiredLeases4(Lease4Collection& expired_leases,
+                                    const size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED4).arg(max_leases);
+    Mutex::Locker locker(mutex_);
+
+    getExpiredLeasesCommon(storage4_.get<4>(), expired_leases, max_leases);
+}
+
+void
+Memfile_LeaseMgr::getExpiredLeases6(Lease6Collection& expired_leases,
+                                    const size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED6).arg(max_leases);
+    Mutex::Locker locker(mutex_);
+
+    getExpiredLeasesCommon(storage6_.get<2>(), expired_leases, max_leases);
+}
+
+Lease4Collection
+Memfile_LeaseMgr::getLeases4(const isc::asiolink::IOAddress& lower,
+                             const isc::asiolink::IOAddress& upper) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_RANGE4).arg(lower.toText())
+        .arg(upper.toText());
+    Mutex::Locker locker(mutex_);
+
+    typedef Memfile_LeaseMgr::Lease4Storage::nth_index<0>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<0>();
+    Lease4Collection collection;
+    for (SearchIndex::const_iterator lease = idx.lower_bound(lower);
+         lease != idx.upper_bound(upper); ++lease) {
+        collection.push_back(Lease4Ptr(new Lease4(**lease)));
+    }
+    return (collection);
+}
+
+Lease6Collection
+Memfile_LeaseMgr::getLeases6(Lease::Type type,
+                             const isc::asiolink::IOAddress& lower,
+                             const isc::asiolink::IOAddress& upper) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_RANGE6).arg(lower.toText())
+        .arg(upper.toText()).arg(type);
+    Mutex::Locker locker(mutex_);
+
+    typedef Memfile_LeaseMgr::Lease6Storage::nth_index<0>::type SearchIndex;
+    const SearchIndex& idx = storage6_.get<0>();
+    Lease6Collection collection;
+    for (SearchIndex::const_iterator lease = idx.lower_bound(lower);
+         lease != idx.upper_bound(upper); ++lease) {
+        if ((*lease)->type_ == type) {
+            collection.push_back(Lease6Ptr(new Lease6(**lease)));
+        }
+    }
+    return (collection);
+}
+
 void
 Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR4).arg(lease->addr_.toText());
+    Mutex::Locker locker(mutex_);
 
     Lease4Storage::iterator lease_it = storage4_.find(lease->addr_);
     if (lease_it == storage4_.end()) {
         isc_throw(NoSuchLease, "failed to update the lease with address "
                   << lease->addr_ << " - no such lease");
     }
-    **lease_it = *lease;
+    updateStoredLease(storage4_, lease_it, *lease, journal_.get());
+    compactIfNeeded();
 }
 
 void
 Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR6).arg(lease->addr_.toText());
+    Mutex::Locker locker(mutex_);
 
     Lease6Storage::iterator lease_it = storage6_.find(lease->addr_);
     if (lease_it == storage6_.end()) {
         isc_throw(NoSuchLease, "failed to update the lease with address "
                   << lease->addr_ << " - no such lease");
     }
-    **lease_it = *lease;
+    updateStoredLease(storage6_, lease_it, *lease, journal_.get());
+    compactIfNeeded();
 }
 
 bool
 Memfile_LeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_DELETE_ADDR).arg(addr.toText());
+    Mutex::Locker locker(mutex_);
+
     if (addr.isV4()) {
         // v4 lease
         Lease4Storage::iterator l = storage4_.find(addr);
@@ -276,7 +486,11 @@ Memfile_LeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
             // No such lease
             return (false);
         } else {
+            if (journal_) {
+                journal_->appendDelete(addr);
+            }
             storage4_.erase(l);
+            compactIfNeeded();
             return (true);
         }
 
@@ -287,7 +501,11 @@ Memfile_LeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
             // No such lease
             return (false);
         } else {
+            if (journal_) {
+                journal_->appendDelete(addr);
+            }
             storage6_.erase(l);
+            compactIfNeeded();
             return (true);
         }
     }
@@ -295,14 +513,19 @@ Memfile_LeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
 
 std::string
 Memfile_LeaseMgr::getDescription() const {
-    return (std::string("This is a dummy memfile backend implementation.\n"
-                        "It does not offer any useful lease management and its only\n"
-                        "purpose is to test abstract lease manager API."));
+    return (std::string("This is a memfile backend implementation.\n"
+                        "It holds all leases in memory and optionally records\n"
+                        "the lease changes in an append-only journal file."));
 }
 
 void
 Memfile_LeaseMgr::commit() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MEMFILE_COMMIT);
+    Mutex::Locker locker(mutex_);
+
+    if (journal_) {
+        journal_->sync();
+    }
 }
 
 void
@@ -310,3 +533,201 @@ Memfile_LeaseMgr::rollback() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ROLLBACK);
 }
+
+void
+Memfile_LeaseMgr::compact() {
+    Mutex::Locker compact_locker(compact_mutex_);
+
+    // Copy the leases, so as the compacted journal can be written without
+    // blocking the lease changes. The records appended to the journal
+    // after this point are copied from the offset of its current end.
+    Lease4Collection leases4;
+    Lease6Collection leases6;
+    std::string filename;
+    uint64_t tail_offset = 0;
+    {
+        Mutex::Locker locker(mutex_);
+        if (!journal_) {
+            return;
+        }
+
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_MEMFILE_COMPACT)
+            .arg(journal_->getFilename()).arg(journal_->getRecordCount())
+            .arg(storage4_.size() + storage6_.size());
+
+        leases4.reserve(storage4_.size());
+        for (Lease4Storage::const_iterator lease = storage4_.begin();
+             lease != storage4_.end(); ++lease) {
+            leases4.push_back(Lease4Ptr(new Lease4(**lease)));
+        }
+        leases6.reserve(storage6_.size());
+        for (Lease6Storage::const_iterator lease = storage6_.begin();
+             lease != storage6_.end(); ++lease) {
+            leases6.push_back(Lease6Ptr(new Lease6(**lease)));
+        }
+        filename = journal_->getFilename();
+        tail_offset = journal_->getSize();
+    }
+
+    // Write the snapshot of the database into the temporary file. Should
+    // anything fail here, the original journal remains untouched and the
+    // temporary file is removed.
+    const std::string tmp_filename = filename + ".compact";
+    try {
+        LeaseJournal snapshot(tmp_filename, leases4.size() + leases6.size() + 1);
+        snapshot.open(true);
+        for (Lease4Collection::const_iterator lease = leases4.begin();
+             lease != leases4.end(); ++lease) {
+            snapshot.append(**lease);
+        }
+        for (Lease6Collection::const_iterator lease = leases6.begin();
+             lease != leases6.end(); ++lease) {
+            snapshot.append(**lease);
+        }
+
+        Mutex::Locker locker(mutex_);
+        snapshot.appendTail(filename, tail_offset);
+
+        // The rename is atomic, so the journal file either holds the old
+        // records or the snapshot - never a mix of them.
+        journal_->replace(snapshot);
+
+    } catch (...) {
+        static_cast<void>(unlink(tmp_filename.c_str()));
+        throw;
+    }
+}
+
+void
+Memfile_LeaseMgr::waitForCompaction() {
+    // The thread is waited for without holding the mutex, as the compaction
+    // needs it to complete.
+    boost::scoped_ptr<Thread> compactor;
+    {
+        Mutex::Locker locker(mutex_);
+        compactor.swap(compactor_);
+    }
+    if (compactor) {
+        compactor->wait();
+    }
+}
+
+void
+Memfile_LeaseMgr::compactInBackground() {
+    // The lease change which triggered the compaction has already been
+    // applied and recorded in the journal, so a failure here must not
+    // be reported as a failure of that change.  The journal keeps growing
+    // until the next attempt, which is deferred until another
+    // compact-threshold records were appended.
+    bool failed = false;
+    try {
+        compact();
+    } catch (const std::exception& ex) {
+        failed = true;
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_COMPACT_FAIL)
+            .arg(getName()).arg(ex.what());
+    }
+
+    Mutex::Locker locker(mutex_);
+    compact_retry_records_ = failed ?
+        journal_->getRecordCount() + compact_threshold_ : 0;
+    // Nothing may lock the mutex after this point: the thread is waited
+    // for by the next compactIfNeeded while holding it.
+    compacting_ = false;
+}
+
+void
+Memfile_LeaseMgr::loadJournal() {
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_JOURNAL_LOAD)
+        .arg(journal_->getFilename());
+
+    journal_->startReplay();
+    LeaseJournal::Record record;
+    while (journal_->readRecord(record)) {
+        switch (record.type_) {
+        case LeaseJournal::RECORD_LEASE4: {
+            Lease4Storage::iterator l = storage4_.find(record.addr_);
+            if ((l != storage4_.end()) && !storage4_.replace(l, record.lease4_)) {
+                storage4_.erase(l);
+                l = storage4_.end();
+            }
+            if (l == storage4_.end()) {
+                storage4_.insert(record.lease4_);
+            }
+            break;
+        }
+        case LeaseJournal::RECORD_LEASE6: {
+            Lease6Storage::iterator l = storage6_.find(record.addr_);
+            if ((l != storage6_.end()) && !storage6_.replace(l, record.lease6_)) {
+                storage6_.erase(l);
+                l = storage6_.end();
+            }
+            if (l == storage6_.end()) {
+                storage6_.insert(record.lease6_);
+            }
+            break;
+        }
+        case LeaseJournal::RECORD_DELETE4:
+            storage4_.erase(record.addr_);
+            break;
+
+        case LeaseJournal::RECORD_DELETE6:
+            storage6_.erase(record.addr_);
+            break;
+        }
+    }
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_JOURNAL_LOADED)
+        .arg(storage4_.size()).arg(storage6_.size())
+        .arg(journal_->getRecordCount()).arg(journal_->getInvalidCount());
+}
+
+void
+Memfile_LeaseMgr::compactIfNeeded() {
+    if (!journal_ || (compact_threshold_ == 0) || compacting_) {
+        return;
+    }
+    const size_t leases = storage4_.size() + storage6_.size();
+    const size_t records = journal_->getRecordCount();
+    if (records <= leases) {
+        return;
+    }
+    const size_t superseded = records - leases;
+    if ((superseded >= compact_threshold_) && (superseded >= leases) &&
+        (records >= compact_retry_records_)) {
+        // The previous compaction has completed, so its thread only
+        // needs to be reaped.
+        if (compactor_) {
+            compactor_->wait();
+        }
+        compacting_ = true;
+        try {
+            compactor_.reset(new Thread(boost::bind(&Memfile_LeaseMgr::
+                                                    compactInBackground,
+                                                    this)));
+        } catch (const std::exception& ex) {
+            compactor_.reset();
+            compacting_ = false;
+            compact_retry_records_ = records + compact_threshold_;
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_COMPACT_FAIL)
+                .arg(journal_->getFilename()).arg(ex.what());
+        }
+    }
+}
+
+uint32_t
+Memfile_LeaseMgr::getNumericParameter(const std::string& name,
+                                      const uint32_t default_value) const {
+    std::string value;
+    try {
+        value = getParameter(name);
+    } catch (const isc::BadValue&) {
+        return (default_value);
+    }
+    try {
+        return (boost::lexical_cast<uint32_t>(value));
+    } catch (const boost::bad_lexical_cast&) {
+        isc_throw(isc::BadValue, "invalid value '" << value << "' of the '"
+                  << name << "' memfile parameter");
+    }
+}
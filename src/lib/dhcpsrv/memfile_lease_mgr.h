@@ -16,25 +16,53 @@
 #define MEMFILE_LEASE_MGR_H
 
 #include <dhcp/hwaddr.h>
+#include <dhcpsrv/lease_journal.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/indexed_by.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace isc {
 namespace dhcp {
 
-// This is a concrete implementation of a Lease database.
-//
-// It is for testing purposes only. It is NOT a production code.
-//
-// It does not do anything useful now, and is used for abstract LeaseMgr
-// class testing. It may later evolve into more useful backend if the
-// need arises. We can reuse code from memfile benchmark. See code in
-// tests/tools/dhcp-ubench/memfile_bench.{cc|h}
+/// @brief Concrete implementation of a lease database backend using
+/// in-memory storage with an optional on-disk journal.
+///
+/// All leases are held in the multi-index containers, so the lookups are
+/// served at memory speed. If the "name" parameter is specified, every
+/// change to the lease database is also appended to the lease journal
+/// file (see @c LeaseJournal). The journal is replayed when the lease
+/// manager is created, so the leases survive the restart of the server.
+///
+/// The following parameters control the journal:
+/// - name - name of the journal file. If not specified, the leases are
+///   only held in memory and are lost when the server is restarted.
+/// - sync-batch - number of lease changes after which the journal is
+///   forced onto the disk (in addition to each call to @c commit).
+/// - compact-threshold - minimal number of superseded records in the
+///   journal which triggers the compaction of the journal. The value of 0
+///   disables the automatic compaction.
+///
+/// The journal is compacted when it holds at least "compact-threshold"
+/// superseded records and at least as many superseded records as there
+/// are leases in the database. The compaction is thus amortized to a
+/// constant cost per lease change. It runs in a background thread: the
+/// leases are copied while holding the lease manager's mutex, but the
+/// compacted journal is written without holding it. The records appended
+/// in the meantime are then copied to the compacted journal, which replaces
+/// the original one.
+///
+/// The lease manager may be used by several threads at the same time: each
+/// public method holds the lease manager's mutex for its duration. The
+/// leases are always returned as copies, so the caller may use them while
+/// other threads modify the database.
 class Memfile_LeaseMgr : public LeaseMgr {
 public:
 
@@ -46,8 +74,19 @@ public:
     ///
     /// @param parameters A data structure relating keywords and values
     ///        concerned with the database.
+    ///
+    /// @throw DbOpenError if the lease journal can't be opened.
+    /// @throw BadValue if the journal parameters are invalid.
     Memfile_LeaseMgr(const ParameterMap& parameters);
 
+    /// @brief Default number of lease changes between disk synchronizations
+    /// of the lease journal.
+    static const uint32_t DEFAULT_SYNC_BATCH = 64;
+
+    /// @brief Default minimal number of superseded journal records which
+    /// triggers the compaction.
+    static const uint32_t DEFAULT_COMPACT_THRESHOLD = 10000;
+
     /// @brief Destructor (closes file)
     virtual ~Memfile_LeaseMgr();
 
@@ -172,6 +211,53 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// The leases are found with the expiration time index.
+    ///
+    /// @param [out] expired_leases The expired leases are appended to this
+    ///        collection.
+    /// @param max_leases Maximum number of leases returned; 0 means no
+    ///        limit.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// The leases are found with the expiration time index.
+    ///
+    /// @param [out] expired_leases The expired leases are appended to this
+    ///        collection.
+    /// @param max_leases Maximum number of leases returned; 0 means no
+    ///        limit.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns the IPv4 leases for the addresses in the range.
+    ///
+    /// The leases are found with the address index.
+    ///
+    /// @param lower first address of the range
+    /// @param upper last address of the range
+    ///
+    /// @return collection of the leases (may be empty if no lease is found)
+    virtual Lease4Collection
+    getLeases4(const isc::asiolink::IOAddress& lower,
+               const isc::asiolink::IOAddress& upper) const;
+
+    /// @brief Returns the IPv6 leases for the addresses in the range.
+    ///
+    /// The leases are found with the address index.
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param lower first address (or prefix) of the range
+    /// @param upper last address (or prefix) of the range
+    ///
+    /// @return collection of the leases (may be empty if no lease is found)
+    virtual Lease6Collection
+    getLeases6(Lease::Type type, const isc::asiolink::IOAddress& lower,
+               const isc::asiolink::IOAddress& upper) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @warning This function does not validate the pointer to the lease.
@@ -211,11 +297,10 @@ public:
 
     /// @brief Returns backend name.
     ///
-    /// For now, memfile can only store data in memory.
-    ///
-    /// @return Name of the backend.
+    /// @return Name of the lease journal file or "memory" if the leases
+    /// are not persisted.
     virtual std::string getName() const {
-        return ("memory");
+        return (journal_ ? journal_->getFilename() : std::string("memory"));
     }
 
     /// @brief Returns description of the backend.
@@ -235,8 +320,11 @@ public:
 
     /// @brief Commit Transactions
     ///
-    /// Commits all pending database operations.  On databases that don't
-    /// support transactions, this is a no-op.
+    /// Memfile doesn't support transactions, as each change is applied
+    /// immediately. The commit forces the pending records of the lease
+    /// journal onto the disk.
+    ///
+    /// @throw DbOperationError if the journal could not be synchronized.
     virtual void commit();
 
     /// @brief Rollback Transactions
@@ -245,8 +333,59 @@ public:
     /// support transactions, this is a no-op.
     virtual void rollback();
 
+    /// @brief Rewrites the lease journal to hold one record per lease.
+    ///
+    /// The current contents of the lease database are written into
+    /// a temporary file, which then atomically replaces the journal. The
+    /// lease changes are only blocked while the leases are copied and while
+    /// the journal is replaced. This is a no-op if the leases are not
+    /// persisted.
+    ///
+    /// @throw DbOperationError if the journal could not be rewritten.
+    void compact();
+
+    /// @brief Waits for the background compaction to complete.
+    ///
+    /// This returns immediately if no compaction is in progress.
+    void waitForCompaction();
+
+    /// @brief Returns the number of records held in the lease journal.
+    ///
+    /// @return Number of records or 0 if the leases are not persisted.
+    size_t getJournalRecordCount() const {
+        isc::util::thread::Mutex::Locker locker(mutex_);
+        return (journal_ ? journal_->getRecordCount() : 0);
+    }
+
 protected:
 
+    /// @brief Loads the leases from the lease journal.
+    ///
+    /// The records are applied in order, so each lease ends up in the state
+    /// recorded by its last record.
+    void loadJournal();
+
+    /// @brief Runs the compaction in the background thread.
+    ///
+    /// The lease change which triggered the compaction has already been
+    /// applied, so a failure of the compaction is logged rather than thrown.
+    void compactInBackground();
+
+    /// @brief Starts the background compaction of the lease journal if it
+    /// holds enough superseded records.
+    ///
+    /// The caller must hold the mutex.
+    void compactIfNeeded();
+
+    /// @brief Returns the numeric value of the optional parameter.
+    ///
+    /// @param name Name of the parameter.
+    /// @param default_value Value returned if the parameter is not given.
+    ///
+    /// @throw BadValue if the parameter is not a number.
+    uint32_t getNumericParameter(const std::string& name,
+                                 const uint32_t default_value) const;
+
     // This is a multi-index container, which holds elements that can
     // be accessed using different search indexes.
     typedef boost::multi_index_container<
@@ -261,7 +400,10 @@ protected:
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
+            // The lookups by client identity are exact matches, so the hashed
+            // index is used. It doesn't have to compare the DUID vectors
+            // O(log n) times on each lookup like the ordered index does.
+            boost::multi_index::hashed_unique<
                 // This is a composite index that will be used to search for
                 // the lease using three attributes: DUID, IAID, Subnet Id.
                 boost::multi_index::composite_key<
@@ -275,6 +417,14 @@ protected:
                     boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>,
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the third index starts here.
+            // It sorts the leases by the expiration time, so as the expired
+            // leases are found without walking all leases.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
      > Lease6Storage; // Specify the type name of this container.
@@ -288,7 +438,8 @@ protected:
         boost::multi_index::indexed_by<
             // Specification of the first index starts here.
             // This index sorts leases by IPv4 addresses represented as
-            // IOAddress objects.
+            // IOAddress objects. It remains ordered so as the leases can
+            // be walked in the order of addresses.
             boost::multi_index::ordered_unique<
                 // The IPv4 address are held in addr_ members that belong to
                 // Lease class.
@@ -296,7 +447,9 @@ protected:
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
+            // This and the following indexes are only used for exact matches
+            // so they are hashed rather than ordered.
+            boost::multi_index::hashed_unique<
                 // This is a composite index that combines two attributes of the
                 // Lease4 object: hardware address and subnet id.
                 boost::multi_index::composite_key<
@@ -314,7 +467,7 @@ protected:
             >,
 
             // Specification of the third index starts here.
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 // This is a composite index that uses two values to search for a
                 // lease: client id and subnet id.
                 boost::multi_index::composite_key<
@@ -329,7 +482,7 @@ protected:
             >,
 
             // Specification of the fourth index starts here.
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 // This is a composite index that uses two values to search for a
                 // lease: client id and subnet id.
                 boost::multi_index::composite_key<
@@ -345,6 +498,14 @@ protected:
                     // The subnet id is accessed through the subnet_id_ member.
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the fifth index starts here.
+            // It sorts the leases by the expiration time, so as the expired
+            // leases are found without walking all leases.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
     > Lease4Storage; // Specify the type name for this container.
@@ -354,6 +515,30 @@ protected:
 
     /// @brief stores IPv6 leases
     Lease6Storage storage6_;
+
+    /// @brief Lease journal (NULL if the leases are not persisted)
+    boost::scoped_ptr<LeaseJournal> journal_;
+
+    /// @brief Number of superseded records which triggers compaction.
+    uint32_t compact_threshold_;
+
+    /// @brief Number of journal records below which the compaction isn't
+    /// retried after a failure.
+    size_t compact_retry_records_;
+
+    /// @brief Indicates that the background compaction is in progress.
+    bool compacting_;
+
+    /// @brief Thread running the background compaction.
+    boost::scoped_ptr<isc::util::thread::Thread> compactor_;
+
+    /// @brief Serializes the access to the leases and the journal.
+    mutable isc::util::thread::Mutex mutex_;
+
+    /// @brief Serializes the compactions.
+    ///
+    /// It is held for the whole compaction and acquired before @c mutex_.
+    isc::util::thread::Mutex compact_mutex_;
 };
 
 }; // end of isc::dhcp namespace
@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <time.h>
@@ -32,6 +33,7 @@
 using namespace isc;
 using namespace isc::dhcp;
 using namespace std;
+using isc::util::thread::Mutex;
 
 /// @file
 ///
@@ -145,6 +147,14 @@ TaggedStatement tagged_statements[] = {
                         "fqdn_fwd, fqdn_rev, hostname "
                             "FROM lease4 "
                             "WHERE client_id = ? AND subnet_id = ?"},
+    {MySqlLeaseMgr::GET_LEASE4_EXPIRE,
+                    "SELECT address, hwaddr, client_id, "
+                        "valid_lifetime, expire, subnet_id, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease4 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire "
+                            "LIMIT ?"},
     {MySqlLeaseMgr::GET_LEASE4_HWADDR,
                     "SELECT address, hwaddr, client_id, "
                         "valid_lifetime, expire, subnet_id, "
@@ -157,6 +167,12 @@ TaggedStatement tagged_statements[] = {
                         "fqdn_fwd, fqdn_rev, hostname "
                             "FROM lease4 "
                             "WHERE hwaddr = ? AND subnet_id = ?"},
+    {MySqlLeaseMgr::GET_LEASE4_RANGE,
+                    "SELECT address, hwaddr, client_id, "
+                        "valid_lifetime, expire, subnet_id, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease4 "
+                            "WHERE address >= ? AND address <= ?"},
     {MySqlLeaseMgr::GET_LEASE6_ADDR,
                     "SELECT address, duid, valid_lifetime, "
                         "expire, subnet_id, pref_lifetime, "
@@ -179,6 +195,22 @@ TaggedStatement tagged_statements[] = {
                             "FROM lease6 "
                             "WHERE duid = ? AND iaid = ? AND subnet_id = ? "
                             "AND lease_type = ?"},
+    {MySqlLeaseMgr::GET_LEASE6_EXPIRE,
+                    "SELECT address, duid, valid_lifetime, "
+                        "expire, subnet_id, pref_lifetime, "
+                        "lease_type, iaid, prefix_len, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease6 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire "
+                            "LIMIT ?"},
+    {MySqlLeaseMgr::GET_LEASE6_TYPE,
+                    "SELECT address, duid, valid_lifetime, "
+                        "expire, subnet_id, pref_lifetime, "
+                        "lease_type, iaid, prefix_len, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease6 "
+                            "WHERE lease_type = ?"},
     {MySqlLeaseMgr::GET_VERSION,
                     "SELECT version, minor FROM schema_version"},
     {MySqlLeaseMgr::INSERT_LEASE4,
@@ -1120,6 +1152,18 @@ MySqlLeaseMgr::MySqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
     // Prepare all statements likely to be used.
     prepareStatements();
 
+    // The newer minor versions only add to the schema (e.g. indexes), so
+    // they are accepted. The older ones lack what this code relies on.
+    const std::pair<uint32_t, uint32_t> version = getVersion();
+    if ((version.first != CURRENT_VERSION_VERSION) ||
+        (version.second < CURRENT_VERSION_MINOR)) {
+        isc_throw(DbOpenError, "MySQL lease database schema version "
+                  << version.first << "." << version.second
+                  << " found, " << CURRENT_VERSION_VERSION << "."
+                  << CURRENT_VERSION_MINOR << " expected: upgrade the"
+                  " database with the dhcpdb_upgrade_*.mysql scripts");
+    }
+
     // Create the exchange objects for use in exchanging data between the
     // program and the database.
     exchange4_.reset(new MySqlLease4Exchange());
@@ -1362,6 +1406,18 @@ MySqlLeaseMgr::addLeaseCommon(StatementIndex stindex,
 
 bool
 MySqlLeaseMgr::addLease(const Lease4Ptr& lease) {
+    Mutex::Locker locker(mutex_);
+    return (addLeaseInternal(lease));
+}
+
+bool
+MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
+    Mutex::Locker locker(mutex_);
+    return (addLeaseInternal(lease));
+}
+
+bool
+MySqlLeaseMgr::addLeaseInternal(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_ADD_ADDR4).arg(lease->addr_.toText());
 
@@ -1373,7 +1429,7 @@ MySqlLeaseMgr::addLease(const Lease4Ptr& lease) {
 }
 
 bool
-MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
+MySqlLeaseMgr::addLeaseInternal(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_ADD_ADDR6).arg(lease->addr_.toText())
               .arg(lease->type_);
@@ -1516,6 +1572,7 @@ Lease4Ptr
 MySqlLeaseMgr::getLease4(const isc::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_ADDR4).arg(addr.toText());
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[1];
@@ -1538,6 +1595,7 @@ Lease4Collection
 MySqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_HWADDR).arg(hwaddr.toText());
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[1];
@@ -1569,6 +1627,7 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_SUBID_HWADDR)
         .arg(subnet_id).arg(hwaddr.toText());
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[2];
@@ -1603,6 +1662,7 @@ Lease4Collection
 MySqlLeaseMgr::getLease4(const ClientId& clientid) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_CLIENTID).arg(clientid.toText());
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[1];
@@ -1637,6 +1697,7 @@ MySqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_SUBID_CLIENTID)
               .arg(subnet_id).arg(clientid.toText());
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[2];
@@ -1667,6 +1728,7 @@ MySqlLeaseMgr::getLease6(Lease::Type lease_type,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_ADDR6).arg(addr.toText())
               .arg(lease_type);
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[2];
@@ -1700,6 +1762,7 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_IAID_DUID).arg(iaid).arg(duid.toText())
               .arg(lease_type);
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[3];
@@ -1750,6 +1813,7 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
               DHCPSRV_MYSQL_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText())
               .arg(lease_type);
+    Mutex::Locker locker(mutex_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[4];
@@ -1787,6 +1851,119 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
     return (result);
 }
 
+// Expired leases.  The leases are selected by the "expire" column, which is
+// indexed, so the database doesn't have to scan the whole table.
+
+template<typename LeaseCollection>
+void
+MySqlLeaseMgr::getExpiredLeasesCommon(LeaseCollection& expired_leases,
+                                      const size_t max_leases,
+                                      StatementIndex stindex) const {
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+
+    // The leases which expired before now.
+    MYSQL_TIME expire_time;
+    convertToDatabaseTime(time(NULL), 0, expire_time);
+    inbind[0].buffer_type = MYSQL_TYPE_TIMESTAMP;
+    inbind[0].buffer = reinterpret_cast<char*>(&expire_time);
+    inbind[0].buffer_length = sizeof(expire_time);
+
+    // The limit of 0 means that all expired leases are returned.
+    uint32_t limit = std::numeric_limits<uint32_t>::max();
+    if ((max_leases > 0) && (max_leases < limit)) {
+        limit = static_cast<uint32_t>(max_leases);
+    }
+    inbind[1].buffer_type = MYSQL_TYPE_LONG;
+    inbind[1].buffer = reinterpret_cast<char*>(&limit);
+    inbind[1].is_unsigned = MLM_TRUE;
+
+    getLeaseCollection(stindex, inbind, expired_leases);
+}
+
+void
+MySqlLeaseMgr::getExpiredLeases4(Lease4Collection& expired_leases,
+                                 const size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED4).arg(max_leases);
+    Mutex::Locker locker(mutex_);
+
+    getExpiredLeasesCommon(expired_leases, max_leases, GET_LEASE4_EXPIRE);
+}
+
+void
+MySqlLeaseMgr::getExpiredLeases6(Lease6Collection& expired_leases,
+                                 const size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED6).arg(max_leases);
+    Mutex::Locker locker(mutex_);
+
+    getExpiredLeasesCommon(expired_leases, max_leases, GET_LEASE6_EXPIRE);
+}
+
+Lease4Collection
+MySqlLeaseMgr::getLeases4(const isc::asiolink::IOAddress& lower,
+                          const isc::asiolink::IOAddress& upper) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_RANGE4).arg(lower.toText())
+              .arg(upper.toText());
+    Mutex::Locker locker(mutex_);
+
+    // Set up the WHERE clause values
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+
+    uint32_t lower4 = static_cast<uint32_t>(lower);
+    inbind[0].buffer_type = MYSQL_TYPE_LONG;
+    inbind[0].buffer = reinterpret_cast<char*>(&lower4);
+    inbind[0].is_unsigned = MLM_TRUE;
+
+    uint32_t upper4 = static_cast<uint32_t>(upper);
+    inbind[1].buffer_type = MYSQL_TYPE_LONG;
+    inbind[1].buffer = reinterpret_cast<char*>(&upper4);
+    inbind[1].is_unsigned = MLM_TRUE;
+
+    // ... and get the data
+    Lease4Collection result;
+    getLeaseCollection(GET_LEASE4_RANGE, inbind, result);
+
+    return (result);
+}
+
+Lease6Collection
+MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
+                          const isc::asiolink::IOAddress& lower,
+                          const isc::asiolink::IOAddress& upper) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_RANGE6).arg(lower.toText())
+              .arg(upper.toText()).arg(lease_type);
+    Mutex::Locker locker(mutex_);
+
+    // Set up the WHERE clause value
+    MYSQL_BIND inbind[1];
+    memset(inbind, 0, sizeof(inbind));
+
+    // LEASE_TYPE
+    inbind[0].buffer_type = MYSQL_TYPE_TINY;
+    inbind[0].buffer = reinterpret_cast<char*>(&lease_type);
+    inbind[0].is_unsigned = MLM_TRUE;
+
+    Lease6Collection leases;
+    getLeaseCollection(GET_LEASE6_TYPE, inbind, leases);
+
+    // The addresses are stored as text, so the range is applied here.
+    Lease6Collection result;
+    for (Lease6Collection::const_iterator lease = leases.begin();
+         lease != leases.end(); ++lease) {
+        if (lower.smallerEqual((*lease)->addr_) &&
+            (*lease)->addr_.smallerEqual(upper)) {
+            result.push_back(*lease);
+        }
+    }
+
+    return (result);
+}
+
 // Update lease methods.  These comprise common code that handles the actual
 // update, and type-specific methods that set up the parameters for the prepared
 // statement depending on the type of lease.
@@ -1821,6 +1998,13 @@ MySqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind,
 
 void
 MySqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
+    Mutex::Locker locker(mutex_);
+    updateLease4Internal(lease);
+}
+
+
+void
+MySqlLeaseMgr::updateLease4Internal(const Lease4Ptr& lease) {
     const StatementIndex stindex = UPDATE_LEASE4;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1846,6 +2030,13 @@ MySqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
 
 void
 MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
+    Mutex::Locker locker(mutex_);
+    updateLease6Internal(lease);
+}
+
+
+void
+MySqlLeaseMgr::updateLease6Internal(const Lease6Ptr& lease) {
     const StatementIndex stindex = UPDATE_LEASE6;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1898,6 +2089,13 @@ MySqlLeaseMgr::deleteLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind) {
 
 bool
 MySqlLeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
+    Mutex::Locker locker(mutex_);
+    return (deleteLeaseInternal(addr));
+}
+
+
+bool
+MySqlLeaseMgr::deleteLeaseInternal(const isc::asiolink::IOAddress& addr) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_DELETE_ADDR).arg(addr.toText());
 
@@ -1929,6 +2127,74 @@ MySqlLeaseMgr::deleteLease(const isc::asiolink::IOAddress& addr) {
     }
 }
 
+// Batched writes.  The writes are executed with the single lease methods,
+// but within one transaction, so as the database commits them at once.  The
+// mutex is held for the whole transaction, so as no statement issued by
+// another thread becomes part of it.
+
+void
+MySqlLeaseMgr::writeLeaseInternal(LeaseWrite& write) {
+    try {
+        switch (write.type_) {
+        case LeaseWrite::ADD:
+            write.result_ = (write.lease4_ ? addLeaseInternal(write.lease4_) :
+                             addLeaseInternal(write.lease6_));
+            break;
+
+        case LeaseWrite::UPDATE:
+            if (write.lease4_) {
+                updateLease4Internal(write.lease4_);
+            } else {
+                updateLease6Internal(write.lease6_);
+            }
+            write.result_ = true;
+            break;
+
+        case LeaseWrite::DELETE:
+            write.result_ = deleteLeaseInternal(write.addr_);
+            break;
+        }
+    } catch (const std::exception& ex) {
+        write.result_ = false;
+        write.error_ = ex.what();
+    }
+}
+
+void
+MySqlLeaseMgr::writeLeases(LeaseWriteCollection& writes) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_WRITE_LEASES).arg(writes.size());
+    Mutex::Locker locker(mutex_);
+
+    // Disabling autocommit starts the transaction.
+    if (mysql_autocommit(mysql_, 0) != 0) {
+        isc_throw(DbOperationError, "unable to start transaction: "
+                  << mysql_error(mysql_));
+    }
+
+    for (LeaseWriteCollection::iterator write = writes.begin();
+         write != writes.end(); ++write) {
+        writeLeaseInternal(*write);
+    }
+
+    try {
+        commitInternal();
+    } catch (const DbOperationError& ex) {
+        // None of the writes has been stored.
+        (void)mysql_rollback(mysql_);
+        for (LeaseWriteCollection::iterator write = writes.begin();
+             write != writes.end(); ++write) {
+            write->result_ = false;
+            write->error_ = ex.what();
+        }
+    }
+
+    // Return to the autocommit mode used by the single lease methods.
+    if (mysql_autocommit(mysql_, 1) != 0) {
+        isc_throw(DbOperationError, mysql_error(mysql_));
+    }
+}
+
 // Miscellaneous database methods.
 
 std::string
@@ -1955,6 +2221,7 @@ MySqlLeaseMgr::getVersion() const {
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_VERSION);
+    Mutex::Locker locker(mutex_);
 
     uint32_t    major;      // Major version number
     uint32_t    minor;      // Minor version number
@@ -2002,6 +2269,13 @@ MySqlLeaseMgr::getVersion() const {
 
 void
 MySqlLeaseMgr::commit() {
+    Mutex::Locker locker(mutex_);
+    commitInternal();
+}
+
+
+void
+MySqlLeaseMgr::commitInternal() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MYSQL_COMMIT);
     if (mysql_commit(mysql_) != 0) {
         isc_throw(DbOperationError, "commit failed: " << mysql_error(mysql_));
@@ -2012,6 +2286,7 @@ MySqlLeaseMgr::commit() {
 void
 MySqlLeaseMgr::rollback() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MYSQL_ROLLBACK);
+    Mutex::Locker locker(mutex_);
     if (mysql_rollback(mysql_) != 0) {
         isc_throw(DbOperationError, "rollback failed: " << mysql_error(mysql_));
     }
@@ -17,6 +17,7 @@
 
 #include <dhcp/hwaddr.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <util/threads/sync.h>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/utility.hpp>
@@ -78,7 +79,7 @@ private:
 // Define the current database schema values
 
 const uint32_t CURRENT_VERSION_VERSION = 1;
-const uint32_t CURRENT_VERSION_MINOR = 0;
+const uint32_t CURRENT_VERSION_MINOR = 1;
 
 
 // Forward declaration of the Lease exchange objects.  These classes are defined
@@ -92,6 +93,10 @@ class MySqlLease6Exchange;
 /// This class provides the \ref isc::dhcp::LeaseMgr interface to the MySQL
 /// database.  Use of this backend presupposes that a MySQL database is
 /// available and that the Kea schema has been created within it.
+///
+/// The lease manager may be used by several threads at the same time. The
+/// connection, the prepared statements and the exchange objects are shared,
+/// so each public method holds the lease manager's mutex for its duration.
 
 class MySqlLeaseMgr : public LeaseMgr {
 public:
@@ -106,7 +111,9 @@ public:
     ///
     /// If the database is successfully opened, the version number in the
     /// schema_version table will be checked against hard-coded value in
-    /// the implementation file.
+    /// the implementation file. The database with a different major
+    /// version or an older minor version is rejected: it must be upgraded
+    /// with the dhcpdb_upgrade_*.mysql scripts first.
     ///
     /// Finally, all the SQL commands are pre-compiled.
     ///
@@ -114,7 +121,8 @@ public:
     ///        concerned with the database.
     ///
     /// @throw isc::dhcp::NoDatabaseName Mandatory database name not given
-    /// @throw isc::dhcp::DbOpenError Error opening the database
+    /// @throw isc::dhcp::DbOpenError Error opening the database or the
+    ///        schema version doesn't match the one expected.
     /// @throw isc::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     MySqlLeaseMgr(const ParameterMap& parameters);
@@ -314,6 +322,67 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// The leases are found with the index of the "expire" column.
+    ///
+    /// @param [out] expired_leases The expired leases are appended to this
+    ///        collection.
+    /// @param max_leases Maximum number of leases returned; 0 means no
+    ///        limit.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases4(Lease4Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// The leases are found with the index of the "expire" column.
+    ///
+    /// @param [out] expired_leases The expired leases are appended to this
+    ///        collection.
+    /// @param max_leases Maximum number of leases returned; 0 means no
+    ///        limit.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases6(Lease6Collection& expired_leases,
+                                   const size_t max_leases) const;
+
+    /// @brief Returns the IPv4 leases for the addresses in the range.
+    ///
+    /// The leases are found with the primary key of the "address" column.
+    ///
+    /// @param lower first address of the range
+    /// @param upper last address of the range
+    ///
+    /// @return collection of the leases (may be empty if no lease is found)
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease4Collection
+    getLeases4(const isc::asiolink::IOAddress& lower,
+               const isc::asiolink::IOAddress& upper) const;
+
+    /// @brief Returns the IPv6 leases for the addresses in the range.
+    ///
+    /// The IPv6 addresses are stored as text, which doesn't sort in the
+    /// order of the addresses. The leases of the type are therefore
+    /// scanned in a single query and filtered by the range.
+    ///
+    /// @param type specifies lease type: (NA, TA or PD)
+    /// @param lower first address (or prefix) of the range
+    /// @param upper last address (or prefix) of the range
+    ///
+    /// @return collection of the leases (may be empty if no lease is found)
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease6Collection
+    getLeases6(Lease::Type type, const isc::asiolink::IOAddress& lower,
+               const isc::asiolink::IOAddress& upper) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// Updates the record of the lease in the database (as identified by the
@@ -351,6 +420,24 @@ public:
     ///        failed.
     virtual bool deleteLease(const isc::asiolink::IOAddress& addr);
 
+    /// @brief Executes a batch of lease writes.
+    ///
+    /// Autocommit is suspended for the duration of the batch, so as all
+    /// writes are executed in one transaction and the database flushes
+    /// them to disk once. The writes reuse the prepared statements, one
+    /// per lease: multi-row statements would make the whole batch fail on
+    /// a single duplicate entry, while each @c addLease must report it
+    /// individually.
+    ///
+    /// If the transaction can't be committed, it is rolled back and all
+    /// writes of the batch are marked as failed.
+    ///
+    /// @param writes Writes to be executed.
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void writeLeases(LeaseWriteCollection& writes);
+
     /// @brief Return backend type
     ///
     /// Returns the type of the backend (e.g. "mysql", "memfile" etc.)
@@ -458,11 +545,15 @@ public:
         GET_LEASE4_ADDR,            // Get lease4 by address
         GET_LEASE4_CLIENTID,        // Get lease4 by client ID
         GET_LEASE4_CLIENTID_SUBID,  // Get lease4 by client ID & subnet ID
+        GET_LEASE4_EXPIRE,          // Get expired lease4
         GET_LEASE4_HWADDR,          // Get lease4 by HW address
         GET_LEASE4_HWADDR_SUBID,    // Get lease4 by HW address & subnet ID
+        GET_LEASE4_RANGE,           // Get lease4 by address range
         GET_LEASE6_ADDR,            // Get lease6 by address
         GET_LEASE6_DUID_IAID,       // Get lease6 by DUID and IAID
         GET_LEASE6_DUID_IAID_SUBID, // Get lease6 by DUID, IAID and subnet ID
+        GET_LEASE6_EXPIRE,          // Get expired lease6
+        GET_LEASE6_TYPE,            // Get lease6 by lease type
         GET_VERSION,                // Obtain version number
         INSERT_LEASE4,              // Add entry to lease4 table
         INSERT_LEASE6,              // Add entry to lease6 table
@@ -590,6 +681,26 @@ private:
         getLeaseCollection(stindex, bind, exchange6_, result);
     }
 
+    /// @brief Get Expired Leases Common Code
+    ///
+    /// This method performs the common actions for both flavours (V4 and V6)
+    /// of the getExpiredLeases method.  It binds the current time and the
+    /// maximum number of leases to the prepared statement and retrieves
+    /// the leases.
+    ///
+    /// @param [out] expired_leases The expired leases are appended to this
+    ///        collection.
+    /// @param max_leases Maximum number of leases returned; 0 means no
+    ///        limit.
+    /// @param stindex Index of statement being executed
+    ///
+    /// @throw isc::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    template<typename LeaseCollection>
+    void getExpiredLeasesCommon(LeaseCollection& expired_leases,
+                                const size_t max_leases,
+                                StatementIndex stindex) const;
+
     /// @brief Get Lease4 Common Code
     ///
     /// This method performs the common actions for the various getLease4()
@@ -652,6 +763,35 @@ private:
     ///        failed.
     bool deleteLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind);
 
+    ///@{
+    /// The following methods implement the lease writes and the commit
+    /// without taking the mutex. They are called by the public methods,
+    /// and by @c writeLeases which holds the mutex for the whole batch.
+    /// The caller must hold the mutex.
+
+    /// @brief Adds an IPv4 lease (see @c addLease).
+    bool addLeaseInternal(const Lease4Ptr& lease);
+
+    /// @brief Adds an IPv6 lease (see @c addLease).
+    bool addLeaseInternal(const Lease6Ptr& lease);
+
+    /// @brief Updates an IPv4 lease (see @c updateLease4).
+    void updateLease4Internal(const Lease4Ptr& lease4);
+
+    /// @brief Updates an IPv6 lease (see @c updateLease6).
+    void updateLease6Internal(const Lease6Ptr& lease6);
+
+    /// @brief Deletes a lease (see @c deleteLease).
+    bool deleteLeaseInternal(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Executes a single write of a batch (see
+    /// @c LeaseMgr::writeLease).
+    void writeLeaseInternal(LeaseWrite& write);
+
+    /// @brief Commits the transaction (see @c commit).
+    void commitInternal();
+    ///@}
+
     /// @brief Check Error and Throw Exception
     ///
     /// Virtually all MySQL functions return a status which, if non-zero,
@@ -685,6 +825,9 @@ private:
     MySqlHolder mysql_;
     std::vector<MYSQL_STMT*> statements_;       ///< Prepared statements
     std::vector<std::string> text_statements_;  ///< Raw text of statements
+
+    /// Serializes the use of the connection and of the exchange objects.
+    mutable isc::util::thread::Mutex mutex_;
 };
 
 }; // end of isc::dhcp namespace
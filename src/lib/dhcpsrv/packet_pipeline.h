@@ -0,0 +1,289 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef PACKET_PIPELINE_H
+#define PACKET_PIPELINE_H
+
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <exceptions/exceptions.h>
+#include <util/threads/bounded_queue.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Multi-threaded packet processing pipeline of the DHCP server.
+///
+/// The pipeline lets the server process multiple packets concurrently.
+/// It consists of three stages:
+/// - the receiver (the thread calling @c push, typically the main thread of
+///   the server) which receives the queries and places them in the queue,
+/// - a configurable number of worker threads which take the queries from
+///   the queue, process them and produce responses,
+/// - a single sender thread which transmits the responses, in batches of
+///   the responses which piled up while it was sending the previous ones.
+///
+/// The stages are connected with the bounded queues. When the query queue
+/// is full, the query is rejected and the receiver drops it, rather than
+/// letting the backlog of queries (and their latency) grow without bound.
+///
+/// By default, all workers take the queries from the same queue, so the
+/// queries sent by the same client may be processed concurrently and their
+/// responses sent in any order. If the pipeline is given a function which
+/// returns a key for the query (e.g. a hash of the client identifier), each
+/// worker gets its own queue and the queries with the same key are always
+/// processed by the same worker, in the order in which they were received.
+///
+/// The pipeline doesn't make the processing itself thread safe. The
+/// processing function is called concurrently by the workers, so it
+/// must serialize access to the shared state on its own.
+///
+/// @tparam PktPtrType Type of the pointer to the packet, i.e. @c Pkt4Ptr or
+/// @c Pkt6Ptr.
+template<typename PktPtrType>
+class PacketPipeline : public boost::noncopyable {
+public:
+
+    /// @brief Function processing a query and returning the response.
+    ///
+    /// The function returns a null pointer if there is no response to send.
+    typedef boost::function<PktPtrType(const PktPtrType&)> ProcessCallback;
+
+    /// @brief Function transmitting a batch of responses.
+    typedef boost::function<void(const std::vector<PktPtrType>&)>
+    SendCallback;
+
+    /// @brief Function returning the key selecting the worker for the query.
+    typedef boost::function<size_t(const PktPtrType&)> KeyCallback;
+
+    /// @brief Maximum number of responses handed to the send function at
+    /// once.
+    static const size_t SEND_BATCH_SIZE = 32;
+
+    /// @brief Constructor.
+    ///
+    /// Starts the worker threads and the sender thread.
+    ///
+    /// @param workers Number of the worker threads.
+    /// @param queue_size Capacity of the query queue and the response queue.
+    /// If the key function is specified, it is the capacity of the query
+    /// queue of each worker.
+    /// @param process Function processing the queries.
+    /// @param send Function transmitting the batches of responses.
+    /// @param key Optional function returning the key of the query. The
+    /// queries with the same key are processed in order by one worker.
+    ///
+    /// @throw isc::BadValue if the number of workers is 0.
+    /// @throw isc::InvalidParameter if the queue size is 0.
+    PacketPipeline(const size_t workers, const size_t queue_size,
+                   const ProcessCallback& process, const SendCallback& send,
+                   const KeyCallback& key = KeyCallback())
+        : process_(process), send_(send), key_(key), responses_(queue_size) {
+        if (workers == 0) {
+            isc_throw(isc::BadValue, "number of packet processing workers"
+                      " must be greater than 0");
+        }
+        const size_t queues_num = key_ ? workers : 1;
+        for (size_t i = 0; i < queues_num; ++i) {
+            queries_.push_back(QueuePtr(new Queue(queue_size)));
+        }
+        try {
+            sender_.reset(new util::thread::Thread(
+                boost::bind(&PacketPipeline::sendLoop, this)));
+            for (size_t i = 0; i < workers; ++i) {
+                workers_.push_back(ThreadPtr(new util::thread::Thread(
+                    boost::bind(&PacketPipeline::processLoop, this,
+                                queries_[i % queues_num]))));
+            }
+        } catch (...) {
+            // The destructor won't be called, so terminate the threads
+            // started so far, as they refer to this object.
+            stop();
+            throw;
+        }
+    }
+
+    /// @brief Destructor.
+    ///
+    /// Stops the pipeline.
+    ~PacketPipeline() {
+        stop();
+    }
+
+    /// @brief Hands the query over to the workers.
+    ///
+    /// @param query Query to be processed.
+    ///
+    /// @return true if the query has been queued, false if the queue is
+    /// full or the pipeline has been stopped.
+    bool push(const PktPtrType& query) {
+        const size_t index = key_ ? key_(query) % queries_.size() : 0;
+        return (queries_[index]->push(query));
+    }
+
+    /// @brief Hands the response over to the sender.
+    ///
+    /// It sends the responses which are not returned by the processing
+    /// function, e.g. the response which is held until the lease writes
+    /// made while processing the query have been committed. If the sender
+    /// can't keep up, it waits until there is room in the response queue.
+    ///
+    /// @param rsp Response to be sent.
+    ///
+    /// @return true if the response has been queued, false if the pipeline
+    /// has been stopped.
+    bool send(const PktPtrType& rsp) {
+        while (!responses_.push(rsp)) {
+            if (responses_.isClosed()) {
+                return (false);
+            }
+            responses_.waitIdle();
+        }
+        return (true);
+    }
+
+    /// @brief Waits until all queued queries have been processed and the
+    /// responses sent.
+    ///
+    /// The caller must not push new queries while waiting. When this method
+    /// returns, none of the pipeline threads accesses the server state, so
+    /// the server may be safely reconfigured.
+    void wait() {
+        for (size_t i = 0; i < queries_.size(); ++i) {
+            queries_[i]->waitIdle();
+        }
+        responses_.waitIdle();
+    }
+
+    /// @brief Stops the pipeline.
+    ///
+    /// The queries already queued are processed and their responses sent
+    /// before the threads terminate.
+    void stop() {
+        for (size_t i = 0; i < queries_.size(); ++i) {
+            queries_[i]->close();
+        }
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i]->wait();
+        }
+        workers_.clear();
+
+        responses_.close();
+        if (sender_) {
+            sender_->wait();
+            sender_.reset();
+        }
+    }
+
+    /// @brief Returns the number of the worker threads.
+    size_t getWorkersNum() const {
+        return (workers_.size());
+    }
+
+private:
+
+    /// @brief Queue of the packets.
+    typedef util::thread::BoundedQueue<PktPtrType> Queue;
+
+    /// @brief Pointer to the queue.
+    typedef boost::shared_ptr<Queue> QueuePtr;
+
+    /// @brief Main function of the worker thread.
+    ///
+    /// @param queries Queue from which the worker takes the queries.
+    void processLoop(const QueuePtr& queries) {
+        PktPtrType query;
+        while (queries->pop(query)) {
+            PktPtrType rsp;
+            try {
+                rsp = process_(query);
+            } catch (const std::exception& ex) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_PIPELINE_PROCESS_FAIL)
+                    .arg(ex.what());
+            } catch (...) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_PIPELINE_PROCESS_EXCEPTION);
+            }
+            // The response queue is full if the sender can't keep up with
+            // the workers. Rather than dropping the response (and losing the
+            // lease allocated for the client) wait for the sender to catch
+            // up.
+            if (rsp) {
+                send(rsp);
+            }
+            query.reset();
+            queries->done();
+        }
+    }
+
+    /// @brief Main function of the sender thread.
+    ///
+    /// The responses which are waiting in the queue are sent together, so
+    /// as they may be transmitted with a single system call.
+    void sendLoop() {
+        std::vector<PktPtrType> rsps;
+        while (responses_.popBatch(rsps, SEND_BATCH_SIZE) > 0) {
+            try {
+                send_(rsps);
+            } catch (const std::exception& ex) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_PIPELINE_SEND_FAIL)
+                    .arg(ex.what());
+            } catch (...) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_PIPELINE_SEND_EXCEPTION);
+            }
+            const size_t count = rsps.size();
+            rsps.clear();
+            responses_.done(count);
+        }
+    }
+
+    /// @brief Pointer to the thread.
+    typedef boost::shared_ptr<util::thread::Thread> ThreadPtr;
+
+    /// @brief Function processing the queries.
+    ProcessCallback process_;
+
+    /// @brief Function transmitting the responses.
+    SendCallback send_;
+
+    /// @brief Function returning the key of the query.
+    KeyCallback key_;
+
+    /// @brief Queries waiting for the workers.
+    ///
+    /// There is one queue shared by all workers or, if the key function
+    /// is specified, one queue per worker.
+    std::vector<QueuePtr> queries_;
+
+    /// @brief Responses waiting for the sender.
+    Queue responses_;
+
+    /// @brief Worker threads.
+    std::vector<ThreadPtr> workers_;
+
+    /// @brief Sender thread.
+    boost::scoped_ptr<util::thread::Thread> sender_;
+};
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // PACKET_PIPELINE_H
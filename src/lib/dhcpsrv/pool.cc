@@ -15,13 +15,128 @@
 #include <asiolink/io_address.h>
 #include <dhcpsrv/addr_utilities.h>
 #include <dhcpsrv/pool.h>
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+
+#include <limits>
 #include <sstream>
 
 using namespace isc::asiolink;
+using namespace isc::util::thread;
 
 namespace isc {
 namespace dhcp {
 
+/// @brief Usage of the addresses in a pool.
+///
+/// The bitmap holds one bit per position in the pool. The bit is set when
+/// the address is used. The bits past the end of the pool are always set,
+/// so as they are never found free.
+class PoolUsage {
+public:
+    /// @brief Constructor
+    ///
+    /// @param capacity number of positions in the pool
+    PoolUsage(uint64_t capacity)
+        : capacity_(capacity), bitmap_((capacity + 63) / 64, 0), used_(0) {
+        if (capacity % 64 != 0) {
+            bitmap_.back() = ~static_cast<uint64_t>(0) << (capacity % 64);
+        }
+    }
+
+    /// @brief Sets or clears the bit for the position.
+    ///
+    /// @param position position within the pool
+    /// @param used true if the position is to be marked used
+    void mark(uint64_t position, bool used) {
+        Mutex::Locker lock(mutex_);
+        uint64_t& word = bitmap_[position / 64];
+        const uint64_t bit = static_cast<uint64_t>(1) << (position % 64);
+        if (used && !(word & bit)) {
+            word |= bit;
+            ++used_;
+        } else if (!used && (word & bit)) {
+            word &= ~bit;
+            --used_;
+        }
+    }
+
+    /// @brief Number of positions in the pool
+    const uint64_t capacity_;
+
+    /// @brief Bitmap of used positions
+    std::vector<uint64_t> bitmap_;
+
+    /// @brief Number of used positions
+    uint64_t used_;
+
+    /// @brief Mutex protecting the bitmap and the counter
+    ///
+    /// The statistics may be read by a different thread than the one
+    /// allocating the leases.
+    Mutex mutex_;
+};
+
+namespace {
+
+/// @brief Returns the index of the least significant zero bit in the word.
+///
+/// @param word word which has at least one bit cleared
+/// @return bit index (0-63)
+unsigned int
+lowestZeroBit(uint64_t word) {
+#ifdef __GNUC__
+    return (__builtin_ctzll(~word));
+#else
+    unsigned int index = 0;
+    while (word & 1) {
+        word >>= 1;
+        ++index;
+    }
+    return (index);
+#endif
+}
+
+/// @brief Returns the bits above the shift of the difference of addresses.
+///
+/// @param addr address to subtract from
+/// @param first address to subtract
+/// @param shift number of the least significant bits to discard
+/// @param [out] value (addr - first) >> shift if it fits in the uint64_t
+/// @return false if the value doesn't fit in the uint64_t
+bool
+shiftedDifference(const IOAddress& addr, const IOAddress& first,
+                  unsigned int shift, uint64_t& value) {
+    const std::vector<uint8_t>& minuend = addr.toBytes();
+    const std::vector<uint8_t>& subtrahend = first.toBytes();
+
+    // Compute addr - first, byte by byte, starting from the least
+    // significant one.
+    std::vector<uint8_t> diff(minuend.size());
+    int borrow = 0;
+    for (int i = minuend.size() - 1; i >= 0; --i) {
+        int byte = static_cast<int>(minuend[i]) - subtrahend[i] - borrow;
+        borrow = (byte < 0) ? 1 : 0;
+        diff[i] = static_cast<uint8_t>(byte + borrow * 256);
+    }
+
+    value = 0;
+    const unsigned int bits = diff.size() * 8;
+    for (unsigned int bit = bits - 1; bit + 1 > shift; --bit) {
+        if (diff[diff.size() - 1 - bit / 8] & (1 << (bit % 8))) {
+            if (bit - shift >= 64) {
+                return (false);
+            }
+            value |= static_cast<uint64_t>(1) << (bit - shift);
+        }
+    }
+    return (true);
+}
+
+}; // anonymous namespace
+
+const uint64_t Pool::MAX_TRACKED_CAPACITY;
+
 Pool::Pool(Lease::Type type, const isc::asiolink::IOAddress& first,
            const isc::asiolink::IOAddress& last)
     :id_(getNextID()), first_(first), last_(last), type_(type) {
@@ -31,6 +146,137 @@ bool Pool::inRange(const isc::asiolink::IOAddress& addr) const {
     return (first_.smallerEqual(addr) && addr.smallerEqual(last_));
 }
 
+uint64_t
+Pool::getCapacity() const {
+    uint64_t count = 0;
+    if (!shiftedDifference(last_, first_, getPositionShift(), count) ||
+        (count == std::numeric_limits<uint64_t>::max())) {
+        return (std::numeric_limits<uint64_t>::max());
+    }
+    return (count + 1);
+}
+
+isc::asiolink::IOAddress
+Pool::getAddress(uint64_t position) const {
+    if (position >= getCapacity()) {
+        isc_throw(BadValue, "position " << position << " is out of range"
+                  " of the pool " << toText());
+    }
+
+    std::vector<uint8_t> addr = first_.toBytes();
+    const unsigned int shift = getPositionShift();
+    const unsigned int bits = addr.size() * 8;
+
+    // Add position << shift to the first address.
+    int carry = 0;
+    for (unsigned int bit = 0; bit < bits; bit += 8) {
+        unsigned int addend = 0;
+        for (unsigned int i = 0; i < 8; ++i) {
+            if ((bit + i >= shift) && (bit + i - shift < 64) &&
+                ((position >> (bit + i - shift)) & 1)) {
+                addend |= 1 << i;
+            }
+        }
+        const unsigned int index = addr.size() - 1 - bit / 8;
+        const unsigned int sum = addr[index] + addend + carry;
+        addr[index] = static_cast<uint8_t>(sum & 0xFF);
+        carry = sum >> 8;
+    }
+    return (IOAddress::fromBytes(first_.getFamily(), &addr[0]));
+}
+
+uint64_t
+Pool::getPosition(const isc::asiolink::IOAddress& addr) const {
+    uint64_t position = 0;
+    if (!inRange(addr) ||
+        !shiftedDifference(addr, first_, getPositionShift(), position)) {
+        isc_throw(BadValue, "address " << addr << " is out of range of the"
+                  " pool " << toText());
+    }
+    return (position);
+}
+
+void
+Pool::initUsage() {
+    const uint64_t capacity = getCapacity();
+    if (capacity > MAX_TRACKED_CAPACITY) {
+        isc_throw(InvalidOperation, "unable to track usage of the pool "
+                  << toText() << ": it has more than " << MAX_TRACKED_CAPACITY
+                  << " addresses");
+    }
+    usage_.reset(new PoolUsage(capacity));
+}
+
+void
+Pool::markUsed(const isc::asiolink::IOAddress& addr) {
+    const uint64_t position = getPosition(addr);
+    if (usage_) {
+        usage_->mark(position, true);
+    }
+}
+
+void
+Pool::markFree(const isc::asiolink::IOAddress& addr) {
+    const uint64_t position = getPosition(addr);
+    if (usage_) {
+        usage_->mark(position, false);
+    }
+}
+
+bool
+Pool::isUsed(const isc::asiolink::IOAddress& addr) const {
+    const uint64_t position = getPosition(addr);
+    if (!usage_) {
+        return (false);
+    }
+    Mutex::Locker lock(usage_->mutex_);
+    return (usage_->bitmap_[position / 64] &
+            (static_cast<uint64_t>(1) << (position % 64)));
+}
+
+bool
+Pool::findFreeAddress(const isc::asiolink::IOAddress& start,
+                      isc::asiolink::IOAddress& addr) const {
+    const uint64_t position = getPosition(start);
+    if (!usage_) {
+        return (false);
+    }
+
+    uint64_t found = 0;
+    {
+        Mutex::Locker lock(usage_->mutex_);
+        const std::vector<uint64_t>& bitmap = usage_->bitmap_;
+        if (usage_->used_ == usage_->capacity_) {
+            return (false);
+        }
+
+        // The bits below the start position in the first word are treated
+        // as used. They are checked when the scan wraps around to this word.
+        size_t index = position / 64;
+        uint64_t word = bitmap[index] |
+            ((static_cast<uint64_t>(1) << (position % 64)) - 1);
+        for (size_t i = 0; i <= bitmap.size(); ++i) {
+            if (word != ~static_cast<uint64_t>(0)) {
+                found = index * 64 + lowestZeroBit(word);
+                break;
+            }
+            index = (index + 1) % bitmap.size();
+            word = bitmap[index];
+        }
+    }
+    addr = getAddress(found);
+    return (true);
+}
+
+uint64_t
+Pool::getUsedCount() const {
+    if (!usage_) {
+        return (0);
+    }
+    Mutex::Locker lock(usage_->mutex_);
+    return (usage_->used_);
+}
+
 std::string
 Pool::toText() const {
     std::stringstream tmp;
@@ -21,9 +21,13 @@
 
 #include <vector>
 
+#include <stdint.h>
+
 namespace isc {
 namespace dhcp {
 
+class PoolUsage;
+
 /// @brief base class for Pool4 and Pool6
 ///
 /// Stores information about pool of IPv4 or IPv6 addresses.
@@ -66,6 +70,96 @@ public:
         return (type_);
     }
 
+    /// @brief Returns the number of addresses (or prefixes) in the pool.
+    ///
+    /// For the prefix delegation pools it is the number of prefixes of the
+    /// delegated length.
+    ///
+    /// @return number of addresses or prefixes, capped at the maximum value
+    /// of the uint64_t type
+    uint64_t getCapacity() const;
+
+    /// @brief Returns the address (or prefix) at the position in the pool.
+    ///
+    /// The first address in the pool is at position 0.
+    ///
+    /// @param position position within the pool
+    /// @throw BadValue if the position is out of range of the pool
+    /// @return address or prefix
+    isc::asiolink::IOAddress getAddress(uint64_t position) const;
+
+    /// @brief Returns the position of the address (or prefix) in the pool.
+    ///
+    /// @param addr address or prefix within the pool
+    /// @throw BadValue if the address doesn't belong to the pool
+    /// @return position within the pool
+    uint64_t getPosition(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Maximum capacity of the pool for which the usage may be tracked.
+    ///
+    /// The usage is tracked with one bit per address, so the limit bounds
+    /// the bitmap size to 128kB per pool.
+    static const uint64_t MAX_TRACKED_CAPACITY = 1048576;
+
+    /// @brief Starts tracking the usage of the addresses in the pool.
+    ///
+    /// All addresses are initially marked free. Any previously collected
+    /// usage information is discarded.
+    ///
+    /// @throw InvalidOperation if the pool capacity exceeds
+    /// @c MAX_TRACKED_CAPACITY
+    void initUsage();
+
+    /// @brief Checks if the usage of the addresses in the pool is tracked.
+    ///
+    /// @return true if @c initUsage has been called for the pool
+    bool isUsageTracked() const {
+        return (static_cast<bool>(usage_));
+    }
+
+    /// @brief Marks the address (or prefix) as used.
+    ///
+    /// This is a no-op if the usage is not tracked.
+    ///
+    /// @param addr address or prefix within the pool
+    /// @throw BadValue if the address doesn't belong to the pool
+    void markUsed(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Marks the address (or prefix) as free.
+    ///
+    /// This is a no-op if the usage is not tracked.
+    ///
+    /// @param addr address or prefix within the pool
+    /// @throw BadValue if the address doesn't belong to the pool
+    void markFree(const isc::asiolink::IOAddress& addr);
+
+    /// @brief Checks if the address (or prefix) is marked as used.
+    ///
+    /// @param addr address or prefix within the pool
+    /// @throw BadValue if the address doesn't belong to the pool
+    /// @return true if the address is marked as used, false if it is
+    /// marked as free or the usage is not tracked
+    bool isUsed(const isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Finds the first free address (or prefix) from the given one.
+    ///
+    /// The bitmap is scanned from the position of the @c start address
+    /// towards the end of the pool and then from the beginning of the pool,
+    /// so as the whole pool is checked.
+    ///
+    /// @param start address or prefix within the pool to start from
+    /// @param [out] addr free address or prefix found
+    /// @throw BadValue if the start address doesn't belong to the pool
+    /// @return true if the free address has been found, false if all
+    /// addresses are used or the usage is not tracked
+    bool findFreeAddress(const isc::asiolink::IOAddress& start,
+                         isc::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns the number of addresses marked as used.
+    ///
+    /// @return number of used addresses, 0 if the usage is not tracked
+    uint64_t getUsedCount() const;
+
     /// @brief returns textual representation of the pool
     ///
     /// @return textual representation
@@ -94,6 +188,16 @@ protected:
          const isc::asiolink::IOAddress& first,
          const isc::asiolink::IOAddress& last);
 
+    /// @brief Returns the number of address bits below the position.
+    ///
+    /// Consecutive positions in the pool are addresses that differ by
+    /// 2^shift. This is 0 for the address pools.
+    ///
+    /// @return number of bits the position is shifted by
+    virtual unsigned int getPositionShift() const {
+        return (0);
+    }
+
     /// @brief returns the next unique Pool-ID
     ///
     /// @return the next unique Pool-ID
@@ -120,6 +224,11 @@ protected:
 
     /// @brief defines a lease type that will be served from this pool
     Lease::Type type_;
+
+    /// @brief Usage of the addresses in the pool (NULL if not tracked)
+    ///
+    /// Copies of the pool share the usage information.
+    boost::shared_ptr<PoolUsage> usage_;
 };
 
 /// @brief Pool information for IPv4 addresses
@@ -205,7 +314,7 @@ public:
     /// This may be useful for "prefix/len" style definition for
     /// addresses, but is mostly useful for prefix pools.
     /// @return prefix length (1-128)
-    uint8_t getLength() {
+    uint8_t getLength() const {
         return (prefix_len_);
     }
 
@@ -214,6 +323,14 @@ public:
     /// @return textual representation
     virtual std::string toText() const;
 
+protected:
+    /// @brief Returns the number of address bits below the position.
+    ///
+    /// @return 128 - delegated prefix length
+    virtual unsigned int getPositionShift() const {
+        return (128 - prefix_len_);
+    }
+
 private:
     /// @brief Defines prefix length (for TYPE_PD only)
     uint8_t prefix_len_;
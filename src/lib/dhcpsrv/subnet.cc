@@ -17,6 +17,7 @@
 #include <dhcpsrv/addr_utilities.h>
 #include <dhcpsrv/subnet.h>
 
+#include <limits>
 #include <sstream>
 
 using namespace isc::asiolink;
@@ -32,7 +33,8 @@ Subnet::Subnet(const isc::asiolink::IOAddress& prefix, uint8_t len,
                const Triplet<uint32_t>& t2,
                const Triplet<uint32_t>& valid_lifetime,
                const isc::dhcp::Subnet::RelayInfo& relay)
-    :id_(generateNextID()), prefix_(prefix), prefix_len_(len),
+    :id_(generateNextID()), capacity_(0), capacity_ta_(0), capacity_pd_(0),
+     prefix_(prefix), prefix_len_(len),
      t1_(t1), t2_(t2), valid_(valid_lifetime),
      last_allocated_ia_(lastAddrInPrefix(prefix, len)),
      last_allocated_ta_(lastAddrInPrefix(prefix, len)),
@@ -156,6 +158,42 @@ void Subnet::delVendorOptions() {
     vendor_option_spaces_.clearItems();
 }
 
+namespace {
+
+/// @brief Precompiles the options held in the container.
+///
+/// @param options container holding the option descriptors.
+void
+precompileOptionContainer(const Subnet::OptionContainerPtr& options) {
+    for (Subnet::OptionContainer::const_iterator desc = options->begin();
+         desc != options->end(); ++desc) {
+        try {
+            desc->option->precompile();
+        } catch (const std::exception&) {
+            // The option is packed with each response instead, which
+            // reports the error.
+        }
+    }
+}
+
+}; // end of anonymous namespace
+
+void
+Subnet::precompileOptions() {
+    const std::list<std::string> spaces = option_spaces_.getOptionSpaceNames();
+    for (std::list<std::string>::const_iterator space = spaces.begin();
+         space != spaces.end(); ++space) {
+        precompileOptionContainer(option_spaces_.getItems(*space));
+    }
+
+    const std::list<uint32_t> vendor_ids =
+        vendor_option_spaces_.getOptionSpaceNames();
+    for (std::list<uint32_t>::const_iterator vendor_id = vendor_ids.begin();
+         vendor_id != vendor_ids.end(); ++vendor_id) {
+        precompileOptionContainer(vendor_option_spaces_.getItems(*vendor_id));
+    }
+}
+
 isc::asiolink::IOAddress Subnet::getLastAllocated(Lease::Type type) const {
     // check if the type is valid (and throw if it isn't)
     checkType(type);
@@ -250,6 +288,44 @@ const PoolCollection& Subnet::getPools(Lease::Type type) const {
     }
 }
 
+uint64_t
+Subnet::getPoolCapacity(Lease::Type type) const {
+    // check if the type is valid (and throw if it isn't)
+    checkType(type);
+
+    switch (type) {
+    case Lease::TYPE_V4:
+    case Lease::TYPE_NA:
+        return (capacity_);
+    case Lease::TYPE_TA:
+        return (capacity_ta_);
+    case Lease::TYPE_PD:
+        return (capacity_pd_);
+    default:
+        isc_throw(BadValue, "Unsupported pool type: "
+                  << static_cast<int>(type));
+    }
+}
+
+uint64_t&
+Subnet::getPoolCapacityWritable(Lease::Type type) {
+    // check if the type is valid (and throw if it isn't)
+    checkType(type);
+
+    switch (type) {
+    case Lease::TYPE_V4:
+    case Lease::TYPE_NA:
+        return (capacity_);
+    case Lease::TYPE_TA:
+        return (capacity_ta_);
+    case Lease::TYPE_PD:
+        return (capacity_pd_);
+    default:
+        isc_throw(BadValue, "Invalid pool type specified: "
+                  << static_cast<int>(type));
+    }
+}
+
 PoolCollection& Subnet::getPoolsWritable(Lease::Type type) {
     // check if the type is valid (and throw if it isn't)
     checkType(type);
@@ -311,11 +387,21 @@ Subnet::addPool(const PoolPtr& pool) {
 
     // Add the pool to the appropriate pools collection
     getPoolsWritable(pool->getType()).push_back(pool);
+
+    // Update the capacity of the pools, saturating on overflow.
+    uint64_t& capacity = getPoolCapacityWritable(pool->getType());
+    const uint64_t pool_capacity = pool->getCapacity();
+    if (pool_capacity > std::numeric_limits<uint64_t>::max() - capacity) {
+        capacity = std::numeric_limits<uint64_t>::max();
+    } else {
+        capacity += pool_capacity;
+    }
 }
 
 void
 Subnet::delPools(Lease::Type type) {
     getPoolsWritable(type).clear();
+    getPoolCapacityWritable(type) = 0;
 }
 
 void
@@ -30,6 +30,7 @@
 #include <dhcpsrv/pool.h>
 #include <dhcpsrv/triplet.h>
 #include <dhcpsrv/lease.h>
+#include <util/threads/sync.h>
 
 namespace isc {
 namespace dhcp {
@@ -217,6 +218,16 @@ public:
     /// @brief Deletes all vendor options configured for the subnet.
     void delVendorOptions();
 
+    /// @brief Precompiles the options configured for the subnet.
+    ///
+    /// Stores the on-wire data of all options configured for the subnet,
+    /// including the vendor options, so as they are copied into the
+    /// responses rather than packed for each response (see
+    /// @c Option::precompile). It is called when the configuration of the
+    /// subnet is committed. The options which can't be packed are left
+    /// intact, so as the error is reported when the response is sent.
+    void precompileOptions();
+
     /// @brief checks if the specified address is in pools
     ///
     /// Note the difference between inSubnet() and inPool(). For a given
@@ -310,6 +321,18 @@ public:
     void setLastAllocated(Lease::Type type,
                           const isc::asiolink::IOAddress& addr);
 
+    /// @brief Returns the mutex serializing the allocations in this subnet.
+    ///
+    /// The allocation engine holds it while it allocates a lease from the
+    /// subnet, so as the last allocated addresses and the usage of the pools
+    /// are modified by one thread at a time. The allocations in different
+    /// subnets may proceed concurrently.
+    ///
+    /// @return mutex of the subnet
+    isc::util::thread::Mutex& getAllocationMutex() const {
+        return (allocation_mutex_);
+    }
+
     /// @brief Returns unique ID for that subnet
     /// @return unique ID for that subnet
     SubnetID getID() const { return (id_); }
@@ -371,6 +394,16 @@ public:
     /// @return a collection of all pools
     const PoolCollection& getPools(Lease::Type type) const;
 
+    /// @brief Returns the number of addresses or prefixes in the pools.
+    ///
+    /// The value is updated when the pools are added or deleted, so as
+    /// the allocators don't have to walk over the pools for every packet.
+    ///
+    /// @param type lease type of the pools
+    /// @return number of addresses (or prefixes for PD). The value is
+    /// capped at the maximum value of the uint64_t type.
+    uint64_t getPoolCapacity(Lease::Type type) const;
+
     /// @brief Sets name of the network interface for directly attached networks
     ///
     /// @param iface_name name of the interface
@@ -464,6 +497,12 @@ protected:
     /// @return a collection of all pools
     PoolCollection& getPoolsWritable(Lease::Type type);
 
+    /// @brief Returns the capacity of the pools (non-const variant)
+    ///
+    /// @param type lease type of the pools
+    /// @return a reference to the capacity of the pools of this type
+    uint64_t& getPoolCapacityWritable(Lease::Type type);
+
     /// @brief Protected constructor
     //
     /// By making the constructor protected, we make sure that noone will
@@ -543,6 +582,15 @@ protected:
     /// @brief collection of IPv6 prefix pools in that subnet
     PoolCollection pools_pd_;
 
+    /// @brief number of addresses in the IPv4 or non-temporary IPv6 pools
+    uint64_t capacity_;
+
+    /// @brief number of addresses in the IPv6 temporary address pools
+    uint64_t capacity_ta_;
+
+    /// @brief number of prefixes in the IPv6 prefix pools
+    uint64_t capacity_pd_;
+
     /// @brief a prefix of the subnet
     isc::asiolink::IOAddress prefix_;
 
@@ -579,6 +627,11 @@ protected:
     /// See @ref last_allocated_ia_ for details.
     isc::asiolink::IOAddress last_allocated_pd_;
 
+    /// @brief Serializes the allocations in this subnet.
+    ///
+    /// See @ref getAllocationMutex for details.
+    mutable isc::util::thread::Mutex allocation_mutex_;
+
     /// @brief Name of the network interface (if connected directly)
     std::string iface_;
 
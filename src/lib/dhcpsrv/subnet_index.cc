@@ -0,0 +1,113 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/addr_utilities.h>
+#include <dhcpsrv/subnet_index.h>
+
+#include <algorithm>
+
+using namespace isc::asiolink;
+
+namespace isc {
+namespace dhcp {
+
+SubnetIndex::SubnetIndex()
+    : built_(false) {
+}
+
+void
+SubnetIndex::clear() {
+    prefixes_.clear();
+    relays_.clear();
+    ifaces_.clear();
+    interface_ids_.clear();
+    ids_.clear();
+    built_ = false;
+}
+
+void
+SubnetIndex::add(const SubnetPtr& subnet, size_t position) {
+    ids_[subnet->getID()].push_back(position);
+
+    const std::pair<IOAddress, uint8_t> prefix = subnet->get();
+    prefixes_[prefix.second][firstAddrInPrefix(prefix.first,
+                                               prefix.second)]
+        .push_back(position);
+
+    // The relay address is unspecified if no relay has been configured.
+    relays_[subnet->getRelayInfo().addr_].push_back(position);
+
+    const std::string iface = subnet->getIface();
+    if (!iface.empty()) {
+        ifaces_[iface].push_back(position);
+    }
+
+    Subnet6Ptr subnet6 = boost::dynamic_pointer_cast<Subnet6>(subnet);
+    if (subnet6 && subnet6->getInterfaceId()) {
+        const OptionPtr& interface_id = subnet6->getInterfaceId();
+        interface_ids_[std::make_pair(interface_id->getType(),
+                                      interface_id->getData())]
+            .push_back(position);
+    }
+}
+
+void
+SubnetIndex::findByAddress(const IOAddress& addr,
+                           Positions& positions) const {
+    const uint8_t max_len = addr.isV4() ? 32 : 128;
+    for (std::map<uint8_t, AddressMap>::const_iterator prefix =
+             prefixes_.begin(); prefix != prefixes_.end(); ++prefix) {
+        // The subnets of the other address family are never in range.
+        if (prefix->first > max_len) {
+            break;
+        }
+        appendPositions(prefix->second,
+                        firstAddrInPrefix(addr, prefix->first), positions);
+    }
+}
+
+void
+SubnetIndex::findByRelay(const IOAddress& addr, Positions& positions) const {
+    appendPositions(relays_, addr, positions);
+}
+
+void
+SubnetIndex::findByIface(const std::string& iface,
+                         Positions& positions) const {
+    appendPositions(ifaces_, iface, positions);
+}
+
+void
+SubnetIndex::findByInterfaceId(const OptionPtr& interface_id,
+                               Positions& positions) const {
+    appendPositions(interface_ids_,
+                    std::make_pair(interface_id->getType(),
+                                   interface_id->getData()),
+                    positions);
+}
+
+void
+SubnetIndex::findById(const SubnetID subnet_id, Positions& positions) const {
+    appendPositions(ids_, subnet_id, positions);
+}
+
+void
+SubnetIndex::sortPositions(Positions& positions) {
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()),
+                    positions.end());
+}
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
@@ -0,0 +1,177 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SUBNET_INDEX_H
+#define SUBNET_INDEX_H
+
+#include <asiolink/io_address.h>
+#include <dhcp/option.h>
+#include <dhcpsrv/subnet.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace isc {
+namespace dhcp {
+
+/// @brief Index of the configured subnets used for the subnet selection.
+///
+/// The subnets are looked up by the address (the longest prefix doesn't
+/// matter, any subnet covering the address is a candidate), by the relay
+/// address, by the interface name, by the interface-id option and by the
+/// subnet identifier. The
+/// index refers to the subnets by their positions in the collection it
+/// has been built from. Each lookup returns the positions of all subnets
+/// which match, so as the caller may apply the client class filtering and
+/// select the first matching subnet in the configuration order, exactly as
+/// if the whole collection was walked.
+///
+/// The subnets are indexed by the prefix of each configured length. The
+/// number of distinct prefix lengths is typically small, so the lookup by
+/// the address is a few map lookups regardless of the number of subnets.
+///
+/// The index reflects the state of the subnets at the time it was built.
+/// It must be rebuilt when the subnets are added, removed or modified.
+class SubnetIndex {
+public:
+    /// @brief Positions of the subnets in the indexed collection.
+    typedef std::vector<size_t> Positions;
+
+    /// @brief Constructor.
+    ///
+    /// Creates an index which hasn't been built.
+    SubnetIndex();
+
+    /// @brief Builds the index for the collection of subnets.
+    ///
+    /// @param subnets collection of pointers to the subnets
+    /// @tparam SubnetCollection a vector of Subnet4Ptr or Subnet6Ptr
+    template<typename SubnetCollection>
+    void build(const SubnetCollection& subnets) {
+        clear();
+        for (size_t position = 0; position < subnets.size(); ++position) {
+            add(subnets[position], position);
+        }
+        built_ = true;
+    }
+
+    /// @brief Removes all subnets from the index.
+    ///
+    /// The index is no longer considered built.
+    void clear();
+
+    /// @brief Checks if the index has been built.
+    ///
+    /// @return true if the index reflects the subnets collection
+    bool isBuilt() const {
+        return (built_);
+    }
+
+    /// @brief Finds the subnets which the address belongs to.
+    ///
+    /// @param addr address
+    /// @param [out] positions positions of the found subnets are appended
+    /// to this collection
+    void findByAddress(const isc::asiolink::IOAddress& addr,
+                       Positions& positions) const;
+
+    /// @brief Finds the subnets configured for the relay address.
+    ///
+    /// @param addr relay address
+    /// @param [out] positions positions of the found subnets are appended
+    /// to this collection
+    void findByRelay(const isc::asiolink::IOAddress& addr,
+                     Positions& positions) const;
+
+    /// @brief Finds the subnets configured for the interface.
+    ///
+    /// @param iface interface name
+    /// @param [out] positions positions of the found subnets are appended
+    /// to this collection
+    void findByIface(const std::string& iface, Positions& positions) const;
+
+    /// @brief Finds the subnets configured for the interface-id option.
+    ///
+    /// @param interface_id interface-id option
+    /// @param [out] positions positions of the found subnets are appended
+    /// to this collection
+    void findByInterfaceId(const OptionPtr& interface_id,
+                           Positions& positions) const;
+
+    /// @brief Finds the subnets with the identifier.
+    ///
+    /// @param subnet_id subnet identifier
+    /// @param [out] positions positions of the found subnets are appended
+    /// to this collection
+    void findById(const SubnetID subnet_id, Positions& positions) const;
+
+    /// @brief Sorts the positions and removes the duplicates.
+    ///
+    /// The positions found by multiple lookups are merged with this
+    /// function, so as they can be walked in the configuration order.
+    ///
+    /// @param positions positions of the subnets
+    static void sortPositions(Positions& positions);
+
+private:
+    /// @brief Adds the subnet to the index.
+    ///
+    /// @param subnet subnet to be added
+    /// @param position position of the subnet in the indexed collection
+    void add(const SubnetPtr& subnet, size_t position);
+
+    /// @brief Appends the positions found under the key in the map.
+    ///
+    /// @param map map to be searched
+    /// @param key key to be found
+    /// @param [out] positions positions are appended to this collection
+    template<typename Map>
+    static void appendPositions(const Map& map,
+                                const typename Map::key_type& key,
+                                Positions& positions) {
+        typename Map::const_iterator found = map.find(key);
+        if (found != map.end()) {
+            positions.insert(positions.end(), found->second.begin(),
+                             found->second.end());
+        }
+    }
+
+    /// @brief Subnets by the first address of the prefix.
+    typedef std::map<isc::asiolink::IOAddress, Positions> AddressMap;
+
+    /// @brief Subnets by the prefix length and the first address.
+    std::map<uint8_t, AddressMap> prefixes_;
+
+    /// @brief Subnets by the relay address.
+    AddressMap relays_;
+
+    /// @brief Subnets by the interface name.
+    std::map<std::string, Positions> ifaces_;
+
+    /// @brief Subnets by the interface-id option type and data.
+    std::map<std::pair<uint16_t, OptionBuffer>, Positions> interface_ids_;
+
+    /// @brief Subnets by the subnet identifier.
+    std::map<SubnetID, Positions> ids_;
+
+    /// @brief Indicates if the index has been built.
+    bool built_;
+};
+
+}; // end of isc::dhcp namespace
+}; // end of isc namespace
+
+#endif // SUBNET_INDEX_H
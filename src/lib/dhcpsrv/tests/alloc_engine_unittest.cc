@@ -18,6 +18,7 @@
 #include <dhcp/duid.h>
 #include <dhcp/dhcp4.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/async_lease_mgr.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/lease_mgr.h>
 #include <dhcpsrv/lease_mgr_factory.h>
@@ -29,6 +30,7 @@
 #include <hooks/callout_manager.h>
 #include <hooks/hooks_manager.h>
 
+#include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
@@ -48,6 +50,67 @@ using namespace isc::dhcp::test;
 
 namespace {
 
+/// @brief Appends the lease to the collection.
+///
+/// It is used as a callback collecting the reclaimed leases.
+///
+/// @param leases collection of the leases
+/// @param lease lease to be appended
+template<typename LeasePtrType>
+void collectLease(std::vector<LeasePtrType>* leases,
+                  const LeasePtrType& lease) {
+    leases->push_back(lease);
+}
+
+/// @brief Appends the result of the lease commit to the collection.
+///
+/// @param results collection of the results
+/// @param success result of the commit
+void recordCommit(std::vector<bool>* results, bool success) {
+    results->push_back(success);
+}
+
+/// @brief Holds the execution of the asynchronous lease operations.
+///
+/// The lookup queued by @c close blocks the thread of the lease manager
+/// until @c open is called, so as the writes queued after it remain
+/// pending.
+class CommitGate {
+public:
+    /// @brief Constructor.
+    CommitGate() : open_(false) {
+    }
+
+    /// @brief Queues the lookup blocking the lease manager.
+    ///
+    /// @param lease_mgr lease manager to be blocked
+    void close(AsyncLeaseMgr& lease_mgr) {
+        ASSERT_TRUE(lease_mgr.getLease4(IOAddress("0.0.0.0"),
+                                        boost::bind(&CommitGate::wait, this,
+                                                    _1)));
+    }
+
+    /// @brief Unblocks the lease manager.
+    void open() {
+        util::thread::Mutex::Locker lock(mutex_);
+        open_ = true;
+        cond_.broadcast();
+    }
+
+private:
+    /// @brief Blocks until @c open is called.
+    void wait(const Lease4Ptr&) {
+        util::thread::Mutex::Locker lock(mutex_);
+        while (!open_) {
+            cond_.wait(mutex_);
+        }
+    }
+
+    util::thread::Mutex mutex_;
+    util::thread::CondVar cond_;
+    bool open_;
+};
+
 /// @brief Allocation engine with some internal methods exposed
 class NakedAllocEngine : public AllocEngine {
 public:
@@ -64,6 +127,9 @@ public:
     // Expose internal classes for testing purposes
     using AllocEngine::Allocator;
     using AllocEngine::IterativeAllocator;
+    using AllocEngine::PositionalAllocator;
+    using AllocEngine::HashedAllocator;
+    using AllocEngine::RandomAllocator;
     using AllocEngine::getAllocator;
 
     /// @brief IterativeAllocator with internal methods exposed
@@ -470,9 +536,8 @@ public:
 TEST_F(AllocEngine6Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)), NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)), NotImplemented);
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)));
 
     ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100, true)));
 
@@ -800,6 +865,199 @@ TEST_F(AllocEngine6Test, IterativeAllocator_manyPools6) {
     }
 }
 
+// Checks that the allocation type names are converted to the types.
+TEST_F(AllocEngine6Test, allocTypeFromText) {
+    EXPECT_EQ(AllocEngine::ALLOC_ITERATIVE,
+              AllocEngine::allocTypeFromText("iterative"));
+    EXPECT_EQ(AllocEngine::ALLOC_HASHED,
+              AllocEngine::allocTypeFromText("hashed"));
+    EXPECT_EQ(AllocEngine::ALLOC_RANDOM,
+              AllocEngine::allocTypeFromText("random"));
+    EXPECT_THROW(AllocEngine::allocTypeFromText("fancy"), BadValue);
+}
+
+// Checks that the positions are mapped to the addresses and prefixes in
+// all pools of the subnet.
+TEST_F(AllocEngine6Test, PositionalAllocatorPositions) {
+    typedef NakedAllocEngine::PositionalAllocator Alloc;
+
+    const PoolCollection& pools = subnet_->getPools(Lease::TYPE_NA);
+    // The pool is 2001:db8:1::10 - 2001:db8:1::20.
+    EXPECT_EQ(17, subnet_->getPoolCapacity(Lease::TYPE_NA));
+    EXPECT_EQ("2001:db8:1::10",
+              Alloc::getAddress(pools, 0).toText());
+    EXPECT_EQ("2001:db8:1::20",
+              Alloc::getAddress(pools, 16).toText());
+    EXPECT_THROW(Alloc::getAddress(pools, 17), BadValue);
+
+    // Use the pools of the IterativeAllocatorPrefixStep test.
+    subnet_.reset(new Subnet6(IOAddress("2001:db8::"), 32, 1, 2, 3, 4));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_PD,
+                                        IOAddress("2001:db8::"), 56, 60)));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_PD,
+                                        IOAddress("2001:db8:1::"), 48, 48)));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_PD,
+                                        IOAddress("2001:db8:2::"), 56, 64)));
+    const PoolCollection& pd_pools = subnet_->getPools(Lease::TYPE_PD);
+    EXPECT_EQ(16 + 1 + 256, subnet_->getPoolCapacity(Lease::TYPE_PD));
+    EXPECT_EQ("2001:db8:0:10::",
+              Alloc::getAddress(pd_pools, 1).toText());
+    EXPECT_EQ("2001:db8:0:f0::",
+              Alloc::getAddress(pd_pools, 15).toText());
+    EXPECT_EQ("2001:db8:1::",
+              Alloc::getAddress(pd_pools, 16).toText());
+    EXPECT_EQ("2001:db8:2::",
+              Alloc::getAddress(pd_pools, 17).toText());
+    EXPECT_EQ("2001:db8:2:ff::",
+              Alloc::getAddress(pd_pools, 272).toText());
+
+}
+
+// Checks that the hashed allocator picks the same address for the same
+// client and walks over all addresses when the candidates are rejected.
+TEST_F(AllocEngine6Test, HashedAllocator) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+
+    const IOAddress first = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, first));
+    // The new allocation for the same client starts at the same address.
+    EXPECT_EQ(first.toText(),
+              alloc.pickAddress(subnet_, duid_, IOAddress("::")).toText());
+
+    // Walk over all addresses by rejecting each candidate.
+    std::set<IOAddress> generated_addrs;
+    IOAddress candidate = first;
+    generated_addrs.insert(candidate);
+    for (int i = 1; i < 17; ++i) {
+        candidate = alloc.pickAddress(subnet_, duid_, candidate);
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        generated_addrs.insert(candidate);
+    }
+    EXPECT_EQ(17, generated_addrs.size());
+    // Then the walk wraps around.
+    EXPECT_EQ(first.toText(),
+              alloc.pickAddress(subnet_, duid_, candidate).toText());
+
+    // Different clients are spread over the pool.
+    generated_addrs.clear();
+    for (uint8_t i = 0; i < 50; ++i) {
+        DuidPtr duid(new DUID(vector<uint8_t>(8, i)));
+        generated_addrs.insert(alloc.pickAddress(subnet_, duid,
+                                                 IOAddress("::")));
+    }
+    EXPECT_LT(1, generated_addrs.size());
+}
+
+// Checks that the random allocator picks addresses from the pool and
+// walks at most MAX_PROBES consecutive addresses from a random start.
+TEST_F(AllocEngine6Test, RandomAllocator) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_NA);
+
+    subnet_.reset(new Subnet6(IOAddress("2001:db8:1::"), 56, 1, 2, 3, 4));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_NA,
+                                        IOAddress("2001:db8:1::"), 64)));
+
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_,
+                                                IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        generated_addrs.insert(candidate);
+    }
+    // The chance of the collision within the /64 pool is negligible.
+    EXPECT_LT(990, generated_addrs.size());
+
+    // Walk from the random start and count the consecutive addresses.
+    IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    uint64_t consecutive = 1;
+    for (;;) {
+        IOAddress next = alloc.pickAddress(subnet_, duid_, candidate);
+        const uint64_t step = next.toBytes()[15] - candidate.toBytes()[15];
+        candidate = next;
+        if ((step != 1) && (static_cast<uint8_t>(step) != 1)) {
+            break;
+        }
+        ++consecutive;
+        ASSERT_GE(NakedAllocEngine::RandomAllocator::MAX_PROBES, consecutive);
+    }
+    // The walk may only end early if the start happens to be placed right
+    // before the end of the pool.
+    EXPECT_EQ(NakedAllocEngine::RandomAllocator::MAX_PROBES, consecutive);
+}
+
+// Checks that the hashed and random allocators can be used by the engine
+// to allocate the last free address in the pool.
+TEST_F(AllocEngine6Test, smallPoolHashedRandom6) {
+    const AllocEngine::AllocType types[] = { AllocEngine::ALLOC_HASHED,
+                                             AllocEngine::ALLOC_RANDOM };
+    initSubnet(IOAddress("2001:db8:1::"), IOAddress("2001:db8:1::ad"),
+               IOAddress("2001:db8:1::af"));
+    // Two of the three addresses are taken.
+    DuidPtr other_duid(new DUID(vector<uint8_t>(12, 0xff)));
+    for (int i = 0; i < 2; ++i) {
+        IOAddress addr(i == 0 ? "2001:db8:1::ad" : "2001:db8:1::af");
+        Lease6Ptr used(new Lease6(Lease::TYPE_NA, addr, other_duid, i, 501,
+                                  502, 503, 504, subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        SCOPED_TRACE(i == 0 ? "hashed" : "random");
+        boost::scoped_ptr<AllocEngine> engine;
+        ASSERT_NO_THROW(engine.reset(new AllocEngine(types[i], 100)));
+
+        Lease6Ptr lease;
+        ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                        duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                        false, "", true, CalloutHandlePtr(), old_leases_)));
+        ASSERT_TRUE(lease);
+        EXPECT_EQ("2001:db8:1::ae", lease->addr_.toText());
+    }
+}
+
+// Checks that the allocation engine skips the addresses known to be used
+// when the usage of the pools is tracked.
+TEST_F(AllocEngine6Test, poolTracking6) {
+    initSubnet(IOAddress("2001:db8:1::"), IOAddress("2001:db8:1::10"),
+               IOAddress("2001:db8:1::1f"));
+    DuidPtr other_duid(new DUID(vector<uint8_t>(12, 0xff)));
+    for (int i = 0; i < 5; ++i) {
+        Lease6Ptr used(new Lease6(Lease::TYPE_NA, pool_->getAddress(i),
+                                  other_duid, i, 501, 502, 503, 504,
+                                  subnet_->getID()));
+        // The last lease has expired.
+        if (i == 4) {
+            used->cltt_ = time(NULL) - 1000;
+        }
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+    }
+
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100)));
+    EXPECT_FALSE(engine->getPoolTracking());
+    EXPECT_FALSE(pool_->isUsageTracked());
+
+    // The usage of all pools is collected when the tracking is enabled.
+    // The expired lease doesn't make its address used.
+    engine->setPoolTracking(true);
+    EXPECT_TRUE(engine->getPoolTracking());
+    ASSERT_TRUE(pool_->isUsageTracked());
+    EXPECT_EQ(4, pool_->getUsedCount());
+    EXPECT_FALSE(pool_->isUsed(pool_->getAddress(4)));
+    EXPECT_TRUE(pd_pool_->isUsageTracked());
+    EXPECT_EQ(0, pd_pool_->getUsedCount());
+
+    // The expired lease is reused.
+    Lease6Ptr lease;
+    ASSERT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", false, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("2001:db8:1::14", lease->addr_.toText());
+    EXPECT_EQ(5, pool_->getUsedCount());
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine6Test, smallPool6) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -842,6 +1100,61 @@ TEST_F(AllocEngine6Test, smallPool6) {
     EXPECT_FALSE(old_leases_[0]);
 }
 
+// This test checks that the lease is allocated while the write of the lease
+// allocated for another client is pending, and that the address of the
+// pending lease is not handed out again.
+TEST_F(AllocEngine6Test, commitPending6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100)));
+    ASSERT_TRUE(engine);
+
+    AsyncLeaseMgr lease_mgr(16, 8);
+    CommitGate gate;
+    gate.close(lease_mgr);
+    std::vector<bool> results;
+
+    LeaseCommitPtr commit(new LeaseCommit(lease_mgr));
+    Lease6Ptr lease;
+    EXPECT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", false, CalloutHandlePtr(), old_leases_,
+                    commit)));
+    ASSERT_TRUE(lease);
+    commit->close(boost::bind(&recordCommit, &results, _1));
+    EXPECT_EQ(1, commit->getPending());
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(lease->type_,
+                                                       lease->addr_));
+
+    // The second client asks for the same address and it gets another one
+    // while the lease of the first client is not written yet.
+    DuidPtr duid2(new DUID(vector<uint8_t>(8, 0x45)));
+    LeaseCommitPtr commit2(new LeaseCommit(lease_mgr));
+    Lease6Ptr lease2;
+    EXPECT_NO_THROW(lease2 = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid2, iaid_, lease->addr_, Lease::TYPE_NA, false, false,
+                    "", false, CalloutHandlePtr(), old_leases_, commit2)));
+    ASSERT_TRUE(lease2);
+    EXPECT_NE(lease->addr_, lease2->addr_);
+    commit2->close(boost::bind(&recordCommit, &results, _1));
+    EXPECT_TRUE(results.empty());
+
+    // Both leases are written when the lease manager is unblocked.
+    gate.open();
+    lease_mgr.wait();
+    ASSERT_EQ(2, results.size());
+    EXPECT_TRUE(results[0]);
+    EXPECT_TRUE(results[1]);
+
+    Lease6Ptr from_mgr = LeaseMgrFactory::instance().getLease6(lease->type_,
+                                                               lease->addr_);
+    ASSERT_TRUE(from_mgr);
+    detailCompareLease(lease, from_mgr);
+    from_mgr = LeaseMgrFactory::instance().getLease6(lease2->type_,
+                                                     lease2->addr_);
+    ASSERT_TRUE(from_mgr);
+    detailCompareLease(lease2, from_mgr);
+}
+
 // This test checks if all addresses in a pool are currently used, the attempt
 // to find out a new lease fails.
 TEST_F(AllocEngine6Test, outOfAddresses6) {
@@ -985,6 +1298,52 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
     detailCompareLease(lease, from_mgr);
 }
 
+// This test checks that the expired leases are reclaimed: removed from the
+// database, marked free in the pool and passed to the callback.
+TEST_F(AllocEngine6Test, reclaimExpiredLeases6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100)));
+    engine->setPoolTracking(true);
+    pool_->initUsage();
+
+    // Three expired leases and one valid lease.
+    for (int i = 0; i < 4; ++i) {
+        stringstream addr;
+        addr << "2001:db8:1::1" << i;
+        DuidPtr duid(new DUID(vector<uint8_t>(8, i)));
+        Lease6Ptr lease(new Lease6(Lease::TYPE_NA, IOAddress(addr.str()),
+                                   duid, i, 501, 502, 503, 504,
+                                   subnet_->getID(), 0));
+        if (i < 3) {
+            lease->cltt_ = time(NULL) - 1000 + i;
+        }
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        pool_->markUsed(lease->addr_);
+    }
+    ASSERT_TRUE(pool_->isUsageTracked());
+    ASSERT_EQ(4, pool_->getUsedCount());
+
+    std::vector<Lease6Ptr> reclaimed;
+    AllocEngine::ReclamationStats stats =
+        engine->reclaimExpiredLeases6(0, 0, boost::bind(&collectLease<Lease6Ptr>,
+                                                        &reclaimed, _1));
+    EXPECT_EQ(3, stats.reclaimed_);
+    EXPECT_FALSE(stats.timed_out_);
+
+    // The leases have been reclaimed in the order of their expiration.
+    ASSERT_EQ(3, reclaimed.size());
+    EXPECT_EQ("2001:db8:1::10", reclaimed[0]->addr_.toText());
+    EXPECT_EQ("2001:db8:1::11", reclaimed[1]->addr_.toText());
+    EXPECT_EQ("2001:db8:1::12", reclaimed[2]->addr_.toText());
+
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                 IOAddress("2001:db8:1::10")));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                IOAddress("2001:db8:1::13")));
+    EXPECT_EQ(1, pool_->getUsedCount());
+}
+
 // --- IPv4 ---
 
 // This test checks if the v4 Allocation Engine can be instantiated, parses
@@ -992,11 +1351,10 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
 TEST_F(AllocEngine4Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5, false)),
-                 NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5, false)),
-                 NotImplemented);
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5,
+                                            false)));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5,
+                                            false)));
 
     // Create V4 (ipv6=false) Allocation Engine that will try at most
     // 100 attempts to pick up a lease
@@ -1310,6 +1668,189 @@ TEST_F(AllocEngine4Test, IterativeAllocator_manyPools4) {
 }
 
 
+// Checks that the hashed allocator handles the clients with and without
+// client identifier.
+TEST_F(AllocEngine4Test, HashedAllocator) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+
+    const IOAddress first = alloc.pickAddress(subnet_, clientid_,
+                                              IOAddress("0.0.0.0"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, first));
+    EXPECT_EQ(first.toText(), alloc.pickAddress(subnet_, clientid_,
+                                                IOAddress("0.0.0.0")).toText());
+
+    // The clients without client identifier start at the beginning of
+    // the pool.
+    IOAddress candidate = alloc.pickAddress(subnet_, ClientIdPtr(),
+                                            IOAddress("0.0.0.0"));
+    EXPECT_EQ("192.0.2.100", candidate.toText());
+    candidate = alloc.pickAddress(subnet_, ClientIdPtr(), candidate);
+    EXPECT_EQ("192.0.2.101", candidate.toText());
+}
+
+// Checks that the clients which don't send a client identifier are keyed
+// by their hardware address when the hashed allocator is used.
+TEST_F(AllocEngine4Test, hashedAllocNoClientId4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_HASHED,
+                                                 100, false)));
+
+    Lease4Ptr lease = engine->allocateLease4(subnet_, ClientIdPtr(), hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "", true,
+                                             CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+
+    // The address is the one picked for the hardware address.
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+    DuidPtr hwaddr_key(new DUID(hwaddr_->hwaddr_));
+    EXPECT_EQ(alloc.pickAddress(subnet_, hwaddr_key,
+                                IOAddress("0.0.0.0")).toText(),
+              lease->addr_.toText());
+}
+
+// Checks that the random allocator picks the addresses from the pool.
+TEST_F(AllocEngine4Test, RandomAllocator) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_V4);
+
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, clientid_,
+                                                IOAddress("0.0.0.0"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+        generated_addrs.insert(candidate);
+    }
+    // All 10 addresses of the pool should have been picked.
+    EXPECT_EQ(10, generated_addrs.size());
+}
+
+// Checks that the hashed and random allocators find the only free address
+// in the pool.
+TEST_F(AllocEngine4Test, smallPoolHashedRandom4) {
+    const AllocEngine::AllocType types[] = { AllocEngine::ALLOC_HASHED,
+                                             AllocEngine::ALLOC_RANDOM };
+    // Take all addresses but 192.0.2.105.
+    uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    uint8_t clientid2[] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    for (int i = 100; i < 110; ++i) {
+        if (i == 105) {
+            continue;
+        }
+        stringstream addr;
+        addr << "192.0.2." << i;
+        hwaddr2[5] = i;
+        clientid2[7] = i;
+        Lease4Ptr used(new Lease4(IOAddress(addr.str()), hwaddr2,
+                                  sizeof(hwaddr2), clientid2,
+                                  sizeof(clientid2), 501, 502, 503,
+                                  time(NULL), subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        SCOPED_TRACE(i == 0 ? "hashed" : "random");
+        boost::scoped_ptr<AllocEngine> engine;
+        ASSERT_NO_THROW(engine.reset(new AllocEngine(types[i], 100, false)));
+
+        Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                                 IOAddress("0.0.0.0"),
+                                                 false, false, "", true,
+                                                 CalloutHandlePtr(),
+                                                 old_lease_);
+        ASSERT_TRUE(lease);
+        EXPECT_EQ("192.0.2.105", lease->addr_.toText());
+    }
+}
+
+// Checks that the allocation engine skips the addresses known to be used
+// when the usage of the pools is tracked.
+TEST_F(AllocEngine4Test, poolTracking4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+
+    // Take the first five addresses.
+    uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    uint8_t clientid2[] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    for (int i = 100; i < 105; ++i) {
+        stringstream addr;
+        addr << "192.0.2." << i;
+        hwaddr2[5] = i;
+        clientid2[7] = i;
+        Lease4Ptr used(new Lease4(IOAddress(addr.str()), hwaddr2,
+                                  sizeof(hwaddr2), clientid2,
+                                  sizeof(clientid2), 501, 502, 503,
+                                  time(NULL), subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+    }
+
+    // The usage is collected when the tracking is enabled.
+    engine->setPoolTracking(true);
+    ASSERT_TRUE(pool_->isUsageTracked());
+    EXPECT_EQ(5, pool_->getUsedCount());
+
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "", false,
+                                             CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.105", lease->addr_.toText());
+    EXPECT_EQ(6, pool_->getUsedCount());
+
+    // Take the next address without the engine knowing about it.
+    hwaddr2[5] = 106;
+    clientid2[7] = 106;
+    Lease4Ptr used(new Lease4(IOAddress("192.0.2.106"), hwaddr2,
+                              sizeof(hwaddr2), clientid2, sizeof(clientid2),
+                              501, 502, 503, time(NULL), subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+
+    // The engine notices that the address is used and takes the next one.
+    ClientIdPtr clientid3(new ClientId(vector<uint8_t>(8, 0x33)));
+    HWAddrPtr hwaddr3(new HWAddr(vector<uint8_t>(6, 0x33), HTYPE_ETHER));
+    lease = engine->allocateLease4(subnet_, clientid3, hwaddr3,
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   false, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.107", lease->addr_.toText());
+    EXPECT_EQ(8, pool_->getUsedCount());
+
+    // The fake allocation doesn't mark the address used.
+    ClientIdPtr clientid4(new ClientId(vector<uint8_t>(8, 0x44)));
+    HWAddrPtr hwaddr4(new HWAddr(vector<uint8_t>(6, 0x44), HTYPE_ETHER));
+    lease = engine->allocateLease4(subnet_, clientid4, hwaddr4,
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   true, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(8, pool_->getUsedCount());
+
+    // The lease which has expired since the usage was collected is found
+    // for the hint. Its address is marked free, even though the fake
+    // allocation doesn't reuse it yet.
+    Lease4Ptr expired =
+        LeaseMgrFactory::instance().getLease4(IOAddress("192.0.2.100"));
+    ASSERT_TRUE(expired);
+    expired->cltt_ = time(NULL) - 1000;
+    ASSERT_NO_THROW(LeaseMgrFactory::instance().updateLease4(expired));
+    ClientIdPtr clientid5(new ClientId(vector<uint8_t>(8, 0x55)));
+    HWAddrPtr hwaddr5(new HWAddr(vector<uint8_t>(6, 0x55), HTYPE_ETHER));
+    lease = engine->allocateLease4(subnet_, clientid5, hwaddr5,
+                                   IOAddress("192.0.2.100"), false, false, "",
+                                   true, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.100", lease->addr_.toText());
+    EXPECT_FALSE(pool_->isUsed(IOAddress("192.0.2.100")));
+
+    // The real allocation reuses the lease and marks the address used.
+    lease = engine->allocateLease4(subnet_, clientid5, hwaddr5,
+                                   IOAddress("192.0.2.100"), false, false, "",
+                                   false, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.100", lease->addr_.toText());
+    EXPECT_TRUE(pool_->isUsed(IOAddress("192.0.2.100")));
+    EXPECT_EQ(8, pool_->getUsedCount());
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine4Test, smallPool4) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -1556,6 +2097,129 @@ TEST_F(AllocEngine4Test, renewLease4) {
     detailCompareLease(lease, from_mgr);
 }
 
+// This test checks that the lease is allocated while the write of the lease
+// allocated for another client is pending, and that the address of the
+// pending lease is not handed out again.
+TEST_F(AllocEngine4Test, commitPending4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    AsyncLeaseMgr lease_mgr(16, 8);
+    CommitGate gate;
+    gate.close(lease_mgr);
+    std::vector<bool> results;
+
+    LeaseCommitPtr commit(new LeaseCommit(lease_mgr));
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"), false,
+                                             false, "", false,
+                                             CalloutHandlePtr(), old_lease_,
+                                             commit);
+    ASSERT_TRUE(lease);
+    commit->close(boost::bind(&recordCommit, &results, _1));
+    EXPECT_EQ(1, commit->getPending());
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(lease->addr_));
+
+    // The second client asks for the same address and it gets another one
+    // while the lease of the first client is not written yet.
+    const uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    const uint8_t clientid2[] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    LeaseCommitPtr commit2(new LeaseCommit(lease_mgr));
+    Lease4Ptr lease2 = engine->allocateLease4(subnet_,
+        ClientIdPtr(new ClientId(clientid2, sizeof(clientid2))),
+        HWAddrPtr(new HWAddr(hwaddr2, sizeof(hwaddr2), HTYPE_ETHER)),
+        lease->addr_, false, false, "", false, CalloutHandlePtr(),
+        old_lease_, commit2);
+    ASSERT_TRUE(lease2);
+    EXPECT_NE(lease->addr_, lease2->addr_);
+    commit2->close(boost::bind(&recordCommit, &results, _1));
+    EXPECT_TRUE(results.empty());
+
+    // Both leases are written when the lease manager is unblocked.
+    gate.open();
+    lease_mgr.wait();
+    ASSERT_EQ(2, results.size());
+    EXPECT_TRUE(results[0]);
+    EXPECT_TRUE(results[1]);
+
+    Lease4Ptr from_mgr = LeaseMgrFactory::instance().getLease4(lease->addr_);
+    ASSERT_TRUE(from_mgr);
+    detailCompareLease(lease, from_mgr);
+    from_mgr = LeaseMgrFactory::instance().getLease4(lease2->addr_);
+    ASSERT_TRUE(from_mgr);
+    detailCompareLease(lease2, from_mgr);
+
+    // The committed lease is now renewed for its client.
+    Lease4Ptr renewed = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                               IOAddress("0.0.0.0"), false,
+                                               false, "", false,
+                                               CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(renewed);
+    EXPECT_EQ(lease->addr_, renewed->addr_);
+    EXPECT_TRUE(old_lease_);
+}
+
+// This test checks that the expired leases are reclaimed: removed from the
+// database, marked free in the pool and passed to the callback. It also
+// checks that the number of leases reclaimed in one cycle is limited.
+TEST_F(AllocEngine4Test, reclaimExpiredLeases4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    engine->setPoolTracking(true);
+    pool_->initUsage();
+
+    // Five expired leases and one valid lease.
+    uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    uint8_t clientid2[] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    for (int i = 100; i < 106; ++i) {
+        stringstream addr;
+        addr << "192.0.2." << i;
+        hwaddr2[5] = i;
+        clientid2[7] = i;
+        // The first lease expires last.
+        const time_t cltt = (i == 105) ? time(NULL) :
+            time(NULL) - 1000 - (i == 100 ? 0 : 200 - i);
+        Lease4Ptr lease(new Lease4(IOAddress(addr.str()), hwaddr2,
+                                   sizeof(hwaddr2), clientid2,
+                                   sizeof(clientid2), 501, 502, 503,
+                                   cltt, subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        pool_->markUsed(lease->addr_);
+    }
+    ASSERT_EQ(6, pool_->getUsedCount());
+
+    std::vector<Lease4Ptr> reclaimed;
+    AllocEngine::Lease4ReclaimCallback callback =
+        boost::bind(&collectLease<Lease4Ptr>, &reclaimed, _1);
+
+    // Only two leases are reclaimed in the first cycle, the ones which
+    // expired first.
+    AllocEngine::ReclamationStats stats =
+        engine->reclaimExpiredLeases4(2, 0, callback);
+    EXPECT_EQ(2, stats.reclaimed_);
+    ASSERT_EQ(2, reclaimed.size());
+    EXPECT_EQ("192.0.2.101", reclaimed[0]->addr_.toText());
+    EXPECT_EQ("192.0.2.102", reclaimed[1]->addr_.toText());
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(IOAddress("192.0.2.101")));
+    EXPECT_EQ(4, pool_->getUsedCount());
+
+    // The next cycle reclaims the remaining expired leases.
+    stats = engine->reclaimExpiredLeases4(0, 0, callback);
+    EXPECT_EQ(3, stats.reclaimed_);
+    ASSERT_EQ(5, reclaimed.size());
+    EXPECT_EQ("192.0.2.100", reclaimed[4]->addr_.toText());
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(IOAddress("192.0.2.105")));
+    EXPECT_EQ(1, pool_->getUsedCount());
+
+    // Nothing left to reclaim.
+    stats = engine->reclaimExpiredLeases4(0, 0, callback);
+    EXPECT_EQ(0, stats.reclaimed_);
+    EXPECT_EQ(5, reclaimed.size());
+}
+
 /// @brief helper class used in Hooks testing in AllocEngine6
 ///
 /// It features a couple of callout functions and buffers to store
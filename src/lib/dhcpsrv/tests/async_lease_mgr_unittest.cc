@@ -0,0 +1,392 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/async_lease_mgr.h>
+#include <dhcpsrv/lease_mgr_factory.h>
+#include <dhcpsrv/memfile_lease_mgr.h>
+#include <dhcpsrv/tests/generic_lease_mgr_unittest.h>
+#include <util/threads/sync.h>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::dhcp::test;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Memfile backend recording the sizes of the batches of writes.
+///
+/// The execution of the batches can be blocked, so as the test can queue
+/// operations while the thread executing them is busy.
+class RecordingLeaseMgr : public Memfile_LeaseMgr {
+public:
+
+    /// @brief Constructor.
+    RecordingLeaseMgr()
+        : Memfile_LeaseMgr(LeaseMgr::ParameterMap()), blocked_(false),
+          writing_(false) {
+    }
+
+    /// @brief Records the size of the batch and executes it.
+    ///
+    /// If the backend is blocked, it waits until it's released.
+    virtual void writeLeases(LeaseWriteCollection& writes) {
+        {
+            Mutex::Locker locker(mutex_);
+            batches_.push_back(writes.size());
+            writing_ = true;
+            cond_.broadcast();
+            while (blocked_) {
+                cond_.wait(mutex_);
+            }
+            writing_ = false;
+        }
+        Memfile_LeaseMgr::writeLeases(writes);
+    }
+
+    /// @brief Blocks the execution of the following batches.
+    void block() {
+        Mutex::Locker locker(mutex_);
+        blocked_ = true;
+    }
+
+    /// @brief Waits until the blocked batch is being executed.
+    void waitWriting() {
+        Mutex::Locker locker(mutex_);
+        while (!writing_) {
+            cond_.wait(mutex_);
+        }
+    }
+
+    /// @brief Lets the blocked batch complete.
+    void release() {
+        Mutex::Locker locker(mutex_);
+        blocked_ = false;
+        cond_.broadcast();
+    }
+
+    /// @brief Sizes of the executed batches.
+    std::vector<size_t> batches_;
+
+private:
+    /// @brief Mutex protecting the members.
+    Mutex mutex_;
+
+    /// @brief Signalled when the batch starts or the backend is released.
+    CondVar cond_;
+
+    /// @brief Indicates if the batches are blocked.
+    bool blocked_;
+
+    /// @brief Indicates if the batch is being executed.
+    bool writing_;
+};
+
+/// @brief Test fixture class for the @c AsyncLeaseMgr.
+class AsyncLeaseMgrTest : public GenericLeaseMgrTest {
+public:
+
+    /// @brief Constructor.
+    AsyncLeaseMgrTest()
+        : lease_mgr_(new RecordingLeaseMgr()) {
+        lmptr_ = lease_mgr_;
+    }
+
+    /// @brief Destructor.
+    virtual ~AsyncLeaseMgrTest() {
+        delete lmptr_;
+        lmptr_ = 0;
+    }
+
+    /// @brief Not used by these tests.
+    virtual void reopen() {
+    }
+
+    /// @brief Stores the result of the write.
+    void writeDone(const LeaseWrite& write) {
+        writes_.push_back(write);
+    }
+
+    /// @brief Stores the IPv4 lease read.
+    void lease4Read(const Lease4Ptr& lease) {
+        leases4_.push_back(lease);
+    }
+
+    /// @brief Stores the IPv6 lease read.
+    void lease6Read(const Lease6Ptr& lease) {
+        leases6_.push_back(lease);
+    }
+
+    /// @brief Stores the result of the commit.
+    ///
+    /// The number of the writes completed so far is stored along with it.
+    void commitDone(const bool success) {
+        commits_.push_back(std::make_pair(success, writes_.size()));
+    }
+
+    /// @brief Returns the callback storing the result of the commit.
+    LeaseCommit::CompletionCallback commitCallback() {
+        return (boost::bind(&AsyncLeaseMgrTest::commitDone, this, _1));
+    }
+
+    /// @brief Returns the callback storing the result of the write.
+    AsyncLeaseMgr::WriteCallback writeCallback() {
+        return (boost::bind(&AsyncLeaseMgrTest::writeDone, this, _1));
+    }
+
+    /// @brief Returns the callback storing the IPv4 lease read.
+    AsyncLeaseMgr::Lease4Callback lease4Callback() {
+        return (boost::bind(&AsyncLeaseMgrTest::lease4Read, this, _1));
+    }
+
+    /// @brief Returns the callback storing the IPv6 lease read.
+    AsyncLeaseMgr::Lease6Callback lease6Callback() {
+        return (boost::bind(&AsyncLeaseMgrTest::lease6Read, this, _1));
+    }
+
+    /// @brief Backend used by the tests.
+    RecordingLeaseMgr* lease_mgr_;
+
+    /// @brief Results of the writes in the order of completion.
+    std::vector<LeaseWrite> writes_;
+
+    /// @brief IPv4 leases read in the order of completion.
+    std::vector<Lease4Ptr> leases4_;
+
+    /// @brief IPv6 leases read in the order of completion.
+    std::vector<Lease6Ptr> leases6_;
+
+    /// @brief Results of the commits and the numbers of the writes
+    /// completed before them.
+    std::vector<std::pair<bool, size_t> > commits_;
+};
+
+// Checks that the invalid parameters are rejected.
+TEST_F(AsyncLeaseMgrTest, constructor) {
+    EXPECT_THROW(AsyncLeaseMgr(*lease_mgr_, 0, 1), InvalidParameter);
+    EXPECT_THROW(AsyncLeaseMgr(*lease_mgr_, 1, 0), BadValue);
+    AsyncLeaseMgr async_mgr(*lease_mgr_, 16, 4);
+    EXPECT_EQ(4, async_mgr.getMaxBatchSize());
+}
+
+// Checks that the queued operations are executed and their callbacks are
+// invoked in order.
+TEST_F(AsyncLeaseMgrTest, operations) {
+    std::vector<Lease4Ptr> leases4 = createLeases4();
+    std::vector<Lease6Ptr> leases6 = createLeases6();
+    AsyncLeaseMgr async_mgr(*lease_mgr_);
+
+    EXPECT_TRUE(async_mgr.addLease(leases4[1], writeCallback()));
+    EXPECT_TRUE(async_mgr.addLease(leases6[1], writeCallback()));
+    EXPECT_TRUE(async_mgr.getLease4(ioaddress4_[1], lease4Callback()));
+    EXPECT_TRUE(async_mgr.getLease6(leasetype6_[1], ioaddress6_[1],
+                                    lease6Callback()));
+    leases4[1]->valid_lft_ += 100;
+    EXPECT_TRUE(async_mgr.updateLease4(leases4[1], writeCallback()));
+    EXPECT_TRUE(async_mgr.updateLease6(leases6[2], writeCallback()));
+    EXPECT_TRUE(async_mgr.deleteLease(ioaddress6_[1], writeCallback()));
+    // The write without the callback.
+    EXPECT_TRUE(async_mgr.addLease(leases4[2]));
+    EXPECT_TRUE(async_mgr.getLease6(leasetype6_[1], ioaddress6_[1],
+                                    lease6Callback()));
+    async_mgr.wait();
+
+    ASSERT_EQ(5, writes_.size());
+    EXPECT_EQ(LeaseWrite::ADD, writes_[0].type_);
+    EXPECT_TRUE(writes_[0].result_);
+    EXPECT_TRUE(writes_[1].result_);
+    EXPECT_EQ(LeaseWrite::UPDATE, writes_[2].type_);
+    EXPECT_TRUE(writes_[2].result_);
+    // The IPv6 lease to be updated hasn't been added.
+    EXPECT_FALSE(writes_[3].result_);
+    EXPECT_FALSE(writes_[3].error_.empty());
+    EXPECT_EQ(LeaseWrite::DELETE, writes_[4].type_);
+    EXPECT_EQ(ioaddress6_[1], writes_[4].addr_);
+    EXPECT_TRUE(writes_[4].result_);
+
+    // The reads see the preceding writes.
+    ASSERT_EQ(1, leases4_.size());
+    ASSERT_TRUE(leases4_[0]);
+    EXPECT_EQ(ioaddress4_[1], leases4_[0]->addr_);
+    ASSERT_EQ(2, leases6_.size());
+    ASSERT_TRUE(leases6_[0]);
+    EXPECT_EQ(ioaddress6_[1], leases6_[0]->addr_);
+    EXPECT_FALSE(leases6_[1]);
+
+    Lease4Ptr lease = lease_mgr_->getLease4(ioaddress4_[1]);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(leases4[1]->valid_lft_, lease->valid_lft_);
+    EXPECT_TRUE(lease_mgr_->getLease4(ioaddress4_[2]));
+}
+
+// Checks that the writes queued while the backend is busy are executed in
+// batches and that the reads are not reordered with the writes.
+TEST_F(AsyncLeaseMgrTest, batches) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    AsyncLeaseMgr async_mgr(*lease_mgr_, 16, 3);
+
+    lease_mgr_->block();
+    EXPECT_TRUE(async_mgr.addLease(leases[0], writeCallback()));
+    lease_mgr_->waitWriting();
+
+    // The first write is in progress, so the following operations pile up.
+    for (int i = 1; i < 5; ++i) {
+        EXPECT_TRUE(async_mgr.addLease(leases[i], writeCallback()));
+    }
+    EXPECT_TRUE(async_mgr.getLease4(ioaddress4_[4], lease4Callback()));
+    EXPECT_TRUE(async_mgr.deleteLease(ioaddress4_[0], writeCallback()));
+    lease_mgr_->release();
+    async_mgr.wait();
+
+    // The operations are taken from the queue 3 at a time. The read
+    // splits the writes of the last 3 operations into two batches.
+    ASSERT_EQ(4, lease_mgr_->batches_.size());
+    EXPECT_EQ(1, lease_mgr_->batches_[0]);
+    EXPECT_EQ(3, lease_mgr_->batches_[1]);
+    EXPECT_EQ(1, lease_mgr_->batches_[2]);
+    EXPECT_EQ(1, lease_mgr_->batches_[3]);
+
+    ASSERT_EQ(6, writes_.size());
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_TRUE(writes_[i].result_) << "write " << i;
+    }
+    ASSERT_EQ(1, leases4_.size());
+    EXPECT_TRUE(leases4_[0]);
+    EXPECT_FALSE(lease_mgr_->getLease4(ioaddress4_[0]));
+}
+
+// Checks that the operations are rejected when the queue is full and when
+// the manager has been stopped.
+TEST_F(AsyncLeaseMgrTest, queueFull) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    AsyncLeaseMgr async_mgr(*lease_mgr_, 2, 8);
+
+    lease_mgr_->block();
+    EXPECT_TRUE(async_mgr.addLease(leases[0]));
+    lease_mgr_->waitWriting();
+
+    EXPECT_TRUE(async_mgr.addLease(leases[1]));
+    EXPECT_TRUE(async_mgr.addLease(leases[2]));
+    EXPECT_FALSE(async_mgr.addLease(leases[3]));
+    lease_mgr_->release();
+
+    // The queued operations are executed before the thread terminates.
+    async_mgr.stop();
+    EXPECT_FALSE(async_mgr.deleteLease(ioaddress4_[0]));
+    EXPECT_TRUE(lease_mgr_->getLease4(ioaddress4_[2]));
+    EXPECT_FALSE(lease_mgr_->getLease4(ioaddress4_[3]));
+}
+
+// Checks that the operations are executed on the backend created by the
+// factory.
+TEST_F(AsyncLeaseMgrTest, factoryBackend) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    LeaseMgrFactory::create("type=memfile");
+    {
+        AsyncLeaseMgr async_mgr(16, 4);
+        EXPECT_TRUE(async_mgr.addLease(leases[1], writeCallback()));
+        EXPECT_TRUE(async_mgr.write(LeaseWrite(LeaseWrite::ADD, leases[2]),
+                                    writeCallback()));
+        async_mgr.wait();
+    }
+    ASSERT_EQ(2, writes_.size());
+    EXPECT_TRUE(writes_[0].result_);
+    EXPECT_TRUE(writes_[1].result_);
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(ioaddress4_[1]));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(ioaddress4_[2]));
+    EXPECT_FALSE(lease_mgr_->getLease4(ioaddress4_[1]));
+    LeaseMgrFactory::destroy();
+}
+
+// Checks that the commit completes when all its writes have been executed,
+// while the submitter continues.
+TEST_F(AsyncLeaseMgrTest, commit) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    AsyncLeaseMgr async_mgr(*lease_mgr_);
+
+    lease_mgr_->block();
+    LeaseCommitPtr commit(new LeaseCommit(async_mgr));
+    EXPECT_TRUE(commit->submit(LeaseWrite(LeaseWrite::ADD, leases[1]),
+                               writeCallback()));
+    lease_mgr_->waitWriting();
+    EXPECT_TRUE(commit->submit(LeaseWrite(LeaseWrite::ADD, leases[2]),
+                               writeCallback()));
+
+    // The lease is copied on submission, so its modification doesn't
+    // affect the pending write.
+    const uint32_t valid_lft = leases[2]->valid_lft_;
+    leases[2]->valid_lft_ += 100;
+    commit->close(commitCallback());
+    EXPECT_EQ(2, commit->getPending());
+    EXPECT_TRUE(commits_.empty());
+    EXPECT_THROW(commit->submit(LeaseWrite(LeaseWrite::ADD, leases[3])),
+                 InvalidOperation);
+    EXPECT_THROW(commit->close(commitCallback()), InvalidOperation);
+
+    // The completion callback is invoked after the callbacks of the writes.
+    lease_mgr_->release();
+    async_mgr.wait();
+    EXPECT_EQ(0, commit->getPending());
+    ASSERT_EQ(1, commits_.size());
+    EXPECT_TRUE(commits_[0].first);
+    EXPECT_EQ(2, commits_[0].second);
+    Lease4Ptr lease = lease_mgr_->getLease4(ioaddress4_[2]);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(valid_lft, lease->valid_lft_);
+    EXPECT_FALSE(lease_mgr_->getLease4(ioaddress4_[3]));
+}
+
+// Checks that the commit fails if any of its writes fails and that the
+// commit without pending writes completes when it is closed.
+TEST_F(AsyncLeaseMgrTest, commitFailure) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    AsyncLeaseMgr async_mgr(*lease_mgr_);
+    ASSERT_TRUE(lease_mgr_->addLease(leases[1]));
+
+    LeaseCommitPtr commit(new LeaseCommit(async_mgr));
+    EXPECT_TRUE(commit->submit(LeaseWrite(LeaseWrite::ADD, leases[1])));
+    EXPECT_TRUE(commit->submit(LeaseWrite(LeaseWrite::ADD, leases[2])));
+    async_mgr.wait();
+    EXPECT_TRUE(commits_.empty());
+    commit->close(commitCallback());
+    ASSERT_EQ(1, commits_.size());
+    EXPECT_FALSE(commits_[0].first);
+
+    commit.reset(new LeaseCommit(async_mgr));
+    commit->close(commitCallback());
+    ASSERT_EQ(2, commits_.size());
+    EXPECT_TRUE(commits_[1].first);
+
+    // The rejected write doesn't make the commit fail.
+    async_mgr.stop();
+    commit.reset(new LeaseCommit(async_mgr));
+    EXPECT_FALSE(commit->submit(LeaseWrite(LeaseWrite::ADD, leases[3])));
+    EXPECT_EQ(0, commit->getPending());
+    commit->close(commitCallback());
+    ASSERT_EQ(3, commits_.size());
+    EXPECT_TRUE(commits_[2].first);
+}
+
+} // end of anonymous namespace
@@ -19,7 +19,9 @@
 #include <dhcp/pkt4.h>
 #include <dhcpsrv/callout_handle_store.h>
 #include "test_get_callout_handle.h"
+#include <util/threads/thread.h>
 
+#include <boost/bind.hpp>
 #include <gtest/gtest.h>
 
 using namespace isc;
@@ -28,6 +30,17 @@ using namespace isc::hooks;
 
 namespace {
 
+/// @brief Gets the CalloutHandle for the packet.
+///
+/// It is run in a separate thread.
+///
+/// @param pktptr Packet.
+/// @param [out] chptr CalloutHandle returned for the packet.
+void
+getHandleInThread(const Pkt4Ptr& pktptr, CalloutHandlePtr& chptr) {
+    chptr = getCalloutHandle(pktptr);
+}
+
 TEST(CalloutHandleStoreTest, StoreRetrieve) {
 
     // Create two DHCP4 packets during tests.  The constructor arguments are
@@ -119,4 +132,63 @@ TEST(CalloutHandleStoreTest, SeparateCompilationUnit) {
     EXPECT_TRUE(chptr_1 == chptr_2);
 }
 
+// Checks that the threads processing the packets concurrently don't share
+// the CalloutHandles.
+
+TEST(CalloutHandleStoreTest, SeparateThreads) {
+    Pkt4Ptr pktptr_1(new Pkt4(DHCPDISCOVER, 1234));
+    Pkt4Ptr pktptr_2(new Pkt4(DHCPDISCOVER, 5678));
+    CalloutHandlePtr chptr_1 = getCalloutHandle(pktptr_1);
+    ASSERT_TRUE(chptr_1);
+
+    // Another thread gets a different handle, even for the same packet.
+    CalloutHandlePtr chptr_2;
+    isc::util::thread::Thread thread_1(boost::bind(&getHandleInThread,
+                                                   pktptr_1,
+                                                   boost::ref(chptr_2)));
+    thread_1.wait();
+    ASSERT_TRUE(chptr_2);
+    EXPECT_FALSE(chptr_1 == chptr_2);
+
+    // The other thread, which gets a handle for another packet, doesn't
+    // replace the handle stored for this thread.
+    CalloutHandlePtr chptr_3;
+    isc::util::thread::Thread thread_2(boost::bind(&getHandleInThread,
+                                                   pktptr_2,
+                                                   boost::ref(chptr_3)));
+    thread_2.wait();
+    ASSERT_TRUE(chptr_3);
+    EXPECT_TRUE(chptr_1 == getCalloutHandle(pktptr_1));
+
+    // The data stored for the terminated threads has been released.
+    EXPECT_EQ(1, chptr_2.use_count());
+    EXPECT_EQ(1, chptr_3.use_count());
+
+    // Clear the stored pointers.
+    getCalloutHandle(Pkt4Ptr());
+}
+
+// Checks that the handles stored for all threads can be released, e.g.
+// before the hooks libraries are reloaded.
+
+TEST(CalloutHandleStoreTest, ClearAll) {
+    Pkt4Ptr pktptr_1(new Pkt4(DHCPDISCOVER, 1234));
+    CalloutHandlePtr chptr_1 = getCalloutHandle(pktptr_1);
+    ASSERT_TRUE(chptr_1);
+    EXPECT_EQ(2, chptr_1.use_count());
+    EXPECT_EQ(2, pktptr_1.use_count());
+
+    CalloutHandleStore<Pkt4Ptr>::clearAll();
+    EXPECT_EQ(1, chptr_1.use_count());
+    EXPECT_EQ(1, pktptr_1.use_count());
+
+    // A new handle is created for the same packet.
+    CalloutHandlePtr chptr_2 = getCalloutHandle(pktptr_1);
+    ASSERT_TRUE(chptr_2);
+    EXPECT_FALSE(chptr_1 == chptr_2);
+
+    // Clear the stored pointers.
+    getCalloutHandle(Pkt4Ptr());
+}
+
 } // Anonymous namespace
@@ -682,6 +682,112 @@ TEST_F(CfgMgrTest, classifySubnet6InterfaceId) {
     EXPECT_EQ(subnet3, cfg_mgr.getSubnet6(ifaceid, classify_));
 }
 
+// This test verifies that the indexed IPv4 subnet selection returns the
+// same subnets as the walk over all subnets, including the client class
+// filtering and the configuration order of the overlapping subnets.
+TEST_F(CfgMgrTest, indexSubnets4) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet4Ptr subnet1(new Subnet4(IOAddress("192.0.2.0"), 26, 1, 2, 3));
+    Subnet4Ptr subnet2(new Subnet4(IOAddress("192.0.2.64"), 26, 1, 2, 3));
+    Subnet4Ptr subnet3(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
+    subnet2->setRelayInfo(IOAddress("10.0.0.2"));
+    subnet1->allowClientClass("foo");
+
+    cfg_mgr.addSubnet4(subnet1);
+    cfg_mgr.addSubnet4(subnet2);
+    cfg_mgr.addSubnet4(subnet3);
+    cfg_mgr.indexSubnets4();
+
+    // The client doesn't belong to the foo class, so the subnet1 is skipped.
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnet4(IOAddress("192.0.2.5"), classify_));
+    classify_.insert("foo");
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet4(IOAddress("192.0.2.5"), classify_));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4(IOAddress("192.0.2.70"), classify_));
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnet4(IOAddress("192.0.2.130"), classify_));
+    EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.3.1"), classify_));
+
+    // The relay address selects the subnet which is not in range of it.
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4(IOAddress("10.0.0.2"), classify_,
+                                          true));
+    EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("10.0.0.2"), classify_));
+
+    // Adding the subnet invalidates the index, but the subnet is found.
+    Subnet4Ptr subnet4(new Subnet4(IOAddress("192.0.3.0"), 24, 1, 2, 3));
+    cfg_mgr.addSubnet4(subnet4);
+    EXPECT_EQ(subnet4, cfg_mgr.getSubnet4(IOAddress("192.0.3.1"), classify_));
+    cfg_mgr.indexSubnets4();
+    EXPECT_EQ(subnet4, cfg_mgr.getSubnet4(IOAddress("192.0.3.1"), classify_));
+
+    // The index is cleared together with the subnets.
+    cfg_mgr.deleteSubnets4();
+    EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.5"), classify_));
+}
+
+// This test verifies that the subnets are found by their identifiers, with
+// and without the index.
+TEST_F(CfgMgrTest, subnetById) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet4Ptr subnet1(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
+    Subnet4Ptr subnet2(new Subnet4(IOAddress("192.0.3.0"), 24, 1, 2, 3));
+    Subnet6Ptr subnet3(new Subnet6(IOAddress("2000::"), 48, 1, 2, 3, 4));
+    cfg_mgr.addSubnet4(subnet1);
+    cfg_mgr.addSubnet4(subnet2);
+    cfg_mgr.addSubnet6(subnet3);
+
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4(subnet2->getID()));
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnet6(subnet3->getID()));
+    EXPECT_FALSE(cfg_mgr.getSubnet6(subnet1->getID()));
+
+    cfg_mgr.indexSubnets4();
+    cfg_mgr.indexSubnets6();
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet4(subnet1->getID()));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet4(subnet2->getID()));
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnet6(subnet3->getID()));
+    EXPECT_FALSE(cfg_mgr.getSubnet4(subnet3->getID()));
+}
+
+// This test verifies that the indexed IPv6 subnet selection by the address,
+// relay address, interface name and interface-id respects the client
+// classification.
+TEST_F(CfgMgrTest, indexSubnets6) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+
+    Subnet6Ptr subnet1(new Subnet6(IOAddress("2000::"), 48, 1, 2, 3, 4));
+    Subnet6Ptr subnet2(new Subnet6(IOAddress("2000::"), 32, 1, 2, 3, 4));
+    Subnet6Ptr subnet3(new Subnet6(IOAddress("3000::"), 48, 1, 2, 3, 4));
+    OptionPtr ifaceid = generateInterfaceId("relay1.eth0");
+    subnet1->setInterfaceId(ifaceid);
+    subnet2->setInterfaceId(ifaceid);
+    subnet1->setIface("foo");
+    subnet3->setIface("foo");
+    subnet3->setRelayInfo(IOAddress("2001:db8:ff::1"));
+    subnet1->allowClientClass("alpha");
+
+    cfg_mgr.addSubnet6(subnet1);
+    cfg_mgr.addSubnet6(subnet2);
+    cfg_mgr.addSubnet6(subnet3);
+    cfg_mgr.indexSubnets6();
+
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet6(IOAddress("2000::1"), classify_));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet6(ifaceid, classify_));
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnet6("foo", classify_));
+    EXPECT_EQ(subnet3, cfg_mgr.getSubnet6(IOAddress("2001:db8:ff::1"),
+                                          classify_, true));
+    EXPECT_FALSE(cfg_mgr.getSubnet6(generateInterfaceId("VL32"), classify_));
+    EXPECT_FALSE(cfg_mgr.getSubnet6("bar", classify_));
+
+    // Once the client belongs to the alpha class, the subnet1 takes
+    // precedence because it comes first in the configuration.
+    classify_.insert("alpha");
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet6(IOAddress("2000::1"), classify_));
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet6(ifaceid, classify_));
+    EXPECT_EQ(subnet1, cfg_mgr.getSubnet6("foo", classify_));
+    EXPECT_EQ(subnet2, cfg_mgr.getSubnet6(IOAddress("2000:0:1::1"),
+                                          classify_));
+}
+
 // This test verifies if the configuration manager is able to hold and return
 // valid leases
 TEST_F(CfgMgrTest, subnet6) {
@@ -232,6 +232,24 @@ TEST_F(DbAccessParserTest, emptyKeyword) {
     checkAccessString("Valid memfile", parser.getDbAccessParameters(), config);
 }
 
+// Check that the numeric parameters are passed to the lease manager as
+// strings.
+TEST_F(DbAccessParserTest, integerKeyword) {
+    const char* config[] = {"type", "memfile",
+                            "sync-batch", "16",
+                            "compact-threshold", "0",
+                            NULL};
+
+    ConstElementPtr json_elements =
+        Element::fromJSON("{ \"type\": \"memfile\", \"sync-batch\": 16, "
+                          "\"compact-threshold\": 0 }");
+
+    TestDbAccessParser parser("lease-database");
+    EXPECT_NO_THROW(parser.build(json_elements));
+    checkAccessString("Numeric memfile parameters",
+                      parser.getDbAccessParameters(), config);
+}
+
 // Check that the parser works with a valid MySQL configuration
 TEST_F(DbAccessParserTest, validTypeMysql) {
     const char* config[] = {"type",     "mysql",
@@ -0,0 +1,305 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcpsrv/lease_journal.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/tests/test_utils.h>
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+
+#include <stdio.h>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+using namespace isc::dhcp::test;
+
+namespace {
+
+/// @brief Test fixture class for the @c LeaseJournal.
+class LeaseJournalTest : public ::testing::Test {
+public:
+
+    /// @brief Constructor
+    ///
+    /// Removes the journal file left over by the previous tests.
+    LeaseJournalTest()
+        : filename_(std::string(TEST_DATA_BUILDDIR) + "/lease_journal.test") {
+        static_cast<void>(remove(filename_.c_str()));
+    }
+
+    /// @brief Destructor
+    ///
+    /// Removes the journal file.
+    virtual ~LeaseJournalTest() {
+        static_cast<void>(remove(filename_.c_str()));
+    }
+
+    /// @brief Returns the contents of the journal file.
+    std::string readFile() const {
+        std::ifstream fs(filename_.c_str());
+        return (std::string(std::istreambuf_iterator<char>(fs),
+                            std::istreambuf_iterator<char>()));
+    }
+
+    /// @brief Appends arbitrary text to the journal file.
+    void appendFile(const std::string& text) const {
+        std::ofstream fs(filename_.c_str(), std::ios::app);
+        fs << text;
+    }
+
+    /// @brief Creates an IPv4 lease used in the tests.
+    Lease4Ptr createLease4(const std::string& addr) const {
+        const uint8_t hwaddr[] = { 0x08, 0x00, 0x2b, 0x02, 0x3f, 0x4e };
+        const uint8_t clientid[] = { 0x01, 0x02, 0x03, 0x04 };
+        Lease4Ptr lease(new Lease4(IOAddress(addr), hwaddr, sizeof(hwaddr),
+                                   clientid, sizeof(clientid), 3600, 1800,
+                                   2700, 1234567, 7, true, false,
+                                   "host,with\\odd\nchars.example.org"));
+        return (lease);
+    }
+
+    /// @brief Creates an IPv6 lease used in the tests.
+    Lease6Ptr createLease6(const std::string& addr) const {
+        DuidPtr duid(new DUID(std::vector<uint8_t>(8, 0x42)));
+        Lease6Ptr lease(new Lease6(Lease::TYPE_PD, IOAddress(addr), duid, 77,
+                                   1000, 2000, 500, 800, 9, false, true,
+                                   "host.example.org", 56));
+        lease->cltt_ = 7654321;
+        return (lease);
+    }
+
+    /// @brief Name of the journal file used by the tests.
+    std::string filename_;
+};
+
+// Checks that the leases written to the journal can be read back.
+TEST_F(LeaseJournalTest, appendAndReplay) {
+    Lease4Ptr lease4 = createLease4("192.0.2.3");
+    Lease6Ptr lease6 = createLease6("2001:db8:1::");
+    {
+        LeaseJournal journal(filename_);
+        ASSERT_NO_THROW(journal.open());
+        ASSERT_TRUE(journal.isOpen());
+        ASSERT_NO_THROW(journal.append(*lease4));
+        ASSERT_NO_THROW(journal.append(*lease6));
+        ASSERT_NO_THROW(journal.appendDelete(IOAddress("192.0.2.4")));
+        ASSERT_NO_THROW(journal.appendDelete(IOAddress("2001:db8:1::")));
+        EXPECT_EQ(4, journal.getRecordCount());
+    }
+
+    LeaseJournal journal(filename_);
+    journal.startReplay();
+
+    LeaseJournal::Record record;
+    ASSERT_TRUE(journal.readRecord(record));
+    EXPECT_EQ(LeaseJournal::RECORD_LEASE4, record.type_);
+    EXPECT_EQ("192.0.2.3", record.addr_.toText());
+    ASSERT_TRUE(record.lease4_);
+    detailCompareLease(lease4, record.lease4_);
+
+    ASSERT_TRUE(journal.readRecord(record));
+    EXPECT_EQ(LeaseJournal::RECORD_LEASE6, record.type_);
+    ASSERT_TRUE(record.lease6_);
+    detailCompareLease(lease6, record.lease6_);
+    EXPECT_EQ(lease6->cltt_, record.lease6_->cltt_);
+
+    ASSERT_TRUE(journal.readRecord(record));
+    EXPECT_EQ(LeaseJournal::RECORD_DELETE4, record.type_);
+    EXPECT_EQ("192.0.2.4", record.addr_.toText());
+
+    ASSERT_TRUE(journal.readRecord(record));
+    EXPECT_EQ(LeaseJournal::RECORD_DELETE6, record.type_);
+    EXPECT_EQ("2001:db8:1::", record.addr_.toText());
+
+    EXPECT_FALSE(journal.readRecord(record));
+    EXPECT_EQ(4, journal.getRecordCount());
+    EXPECT_EQ(0, journal.getInvalidCount());
+}
+
+// Checks that replaying a journal which doesn't exist yields no records.
+TEST_F(LeaseJournalTest, replayNoFile) {
+    LeaseJournal journal(filename_);
+    journal.startReplay();
+    LeaseJournal::Record record;
+    EXPECT_FALSE(journal.readRecord(record));
+    EXPECT_EQ(0, journal.getRecordCount());
+}
+
+// Checks that the records are synchronized in batches.
+TEST_F(LeaseJournalTest, syncBatch) {
+    LeaseJournal journal(filename_, 3);
+    ASSERT_NO_THROW(journal.open());
+
+    journal.appendDelete(IOAddress("192.0.2.1"));
+    journal.appendDelete(IOAddress("192.0.2.2"));
+    EXPECT_EQ(2, journal.getUnsyncedCount());
+    journal.appendDelete(IOAddress("192.0.2.3"));
+    EXPECT_EQ(0, journal.getUnsyncedCount());
+
+    journal.appendDelete(IOAddress("192.0.2.4"));
+    EXPECT_EQ(1, journal.getUnsyncedCount());
+    ASSERT_NO_THROW(journal.sync());
+    EXPECT_EQ(0, journal.getUnsyncedCount());
+
+    // Records are flushed to the file even if they're not synchronized.
+    journal.appendDelete(IOAddress("192.0.2.5"));
+    EXPECT_EQ("delete4,192.0.2.1,4d9d5af1\n"
+              "delete4,192.0.2.2,4a9d5638\n"
+              "delete4,192.0.2.3,4b9d57cb\n"
+              "delete4,192.0.2.4,509d5faa\n"
+              "delete4,192.0.2.5,519d613d\n", readFile());
+}
+
+// Checks that the invalid records are skipped and that a partially written
+// last record doesn't corrupt the records appended after it.
+TEST_F(LeaseJournalTest, invalidRecords) {
+    appendFile("delete4,192.0.2.1,4d9d5af1\n"
+               "unknown,192.0.2.2,ef0704c7\n"
+               "delete4,2001:db8:1::1,29d1690d\n"
+               "lease4,192.0.2.3,0800,,3600,foo,2700,0,1,0,0,,c3921fbf\n"
+               "delete4,192.0.2.2\n"
+               "delete4,192.0.2.3,4d9d5af1\n"
+               "lease4,192.0.2.4,0800,0102");
+
+    LeaseJournal journal(filename_);
+    ASSERT_NO_THROW(journal.open());
+    journal.appendDelete(IOAddress("192.0.2.5"));
+    journal.close();
+
+    journal.startReplay();
+    LeaseJournal::Record record;
+    ASSERT_TRUE(journal.readRecord(record));
+    EXPECT_EQ("192.0.2.1", record.addr_.toText());
+    ASSERT_TRUE(journal.readRecord(record));
+    EXPECT_EQ("192.0.2.5", record.addr_.toText());
+    EXPECT_FALSE(journal.readRecord(record));
+
+    EXPECT_EQ(2, journal.getRecordCount());
+    EXPECT_EQ(5, journal.getInvalidCount());
+}
+
+// Checks that a record cut inside the hostname, its last field, is rejected
+// and removed from the journal when it is reopened.
+TEST_F(LeaseJournalTest, truncatedHostname) {
+    Lease4Ptr lease4 = createLease4("192.0.2.3");
+    {
+        LeaseJournal journal(filename_);
+        ASSERT_NO_THROW(journal.open());
+        journal.appendDelete(IOAddress("192.0.2.1"));
+        journal.append(*lease4);
+    }
+
+    // Simulate the crash while the lease record was being written.
+    std::string contents = readFile();
+    const size_t cut = contents.find("odd");
+    ASSERT_NE(std::string::npos, cut);
+    contents.resize(cut);
+    ASSERT_EQ(0, remove(filename_.c_str()));
+    appendFile(contents);
+
+    LeaseJournal journal(filename_);
+    journal.startReplay();
+    LeaseJournal::Record record;
+    ASSERT_TRUE(journal.readRecord(record));
+    EXPECT_EQ(LeaseJournal::RECORD_DELETE4, record.type_);
+    EXPECT_FALSE(journal.readRecord(record));
+    EXPECT_EQ(1, journal.getRecordCount());
+    EXPECT_EQ(1, journal.getInvalidCount());
+
+    // The partial record is removed, so as the records appended next are
+    // read back.
+    ASSERT_NO_THROW(journal.open());
+    EXPECT_EQ(1, journal.getRecordCount());
+    EXPECT_EQ("delete4,192.0.2.1,4d9d5af1\n", readFile());
+    journal.append(*lease4);
+    EXPECT_EQ(2, journal.getRecordCount());
+    journal.close();
+
+    journal.startReplay();
+    ASSERT_TRUE(journal.readRecord(record));
+    ASSERT_TRUE(journal.readRecord(record));
+    ASSERT_TRUE(record.lease4_);
+    detailCompareLease(lease4, record.lease4_);
+    EXPECT_FALSE(journal.readRecord(record));
+    EXPECT_EQ(0, journal.getInvalidCount());
+}
+
+// Checks that the journal file can be replaced with another file.
+TEST_F(LeaseJournalTest, replace) {
+    LeaseJournal journal(filename_);
+    ASSERT_NO_THROW(journal.open());
+    journal.appendDelete(IOAddress("192.0.2.1"));
+    journal.appendDelete(IOAddress("192.0.2.2"));
+
+    LeaseJournal other(filename_ + ".other");
+    ASSERT_NO_THROW(other.open(true));
+    other.appendDelete(IOAddress("192.0.2.3"));
+
+    ASSERT_NO_THROW(journal.replace(other));
+    EXPECT_TRUE(journal.isOpen());
+    EXPECT_FALSE(other.isOpen());
+    EXPECT_EQ(1, journal.getRecordCount());
+
+    journal.appendDelete(IOAddress("192.0.2.4"));
+    EXPECT_EQ("delete4,192.0.2.3,4b9d57cb\n"
+              "delete4,192.0.2.4,509d5faa\n", readFile());
+}
+
+// Checks that the records appended to the journal after the given offset
+// can be copied to another journal.
+TEST_F(LeaseJournalTest, appendTail) {
+    LeaseJournal journal(filename_);
+    ASSERT_NO_THROW(journal.open());
+    EXPECT_EQ(0, journal.getSize());
+    journal.appendDelete(IOAddress("192.0.2.1"));
+    const uint64_t offset = journal.getSize();
+    EXPECT_EQ(27, offset);
+    journal.appendDelete(IOAddress("192.0.2.2"));
+    journal.appendDelete(IOAddress("192.0.2.3"));
+
+    const std::string other_filename = filename_ + ".other";
+    {
+        LeaseJournal other(other_filename);
+        ASSERT_NO_THROW(other.open(true));
+        other.appendDelete(IOAddress("192.0.2.4"));
+        ASSERT_NO_THROW(other.appendTail(filename_, offset));
+        EXPECT_EQ(3, other.getRecordCount());
+        ASSERT_NO_THROW(journal.replace(other));
+    }
+    EXPECT_EQ(3, journal.getRecordCount());
+    EXPECT_EQ("delete4,192.0.2.4,509d5faa\n"
+              "delete4,192.0.2.2,4a9d5638\n"
+              "delete4,192.0.2.3,4b9d57cb\n", readFile());
+
+    // The journal must exist.
+    LeaseJournal other(other_filename);
+    EXPECT_THROW(other.appendTail(other_filename, 0), DbOperationError);
+}
+
+// Checks that the journal can't be written before it is opened.
+TEST_F(LeaseJournalTest, notOpen) {
+    LeaseJournal journal(filename_);
+    EXPECT_FALSE(journal.isOpen());
+    EXPECT_THROW(journal.appendDelete(IOAddress("192.0.2.1")),
+                 DbOperationError);
+}
+
+}; // end of anonymous namespace
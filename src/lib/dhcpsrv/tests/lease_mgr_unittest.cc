@@ -173,6 +173,42 @@ public:
         return (leases6_);
     }
 
+    /// @brief Returns expired IPv4 leases.
+    ///
+    /// @param expired_leases not modified
+    /// @param max_leases ignored
+    virtual void getExpiredLeases4(Lease4Collection&, const size_t) const {
+    }
+
+    /// @brief Returns expired IPv6 leases.
+    ///
+    /// @param expired_leases not modified
+    /// @param max_leases ignored
+    virtual void getExpiredLeases6(Lease6Collection&, const size_t) const {
+    }
+
+    /// @brief Returns IPv4 leases for the address range.
+    ///
+    /// @param lower ignored
+    /// @param upper ignored
+    ///
+    /// @return empty collection
+    virtual Lease4Collection getLeases4(const IOAddress&,
+                                        const IOAddress&) const {
+        return (Lease4Collection());
+    }
+
+    /// @brief Returns IPv6 leases for the address range.
+    ///
+    /// @param lower ignored
+    /// @param upper ignored
+    ///
+    /// @return whatever is set in leases6_ field
+    virtual Lease6Collection getLeases6(Lease::Type, const IOAddress&,
+                                        const IOAddress&) const {
+        return (leases6_);
+    }
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
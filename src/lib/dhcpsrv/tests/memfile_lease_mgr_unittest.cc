@@ -25,6 +25,10 @@
 #include <iostream>
 #include <sstream>
 
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace std;
 using namespace isc;
 using namespace isc::asiolink;
@@ -228,6 +232,391 @@ TEST_F(MemfileLeaseMgrTest, DISABLED_updateLease6) {
     testUpdateLease6();
 }
 
+// Checks that the updated lease is re-indexed, i.e. it can be found using
+// its new hardware address and client identifier but not the old ones.
+TEST_F(MemfileLeaseMgrTest, updateLease4Reindex) {
+    Lease4Ptr lease = initializeLease4(straddress4_[1]);
+    ASSERT_TRUE(lmptr_->addLease(lease));
+
+    const HWAddr old_hwaddr(lease->hwaddr_, HTYPE_ETHER);
+    const ClientId old_client_id(*lease->client_id_);
+    lease->hwaddr_ = vector<uint8_t>(6, 0x5a);
+    lease->client_id_.reset(new ClientId(vector<uint8_t>(8, 0x5b)));
+    ASSERT_NO_THROW(lmptr_->updateLease4(lease));
+
+    const HWAddr new_hwaddr(lease->hwaddr_, HTYPE_ETHER);
+    Lease4Ptr l_returned = lmptr_->getLease4(new_hwaddr, lease->subnet_id_);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(lease, l_returned);
+    l_returned = lmptr_->getLease4(*lease->client_id_, lease->subnet_id_);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(lease, l_returned);
+    l_returned = lmptr_->getLease4(*lease->client_id_, new_hwaddr,
+                                   lease->subnet_id_);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(lease, l_returned);
+
+    EXPECT_FALSE(lmptr_->getLease4(old_hwaddr, lease->subnet_id_));
+    EXPECT_FALSE(lmptr_->getLease4(old_client_id, lease->subnet_id_));
+}
+
+// Checks that the lease is not updated if the new value conflicts with
+// another lease in the same subnet.
+TEST_F(MemfileLeaseMgrTest, updateLease4Conflict) {
+    Lease4Ptr lease1 = initializeLease4(straddress4_[1]);
+    Lease4Ptr lease2 = initializeLease4(straddress4_[2]);
+    lease2->subnet_id_ = lease1->subnet_id_;
+    lease2->hwaddr_ = vector<uint8_t>(6, 0x5a);
+    lease2->client_id_.reset(new ClientId(vector<uint8_t>(8, 0x5b)));
+    ASSERT_TRUE(lmptr_->addLease(lease1));
+    ASSERT_TRUE(lmptr_->addLease(lease2));
+
+    Lease4Ptr updated(new Lease4(*lease2));
+    updated->hwaddr_ = lease1->hwaddr_;
+    EXPECT_THROW(lmptr_->updateLease4(updated), DbOperationError);
+
+    // Both leases are still there, unchanged.
+    Lease4Ptr l_returned = lmptr_->getLease4(ioaddress4_[2]);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(lease2, l_returned);
+    l_returned = lmptr_->getLease4(HWAddr(lease1->hwaddr_, HTYPE_ETHER),
+                                   lease1->subnet_id_);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(lease1, l_returned);
+}
+
+// Checks that the updated IPv6 lease can be found using its new DUID.
+TEST_F(MemfileLeaseMgrTest, updateLease6Reindex) {
+    Lease6Ptr lease = initializeLease6(straddress6_[1]);
+    ASSERT_TRUE(lmptr_->addLease(lease));
+
+    const DUID old_duid(*lease->duid_);
+    lease->duid_.reset(new DUID(vector<uint8_t>(10, 0x5c)));
+    ASSERT_NO_THROW(lmptr_->updateLease6(lease));
+
+    Lease6Collection returned =
+        lmptr_->getLeases6(lease->type_, *lease->duid_, lease->iaid_,
+                           lease->subnet_id_);
+    ASSERT_EQ(1, returned.size());
+    detailCompareLease(lease, returned[0]);
+
+    EXPECT_TRUE(lmptr_->getLeases6(lease->type_, old_duid, lease->iaid_,
+                                   lease->subnet_id_).empty());
+}
+
+// Checks that the expired leases are returned in the order of their
+// expiration time and that the number of returned leases is limited.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases4) {
+    const time_t now = time(NULL);
+    for (int i = 0; i < 4; ++i) {
+        Lease4Ptr lease = initializeLease4(straddress4_[i]);
+        lease->valid_lft_ = 100;
+        // The last lease is valid, the others expired in reverse order.
+        lease->cltt_ = (i == 3) ? now : now - 200 - i;
+        ASSERT_TRUE(lmptr_->addLease(lease));
+    }
+
+    Lease4Collection expired;
+    lmptr_->getExpiredLeases4(expired, 0);
+    ASSERT_EQ(3, expired.size());
+    EXPECT_EQ(straddress4_[2], expired[0]->addr_.toText());
+    EXPECT_EQ(straddress4_[1], expired[1]->addr_.toText());
+    EXPECT_EQ(straddress4_[0], expired[2]->addr_.toText());
+
+    expired.clear();
+    lmptr_->getExpiredLeases4(expired, 2);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(straddress4_[2], expired[0]->addr_.toText());
+
+    // The renewed lease is no longer expired.
+    Lease4Ptr renewed = lmptr_->getLease4(ioaddress4_[2]);
+    ASSERT_TRUE(renewed);
+    renewed->cltt_ = now;
+    ASSERT_NO_THROW(lmptr_->updateLease4(renewed));
+    expired.clear();
+    lmptr_->getExpiredLeases4(expired, 0);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(straddress4_[1], expired[0]->addr_.toText());
+}
+
+// Checks that the expired IPv6 leases are returned in the order of their
+// expiration time.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases6) {
+    const time_t now = time(NULL);
+    for (int i = 0; i < 3; ++i) {
+        Lease6Ptr lease = initializeLease6(straddress6_[i]);
+        lease->valid_lft_ = 100;
+        lease->cltt_ = (i == 0) ? now : now - 200 + i;
+        ASSERT_TRUE(lmptr_->addLease(lease));
+    }
+
+    Lease6Collection expired;
+    lmptr_->getExpiredLeases6(expired, 0);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(straddress6_[1], expired[0]->addr_.toText());
+    EXPECT_EQ(straddress6_[2], expired[1]->addr_.toText());
+}
+
+// Checks that the leases for the addresses within the range are returned.
+TEST_F(MemfileLeaseMgrTest, getLeases4Range) {
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(lmptr_->addLease(initializeLease4(straddress4_[i])));
+    }
+
+    Lease4Collection leases = lmptr_->getLeases4(ioaddress4_[2],
+                                                 ioaddress4_[5]);
+    ASSERT_EQ(4, leases.size());
+    EXPECT_EQ(straddress4_[2], leases[0]->addr_.toText());
+    EXPECT_EQ(straddress4_[5], leases[3]->addr_.toText());
+
+    // The bounds don't have to be the addresses of the leases.
+    EXPECT_EQ(8, lmptr_->getLeases4(IOAddress("192.0.1.0"),
+                                    IOAddress("192.0.3.0")).size());
+    EXPECT_TRUE(lmptr_->getLeases4(IOAddress("192.0.2.8"),
+                                   IOAddress("192.0.2.255")).empty());
+}
+
+// Checks that the IPv6 leases of the type within the range are returned.
+TEST_F(MemfileLeaseMgrTest, getLeases6Range) {
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(lmptr_->addLease(initializeLease6(straddress6_[i])));
+    }
+
+    // The leases 0, 3 and 6 are NA leases.
+    Lease6Collection leases = lmptr_->getLeases6(Lease::TYPE_NA,
+                                                 ioaddress6_[0],
+                                                 ioaddress6_[5]);
+    ASSERT_EQ(2, leases.size());
+    EXPECT_EQ(ioaddress6_[0], leases[0]->addr_);
+    EXPECT_EQ(ioaddress6_[3], leases[1]->addr_);
+
+    leases = lmptr_->getLeases6(Lease::TYPE_PD, ioaddress6_[0],
+                                ioaddress6_[7]);
+    ASSERT_EQ(2, leases.size());
+    EXPECT_EQ(ioaddress6_[2], leases[0]->addr_);
+    EXPECT_EQ(ioaddress6_[5], leases[1]->addr_);
+}
+
+// Checks that the default implementation of the batch executes all writes
+// and reports their results, including the failed ones.
+TEST_F(MemfileLeaseMgrTest, writeLeases) {
+    std::vector<Lease4Ptr> leases = createLeases4();
+    LeaseWriteCollection writes;
+    writes.push_back(LeaseWrite(LeaseWrite::ADD, leases[1]));
+    writes.push_back(LeaseWrite(LeaseWrite::ADD, leases[1]));
+    writes.push_back(LeaseWrite(LeaseWrite::UPDATE, leases[2]));
+    writes.push_back(LeaseWrite(LeaseWrite::ADD, leases[2]));
+    writes.push_back(LeaseWrite(ioaddress4_[1]));
+    lmptr_->writeLeases(writes);
+
+    EXPECT_TRUE(writes[0].result_);
+    EXPECT_TRUE(writes[0].error_.empty());
+    // Duplicate lease is not an error.
+    EXPECT_FALSE(writes[1].result_);
+    EXPECT_TRUE(writes[1].error_.empty());
+    // The lease to be updated doesn't exist.
+    EXPECT_FALSE(writes[2].result_);
+    EXPECT_FALSE(writes[2].error_.empty());
+    EXPECT_TRUE(writes[3].result_);
+    EXPECT_TRUE(writes[4].result_);
+
+    EXPECT_FALSE(lmptr_->getLease4(ioaddress4_[1]));
+    EXPECT_TRUE(lmptr_->getLease4(ioaddress4_[2]));
+}
+
+/// @brief Test fixture for the memfile backend which persists the leases
+/// in the lease journal.
+class PersistentMemfileLeaseMgrTest : public GenericLeaseMgrTest {
+public:
+
+    /// @brief Constructor
+    ///
+    /// Removes the journal left over by previous tests and opens the
+    /// lease manager.
+    PersistentMemfileLeaseMgrTest()
+        : journal_(std::string(TEST_DATA_BUILDDIR) + "/leases.journal") {
+        static_cast<void>(remove(journal_.c_str()));
+        lmptr_ = new Memfile_LeaseMgr(getParameters());
+    }
+
+    /// @brief Destructor
+    ///
+    /// Destroys the lease manager and removes the journal.
+    virtual ~PersistentMemfileLeaseMgrTest() {
+        delete lmptr_;
+        lmptr_ = 0;
+        static_cast<void>(remove(journal_.c_str()));
+    }
+
+    /// @brief Returns parameters of the lease manager.
+    ///
+    /// @param compact_threshold Value of the compact-threshold parameter.
+    LeaseMgr::ParameterMap getParameters(const std::string&
+                                         compact_threshold = "0") const {
+        LeaseMgr::ParameterMap pmap;
+        pmap["type"] = "memfile";
+        pmap["name"] = journal_;
+        pmap["compact-threshold"] = compact_threshold;
+        return (pmap);
+    }
+
+    /// @brief Reopens the lease manager, i.e. reloads the leases from
+    /// the lease journal.
+    virtual void reopen() {
+        delete lmptr_;
+        lmptr_ = 0;
+        lmptr_ = new Memfile_LeaseMgr(getParameters());
+    }
+
+    /// @brief Name of the lease journal.
+    std::string journal_;
+};
+
+// Checks that the name of the journal is returned as the backend name.
+TEST_F(PersistentMemfileLeaseMgrTest, getName) {
+    EXPECT_EQ(journal_, lmptr_->getName());
+}
+
+// Checks that the invalid journal parameters are rejected.
+TEST_F(PersistentMemfileLeaseMgrTest, invalidParameters) {
+    LeaseMgr::ParameterMap pmap = getParameters("many");
+    EXPECT_THROW(Memfile_LeaseMgr lease_mgr(pmap), isc::BadValue);
+
+    pmap = getParameters();
+    pmap["name"] = "/no/such/directory/leases.journal";
+    EXPECT_THROW(Memfile_LeaseMgr lease_mgr(pmap), DbOpenError);
+}
+
+// Checks that the IPv4 leases are restored from the journal.
+TEST_F(PersistentMemfileLeaseMgrTest, basicLease4) {
+    testBasicLease4();
+}
+
+// Checks that the IPv6 leases are restored from the journal.
+TEST_F(PersistentMemfileLeaseMgrTest, basicLease6) {
+    testBasicLease6();
+}
+
+// Checks that the leases with no client identifier are restored from
+// the journal.
+TEST_F(PersistentMemfileLeaseMgrTest, DISABLED_lease4NullClientId) {
+
+    /// @todo Test is disabled, because the memfile index by client id and
+    /// subnet id is unique, so only one lease with no client id can be
+    /// stored for the subnet.
+    testLease4NullClientId();
+}
+
+// Checks that the lease updates are restored from the journal.
+TEST_F(PersistentMemfileLeaseMgrTest, updateLease4) {
+    vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+
+    leases[1]->valid_lft_ = 12345;
+    leases[1]->hostname_ = "updated.example.org";
+    ASSERT_NO_THROW(lmptr_->updateLease4(leases[1]));
+    reopen();
+
+    Lease4Ptr l_returned = lmptr_->getLease4(ioaddress4_[1]);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(leases[1], l_returned);
+
+    // The lookups through the other indexes must find the lease too.
+    l_returned = lmptr_->getLease4(*leases[1]->client_id_,
+                                   leases[1]->subnet_id_);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(leases[1], l_returned);
+}
+
+// Checks that the journal is compacted once it holds enough superseded
+// records and that the compacted journal holds all leases.
+TEST_F(PersistentMemfileLeaseMgrTest, compact) {
+    delete lmptr_;
+    lmptr_ = 0;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr;
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(getParameters("4"))));
+
+    vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lease_mgr->addLease(leases[1]));
+    ASSERT_TRUE(lease_mgr->addLease(leases[2]));
+    EXPECT_EQ(2, lease_mgr->getJournalRecordCount());
+
+    // Three updates don't exceed the threshold.
+    for (int i = 0; i < 3; ++i) {
+        leases[1]->cltt_ += 10;
+        lease_mgr->updateLease4(leases[1]);
+    }
+    EXPECT_EQ(5, lease_mgr->getJournalRecordCount());
+
+    // The fourth update reaches the threshold.
+    leases[1]->cltt_ += 10;
+    lease_mgr->updateLease4(leases[1]);
+    lease_mgr->waitForCompaction();
+    EXPECT_EQ(2, lease_mgr->getJournalRecordCount());
+
+    // The explicit compaction can be requested at any time.
+    EXPECT_TRUE(lease_mgr->deleteLease(ioaddress4_[2]));
+    EXPECT_EQ(3, lease_mgr->getJournalRecordCount());
+    ASSERT_NO_THROW(lease_mgr->compact());
+    EXPECT_EQ(1, lease_mgr->getJournalRecordCount());
+
+    // Reopen and make sure that the compacted journal holds the leases.
+    lease_mgr.reset();
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(getParameters("4"))));
+    EXPECT_EQ(1, lease_mgr->getJournalRecordCount());
+
+    Lease4Ptr l_returned = lease_mgr->getLease4(ioaddress4_[1]);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(leases[1], l_returned);
+    EXPECT_FALSE(lease_mgr->getLease4(ioaddress4_[2]));
+}
+
+// Checks that a failure of the compaction doesn't fail the lease change
+// which triggered it and that the compaction is retried later.
+TEST_F(PersistentMemfileLeaseMgrTest, compactFailure) {
+    delete lmptr_;
+    lmptr_ = 0;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr;
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(getParameters("4"))));
+
+    vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lease_mgr->addLease(leases[1]));
+    ASSERT_TRUE(lease_mgr->addLease(leases[2]));
+
+    // The temporary file of the compaction can't be created if there is
+    // a directory in its place.
+    const std::string tmp_journal = journal_ + ".compact";
+    ASSERT_EQ(0, mkdir(tmp_journal.c_str(), S_IRWXU));
+
+    // The fourth update reaches the threshold, but the compaction fails.
+    for (int i = 0; i < 4; ++i) {
+        leases[1]->cltt_ += 10;
+        EXPECT_NO_THROW(lease_mgr->updateLease4(leases[1]));
+    }
+    lease_mgr->waitForCompaction();
+    EXPECT_EQ(6, lease_mgr->getJournalRecordCount());
+    ASSERT_EQ(0, rmdir(tmp_journal.c_str()));
+
+    // The compaction isn't retried until other 4 records were appended.
+    for (int i = 0; i < 3; ++i) {
+        leases[1]->cltt_ += 10;
+        EXPECT_NO_THROW(lease_mgr->updateLease4(leases[1]));
+    }
+    lease_mgr->waitForCompaction();
+    EXPECT_EQ(9, lease_mgr->getJournalRecordCount());
+    leases[1]->cltt_ += 10;
+    EXPECT_NO_THROW(lease_mgr->updateLease4(leases[1]));
+    lease_mgr->waitForCompaction();
+    EXPECT_EQ(2, lease_mgr->getJournalRecordCount());
+
+    // All the changes have been recorded.
+    lease_mgr.reset();
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(getParameters("4"))));
+    Lease4Ptr l_returned = lease_mgr->getLease4(ioaddress4_[1]);
+    ASSERT_TRUE(l_returned);
+    detailCompareLease(leases[1], l_returned);
+}
+
 // The following tests are not applicable for memfile. When adding
 // new tests to the list here, make sure to provide brief explanation
 // why they are not applicable:
@@ -254,6 +254,23 @@ TEST(MySqlOpenTest, OpenDatabase) {
     destroySchema();
 }
 
+/// @brief Check that the database with an old schema version is rejected
+TEST(MySqlOpenTest, OldSchemaVersion) {
+    destroySchema();
+    createSchema();
+
+    {
+        MySqlHolder mysql;
+        (void) mysql_real_connect(mysql, "localhost", "keatest",
+                                  "keatest", "keatest", 0, NULL, 0);
+        ASSERT_EQ(0, mysql_query(mysql, "UPDATE schema_version SET minor = 0"));
+    }
+    EXPECT_THROW(LeaseMgrFactory::create(validConnectionString()),
+                 DbOpenError);
+
+    destroySchema();
+}
+
 /// @brief Check the getType() method
 ///
 /// getType() returns a string giving the type of the backend, which should
@@ -0,0 +1,211 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/pkt4.h>
+#include <dhcpsrv/packet_pipeline.h>
+#include <util/threads/sync.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace isc;
+using namespace isc::dhcp;
+using namespace isc::util::thread;
+
+namespace {
+
+/// @brief Test fixture class for the @c PacketPipeline.
+///
+/// The fixture implements the processing and send functions which record
+/// the packets passed through the pipeline.
+class PacketPipelineTest : public ::testing::Test {
+public:
+
+    /// @brief Processes the query.
+    ///
+    /// Queries with odd transaction ids are answered, the others are
+    /// dropped. The query with transaction id 13 causes an exception and
+    /// the query with transaction id 17 an exception of an unknown type.
+    Pkt4Ptr process(const Pkt4Ptr& query) {
+        if (query->getTransid() == 13) {
+            isc_throw(isc::Unexpected, "unlucky query");
+        }
+        if (query->getTransid() == 17) {
+            throw (query->getTransid());
+        }
+        Mutex::Locker locker(mutex_);
+        processed_.insert(query->getTransid());
+        order_[getKey(query)].push_back(query->getTransid());
+        if (query->getTransid() % 2 == 0) {
+            return (Pkt4Ptr());
+        }
+        return (Pkt4Ptr(new Pkt4(DHCPOFFER, query->getTransid())));
+    }
+
+    /// @brief Records the transaction ids of the responses.
+    void send(const std::vector<Pkt4Ptr>& rsps) {
+        // There is only one sender thread, so no locking is needed.
+        for (std::vector<Pkt4Ptr>::const_iterator rsp = rsps.begin();
+             rsp != rsps.end(); ++rsp) {
+            sent_.insert((*rsp)->getTransid());
+        }
+    }
+
+    /// @brief Returns the key of the query.
+    ///
+    /// The queries are divided into 5 groups by transaction id.
+    static size_t getKey(const Pkt4Ptr& query) {
+        return (query->getTransid() % 5);
+    }
+
+    /// @brief Creates the pipeline using the fixture's callbacks.
+    ///
+    /// @param workers Number of workers.
+    /// @param queue_size Size of the queues.
+    /// @param use_key Indicates whether the queries should be distributed
+    /// to the workers by key.
+    PacketPipeline<Pkt4Ptr>* createPipeline(const size_t workers,
+                                            const size_t queue_size,
+                                            const bool use_key = false) {
+        PacketPipeline<Pkt4Ptr>::KeyCallback key;
+        if (use_key) {
+            key = &PacketPipelineTest::getKey;
+        }
+        return (new PacketPipeline<Pkt4Ptr>(workers, queue_size,
+            boost::bind(&PacketPipelineTest::process, this, _1),
+            boost::bind(&PacketPipelineTest::send, this, _1), key));
+    }
+
+    /// @brief Protects the processed_ set.
+    Mutex mutex_;
+
+    /// @brief Transaction ids of the processed queries.
+    std::set<uint32_t> processed_;
+
+    /// @brief Transaction ids of the processed queries, in the order of
+    /// processing, by query key.
+    std::map<size_t, std::vector<uint32_t> > order_;
+
+    /// @brief Transaction ids of the sent responses.
+    std::set<uint32_t> sent_;
+};
+
+// Checks that the pipeline can't be created without workers or queue.
+TEST_F(PacketPipelineTest, invalidParameters) {
+    EXPECT_THROW(delete createPipeline(0, 10), isc::BadValue);
+    EXPECT_THROW(delete createPipeline(2, 0), isc::InvalidParameter);
+}
+
+// Checks that all queries are processed and the responses are sent.
+TEST_F(PacketPipelineTest, process) {
+    boost::scoped_ptr<PacketPipeline<Pkt4Ptr> > pipeline(createPipeline(4, 8));
+    EXPECT_EQ(4, pipeline->getWorkersNum());
+
+    size_t pushed = 0;
+    for (uint32_t transid = 1; transid <= 100; ++transid) {
+        Pkt4Ptr query(new Pkt4(DHCPDISCOVER, transid));
+        // The queue is small so wait for the workers when it is full.
+        while (!pipeline->push(query)) {
+            pipeline->wait();
+        }
+        ++pushed;
+    }
+    pipeline->wait();
+    EXPECT_EQ(100, pushed);
+
+    // All queries but the ones that caused the exceptions were processed.
+    // The workers kept running after the exceptions, otherwise waiting for
+    // the queued queries wouldn't have returned.
+    EXPECT_EQ(98, processed_.size());
+    EXPECT_EQ(0, processed_.count(13));
+    EXPECT_EQ(0, processed_.count(17));
+
+    // The responses to the queries with odd transaction ids were sent.
+    ASSERT_EQ(48, sent_.size());
+    for (uint32_t transid = 1; transid <= 100; transid += 2) {
+        EXPECT_EQ((transid != 13) && (transid != 17) ? 1 : 0,
+                  sent_.count(transid));
+    }
+}
+
+// Checks that the queued queries are processed when the pipeline stops
+// and that no more queries are accepted afterwards.
+TEST_F(PacketPipelineTest, stop) {
+    boost::scoped_ptr<PacketPipeline<Pkt4Ptr> > pipeline(createPipeline(2,
+                                                                        100));
+    for (uint32_t transid = 1; transid <= 10; ++transid) {
+        ASSERT_TRUE(pipeline->push(Pkt4Ptr(new Pkt4(DHCPDISCOVER, transid))));
+    }
+    pipeline->stop();
+    EXPECT_EQ(0, pipeline->getWorkersNum());
+    EXPECT_EQ(10, processed_.size());
+    EXPECT_EQ(5, sent_.size());
+
+    EXPECT_FALSE(pipeline->push(Pkt4Ptr(new Pkt4(DHCPDISCOVER, 11))));
+}
+
+// Checks that the responses which are not returned by the processing
+// function are sent and that they are rejected once the pipeline stops.
+TEST_F(PacketPipelineTest, send) {
+    boost::scoped_ptr<PacketPipeline<Pkt4Ptr> > pipeline(createPipeline(1,
+                                                                        2));
+    for (uint32_t transid = 1; transid <= 10; ++transid) {
+        EXPECT_TRUE(pipeline->send(Pkt4Ptr(new Pkt4(DHCPACK, transid))));
+    }
+    pipeline->wait();
+    EXPECT_TRUE(processed_.empty());
+    EXPECT_EQ(10, sent_.size());
+
+    pipeline->stop();
+    EXPECT_FALSE(pipeline->send(Pkt4Ptr(new Pkt4(DHCPACK, 11))));
+    EXPECT_EQ(10, sent_.size());
+}
+
+// Checks that the queries with the same key are processed in order.
+TEST_F(PacketPipelineTest, key) {
+    boost::scoped_ptr<PacketPipeline<Pkt4Ptr> > pipeline(createPipeline(3, 8,
+                                                                        true));
+    EXPECT_EQ(3, pipeline->getWorkersNum());
+
+    for (uint32_t transid = 1; transid <= 100; ++transid) {
+        Pkt4Ptr query(new Pkt4(DHCPDISCOVER, transid));
+        while (!pipeline->push(query)) {
+            pipeline->wait();
+        }
+    }
+    pipeline->wait();
+
+    EXPECT_EQ(98, processed_.size());
+    EXPECT_EQ(48, sent_.size());
+
+    // Each group of queries must have been processed in the order in which
+    // the queries were pushed.
+    ASSERT_EQ(5, order_.size());
+    for (std::map<size_t, std::vector<uint32_t> >::const_iterator group =
+             order_.begin(); group != order_.end(); ++group) {
+        for (size_t i = 1; i < group->second.size(); ++i) {
+            EXPECT_LT(group->second[i - 1], group->second[i]);
+        }
+    }
+}
+
+}; // end of anonymous namespace
@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include <iostream>
+#include <limits>
 #include <vector>
 #include <sstream>
 
@@ -110,6 +111,92 @@ TEST(Poo4Test,toText) {
     EXPECT_EQ("type=V4, 192.0.2.128-192.0.2.143", pool2.toText());
 }
 
+// Checks that the addresses are mapped to the positions in the pool.
+TEST(Pool4Test, positions) {
+    Pool4 pool(IOAddress("192.0.2.250"), IOAddress("192.0.3.4"));
+    EXPECT_EQ(11, pool.getCapacity());
+
+    EXPECT_EQ("192.0.2.250", pool.getAddress(0).toText());
+    EXPECT_EQ("192.0.3.0", pool.getAddress(6).toText());
+    EXPECT_EQ("192.0.3.4", pool.getAddress(10).toText());
+    EXPECT_THROW(pool.getAddress(11), BadValue);
+
+    EXPECT_EQ(0, pool.getPosition(IOAddress("192.0.2.250")));
+    EXPECT_EQ(6, pool.getPosition(IOAddress("192.0.3.0")));
+    EXPECT_EQ(10, pool.getPosition(IOAddress("192.0.3.4")));
+    EXPECT_THROW(pool.getPosition(IOAddress("192.0.3.5")), BadValue);
+
+    Pool4 whole(IOAddress("0.0.0.0"), IOAddress("255.255.255.255"));
+    EXPECT_EQ(4294967296ULL, whole.getCapacity());
+}
+
+// Checks that the used addresses in the pool are tracked.
+TEST(Pool4Test, usage) {
+    Pool4 pool(IOAddress("192.0.2.0"), 25);
+    ASSERT_EQ(128, pool.getCapacity());
+
+    // The usage is not tracked by default.
+    EXPECT_FALSE(pool.isUsageTracked());
+    EXPECT_NO_THROW(pool.markUsed(IOAddress("192.0.2.1")));
+    EXPECT_EQ(0, pool.getUsedCount());
+    IOAddress free_addr("0.0.0.0");
+    EXPECT_FALSE(pool.findFreeAddress(IOAddress("192.0.2.1"), free_addr));
+
+    ASSERT_NO_THROW(pool.initUsage());
+    EXPECT_TRUE(pool.isUsageTracked());
+    EXPECT_EQ(0, pool.getUsedCount());
+
+    // Mark all addresses but two as used.
+    for (uint64_t position = 0; position < pool.getCapacity(); ++position) {
+        if ((position != 5) && (position != 100)) {
+            pool.markUsed(pool.getAddress(position));
+        }
+    }
+    // Marking the address twice doesn't change the counter.
+    pool.markUsed(IOAddress("192.0.2.0"));
+    EXPECT_EQ(126, pool.getUsedCount());
+    EXPECT_TRUE(pool.isUsed(IOAddress("192.0.2.0")));
+    EXPECT_FALSE(pool.isUsed(IOAddress("192.0.2.5")));
+    EXPECT_THROW(pool.markUsed(IOAddress("192.0.2.128")), BadValue);
+
+    // The free address is found from the start address onwards.
+    ASSERT_TRUE(pool.findFreeAddress(IOAddress("192.0.2.0"), free_addr));
+    EXPECT_EQ("192.0.2.5", free_addr.toText());
+    ASSERT_TRUE(pool.findFreeAddress(IOAddress("192.0.2.5"), free_addr));
+    EXPECT_EQ("192.0.2.5", free_addr.toText());
+    ASSERT_TRUE(pool.findFreeAddress(IOAddress("192.0.2.6"), free_addr));
+    EXPECT_EQ("192.0.2.100", free_addr.toText());
+    // The search wraps around.
+    ASSERT_TRUE(pool.findFreeAddress(IOAddress("192.0.2.101"), free_addr));
+    EXPECT_EQ("192.0.2.5", free_addr.toText());
+
+    pool.markUsed(IOAddress("192.0.2.5"));
+    pool.markUsed(IOAddress("192.0.2.100"));
+    EXPECT_EQ(128, pool.getUsedCount());
+    EXPECT_FALSE(pool.findFreeAddress(IOAddress("192.0.2.0"), free_addr));
+
+    pool.markFree(IOAddress("192.0.2.127"));
+    EXPECT_EQ(127, pool.getUsedCount());
+    ASSERT_TRUE(pool.findFreeAddress(IOAddress("192.0.2.64"), free_addr));
+    EXPECT_EQ("192.0.2.127", free_addr.toText());
+
+    // The usage is shared by the copies of the pool.
+    Pool4 copy(pool);
+    copy.markFree(IOAddress("192.0.2.0"));
+    EXPECT_EQ(126, pool.getUsedCount());
+
+    // Starting over discards the collected usage.
+    pool.initUsage();
+    EXPECT_EQ(0, pool.getUsedCount());
+}
+
+// Checks that the usage of too large pools can't be tracked.
+TEST(Pool4Test, usageTooLarge) {
+    Pool4 pool(IOAddress("10.0.0.0"), 8);
+    EXPECT_THROW(pool.initUsage(), InvalidOperation);
+    EXPECT_FALSE(pool.isUsageTracked());
+}
+
 TEST(Pool6Test, constructor_first_last) {
 
     // let's construct 2001:db8:1:: - 2001:db8:1::ffff:ffff:ffff:ffff pool
@@ -263,4 +350,38 @@ TEST(Poo6Test,toText) {
               pool2.toText());
 }
 
+// Checks that the delegated prefixes are mapped to the positions in the pool.
+TEST(Pool6Test, positionsPD) {
+    Pool6 pool(Lease::TYPE_PD, IOAddress("2001:db8:1::"), 48, 56);
+    EXPECT_EQ(256, pool.getCapacity());
+
+    EXPECT_EQ("2001:db8:1::", pool.getAddress(0).toText());
+    EXPECT_EQ("2001:db8:1:100::", pool.getAddress(1).toText());
+    EXPECT_EQ("2001:db8:1:ff00::", pool.getAddress(255).toText());
+    EXPECT_EQ(255, pool.getPosition(IOAddress("2001:db8:1:ff00::")));
+
+    // The capacity of a huge pool is capped.
+    Pool6 huge(Lease::TYPE_NA, IOAddress("2001:db8::"), 48);
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), huge.getCapacity());
+    EXPECT_THROW(huge.initUsage(), InvalidOperation);
+}
+
+// Checks that the used prefixes in the pool are tracked.
+TEST(Pool6Test, usagePD) {
+    Pool6 pool(Lease::TYPE_PD, IOAddress("2001:db8:1::"), 56, 64);
+    ASSERT_NO_THROW(pool.initUsage());
+
+    pool.markUsed(IOAddress("2001:db8:1::"));
+    pool.markUsed(IOAddress("2001:db8:1:1::"));
+    EXPECT_EQ(2, pool.getUsedCount());
+
+    IOAddress free_addr("::");
+    ASSERT_TRUE(pool.findFreeAddress(IOAddress("2001:db8:1::"), free_addr));
+    EXPECT_EQ("2001:db8:1:2::", free_addr.toText());
+
+    pool.markFree(IOAddress("2001:db8:1::"));
+    EXPECT_EQ(1, pool.getUsedCount());
+    EXPECT_FALSE(pool.isUsed(IOAddress("2001:db8:1::")));
+}
+
 }; // end of anonymous namespace
@@ -0,0 +1,203 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp6.h>
+#include <dhcpsrv/subnet_index.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc;
+using namespace isc::asiolink;
+using namespace isc::dhcp;
+
+namespace {
+
+/// @brief Returns the positions found by the address lookup, sorted.
+///
+/// @param index index to be searched
+/// @param addr address
+SubnetIndex::Positions
+findByAddress(const SubnetIndex& index, const std::string& addr) {
+    SubnetIndex::Positions positions;
+    index.findByAddress(IOAddress(addr), positions);
+    SubnetIndex::sortPositions(positions);
+    return (positions);
+}
+
+// Checks that the index is built and cleared.
+TEST(SubnetIndexTest, build) {
+    SubnetIndex index;
+    EXPECT_FALSE(index.isBuilt());
+
+    Subnet4Collection subnets;
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 24,
+                                             1, 2, 3)));
+    index.build(subnets);
+    EXPECT_TRUE(index.isBuilt());
+    EXPECT_EQ(1, findByAddress(index, "192.0.2.1").size());
+
+    index.clear();
+    EXPECT_FALSE(index.isBuilt());
+    EXPECT_TRUE(findByAddress(index, "192.0.2.1").empty());
+}
+
+// Checks that the subnets are found by the address, including the
+// subnets of different prefix lengths which overlap.
+TEST(SubnetIndexTest, findByAddress4) {
+    Subnet4Collection subnets;
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 26,
+                                             1, 2, 3)));
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.64"), 26,
+                                             1, 2, 3)));
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 24,
+                                             1, 2, 3)));
+    // Prefix which is not aligned to its length.
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("10.1.2.3"), 16,
+                                             1, 2, 3)));
+    SubnetIndex index;
+    index.build(subnets);
+
+    SubnetIndex::Positions positions = findByAddress(index, "192.0.2.1");
+    ASSERT_EQ(2, positions.size());
+    EXPECT_EQ(0, positions[0]);
+    EXPECT_EQ(2, positions[1]);
+
+    positions = findByAddress(index, "192.0.2.127");
+    ASSERT_EQ(2, positions.size());
+    EXPECT_EQ(1, positions[0]);
+    EXPECT_EQ(2, positions[1]);
+
+    positions = findByAddress(index, "192.0.2.128");
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(2, positions[0]);
+
+    positions = findByAddress(index, "10.1.255.255");
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(3, positions[0]);
+
+    EXPECT_TRUE(findByAddress(index, "192.0.3.0").empty());
+    EXPECT_TRUE(findByAddress(index, "2001:db8::1").empty());
+}
+
+// Checks that the IPv6 subnets are found by the address.
+TEST(SubnetIndexTest, findByAddress6) {
+    Subnet6Collection subnets;
+    subnets.push_back(Subnet6Ptr(new Subnet6(IOAddress("2001:db8:1::"), 48,
+                                             1, 2, 3, 4)));
+    subnets.push_back(Subnet6Ptr(new Subnet6(IOAddress("2001:db8:1:1::"), 64,
+                                             1, 2, 3, 4)));
+    SubnetIndex index;
+    index.build(subnets);
+
+    SubnetIndex::Positions positions = findByAddress(index, "2001:db8:1:1::5");
+    ASSERT_EQ(2, positions.size());
+    EXPECT_EQ(0, positions[0]);
+    EXPECT_EQ(1, positions[1]);
+
+    positions = findByAddress(index, "2001:db8:1:2::5");
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(0, positions[0]);
+
+    EXPECT_TRUE(findByAddress(index, "2001:db8:2::1").empty());
+    EXPECT_TRUE(findByAddress(index, "192.0.2.1").empty());
+}
+
+// Checks that the subnets are found by the relay address, interface name
+// and interface-id.
+TEST(SubnetIndexTest, findByRelayIfaceInterfaceId) {
+    Subnet6Collection subnets;
+    for (int i = 0; i < 3; ++i) {
+        subnets.push_back(Subnet6Ptr(new Subnet6(IOAddress("2001:db8::"), 48,
+                                                 1, 2, 3, 4)));
+    }
+    subnets[0]->setRelayInfo(IOAddress("2001:db8:ff::1"));
+    subnets[2]->setRelayInfo(IOAddress("2001:db8:ff::1"));
+    subnets[1]->setIface("eth0");
+    OptionPtr interface_id(new Option(Option::V6, D6O_INTERFACE_ID,
+                                      OptionBuffer(4, 0x11)));
+    subnets[2]->setInterfaceId(interface_id);
+
+    SubnetIndex index;
+    index.build(subnets);
+
+    SubnetIndex::Positions positions;
+    index.findByRelay(IOAddress("2001:db8:ff::1"), positions);
+    ASSERT_EQ(2, positions.size());
+    EXPECT_EQ(0, positions[0]);
+    EXPECT_EQ(2, positions[1]);
+
+    positions.clear();
+    index.findByIface("eth0", positions);
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(1, positions[0]);
+
+    positions.clear();
+    index.findByIface("eth1", positions);
+    EXPECT_TRUE(positions.empty());
+
+    // The interface-id is matched by its contents.
+    positions.clear();
+    OptionPtr same_id(new Option(Option::V6, D6O_INTERFACE_ID,
+                                 OptionBuffer(4, 0x11)));
+    index.findByInterfaceId(same_id, positions);
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(2, positions[0]);
+
+    positions.clear();
+    OptionPtr other_id(new Option(Option::V6, D6O_INTERFACE_ID,
+                                  OptionBuffer(4, 0x22)));
+    index.findByInterfaceId(other_id, positions);
+    EXPECT_TRUE(positions.empty());
+}
+
+// Checks that the subnets are found by their identifiers.
+TEST(SubnetIndexTest, findById) {
+    Subnet4Collection subnets;
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 24,
+                                             1, 2, 3)));
+    subnets.push_back(Subnet4Ptr(new Subnet4(IOAddress("192.0.3.0"), 24,
+                                             1, 2, 3)));
+    SubnetIndex index;
+    index.build(subnets);
+
+    SubnetIndex::Positions positions;
+    index.findById(subnets[1]->getID(), positions);
+    ASSERT_EQ(1, positions.size());
+    EXPECT_EQ(1, positions[0]);
+
+    positions.clear();
+    index.findById(subnets[1]->getID() + 1, positions);
+    EXPECT_TRUE(positions.empty());
+}
+
+// Checks that the merged positions are sorted and unique.
+TEST(SubnetIndexTest, sortPositions) {
+    SubnetIndex::Positions positions;
+    positions.push_back(5);
+    positions.push_back(1);
+    positions.push_back(5);
+    positions.push_back(3);
+    SubnetIndex::sortPositions(positions);
+    ASSERT_EQ(3, positions.size());
+    EXPECT_EQ(1, positions[0]);
+    EXPECT_EQ(3, positions[1]);
+    EXPECT_EQ(5, positions[2]);
+}
+
+} // end of anonymous namespace
@@ -23,6 +23,9 @@
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 
+#include <limits>
+#include <vector>
+
 // don't import the entire boost namespace.  It will unexpectedly hide uint8_t
 // for some systems.
 using boost::scoped_ptr;
@@ -121,6 +124,25 @@ TEST(Subnet4Test, Pool4InSubnet4) {
 
 }
 
+// Checks that the capacity of the pools is updated when the pools are
+// added and deleted.
+TEST(Subnet4Test, poolCapacity) {
+    Subnet4Ptr subnet(new Subnet4(IOAddress("192.1.2.0"), 24, 1, 2, 3));
+    EXPECT_EQ(0, subnet->getPoolCapacity(Lease::TYPE_V4));
+
+    subnet->addPool(PoolPtr(new Pool4(IOAddress("192.1.2.0"), 25)));
+    EXPECT_EQ(128, subnet->getPoolCapacity(Lease::TYPE_V4));
+    subnet->addPool(PoolPtr(new Pool4(IOAddress("192.1.2.200"),
+                                      IOAddress("192.1.2.209"))));
+    EXPECT_EQ(138, subnet->getPoolCapacity(Lease::TYPE_V4));
+
+    subnet->delPools(Lease::TYPE_V4);
+    EXPECT_EQ(0, subnet->getPoolCapacity(Lease::TYPE_V4));
+
+    // There are no IPv6 pools in the IPv4 subnet.
+    EXPECT_THROW(subnet->getPoolCapacity(Lease::TYPE_NA), BadValue);
+}
+
 TEST(Subnet4Test, Subnet4_Pool4_checks) {
 
     Subnet4Ptr subnet(new Subnet4(IOAddress("192.0.2.0"), 8, 1, 2, 3));
@@ -564,6 +586,31 @@ TEST(Subnet6Test, clientClassesMultiple) {
     EXPECT_TRUE(subnet->clientSupported(bar_class));
 }
 
+// Checks that the capacity is maintained per pool type and that it is
+// capped at the maximum value of uint64_t.
+TEST(Subnet6Test, poolCapacity) {
+    Subnet6Ptr subnet(new Subnet6(IOAddress("2001:db8::"), 32, 1, 2, 3, 4));
+
+    subnet->addPool(PoolPtr(new Pool6(Lease::TYPE_NA,
+                                      IOAddress("2001:db8:1::10"),
+                                      IOAddress("2001:db8:1::20"))));
+    subnet->addPool(PoolPtr(new Pool6(Lease::TYPE_PD,
+                                      IOAddress("2001:db8:2::"), 56, 60)));
+    EXPECT_EQ(17, subnet->getPoolCapacity(Lease::TYPE_NA));
+    EXPECT_EQ(0, subnet->getPoolCapacity(Lease::TYPE_TA));
+    EXPECT_EQ(16, subnet->getPoolCapacity(Lease::TYPE_PD));
+
+    // The capacity of the huge pools is capped.
+    subnet->addPool(PoolPtr(new Pool6(Lease::TYPE_NA,
+                                      IOAddress("2001:db8:3::"), 48)));
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+              subnet->getPoolCapacity(Lease::TYPE_NA));
+    subnet->addPool(PoolPtr(new Pool6(Lease::TYPE_NA,
+                                      IOAddress("2001:db8:4::"), 48)));
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+              subnet->getPoolCapacity(Lease::TYPE_NA));
+}
+
 TEST(Subnet6Test, Subnet6_Pool6_checks) {
 
     Subnet6Ptr subnet(new Subnet6(IOAddress("2001:db8:1::"), 56, 1, 2, 3, 4));
@@ -856,6 +903,33 @@ TEST(Subnet6Test, addVendorOptions) {
     EXPECT_TRUE(options->empty());
 }
 
+// This test verifies that all options configured for the subnet, including
+// the vendor options, are precompiled.
+TEST(Subnet6Test, precompileOptions) {
+    Subnet6Ptr subnet(new Subnet6(IOAddress("2001:db8:1::"), 56, 1, 2, 3, 4));
+
+    std::vector<OptionPtr> options;
+    for (uint16_t code = 100; code < 103; ++code) {
+        options.push_back(OptionPtr(new Option(Option::V6, code,
+                                               OptionBuffer(10, 0xFF))));
+        ASSERT_NO_THROW(subnet->addOption(options.back(), false, "dhcp6"));
+        options.push_back(OptionPtr(new Option(Option::V6, code,
+                                               OptionBuffer(10, 0xFF))));
+        ASSERT_NO_THROW(subnet->addOption(options.back(), false, "isc"));
+        options.push_back(OptionPtr(new Option(Option::V6, code,
+                                               OptionBuffer(10, 0xFF))));
+        ASSERT_NO_THROW(subnet->addVendorOption(options.back(), false,
+                                                12345678));
+    }
+
+    subnet->precompileOptions();
+
+    for (std::vector<OptionPtr>::const_iterator option = options.begin();
+         option != options.end(); ++option) {
+        EXPECT_TRUE((*option)->isPrecompiled());
+    }
+}
+
 
 
 // This test verifies that inRange() and inPool() methods work properly.
@@ -24,6 +24,7 @@
 
 #include <limits>
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 using namespace std;
@@ -39,17 +40,17 @@ namespace {     // hide internal-only names from the public namespaces
 /// rendered in the internal buffer for the \c MessageRendererImpl object.
 ///
 /// A \c MessageRendererImpl object maintains a set of \c OffsetItem
-/// objects in a hash table, and searches the table for the position of the
-/// longest match (ancestor) name against each new name to be rendered into
-/// the buffer.
+/// objects in an open-addressed hash table, and searches the table for the
+/// position of the longest match (ancestor) name against each new name to
+/// be rendered into the buffer.
 struct OffsetItem {
-    OffsetItem(size_t hash, size_t pos, size_t len) :
-        hash_(hash), pos_(pos), len_(len)
-    {}
+    /// The generation of the table the item was stored in.  The items of
+    /// an older generation are free slots.
+    uint32_t generation_;
 
-    /// The hash value for the stored name calculated by LabelSequence.getHash.
-    /// This will help make name comparison in \c NameCompare more efficient.
-    size_t hash_;
+    /// The hash value for the stored name calculated by \c hashLabel().
+    /// This will help make name comparison in \c matchName() more efficient.
+    uint32_t hash_;
 
     /// The position (offset from the beginning) in the buffer where the
     /// name starts.
@@ -59,93 +60,94 @@ struct OffsetItem {
     uint16_t len_;
 };
 
-/// \brief The \c NameCompare class is a functor that checks equality
-/// between the name corresponding to an \c OffsetItem object and the name
-/// consists of labels represented by a \c LabelSequence object.
+/// \brief Compute the hash value of a label sequence.
+///
+/// The value is computed from the first label of the sequence and the hash
+/// value of the sequence following it, so as the values for all the
+/// suffixes of a name can be computed by hashing each label only once,
+/// from the last one.  The (FNV-1a style) hashing is much cheaper than
+/// \c LabelSequence::getHash(), and covers the whole name.
 ///
 /// Template parameter CASE_SENSITIVE determines whether to ignore the case
-/// of the names.  This policy doesn't change throughout the lifetime of
-/// this object, so we separate these using template to avoid unnecessary
-/// condition check.
+/// of the label.
 template <bool CASE_SENSITIVE>
-struct NameCompare {
-    /// \brief Constructor
-    ///
-    /// \param buffer The buffer for rendering used in the caller renderer
-    /// \param name_buf An input buffer storing the wire-format data of the
-    /// name to be newly rendered (and only that data).
-    /// \param hash The hash value for the name.
-    NameCompare(const OutputBuffer& buffer, InputBuffer& name_buf,
-                size_t hash) :
-        buffer_(&buffer), name_buf_(&name_buf), hash_(hash)
-    {}
-
-    bool operator()(const OffsetItem& item) const {
-        // Trivial inequality check.  If either the hash or the total length
-        // doesn't match, the names are obviously different.
-        if (item.hash_  != hash_ || item.len_ != name_buf_->getLength()) {
-            return (false);
-        }
+inline uint32_t
+hashLabel(const uint8_t* label, uint32_t hash) {
+    const uint8_t* const label_end = label + *label + 1;
+    for (; label != label_end; ++label) {
+        hash ^= CASE_SENSITIVE ? *label : maptolower[*label];
+        hash *= 16777619;
+    }
+    return (hash);
+}
 
-        // Compare the name data, character-by-character.
-        // item_pos keeps track of the position in the buffer corresponding to
-        // the character to compare.  item_label_len is the number of
-        // characters in the labels where the character pointed by item_pos
-        // belongs.  When it reaches zero, nextPosition() identifies the
-        // position for the subsequent label, taking into account name
-        // compression, and resets item_label_len to the length of the new
-        // label.
-        name_buf_->setPosition(0); // buffer can be reused, so reset position
-        uint16_t item_pos = item.pos_;
-        uint16_t item_label_len = 0;
-        for (size_t i = 0; i < item.len_; ++i, ++item_pos) {
-            item_pos = nextPosition(*buffer_, item_pos, item_label_len);
-            const uint8_t ch1 = (*buffer_)[item_pos];
-            const uint8_t ch2 = name_buf_->readUint8();
-            if (CASE_SENSITIVE) {
-                if (ch1 != ch2) {
-                    return (false);
-                }
-            } else {
-                if (maptolower[ch1] != maptolower[ch2]) {
-                    return (false);
-                }
-            }
+/// \brief Get the position of the next character of a name rendered in the
+/// buffer, following compression pointers.
+///
+/// \c llen is the number of characters left in the current label.  When
+/// it reaches zero, the position for the subsequent label is identified,
+/// taking into account name compression, and \c llen is reset to the
+/// length of the new label.
+inline uint16_t
+nextPosition(const OutputBuffer& buffer, uint16_t pos, uint16_t& llen) {
+    if (llen == 0) {
+        size_t i = 0;
+
+        while ((buffer[pos] & Name::COMPRESS_POINTER_MARK8) ==
+               Name::COMPRESS_POINTER_MARK8) {
+            pos = (buffer[pos] & ~Name::COMPRESS_POINTER_MARK8) *
+                256 + buffer[pos + 1];
+
+            // This loop should stop as long as the buffer has been
+            // constructed validly and the search/insert argument is based
+            // on a valid name, which is an assumption for this class.
+            // But we'll abort if a bug could cause an infinite loop.
+            i += 2;
+            assert(i < Name::MAX_WIRE);
         }
-
-        return (true);
+        llen = buffer[pos];
+    } else {
+        --llen;
     }
+    return (pos);
+}
 
-private:
-    uint16_t nextPosition(const OutputBuffer& buffer,
-                          uint16_t pos, uint16_t& llen) const
-    {
-        if (llen == 0) {
-            size_t i = 0;
-
-            while ((buffer[pos] & Name::COMPRESS_POINTER_MARK8) ==
-                   Name::COMPRESS_POINTER_MARK8) {
-                pos = (buffer[pos] & ~Name::COMPRESS_POINTER_MARK8) *
-                    256 + buffer[pos + 1];
-
-                // This loop should stop as long as the buffer has been
-                // constructed validly and the search/insert argument is based
-                // on a valid name, which is an assumption for this class.
-                // But we'll abort if a bug could cause an infinite loop.
-                i += 2;
-                assert(i < Name::MAX_WIRE);
+/// \brief Check the equality between the name corresponding to an
+/// \c OffsetItem object and the name in wire format stored in \c data.
+///
+/// The length of \c data is expected to be the one of the item, which is
+/// checked by the caller along with the hash value.
+///
+/// Template parameter CASE_SENSITIVE determines whether to ignore the case
+/// of the names.
+template <bool CASE_SENSITIVE>
+bool
+matchName(const OutputBuffer& buffer, const OffsetItem& item,
+          const uint8_t* data)
+{
+    // Compare the name data, character-by-character.  item_pos keeps track
+    // of the position in the buffer corresponding to the character to
+    // compare.  item_label_len is the number of characters in the labels
+    // where the character pointed by item_pos belongs.
+    uint16_t item_pos = item.pos_;
+    uint16_t item_label_len = 0;
+    for (size_t i = 0; i < item.len_; ++i, ++item_pos) {
+        item_pos = nextPosition(buffer, item_pos, item_label_len);
+        const uint8_t ch1 = buffer[item_pos];
+        const uint8_t ch2 = data[i];
+        if (CASE_SENSITIVE) {
+            if (ch1 != ch2) {
+                return (false);
             }
-            llen = buffer[pos];
         } else {
-            --llen;
+            if (maptolower[ch1] != maptolower[ch2]) {
+                return (false);
+            }
         }
-        return (pos);
     }
 
-    const OutputBuffer* buffer_;
-    InputBuffer* name_buf_;
-    const size_t hash_;
-};
+    return (true);
+}
 }
 
 ///
@@ -158,57 +160,129 @@ private:
 /// It internally holds a hash table for OffsetItem objects corresponding
 /// to portions of names rendered in this renderer.  The offset information
 /// is used to compress subsequent names to be rendered.
+///
+/// The table is open-addressed (with linear probing) in a single array, so
+/// as a lookup usually touches a single cache line.  Rather than clearing
+/// the whole array for each new message, each slot records the generation
+/// it was filled in, and \c clear() only starts a new generation.
 struct MessageRenderer::MessageRendererImpl {
-    // The size of hash buckets and number of hash entries per bucket for
-    // which space is preallocated and kept reserved for subsequent rendering
-    // to provide better performance.  These values are derived from the
-    // BIND 9 implementation that uses a similar hash table.
-    static const size_t BUCKETS = 64;
-    static const size_t RESERVED_ITEMS = 16;
+    // The initial number of slots in the hash table.  It must be a power of
+    // 2.  It's large enough for the names of a typical response; the table
+    // grows when a message needs more slots, and keeps its size for the
+    // subsequent messages.
+    static const size_t INITIAL_TABLE_SIZE = 256;
     static const uint16_t NO_OFFSET = 65535; // used as a marker of 'not found'
 
     /// \brief Constructor
     MessageRendererImpl() :
+        table_(INITIAL_TABLE_SIZE), generation_(1), item_count_(0),
         msglength_limit_(512), truncated_(false),
         compress_mode_(MessageRenderer::CASE_INSENSITIVE)
     {
-        // Reserve some spaces for hash table items.
-        for (size_t i = 0; i < BUCKETS; ++i) {
-            table_[i].reserve(RESERVED_ITEMS);
+        // All the slots are initially free (of generation 0).
+        memset(&table_[0], 0, table_.size() * sizeof(OffsetItem));
+    }
+
+    // The slot for a hash value to start probing from.
+    size_t getSlot(const uint32_t hash) const {
+        return ((hash ^ (hash >> 16)) & (table_.size() - 1));
+    }
+
+    uint16_t findOffset(const OutputBuffer& buffer, const uint8_t* data,
+                        size_t len, uint32_t hash, bool case_sensitive) const
+    {
+        // The table is never more than half full, so there's always a free
+        // slot to stop the probing.
+        const size_t mask = table_.size() - 1;
+        for (size_t i = getSlot(hash); table_[i].generation_ == generation_;
+             i = (i + 1) & mask) {
+            const OffsetItem& item = table_[i];
+            if (item.hash_ != hash || item.len_ != len) {
+                continue;
+            }
+            if (case_sensitive ? matchName<true>(buffer, item, data) :
+                matchName<false>(buffer, item, data)) {
+                return (item.pos_);
+            }
+        }
+        return (NO_OFFSET);
+    }
+
+    void addOffset(uint32_t hash, size_t offset, size_t len) {
+        if ((item_count_ + 1) * 2 > table_.size()) {
+            grow();
+        }
+        insert(hash, offset, len);
+        ++item_count_;
+    }
+
+    void clear() {
+        item_count_ = 0;
+        if (++generation_ == 0) {
+            // After a wrap around, the slots from the generations before
+            // might look current, so they are really freed.
+            memset(&table_[0], 0, table_.size() * sizeof(OffsetItem));
+            generation_ = 1;
         }
     }
 
-    uint16_t findOffset(const OutputBuffer& buffer, InputBuffer& name_buf,
-                        size_t hash, bool case_sensitive) const
+    // Compute the hash values of all the suffixes of a name, in wire
+    // format, storing the offset of each label on the way.
+    template <bool CASE_SENSITIVE>
+    void hashSequence(const uint8_t* data, size_t data_len,
+                      size_t nlabels)
     {
-        // Find a matching entry, if any.  We use some heuristics here: often
-        // the same name appears consecutively (like repeating the same owner
-        // name for a single RRset), so in case there's a collision in the
-        // bucket it will be more likely to find it in the tail side of the
-        // bucket.
-        const size_t bucket_id = hash % BUCKETS;
-        vector<OffsetItem>::const_reverse_iterator found;
-        if (case_sensitive) {
-            found = find_if(table_[bucket_id].rbegin(),
-                            table_[bucket_id].rend(),
-                            NameCompare<true>(buffer, name_buf, hash));
-        } else {
-            found = find_if(table_[bucket_id].rbegin(),
-                            table_[bucket_id].rend(),
-                            NameCompare<false>(buffer, name_buf, hash));
+        size_t pos = 0;
+        for (size_t i = 0; i < nlabels; ++i) {
+            label_offsets_[i] = pos;
+            pos += data[pos] + 1;
         }
-        if (found != table_[bucket_id].rend()) {
-            return (found->pos_);
+        assert(pos == data_len);
+        uint32_t hash = 2166136261U;
+        for (size_t i = nlabels; i > 0; --i) {
+            hash = hashLabel<CASE_SENSITIVE>(data + label_offsets_[i - 1],
+                                             hash);
+            seq_hashes_[i - 1] = hash;
         }
-        return (NO_OFFSET);
     }
 
-    void addOffset(size_t hash, size_t offset, size_t len) {
-        table_[hash % BUCKETS].push_back(OffsetItem(hash, offset, len));
+private:
+    void insert(uint32_t hash, size_t offset, size_t len) {
+        const size_t mask = table_.size() - 1;
+        size_t i = getSlot(hash);
+        while (table_[i].generation_ == generation_) {
+            i = (i + 1) & mask;
+        }
+        OffsetItem& item = table_[i];
+        item.generation_ = generation_;
+        item.hash_ = hash;
+        item.pos_ = offset;
+        item.len_ = len;
+    }
+
+    // Double the size of the table, keeping the current items.
+    void grow() {
+        vector<OffsetItem> old_table(table_.size() * 2);
+        memset(&old_table[0], 0, old_table.size() * sizeof(OffsetItem));
+        old_table.swap(table_);
+        const uint32_t old_generation = generation_;
+        generation_ = 1;
+        for (vector<OffsetItem>::const_iterator it = old_table.begin();
+             it != old_table.end(); ++it) {
+            if (it->generation_ == old_generation) {
+                insert(it->hash_, it->pos_, it->len_);
+            }
+        }
     }
 
     // The hash table for the (offset + position in the buffer) entries
-    vector<OffsetItem> table_[BUCKETS];
+    vector<OffsetItem> table_;
+    // The current generation of the table
+    uint32_t generation_;
+    // The number of items in the current generation
+    size_t item_count_;
+
+public:
     /// The maximum length of rendered data that can fit without
     /// truncation.
     uint16_t msglength_limit_;
@@ -218,10 +292,10 @@ struct MessageRenderer::MessageRendererImpl {
     /// The name compression mode.
     CompressMode compress_mode_;
 
-    // Placeholder for hash values as they are calculated in writeName().
-    // Note: we may want to make it a local variable of writeName() if it
-    // works more efficiently.
-    boost::array<size_t, Name::MAX_LABELS> seq_hashes_;
+    // Placeholder for hash values and label offsets as they are calculated
+    // in writeName().
+    boost::array<uint32_t, Name::MAX_LABELS> seq_hashes_;
+    boost::array<uint8_t, Name::MAX_LABELS> label_offsets_;
 };
 
 MessageRenderer::MessageRenderer() :
@@ -239,19 +313,7 @@ MessageRenderer::clear() {
     impl_->msglength_limit_ = 512;
     impl_->truncated_ = false;
     impl_->compress_mode_ = CASE_INSENSITIVE;
-
-    // Clear the hash table.  We reserve the minimum space for possible
-    // subsequent use of the renderer.
-    for (size_t i = 0; i < MessageRendererImpl::BUCKETS; ++i) {
-        if (impl_->table_[i].size() > MessageRendererImpl::RESERVED_ITEMS) {
-            // Trim excessive capacity: swap ensures the new capacity is only
-            // reasonably large for the reserved space.
-            vector<OffsetItem> new_table;
-            new_table.reserve(MessageRendererImpl::RESERVED_ITEMS);
-            new_table.swap(impl_->table_[i]);
-        }
-        impl_->table_[i].clear();
-    }
+    impl_->clear();
 }
 
 size_t
@@ -290,32 +352,29 @@ MessageRenderer::setCompressMode(const CompressMode mode) {
 
 void
 MessageRenderer::writeName(const LabelSequence& ls, const bool compress) {
-    LabelSequence sequence(ls);
-    const size_t nlabels = sequence.getLabelCount();
     size_t data_len;
-    const uint8_t* data;
+    const uint8_t* const data = ls.getData(&data_len);
+    const size_t nlabels = ls.getLabelCount();
+    const bool case_sensitive = (impl_->compress_mode_ ==
+                                 MessageRenderer::CASE_SENSITIVE);
+    if (case_sensitive) {
+        impl_->hashSequence<true>(data, data_len, nlabels);
+    } else {
+        impl_->hashSequence<false>(data, data_len, nlabels);
+    }
 
     // Find the offset in the offset table whose name gives the longest
     // match against the name to be rendered.
     size_t nlabels_uncomp;
     uint16_t ptr_offset = MessageRendererImpl::NO_OFFSET;
-    const bool case_sensitive = (impl_->compress_mode_ ==
-                                 MessageRenderer::CASE_SENSITIVE);
     for (nlabels_uncomp = 0; nlabels_uncomp < nlabels; ++nlabels_uncomp) {
-        if (nlabels_uncomp > 0) {
-            sequence.stripLeft(1);
-        }
-
-        data = sequence.getData(&data_len);
-        if (data_len == 1) { // trailing dot.
+        const size_t label_offset = impl_->label_offsets_[nlabels_uncomp];
+        if (data[label_offset] == 0) { // trailing dot.
             ++nlabels_uncomp;
             break;
         }
-        // write with range check for safety
-        impl_->seq_hashes_.at(nlabels_uncomp) =
-            sequence.getHash(impl_->compress_mode_);
-        InputBuffer name_buf(data, data_len);
-        ptr_offset = impl_->findOffset(getBuffer(), name_buf,
+        ptr_offset = impl_->findOffset(getBuffer(), data + label_offset,
+                                       data_len - label_offset,
                                        impl_->seq_hashes_[nlabels_uncomp],
                                        case_sensitive);
         if (ptr_offset != MessageRendererImpl::NO_OFFSET) {
@@ -327,13 +386,10 @@ MessageRenderer::writeName(const LabelSequence& ls, const bool compress) {
     size_t offset = getLength();
     // Write uncompress part:
     if (nlabels_uncomp > 0 || !compress) {
-        LabelSequence uncomp_sequence(ls);
-        if (compress && nlabels > nlabels_uncomp) {
-            // If there's compressed part, strip off that part.
-            uncomp_sequence.stripRight(nlabels - nlabels_uncomp);
-        }
-        data = uncomp_sequence.getData(&data_len);
-        writeData(data, data_len);
+        // If there's compressed part, strip off that part.
+        const size_t uncomp_len = (compress && nlabels > nlabels_uncomp) ?
+            impl_->label_offsets_[nlabels_uncomp] : data_len;
+        writeData(data, uncomp_len);
     }
     // And write compression pointer if available:
     if (compress && ptr_offset != MessageRendererImpl::NO_OFFSET) {
@@ -345,7 +401,7 @@ MessageRenderer::writeName(const LabelSequence& ls, const bool compress) {
     // in the hash table.  The renderer's buffer has just stored the
     // corresponding data, so we use the rendered data to get the length
     // of each label of the names.
-    size_t seqlen = ls.getDataLength();
+    size_t seqlen = data_len;
     for (size_t i = 0; i < nlabels_uncomp; ++i) {
         const uint8_t label_len = getBuffer()[offset];
         if (label_len == 0) { // offset for root doesn't need to be stored.
@@ -295,4 +295,28 @@ TEST_F(MessageRendererTest, manyRRs) {
     // any disruption.
     EXPECT_NO_THROW(renderer.clear());
 }
+
+TEST_F(MessageRendererTest, compressManyNames) {
+    // Render enough names for the compression table to grow, then the
+    // same names again: each of them should be compressed into a pointer.
+    for (size_t i = 0; i < 1000; ++i) {
+        renderer.writeName(Name(lexical_cast<std::string>(i) + ".example"));
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+        const size_t length = renderer.getLength();
+        renderer.writeName(Name(lexical_cast<std::string>(i) + ".EXAMPLE"));
+        EXPECT_EQ(length + 2, renderer.getLength());
+    }
+
+    // Once cleared, none of the previous names is used for compression,
+    // even if the new ones happen to be at the same positions.
+    renderer.clear();
+    renderer.skip(12);
+    const Name name("www.example.org");
+    renderer.writeName(name);
+    EXPECT_EQ(12 + name.getLength(), renderer.getLength());
+    renderer.writeName(Name("0.example"));
+    EXPECT_EQ(12 + name.getLength() + Name("0.example").getLength(),
+              renderer.getLength());
+}
 }
@@ -0,0 +1,209 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <hooks/callout_handle.h>
+#include <hooks/callout_manager.h>
+#include <hooks/server_hooks.h>
+#include <log/logger_support.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::bench;
+using namespace isc::hooks;
+
+namespace {
+
+// The hook points of the DHCP servers and the arguments passed to their
+// callouts.  The values of the arguments are irrelevant to the benchmark,
+// so all of them are shared pointers, like the packets and leases passed
+// by the servers.
+struct HookPoint {
+    const char* name_;
+    const char* arguments_[6];
+};
+
+const HookPoint hook_points[] = {
+    { "buffer4_receive", { "query4" } },
+    { "pkt4_receive", { "query4" } },
+    { "subnet4_select", { "query4", "subnet4", "subnet4collection" } },
+    { "lease4_select", { "subnet4", "clientid", "hwaddr", "fake_allocation",
+                         "lease4" } },
+    { "lease4_release", { "query4", "lease4" } },
+    { "pkt4_send", { "response4" } },
+    { "buffer4_send", { "response4" } },
+    { "buffer6_receive", { "query6" } },
+    { "pkt6_receive", { "query6" } },
+    { "subnet6_select", { "query6", "subnet6", "subnet6collection" } },
+    { "lease6_select", { "subnet6", "fake_allocation", "lease6" } },
+    { "lease6_renew", { "query6", "lease6", "ia_na" } },
+    { "lease6_release", { "query6", "lease6" } },
+    { "pkt6_send", { "response6" } },
+    { "buffer6_send", { "response6" } }
+};
+
+typedef boost::shared_ptr<int> ValuePtr;
+
+// Hook point being measured and the indexes of its arguments.  They are
+// used by the callouts.
+const HookPoint* current_hook = NULL;
+vector<int> current_arguments;
+
+// Callout reading all arguments by name.
+int
+calloutByName(CalloutHandle& handle) {
+    ValuePtr value;
+    for (int i = 0; current_hook->arguments_[i] != NULL; ++i) {
+        handle.getArgument(current_hook->arguments_[i], value);
+    }
+    return (0);
+}
+
+// Callout reading all arguments using the indexes resolved in advance,
+// as a library would do when it is loaded.
+int
+calloutByIndex(CalloutHandle& handle) {
+    ValuePtr value;
+    for (vector<int>::const_iterator index = current_arguments.begin();
+         index != current_arguments.end(); ++index) {
+        handle.getArgument(*index, value);
+    }
+    return (0);
+}
+
+// This benchmark performs what the server does at a hook point: it sets
+// the arguments, calls the callouts and retrieves the first argument,
+// which the callouts may have modified.  The arguments are accessed by
+// name or by index.
+class CalloutBenchMark {
+public:
+    CalloutBenchMark(CalloutManager& manager, CalloutHandle& handle,
+                     const int hook_index, const bool by_index) :
+        manager_(manager), handle_(handle), hook_index_(hook_index),
+        by_index_(by_index), value_(new int(0))
+    {}
+    unsigned int run() {
+        handle_.deleteAllArguments();
+        handle_.setSkip(false);
+        if (by_index_) {
+            for (vector<int>::const_iterator index =
+                     current_arguments.begin();
+                 index != current_arguments.end(); ++index) {
+                handle_.setArgument(*index, value_);
+            }
+        } else {
+            for (int i = 0; current_hook->arguments_[i] != NULL; ++i) {
+                handle_.setArgument(current_hook->arguments_[i], value_);
+            }
+        }
+        manager_.callCallouts(hook_index_, handle_);
+        ValuePtr value;
+        if (by_index_) {
+            handle_.getArgument(current_arguments[0], value);
+        } else {
+            handle_.getArgument(current_hook->arguments_[0], value);
+        }
+        assert(value == value_);
+        return (1);
+    }
+private:
+    CalloutManager& manager_;
+    CalloutHandle& handle_;
+    const int hook_index_;
+    const bool by_index_;
+    const ValuePtr value_;
+};
+
+void
+usage() {
+    cerr << "Usage: callout_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 1000000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    isc::log::initLogger("callout_bench");
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+
+    // The hooks must be registered before the callout manager is created.
+    const size_t hook_count = sizeof(hook_points) / sizeof(hook_points[0]);
+    ServerHooks& hooks = ServerHooks::getServerHooks();
+    vector<int> hook_indexes;
+    for (size_t i = 0; i < hook_count; ++i) {
+        hook_indexes.push_back(hooks.registerHook(hook_points[i].name_));
+    }
+
+    boost::shared_ptr<CalloutManager> manager(new CalloutManager(1));
+    manager->setLibraryIndex(1);
+
+    for (size_t i = 0; i < hook_count; ++i) {
+        current_hook = &hook_points[i];
+        current_arguments.clear();
+        for (int j = 0; current_hook->arguments_[j] != NULL; ++j) {
+            current_arguments.push_back(
+                hooks.registerArgument(current_hook->arguments_[j]));
+        }
+
+        // The handle is reused by all iterations, like the server uses
+        // it for all hook points while processing a packet.
+        CalloutHandle handle(manager);
+
+        manager->registerCallout(current_hook->name_, calloutByName);
+        cout << "Benchmark for " << current_hook->name_
+             << " with the arguments accessed by name" << endl;
+        BenchMark<CalloutBenchMark>(iteration,
+                                    CalloutBenchMark(*manager, handle,
+                                                     hook_indexes[i], false));
+        manager->deregisterAllCallouts(current_hook->name_);
+
+        manager->registerCallout(current_hook->name_, calloutByIndex);
+        cout << "Benchmark for " << current_hook->name_
+             << " with the arguments accessed by index" << endl;
+        BenchMark<CalloutBenchMark>(iteration,
+                                    CalloutBenchMark(*manager, handle,
+                                                     hook_indexes[i], true));
+        manager->deregisterAllCallouts(current_hook->name_);
+    }
+
+    return (0);
+}
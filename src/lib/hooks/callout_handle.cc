@@ -17,6 +17,7 @@
 #include <hooks/library_handle.h>
 #include <hooks/server_hooks.h>
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -31,7 +32,7 @@ CalloutHandle::CalloutHandle(const boost::shared_ptr<CalloutManager>& manager,
                     const boost::shared_ptr<LibraryManagerCollection>& lmcoll)
     : lm_collection_(lmcoll), arguments_(), context_collection_(),
       manager_(manager), server_hooks_(ServerHooks::getServerHooks()),
-      skip_(false) {
+      skip_(false), current_hook_(-1), current_library_(-1) {
 
     // Call the "context_create" hook.  We should be OK doing this - although
     // the constructor has not finished running, all the member variables
@@ -72,11 +73,16 @@ vector<string>
 CalloutHandle::getArgumentNames() const {
 
     vector<string> names;
-    for (ElementCollection::const_iterator i = arguments_.begin();
-         i != arguments_.end(); ++i) {
-        names.push_back(i->first);
+    for (int i = 0; i < static_cast<int>(arguments_.size()); ++i) {
+        if (arguments_[i].present_) {
+            names.push_back(server_hooks_.getArgumentName(i));
+        }
     }
 
+    // The names are returned in alphabetical order rather than in the
+    // order of the argument indexes.
+    sort(names.begin(), names.end());
+
     return (names);
 }
 
@@ -85,7 +91,27 @@ CalloutHandle::getArgumentNames() const {
 
 LibraryHandle&
 CalloutHandle::getLibraryHandle() const {
-    return (manager_->getLibraryHandle());
+    if (current_library_ < 0) {
+        return (manager_->getLibraryHandle());
+    }
+
+    // The library handle bound to the library of the callout is used, as
+    // the current library index of the callout manager is not set while
+    // the callouts are called.
+    boost::shared_ptr<LibraryHandle>& handle =
+        library_handles_[current_library_];
+    if (!handle) {
+        handle.reset(new LibraryHandle(manager_.get(), current_library_));
+    }
+    return (*handle);
+}
+
+// Return the index of the library of the callout being called.
+
+int
+CalloutHandle::getLibraryIndex() const {
+    return (current_library_ >= 0 ? current_library_ :
+            manager_->getLibraryIndex());
 }
 
 // Return the context for the currently pointed-to library.  This version is
@@ -94,7 +120,7 @@ CalloutHandle::getLibraryHandle() const {
 
 CalloutHandle::ElementCollection&
 CalloutHandle::getContextForLibrary() {
-    int libindex = manager_->getLibraryIndex();
+    int libindex = getLibraryIndex();
 
     // Access a reference to the element collection for the given index,
     // creating a new element collection if necessary, and return it.
@@ -106,7 +132,7 @@ CalloutHandle::getContextForLibrary() {
 
 const CalloutHandle::ElementCollection&
 CalloutHandle::getContextForLibrary() const {
-    int libindex = manager_->getLibraryIndex();
+    int libindex = getLibraryIndex();
 
     ContextCollection::const_iterator libcontext =
         context_collection_.find(libindex);
@@ -144,7 +170,7 @@ CalloutHandle::getContextNames() const {
 string
 CalloutHandle::getHookName() const {
     // Get the current hook index.
-    int index = manager_->getHookIndex();
+    int index = current_hook_;
 
     // ... and look up the hook.
     string hook = "";
@@ -17,6 +17,7 @@
 
 #include <exceptions/exceptions.h>
 #include <hooks/library_handle.h>
+#include <hooks/server_hooks.h>
 
 #include <boost/any.hpp>
 #include <boost/shared_ptr.hpp>
@@ -28,8 +29,6 @@
 namespace isc {
 namespace hooks {
 
-class ServerHooks;
-
 /// @brief No such argument
 ///
 /// Thrown if an attempt is made access an argument that does not exist.
@@ -69,7 +68,10 @@ class LibraryManagerCollection;
 /// - Arguments.  When the callouts associated with a hook are called, they
 ///   are passed information by the server (and can return information to it)
 ///   through name/value pairs.  Each of these pairs is an argument and the
-///   information is accessed through the {get,set}Argument() methods.
+///   information is accessed through the {get,set}Argument() methods.  The
+///   arguments are held in slots indexed by the argument index registered
+///   with ServerHooks::registerArgument(), so the code which resolves the
+///   index in advance can access the argument without looking up its name.
 ///
 /// - Per-packet context.  Each packet has a context associated with it, this
 ///   context being  on a per-library basis.  In other words, As a packet passes
@@ -145,7 +147,32 @@ public:
     /// @param value Value to set.  That can be of any data type.
     template <typename T>
     void setArgument(const std::string& name, T value) {
-        arguments_[name] = value;
+        setArgument(server_hooks_.registerArgument(name), value);
+    }
+
+    /// @brief Set argument by index
+    ///
+    /// Sets the value of an argument identified by the index returned by
+    /// ServerHooks::registerArgument().  If the slot already holds a
+    /// value of the same type (e.g. a callout replaces the value passed
+    /// by the server, or the argument was set at an earlier hook and
+    /// deleted since), the value is assigned in place, without allocating
+    /// a new holder.
+    ///
+    /// @param index Index of the argument.
+    /// @param value Value to set.  That can be of any default constructible
+    ///        data type.
+    template <typename T>
+    void setArgument(int index, T value) {
+        Argument& argument = getArgumentSlot(index);
+        T* stored = boost::any_cast<T>(&argument.value_);
+        if (stored != NULL) {
+            *stored = value;
+        } else {
+            argument.value_ = value;
+            argument.release_ = &releaseValue<T>;
+        }
+        argument.present_ = true;
     }
 
     /// @brief Get argument
@@ -162,13 +189,36 @@ public:
     ///        the variable provided to receive the value.
     template <typename T>
     void getArgument(const std::string& name, T& value) const {
-        ElementCollection::const_iterator element_ptr = arguments_.find(name);
-        if (element_ptr == arguments_.end()) {
+        const int index = server_hooks_.findArgument(name);
+        if (!hasArgument(index)) {
             isc_throw(NoSuchArgument, "unable to find argument with name " <<
                       name);
         }
 
-        value = boost::any_cast<T>(element_ptr->second);
+        value = boost::any_cast<T>(arguments_[index].value_);
+    }
+
+    /// @brief Get argument by index
+    ///
+    /// Gets the value of an argument identified by the index returned by
+    /// ServerHooks::registerArgument().
+    ///
+    /// @param index Index of the argument.
+    /// @param value [out] Value to set.  The type of "value" is important:
+    ///        it must match the type of the value set.
+    ///
+    /// @throw NoSuchArgument No argument with the given index is present.
+    /// @throw boost::bad_any_cast An argument with the given index is
+    ///        present, but the data type of the value is not the same as the
+    ///        type of the variable provided to receive the value.
+    template <typename T>
+    void getArgument(int index, T& value) const {
+        if (!hasArgument(index)) {
+            isc_throw(NoSuchArgument, "unable to find argument with index " <<
+                      index);
+        }
+
+        value = boost::any_cast<T>(arguments_[index].value_);
     }
 
     /// @brief Get argument names
@@ -189,17 +239,28 @@ public:
     ///
     /// @param name Name of the element in the argument list to set.
     void deleteArgument(const std::string& name) {
-        static_cast<void>(arguments_.erase(name));
+        const int index = server_hooks_.findArgument(name);
+        if (hasArgument(index)) {
+            releaseArgument(arguments_[index]);
+        }
     }
 
     /// @brief Delete all arguments
     ///
-    /// Deletes all arguments associated with this context.
+    /// Deletes all arguments associated with this context.  The values
+    /// are released, so the handle doesn't keep the objects passed to the
+    /// previous hook (e.g. packets or leases) alive, but the slots and
+    /// their holders are kept for the arguments set at the next hook.
     ///
     /// N.B. If any elements are raw pointers, the pointed-to data is NOT
     /// deleted by this method.
     void deleteAllArguments() {
-        arguments_.clear();
+        for (ArgumentCollection::iterator argument = arguments_.begin();
+             argument != arguments_.end(); ++argument) {
+            if (argument->present_) {
+                releaseArgument(*argument);
+            }
+        }
     }
 
     /// @brief Set skip flag
@@ -228,7 +289,7 @@ public:
     /// only available when called by a callout (which in turn is called
     /// through the "callCallouts" method), as it is only then that the current
     /// library index is valid.  A callout uses the library handle to
-    /// dynamically register or deregister callouts.
+    /// dynamically register or deregister callouts for its library.
     ///
     /// @return Reference to the library handle.
     ///
@@ -319,15 +380,88 @@ public:
     std::string getHookName() const;
 
 private:
-    /// @brief Check index
+    /// @brief Argument slot
+    struct Argument {
+        /// @brief Constructor
+        Argument() : present_(false), release_(NULL) {
+        }
+
+        /// Value of the argument.  It is empty if no argument was ever set
+        /// in the slot, and holds a default constructed value if the
+        /// argument was deleted.
+        boost::any value_;
+
+        /// Indicates if the argument is set.
+        bool present_;
+
+        /// Replaces the value by a default constructed value of its type.
+        void (*release_)(boost::any&);
+    };
+
+    /// Argument slots, indexed by the argument index.
+    typedef std::vector<Argument> ArgumentCollection;
+
+    /// @brief Replace a value by a default constructed value
     ///
-    /// Gets the current library index, throwing an exception if it is not set
-    /// or is invalid for the current library collection.
+    /// Releases the object the value refers to (e.g. the packet held by a
+    /// shared pointer) but keeps the holder of the value.
     ///
-    /// @return Current library index, valid for this library collection.
+    /// @param value Value of type T.
+    template <typename T>
+    static void releaseValue(boost::any& value) {
+        T* stored = boost::any_cast<T>(&value);
+        if (stored != NULL) {
+            *stored = T();
+        }
+    }
+
+    /// @brief Delete the argument of a slot
     ///
-    /// @throw InvalidIndex current library index is not valid for the library
-    ///        handle collection.
+    /// @param argument Slot of the argument.
+    static void releaseArgument(Argument& argument) {
+        if (argument.release_ != NULL) {
+            (*argument.release_)(argument.value_);
+        }
+        argument.present_ = false;
+    }
+
+    /// @brief Check if the argument is set
+    ///
+    /// @param index Index of the argument, -1 if the argument name is not
+    ///        registered.
+    ///
+    /// @return true if the argument is set.
+    bool hasArgument(int index) const {
+        return ((index >= 0) &&
+                (index < static_cast<int>(arguments_.size())) &&
+                arguments_[index].present_);
+    }
+
+    /// @brief Get argument slot
+    ///
+    /// @param index Index of the argument.  The slot is created if it does
+    ///        not exist.
+    ///
+    /// @return Reference to the slot.
+    ///
+    /// @throw NoSuchArgument The index is negative.
+    Argument& getArgumentSlot(int index) {
+        if (index < 0) {
+            isc_throw(NoSuchArgument, "invalid argument index " << index);
+        }
+        if (index >= static_cast<int>(arguments_.size())) {
+            arguments_.resize(index + 1);
+        }
+        return (arguments_[index]);
+    }
+
+    /// @brief Get current library index
+    ///
+    /// Gets the index of the library of the callout being called with this
+    /// handle.  Outside of the callouts, this is the current library index
+    /// of the callout manager.
+    ///
+    /// @return Current library index.
     int getLibraryIndex() const;
 
     /// @brief Return reference to context for current library
@@ -363,7 +497,7 @@ private:
     boost::shared_ptr<LibraryManagerCollection> lm_collection_;
 
     /// Collection of arguments passed to the callouts
-    ElementCollection arguments_;
+    ArgumentCollection arguments_;
 
     /// Context collection - there is one entry per library context.
     ContextCollection context_collection_;
@@ -378,6 +512,21 @@ private:
 
     /// "Skip" flag, indicating if the caller should bypass remaining callouts.
     bool skip_;
+
+    /// Index of the hook on which the callouts are being called with this
+    /// handle, -1 outside of the callouts.  It is set by the CalloutManager.
+    int current_hook_;
+
+    /// Index of the library of the callout being called with this handle,
+    /// -1 outside of the callouts.  It is set by the CalloutManager.
+    int current_library_;
+
+    /// Library handles returned to the callouts, indexed by the library
+    /// index.
+    mutable std::map<int, boost::shared_ptr<LibraryHandle> > library_handles_;
+
+    /// The CalloutManager sets the current hook and library indexes.
+    friend class CalloutManager;
 };
 
 /// A shared pointer to a CalloutHandle object.
@@ -32,7 +32,7 @@ namespace hooks {
 // Constructor
 CalloutManager::CalloutManager(int num_libraries)
     : server_hooks_(ServerHooks::getServerHooks()),
-      current_hook_(-1), current_library_(-1),
+      current_library_(-1),
       hook_vector_(ServerHooks::getServerHooks().getCount()),
       library_handle_(this), pre_library_handle_(this, 0),
       post_library_handle_(this, INT_MAX), num_libraries_(num_libraries)
@@ -123,9 +123,16 @@ CalloutManager::callCallouts(int hook_index, CalloutHandle& callout_handle) {
     // also catches the case of an invalid index.
     if (calloutsPresent(hook_index)) {
 
+        // The current hook and library indexes are held in the callout
+        // handle, so several threads may call the callouts at the same time,
+        // each with its own handle.  The previous values are restored at the
+        // end, in case a callout calls the callouts on another hook.
+        const int saved_hook = callout_handle.current_hook_;
+        const int saved_library = callout_handle.current_library_;
+
         // Set the current hook index.  This is used should a callout wish to
         // determine to what hook it is attached.
-        current_hook_ = hook_index;
+        callout_handle.current_hook_ = hook_index;
 
         // Duplicate the callout vector for this hook and work through that.
         // This step is needed because we allow dynamic registration and
@@ -138,39 +145,40 @@ CalloutManager::callCallouts(int hook_index, CalloutHandle& callout_handle) {
         for (CalloutVector::const_iterator i = callouts.begin();
              i != callouts.end(); ++i) {
             // In case the callout tries to register or deregister a callout,
-            // set the current library index to the index associated with the
-            // library that registered the callout being called.
-            current_library_ = i->first;
+            // or to access its context, set the current library index to the
+            // index associated with the library that registered the callout
+            // being called.
+            callout_handle.current_library_ = i->first;
 
             // Call the callout
             try {
                 int status = (*i->second)(callout_handle);
                 if (status == 0) {
                     LOG_DEBUG(hooks_logger, HOOKS_DBG_EXTENDED_CALLS,
-                              HOOKS_CALLOUT_CALLED).arg(current_library_)
-                        .arg(server_hooks_.getName(current_hook_))
+                              HOOKS_CALLOUT_CALLED).arg(i->first)
+                        .arg(server_hooks_.getName(hook_index))
                         .arg(PointerConverter(i->second).dlsymPtr());
                 } else {
                     LOG_ERROR(hooks_logger, HOOKS_CALLOUT_ERROR)
-                        .arg(current_library_)
-                        .arg(server_hooks_.getName(current_hook_))
+                        .arg(i->first)
+                        .arg(server_hooks_.getName(hook_index))
                         .arg(PointerConverter(i->second).dlsymPtr());
                 }
             } catch (const std::exception& e) {
                 // Any exception, not just ones based on isc::Exception
                 LOG_ERROR(hooks_logger, HOOKS_CALLOUT_EXCEPTION)
-                    .arg(current_library_)
-                    .arg(server_hooks_.getName(current_hook_))
+                    .arg(i->first)
+                    .arg(server_hooks_.getName(hook_index))
                     .arg(PointerConverter(i->second).dlsymPtr())
                     .arg(e.what());
             }
 
         }
 
-        // Reset the current hook and library indexs to an invalid value to
-        // catch any programming errors.
-        current_hook_ = -1;
-        current_library_ = -1;
+        // Restore the current hook and library indexes, which are invalid
+        // unless the callouts were called by another callout.
+        callout_handle.current_hook_ = saved_hook;
+        callout_handle.current_library_ = saved_library;
     }
 }
 
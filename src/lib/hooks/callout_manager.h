@@ -197,22 +197,19 @@ public:
     /// Iterates through the libray handles and calls the callouts associated
     /// with the given hook index.
     ///
-    /// @note This method invalidates the current library index set with
-    ///       setLibraryIndex().
+    /// The current hook and library indexes are set in the callout handle
+    /// rather than in this object, so the server may call this method from
+    /// several threads at the same time, each with its own callout handle,
+    /// e.g. when processing packets concurrently.  The callouts of the
+    /// loaded libraries must be thread safe in such case.  The dynamic
+    /// registration and deregistration of callouts is not: it must not be
+    /// used while other threads may be calling the callouts.
     ///
     /// @param hook_index Index of the hook to call.
     /// @param callout_handle Reference to the CalloutHandle object for the
     ///        current object being processed.
     void callCallouts(int hook_index, CalloutHandle& callout_handle);
 
-    /// @brief Get current hook index
-    ///
-    /// Made available during callCallouts, this is the index of the hook
-    /// on which callouts are being called.
-    int getHookIndex() const {
-        return (current_hook_);
-    }
-
     /// @brief Get number of libraries
     ///
     /// Returns the number of libraries that this CalloutManager is expected
@@ -225,14 +222,11 @@ public:
 
     /// @brief Get current library index
     ///
-    /// Returns the index of the "current" library.  This the index associated
-    /// with the currently executing callout when callCallouts is executing.
-    /// When callCallouts() is not executing (as is the case when the load()
-    /// function in a user-library is called during the library load process),
-    /// the index can be set by setLibraryIndex().
-    ///
-    /// @note The value set by this method is lost after a call to
-    ///       callCallouts.
+    /// Returns the index of the "current" library.  This is the index used
+    /// by the callout registration methods, set by setLibraryIndex() (as is
+    /// done when the load() function in a user-library is called during the
+    /// library load process).  The index of the library of the currently
+    /// executing callout is held in the callout handle instead.
     ///
     /// @return Current library index.
     int getLibraryIndex() const {
@@ -345,11 +339,6 @@ private:
     /// a reference instead of accessing the singleton within the code.
     ServerHooks& server_hooks_;
 
-    /// Current hook.  When a call is made to callCallouts, this holds the
-    /// index of the current hook.  It is set to an invalid value (-1)
-    /// otherwise.
-    int current_hook_;
-
     /// Current library index.  When a call is made to any of the callout
     /// registration methods, this variable indicates the index of the user
     /// library that should be associated with the call.
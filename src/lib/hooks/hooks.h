@@ -21,8 +21,9 @@
 
 namespace {
 
-// Version 1 of the hooks framework.
-const int BIND10_HOOKS_VERSION = 1;
+// Version 2 of the hooks framework.  The layout of the CalloutHandle
+// changed in this version.
+const int BIND10_HOOKS_VERSION = 2;
 
 // Names of the framework functions.
 const char* const LOAD_FUNCTION_NAME = "load";
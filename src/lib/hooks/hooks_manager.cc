@@ -165,6 +165,13 @@ HooksManager::registerHook(const std::string& name) {
     return (ServerHooks::getServerHooks().registerHook(name));
 }
 
+// Shell around ServerHooks::registerArgument()
+
+int
+HooksManager::registerArgument(const std::string& name) {
+    return (ServerHooks::getServerHooks().registerArgument(name));
+}
+
 // Return pre- and post- library handles.
 
 isc::hooks::LibraryHandle&
@@ -171,6 +171,18 @@ public:
     ///         registered.
     static int registerHook(const std::string& name);
 
+    /// @brief Register Callout Argument
+    ///
+    /// This is just a convenience shell around the
+    /// ServerHooks::registerArgument() method.  The returned index is passed
+    /// to the CalloutHandle::setArgument() and CalloutHandle::getArgument()
+    /// methods, which then don't need to look up the argument name.
+    ///
+    /// @param name Name of the argument
+    ///
+    /// @return Index of the argument.
+    static int registerArgument(const std::string& name);
+
     /// @brief Return list of loaded libraries
     ///
     /// Returns the names of the loaded libraries.
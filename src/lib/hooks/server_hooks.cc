@@ -15,12 +15,14 @@
 #include <exceptions/exceptions.h>
 #include <hooks/hooks_log.h>
 #include <hooks/server_hooks.h>
+#include <util/threads/sync.h>
 
 #include <utility>
 #include <vector>
 
 using namespace std;
 using namespace isc;
+using namespace isc::util::thread;
 
 namespace isc {
 namespace hooks {
@@ -37,10 +39,13 @@ namespace hooks {
 // point, the logging system is not initialized, so messages are unable to
 // be output.
 
-ServerHooks::ServerHooks() {
+ServerHooks::ServerHooks() : arguments_mutex_(new RWMutex()) {
     initialize();
 }
 
+ServerHooks::~ServerHooks() {
+}
+
 // Register a hook.  The index assigned to the hook is the current number
 // of entries in the collection, so ensuring that hook indexes are unique
 // and non-negative.
@@ -146,6 +151,51 @@ ServerHooks::getHookNames() const {
     return (names);
 }
 
+// Register an argument.  Unlike hooks, arguments may be registered more than
+// once, by the server and by the libraries using the same argument.
+
+int
+ServerHooks::registerArgument(const string& name) {
+    const int found = findArgument(name);
+    if (found >= 0) {
+        return (found);
+    }
+
+    // Check again under the exclusive lock, as another thread may have
+    // registered the same name in the meantime.
+    RWMutex::Locker locker(*arguments_mutex_);
+    HookCollection::const_iterator i = arguments_.find(name);
+    if (i != arguments_.end()) {
+        return (i->second);
+    }
+
+    int index = argument_names_.size();
+    arguments_.insert(make_pair(name, index));
+    argument_names_.push_back(name);
+    return (index);
+}
+
+// Find the index associated with an argument name.
+
+int
+ServerHooks::findArgument(const string& name) const {
+    RWMutex::ReaderLocker locker(*arguments_mutex_);
+    HookCollection::const_iterator i = arguments_.find(name);
+    return (i == arguments_.end() ? -1 : i->second);
+}
+
+// Find the name associated with an argument index.
+
+string
+ServerHooks::getArgumentName(int index) const {
+    RWMutex::ReaderLocker locker(*arguments_mutex_);
+    if ((index < 0) || (index >= static_cast<int>(argument_names_.size()))) {
+        isc_throw(OutOfRange, "argument index " << index
+                  << " is not recognised");
+    }
+    return (argument_names_[index]);
+}
+
 // Return global ServerHooks object
 
 ServerHooks&
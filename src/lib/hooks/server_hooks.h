@@ -18,12 +18,19 @@
 #include <exceptions/exceptions.h>
 
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <map>
 #include <string>
 #include <vector>
 
 namespace isc {
+namespace util {
+namespace thread {
+class RWMutex;
+}
+}
+
 namespace hooks {
 
 /// @brief Duplicate hook
@@ -75,7 +82,8 @@ public:
     /// Resets the collection of hooks to the initial state, with just the
     /// context_create and context_destroy hooks set.  This used during
     /// testing to reset the global ServerHooks object; it should never be
-    /// used in production.
+    /// used in production.  The registered argument names are not affected,
+    /// as their indexes may be held by the code using them.
     ///
     /// @throws isc::Unexpected if the registration of the pre-defined hooks
     ///         fails in some way.
@@ -134,6 +142,45 @@ public:
     /// @return Vector of strings holding hook names.
     std::vector<std::string> getHookNames() const;
 
+    /// @brief Register callout argument
+    ///
+    /// Registers the name of an argument passed to the callouts and
+    /// returns the index of the argument.  The CalloutHandle holds the
+    /// arguments in the slots identified by these indexes, so the code
+    /// which resolves the index once (typically when the server starts or
+    /// when the library is loaded) can access the argument without looking
+    /// up its name.  Unlike hooks, the same argument name may be
+    /// registered many times: the index assigned when the name was first
+    /// registered is returned.
+    ///
+    /// The argument names may be registered while other threads are
+    /// calling the callouts (e.g. when a callout sets an argument by a
+    /// name not used before), so the argument collection is protected by
+    /// a lock.  The lookups only take it shared.
+    ///
+    /// @param name Name of the argument
+    ///
+    /// @return Index of the argument.  This is greater than or equal to
+    ///         zero.
+    int registerArgument(const std::string& name);
+
+    /// @brief Find callout argument
+    ///
+    /// @param name Name of the argument
+    ///
+    /// @return Index of the argument or -1 if the argument name hasn't been
+    ///         registered.
+    int findArgument(const std::string& name) const;
+
+    /// @brief Get callout argument name
+    ///
+    /// @param index Index of the argument
+    ///
+    /// @return Name of the argument.
+    ///
+    /// @throw isc::OutOfRange if the index is unknown.
+    std::string getArgumentName(int index) const;
+
     /// @brief Return ServerHooks object
     ///
     /// Returns the global ServerHooks object.
@@ -157,6 +204,9 @@ private:
     ///         fails in some way.
     ServerHooks();
 
+    /// @brief Destructor
+    ~ServerHooks();
+
     /// @brief Initialize hooks
     ///
     /// Sets the collection of hooks to the initial state, with just the
@@ -175,6 +225,13 @@ private:
     /// simpler than using a multi-indexed container.)
     HookCollection  hooks_;                 ///< Hook name/index collection
     InverseHookCollection inverse_hooks_;   ///< Hook index/name collection
+
+    /// Argument name/index collection
+    HookCollection arguments_;
+    /// Argument names, indexed by the argument index
+    std::vector<std::string> argument_names_;
+    /// Lock protecting the argument names and indexes
+    boost::scoped_ptr<isc::util::thread::RWMutex> arguments_mutex_;
 };
 
 } // namespace util
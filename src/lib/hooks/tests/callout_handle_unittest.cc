@@ -21,11 +21,46 @@
 
 #include <gtest/gtest.h>
 
+#include <new>
+#include <stdlib.h>
+
 using namespace isc::hooks;
 using namespace std;
 
 namespace {
 
+/// Set while the allocations are counted.
+bool count_allocations = false;
+
+/// Number of the allocations made while counting.
+size_t allocation_count = 0;
+
+}
+
+// The global operator new is replaced so as the tests can check that the
+// handle doesn't allocate memory when the arguments are set again.
+
+void*
+operator new(size_t size) throw(std::bad_alloc) {
+    if (count_allocations) {
+        ++allocation_count;
+    }
+    void* p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return (p);
+}
+
+void
+operator delete(void* p) throw() {
+    if (p != NULL) {
+        free(p);
+    }
+}
+
+namespace {
+
 /// @file
 /// @brief Holds the CalloutHandle argument tests
 ///
@@ -307,6 +342,112 @@ TEST_F(CalloutHandleTest, DeleteAllArguments) {
     EXPECT_THROW(handle.getArgument("four", value), NoSuchArgument);
 }
 
+// Test that the arguments can be accessed using the registered indexes and
+// that they are the same arguments as those accessed by name.
+
+TEST_F(CalloutHandleTest, ArgumentIndex) {
+    CalloutHandle handle(getCalloutManager());
+
+    ServerHooks& hooks = ServerHooks::getServerHooks();
+    const int one_index = hooks.registerArgument("one");
+    const int two_index = hooks.registerArgument("two");
+    EXPECT_NE(one_index, two_index);
+
+    int value = 0;
+    handle.setArgument(one_index, 1);
+    handle.setArgument("two", 2);
+
+    handle.getArgument("one", value);
+    EXPECT_EQ(1, value);
+    handle.getArgument(two_index, value);
+    EXPECT_EQ(2, value);
+
+    // The argument which is registered but not set is not present.
+    const int three_index = hooks.registerArgument("three");
+    EXPECT_THROW(handle.getArgument(three_index, value), NoSuchArgument);
+    EXPECT_THROW(handle.getArgument("three", value), NoSuchArgument);
+
+    // The type of the argument is checked.
+    long lvalue;
+    EXPECT_THROW(handle.getArgument(one_index, lvalue), boost::bad_any_cast);
+
+    // The invalid index is reported.
+    EXPECT_THROW(handle.getArgument(-1, value), NoSuchArgument);
+    EXPECT_THROW(handle.setArgument(-1, value), NoSuchArgument);
+}
+
+// Test that the arguments deleted with deleteAllArguments can be set again,
+// also with a value of a different type, and that they are released when
+// deleted individually.
+
+TEST_F(CalloutHandleTest, ArgumentReuse) {
+    CalloutHandle handle(getCalloutManager());
+
+    boost::shared_ptr<int> one(new int(1));
+    boost::shared_ptr<int> value;
+    handle.setArgument("one", one);
+    handle.deleteAllArguments();
+    EXPECT_THROW(handle.getArgument("one", value), NoSuchArgument);
+
+    // The handle doesn't hold the deleted value.
+    EXPECT_TRUE(one.unique());
+
+    boost::shared_ptr<int> two(new int(2));
+    handle.setArgument("one", two);
+    handle.getArgument("one", value);
+    EXPECT_EQ(two, value);
+    value.reset();
+
+    // The argument of a different type replaces the value.
+    handle.deleteAllArguments();
+    handle.setArgument("one", string("one"));
+    string svalue;
+    handle.getArgument("one", svalue);
+    EXPECT_EQ("one", svalue);
+    EXPECT_TRUE(two.unique());
+
+    // Only the names of the arguments which are set are returned.
+    handle.setArgument("two", 2);
+    handle.deleteArgument("one");
+    vector<string> names = handle.getArgumentNames();
+    ASSERT_EQ(1, names.size());
+    EXPECT_EQ("two", names[0]);
+}
+
+// Test that the arguments set again after deleteAllArguments, as the servers
+// do for each packet, reuse the holders of the deleted values.
+
+TEST_F(CalloutHandleTest, ArgumentReuseAllocations) {
+    CalloutHandle handle(getCalloutManager());
+
+    ServerHooks& hooks = ServerHooks::getServerHooks();
+    const int one_index = hooks.registerArgument("one");
+    const int two_index = hooks.registerArgument("two");
+
+    // The slots and the holders are allocated when the arguments are set
+    // for the first time.
+    boost::shared_ptr<int> one(new int(1));
+    handle.setArgument(one_index, one);
+    handle.setArgument(two_index, true);
+    handle.deleteAllArguments();
+    EXPECT_TRUE(one.unique());
+
+    allocation_count = 0;
+    count_allocations = true;
+    for (int i = 0; i < 10; ++i) {
+        handle.setArgument(one_index, one);
+        handle.setArgument(two_index, false);
+        handle.deleteAllArguments();
+    }
+    count_allocations = false;
+    EXPECT_EQ(0, allocation_count);
+
+    // The deleted values are still released.
+    EXPECT_TRUE(one.unique());
+    boost::shared_ptr<int> value;
+    EXPECT_THROW(handle.getArgument(one_index, value), NoSuchArgument);
+}
+
 // Test the "skip" flag.
 
 TEST_F(CalloutHandleTest, SkipFlag) {
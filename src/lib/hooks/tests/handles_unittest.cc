@@ -970,5 +970,34 @@ TEST_F(HandlesTest, HookName) {
     EXPECT_EQ(std::string("gamma"), HandlesTest::common_string_);
 }
 
+// Test that the current hook is held by the CalloutHandle, so the callouts
+// called with another handle (e.g. by another thread) don't change it.
+
+int
+callout_nested_hook_name(CalloutHandle& callout_handle) {
+    boost::shared_ptr<CalloutManager> manager;
+    callout_handle.getArgument("manager", manager);
+
+    CalloutHandle other_handle(manager);
+    manager->callCallouts(ServerHooks::getServerHooks().getIndex("beta"),
+                          other_handle);
+    HandlesTest::common_string_ += callout_handle.getHookName();
+    return (0);
+}
+
+TEST_F(HandlesTest, HookNameOtherHandle) {
+    getCalloutManager()->setLibraryIndex(1);
+    getCalloutManager()->registerCallout("alpha", callout_nested_hook_name);
+    getCalloutManager()->registerCallout("beta", callout_hook_name);
+
+    CalloutHandle callout_handle(getCalloutManager());
+    callout_handle.setArgument("manager", getCalloutManager());
+    getCalloutManager()->callCallouts(alpha_index_, callout_handle);
+    EXPECT_EQ(std::string("betaalpha"), HandlesTest::common_string_);
+
+    // The hook is not set outside of the callouts.
+    EXPECT_EQ(std::string(""), callout_handle.getHookName());
+}
+
 } // Anonymous namespace
 
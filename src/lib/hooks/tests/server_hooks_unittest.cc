@@ -13,15 +13,20 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <hooks/server_hooks.h>
+#include <util/threads/thread.h>
 
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <sstream>
 #include <string>
 #include <vector>
 
 using namespace isc;
 using namespace isc::hooks;
+using namespace isc::util::thread;
 using namespace std;
 
 namespace {
@@ -159,6 +164,71 @@ TEST(ServerHooksTest, UnknownHookName) {
     EXPECT_THROW(static_cast<void>(hooks.getIndex("unknown")), NoSuchHook);
 }
 
+// Check that the arguments can be registered many times and that they are
+// not affected by the reset.
+
+TEST(ServerHooksTest, RegisterArguments) {
+    ServerHooks& hooks = ServerHooks::getServerHooks();
+
+    EXPECT_EQ(-1, hooks.findArgument("test_argument_alpha"));
+    int alpha = hooks.registerArgument("test_argument_alpha");
+    int beta = hooks.registerArgument("test_argument_beta");
+    EXPECT_GE(alpha, 0);
+    EXPECT_NE(alpha, beta);
+
+    EXPECT_EQ(alpha, hooks.registerArgument("test_argument_alpha"));
+    EXPECT_EQ(alpha, hooks.findArgument("test_argument_alpha"));
+    EXPECT_EQ("test_argument_beta", hooks.getArgumentName(beta));
+
+    hooks.reset();
+    EXPECT_EQ(beta, hooks.findArgument("test_argument_beta"));
+
+    EXPECT_THROW(hooks.getArgumentName(-1), isc::OutOfRange);
+    EXPECT_THROW(hooks.getArgumentName(beta + 1000), isc::OutOfRange);
+}
+
+// Registers the argument names used by the RegisterArgumentsThreads test,
+// storing the indexes returned.
+
+void
+registerArguments(vector<int>* indexes) {
+    ServerHooks& hooks = ServerHooks::getServerHooks();
+    for (int i = 0; i < indexes->size(); ++i) {
+        ostringstream name;
+        name << "test_argument_thread_" << i;
+        (*indexes)[i] = hooks.registerArgument(name.str());
+    }
+}
+
+// Check that the arguments registered at the same time by several threads
+// are assigned the same indexes.
+
+TEST(ServerHooksTest, RegisterArgumentsThreads) {
+    const int THREADS = 4;
+    const int ARGUMENTS = 100;
+    vector<vector<int> > indexes(THREADS, vector<int>(ARGUMENTS, -1));
+    vector<boost::shared_ptr<Thread> > threads;
+    for (int i = 0; i < THREADS; ++i) {
+        threads.push_back(boost::shared_ptr<Thread>(
+            new Thread(boost::bind(&registerArguments, &indexes[i]))));
+    }
+    for (int i = 0; i < THREADS; ++i) {
+        threads[i]->wait();
+    }
+
+    ServerHooks& hooks = ServerHooks::getServerHooks();
+    for (int i = 0; i < ARGUMENTS; ++i) {
+        ostringstream name;
+        name << "test_argument_thread_" << i;
+        const int index = hooks.findArgument(name.str());
+        ASSERT_GE(index, 0);
+        EXPECT_EQ(name.str(), hooks.getArgumentName(index));
+        for (int j = 0; j < THREADS; ++j) {
+            EXPECT_EQ(index, indexes[j][i]);
+        }
+    }
+}
+
 // Check that the count of hooks is correct.
 
 TEST(ServerHooksTest, HookCount) {
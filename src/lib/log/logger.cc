@@ -17,6 +17,7 @@
 
 #include <log/logger.h>
 #include <log/logger_impl.h>
+#include <log/logger_manager.h>
 #include <log/logger_name.h>
 #include <log/logger_support.h>
 #include <log/message_dictionary.h>
@@ -30,9 +31,18 @@ namespace isc {
 namespace log {
 
 // Initialize underlying logger, but only if logging has been initialized.
-void Logger::initLoggerImpl() {
+// Several threads may use the logger for the first time at once, so the
+// implementation is created under the logging mutex, by the first of them.
+// The pointer is only published once the implementation is constructed.
+LoggerImpl* Logger::initLoggerImpl() {
     if (isLoggingInitialized()) {
-        loggerptr_ = new LoggerImpl(name_);
+        isc::util::thread::Mutex::Locker locker(LoggerManager::getMutex());
+        LoggerImpl* loggerptr = loggerptr_.load();
+        if (!loggerptr) {
+            loggerptr = new LoggerImpl(name_);
+            loggerptr_.store(loggerptr);
+        }
+        return (loggerptr);
     } else {
         isc_throw(LoggingNotInitialized, "attempt to access logging function "
                   "before logging has been initialized");
@@ -42,12 +52,12 @@ void Logger::initLoggerImpl() {
 // Destructor.
 
 Logger::~Logger() {
-    delete loggerptr_;
+    delete loggerptr_.load();
 
     // The next statement is required for the BIND 10 hooks framework, where
     // a statically-linked BIND 10 loads and unloads multiple libraries. See
     // the hooks documentation for more details.
-    loggerptr_ = 0;
+    loggerptr_.store(NULL);
 }
 
 // Get Name of Logger
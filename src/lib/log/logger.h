@@ -24,6 +24,7 @@
 #include <log/logger_level.h>
 #include <log/message_types.h>
 #include <log/log_formatter.h>
+#include <util/threads/atomic.h>
 
 namespace isc {
 namespace log {
@@ -309,18 +310,32 @@ private:
     /// regardless of whether is is statically or automatically declared -  will
     /// cause a "LoggingNotInitialized" exception to be thrown.
     ///
+    /// The implementation is created once, even if several threads use the
+    /// logger for the first time at the same time (see \c initLoggerImpl).
+    /// The pointer is loaded with the acquire semantics, so a thread which
+    /// gets the pointer set by another thread also sees the implementation
+    /// fully constructed.
+    ///
     /// \return Returns pointer to implementation
     LoggerImpl* getLoggerPtr() {
-        if (!loggerptr_) {
-            initLoggerImpl();
+        LoggerImpl* loggerptr = loggerptr_.load();
+        if (!loggerptr) {
+            loggerptr = initLoggerImpl();
         }
-        return (loggerptr_);
+        return (loggerptr);
     }
 
     /// \brief Initialize Underlying Implementation and Set loggerptr_
-    void initLoggerImpl();
+    ///
+    /// The pointer is set under the logging mutex, unless another thread
+    /// has set it in the meantime. It is stored with the release semantics
+    /// after the implementation has been constructed.
+    ///
+    /// \return Returns pointer to implementation
+    LoggerImpl* initLoggerImpl();
 
-    LoggerImpl* loggerptr_;                  ///< Pointer to underlying logger
+    /// Pointer to underlying logger
+    isc::util::thread::Atomic<LoggerImpl*> loggerptr_;
     char        name_[MAX_LOGGER_NAME_SIZE + 1]; ///< Copy of the logger name
 };
 
@@ -14,6 +14,7 @@
 
 #include <server_common/keyring.h>
 #include <server_common/logger.h>
+#include <util/threads/sync.h>
 
 using namespace isc::dns;
 using namespace isc::data;
@@ -27,6 +28,13 @@ KeyringPtr keyring;
 
 namespace {
 
+// Protects the replacement of the keyring against copyKeyring().
+isc::util::thread::Mutex&
+getKeyringMutex() {
+    static isc::util::thread::Mutex mutex;
+    return (mutex);
+}
+
 void
 updateKeyring(const std::string&, ConstElementPtr data,
               const isc::config::ConfigData&) {
@@ -41,6 +49,7 @@ updateKeyring(const std::string&, ConstElementPtr data,
     for (size_t i(0); list && i < list->size(); ++ i) {
         load->add(TSIGKey(list->get(i)->stringValue()));
     }
+    isc::util::thread::Mutex::Locker locker(getKeyringMutex());
     keyring.swap(load);
 }
 
@@ -63,9 +72,18 @@ deinitKeyring(config::ModuleCCSession& session) {
         return;
     }
     LOG_DEBUG(logger, DBG_TRACE_BASIC, SRVCOMM_KEYS_DEINIT);
-    keyring.reset();
+    {
+        isc::util::thread::Mutex::Locker locker(getKeyringMutex());
+        keyring.reset();
+    }
     session.removeRemoteConfig("tsig_keys");
 }
 
+KeyringPtr
+copyKeyring(const KeyringPtr& ring) {
+    isc::util::thread::Mutex::Locker locker(getKeyringMutex());
+    return (ring);
+}
+
 }
 }
@@ -35,7 +35,9 @@
  * If you want to keep a key (or session) for longer time or your application
  * is multithreaded, you might want to have a copy of the shared pointer to
  * hold a reference. Otherwise an update might replace the keyring and delete
- * the keys in the old one.
+ * the keys in the old one. The updates are done in the thread handling the
+ * configuration session, so the other threads must take the copy with
+ * copyKeyring.
  *
  * Also note that, while the interface doesn't prevent application from
  * modifying the keyring, it is not a good idea to do so. As mentioned above,
@@ -96,6 +98,21 @@ initKeyring(config::ModuleCCSession& session);
 void
 deinitKeyring(config::ModuleCCSession& session);
 
+/**
+ * \brief Copy a pointer to the key ring
+ *
+ * This returns a copy of the given pointer, taken under the same lock as the
+ * one under which keyring is replaced by the configuration updates, so it
+ * can be safely called from another thread than the one handling the
+ * configuration session. The returned key ring is kept alive by the copy
+ * even if keyring is replaced in the meantime.
+ *
+ * \param ring The pointer to copy, normally keyring itself.
+ * \return The copy of ring.
+ */
+boost::shared_ptr<dns::TSIGKeyRing>
+copyKeyring(const boost::shared_ptr<dns::TSIGKeyRing>& ring);
+
 }
 }
 
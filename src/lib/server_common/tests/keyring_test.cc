@@ -115,6 +115,25 @@ TEST_F(KeyringTest, keyringWithDefault) {
     deinitKeyring(*mccs);
 }
 
+// A copy taken by copyKeyring keeps the old keys after an update.
+TEST_F(KeyringTest, copyKeyring) {
+    doInit();
+    const boost::shared_ptr<TSIGKeyRing> copy(copyKeyring(keyring));
+    EXPECT_EQ(keyring, copy);
+
+    session.addMessage(createCommand("config_update", Element::fromJSON(
+        "{\"keys\": [\"another:MTIzNAo=:hmac-sha256\"]}")),
+                       "tsig_keys", "*");
+    mccs->checkCommand();
+    EXPECT_NE(keyring, copy);
+    EXPECT_EQ(TSIGKeyRing::SUCCESS,
+              copy->find(Name("key"), TSIGKey::HMACSHA1_NAME()).code);
+    EXPECT_EQ(TSIGKeyRing::SUCCESS,
+              copyKeyring(keyring)->find(Name("another"),
+                                         TSIGKey::HMACSHA256_NAME()).code);
+    deinitKeyring(*mccs);
+}
+
 // Init twice
 TEST_F(KeyringTest, initTwice) {
     // It is NULL before
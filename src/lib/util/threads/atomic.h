@@ -0,0 +1,67 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef B10_THREAD_ATOMIC_H
+#define B10_THREAD_ATOMIC_H
+
+#include <boost/noncopyable.hpp>
+
+namespace isc {
+namespace util {
+namespace thread {
+
+/// \brief A value shared by several threads without a lock.
+///
+/// The value is loaded and stored atomically. A store has the release
+/// semantics and a load has the acquire semantics: a thread which loads
+/// the value stored by another thread also sees all the writes made by that
+/// thread before the store. This makes it possible to publish an object
+/// created by one thread to the others through a pointer, or to signal
+/// them with a flag, without taking a mutex on each access.
+///
+/// The implementation uses the atomic builtins of the compiler (available
+/// in GCC 4.7 and clang 3.1 or later).
+///
+/// \tparam T Type of the value. It must be an integral or a pointer type.
+template <typename T>
+class Atomic : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \param value Initial value.
+    explicit Atomic(const T value = T()) :
+        value_(value)
+    {}
+
+    /// \brief Returns the value (with the acquire semantics).
+    T load() const {
+        return (__atomic_load_n(&value_, __ATOMIC_ACQUIRE));
+    }
+
+    /// \brief Sets the value (with the release semantics).
+    ///
+    /// \param value New value.
+    void store(const T value) {
+        __atomic_store_n(&value_, value, __ATOMIC_RELEASE);
+    }
+
+private:
+    T value_;
+};
+
+} // namespace thread
+} // namespace util
+} // namespace isc
+
+#endif
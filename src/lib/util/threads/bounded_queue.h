@@ -0,0 +1,247 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef B10_THREAD_BOUNDED_QUEUE_H
+#define B10_THREAD_BOUNDED_QUEUE_H
+
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace isc {
+namespace util {
+namespace thread {
+
+/// \brief A queue of limited capacity used to pass items between threads.
+///
+/// Any number of threads may put items into the queue and take them out.
+/// The producers are never blocked: when the queue is full, \c push()
+/// fails and the producer decides what to do with the item (e.g. a server
+/// drops a packet it has no capacity to process, just like the kernel would
+/// if the socket buffer was full). The consumers block in \c pop() until
+/// an item is available or the queue is closed.
+///
+/// The queue also keeps track of the items which have been taken out,
+/// but not yet processed. A consumer calls \c done() when it's finished
+/// with an item, and \c waitIdle() returns once all items put into the
+/// queue have been processed. This allows a producer to wait for the
+/// consumers to become idle, e.g. before it reconfigures the data they
+/// use.
+///
+/// \tparam T Type of the items. It must be copyable and default
+/// constructible; typically it is a shared pointer.
+template <typename T>
+class BoundedQueue : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \param capacity Maximum number of items held in the queue.
+    ///
+    /// \throw isc::InvalidParameter if the capacity is 0.
+    explicit BoundedQueue(const size_t capacity) :
+        capacity_(capacity), pending_(0), closed_(false)
+    {
+        if (capacity_ == 0) {
+            isc_throw(isc::InvalidParameter,
+                      "capacity of the queue must be greater than 0");
+        }
+    }
+
+    /// \brief Puts an item at the end of the queue.
+    ///
+    /// This method never blocks.
+    ///
+    /// \param item Item to be added.
+    ///
+    /// \return true if the item has been added, false if the queue is full
+    /// or closed.
+    bool push(const T& item) {
+        Mutex::Locker locker(mutex_);
+        if (closed_ || (items_.size() >= capacity_)) {
+            return (false);
+        }
+        items_.push_back(item);
+        ++pending_;
+        not_empty_.signal();
+        return (true);
+    }
+
+    /// \brief Takes an item from the front of the queue.
+    ///
+    /// Blocks until an item is available or the queue is closed. The items
+    /// put into the queue before it was closed are still returned.
+    ///
+    /// \param [out] item Item taken from the queue.
+    ///
+    /// \return true if an item has been taken, false if the queue has been
+    /// closed and there are no more items in it.
+    bool pop(T& item) {
+        Mutex::Locker locker(mutex_);
+        while (items_.empty() && !closed_) {
+            not_empty_.wait(mutex_);
+        }
+        if (items_.empty()) {
+            return (false);
+        }
+        item = items_.front();
+        items_.pop_front();
+        return (true);
+    }
+
+    /// \brief Takes up to the specified number of items from the front of
+    /// the queue.
+    ///
+    /// Blocks until at least one item is available or the queue is closed,
+    /// then takes all items available at the time, but no more than
+    /// \c max_items. It lets a consumer process the items which piled up
+    /// while it was busy in one go.
+    ///
+    /// \param [out] items Items taken from the queue are appended to this
+    /// vector.
+    /// \param max_items Maximum number of items to be taken.
+    ///
+    /// \return Number of items taken, 0 if the queue has been closed and
+    /// there are no more items in it.
+    size_t popBatch(std::vector<T>& items, const size_t max_items) {
+        Mutex::Locker locker(mutex_);
+        while (items_.empty() && !closed_) {
+            not_empty_.wait(mutex_);
+        }
+        size_t count = 0;
+        while (!items_.empty() && (count < max_items)) {
+            items.push_back(items_.front());
+            items_.pop_front();
+            ++count;
+        }
+        return (count);
+    }
+
+    /// \brief Takes up to the specified number of items from the front of
+    /// the queue, waiting for them for the limited time.
+    ///
+    /// Works like the other \c popBatch(), but it returns once the
+    /// specified time has elapsed even if no item is available.  The
+    /// timeout of 0 means that the items available at the time are taken
+    /// without waiting.
+    ///
+    /// \param [out] items Items taken from the queue are appended to this
+    /// vector.
+    /// \param max_items Maximum number of items to be taken.
+    /// \param timeout_usec Maximum time to wait for items, in microseconds.
+    ///
+    /// \return Number of items taken, 0 if the time has elapsed or the
+    /// queue has been closed and there are no more items in it.
+    size_t popBatch(std::vector<T>& items, const size_t max_items,
+                    const uint32_t timeout_usec) {
+        Mutex::Locker locker(mutex_);
+        if (items_.empty() && !closed_ && (timeout_usec > 0)) {
+            // Spurious wakeups only shorten the wait, the caller is
+            // expected to call this again if it has nothing to do.
+            not_empty_.timedWait(mutex_, timeout_usec);
+        }
+        size_t count = 0;
+        while (!items_.empty() && (count < max_items)) {
+            items.push_back(items_.front());
+            items_.pop_front();
+            ++count;
+        }
+        return (count);
+    }
+
+    /// \brief Indicates that items taken from the queue have been processed.
+    ///
+    /// Must be called once for each item taken out by \c pop() or
+    /// \c popBatch().
+    ///
+    /// \param count Number of the processed items.
+    void done(const size_t count = 1) {
+        Mutex::Locker locker(mutex_);
+        if (pending_ > 0) {
+            pending_ = (count < pending_ ? pending_ - count : 0);
+            if (pending_ == 0) {
+                idle_.broadcast();
+            }
+        }
+    }
+
+    /// \brief Waits until all items put into the queue have been processed.
+    ///
+    /// There must be a consumer taking the items out of the queue, or this
+    /// method blocks forever.
+    void waitIdle() {
+        Mutex::Locker locker(mutex_);
+        while (pending_ > 0) {
+            idle_.wait(mutex_);
+        }
+    }
+
+    /// \brief Closes the queue.
+    ///
+    /// No more items can be put into the queue, and all consumers are woken
+    /// up so as they can exit once the queue is drained.
+    void close() {
+        Mutex::Locker locker(mutex_);
+        closed_ = true;
+        not_empty_.broadcast();
+    }
+
+    /// \brief Checks if the queue has been closed.
+    bool isClosed() const {
+        Mutex::Locker locker(mutex_);
+        return (closed_);
+    }
+
+    /// \brief Returns the number of items held in the queue.
+    size_t size() const {
+        Mutex::Locker locker(mutex_);
+        return (items_.size());
+    }
+
+    /// \brief Returns the maximum number of items held in the queue.
+    size_t getCapacity() const {
+        return (capacity_);
+    }
+
+private:
+    /// \brief Mutex protecting all members.
+    mutable Mutex mutex_;
+
+    /// \brief Signalled when an item is added or the queue is closed.
+    CondVar not_empty_;
+
+    /// \brief Signalled when the last pending item has been processed.
+    CondVar idle_;
+
+    /// \brief Items held in the queue.
+    std::deque<T> items_;
+
+    /// \brief Maximum number of items held in the queue.
+    const size_t capacity_;
+
+    /// \brief Number of items added and not yet processed.
+    size_t pending_;
+
+    /// \brief Indicates if the queue has been closed.
+    bool closed_;
+};
+
+} // namespace thread
+} // namespace util
+} // namespace isc
+
+#endif // B10_THREAD_BOUNDED_QUEUE_H
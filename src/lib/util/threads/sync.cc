@@ -24,6 +24,7 @@
 #include <cassert>
 
 #include <pthread.h>
+#include <time.h>
 
 using std::auto_ptr;
 
@@ -246,6 +247,37 @@ CondVar::wait(Mutex& mutex) {
     }
 }
 
+bool
+CondVar::timedWait(Mutex& mutex, const uint32_t timeout_usec) {
+    // The timeout of pthread_cond_timedwait() is the absolute time of the
+    // clock used by the condition variable, which is the system clock.
+    struct timespec due;
+    clock_gettime(CLOCK_REALTIME, &due);
+    due.tv_sec += timeout_usec / 1000000;
+    due.tv_nsec += (timeout_usec % 1000000) * 1000;
+    if (due.tv_nsec >= 1000000000) {
+        ++due.tv_sec;
+        due.tv_nsec -= 1000000000;
+    }
+#ifdef ENABLE_DEBUG
+    mutex.preUnlockAction(true);    // Only in debug mode
+    const int result = pthread_cond_timedwait(&impl_->cond_,
+                                              &mutex.impl_->mutex, &due);
+    mutex.postLockAction();     // Only in debug mode
+#else
+    const int result = pthread_cond_timedwait(&impl_->cond_,
+                                              &mutex.impl_->mutex, &due);
+#endif
+    if (result == ETIMEDOUT) {
+        return (false);
+    }
+    if (result != 0) {
+        isc_throw(isc::BadValue, "pthread_cond_timedwait failed "
+                  "unexpectedly: " << std::strerror(result));
+    }
+    return (true);
+}
+
 void
 CondVar::signal() {
     const int result = pthread_cond_signal(&impl_->cond_);
@@ -255,6 +287,121 @@ CondVar::signal() {
     assert(result == 0);
 }
 
+void
+CondVar::broadcast() {
+    const int result = pthread_cond_broadcast(&impl_->cond_);
+
+    // Same as in signal(), this can only fail if cond_ is invalid.
+    assert(result == 0);
+}
+
+class RWMutex::Impl {
+public:
+    pthread_rwlock_t rwlock_;
+};
+
+namespace {
+
+struct RWLockAttrDeinitializer {
+    RWLockAttrDeinitializer(pthread_rwlockattr_t& attributes):
+        attributes_(attributes)
+    {}
+    ~RWLockAttrDeinitializer() {
+        const int result = pthread_rwlockattr_destroy(&attributes_);
+        assert(result == 0);
+    }
+    pthread_rwlockattr_t& attributes_;
+};
+
+}
+
+RWMutex::RWMutex() :
+    impl_(NULL)
+{
+    pthread_rwlockattr_t attributes;
+    int result = pthread_rwlockattr_init(&attributes);
+    switch (result) {
+        case 0: // All 0K
+            break;
+        case ENOMEM:
+            throw std::bad_alloc();
+        default:
+            isc_throw(isc::InvalidOperation, std::strerror(result));
+    }
+    RWLockAttrDeinitializer deinitializer(attributes);
+
+    // By default, the glibc read-write locks let new readers in as long as
+    // the lock is held shared, so a writer may wait forever on a busy
+    // server.  Prefer the writers where we can.
+#ifdef PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP
+    result = pthread_rwlockattr_setkind_np(&attributes,
+        PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    if (result != 0) {
+        isc_throw(isc::InvalidOperation, std::strerror(result));
+    }
+#endif
+
+    auto_ptr<Impl> impl(new Impl);
+    result = pthread_rwlock_init(&impl->rwlock_, &attributes);
+    switch (result) {
+        case 0: // All 0K
+            impl_ = impl.release();
+            break;
+        case ENOMEM:
+        case EAGAIN:
+            throw std::bad_alloc();
+        default:
+            isc_throw(isc::InvalidOperation, std::strerror(result));
+    }
+}
+
+RWMutex::~RWMutex() {
+    if (impl_ != NULL) {
+        const int result = pthread_rwlock_destroy(&impl_->rwlock_);
+        delete impl_;
+        // We don't want to throw from the destructor. Also, if this ever
+        // fails, something is really screwed up a lot.
+        assert(result == 0);
+    }
+}
+
+void
+RWMutex::lock() {
+    assert(impl_ != NULL);
+    const int result = pthread_rwlock_wrlock(&impl_->rwlock_);
+    if (result != 0) {
+        isc_throw(isc::InvalidOperation, std::strerror(result));
+    }
+}
+
+bool
+RWMutex::tryLock() {
+    assert(impl_ != NULL);
+    const int result = pthread_rwlock_trywrlock(&impl_->rwlock_);
+    if (result == EBUSY || result == EDEADLK) {
+        return (false);
+    } else if (result != 0) {
+        isc_throw(isc::InvalidOperation, std::strerror(result));
+    }
+    return (true);
+}
+
+void
+RWMutex::readLock() {
+    assert(impl_ != NULL);
+    const int result = pthread_rwlock_rdlock(&impl_->rwlock_);
+    if (result != 0) {
+        isc_throw(isc::InvalidOperation, std::strerror(result));
+    }
+}
+
+void
+RWMutex::unlock() {
+    assert(impl_ != NULL);
+    const int result = pthread_rwlock_unlock(&impl_->rwlock_);
+    assert(result == 0); // This should never be possible
+}
+
 }
 }
 }
@@ -20,6 +20,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <cstdlib> // for NULL.
+#include <stdint.h>
 
 namespace isc {
 namespace util {
@@ -194,11 +195,6 @@ private:
 /// Note that \c mutex passed to the \c wait() method must be the same one
 /// used to construct the \c locker.
 ///
-/// Right now there is no equivalent to pthread_cond_broadcast() or
-/// pthread_cond_timedwait() in this class, because this class is meant
-/// for internal development of BIND 10 and we don't need these at the
-/// moment.  If and when we need these interfaces they can be added at that
-/// point.
 ///
 /// \note This class is defined as a friend class of \c Mutex and directly
 /// refers to and modifies private internals of the \c Mutex class.  It breaks
@@ -240,6 +236,23 @@ public:
     /// \param mutex A \c Mutex object to be released on wait().
     void wait(Mutex& mutex);
 
+    /// \brief Wait on the condition variable for the limited time.
+    ///
+    /// This method works like \c wait(), but it returns once the specified
+    /// time has elapsed even if the condition variable hasn't been
+    /// signalled, like \c pthread_cond_timedwait().  As with \c wait(), the
+    /// caller must check the condition it waits for when this method
+    /// returns.
+    ///
+    /// \throw isc::InvalidOperation mutex isn't locked
+    /// \throw isc::BadValue mutex is not a valid \c Mutex object
+    ///
+    /// \param mutex A \c Mutex object to be released on wait().
+    /// \param timeout_usec Maximum time to wait, in microseconds.
+    ///
+    /// \return false if the time has elapsed, true otherwise.
+    bool timedWait(Mutex& mutex, const uint32_t timeout_usec);
+
     /// \brief Unblock a thread waiting for the condition variable.
     ///
     /// This method wakes one of other threads (if any) waiting on this object
@@ -248,11 +261,138 @@ public:
     /// This method never throws; if some unexpected low level error happens
     /// it terminates the program.
     void signal();
+
+    /// \brief Unblock all threads waiting for the condition variable.
+    ///
+    /// This method works like \c signal(), but it wakes all threads
+    /// waiting on this object rather than just one of them.
+    ///
+    /// This method never throws; if some unexpected low level error happens
+    /// it terminates the program.
+    void broadcast();
 private:
     class Impl;
     Impl* impl_;
 };
 
+/// \brief Reader-writer lock with an interface similar to \c Mutex.
+///
+/// Any number of threads can hold the lock shared at the same time, which
+/// is what makes it possible for several threads to read the same data
+/// concurrently, while a thread holding it exclusive excludes all the
+/// others.  As with \c Mutex, the lock is acquired and released only by
+/// creating and destroying the locker objects.
+///
+/// The \c Locker class acquires the lock exclusive and has the same
+/// interface as \c Mutex::Locker, so as the \c RWMutex can be used in place
+/// of a \c Mutex wherever the code is templated on the mutex type.  The
+/// \c ReaderLocker class acquires it shared.
+///
+/// Where the system supports it, the threads waiting for the exclusive
+/// lock have priority over the ones waiting for the shared lock, so as a
+/// continuous stream of readers can't starve a writer.
+///
+/// The lock is not recursive: a thread must not try to acquire it while
+/// already holding it, in either mode.
+class RWMutex : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc In case allocation of something (memory, the
+    ///     OS lock) fails.
+    /// \throw isc::InvalidOperation Other unspecified errors around the lock.
+    RWMutex();
+
+    /// \brief Destructor.
+    ///
+    /// It is not allowed to destroy a lock which is currently held.
+    ~RWMutex();
+
+    /// \brief This holds the lock exclusive.
+    class Locker : boost::noncopyable {
+    public:
+        /// \brief Exception thrown when the lock is already held and
+        ///     a non-blocking locker is attempted around it.
+        struct AlreadyLocked : public isc::InvalidParameter {
+            AlreadyLocked(const char* file, size_t line, const char* what) :
+                isc::InvalidParameter(file, line, what)
+            {}
+        };
+
+        /// \brief Constructor.
+        ///
+        /// Acquires the lock exclusive. May block for extended period of
+        /// time if \c block is true.
+        ///
+        /// \throw isc::InvalidOperation when OS reports error.
+        /// \throw AlreadyLocked if \c block is false and the lock is already
+        ///     held, in either mode.
+        Locker(RWMutex& mutex, bool block = true) :
+            mutex_(mutex)
+        {
+            if (block) {
+                mutex.lock();
+            } else {
+                if (!mutex.tryLock()) {
+                    isc_throw(AlreadyLocked, "The lock is already held");
+                }
+            }
+        }
+
+        /// \brief Destructor.
+        ///
+        /// Releases the lock.
+        ~Locker() {
+            mutex_.unlock();
+        }
+    private:
+        RWMutex& mutex_;
+    };
+
+    /// \brief This holds the lock shared.
+    class ReaderLocker : boost::noncopyable {
+    public:
+        /// \brief Constructor.
+        ///
+        /// Acquires the lock shared. It blocks as long as a thread holds
+        /// it exclusive or, where supported, waits to do so.
+        ///
+        /// \throw isc::InvalidOperation when OS reports error.
+        ReaderLocker(RWMutex& mutex) :
+            mutex_(mutex)
+        {
+            mutex.readLock();
+        }
+
+        /// \brief Destructor.
+        ///
+        /// Releases the lock.
+        ~ReaderLocker() {
+            mutex_.unlock();
+        }
+    private:
+        RWMutex& mutex_;
+    };
+
+private:
+    /// \brief Acquire the lock exclusive, blocking until it is possible.
+    void lock();
+
+    /// \brief Try to acquire the lock exclusive without blocking.
+    ///
+    /// \return true if the lock was acquired, false otherwise.
+    bool tryLock();
+
+    /// \brief Acquire the lock shared, blocking until it is possible.
+    void readLock();
+
+    /// \brief Release the lock, held in either mode.
+    void unlock();
+
+    class Impl;
+    Impl* impl_;
+};
+
 } // namespace thread
 } // namespace util
 } // namespace isc
@@ -0,0 +1,70 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <util/threads/atomic.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace isc::util::thread;
+
+namespace {
+
+// The stored value is returned.
+TEST(AtomicTest, loadStore) {
+    Atomic<bool> flag;
+    EXPECT_FALSE(flag.load());
+    flag.store(true);
+    EXPECT_TRUE(flag.load());
+
+    Atomic<int> value(5);
+    EXPECT_EQ(5, value.load());
+    value.store(-7);
+    EXPECT_EQ(-7, value.load());
+}
+
+/// \brief Object published by one thread to another.
+struct Published {
+    int first_;
+    int second_;
+};
+
+/// \brief Fills in the object and publishes it.
+void
+publish(Published* object, Atomic<Published*>* pointer) {
+    object->first_ = 1;
+    object->second_ = 2;
+    pointer->store(object);
+}
+
+// The writes made before the store are seen by the thread which loads the
+// stored pointer.
+TEST(AtomicTest, publish) {
+    Published object = { 0, 0 };
+    Atomic<Published*> pointer;
+    Thread thread(boost::bind(&publish, &object, &pointer));
+
+    Published* published = NULL;
+    while ((published = pointer.load()) == NULL) {
+    }
+    EXPECT_EQ(1, published->first_);
+    EXPECT_EQ(2, published->second_);
+    thread.wait();
+}
+
+}
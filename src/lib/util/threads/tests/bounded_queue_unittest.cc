@@ -0,0 +1,175 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <util/threads/bounded_queue.h>
+#include <util/threads/thread.h>
+#include <util/unittests/check_valgrind.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace isc::util::thread;
+
+namespace {
+
+typedef BoundedQueue<int> IntQueue;
+
+// The queue can't be created with zero capacity.
+TEST(BoundedQueueTest, zeroCapacity) {
+    EXPECT_THROW(IntQueue queue(0), isc::InvalidParameter);
+}
+
+// Items are returned in order and push fails when the queue is full.
+TEST(BoundedQueueTest, pushPop) {
+    IntQueue queue(2);
+    EXPECT_EQ(2, queue.getCapacity());
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_FALSE(queue.push(3));
+    EXPECT_EQ(2, queue.size());
+
+    int item = 0;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(1, item);
+    EXPECT_TRUE(queue.push(3));
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(2, item);
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(3, item);
+    EXPECT_EQ(0, queue.size());
+}
+
+// The items put into the queue before it was closed can still be taken
+// out. Nothing can be added to the closed queue.
+TEST(BoundedQueueTest, close) {
+    IntQueue queue(4);
+    EXPECT_TRUE(queue.push(1));
+    queue.close();
+    EXPECT_TRUE(queue.isClosed());
+    EXPECT_FALSE(queue.push(2));
+
+    int item = 0;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(1, item);
+    // The queue is closed and empty, so this doesn't block.
+    EXPECT_FALSE(queue.pop(item));
+}
+
+// Waiting for the idle queue returns immediately.
+TEST(BoundedQueueTest, waitIdleEmpty) {
+    IntQueue queue(1);
+    queue.waitIdle();
+    EXPECT_TRUE(queue.push(1));
+    int item = 0;
+    ASSERT_TRUE(queue.pop(item));
+    queue.done();
+    queue.waitIdle();
+}
+
+// The items are taken in batches limited by the maximum batch size and
+// the batch is marked processed at once.
+TEST(BoundedQueueTest, popBatch) {
+    IntQueue queue(8);
+    for (int i = 1; i <= 5; ++i) {
+        EXPECT_TRUE(queue.push(i));
+    }
+
+    std::vector<int> items;
+    ASSERT_EQ(3, queue.popBatch(items, 3));
+    ASSERT_EQ(3, items.size());
+    EXPECT_EQ(1, items[0]);
+    EXPECT_EQ(3, items[2]);
+
+    // Items are appended to the vector.
+    ASSERT_EQ(2, queue.popBatch(items, 3));
+    ASSERT_EQ(5, items.size());
+    EXPECT_EQ(5, items[4]);
+    EXPECT_EQ(0, queue.size());
+
+    queue.done(items.size());
+    queue.waitIdle();
+
+    // The closed and empty queue returns no items without blocking.
+    queue.close();
+    EXPECT_EQ(0, queue.popBatch(items, 3));
+}
+
+// The items are taken without waiting or after the limited wait.
+TEST(BoundedQueueTest, popBatchTimeout) {
+    IntQueue queue(8);
+    std::vector<int> items;
+    EXPECT_EQ(0, queue.popBatch(items, 3, 0));
+    EXPECT_EQ(0, queue.popBatch(items, 3, 10000));
+    EXPECT_TRUE(items.empty());
+
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    ASSERT_EQ(2, queue.popBatch(items, 3, 0));
+    EXPECT_EQ(2, items[1]);
+    queue.done(items.size());
+}
+
+// Takes all items from the queue, sums them up and marks them processed.
+void
+consume(IntQueue* queue, int* sum) {
+    int item = 0;
+    while (queue->pop(item)) {
+        *sum += item;
+        queue->done();
+    }
+}
+
+// Several consumers take the items from the queue. Once the producer has
+// waited for the queue to become idle, all items must have been processed.
+TEST(BoundedQueueTest, consumers) {
+    if (isc::util::unittests::runningOnValgrind()) {
+        return;
+    }
+    const size_t consumers_num = 4;
+    IntQueue queue(16);
+    std::vector<int> sums(consumers_num, 0);
+    std::vector<boost::shared_ptr<Thread> > consumers;
+    for (size_t i = 0; i < consumers_num; ++i) {
+        consumers.push_back(boost::shared_ptr<Thread>(
+            new Thread(boost::bind(&consume, &queue, &sums[i]))));
+    }
+
+    int expected = 0;
+    for (int i = 1; i <= 1000; ++i) {
+        // The queue may be full, in which case the producer retries.
+        while (!queue.push(i)) {
+            queue.waitIdle();
+        }
+        expected += i;
+    }
+    queue.waitIdle();
+    EXPECT_EQ(0, queue.size());
+
+    // Each consumer must exit after the queue is closed.
+    queue.close();
+    int total = 0;
+    for (size_t i = 0; i < consumers_num; ++i) {
+        consumers[i]->wait();
+        total += sums[i];
+    }
+    EXPECT_EQ(expected, total);
+}
+
+}
@@ -95,6 +95,22 @@ TEST_F(CondVarTest, waitAndSignal) {
     }
 }
 
+// The wait with a timeout returns when the condition variable is signalled
+// and when the time elapses.
+TEST_F(CondVarTest, timedWait) {
+    Mutex::Locker locker(mutex_);
+    EXPECT_FALSE(condvar_.timedWait(mutex_, 10000));
+    if (!isc::util::unittests::runningOnValgrind()) {
+        int shared_var = 0;
+        Thread t(boost::bind(&ringSignal, &condvar_, &mutex_, &shared_var));
+        while ((shared_var == 0) && !do_exit) {
+            condvar_.timedWait(mutex_, 100000);
+        }
+        t.wait();
+        EXPECT_EQ(1, shared_var);
+    }
+}
+
 // Thread's main code for the next test
 void
 signalAndWait(CondVar* condvar1, CondVar* condvar2, Mutex* mutex, int* arg) {
@@ -133,6 +149,31 @@ TEST_F(CondVarTest, multiWaits) {
     EXPECT_EQ(4, shared_var);
 }
 
+// Same as the previous test, but wake up both threads with a single
+// broadcast.
+TEST_F(CondVarTest, multiWaitsBroadcast) {
+    boost::scoped_ptr<Mutex::Locker> locker(new Mutex::Locker(mutex_));
+    CondVar condvar2; // separate cond var for initial synchronization
+    int shared_var = 0; // let the other thread increment this
+    Thread t1(boost::bind(&signalAndWait, &condvar_, &condvar2, &mutex_,
+                          &shared_var));
+    Thread t2(boost::bind(&signalAndWait, &condvar_, &condvar2, &mutex_,
+                          &shared_var));
+
+    // Wait until both threads are waiting on condvar_.
+    while (shared_var < 2 && !do_exit) {
+        condvar2.wait(mutex_);
+    }
+    ASSERT_FALSE(do_exit);
+    ASSERT_EQ(2, shared_var);
+
+    locker.reset();
+    condvar_.broadcast();
+    t1.wait();
+    t2.wait();
+    EXPECT_EQ(4, shared_var);
+}
+
 // Similar to the previous version of the same function, but just do
 // condvar operations.  It will never wake up.
 void
@@ -175,4 +216,9 @@ TEST_F(CondVarTest, emptySignal) {
     EXPECT_NO_THROW(condvar_.signal());
 }
 
+TEST_F(CondVarTest, emptyBroadcast) {
+    // It's okay to call broadcast when no one waits.
+    EXPECT_NO_THROW(condvar_.broadcast());
+}
+
 }
@@ -168,4 +168,65 @@ TEST(MutexTest, swarm) {
     }
 }
 
+
+void
+readerThread(RWMutex* mutex, bool* done) {
+    // The lock is held shared by the main thread, so this must not block.
+    RWMutex::ReaderLocker locker(*mutex);
+    // But it must prevent taking it exclusive.
+    EXPECT_THROW({
+        RWMutex::Locker writer(*mutex, false);
+    }, RWMutex::Locker::AlreadyLocked);
+    *done = true;
+}
+
+// Several threads can hold the lock shared at once, but not exclusive.
+TEST(RWMutexTest, sharedLock) {
+    RWMutex mutex;
+    bool done = false;
+    {
+        RWMutex::ReaderLocker locker(mutex);
+        Thread thread(boost::bind(&readerThread, &mutex, &done));
+        thread.wait();
+    }
+    EXPECT_TRUE(done);
+
+    // Once all the readers are gone, it can be taken exclusive, which
+    // excludes the others.
+    RWMutex::Locker writer(mutex, false);
+    EXPECT_THROW({
+        RWMutex::Locker writer2(mutex, false);
+    }, RWMutex::Locker::AlreadyLocked);
+}
+
+void
+performWriterIncrement(volatile double* canary, volatile bool* ready_me,
+                       volatile bool* ready_other, RWMutex* mutex)
+{
+    *ready_me = true;
+    while (!*ready_other) {}
+
+    for (size_t i = 0; i < iterations; ++i) {
+        RWMutex::Locker lock(*mutex);
+        *canary += 1;
+    }
+}
+
+// The exclusive lock really excludes, as in MutexTest.swarm.
+TEST(RWMutexTest, swarm) {
+    if (!isc::util::unittests::runningOnValgrind()) {
+        double canary = 0;
+        RWMutex mutex;
+        bool ready1 = false;
+        bool ready2 = false;
+        Thread t1(boost::bind(&performWriterIncrement, &canary, &ready1,
+                              &ready2, &mutex));
+        Thread t2(boost::bind(&performWriterIncrement, &canary, &ready2,
+                              &ready1, &mutex));
+        t1.wait();
+        t2.wait();
+        EXPECT_EQ(iterations * 2, canary) << "Threads are badly synchronized";
+    }
+}
+
 }
@@ -14,7 +14,12 @@
 
 #include <sstream>
 #include <iostream>
-#include <map>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/indexed_by.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index_container.hpp>
 #include "memfile_ubench.h"
 
 using namespace std;
@@ -23,21 +28,18 @@ using namespace std;
 /// @brief In-memory + lease file database implementation
 ///
 /// This is a simplified in-memory database that mimics ISC DHCP4 implementation.
-/// It uses STL and boost: std::map for storage, boost::shared ptr for memory
-/// management. It does use C file operations (fopen, fwrite, etc.), because
-/// C++ streams does not offer any easy way to flush their contents, like
-/// fflush() and fsync() does.
+/// It uses STL and boost: boost::multi_index_container for storage,
+/// boost::shared ptr for memory management. It does use C file operations
+/// (fopen, fwrite, etc.), because C++ streams does not offer any easy way to
+/// flush their contents, like fflush() and fsync() does.
 ///
-/// IPv4 address is used as a key in the hash.
+/// The leases are indexed by the IPv4 address and by the hardware address
+/// and pool id, like the leases held by the Kea memfile backend. The layout
+/// of the latter index is selected by the derived class, so as the ordered
+/// and hashed indexes can be compared.
 class memfile_LeaseMgr {
 public:
 
-    /// A hash table for Lease4 leases.
-    typedef std::map<uint32_t /* addr */, Lease4Ptr /* lease info */> IPv4Hash;
-
-    /// An iterator for Lease4 hash table.
-    typedef std::map<uint32_t, Lease4Ptr>::iterator leaseIt;
-
     /// @brief The sole memfile lease manager constructor
     ///
     /// @param filename name of the lease file (will be overwritten)
@@ -45,19 +47,28 @@ public:
     memfile_LeaseMgr(const std::string& filename, bool sync);
 
     /// @brief Destructor (closes file)
-    ~memfile_LeaseMgr();
+    virtual ~memfile_LeaseMgr();
 
     /// @brief adds a lease to the hash
     ///
     /// @param lease lease to be added
-    bool addLease(Lease4Ptr lease);
+    virtual bool addLease(Lease4Ptr lease) = 0;
 
     /// @brief returns existing lease
     ///
     /// @param addr address of the searched lease
     ///
     /// @return smart pointer to the lease (or NULL if lease is not found)
-    Lease4Ptr getLease(uint32_t addr);
+    virtual Lease4Ptr getLease(uint32_t addr) = 0;
+
+    /// @brief returns existing lease for the client
+    ///
+    /// @param hwaddr hardware address of the client
+    /// @param pool_id ID of the pool the lease belongs to
+    ///
+    /// @return smart pointer to the lease (or NULL if lease is not found)
+    virtual Lease4Ptr getLease(const std::vector<uint8_t>& hwaddr,
+                               uint32_t pool_id) = 0;
 
     /// @brief Simplified lease update.
     ///
@@ -69,14 +80,14 @@ public:
     /// @param new_cltt New client last transmission time
     ///
     /// @return pointer to the updated lease (or NULL)
-    Lease4Ptr updateLease(uint32_t addr, uint32_t new_cltt);
+    virtual Lease4Ptr updateLease(uint32_t addr, uint32_t new_cltt) = 0;
 
     /// @brief Deletes a lease.
     ///
     /// @param addr IPv4 address of the lease to be deleted.
     ///
     /// @return true if deletion was successful, false if no such lease exists
-    bool deleteLease(uint32_t addr);
+    virtual bool deleteLease(uint32_t addr) = 0;
 
 protected:
 
@@ -93,11 +104,136 @@ protected:
 
     /// File handle to the open lease file.
     FILE * file_;
+};
+
+/// @brief Lease manager using the specified multi index container.
+///
+/// @tparam Storage multi index container type. The index #0 must be the
+/// unique index by IPv4 address, the index #1 must be the unique index by
+/// hardware address and pool id.
+template<typename Storage>
+class memfile_LeaseMgrImpl : public memfile_LeaseMgr {
+public:
+
+    /// @brief Constructor
+    ///
+    /// @param filename name of the lease file (will be overwritten)
+    /// @param sync should operations be
+    memfile_LeaseMgrImpl(const std::string& filename, bool sync)
+        : memfile_LeaseMgr(filename, sync) {
+    }
+
+    /// @brief adds a lease to the storage
+    virtual bool addLease(Lease4Ptr lease) {
+        if (!storage_.insert(lease).second) {
+            // there is such an address (or client) already
+            return (false);
+        }
+        lease->hostname = "add";
+        writeLease(lease);
+        return (true);
+    }
+
+    /// @brief returns existing lease by address
+    virtual Lease4Ptr getLease(uint32_t addr) {
+        typename Storage::iterator x = storage_.find(addr);
+        if (x != storage_.end()) {
+            return (*x); // found
+        }
+
+        // not found
+        return (Lease4Ptr());
+    }
+
+    /// @brief returns existing lease by hardware address and pool id
+    virtual Lease4Ptr getLease(const std::vector<uint8_t>& hwaddr,
+                               uint32_t pool_id) {
+        typedef typename Storage::template nth_index<1>::type SearchIndex;
+        const SearchIndex& idx = storage_.template get<1>();
+        typename SearchIndex::const_iterator x =
+            idx.find(boost::make_tuple(hwaddr, pool_id));
+        if (x != idx.end()) {
+            return (*x); // found
+        }
+
+        // not found
+        return (Lease4Ptr());
+    }
+
+    /// @brief updates client last transmission time of the lease
+    virtual Lease4Ptr updateLease(uint32_t addr, uint32_t new_cltt) {
+        typename Storage::iterator x = storage_.find(addr);
+        if (x != storage_.end()) {
+            // Neither the address nor the hardware address changes, so
+            // there is no need to re-index the lease.
+            (*x)->cltt = new_cltt;
+            (*x)->hostname = "update";
+            writeLease(*x);
+            return (*x);
+        }
+        return (Lease4Ptr());
+    }
+
+    /// @brief deletes the lease
+    virtual bool deleteLease(uint32_t addr) {
+        typename Storage::iterator x = storage_.find(addr);
+        if (x != storage_.end()) {
+            (*x)->hostname = "delete";
+            writeLease(*x);
+            storage_.erase(x);
+            return (true);
+        }
+        return (false);
+    }
 
-    /// Hash table for IPv4 leases
-    IPv4Hash ip4Hash_;
+protected:
+
+    /// Container holding IPv4 leases
+    Storage storage_;
 };
 
+/// @brief Leases indexed by address and by ordered (hwaddr, pool id) index.
+///
+/// This is the layout used by the Kea memfile backend up to now: each lookup
+/// by client compares the hardware address vectors O(log n) times.
+typedef boost::multi_index_container<
+    Lease4Ptr,
+    boost::multi_index::indexed_by<
+        boost::multi_index::ordered_unique<
+            boost::multi_index::member<Lease4, uint32_t, &Lease4::addr>
+        >,
+        boost::multi_index::ordered_unique<
+            boost::multi_index::composite_key<
+                Lease4,
+                boost::multi_index::member<Lease4, std::vector<uint8_t>,
+                                           &Lease4::hwaddr>,
+                boost::multi_index::member<Lease4, uint32_t, &Lease4::pool_id>
+            >
+        >
+    >
+> OrderedLease4Storage;
+
+/// @brief Leases indexed by address and by hashed (hwaddr, pool id) index.
+///
+/// The address index remains ordered. The lookup by client hashes the
+/// hardware address once and typically compares it with a single lease.
+typedef boost::multi_index_container<
+    Lease4Ptr,
+    boost::multi_index::indexed_by<
+        boost::multi_index::ordered_unique<
+            boost::multi_index::member<Lease4, uint32_t, &Lease4::addr>
+        >,
+        boost::multi_index::hashed_unique<
+            boost::multi_index::composite_key<
+                Lease4,
+                boost::multi_index::member<Lease4, std::vector<uint8_t>,
+                                           &Lease4::hwaddr>,
+                boost::multi_index::member<Lease4, uint32_t, &Lease4::pool_id>
+            >
+        >
+    >
+> HashedLease4Storage;
+
 memfile_LeaseMgr::memfile_LeaseMgr(const std::string& filename, bool sync)
     : filename_(filename), sync_(sync) {
     file_ = fopen(filename.c_str(), "w");
@@ -136,59 +272,42 @@ void memfile_LeaseMgr::writeLease(Lease4Ptr lease) {
     }
 }
 
-bool memfile_LeaseMgr::addLease(Lease4Ptr lease) {
-    if (ip4Hash_.find(lease->addr) != ip4Hash_.end()) {
-        // there is such an address already in the hash
-        return false;
-    }
-    ip4Hash_.insert(pair<uint32_t, Lease4Ptr>(lease->addr, lease));
-    lease->hostname = "add";
-    writeLease(lease);
-    return (true);
-}
-
-Lease4Ptr memfile_LeaseMgr::getLease(uint32_t addr) {
-    leaseIt x = ip4Hash_.find(addr);
-    if (x != ip4Hash_.end()) {
-        return x->second; // found
-    }
-
-    // not found
-    return Lease4Ptr();
-}
-
-Lease4Ptr memfile_LeaseMgr::updateLease(uint32_t addr, uint32_t new_cltt) {
-    leaseIt x = ip4Hash_.find(addr);
-    if (x != ip4Hash_.end()) {
-        x->second->cltt = new_cltt;
-        x->second->hostname = "update";
-        writeLease(x->second);
-        return x->second;
-    }
-    return Lease4Ptr();
-}
-
-bool memfile_LeaseMgr::deleteLease(uint32_t addr) {
-    leaseIt x = ip4Hash_.find(addr);
-    if (x != ip4Hash_.end()) {
-        x->second->hostname = "delete";
-        writeLease(x->second);
-        ip4Hash_.erase(x);
-        return true;
+/// @brief Returns the hardware address of the client holding the lease.
+///
+/// All clients share the same long prefix, which is the worst case for
+/// the ordered index. The address of the lease makes it unique.
+///
+/// @param addr IPv4 address of the lease
+static vector<uint8_t> getHWAddr(uint32_t addr) {
+    const uint8_t hwaddr_len = 20;  // Not a real field
+    vector<uint8_t> hwaddr(hwaddr_len);
+    for (uint8_t i = 0; i < hwaddr_len - 4; ++i) {
+        hwaddr[i] = 'A' + i; // let's make hwaddr consisting of letter
     }
-    return false;
+    hwaddr[hwaddr_len - 4] = addr >> 24;
+    hwaddr[hwaddr_len - 3] = (addr >> 16) & 0xFF;
+    hwaddr[hwaddr_len - 2] = (addr >> 8) & 0xFF;
+    hwaddr[hwaddr_len - 1] = addr & 0xFF;
+    return (hwaddr);
 }
 
 memfile_uBenchmark::memfile_uBenchmark(const string& filename,
                                        uint32_t num_iterations,
                                        bool sync,
                                        bool verbose)
-    :uBenchmark(num_iterations, filename, sync, verbose) {
+    :uBenchmark(num_iterations, filename, sync, verbose), leaseMgr_(NULL),
+     hashed_(false) {
 }
 
 void memfile_uBenchmark::connect() {
     try {
-        leaseMgr_ = new memfile_LeaseMgr(dbname_, sync_);
+        if (hashed_) {
+            leaseMgr_ = new memfile_LeaseMgrImpl<HashedLease4Storage>(dbname_,
+                                                                      sync_);
+        } else {
+            leaseMgr_ = new memfile_LeaseMgrImpl<OrderedLease4Storage>(dbname_,
+                                                                       sync_);
+        }
     } catch (const std::string& e) {
         failure(e.c_str());
     }
@@ -205,8 +324,6 @@ void memfile_uBenchmark::createLease4Test() {
     }
 
     uint32_t addr = BASE_ADDR4;     // Let's start with 1.0.0.0 address
-    const uint8_t hwaddr_len = 20;  // Not a real field
-    char hwaddr_tmp[hwaddr_len];
     const uint8_t client_id_len = 128;
     char client_id_tmp[client_id_len];
     uint32_t valid_lft = 1000;      // We can use the same value for all leases
@@ -221,13 +338,6 @@ void memfile_uBenchmark::createLease4Test() {
 
     cout << "CREATE:   ";
 
-    // While we could put the data directly into vector, I would like to
-    // keep the code as  similar to other benchmarks as possible
-    for (uint8_t i = 0; i < hwaddr_len; ++i) {
-        hwaddr_tmp[i] = 'A' + i; // let's make hwaddr consisting of letter
-    }
-    vector<uint8_t> hwaddr(hwaddr_tmp, hwaddr_tmp + hwaddr_len - 1);
-
     for (uint8_t i = 0; i < client_id_len; i++) {
         client_id_tmp[i] = 33 + i; // 33 is being the first, non whitespace
                                    // printable ASCII character
@@ -240,7 +350,7 @@ void memfile_uBenchmark::createLease4Test() {
 
         Lease4Ptr lease = boost::shared_ptr<Lease4>(new Lease4());
         lease->addr = addr;
-        lease->hwaddr = hwaddr;
+        lease->hwaddr = getHWAddr(addr);
         lease->client_id = client_id;
         lease->valid_lft = valid_lft;
         lease->recycle_time = recycle_time;
@@ -274,7 +384,9 @@ void memfile_uBenchmark::searchLease4Test() {
     for (uint32_t i = 0; i < num_; i++) {
         uint32_t x = BASE_ADDR4 + random() % int(num_ / hitratio_);
 
-        Lease4Ptr lease = leaseMgr_->getLease(x);
+        // The DHCP server looks the client up by its hardware address,
+        // so this is the lookup which depends on the index layout.
+        Lease4Ptr lease = leaseMgr_->getLease(getHWAddr(x), 0);
         if (verbose_) {
             cout << (lease?".":"X");
         }
@@ -335,7 +447,9 @@ void memfile_uBenchmark::deleteLease4Test() {
 }
 
 void memfile_uBenchmark::printInfo() {
-    cout << "Memory db (using std::map) + write-only file." << endl;
+    cout << "Memory db (using boost::multi_index_container with "
+         << (hashed_ ? "hashed" : "ordered") << " client index)"
+         << " + write-only file." << endl;
 }
 
 
@@ -350,7 +464,15 @@ int main(int argc, char * const argv[]) {
 
     bench.parseCmdline(argc, argv);
 
+    // Run the benchmark for both layouts of the client index, so as
+    // they can be compared.
+    bench.printInfo();
     int result = bench.run();
+    if (result == 0) {
+        bench.setHashed(true);
+        bench.printInfo();
+        result = bench.run();
+    }
 
     return (result);
 }
@@ -50,10 +50,14 @@ class memfile_LeaseMgr;
 /// That is a specific backend implementation. See \ref uBenchmark class for
 /// detailed explanation of its operations. This class uses custom in-memory
 /// pseudo-database and external write-only lease file. That approach simulates
-/// modernized model of ISC DHCP4. It uses standard STL maps together with
-/// shared_ptr from boost library. The "database" is implemented in the Lease
+/// modernized model of ISC DHCP4. It uses boost::multi_index_container together
+/// with shared_ptr from boost library. The "database" is implemented in the Lease
 /// Manager (see \ref LeaseMgr in memfile_ubench.cc). All lease changes are
 /// appended to the end of the file, speeding up the process.
+///
+/// The leases are searched by the hardware address of the client. The index
+/// used for this lookup is either ordered or hashed (see \ref setHashed), so
+/// as the two layouts can be compared.
 class memfile_uBenchmark: public uBenchmark {
 public:
 
@@ -69,6 +73,16 @@ public:
     /// @brief Prints backend info.
     virtual void printInfo();
 
+    /// @brief Selects the layout of the index by client.
+    ///
+    /// It takes effect when the lease manager is spawned, i.e. on the next
+    /// run of the benchmark.
+    ///
+    /// @param hashed use the hashed index if true, ordered index otherwise
+    void setHashed(bool hashed) {
+        hashed_ = hashed;
+    }
+
     /// @brief Spawns lease manager that create empty lease file, initializes
     ///        empty STL maps.
     virtual void connect();
@@ -98,6 +112,10 @@ public:
 
 protected:
 
-    /// Lease Manager (concrete backend implementation, based on STL maps)
+    /// Lease Manager (concrete backend implementation, based on multi index
+    /// containers)
     memfile_LeaseMgr * leaseMgr_;
+
+    /// Should the lease manager use the hashed index by client?
+    bool hashed_;
 };
@@ -131,6 +131,7 @@ CommandOptions::reset() {
     preload_ = 0;
     aggressivity_ = 1;
     local_port_ = 0;
+    threads_num_ = 1;
     seeded_ = false;
     seed_ = 0;
     broadcast_ = false;
@@ -144,6 +145,7 @@ CommandOptions::reset() {
     rip_offset_ = -1;
     diags_.clear();
     wrapped_.clear();
+    stats_file_.clear();
     server_name_.clear();
     generateDuidTemplate();
 }
@@ -212,7 +214,7 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
     // In this section we collect argument values from command line
     // they will be tuned and validated elsewhere
     while((opt = getopt(argc, argv, "hv46r:t:R:b:n:p:d:D:l:P:a:L:"
-                        "s:iBc1T:X:O:E:S:I:x:w:e:f:F:")) != -1) {
+                        "s:iBc1T:X:O:E:S:I:x:w:e:f:F:g:H:")) != -1) {
         stream << " -" << static_cast<char>(opt);
         if (optarg) {
             stream << " " << optarg;
@@ -314,10 +316,20 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
                                             " positive integer");
             break;
 
+        case 'g':
+            threads_num_ = positiveInteger("number of threads: -g<threads>"
+                                           " must be a positive integer");
+            break;
+
         case 'h':
             usage();
             return (true);
 
+        case 'H':
+            stats_file_ = nonEmptyString("file for statistics:"
+                                         " -H<stats-file> must be specified");
+            break;
+
         case 'i':
             exchange_mode_ = DO_SA;
             break;
@@ -763,6 +775,22 @@ CommandOptions::validate() const {
     check((getTemplateFiles().size() < 2) && (getRequestedIpOffset() >= 0),
           "second/request -T<template-file> must be set to "
           "use -I<ip-offset>");
+    check((getThreadsNum() > 1) && (getRate() != 0) &&
+          (getRate() < getThreadsNum()),
+          "-r<rate> must not be lower than the number of threads -g<threads>");
+    check((getThreadsNum() > 1) && (getRenewRate() != 0) &&
+          (getRenewRate() < getThreadsNum()),
+          "-f<renew-rate> must not be lower than the number of threads"
+          " -g<threads>");
+    check((getThreadsNum() > 1) && (getReleaseRate() != 0) &&
+          (getReleaseRate() < getThreadsNum()),
+          "-F<release-rate> must not be lower than the number of threads"
+          " -g<threads>");
+    for (int i = 0; i < max_drop_.size(); ++i) {
+        check((getThreadsNum() > 1) && (max_drop_[i] < getThreadsNum()),
+              "-D<max-drop> must not be lower than the number of threads"
+              " -g<threads>");
+    }
 
 }
 
@@ -865,6 +893,9 @@ CommandOptions::printCommandLine() const {
     if (getLocalPort() != 0) {
         std::cout << "local-port=" << local_port_ <<  std::endl;
     }
+    if (threads_num_ > 1) {
+        std::cout << "threads=" << threads_num_ << std::endl;
+    }
     if (seeded_) {
         std::cout << "seed=" << seed_ << std::endl;
     }
@@ -901,6 +932,9 @@ CommandOptions::printCommandLine() const {
     if (!wrapped_.empty()) {
         std::cout << "wrapped=" << wrapped_ << std::endl;
     }
+    if (!stats_file_.empty()) {
+        std::cout << "stats-file=" << stats_file_ << std::endl;
+    }
     if (!localname_.empty()) {
         if (is_interface_) {
             std::cout << "interface=" << localname_ << std::endl;
@@ -920,11 +954,11 @@ CommandOptions::usage() const {
         "         [-F<release-rate>] [-t<report>] [-R<range>] [-b<base>]\n"
         "         [-n<num-request>] [-p<test-period>] [-d<drop-time>]\n"
         "         [-D<max-drop>] [-l<local-addr|interface>] [-P<preload>]\n"
-        "         [-a<aggressivity>] [-L<local-port>] [-s<seed>] [-i] [-B]\n"
-        "         [-c] [-1] [-T<template-file>] [-X<xid-offset>]\n"
+        "         [-a<aggressivity>] [-L<local-port>] [-g<threads>] [-s<seed>]\n"
+        "         [-i] [-B] [-c] [-1] [-T<template-file>] [-X<xid-offset>]\n"
         "         [-O<random-offset] [-E<time-offset>] [-S<srvid-offset>]\n"
         "         [-I<ip-offset>] [-x<diagnostic-selector>] [-w<wrapped>]\n"
-        "         [server]\n"
+        "         [-H<stats-file>] [server]\n"
         "\n"
         "The [server] argument is the name/address of the DHCP server to\n"
         "contact.  For DHCPv4 operation, exchanges are initiated by\n"
@@ -967,7 +1001,20 @@ CommandOptions::usage() const {
         "-E<time-offset>: Offset of the (DHCPv4) secs field / (DHCPv6)\n"
         "    elapsed-time option in the (second/request) template.\n"
         "    The value 0 disables it.\n"
+        "-g<threads>: Number of threads sending and receiving packets.\n"
+        "    Each thread simulates its own subset of the clients (see -R) and\n"
+        "    sends its share of the exchanges (see -r, -n and -D).  The\n"
+        "    responses are received by the main thread and passed to the thread\n"
+        "    which initiated the exchange.  The default is 1.\n"
         "-h: Print this help.\n"
+        "-H<stats-file>: Write the statistics of each exchange to the file:\n"
+        "    the numbers of packets, the minimum, maximum and percentiles\n"
+        "    (50, 90, 99, 99.9 and 99.99) of the delays, in milliseconds.  A\n"
+        "    record is written for each periodic report (see -t), describing\n"
+        "    the delays in the last period, and at the end of the test,\n"
+        "    describing all delays.  The records are written as JSON objects,\n"
+        "    one per line, if the file name ends with '.json', and as CSV\n"
+        "    lines otherwise.\n"
         "-i: Do only the initial part of an exchange: DO or SA, depending on\n"
         "    whether -6 is given.\n"
         "-I<ip-offset>: Offset of the (DHCPv4) IP address in the requested-IP\n"
@@ -252,6 +252,11 @@ public:
     /// \return local port number.
     int getLocalPort() const { return local_port_; }
 
+    /// \brief Returns number of threads running the test.
+    ///
+    /// \return number of threads.
+    int getThreadsNum() const { return threads_num_; }
+
     /// \brief Checks if seed provided.
     ///
     /// \return true if seed was provided.
@@ -317,6 +322,12 @@ public:
     /// \return wrapped command (start/stop).
     std::string getWrapped() const { return wrapped_; }
 
+    /// \brief Returns name of the file to which statistics are written.
+    ///
+    /// \return name of the statistics file or empty string if it was
+    /// not specified.
+    std::string getStatsFile() const { return stats_file_; }
+
     /// \brief Returns server name.
     ///
     /// \return server name.
@@ -522,6 +533,9 @@ private:
     int aggressivity_;
     /// Local port number (host endian)
     int local_port_;
+    /// Number of threads sending and receiving packets, each
+    /// simulating a distinct subset of clients.
+    int threads_num_;
     /// Randomization seed.
     uint32_t seed_;
     /// Indicates that randomization seed was provided.
@@ -557,6 +571,9 @@ private:
     /// Command to be executed at the beginning/end of the test.
     /// This command is expected to expose start and stop argument.
     std::string wrapped_;
+    /// Name of the file to which statistics are written, specified
+    /// with -H<stats-file>.
+    std::string stats_file_;
     /// Server name specified as last argument of command line.
     std::string server_name_;
 };
@@ -0,0 +1,102 @@
+#!/bin/sh
+# Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted, provided that the above
+# copyright notice and this permission notice appear in all copies.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+# REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+# AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+# INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+# LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+# OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+# PERFORMANCE OF THIS SOFTWARE.
+
+# Measures how the throughput of the DHCPv6 server scales with the number
+# of worker threads (the -w option of b10-dhcp6).
+#
+# For each number of workers the script starts the server, runs perfdhcp
+# against it for the specified period and prints the number of the
+# Advertise and Reply messages received per second, as well as the number
+# of dropped exchanges.
+#
+# The server must be able to allocate leases, so it must have a subnet
+# configured for the link perfdhcp sends its queries on. The b10-dhcp6
+# started in the stand-alone mode has no configuration, so by default the
+# server is started without -s and fetches its configuration from a running
+# BIND 10 instance. Make sure that BIND 10 doesn't start the b10-dhcp6
+# itself, e.g. by removing it from the Init/components list with bindctl
+# after configuring the Dhcp6 module.
+#
+# perfdhcp sends the queries from the specified interface to the server's
+# multicast address, so the server must listen on the peer interface, e.g.
+# one end of the veth pair:
+#
+#   ip link add veth0 type veth peer name veth1
+#
+# Usage: dhcp6_scaling_bench.sh <interface> [workers ...]
+#
+# The following environment variables may be used to alter the test:
+#   DHCP6_SERVER  - server command line, default "b10-dhcp6"
+#   PERFDHCP      - perfdhcp binary, default "perfdhcp"
+#   RATE          - queries per second sent by perfdhcp, default 100000
+#   CLIENTS       - number of simulated clients, default 100000
+#   PERIOD        - duration of each run in seconds, default 30
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <interface> [workers ...]" >&2
+    exit 1
+fi
+
+iface=$1
+shift
+workers_list=${*:-"0 1 2 4 8"}
+
+server=${DHCP6_SERVER:-b10-dhcp6}
+perfdhcp=${PERFDHCP:-perfdhcp}
+rate=${RATE:-100000}
+clients=${CLIENTS:-100000}
+period=${PERIOD:-30}
+
+tempfile=`mktemp ${TMPDIR:-/tmp}/dhcp6_scaling_bench.XXXXXX`
+trap 'rm -f $tempfile' EXIT
+
+# Prints the number of the packets received in the specified exchange.
+received() {
+    awk -v exchange="$1" '
+        /^\*\*\*Statistics for: / { current = $3; sub(/\*+$/, "", current) }
+        /^received packets: / { if (current == exchange) { print $3 } }
+    ' $tempfile
+}
+
+# Prints the number of the dropped exchanges, summed over all exchanges.
+drops() {
+    awk '/^drops: / { sum += $2 } END { print sum + 0 }' $tempfile
+}
+
+printf "%8s %12s %12s %10s\n" "workers" "advertise/s" "reply/s" "drops"
+
+for workers in $workers_list; do
+    $server -w $workers > /dev/null 2>&1 &
+    server_pid=$!
+    # Give the server the time to fetch its configuration and open sockets.
+    sleep 3
+
+    $perfdhcp -6 -l $iface -r $rate -R $clients -p $period > $tempfile 2>&1
+    status=$?
+
+    kill $server_pid
+    wait $server_pid 2> /dev/null
+
+    if [ $status -ne 0 ] && [ $status -ne 3 ]; then
+        echo "perfdhcp failed with status $status:" >&2
+        cat $tempfile >&2
+        exit 1
+    fi
+
+    advertise=`received SOLICIT-ADVERTISE`
+    reply=`received REQUEST-REPLY`
+    printf "%8s %12s %12s %10s\n" $workers \
+        `expr ${advertise:-0} / $period` `expr ${reply:-0} / $period` `drops`
+done
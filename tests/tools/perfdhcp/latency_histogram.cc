@@ -0,0 +1,137 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+/// Number of bits of the values counted with the precision of 1.
+const unsigned int SUB_BUCKET_BITS = 8;
+/// Number of the buckets in each power of two, except the first one.
+const size_t SUB_BUCKET_HALF_COUNT = 1 << (SUB_BUCKET_BITS - 1);
+
+}
+
+namespace isc {
+namespace perfdhcp {
+
+const double REPORTED_PERCENTILES[] = { 50, 90, 99, 99.9, 99.99 };
+
+const size_t REPORTED_PERCENTILES_NUM =
+    sizeof(REPORTED_PERCENTILES) / sizeof(REPORTED_PERCENTILES[0]);
+
+LatencyHistogram::LatencyHistogram(const unsigned int max_seconds)
+    : max_value_(static_cast<uint64_t>(std::max(max_seconds, 1U)) * 1000000),
+      counts_(getIndex(max_value_) + 1, 0),
+      count_(0),
+      min_(std::numeric_limits<uint64_t>::max()),
+      max_(0) {
+}
+
+void
+LatencyHistogram::record(const uint64_t usec) {
+    const uint64_t value = std::min(usec, max_value_);
+    ++counts_[getIndex(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void
+LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.max_value_ != max_value_) {
+        isc_throw(BadValue, "unable to merge histograms with different"
+                  " maximum values");
+    }
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void
+LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+}
+
+uint64_t
+LatencyHistogram::getMin() const {
+    return (count_ == 0 ? 0 : min_);
+}
+
+uint64_t
+LatencyHistogram::getValueAtPercentile(const double percentile) const {
+    if ((percentile < 0) || (percentile > 100)) {
+        isc_throw(BadValue, "percentile " << percentile
+                  << " is out of range 0..100");
+    }
+    if (count_ == 0) {
+        return (0);
+    }
+    // Number of the values not greater than the returned one.
+    uint64_t rank =
+        static_cast<uint64_t>(std::ceil(percentile * count_ / 100));
+    rank = std::max(std::min(rank, count_), static_cast<uint64_t>(1));
+    uint64_t total = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        total += counts_[i];
+        if (total >= rank) {
+            return (std::min(getHighestValue(i), max_));
+        }
+    }
+    return (max_);
+}
+
+std::string
+LatencyHistogram::getPercentileName(const double percentile) {
+    std::ostringstream s;
+    s << "p" << percentile;
+    return (s.str());
+}
+
+size_t
+LatencyHistogram::getIndex(const uint64_t value) const {
+    // The values lower than 2^SUB_BUCKET_BITS are held in the buckets of
+    // width 1. The width of the buckets holding the greater values is
+    // doubled with each power of two.
+    size_t bucket = 0;
+    for (uint64_t v = value >> SUB_BUCKET_BITS; v != 0; v >>= 1) {
+        ++bucket;
+    }
+    return (bucket * SUB_BUCKET_HALF_COUNT + (value >> bucket));
+}
+
+uint64_t
+LatencyHistogram::getHighestValue(const size_t index) const {
+    if (index < 2 * SUB_BUCKET_HALF_COUNT) {
+        return (index);
+    }
+    const size_t bucket = index / SUB_BUCKET_HALF_COUNT - 1;
+    const uint64_t sub_bucket = index - bucket * SUB_BUCKET_HALF_COUNT;
+    return ((sub_bucket << bucket) + (static_cast<uint64_t>(1) << bucket) - 1);
+}
+
+} // namespace perfdhcp
+} // namespace isc
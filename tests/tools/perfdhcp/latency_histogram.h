@@ -0,0 +1,129 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace isc {
+namespace perfdhcp {
+
+/// \brief Percentiles of the packet delays reported by perfdhcp.
+extern const double REPORTED_PERCENTILES[];
+
+/// \brief Number of elements of \ref REPORTED_PERCENTILES.
+extern const size_t REPORTED_PERCENTILES_NUM;
+
+/// \brief Histogram of the packet delays.
+///
+/// The minimum, maximum, average and standard deviation of the delays
+/// say little about the tail of the distribution, e.g. the delay which
+/// is not exceeded by 99.9% of the exchanges. This class counts the
+/// delays in buckets, so as any percentile of the delays may be
+/// calculated, while the memory used does not depend on the number of
+/// the delays recorded.
+///
+/// The buckets are laid out as in the HDR (High Dynamic Range)
+/// histogram. The values are grouped by their power of two, and each
+/// group is divided into 128 buckets of equal width. The delays below
+/// 256 microseconds are counted with a precision of 1 microsecond, and
+/// the width of the buckets holding the greater delays is lower than
+/// 1% of the values they hold. Hence, the percentiles are calculated
+/// with an error lower than 1%.
+///
+/// Two histograms are merged by adding their counters, which allows for
+/// combining the histograms of multiple threads or multiple intervals.
+class LatencyHistogram {
+public:
+
+    /// \brief Constructor.
+    ///
+    /// \param max_seconds maximum delay counted precisely, in seconds.
+    /// The greater delays are counted as this one. It determines the
+    /// number of the buckets.
+    LatencyHistogram(const unsigned int max_seconds = 3600);
+
+    /// \brief Count the delay.
+    ///
+    /// \param usec delay in microseconds.
+    void record(const uint64_t usec);
+
+    /// \brief Add the delays counted by another histogram.
+    ///
+    /// \param other histogram which delays are added.
+    /// \throw isc::BadValue if the other histogram has a different
+    /// maximum delay.
+    void merge(const LatencyHistogram& other);
+
+    /// \brief Remove all the delays counted.
+    void reset();
+
+    /// \brief Return the number of the delays counted.
+    uint64_t getCount() const { return (count_); }
+
+    /// \brief Return the minimum delay counted, in microseconds.
+    ///
+    /// \return minimum delay or 0 if no delay has been counted.
+    uint64_t getMin() const;
+
+    /// \brief Return the maximum delay counted, in microseconds.
+    ///
+    /// \return maximum delay or 0 if no delay has been counted.
+    uint64_t getMax() const { return (max_); }
+
+    /// \brief Return the delay at the specified percentile.
+    ///
+    /// \param percentile percentile, between 0 and 100.
+    /// \throw isc::BadValue if the percentile is out of range.
+    /// \return the highest delay counted in the same bucket as the
+    /// delay which is not exceeded by the specified percentage of the
+    /// delays, in microseconds. It is 0 if no delay has been counted.
+    uint64_t getValueAtPercentile(const double percentile) const;
+
+    /// \brief Return the name of the percentile, e.g. "p99.9".
+    ///
+    /// \param percentile percentile.
+    static std::string getPercentileName(const double percentile);
+
+private:
+
+    /// \brief Return the index of the bucket counting the value.
+    ///
+    /// \param value value, not greater than the maximum value.
+    size_t getIndex(const uint64_t value) const;
+
+    /// \brief Return the highest value counted by the bucket.
+    ///
+    /// \param index index of the bucket.
+    uint64_t getHighestValue(const size_t index) const;
+
+    /// Maximum value counted precisely.
+    uint64_t max_value_;
+
+    /// Counters of the values in each bucket.
+    std::vector<uint64_t> counts_;
+
+    uint64_t count_;    ///< Number of the values counted.
+    uint64_t min_;      ///< Minimum value counted.
+    uint64_t max_;      ///< Maximum value counted.
+};
+
+} // namespace perfdhcp
+} // namespace isc
+
+#endif // LATENCY_HISTOGRAM_H
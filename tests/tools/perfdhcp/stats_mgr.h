@@ -19,6 +19,8 @@
 #include <dhcp/pkt6.h>
 #include <exceptions/exceptions.h>
 
+#include "latency_histogram.h"
+
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/multi_index_container.hpp>
@@ -28,8 +30,12 @@
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <string>
+#include <vector>
 
 
 namespace isc {
@@ -280,6 +286,8 @@ public:
               max_delay_(0.),
               sum_delay_(0.),
               sum_delay_squared_(0.),
+              histogram_(),
+              interval_histogram_(),
               orphans_(0),
               collected_(0),
               unordered_lookup_size_sum_(0),
@@ -370,6 +378,10 @@ public:
             // mean delays.
             sum_delay_ += delta;
             sum_delay_squared_ += delta * delta;
+            // Count the delay in the histograms used to calculate the
+            // percentiles.
+            histogram_.record(period.length().total_microseconds());
+            interval_histogram_.record(period.length().total_microseconds());
         }
 
         /// \brief Match received packet with the corresponding sent packet.
@@ -543,6 +555,34 @@ public:
                         getAvgDelay() * getAvgDelay()));
         }
 
+        /// \brief Return histogram of packet delays.
+        ///
+        /// Method returns histogram of delays of all packets received
+        /// since the test start.
+        ///
+        /// \return histogram of packet delays.
+        const LatencyHistogram& getHistogram() const {
+            return(histogram_);
+        }
+
+        /// \brief Return histogram of packet delays in current interval.
+        ///
+        /// Method returns histogram of delays of packets received since
+        /// the interval histogram was reset for the last time, i.e.
+        /// since the last intermediate report.
+        ///
+        /// \return histogram of packet delays in current interval.
+        const LatencyHistogram& getIntervalHistogram() const {
+            return(interval_histogram_);
+        }
+
+        /// \brief Start new interval.
+        ///
+        /// Method resets histogram of packet delays in current interval.
+        void resetIntervalHistogram() {
+            interval_histogram_.reset();
+        }
+
         /// \brief Return number of orphant packets.
         ///
         /// Method returns number of received packets that had no matching
@@ -628,6 +668,40 @@ public:
             return(drops);
         }
 
+        /// \brief Add statistics of another exchange.
+        ///
+        /// Method adds counters and delays collected for the same
+        /// exchange type by another Statistics Manager, e.g. one used
+        /// by another thread running the test. The received and archived
+        /// packets are appended to the local lists so as their timestamps
+        /// may be printed. Packets waiting for the responses are not
+        /// copied, they are only counted as sent. The earlier of the
+        /// test start times is kept.
+        ///
+        /// \param other statistics to be added.
+        void merge(const ExchangeStats& other) {
+            boot_time_ = std::min(boot_time_, other.boot_time_);
+            min_delay_ = std::min(min_delay_, other.min_delay_);
+            max_delay_ = std::max(max_delay_, other.max_delay_);
+            sum_delay_ += other.sum_delay_;
+            sum_delay_squared_ += other.sum_delay_squared_;
+            histogram_.merge(other.histogram_);
+            interval_histogram_.merge(other.interval_histogram_);
+            orphans_ += other.orphans_;
+            collected_ += other.collected_;
+            unordered_lookup_size_sum_ += other.unordered_lookup_size_sum_;
+            unordered_lookups_ += other.unordered_lookups_;
+            ordered_lookups_ += other.ordered_lookups_;
+            sent_packets_num_ += other.sent_packets_num_;
+            rcvd_packets_num_ += other.rcvd_packets_num_;
+            rcvd_packets_.insert(rcvd_packets_.end(),
+                                 other.rcvd_packets_.begin(),
+                                 other.rcvd_packets_.end());
+            archived_packets_.insert(archived_packets_.end(),
+                                     other.archived_packets_.begin(),
+                                     other.archived_packets_.end());
+        }
+
         /// \brief Print main statistics for packet exchange.
         ///
         /// Method prints main statistics for particular exchange.
@@ -652,7 +726,8 @@ public:
         ///
         /// Method prints round trip time packets statistics. Statistics
         /// includes minimum packet delay, maximum packet delay, average
-        /// packet delay and standard deviation of delays. Packet delay
+        /// packet delay, standard deviation of delays and percentiles
+        /// of delays listed in \ref REPORTED_PERCENTILES. Packet delay
         /// is a duration between sending a packet to server and receiving
         /// response from server.
         void printRTTStats() const {
@@ -663,8 +738,16 @@ public:
                      << "avg delay: " << getAvgDelay() * 1e3 << " ms" << endl
                      << "max delay: " << getMaxDelay() * 1e3 << " ms" << endl
                      << "std deviation: " << getStdDevDelay() * 1e3 << " ms"
-                     << endl
-                     << "collected packets: " << getCollectedNum() << endl;
+                     << endl;
+                for (size_t i = 0; i < REPORTED_PERCENTILES_NUM; ++i) {
+                    cout << LatencyHistogram::
+                        getPercentileName(REPORTED_PERCENTILES[i])
+                         << " delay: "
+                         << histogram_.getValueAtPercentile(
+                                REPORTED_PERCENTILES[i]) / 1e3
+                         << " ms" << endl;
+                }
+                cout << "collected packets: " << getCollectedNum() << endl;
             } catch (const Exception& e) {
                 cout << "Delay summary unavailable! No packets received." << endl;
             }
@@ -806,6 +889,13 @@ public:
         double sum_delay_squared_;     ///< Squared sum of delays between
                                        ///< sent and recived packets.
 
+        /// Histogram of delays between sent and received packets.
+        LatencyHistogram histogram_;
+
+        /// Histogram of delays between sent and received packets in
+        /// the current reporting interval.
+        LatencyHistogram interval_histogram_;
+
         uint64_t orphans_;   ///< Number of orphant received packets.
 
         uint64_t collected_; ///< Number of garbage collected packets.
@@ -999,6 +1089,34 @@ public:
         return(sent_packet);
     }
 
+    /// \brief Add statistics collected by another Statistics Manager.
+    ///
+    /// Method adds statistics of all exchanges and all custom counters
+    /// of the other Statistics Manager to the local ones. It is used
+    /// to combine statistics collected by multiple threads, each having
+    /// its own Statistics Manager, into a single report. The custom
+    /// counters not yet present are created. The test is assumed to
+    /// have started when the first of the Statistics Managers was
+    /// created.
+    ///
+    /// \param other Statistics Manager which statistics are added.
+    /// \throw isc::BadValue if exchange type used by the other
+    /// Statistics Manager has not been specified.
+    void merge(const StatsMgr& other) {
+        boot_time_ = std::min(boot_time_, other.boot_time_);
+        for (ExchangesMapIterator it = other.exchanges_.begin();
+             it != other.exchanges_.end(); ++it) {
+            getExchangeStats(it->first)->merge(*it->second);
+        }
+        for (CustomCountersMapIterator it = other.custom_counters_.begin();
+             it != other.custom_counters_.end(); ++it) {
+            if (custom_counters_.find(it->first) == custom_counters_.end()) {
+                addCustomCounter(it->first, it->second->getName());
+            }
+            *custom_counters_[it->first] += it->second->getValue();
+        }
+    }
+
     /// \brief Return minumum delay between sent and received packet.
     ///
     /// Method returns minimum delay between sent and received packet
@@ -1047,6 +1165,44 @@ public:
         return(xchg_stats->getStdDevDelay());
     }
 
+    /// \brief Return histogram of packet delays.
+    ///
+    /// Method returns histogram of delays of all packets received
+    /// since the test start for specified exchange type.
+    ///
+    /// \param xchg_type exchange type.
+    /// \throw isc::BadValue if invalid exchange type specified.
+    /// \return histogram of packet delays.
+    const LatencyHistogram& getHistogram(const ExchangeType xchg_type) const {
+        ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
+        return(xchg_stats->getHistogram());
+    }
+
+    /// \brief Return histogram of packet delays in current interval.
+    ///
+    /// Method returns histogram of delays of packets received since
+    /// the last intermediate report for specified exchange type.
+    ///
+    /// \param xchg_type exchange type.
+    /// \throw isc::BadValue if invalid exchange type specified.
+    /// \return histogram of packet delays in current interval.
+    const LatencyHistogram&
+    getIntervalHistogram(const ExchangeType xchg_type) const {
+        ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
+        return(xchg_stats->getIntervalHistogram());
+    }
+
+    /// \brief Start new interval.
+    ///
+    /// Method resets histograms of packet delays in current interval
+    /// for all exchange types.
+    void resetIntervalHistograms() {
+        for (ExchangesMapIterator it = exchanges_.begin();
+             it != exchanges_.end(); ++it) {
+            it->second->resetIntervalHistogram();
+        }
+    }
+
     /// \brief Return number of orphant packets.
     ///
     /// Method returns number of orphant packets for specified
@@ -1209,7 +1365,8 @@ public:
     /// - minimum packets delay,
     /// - average packets delay,
     /// - maximum packets delay,
-    /// - standard deviation of packets delay.
+    /// - standard deviation of packets delay,
+    /// - percentiles of packets delay.
     ///
     /// \throw isc::InvalidOperation if no exchange type added to
     /// track statistics.
@@ -1257,6 +1414,95 @@ public:
                   << std::endl;
     }
 
+    /// \brief Write header of statistics in CSV format.
+    ///
+    /// Method writes the line naming the columns of the records
+    /// written by \ref writeStats in CSV format.
+    ///
+    /// \param out stream to which the header is written.
+    static void writeStatsHeader(std::ostream& out) {
+        out << "time,period,exchange,sent,received,drops,samples,min";
+        for (size_t i = 0; i < REPORTED_PERCENTILES_NUM; ++i) {
+            out << ","
+                << LatencyHistogram::getPercentileName(REPORTED_PERCENTILES[i]);
+        }
+        out << ",max" << std::endl;
+    }
+
+    /// \brief Write statistics for all exchange types.
+    ///
+    /// Method writes one record for each exchange type, holding the
+    /// time elapsed since the test start in seconds, the period which
+    /// delays are described, the name of the exchange, the number of
+    /// sent, received and dropped packets since the test start, and
+    /// the number of packet delays, their minimum, their percentiles
+    /// listed in \ref REPORTED_PERCENTILES and their maximum, in
+    /// milliseconds. The records are written as lines of CSV or as
+    /// JSON objects, one per line. The delays are unset if no packet
+    /// has been received in the period.
+    ///
+    /// \param out stream to which statistics are written.
+    /// \param json if true the records are written in JSON, otherwise
+    /// they are written in CSV.
+    /// \param interval if true the delays of packets received in current
+    /// interval are written, otherwise the delays of all packets
+    /// received since the test start are written.
+    void writeStats(std::ostream& out, const bool json,
+                    const bool interval) const {
+        const double time = static_cast<double>(
+            getTestPeriod().length().total_microseconds()) / 1e6;
+        const std::string period(interval ? "interval" : "total");
+        const std::string sep(json ? ", " : ",");
+        out << std::fixed << std::setprecision(3);
+        for (ExchangesMapIterator it = exchanges_.begin();
+             it != exchanges_.end(); ++it) {
+            const LatencyHistogram& histogram = interval ?
+                it->second->getIntervalHistogram() :
+                it->second->getHistogram();
+            std::vector<std::string> names;
+            std::vector<uint64_t> delays;
+            names.push_back("min");
+            delays.push_back(histogram.getMin());
+            for (size_t i = 0; i < REPORTED_PERCENTILES_NUM; ++i) {
+                names.push_back(LatencyHistogram::
+                                getPercentileName(REPORTED_PERCENTILES[i]));
+                delays.push_back(histogram.
+                                 getValueAtPercentile(REPORTED_PERCENTILES[i]));
+            }
+            names.push_back("max");
+            delays.push_back(histogram.getMax());
+
+            if (json) {
+                out << "{\"time\": " << time
+                    << ", \"period\": \"" << period << "\""
+                    << ", \"exchange\": \"" << exchangeToString(it->first)
+                    << "\", \"sent\": " << it->second->getSentPacketsNum()
+                    << ", \"received\": " << it->second->getRcvdPacketsNum()
+                    << ", \"drops\": " << it->second->getDroppedPacketsNum()
+                    << ", \"samples\": " << histogram.getCount();
+            } else {
+                out << time << sep << period << sep
+                    << exchangeToString(it->first) << sep
+                    << it->second->getSentPacketsNum() << sep
+                    << it->second->getRcvdPacketsNum() << sep
+                    << it->second->getDroppedPacketsNum() << sep
+                    << histogram.getCount();
+            }
+            for (size_t i = 0; i < delays.size(); ++i) {
+                out << sep;
+                if (json) {
+                    out << "\"" << names[i] << "\": ";
+                }
+                if (histogram.getCount() > 0) {
+                    out << delays[i] / 1e3;
+                } else if (json) {
+                    out << "null";
+                }
+            }
+            out << (json ? "}" : "") << std::endl;
+        }
+    }
+
     /// \brief Print timestamps of all packets.
     ///
     /// Method prints timestamps of all sent and received
@@ -19,12 +19,17 @@
 #include <dhcp/iface_mgr.h>
 #include <dhcp/dhcp4.h>
 #include <dhcp/option6_ia.h>
+#include <dhcp/pkt_filter_inet.h>
+#include <dhcp/pkt_filter_inet6.h>
+#include <util/io_utilities.h>
+#include <util/threads/thread.h>
 #include <util/unittests/check_valgrind.h>
 #include "test_control.h"
 #include "command_options.h"
 #include "perf_pkt4.h"
 #include "perf_pkt6.h"
 
+#include <algorithm>
 #include <fstream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -33,6 +38,7 @@
 #include <signal.h>
 #include <sys/wait.h>
 
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 using namespace std;
@@ -41,10 +47,66 @@ using namespace isc;
 using namespace isc::dhcp;
 using namespace isc::asiolink;
 
+namespace {
+
+/// Maximum number of packets received by the main thread at once, when
+/// the test is run by multiple threads.
+const size_t THREADS_RECEIVE_BATCH = 64;
+/// Timeout of the main thread waiting for the packets (microseconds).
+const uint32_t THREADS_RECEIVE_TIMEOUT = 100000;
+/// Capacity of the queue of the received packets of each thread.
+const size_t THREADS_QUEUE_CAPACITY = 4096;
+
+/// Returns the share of one thread when the value is divided between
+/// the threads running the test. The remainder is given to the first
+/// threads, so as the shares sum up to the value.
+int
+getThreadShare(const int value, const uint32_t index,
+               const uint32_t threads_num) {
+    return (value / threads_num +
+            ((index < value % threads_num) ? 1 : 0));
+}
+
+/// Takes the packets queued for the thread, waiting for them for the
+/// limited time. The packets are stored in the reverse order, so as the
+/// next one to be processed is at the back of the vector. The vector must
+/// be empty.
+template<typename PktPtr>
+void
+takeQueuedPackets(util::thread::BoundedQueue<PktPtr>& queue,
+                  std::vector<PktPtr>& queued, const uint32_t timeout) {
+    const size_t count = queue.popBatch(queued, THREADS_RECEIVE_BATCH,
+                                        timeout);
+    if (count > 0) {
+        // No one waits for the queue to become idle, so the packets
+        // are considered processed once taken.
+        queue.done(count);
+        std::reverse(queued.begin(), queued.end());
+    }
+}
+
+/// Returns the next packet queued for the thread or NULL if there is none.
+template<typename PktPtr>
+PktPtr
+popQueuedPacket(util::thread::BoundedQueue<PktPtr>& queue,
+                std::vector<PktPtr>& queued) {
+    if (queued.empty()) {
+        takeQueuedPackets(queue, queued, 0);
+        if (queued.empty()) {
+            return (PktPtr());
+        }
+    }
+    PktPtr pkt = queued.back();
+    queued.pop_back();
+    return (pkt);
+}
+
+}
+
 namespace isc {
 namespace perfdhcp {
 
-bool TestControl::interrupted_ = false;
+util::thread::Atomic<bool> TestControl::interrupted_(false);
 
 TestControl::TestControlSocket::TestControlSocket(const int socket) :
     SocketInfo(asiolink::IOAddress("127.0.0.1"), 0, socket),
@@ -93,7 +155,7 @@ TestControl::instance() {
     return (test_control);
 }
 
-TestControl::TestControl() {
+TestControl::TestControl() : stats_json_(false), finished_(false) {
     reset();
 }
 
@@ -121,11 +183,8 @@ TestControl::cleanCachedPackets() {
         return;
     }
 
-    static boost::posix_time::ptime last_clean =
-        microsec_clock::universal_time();
-
     // Check how much time has passed since last cleanup.
-    time_period time_since_clean(last_clean,
+    time_period time_since_clean(last_clean_,
                                  microsec_clock::universal_time());
     // Cleanup every 1 second.
     if (time_since_clean.length().total_seconds() >= 1) {
@@ -134,13 +193,29 @@ TestControl::cleanCachedPackets() {
         // since we want to randomize leases to be renewed so leave 5
         // times more packets to randomize from.
         // @todo The cache size might be controlled from the command line.
-        if (reply_storage_.size() > 5 * options.getRenewRate()) {
+        if (reply_storage_.size() > 5 * renew_rate_control_.getRate()) {
             reply_storage_.clear(reply_storage_.size() -
-                                 5 * options.getRenewRate());
+                                 5 * renew_rate_control_.getRate());
         }
         // Remember when we performed a cleanup for the last time.
         // We want to do the next cleanup not earlier than in one second.
-        last_clean = microsec_clock::universal_time();
+        last_clean_ = microsec_clock::universal_time();
+    }
+}
+
+void
+TestControl::collectStats() {
+    initializeStatsMgr();
+    for (std::vector<boost::shared_ptr<TestControl> >::const_iterator worker =
+             workers_.begin(); worker != workers_.end(); ++worker) {
+        util::thread::Mutex::Locker locker((*worker)->stats_mutex_);
+        if (CommandOptions::instance().getIpVersion() == 4) {
+            stats_mgr4_->merge(*(*worker)->stats_mgr4_);
+            (*worker)->stats_mgr4_->resetIntervalHistograms();
+        } else {
+            stats_mgr6_->merge(*(*worker)->stats_mgr6_);
+            (*worker)->stats_mgr6_->resetIntervalHistograms();
+        }
     }
 }
 
@@ -185,7 +260,7 @@ TestControl::byte2Hex(const uint8_t b) const {
 
 bool
 TestControl::checkExitConditions() const {
-    if (interrupted_) {
+    if (interrupted_.load()) {
         return (true);
     }
     CommandOptions& options = CommandOptions::instance();
@@ -213,29 +288,29 @@ TestControl::checkExitConditions() const {
 
     bool max_requests = false;
     // Check if we reached maximum number of DISCOVER/SOLICIT sent.
-    if (options.getNumRequests().size() > 0) {
+    if (num_requests_.size() > 0) {
         if (options.getIpVersion() == 4) {
             if (getSentPacketsNum(StatsMgr4::XCHG_DO) >=
-                options.getNumRequests()[0]) {
+                num_requests_[0]) {
                 max_requests = true;
             }
         } else if (options.getIpVersion() == 6) {
             if (stats_mgr6_->getSentPacketsNum(StatsMgr6::XCHG_SA) >=
-                options.getNumRequests()[0]) {
+                num_requests_[0]) {
                 max_requests = true;
             }
         }
     }
     // Check if we reached maximum number REQUEST packets.
-    if (options.getNumRequests().size() > 1) {
+    if (num_requests_.size() > 1) {
         if (options.getIpVersion() == 4) {
             if (stats_mgr4_->getSentPacketsNum(StatsMgr4::XCHG_RA) >=
-                options.getNumRequests()[1]) {
+                num_requests_[1]) {
                 max_requests = true;
             }
         } else if (options.getIpVersion() == 6) {
             if (stats_mgr6_->getSentPacketsNum(StatsMgr6::XCHG_RR) >=
-                options.getNumRequests()[1]) {
+                num_requests_[1]) {
                 max_requests = true;
             }
         }
@@ -249,29 +324,29 @@ TestControl::checkExitConditions() const {
 
     // Check if we reached maximum number of drops of OFFER/ADVERTISE packets.
     bool max_drops = false;
-    if (options.getMaxDrop().size() > 0) {
+    if (max_drop_.size() > 0) {
         if (options.getIpVersion() == 4) {
             if (stats_mgr4_->getDroppedPacketsNum(StatsMgr4::XCHG_DO) >=
-                options.getMaxDrop()[0]) {
+                max_drop_[0]) {
                 max_drops = true;
             }
         } else if (options.getIpVersion() == 6) {
             if (stats_mgr6_->getDroppedPacketsNum(StatsMgr6::XCHG_SA) >=
-                options.getMaxDrop()[0]) {
+                max_drop_[0]) {
                 max_drops = true;
             }
         }
     }
     // Check if we reached maximum number of drops of ACK/REPLY packets.
-    if (options.getMaxDrop().size() > 1) {
+    if (max_drop_.size() > 1) {
         if (options.getIpVersion() == 4) {
             if (stats_mgr4_->getDroppedPacketsNum(StatsMgr4::XCHG_RA) >=
-                options.getMaxDrop()[1]) {
+                max_drop_[1]) {
                 max_drops = true;
             }
         } else if (options.getIpVersion() == 6) {
             if (stats_mgr6_->getDroppedPacketsNum(StatsMgr6::XCHG_RR) >=
-                options.getMaxDrop()[1]) {
+                max_drop_[1]) {
                 max_drops = true;
             }
         }
@@ -646,7 +721,7 @@ TestControl::handleChild(int) {
 
 void
 TestControl::handleInterrupt(int) {
-    interrupted_ = true;
+    interrupted_.store(true);
 }
 
 void
@@ -710,6 +785,47 @@ TestControl::initializeStatsMgr() {
     }
 }
 
+void
+TestControl::initThreadShare(const uint32_t index,
+                             const uint32_t threads_num) {
+    CommandOptions& options = CommandOptions::instance();
+    basic_rate_control_.setRate(getThreadShare(options.getRate(), index,
+                                               threads_num));
+    renew_rate_control_.setRate(getThreadShare(options.getRenewRate(), index,
+                                               threads_num));
+    release_rate_control_.setRate(getThreadShare(options.getReleaseRate(),
+                                                 index, threads_num));
+    for (int i = 0; i < num_requests_.size(); ++i) {
+        num_requests_[i] = getThreadShare(num_requests_[i], index,
+                                          threads_num);
+    }
+    for (int i = 0; i < max_drop_.size(); ++i) {
+        max_drop_[i] = getThreadShare(max_drop_[i], index, threads_num);
+    }
+
+    // The thread which initiated the exchange is found from the
+    // transaction id of the response.
+    if (options.getIpVersion() == 4) {
+        setTransidGenerator(NumberGeneratorPtr(new ShardGenerator(index,
+                                                                  threads_num)));
+        packet_filter4_.reset(new PktFilterInet());
+        queue4_.reset(new util::thread::BoundedQueue<Pkt4Ptr>
+                      (THREADS_QUEUE_CAPACITY));
+    } else {
+        setTransidGenerator(NumberGeneratorPtr(new ShardGenerator(index,
+                                                                  threads_num,
+                                                                  0x00FFFFFF)));
+        packet_filter6_.reset(new PktFilterInet6());
+        queue6_.reset(new util::thread::BoundedQueue<Pkt6Ptr>
+                      (THREADS_QUEUE_CAPACITY));
+    }
+    uint32_t clients_num = options.getClientsNum() == 0 ?
+        1 : options.getClientsNum();
+    setMacAddrGenerator(NumberGeneratorPtr(new ShardGenerator(index,
+                                                              threads_num,
+                                                              clients_num)));
+}
+
 int
 TestControl::openSocket() const {
     CommandOptions& options = CommandOptions::instance();
@@ -805,6 +921,26 @@ TestControl::openSocket() const {
     return (sock);
 }
 
+void
+TestControl::openStatsFile() {
+    const std::string file_name = CommandOptions::instance().getStatsFile();
+    if (file_name.empty()) {
+        return;
+    }
+    const std::string json_suffix(".json");
+    stats_json_ = (file_name.size() > json_suffix.size()) &&
+        (file_name.compare(file_name.size() - json_suffix.size(),
+                           json_suffix.size(), json_suffix) == 0);
+    boost::shared_ptr<std::ofstream> file(new std::ofstream(file_name.c_str()));
+    if (!file->is_open()) {
+        isc_throw(BadValue, "unable to open statistics file " << file_name);
+    }
+    if (!stats_json_) {
+        StatsMgr4::writeStatsHeader(*file);
+    }
+    stats_file_ = file;
+}
+
 void
 TestControl::sendPackets(const TestControlSocket& socket,
                          const uint64_t packets_num,
@@ -976,6 +1112,12 @@ TestControl::printIntermediateStats() {
         } else if (options.getIpVersion() == 6) {
             stats_mgr6_->printIntermediateStats();
         }
+        writeStats(true);
+        if (options.getIpVersion() == 4) {
+            stats_mgr4_->resetIntervalHistograms();
+        } else if (options.getIpVersion() == 6) {
+            stats_mgr6_->resetIntervalHistograms();
+        }
         last_report_ = now;
     }
 }
@@ -1005,6 +1147,22 @@ TestControl::printStats() const {
     }
 }
 
+void
+TestControl::writeStats(const bool interval) {
+    if (!stats_file_) {
+        return;
+    }
+    if (CommandOptions::instance().getIpVersion() == 4) {
+        stats_mgr4_->writeStats(*stats_file_, stats_json_, interval);
+    } else {
+        stats_mgr6_->writeStats(*stats_file_, stats_json_, interval);
+    }
+    if (!*stats_file_) {
+        isc_throw(Unexpected, "unable to write statistics to the file: "
+                  << CommandOptions::instance().getStatsFile());
+    }
+}
+
 std::string
 TestControl::vector2Hex(const std::vector<uint8_t>& vec,
                         const std::string& separator /* ="" */) const {
@@ -1155,7 +1313,8 @@ TestControl::receivePackets(const TestControlSocket& socket) {
         if (CommandOptions::instance().getIpVersion() == 4) {
             Pkt4Ptr pkt4;
             try {
-                pkt4 = IfaceMgr::instance().receive4(0, getCurrentTimeout());
+                pkt4 = queue4_ ? popQueuedPacket(*queue4_, queued4_) :
+                    IfaceMgr::instance().receive4(0, getCurrentTimeout());
             } catch (const Exception& e) {
                 std::cerr << "Failed to receive DHCPv4 packet: "
                           << e.what() <<  std::endl;
@@ -1173,7 +1332,8 @@ TestControl::receivePackets(const TestControlSocket& socket) {
         } else if (CommandOptions::instance().getIpVersion() == 6) {
             Pkt6Ptr pkt6;
             try {
-                pkt6 = IfaceMgr::instance().receive6(0, getCurrentTimeout());
+                pkt6 = queue6_ ? popQueuedPacket(*queue6_, queued6_) :
+                    IfaceMgr::instance().receive6(0, getCurrentTimeout());
             } catch (const Exception& e) {
                 std::cerr << "Failed to receive DHCPv6 packet: "
                           << e.what() << std::endl;
@@ -1194,6 +1354,19 @@ TestControl::receivePackets(const TestControlSocket& socket) {
     return (received);
 }
 
+void
+TestControl::waitForQueuedPackets() {
+    // Don't wait too long, so as the exit conditions are checked
+    // regularly.
+    const uint32_t timeout = std::min(getCurrentTimeout(),
+                                      THREADS_RECEIVE_TIMEOUT);
+    if (queue4_ && queued4_.empty()) {
+        takeQueuedPackets(*queue4_, queued4_, timeout);
+    } else if (queue6_ && queued6_.empty()) {
+        takeQueuedPackets(*queue6_, queued6_, timeout);
+    }
+}
+
 void
 TestControl::registerOptionFactories4() const {
     static bool factories_registered = false;
@@ -1286,7 +1459,21 @@ TestControl::reset() {
     setTransidGenerator(NumberGeneratorPtr());
     setMacAddrGenerator(NumberGeneratorPtr());
     first_packet_serverid_.clear();
-    interrupted_ = false;
+    num_requests_ = options.getNumRequests();
+    max_drop_ = options.getMaxDrop();
+    last_clean_ = microsec_clock::universal_time();
+    packet_filter4_.reset();
+    packet_filter6_.reset();
+    queue4_.reset();
+    queue6_.reset();
+    queued4_.clear();
+    queued6_.clear();
+    finished_ = false;
+    error_.clear();
+    workers_.clear();
+    stats_file_.reset();
+    stats_json_ = false;
+    interrupted_.store(false);
 }
 
 int
@@ -1314,6 +1501,9 @@ TestControl::run() {
 
     // Diagnostics are command line options mainly.
     printDiagnostics();
+    // Open the file for the statistics before the test starts, so as
+    // invalid file name is reported early.
+    openStatsFile();
     // Option factories have to be registered.
     registerOptionFactories();
     TestControlSocket socket(openSocket());
@@ -1335,78 +1525,30 @@ TestControl::run() {
     // If user interrupts the program we will exit gracefully.
     signal(SIGINT, TestControl::handleInterrupt);
 
-    // Preload server with the number of packets.
-    sendPackets(socket, options.getPreload(), true);
-
-    // Fork and run command specified with -w<wrapped-command>
-    if (!options.getWrapped().empty()) {
-        runWrapped();
-    }
-
-    // Initialize Statistics Manager. Release previous if any.
-    initializeStatsMgr();
-    for (;;) {
-        // Calculate number of packets to be sent to stay
-        // catch up with rate.
-        uint64_t packets_due = basic_rate_control_.getOutboundMessageCount();
-        checkLateMessages(basic_rate_control_);
-        if ((packets_due == 0) && testDiags('i')) {
-            if (options.getIpVersion() == 4) {
-                stats_mgr4_->incrementCounter("shortwait");
-            } else if (options.getIpVersion() == 6) {
-                stats_mgr6_->incrementCounter("shortwait");
-            }
-        }
-
-        // @todo: set non-zero timeout for packets once we implement
-        // microseconds timeout in IfaceMgr.
-        receivePackets(socket);
-
-        // If test period finished, maximum number of packet drops
-        // has been reached or test has been interrupted we have to
-        // finish the test.
-        if (checkExitConditions()) {
-            break;
-        }
-
-        // Initiate new DHCP packet exchanges.
-        sendPackets(socket, packets_due);
-
-        // If -f<renew-rate> option was specified we have to check how many
-        // Renew packets should be sent to catch up with a desired rate.
-        if ((options.getIpVersion() == 6) && (options.getRenewRate() != 0)) {
-            uint64_t renew_packets_due =
-                renew_rate_control_.getOutboundMessageCount();
-            checkLateMessages(renew_rate_control_);
-            // Send Renew messages.
-            sendMultipleMessages6(socket, DHCPV6_RENEW, renew_packets_due);
-        }
+    if (options.getThreadsNum() > 1) {
+        runThreads(socket);
+    } else {
+        // Preload server with the number of packets.
+        sendPackets(socket, options.getPreload(), true);
 
-        // If -F<release-rate> option was specified we have to check how many
-        // Release messages should be sent to catch up with a desired rate.
-        if ((options.getIpVersion() == 6) && (options.getReleaseRate() != 0)) {
-            uint64_t release_packets_due =
-                release_rate_control_.getOutboundMessageCount();
-            checkLateMessages(release_rate_control_);
-            // Send Release messages.
-            sendMultipleMessages6(socket, DHCPV6_RELEASE, release_packets_due);
+        // Fork and run command specified with -w<wrapped-command>
+        if (!options.getWrapped().empty()) {
+            runWrapped();
         }
 
-        // Report delay means that user requested printing number
-        // of sent/received/dropped packets repeatedly.
-        if (options.getReportDelay() > 0) {
-            printIntermediateStats();
+        // Initialize Statistics Manager. Release previous if any.
+        initializeStatsMgr();
+        while (runIteration(socket)) {
+            // Report delay means that user requested printing number
+            // of sent/received/dropped packets repeatedly.
+            if (options.getReportDelay() > 0) {
+                printIntermediateStats();
+            }
         }
-
-        // If we are sending Renews to the server, the Reply packets are cached
-        // so as leases for which we send Renews can be idenitfied. The major
-        // issue with this approach is that most of the time we are caching
-        // more packets than we actually need. This function removes excessive
-        // Reply messages to reduce the memory and CPU utilization. Note that
-        // searches in the long list of Reply packets increases CPU utilization.
-        cleanCachedPackets();
     }
     printStats();
+    writeStats(false);
+    stats_file_.reset();
 
     if (!options.getWrapped().empty()) {
         // true means that we execute wrapped command with 'stop' argument.
@@ -1447,6 +1589,247 @@ TestControl::run() {
     return (ret_code);
 }
 
+bool
+TestControl::runIteration(const TestControlSocket& socket) {
+    CommandOptions& options = CommandOptions::instance();
+    // Calculate number of packets to be sent to stay
+    // catch up with rate.
+    uint64_t packets_due = basic_rate_control_.getOutboundMessageCount();
+    checkLateMessages(basic_rate_control_);
+    if ((packets_due == 0) && testDiags('i')) {
+        if (options.getIpVersion() == 4) {
+            stats_mgr4_->incrementCounter("shortwait");
+        } else if (options.getIpVersion() == 6) {
+            stats_mgr6_->incrementCounter("shortwait");
+        }
+    }
+
+    // @todo: set non-zero timeout for packets once we implement
+    // microseconds timeout in IfaceMgr.
+    receivePackets(socket);
+
+    // If test period finished, maximum number of packet drops
+    // has been reached or test has been interrupted we have to
+    // finish the test.
+    if (checkExitConditions()) {
+        return (false);
+    }
+
+    // Initiate new DHCP packet exchanges.
+    sendPackets(socket, packets_due);
+
+    // If -f<renew-rate> option was specified we have to check how many
+    // Renew packets should be sent to catch up with a desired rate.
+    if ((options.getIpVersion() == 6) && (options.getRenewRate() != 0)) {
+        uint64_t renew_packets_due =
+            renew_rate_control_.getOutboundMessageCount();
+        checkLateMessages(renew_rate_control_);
+        // Send Renew messages.
+        sendMultipleMessages6(socket, DHCPV6_RENEW, renew_packets_due);
+    }
+
+    // If -F<release-rate> option was specified we have to check how many
+    // Release messages should be sent to catch up with a desired rate.
+    if ((options.getIpVersion() == 6) && (options.getReleaseRate() != 0)) {
+        uint64_t release_packets_due =
+            release_rate_control_.getOutboundMessageCount();
+        checkLateMessages(release_rate_control_);
+        // Send Release messages.
+        sendMultipleMessages6(socket, DHCPV6_RELEASE, release_packets_due);
+    }
+
+    // If we are sending Renews to the server, the Reply packets are cached
+    // so as leases for which we send Renews can be idenitfied. The major
+    // issue with this approach is that most of the time we are caching
+    // more packets than we actually need. This function removes excessive
+    // Reply messages to reduce the memory and CPU utilization. Note that
+    // searches in the long list of Reply packets increases CPU utilization.
+    cleanCachedPackets();
+    return (true);
+}
+
+void
+TestControl::runThread(const TestControlSocket& socket) {
+    try {
+        for (;;) {
+            // The statistics are not locked while waiting, so as the main
+            // thread may collect them for the intermediate reports.
+            waitForQueuedPackets();
+            util::thread::Mutex::Locker locker(stats_mutex_);
+            if (!runIteration(socket)) {
+                finished_ = true;
+                return;
+            }
+        }
+    } catch (const std::exception& ex) {
+        util::thread::Mutex::Locker locker(stats_mutex_);
+        error_ = ex.what();
+        finished_ = true;
+    }
+}
+
+void
+TestControl::dispatchPackets(const std::vector<Pkt4Ptr>& pkts) {
+    const uint32_t threads_num = workers_.size();
+    for (std::vector<Pkt4Ptr>::const_iterator pkt = pkts.begin();
+         pkt != pkts.end(); ++pkt) {
+        const std::vector<uint8_t>& data = (*pkt)->data_;
+        if (data.size() < DHCPV4_TRANSID_OFFSET + 4) {
+            continue;
+        }
+        const uint32_t transid =
+            util::readUint32(&data[DHCPV4_TRANSID_OFFSET], 4);
+        // If the thread can't keep up, the packet is dropped.
+        workers_[transid % threads_num]->queue4_->push(*pkt);
+    }
+}
+
+void
+TestControl::dispatchPackets(const std::vector<Pkt6Ptr>& pkts) {
+    const uint32_t threads_num = workers_.size();
+    for (std::vector<Pkt6Ptr>::const_iterator pkt = pkts.begin();
+         pkt != pkts.end(); ++pkt) {
+        const OptionBuffer& data = (*pkt)->data_;
+        if (data.size() < DHCPV6_TRANSID_OFFSET + 3) {
+            continue;
+        }
+        const uint32_t transid =
+            (data[DHCPV6_TRANSID_OFFSET] << 16) +
+            (data[DHCPV6_TRANSID_OFFSET + 1] << 8) +
+            data[DHCPV6_TRANSID_OFFSET + 2];
+        workers_[transid % threads_num]->queue6_->push(*pkt);
+    }
+}
+
+void
+TestControl::runThreads(const TestControlSocket& socket) {
+    CommandOptions& options = CommandOptions::instance();
+    const uint32_t threads_num = options.getThreadsNum();
+
+    // The standard option definitions are created when they are first
+    // used. Make sure that it doesn't happen in multiple threads at once.
+    LibDHCP::getOptionDefs(options.getIpVersion() == 4 ? Option::V4 :
+                           Option::V6);
+
+    workers_.clear();
+    for (uint32_t i = 0; i < threads_num; ++i) {
+        boost::shared_ptr<TestControl> worker(new TestControl());
+        worker->initThreadShare(i, threads_num);
+        worker->template_buffers_ = template_buffers_;
+        workers_.push_back(worker);
+    }
+
+    // Preload server with the number of packets, each thread sending
+    // the packets of its own clients.
+    for (uint32_t i = 0; i < threads_num; ++i) {
+        workers_[i]->sendPackets(socket,
+                                 getThreadShare(options.getPreload(), i,
+                                                threads_num), true);
+    }
+
+    // Fork and run command specified with -w<wrapped-command>
+    if (!options.getWrapped().empty()) {
+        runWrapped();
+    }
+
+    initializeStatsMgr();
+    for (uint32_t i = 0; i < threads_num; ++i) {
+        workers_[i]->initializeStatsMgr();
+    }
+
+    std::vector<boost::shared_ptr<util::thread::Thread> > threads;
+    std::vector<Pkt4Ptr> pkts4;
+    std::vector<Pkt6Ptr> pkts6;
+    try {
+        for (uint32_t i = 0; i < threads_num; ++i) {
+            threads.push_back(boost::shared_ptr<util::thread::Thread>
+                              (new util::thread::Thread
+                               (boost::bind(&TestControl::runThread,
+                                            workers_[i].get(),
+                                            boost::cref(socket)))));
+        }
+
+        for (;;) {
+            bool finished = true;
+            for (uint32_t i = 0; finished && (i < threads_num); ++i) {
+                util::thread::Mutex::Locker locker(workers_[i]->stats_mutex_);
+                finished = workers_[i]->finished_;
+            }
+            if (finished) {
+                break;
+            }
+
+            // The server sends the responses to the well-known port,
+            // whichever thread has sent the request, so all of them are
+            // received from the one socket and passed to the threads.
+            if (options.getIpVersion() == 4) {
+                pkts4.clear();
+                try {
+                    IfaceMgr::instance().receiveBatch4(pkts4,
+                                                       THREADS_RECEIVE_BATCH,
+                                                       0,
+                                                       THREADS_RECEIVE_TIMEOUT);
+                } catch (const Exception& e) {
+                    std::cerr << "Failed to receive DHCPv4 packet: "
+                              << e.what() <<  std::endl;
+                }
+                dispatchPackets(pkts4);
+            } else {
+                pkts6.clear();
+                try {
+                    IfaceMgr::instance().receiveBatch6(pkts6,
+                                                       THREADS_RECEIVE_BATCH,
+                                                       0,
+                                                       THREADS_RECEIVE_TIMEOUT);
+                } catch (const Exception& e) {
+                    std::cerr << "Failed to receive DHCPv6 packet: "
+                              << e.what() << std::endl;
+                }
+                dispatchPackets(pkts6);
+            }
+
+            // Report delay means that user requested printing number
+            // of sent/received/dropped packets repeatedly.
+            if ((options.getReportDelay() > 0) &&
+                (time_period(last_report_, microsec_clock::universal_time()).
+                 length().total_seconds() >= options.getReportDelay())) {
+                collectStats();
+                printIntermediateStats();
+            }
+        }
+    } catch (...) {
+        // Stop the threads before the objects they use are destroyed.
+        interrupted_.store(true);
+        for (uint32_t i = 0; i < threads.size(); ++i) {
+            threads[i]->wait();
+        }
+        throw;
+    }
+
+    for (uint32_t i = 0; i < threads_num; ++i) {
+        threads[i]->wait();
+    }
+    for (uint32_t i = 0; i < threads_num; ++i) {
+        if (!workers_[i]->error_.empty()) {
+            isc_throw(Unexpected, "thread " << i << " failed: "
+                      << workers_[i]->error_);
+        }
+    }
+
+    collectStats();
+    // Take the first packets sent and the first server id received from
+    // the threads, to print them at the end of the test.
+    for (uint32_t i = 0; i < threads_num; ++i) {
+        template_packets_v4_.insert(workers_[i]->template_packets_v4_.begin(),
+                                    workers_[i]->template_packets_v4_.end());
+        template_packets_v6_.insert(workers_[i]->template_packets_v6_.begin(),
+                                    workers_[i]->template_packets_v6_.end());
+        if (first_packet_serverid_.empty()) {
+            first_packet_serverid_ = workers_[i]->first_packet_serverid_;
+        }
+    }
+}
+
 void
 TestControl::runWrapped(bool do_stop /*= false */) const {
     CommandOptions& options = CommandOptions::instance();
@@ -1515,7 +1898,7 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     pkt4->setHWAddr(HTYPE_ETHER, mac_address.size(), mac_address);
 
     pkt4->pack();
-    IfaceMgr::instance().send(pkt4);
+    sendPacket(socket, pkt4);
     if (!preload) {
         if (!stats_mgr4_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
@@ -1565,7 +1948,7 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     // Pack the input packet buffer to output buffer so as it can
     // be sent to server.
     pkt4->rawPack();
-    IfaceMgr::instance().send(boost::static_pointer_cast<Pkt4>(pkt4));
+    sendPacket(socket, boost::static_pointer_cast<Pkt4>(pkt4));
     if (!preload) {
         if (!stats_mgr4_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
@@ -1578,6 +1961,32 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     saveFirstPacket(pkt4);
 }
 
+void
+TestControl::sendPacket(const TestControlSocket& socket, const Pkt4Ptr& pkt) {
+    if (!packet_filter4_) {
+        IfaceMgr::instance().send(pkt);
+        return;
+    }
+    Iface* iface = IfaceMgr::instance().getIface(socket.ifindex_);
+    if (iface == NULL) {
+        isc_throw(BadValue, "unable to find interface with given index");
+    }
+    packet_filter4_->send(*iface, socket.sockfd_, pkt);
+}
+
+void
+TestControl::sendPacket(const TestControlSocket& socket, const Pkt6Ptr& pkt) {
+    if (!packet_filter6_) {
+        IfaceMgr::instance().send(pkt);
+        return;
+    }
+    Iface* iface = IfaceMgr::instance().getIface(socket.ifindex_);
+    if (iface == NULL) {
+        isc_throw(BadValue, "unable to find interface with given index");
+    }
+    packet_filter6_->send(*iface, socket.sockfd_, pkt);
+}
+
 bool
 TestControl::sendMessageFromReply(const uint16_t msg_type,
                                   const TestControlSocket& socket) {
@@ -1601,7 +2010,7 @@ TestControl::sendMessageFromReply(const uint16_t msg_type,
     setDefaults6(socket, msg);
     msg->pack();
     // And send it.
-    IfaceMgr::instance().send(msg);
+    sendPacket(socket, msg);
     if (!stats_mgr6_) {
         isc_throw(Unexpected, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
@@ -1662,7 +2071,7 @@ TestControl::sendRequest4(const TestControlSocket& socket,
     pkt4->setSecs(static_cast<uint16_t>(elapsed_time / 1000));
     // Prepare on wire data to send.
     pkt4->pack();
-    IfaceMgr::instance().send(pkt4);
+    sendPacket(socket, pkt4);
     if (!stats_mgr4_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
                   "hasn't been initialized");
@@ -1767,7 +2176,7 @@ TestControl::sendRequest4(const TestControlSocket& socket,
     setDefaults4(socket, boost::static_pointer_cast<Pkt4>(pkt4));
     // Prepare on-wire data.
     pkt4->rawPack();
-    IfaceMgr::instance().send(boost::static_pointer_cast<Pkt4>(pkt4));
+    sendPacket(socket, boost::static_pointer_cast<Pkt4>(pkt4));
     if (!stats_mgr4_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
                   "hasn't been initialized");
@@ -1822,7 +2231,7 @@ TestControl::sendRequest6(const TestControlSocket& socket,
     setDefaults6(socket, pkt6);
     // Prepare on-wire data.
     pkt6->pack();
-    IfaceMgr::instance().send(pkt6);
+    sendPacket(socket, pkt6);
     if (!stats_mgr6_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
@@ -1927,7 +2336,7 @@ TestControl::sendRequest6(const TestControlSocket& socket,
     // Prepare on wire data.
     pkt6->rawPack();
     // Send packet.
-    IfaceMgr::instance().send(pkt6);
+    sendPacket(socket, pkt6);
     if (!stats_mgr6_) {
         isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
@@ -1982,7 +2391,7 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
 
     setDefaults6(socket, pkt6);
     pkt6->pack();
-    IfaceMgr::instance().send(pkt6);
+    sendPacket(socket, pkt6);
     if (!preload) {
         if (!stats_mgr6_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
@@ -2027,7 +2436,7 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
     pkt6->rawPack();
     setDefaults6(socket, pkt6);
     // Send solicit packet.
-    IfaceMgr::instance().send(pkt6);
+    sendPacket(socket, pkt6);
     if (!preload) {
         if (!stats_mgr6_) {
             isc_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
@@ -23,6 +23,11 @@
 #include <dhcp/dhcp6.h>
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt6.h>
+#include <dhcp/pkt_filter.h>
+#include <dhcp/pkt_filter6.h>
+#include <util/threads/atomic.h>
+#include <util/threads/bounded_queue.h>
+#include <util/threads/sync.h>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
@@ -235,6 +240,53 @@ public:
         uint32_t range_; ///< Number of unique numbers generated.
     };
 
+    /// \brief Generator of the numbers belonging to one shard.
+    ///
+    /// The numbers lower than the range are divided into shards, the
+    /// number belonging to the shard which index is equal to the remainder
+    /// of its division by the number of shards. This generator returns the
+    /// numbers of one shard sequentially. It is used when the test is run
+    /// by multiple threads, so as each thread simulates its own clients and
+    /// the thread which initiated an exchange is found from the transaction
+    /// id of the server's response.
+    class ShardGenerator : public NumberGenerator {
+    public:
+        /// \brief Constructor.
+        ///
+        /// \param shard index of the shard.
+        /// \param shards_num number of shards.
+        /// \param range maximum number generated. If 0 is given then
+        /// range defaults to maximum uint32_t value.
+        ShardGenerator(const uint32_t shard, const uint32_t shards_num,
+                       const uint32_t range = 0xFFFFFFFF) :
+            NumberGenerator(),
+            first_(shard),
+            num_(0),
+            shards_num_(shards_num == 0 ? 1 : shards_num),
+            range_(range == 0 ? 0xFFFFFFFF : range) {
+            // If there are fewer numbers than shards, the shard shares
+            // the numbers of another one.
+            first_ %= range_;
+            num_ = first_;
+        }
+
+        /// \brief Generate the next number of the shard.
+        ///
+        /// \return generated number.
+        virtual uint32_t generate() {
+            uint32_t num = num_;
+            // Use 64 bits so as the sum doesn't overflow.
+            const uint64_t next = static_cast<uint64_t>(num_) + shards_num_;
+            num_ = (next < range_) ? static_cast<uint32_t>(next) : first_;
+            return (num);
+        }
+    private:
+        uint32_t first_;      ///< First number of the shard.
+        uint32_t num_;        ///< Current number.
+        uint32_t shards_num_; ///< Number of shards.
+        uint32_t range_;      ///< Number of unique numbers in all shards.
+    };
+
     /// \brief Length of the Ethernet HW address (MAC) in bytes.
     ///
     /// \todo Make this variable length as there are cases when HW
@@ -314,6 +366,15 @@ protected:
     /// has been reached.
     void cleanCachedPackets();
 
+    /// \brief Combines the statistics of the threads running the test.
+    ///
+    /// This function replaces the Statistics Manager with the one holding
+    /// the statistics gathered by all threads so far. The histograms of
+    /// the packet delays in current interval are reset in the threads, so
+    /// as the next intermediate report describes the packets received
+    /// after this one.
+    void collectStats();
+
     /// \brief Creates DHCPv6 message from the Reply packet.
     ///
     /// This function creates DHCPv6 Renew or Release message using the
@@ -519,6 +580,20 @@ protected:
     /// the one initialized already it is released.
     void initializeStatsMgr();
 
+    /// \brief Prepare the instance to run the share of the test.
+    ///
+    /// When the test is run by multiple threads, each thread uses its own
+    /// instance of this class. This function sets the rates, the number of
+    /// requests and the number of drops which end the test to their share
+    /// for this instance. It also sets the generators, so as the instance
+    /// simulates its own clients and uses its own transaction ids: the
+    /// transaction id of the instance with the given index gives this
+    /// index when divided by the number of threads.
+    ///
+    /// \param index index of the thread.
+    /// \param threads_num number of threads.
+    void initThreadShare(const uint32_t index, const uint32_t threads_num);
+
     /// \brief Open socket to communicate with DHCP server.
     ///
     /// Method opens socket and binds it to local address. Function will
@@ -539,6 +614,16 @@ protected:
     /// \return socket descriptor.
     int openSocket() const;
 
+    /// \brief Open the file to which statistics are written.
+    ///
+    /// The file is opened if it was specified with -H<stats-file>.
+    /// The statistics are written in JSON if the file name ends with
+    /// ".json" and in CSV otherwise. In the latter case the header line
+    /// is written.
+    ///
+    /// \throw isc::BadValue if the file can't be opened.
+    void openStatsFile();
+
     /// \brief Print intermediate statistics.
     ///
     /// Print brief statistics regarding number of sent packets,
@@ -557,6 +642,16 @@ protected:
     /// not initialized.
     void printStats() const;
 
+    /// \brief Write statistics to the statistics file.
+    ///
+    /// Method writes a record for each exchange to the file specified
+    /// with -H<stats-file>, if any.
+    ///
+    /// \param interval if true the delays of the packets received in
+    /// the current interval are written, otherwise the delays of all
+    /// packets received since the test start are written.
+    void writeStats(const bool interval);
+
     /// \brief Process received DHCPv4 packet.
     ///
     /// Method performs processing of the received DHCPv4 packet,
@@ -607,6 +702,15 @@ protected:
     /// \return number of received packets.
     uint64_t receivePackets(const TestControlSocket& socket);
 
+    /// \brief Wait for the packets passed to this thread.
+    ///
+    /// When the test is run by multiple threads, the packets received
+    /// by the main thread are queued for the thread which sent the
+    /// matching request. This function waits until some packets are
+    /// queued or the time to send the next packets has come. The queued
+    /// packets are processed by the following call to \ref receivePackets.
+    void waitForQueuedPackets();
+
     /// \brief Register option factory functions for DHCPv4
     ///
     /// Method registers option factory functions for DHCPv4.
@@ -709,6 +813,25 @@ protected:
                        const std::vector<uint8_t>& template_buf,
                        const bool preload = false);
 
+    /// \brief Send the DHCPv4 packet.
+    ///
+    /// The packet is sent over the provided socket, using the packet
+    /// filter of this instance, if there is any, or the Interface Manager.
+    ///
+    /// \param socket socket to be used.
+    /// \param pkt packet to be sent.
+    /// \throw isc::BadValue if the interface of the socket is unknown.
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void sendPacket(const TestControlSocket& socket, const dhcp::Pkt4Ptr& pkt);
+
+    /// \brief Send the DHCPv6 packet.
+    ///
+    /// \param socket socket to be used.
+    /// \param pkt packet to be sent.
+    /// \throw isc::BadValue if the interface of the socket is unknown.
+    /// \throw isc::dhcp::SocketWriteError if failed to send the packet.
+    void sendPacket(const TestControlSocket& socket, const dhcp::Pkt6Ptr& pkt);
+
     /// \brief Send number of packets to initiate new exchanges.
     ///
     /// Method initiates the new DHCP exchanges by sending number
@@ -1047,6 +1170,56 @@ protected:
     /// spaces or hexadecimal digits.
     void readPacketTemplate(const std::string& file_name);
 
+    /// \brief Run one iteration of the test loop.
+    ///
+    /// Receives the packets from the server, checks the exit conditions
+    /// and sends the packets which are due, including Renew and Release
+    /// messages.
+    ///
+    /// \param socket socket to be used.
+    /// \return false if the exit conditions are fulfilled and the test
+    /// must end, true otherwise.
+    bool runIteration(const TestControlSocket& socket);
+
+    /// \brief Run the share of the test of one thread.
+    ///
+    /// This is the main function of the thread running the test loop of
+    /// this instance, until the exit conditions of this instance are
+    /// fulfilled. An exception thrown by the loop ends the thread and is
+    /// reported by the main thread.
+    ///
+    /// \param socket socket to be used.
+    void runThread(const TestControlSocket& socket);
+
+    /// \brief Pass the received DHCPv4 packets to the threads.
+    ///
+    /// Each packet is queued for the thread which sent the request,
+    /// found from the transaction id, and parsed by that thread. The
+    /// packets too short to hold a transaction id are dropped, as are the
+    /// packets for which the queue of the thread is full.
+    ///
+    /// \param pkts packets received by the main thread.
+    void dispatchPackets(const std::vector<dhcp::Pkt4Ptr>& pkts);
+
+    /// \brief Pass the received DHCPv6 packets to the threads.
+    ///
+    /// \param pkts packets received by the main thread.
+    void dispatchPackets(const std::vector<dhcp::Pkt6Ptr>& pkts);
+
+    /// \brief Run the test with multiple threads.
+    ///
+    /// Each thread sends the packets of its own clients, using its own
+    /// instance of this class, and processes the responses. The main
+    /// thread receives all responses and passes them to the threads which
+    /// sent the requests, as the server sends them to the same port
+    /// whichever thread has sent the request. It also prints the
+    /// intermediate reports. When all threads are done, the Statistics
+    /// Manager of this instance holds the statistics of all of them.
+    ///
+    /// \param socket socket to be used.
+    /// \throw isc::Unexpected if a thread ended with an error.
+    void runThreads(const TestControlSocket& socket);
+
     /// \brief Run wrapped command.
     ///
     /// \param do_stop execute wrapped command with "stop" argument.
@@ -1070,6 +1243,11 @@ protected:
 
     boost::posix_time::ptime last_report_; ///< Last intermediate report time.
 
+    /// File to which statistics are written.
+    boost::shared_ptr<std::ostream> stats_file_;
+    /// Indicates that statistics are written in JSON rather than CSV.
+    bool stats_json_;
+
     StatsMgr4Ptr stats_mgr4_;  ///< Statistics Manager 4.
     StatsMgr6Ptr stats_mgr6_;  ///< Statistics Manager 6.
 
@@ -1089,7 +1267,41 @@ protected:
     std::map<uint8_t, dhcp::Pkt4Ptr> template_packets_v4_;
     std::map<uint8_t, dhcp::Pkt6Ptr> template_packets_v6_;
 
-    static bool interrupted_;  ///< Is program interrupted.
+    /// Number of sent Discover/Solicit and Request packets which
+    /// ends the test. It is the share of this instance when the test is
+    /// run by multiple threads.
+    std::vector<int> num_requests_;
+    /// Number of dropped packets which ends the test.
+    std::vector<int> max_drop_;
+
+    /// Time of the last cleanup of the cached Reply packets.
+    boost::posix_time::ptime last_clean_;
+
+    /// Packet filters used to send the packets when the test is run by
+    /// multiple threads. The filters of the Interface Manager must not
+    /// be used by multiple threads at the same time.
+    dhcp::PktFilterPtr packet_filter4_;
+    dhcp::PktFilter6Ptr packet_filter6_;
+
+    /// Queues of the packets received by the main thread for this one.
+    boost::shared_ptr<util::thread::BoundedQueue<dhcp::Pkt4Ptr> > queue4_;
+    boost::shared_ptr<util::thread::BoundedQueue<dhcp::Pkt6Ptr> > queue6_;
+    /// Packets taken from the queue, waiting to be processed.
+    std::vector<dhcp::Pkt4Ptr> queued4_;
+    std::vector<dhcp::Pkt6Ptr> queued6_;
+
+    /// Protects the statistics, read by the main thread while this
+    /// instance runs in its own thread, and the state of the thread.
+    util::thread::Mutex stats_mutex_;
+    bool finished_;     ///< Is the thread done.
+    std::string error_; ///< Error which ended the thread.
+
+    /// Instances running the test in their threads.
+    std::vector<boost::shared_ptr<TestControl> > workers_;
+
+    /// Is program interrupted. It is set by the signal handler and read
+    /// by all threads running the test.
+    static util::thread::Atomic<bool> interrupted_;
 };
 
 } // namespace perfdhcp
@@ -242,6 +242,7 @@ protected:
         EXPECT_GT(0, opt.getRequestedIpOffset());
         EXPECT_EQ("", opt.getDiags());
         EXPECT_EQ("", opt.getWrapped());
+        EXPECT_EQ("", opt.getStatsFile());
         EXPECT_EQ("192.168.0.1", opt.getServerName());
     }
 };
@@ -681,6 +682,17 @@ TEST_F(CommandOptionsTest, Wrapped) {
                  isc::InvalidParameter);
 }
 
+TEST_F(CommandOptionsTest, StatsFile) {
+    CommandOptions& opt = CommandOptions::instance();
+    EXPECT_NO_THROW(process("perfdhcp -l ethx -H stats.csv all"));
+    EXPECT_EQ("stats.csv", opt.getStatsFile());
+
+    // Negative test cases
+    // Missing file name after -H
+    EXPECT_THROW(process("perfdhcp -l ethx -H all"),
+                 isc::InvalidParameter);
+}
+
 TEST_F(CommandOptionsTest, Diagnostics) {
     CommandOptions& opt = CommandOptions::instance();
     EXPECT_NO_THROW(process("perfdhcp -l ethx -i -x asTe all"));
@@ -757,6 +769,28 @@ TEST_F(CommandOptionsTest, NumRequest) {
                  isc::InvalidParameter);
 }
 
+TEST_F(CommandOptionsTest, Threads) {
+    CommandOptions& opt = CommandOptions::instance();
+    EXPECT_NO_THROW(process("perfdhcp -l ethx all"));
+    EXPECT_EQ(1, opt.getThreadsNum());
+    EXPECT_NO_THROW(process("perfdhcp -g 4 -r 100 -D 10 -D 5% -l ethx all"));
+    EXPECT_EQ(4, opt.getThreadsNum());
+
+    // Negative test cases
+    // Number of threads must be positive integer
+    EXPECT_THROW(process("perfdhcp -g 0 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -g -2 -l ethx all"),
+                 isc::InvalidParameter);
+    // Each thread must have its share of the rates and drops
+    EXPECT_THROW(process("perfdhcp -g 4 -r 3 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -6 -g 4 -r 10 -f 2 -l ethx all"),
+                 isc::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -g 4 -r 10 -D 3 -l ethx all"),
+                 isc::InvalidParameter);
+}
+
 TEST_F(CommandOptionsTest, Period) {
     CommandOptions& opt = CommandOptions::instance();
     EXPECT_NO_THROW(process("perfdhcp -p 120 -l ethx -r 100 all"));
@@ -0,0 +1,130 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+#include "latency_histogram.h"
+#include <gtest/gtest.h>
+
+
+using namespace isc;
+using namespace isc::perfdhcp;
+
+namespace {
+
+// Checks that the empty histogram reports zeros.
+TEST(LatencyHistogram, empty) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.getCount());
+    EXPECT_EQ(0, histogram.getMin());
+    EXPECT_EQ(0, histogram.getMax());
+    EXPECT_EQ(0, histogram.getValueAtPercentile(50));
+    EXPECT_THROW(histogram.getValueAtPercentile(-1), isc::BadValue);
+    EXPECT_THROW(histogram.getValueAtPercentile(100.1), isc::BadValue);
+}
+
+// Checks that the small values are counted precisely.
+TEST(LatencyHistogram, smallValues) {
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 100; ++value) {
+        histogram.record(value);
+    }
+    EXPECT_EQ(100, histogram.getCount());
+    EXPECT_EQ(1, histogram.getMin());
+    EXPECT_EQ(100, histogram.getMax());
+    EXPECT_EQ(1, histogram.getValueAtPercentile(0));
+    EXPECT_EQ(1, histogram.getValueAtPercentile(1));
+    EXPECT_EQ(50, histogram.getValueAtPercentile(50));
+    EXPECT_EQ(90, histogram.getValueAtPercentile(90));
+    EXPECT_EQ(99, histogram.getValueAtPercentile(99));
+    EXPECT_EQ(100, histogram.getValueAtPercentile(99.9));
+    EXPECT_EQ(100, histogram.getValueAtPercentile(100));
+}
+
+// Checks that the percentiles of the large values are calculated with
+// the relative error lower than 1%, and that the tail is reported.
+TEST(LatencyHistogram, largeValues) {
+    LatencyHistogram histogram;
+    // 99% of the values are 1ms-10ms and 1% are 1s.
+    for (uint64_t value = 1000; value < 10900; value += 10) {
+        histogram.record(value);
+    }
+    for (int i = 0; i < 10; ++i) {
+        histogram.record(1000000);
+    }
+    EXPECT_EQ(1000, histogram.getCount());
+    EXPECT_EQ(1000, histogram.getMin());
+    EXPECT_EQ(1000000, histogram.getMax());
+
+    // The 500th value is 5990.
+    const uint64_t p50 = histogram.getValueAtPercentile(50);
+    EXPECT_GE(p50, 5990);
+    EXPECT_LE(p50, 5990 * 1.01);
+    // The 990th value is 10890.
+    const uint64_t p99 = histogram.getValueAtPercentile(99);
+    EXPECT_GE(p99, 10890);
+    EXPECT_LE(p99, 10890 * 1.01);
+    // The highest percentiles fall in the bucket of 1s, which doesn't
+    // exceed the maximum value.
+    EXPECT_EQ(1000000, histogram.getValueAtPercentile(99.9));
+    EXPECT_EQ(1000000, histogram.getValueAtPercentile(99.99));
+}
+
+// Checks that the values greater than the maximum are counted as the
+// maximum.
+TEST(LatencyHistogram, maxValue) {
+    LatencyHistogram histogram(1);
+    histogram.record(5000000);
+    EXPECT_EQ(1, histogram.getCount());
+    EXPECT_EQ(1000000, histogram.getMax());
+    EXPECT_EQ(1000000, histogram.getValueAtPercentile(100));
+}
+
+// Checks that the histograms are merged and reset.
+TEST(LatencyHistogram, mergeReset) {
+    LatencyHistogram histogram1;
+    LatencyHistogram histogram2;
+    for (uint64_t value = 1; value <= 50; ++value) {
+        histogram1.record(value);
+        histogram2.record(value + 50);
+    }
+    histogram1.merge(histogram2);
+    EXPECT_EQ(100, histogram1.getCount());
+    EXPECT_EQ(1, histogram1.getMin());
+    EXPECT_EQ(100, histogram1.getMax());
+    EXPECT_EQ(90, histogram1.getValueAtPercentile(90));
+    // The merged histogram is not modified.
+    EXPECT_EQ(50, histogram2.getCount());
+
+    // The histograms with different layouts can't be merged.
+    LatencyHistogram histogram3(1);
+    EXPECT_THROW(histogram1.merge(histogram3), isc::BadValue);
+
+    histogram1.reset();
+    EXPECT_EQ(0, histogram1.getCount());
+    EXPECT_EQ(0, histogram1.getMin());
+    EXPECT_EQ(0, histogram1.getMax());
+    EXPECT_EQ(0, histogram1.getValueAtPercentile(90));
+    histogram1.record(7);
+    EXPECT_EQ(7, histogram1.getMin());
+    EXPECT_EQ(7, histogram1.getValueAtPercentile(90));
+}
+
+// Checks the names of the percentiles.
+TEST(LatencyHistogram, percentileName) {
+    EXPECT_EQ("p50", LatencyHistogram::getPercentileName(50));
+    EXPECT_EQ("p99.9", LatencyHistogram::getPercentileName(99.9));
+    EXPECT_EQ("p99.99", LatencyHistogram::getPercentileName(99.99));
+}
+
+}
@@ -22,6 +22,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <sstream>
+
 #include "../stats_mgr.h"
 
 using namespace std;
@@ -434,6 +437,130 @@ TEST_F(StatsMgrTest, CustomCounters) {
 
 }
 
+TEST_F(StatsMgrTest, Merge) {
+    boost::scoped_ptr<StatsMgr4> stats_mgr(new StatsMgr4());
+    stats_mgr->addExchangeStats(StatsMgr4::XCHG_DO);
+    boost::scoped_ptr<StatsMgr4> other(new StatsMgr4());
+    other->addExchangeStats(StatsMgr4::XCHG_DO);
+    other->addCustomCounter("latesend", "Late sent packets");
+
+    // Three packets sent and two responses received by the first
+    // Statistics Manager.
+    for (uint32_t transid = 0; transid < 3; ++transid) {
+        boost::shared_ptr<Pkt4> sent(createPacket4(DHCPDISCOVER, transid));
+        ASSERT_NO_THROW(stats_mgr->passSentPacket(StatsMgr4::XCHG_DO, sent));
+    }
+    for (uint32_t transid = 0; transid < 2; ++transid) {
+        boost::shared_ptr<Pkt4> rcvd(createPacket4(DHCPOFFER, transid));
+        ASSERT_NO_THROW(stats_mgr->passRcvdPacket(StatsMgr4::XCHG_DO, rcvd));
+    }
+
+    // Two packets sent and received by the other one, which also gets
+    // an orphan and counts late sent packets.
+    for (uint32_t transid = 10; transid < 12; ++transid) {
+        boost::shared_ptr<Pkt4> sent(createPacket4(DHCPDISCOVER, transid));
+        ASSERT_NO_THROW(other->passSentPacket(StatsMgr4::XCHG_DO, sent));
+        boost::shared_ptr<Pkt4> rcvd(createPacket4(DHCPOFFER, transid));
+        ASSERT_NO_THROW(other->passRcvdPacket(StatsMgr4::XCHG_DO, rcvd));
+    }
+    boost::shared_ptr<Pkt4> orphan(createPacket4(DHCPOFFER, 99));
+    ASSERT_NO_THROW(other->passRcvdPacket(StatsMgr4::XCHG_DO, orphan));
+    other->incrementCounter("latesend", 3);
+
+    ASSERT_NO_THROW(stats_mgr->merge(*other));
+    EXPECT_EQ(5, stats_mgr->getSentPacketsNum(StatsMgr4::XCHG_DO));
+    EXPECT_EQ(4, stats_mgr->getRcvdPacketsNum(StatsMgr4::XCHG_DO));
+    EXPECT_EQ(1, stats_mgr->getDroppedPacketsNum(StatsMgr4::XCHG_DO));
+    EXPECT_EQ(1, stats_mgr->getOrphans(StatsMgr4::XCHG_DO));
+    EXPECT_EQ(3, stats_mgr->getCounter("latesend")->getValue());
+    // The merged Statistics Manager is not modified.
+    EXPECT_EQ(2, other->getSentPacketsNum(StatsMgr4::XCHG_DO));
+
+    // The exchanges of the other Statistics Manager must exist.
+    boost::scoped_ptr<StatsMgr4> other_ra(new StatsMgr4());
+    other_ra->addExchangeStats(StatsMgr4::XCHG_RA);
+    EXPECT_THROW(stats_mgr->merge(*other_ra), isc::BadValue);
+}
+
+TEST_F(StatsMgrTest, Histograms) {
+    boost::scoped_ptr<StatsMgr4> stats_mgr(new StatsMgr4());
+    stats_mgr->addExchangeStats(StatsMgr4::XCHG_DO);
+    stats_mgr->addExchangeStats(StatsMgr4::XCHG_RA);
+
+    // Three exchanges are counted in both histograms.
+    for (uint32_t transid = 0; transid < 3; ++transid) {
+        boost::shared_ptr<Pkt4> sent(createPacket4(DHCPDISCOVER, transid));
+        ASSERT_NO_THROW(stats_mgr->passSentPacket(StatsMgr4::XCHG_DO, sent));
+        boost::shared_ptr<Pkt4> rcvd(createPacket4(DHCPOFFER, transid));
+        ASSERT_NO_THROW(stats_mgr->passRcvdPacket(StatsMgr4::XCHG_DO, rcvd));
+    }
+    EXPECT_EQ(3, stats_mgr->getHistogram(StatsMgr4::XCHG_DO).getCount());
+    EXPECT_EQ(3, stats_mgr->getIntervalHistogram(StatsMgr4::XCHG_DO).
+              getCount());
+    EXPECT_EQ(0, stats_mgr->getHistogram(StatsMgr4::XCHG_RA).getCount());
+    EXPECT_LE(stats_mgr->getHistogram(StatsMgr4::XCHG_DO).
+              getValueAtPercentile(99),
+              stats_mgr->getMaxDelay(StatsMgr4::XCHG_DO) * 1e6 + 1);
+
+    // The new interval starts with an empty histogram.
+    stats_mgr->resetIntervalHistograms();
+    EXPECT_EQ(0, stats_mgr->getIntervalHistogram(StatsMgr4::XCHG_DO).
+              getCount());
+    boost::shared_ptr<Pkt4> sent(createPacket4(DHCPDISCOVER, 3));
+    ASSERT_NO_THROW(stats_mgr->passSentPacket(StatsMgr4::XCHG_DO, sent));
+    boost::shared_ptr<Pkt4> rcvd(createPacket4(DHCPOFFER, 3));
+    ASSERT_NO_THROW(stats_mgr->passRcvdPacket(StatsMgr4::XCHG_DO, rcvd));
+    EXPECT_EQ(4, stats_mgr->getHistogram(StatsMgr4::XCHG_DO).getCount());
+    EXPECT_EQ(1, stats_mgr->getIntervalHistogram(StatsMgr4::XCHG_DO).
+              getCount());
+
+    // The histograms are merged.
+    boost::scoped_ptr<StatsMgr4> merged(new StatsMgr4());
+    merged->addExchangeStats(StatsMgr4::XCHG_DO);
+    merged->addExchangeStats(StatsMgr4::XCHG_RA);
+    ASSERT_NO_THROW(merged->merge(*stats_mgr));
+    EXPECT_EQ(4, merged->getHistogram(StatsMgr4::XCHG_DO).getCount());
+    EXPECT_EQ(1, merged->getIntervalHistogram(StatsMgr4::XCHG_DO).
+              getCount());
+
+    // Each exchange is written in a CSV line. The delays of the exchange
+    // without packets are left empty.
+    std::ostringstream csv;
+    StatsMgr4::writeStatsHeader(csv);
+    stats_mgr->writeStats(csv, false, true);
+    std::istringstream csv_lines(csv.str());
+    std::string line;
+    ASSERT_TRUE(std::getline(csv_lines, line));
+    EXPECT_EQ("time,period,exchange,sent,received,drops,samples,min,"
+              "p50,p90,p99,p99.9,p99.99,max", line);
+    ASSERT_TRUE(std::getline(csv_lines, line));
+    EXPECT_NE(std::string::npos,
+              line.find(",interval,DISCOVER-OFFER,4,4,0,1,"));
+    EXPECT_EQ(13, std::count(line.begin(), line.end(), ','));
+    ASSERT_TRUE(std::getline(csv_lines, line));
+    EXPECT_NE(std::string::npos,
+              line.find(",interval,REQUEST-ACK,0,0,0,0,,,,,,,"));
+    EXPECT_FALSE(std::getline(csv_lines, line));
+
+    // Each exchange is written in a JSON object.
+    std::ostringstream json;
+    stats_mgr->writeStats(json, true, false);
+    std::istringstream json_lines(json.str());
+    ASSERT_TRUE(std::getline(json_lines, line));
+    EXPECT_EQ(0, line.find("{\"time\": "));
+    EXPECT_NE(std::string::npos,
+              line.find("\"period\": \"total\", "
+                        "\"exchange\": \"DISCOVER-OFFER\", \"sent\": 4, "
+                        "\"received\": 4, \"drops\": 0, \"samples\": 4, "
+                        "\"min\": "));
+    EXPECT_NE(std::string::npos, line.find("\"p99.99\": "));
+    EXPECT_EQ('}', line[line.size() - 1]);
+    ASSERT_TRUE(std::getline(json_lines, line));
+    EXPECT_NE(std::string::npos, line.find("\"samples\": 0, "
+                                           "\"min\": null, "));
+    EXPECT_FALSE(std::getline(json_lines, line));
+}
+
 TEST_F(StatsMgrTest, PrintStats) {
     std::cout << "This unit test is checking statistics printing "
               << "capabilities. It is expected that some counters "
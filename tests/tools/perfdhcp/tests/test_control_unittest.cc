@@ -100,6 +100,7 @@ public:
 
     using TestControl::checkExitConditions;
     using TestControl::createMessageFromReply;
+    using TestControl::dispatchPackets;
     using TestControl::factoryElapsedTime6;
     using TestControl::factoryGeneric;
     using TestControl::factoryIana6;
@@ -111,10 +112,12 @@ public:
     using TestControl::getCurrentTimeout;
     using TestControl::getTemplateBuffer;
     using TestControl::initPacketTemplates;
+    using TestControl::initThreadShare;
     using TestControl::initializeStatsMgr;
     using TestControl::openSocket;
     using TestControl::processReceivedPacket4;
     using TestControl::processReceivedPacket6;
+    using TestControl::receivePackets;
     using TestControl::registerOptionFactories;
     using TestControl::reset;
     using TestControl::sendDiscover4;
@@ -132,6 +135,10 @@ public:
     using TestControl::macaddr_gen_;
     using TestControl::first_packet_serverid_;
     using TestControl::interrupted_;
+    using TestControl::num_requests_;
+    using TestControl::max_drop_;
+    using TestControl::stats_mgr4_;
+    using TestControl::workers_;
 
     NakedTestControl() : TestControl() {
         uint32_t clients_num = CommandOptions::instance().getClientsNum() == 0 ?
@@ -908,6 +915,7 @@ public:
 TEST_F(TestControlTest, reset) {
     ASSERT_NO_THROW(processCmdLine("perfdhcp -6 -l ethx -r 50 -f 30 -F 10 -a 3 all"));
     NakedTestControl tc;
+    tc.interrupted_.store(true);
     tc.reset();
     EXPECT_EQ(3, tc.basic_rate_control_.getAggressivity());
     EXPECT_EQ(3, tc.renew_rate_control_.getAggressivity());
@@ -919,10 +927,129 @@ TEST_F(TestControlTest, reset) {
     EXPECT_FALSE(tc.transid_gen_);
     EXPECT_FALSE(tc.macaddr_gen_);
     EXPECT_TRUE(tc.first_packet_serverid_.empty());
-    EXPECT_FALSE(tc.interrupted_);
+    EXPECT_FALSE(tc.interrupted_.load());
 
 }
 
+// This test verifies that the numbers of one shard are generated.
+TEST_F(TestControlTest, ShardGenerator) {
+    TestControl::ShardGenerator gen(1, 3);
+    EXPECT_EQ(1, gen.generate());
+    EXPECT_EQ(4, gen.generate());
+    EXPECT_EQ(7, gen.generate());
+
+    // The generator wraps when it reaches the range.
+    TestControl::ShardGenerator gen_range(2, 3, 9);
+    EXPECT_EQ(2, gen_range.generate());
+    EXPECT_EQ(5, gen_range.generate());
+    EXPECT_EQ(8, gen_range.generate());
+    EXPECT_EQ(2, gen_range.generate());
+
+    // The last numbers below the maximum range don't overflow.
+    TestControl::ShardGenerator gen_max(0, 0x80000000);
+    EXPECT_EQ(0, gen_max.generate());
+    EXPECT_EQ(0x80000000, gen_max.generate());
+    EXPECT_EQ(0, gen_max.generate());
+
+    // When there are fewer numbers than shards, the shards share them.
+    TestControl::ShardGenerator gen_small(5, 8, 4);
+    EXPECT_EQ(1, gen_small.generate());
+    EXPECT_EQ(1, gen_small.generate());
+}
+
+// This test verifies that each thread gets its share of the test.
+TEST_F(TestControlTest, initThreadShare) {
+    ASSERT_NO_THROW(processCmdLine("perfdhcp -6 -l lo -r 10 -f 5 -F 3"
+                                   " -n 7 -D 5 -R 100 -g 3 ::1"));
+    // The remainders are given to the first threads.
+    const int rates[] = { 4, 3, 3 };
+    const int renew_rates[] = { 2, 2, 1 };
+    const int num_requests[] = { 3, 2, 2 };
+    const int max_drops[] = { 2, 2, 1 };
+    for (int i = 0; i < 3; ++i) {
+        SCOPED_TRACE(i);
+        NakedTestControl tc;
+        tc.initThreadShare(i, 3);
+        EXPECT_EQ(rates[i], tc.basic_rate_control_.getRate());
+        EXPECT_EQ(renew_rates[i], tc.renew_rate_control_.getRate());
+        EXPECT_EQ(1, tc.release_rate_control_.getRate());
+        ASSERT_EQ(1, tc.num_requests_.size());
+        EXPECT_EQ(num_requests[i], tc.num_requests_[0]);
+        ASSERT_EQ(1, tc.max_drop_.size());
+        EXPECT_EQ(max_drops[i], tc.max_drop_[0]);
+
+        // The thread which sent the packet is found from its transaction
+        // id and each thread uses its own clients.
+        for (int j = 0; j < 10; ++j) {
+            EXPECT_EQ(i, tc.transid_gen_->generate() % 3);
+            EXPECT_EQ(i, tc.macaddr_gen_->generate() % 3);
+        }
+    }
+}
+
+// This test verifies that the responses received by the main thread on the
+// one socket are passed to the threads which sent the requests.
+TEST_F(TestControlTest, dispatchPackets) {
+    // Get the local loopback interface to open socket on
+    // it and test packets exchanges. We don't want to fail
+    // the test if interface is not available.
+    std::string loopback_iface(getLocalLoopback());
+    if (loopback_iface.empty()) {
+        std::cout << "Unable to find the loopback interface. Skip test."
+                  << std::endl;
+        return;
+    }
+    ASSERT_NO_THROW(processCmdLine("perfdhcp -l " + loopback_iface
+                                   + " -r 100 -n 10 -L 10547 -g 2"
+                                   + " 127.0.0.1"));
+
+    // All threads send the requests from the same socket.
+    NakedTestControl tc;
+    int sock_handle = 0;
+    ASSERT_NO_THROW(sock_handle = tc.openSocket());
+    TestControl::TestControlSocket sock(sock_handle);
+
+    std::vector<boost::shared_ptr<NakedTestControl> > workers;
+    for (uint32_t i = 0; i < 2; ++i) {
+        boost::shared_ptr<NakedTestControl> worker(new NakedTestControl());
+        worker->initThreadShare(i, 2);
+        worker->initializeStatsMgr();
+        workers.push_back(worker);
+        tc.workers_.push_back(worker);
+    }
+
+    // The first thread uses the even transaction ids, the second one
+    // the odd ones.
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_NO_THROW(workers[0]->sendDiscover4(sock));
+        ASSERT_NO_THROW(workers[1]->sendDiscover4(sock));
+    }
+
+    // Simulate the responses received by the main thread, in an order
+    // unrelated to the threads.
+    std::vector<Pkt4Ptr> pkts;
+    const uint32_t transids[] = { 1, 0, 2, 3, 5, 7, 4, 6 };
+    for (int i = 0; i < 8; ++i) {
+        boost::shared_ptr<Pkt4> offer(createOfferPkt4(transids[i]));
+        ASSERT_NO_THROW(offer->pack());
+        const util::OutputBuffer& buf = offer->getBuffer();
+        pkts.push_back(Pkt4Ptr(new Pkt4(static_cast<const uint8_t*>
+                                        (buf.getData()),
+                                        buf.getLength())));
+    }
+    tc.dispatchPackets(pkts);
+
+    // Each thread counts the responses to its own requests.
+    for (uint32_t i = 0; i < 2; ++i) {
+        SCOPED_TRACE(i);
+        EXPECT_EQ(4, workers[i]->receivePackets(sock));
+        EXPECT_EQ(4, workers[i]->stats_mgr4_->
+                  getRcvdPacketsNum(TestControl::StatsMgr4::XCHG_DO));
+        EXPECT_EQ(0, workers[i]->stats_mgr4_->
+                  getOrphans(TestControl::StatsMgr4::XCHG_DO));
+    }
+}
+
 TEST_F(TestControlTest, GenerateDuid) {
     // Simple command line that simulates one client only. Always the
     // same DUID will be generated.